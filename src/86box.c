@@ -66,6 +66,7 @@
 #include <86box/bugger.h>
 #include <86box/postcard.h>
 #include <86box/unittester.h>
+#include <86box/hostshare.h>
 #include <86box/novell_cardkey.h>
 #include <86box/isamem.h>
 #include <86box/isartc.h>
@@ -100,9 +101,15 @@
 #include <86box/plat.h>
 #include <86box/version.h>
 #include <86box/gdbstub.h>
+#include <86box/snapshot.h>
+#include <86box/capture.h>
 #include <86box/machine_status.h>
 #include <86box/apm.h>
 #include <86box/acpi.h>
+#include <86box/device_profile.h>
+#include <86box/trace.h>
+#include <86box/metrics.h>
+#include <86box/bench.h>
 
 // Disable c99-designator to avoid the warnings about int ng
 #ifdef __clang__
@@ -120,7 +127,8 @@ uint64_t     timer_freq;
 char         emu_version[200]; /* version ID string */
 
 #ifdef MTR_ENABLED
-int tracing_on = 0;
+int      tracing_on       = 0;
+uint32_t trace_categories = TRACE_CAT_ALL; /* (C) categories recorded in traces */
 #endif
 
 /* Commandline options. */
@@ -162,6 +170,7 @@ int      dpi_scale                              = 0;              /* (C) DPI sca
                                                                          screen */
 int      vid_api                                = 0;              /* (C) video renderer */
 int      vid_cga_contrast                       = 0;              /* (C) video */
+int      vid_cga_comp_cache                     = 1;              /* (C) video, reuse decoded composite lines */
 int      video_fullscreen                       = 0;              /* (C) video */
 int      video_fullscreen_scale                 = 0;              /* (C) video */
 int      video_fullscreen_first                 = 0;              /* (C) video */
@@ -170,13 +179,23 @@ int      force_43                               = 0;              /* (C) video *
 int      video_filter_method                    = 1;              /* (C) video */
 int      video_vsync                            = 0;              /* (C) video */
 int      video_framerate                        = -1;             /* (C) video */
+int      video_render_thread                    = 0;              /* (C) video */
+int      video_blit_mode                        = 0;              /* (C) video */
+int      video_bus_timing                       = 0;              /* (C) video */
+int      video_frame_stats                      = 0;              /* (C) video */
+int      video_screenshot_format                = 0;              /* (C) video */
+int      video_screenshot_level                 = -1;             /* (C) video, PNG zlib level */
+int      capture_fps                            = 60;             /* (C) video capture frame rate */
+int      vnc_max_fps                            = 0;              /* (C) VNC update rate cap */
 char     video_shader[512]                      = { '\0' };       /* (C) video */
+char     video_shm_name[64]                     = { '\0' };       /* (C) video */
 bool     serial_passthrough_enabled[SERIAL_MAX] = { 0, 0, 0, 0 }; /* (C) activation and kind of
                                                                          pass-through for serial ports */
 int      bugger_enabled                         = 0;              /* (C) enable ISAbugger */
 int      novell_keycard_enabled                 = 0;              /* (C) enable Novell NetWare 2.x key card emulation. */
 int      postcard_enabled                       = 0;              /* (C) enable POST card */
 int      unittester_enabled                     = 0;              /* (C) enable unit tester device */
+int      hostshare_enabled                      = 0;              /* (C) enable host file share device */
 int      isamem_type[ISAMEM_MAX]                = { 0, 0, 0, 0 }; /* (C) enable ISA mem cards */
 int      isartc_type                            = 0;              /* (C) enable ISA RTC card */
 int      gfxcard[2]                             = { 0, 0 };       /* (C) graphics/video card */
@@ -190,13 +209,25 @@ uint32_t mem_size                               = 0;              /* (C) memory
                                                                          system board)*/
 uint32_t isa_mem_size                           = 0;              /* (C) memory size (ISA Memory Cards) */
 int      cpu_use_dynarec                        = 0;              /* (C) cpu uses/needs Dyna */
+int      cpu_dynarec_cache_size                 = 0;              /* (C) recompiler code cache size in MB */
+int      cpu_dynarec_hash_bits                  = 0;              /* (C) old recompiler block hash size, log2 */
+int      cpu_808x_fast                          = 0;              /* (C) 808x batches bus timing */
 int      cpu                                    = 0;              /* (C) cpu type */
 int      fpu_type                               = 0;              /* (C) fpu type */
 int      fpu_softfloat                          = 0;              /* (C) fpu uses softfloat */
+int      fpu_hybrid                             = 0;              /* (C) softfloat fpu uses host fast path */
 int      time_sync                              = 0;              /* (C) enable time sync */
 int      confirm_reset                          = 1;              /* (C) enable reset confirmation */
 int      confirm_exit                           = 1;              /* (C) enable exit confirmation */
 int      confirm_save                           = 1;              /* (C) enable save confirmation */
+int      turbo_post                             = 0;              /* (C) run unthrottled after a hard reset
+                                                                         until this trigger is hit */
+int      turbo_post_time                        = 0;              /* (C) turbo POST limit in emulated seconds,
+                                                                         0 = no limit */
+int      turbo_post_active                      = 0;
+static uint64_t turbo_post_tsc                  = 0;
+int      max_speed                              = 0;              /* (C) run unthrottled, dropping audio
+                                                                         and most frames */
 int      enable_discord                         = 0;              /* (C) enable Discord integration */
 int      pit_mode                               = -1;             /* (C) force setting PIT mode */
 int      fm_driver                              = 0;              /* (C) select FM sound driver */
@@ -255,8 +286,45 @@ static char buff[1024];
 static int  seen = 0;
 
 static int suppr_seen = 1;
+
+/* The log is flushed by a thread of its own, LOG_FLUSH_MS after the last
+   flush at the latest, rather than after every line. */
+#    define LOG_FLUSH_MS 100
+
+static thread_t   *log_flush_thread;
+static atomic_int  log_dirty;
+
+static void
+pclog_flusher(UNUSED(void *priv))
+{
+    while (1) {
+        plat_delay_ms(LOG_FLUSH_MS);
+
+        if (atomic_exchange(&log_dirty, 0))
+            fflush(stdlog);
+    }
+}
 #endif
 
+/* Have the log flushed shortly; called after writing to stdlog. */
+void
+pclog_defer_flush(void)
+{
+#ifndef RELEASE_BUILD
+    atomic_store(&log_dirty, 1);
+
+    if (log_flush_thread == NULL)
+        log_flush_thread = thread_create(pclog_flusher, NULL);
+#endif
+}
+
+void
+pclog_flush(void)
+{
+    if (stdlog != NULL)
+        fflush(stdlog);
+}
+
 /*
  * Log something to the logfile or stdout.
  *
@@ -293,7 +361,7 @@ pclog_ex(const char *fmt, va_list ap)
         fprintf(stdlog, "%s", temp);
     }
 
-    fflush(stdlog);
+    pclog_defer_flush();
 #endif
 }
 
@@ -345,6 +413,7 @@ fatal(const char *fmt, ...)
     nvr_save();
 
     config_save();
+    config_flush();
 
 #ifdef ENABLE_808X_LOG
     dumpregs(1);
@@ -387,6 +456,7 @@ fatal_ex(const char *fmt, va_list ap)
     nvr_save();
 
     config_save();
+    config_flush();
 
 #ifdef ENABLE_808X_LOG
     dumpregs(1);
@@ -531,6 +601,7 @@ usage:
             printf("\nUsage: 86box [options] [cfg-file]\n\n");
             printf("Valid options are:\n\n");
             printf("-? or --help            - show this information\n");
+            printf("-B or --bench secs      - run a benchmark for 'secs' emulated seconds (0 = until guest exit)\n");
             printf("-C or --config path     - set 'path' to be config file\n");
 #ifdef _WIN32
             printf("-D or --debug           - force debug output logging\n");
@@ -562,6 +633,11 @@ usage:
             printf("-Z or --lastvmpath      - the last parameter is VM path rather than config\n");
             printf("\nA config file can be specified. If none is, the default file will be used.\n");
             return 0;
+        } else if (!strcasecmp(argv[c], "--bench") || !strcasecmp(argv[c], "-B")) {
+            if ((c + 1) == argc)
+                goto usage;
+            bench_enabled = 1;
+            bench_run_ms  = strtoull(argv[++c], NULL, 10) * 1000;
         } else if (!strcasecmp(argv[c], "--lastvmpath") || !strcasecmp(argv[c], "-Z")) {
             lvmp = 1;
 #ifdef _WIN32
@@ -1043,6 +1119,10 @@ pc_init_modules(void)
 
     machine_status_init();
 
+    metrics_init();
+
+    bench_start();
+
     if (do_nothing) {
         do_nothing = 0;
         exit(-1);
@@ -1082,6 +1162,12 @@ pc_reset_hard_close(void)
 {
     ui_sb_set_ready(0);
 
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC) && defined(USE_DYNAREC_PROFILE)
+    codegen_profile_report();
+#endif
+    device_profile_report();
+    device_profile_reset();
+
     /* Close all the memory mappings. */
     mem_close();
 
@@ -1243,6 +1329,8 @@ pc_reset_hard_init(void)
         device_add(&postcard_device);
     if (unittester_enabled)
         device_add(&unittester_device);
+    if (hostshare_enabled)
+        device_add(&hostshare_device);
 
     if (lba_enhancer_enabled)
         device_add(&lba_enhancer_device);
@@ -1276,6 +1364,9 @@ pc_reset_hard_init(void)
     cycles_main = 0;
 #endif
 
+    turbo_post_active = (turbo_post != TURBO_POST_OFF);
+    turbo_post_tsc    = tsc;
+
     update_mouse_msg();
 
     ui_hard_reset_completed();
@@ -1339,9 +1430,15 @@ pc_close(UNUSED(thread_t *ptr))
     nvr_save();
 
     config_save();
+    config_flush();
 
     plat_mouse_capture(0);
 
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC) && defined(USE_DYNAREC_PROFILE)
+    codegen_profile_report();
+#endif
+    device_profile_report();
+
     /* Close all the memory mappings. */
     mem_close();
 
@@ -1358,6 +1455,10 @@ pc_close(UNUSED(thread_t *ptr))
         dumpregs(0);
 #endif
 
+    capture_stop();
+
+    metrics_close();
+
     video_close();
 
     device_close_all();
@@ -1381,6 +1482,8 @@ pc_close(UNUSED(thread_t *ptr))
     scsi_disk_close();
 
     gdbstub_close();
+
+    pclog_flush();
 }
 
 #ifdef __APPLE__
@@ -1416,8 +1519,18 @@ pc_run(void)
 
     /* Run a block of code. */
     startblit();
+    if (snapshot_pending)
+        snapshot_process();
+    keyboard_process();
+    TRACE_BEGIN(cpu, "exec");
     cpu_exec((int32_t) cpu_s->rspeed / 100);
+    TRACE_END(cpu, "exec");
     ack_pause();
+    if (turbo_post_active && turbo_post_time &&
+        ((tsc - turbo_post_tsc) >= ((uint64_t) turbo_post_time * cpu_s->rspeed))) {
+        pclog("Turbo POST: time limit reached\n");
+        turbo_post_active = 0;
+    }
 #ifdef USE_GDBSTUB /* avoid a KBC FIFO overflow when CPU emulation is stalled */
     if (gdbstub_step == GDBSTUB_EXEC) {
 #endif
@@ -1427,6 +1540,7 @@ pc_run(void)
     }
 #endif
     joystick_process();
+    network_process();
     endblit();
 
     /* Done with this frame, update statistics. */
@@ -1449,6 +1563,27 @@ pc_run(void)
     }
 }
 
+/*
+ * Whether the platform loop should run frames back to back rather than
+ * pace them to real time. Timers keep running on emulated time either way.
+ */
+int
+pc_unthrottled(void)
+{
+    return turbo_post_active || max_speed || bench_enabled;
+}
+
+/* End turbo POST if it is waiting for this trigger. */
+void
+pc_turbo_post_trigger(int trigger)
+{
+    if (turbo_post_active && (turbo_post == trigger)) {
+        pclog("Turbo POST: trigger %i hit after %" PRIu64 " ms\n", trigger,
+              ((tsc - turbo_post_tsc) * 1000) / cpu_s->rspeed);
+        turbo_post_active = 0;
+    }
+}
+
 /* Handler for the 1-second timer to refresh the window title. */
 void
 pc_onesec(void)
@@ -1456,6 +1591,8 @@ pc_onesec(void)
     fps        = framecount;
     framecount = 0;
 
+    metrics_onesec(fps);
+
     title_update = 1;
 }
 
@@ -48,7 +48,8 @@ int        acpi_rtc_status     = 0;
 atomic_int acpi_pwrbut_pressed = 0;
 int        acpi_enabled        = 0;
 
-static double cpu_to_acpi;
+/* ACPI timer ticks per CPU clock, as a 0.64 fixed-point fraction. */
+static uint64_t cpu_to_acpi;
 
 static int      acpi_power_on    = 0;
 static uint64_t acpi_last_clock  = 0ULL;
@@ -72,10 +73,32 @@ acpi_log(const char *fmt, ...)
 #    define acpi_log(fmt, ...)
 #endif
 
+static void
+acpi_clock_set_scale(void)
+{
+    /* The timer runs at 3.58 MHz, slower than any CPU with ACPI, so
+       the ratio is below 1 and the whole fraction fits in 64 bits. */
+    if (cpuclock > ACPI_TIMER_FREQ)
+        cpu_to_acpi = (uint64_t) ((ACPI_TIMER_FREQ / cpuclock) * 18446744073709551616.0);
+    else
+        cpu_to_acpi = 0xffffffffffffffffULL;
+}
+
+/* Read by the guest in tight loops, so no floating point here. */
 static uint64_t
 acpi_clock_get(void)
 {
-    return tsc * cpu_to_acpi;
+#ifdef __SIZEOF_INT128__
+    return (uint64_t) (((unsigned __int128) tsc * cpu_to_acpi) >> 64);
+#else
+    uint64_t lo  = (tsc & 0xffffffff) * (cpu_to_acpi & 0xffffffff);
+    uint64_t mid = (tsc >> 32) * (cpu_to_acpi & 0xffffffff);
+    uint64_t mi2 = (tsc & 0xffffffff) * (cpu_to_acpi >> 32);
+    uint64_t hi  = (tsc >> 32) * (cpu_to_acpi >> 32);
+
+    mid += (lo >> 32) + (mi2 & 0xffffffff);
+    return hi + (mi2 >> 32) + (mid >> 32);
+#endif
 }
 
 static uint32_t
@@ -2417,8 +2440,9 @@ static void
 acpi_speed_changed(void *priv)
 {
     acpi_t *dev        = (acpi_t *) priv;
-    cpu_to_acpi        = ACPI_TIMER_FREQ / cpuclock;
     bool timer_enabled = timer_is_enabled(&dev->timer);
+
+    acpi_clock_set_scale();
     timer_stop(&dev->timer);
 
     if (timer_enabled)
@@ -2478,7 +2502,7 @@ acpi_init(const device_t *info)
         return NULL;
     memset(dev, 0x00, sizeof(acpi_t));
 
-    cpu_to_acpi = ACPI_TIMER_FREQ / cpuclock;
+    acpi_clock_set_scale();
     dev->vendor = info->local;
 
     dev->irq_line = 9;
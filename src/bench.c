@@ -0,0 +1,216 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Benchmark mode.
+ *
+ *          Started with --bench. The machine runs unthrottled, frames are
+ *          not blitted and sound is not sent to the host, for a given
+ *          amount of emulated time or until the guest sends the exit
+ *          command to the unit tester device; then a report of the host
+ *          time taken and of what the emulator did is printed and the
+ *          emulator quits. Emulated time is counted in the 10 ms slices
+ *          pc_run() executes, so a run covers the same guest work every
+ *          time regardless of host speed.
+ *
+ *          The guest can also mark the start and end of phases of its own
+ *          through the unit tester device; the host time, host CPU time
+ *          and emulated clocks of each phase go to the report and to the
+ *          metrics file.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#if defined WIN32 || defined _WIN32
+#    include <windows.h>
+#else
+#    include <time.h>
+#endif
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/timer.h>
+#include <86box/sound.h>
+#include <86box/device_profile.h>
+#include <86box/metrics.h>
+#include <86box/bench.h>
+
+int      bench_enabled = 0;
+uint64_t bench_run_ms  = 0;
+
+static uint64_t bench_start_ns;
+static uint64_t bench_frames;
+static uint64_t bench_start_tsc;
+
+/* Samples taken at the start of each guest phase. */
+static struct {
+    int      started;
+    uint64_t host_ns;
+    uint64_t cpu_ns;
+    uint64_t tsc;
+} bench_phases[256];
+
+/* Monotonic host time, from an arbitrary origin. */
+uint64_t
+bench_host_ns(void)
+{
+#if defined WIN32 || defined _WIN32
+    static LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER        now;
+
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t) ((now.QuadPart * 1000000000.0) / freq.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+#endif
+}
+
+/* Host CPU time used by the whole process so far, all threads included. */
+uint64_t
+bench_host_cpu_ns(void)
+{
+#if defined WIN32 || defined _WIN32
+    FILETIME create;
+    FILETIME exit;
+    FILETIME kernel;
+    FILETIME user;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &create, &exit, &kernel, &user))
+        return 0;
+    return ((((uint64_t) kernel.dwHighDateTime << 32) | kernel.dwLowDateTime) +
+            (((uint64_t) user.dwHighDateTime << 32) | user.dwLowDateTime)) * 100ULL;
+#else
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+#endif
+}
+
+void
+bench_start(void)
+{
+    if (!bench_enabled)
+        return;
+
+    bench_frames    = 0;
+    bench_start_tsc = tsc;
+    bench_start_ns  = bench_host_ns();
+}
+
+static void
+bench_report(const char *reason)
+{
+    double host_s = (bench_host_ns() - bench_start_ns) / 1000000000.0;
+    double emu_s  = bench_frames / 100.0;
+    double clocks = (tsc >= bench_start_tsc) ? (double) (tsc - bench_start_tsc) : (double) tsc;
+
+    printf("[bench] finished: %s\n", reason);
+    printf("[bench] emulated time: %.2f s, host time: %.3f s, speed: %.1f%%\n",
+           emu_s, host_s, host_s ? ((emu_s * 100.0) / host_s) : 0.0);
+    printf("[bench] emulated CPU clocks: %.0f, %.2f million per host second\n",
+           clocks, host_s ? (clocks / host_s / 1000000.0) : 0.0);
+    printf("[bench] recompiled blocks: %" PRIu64 "\n", metrics.dynarec_blocks);
+    printf("[bench] TLB flushes: %" PRIu64 ", range-limited: %" PRIu64 "\n",
+           metrics.mmu_flushes, metrics.mmu_range_flushes);
+    printf("[bench] timer callbacks: %" PRIu64 "\n", timer_total_fires);
+    printf("[bench] I/O port accesses: %" PRIu64 "\n", metrics.io_accesses);
+    printf("[bench] disk bytes read: %" PRIu64 ", written: %" PRIu64 ", CD-ROM bytes read: %" PRIu64 "\n",
+           metrics.disk_read_bytes, metrics.disk_write_bytes, metrics.cdrom_read_bytes);
+    printf("[bench] network packets received: %" PRIu64 ", sent: %" PRIu64 "\n",
+           metrics.net_rx_packets, metrics.net_tx_packets);
+    printf("[bench] SVGA timing recalculations: %" PRIu64 "\n", metrics.svga_recalcs);
+    fflush(stdout);
+
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC) && defined(USE_DYNAREC_PROFILE)
+    codegen_profile_report();
+#endif
+    device_profile_report();
+}
+
+/* Called after every pc_run(); returns 1 once the run is over. */
+int
+bench_frame(void)
+{
+    if (!bench_enabled)
+        return 0;
+
+    bench_frames++;
+    if (bench_run_ms && ((bench_frames * 10) >= bench_run_ms)) {
+        bench_report("time limit reached");
+        return 1;
+    }
+
+    return 0;
+}
+
+/* The guest sent the exit command to the unit tester device. */
+void
+bench_guest_exit(int code)
+{
+    char reason[64];
+
+    if (!bench_enabled)
+        return;
+
+    snprintf(reason, sizeof(reason), "guest exit, code %02X", code);
+    bench_report(reason);
+}
+
+/* The guest marked the start or the end of one of its phases. */
+void
+bench_phase_marker(uint8_t phase, int stop)
+{
+    uint64_t host_ns = bench_host_ns();
+    uint64_t cpu_ns  = bench_host_cpu_ns();
+    double   host_ms;
+    double   cpu_ms;
+    double   clocks;
+
+    if (!stop) {
+        bench_phases[phase].started = 1;
+        bench_phases[phase].host_ns = host_ns;
+        bench_phases[phase].cpu_ns  = cpu_ns;
+        bench_phases[phase].tsc     = tsc;
+
+        metrics_phase(phase, 0, 0.0, 0.0, 0.0);
+        if (bench_enabled) {
+            printf("[bench] phase %02X started\n", phase);
+            fflush(stdout);
+        }
+        return;
+    }
+
+    /* A stop without a start covers nothing. */
+    if (bench_phases[phase].started) {
+        host_ms = (host_ns - bench_phases[phase].host_ns) / 1000000.0;
+        cpu_ms  = (cpu_ns - bench_phases[phase].cpu_ns) / 1000000.0;
+        clocks  = (tsc >= bench_phases[phase].tsc) ? (double) (tsc - bench_phases[phase].tsc) : (double) tsc;
+    } else
+        host_ms = cpu_ms = clocks = 0.0;
+    bench_phases[phase].started = 0;
+
+    metrics_phase(phase, 1, host_ms, cpu_ms, clocks);
+    if (bench_enabled) {
+        printf("[bench] phase %02X finished: host time: %.3f ms, host CPU time: %.3f ms, emulated CPU clocks: %.0f\n",
+               phase, host_ms, cpu_ms, clocks);
+        fflush(stdout);
+    }
+}
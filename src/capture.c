@@ -0,0 +1,810 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Lossless video capture.
+ *
+ *          Frames of the first monitor and the output of the sound
+ *          mixers are recorded into an AVI file, the video as ZMBV
+ *          (the zlib based lossless codec DOSBox records with) and
+ *          the audio as 16-bit PCM with one track per mixer. The blit
+ *          and sound threads only copy what changed into a queue; all
+ *          compression and file writes are done by a worker thread.
+ *
+ *          AVI has a constant frame rate, so frames are timed by the
+ *          main mixer: after each of its buffers, the worker writes as
+ *          many frames as the buffer's emulated time covers. A frame
+ *          the guest did not change is written as a ZMBV delta frame
+ *          with no changed blocks, which costs a few bytes.
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <zlib.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/path.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/video.h>
+#include <86box/sound.h>
+#include <86box/capture.h>
+
+#define CAPTURE_BLOCK    16
+#define CAPTURE_KEY_SECS 10            /* Seconds between key frames. */
+#define CAPTURE_MAX_SIZE (1000 << 20)  /* Start a new file past this, RIFF offsets are 32-bit. */
+#define CAPTURE_MAX_JOBS 256           /* Frame updates queued before they are dropped. */
+
+#define AVIF_HASINDEX      0x00000010
+#define AVIF_ISINTERLEAVED 0x00000100
+#define AVIIF_KEYFRAME     0x00000010
+
+#define ZMBV_FORMAT_32BPP 8
+
+enum {
+    CAPTURE_JOB_VIDEO = 0,
+    CAPTURE_JOB_AUDIO
+};
+
+typedef struct capture_job_t {
+    struct capture_job_t *next;
+
+    int type;
+
+    /* Video: rows y1 to (y2 - 1) of a w x h frame, full if everything else
+       should be cleared. */
+    int w;
+    int h;
+    int y1;
+    int y2;
+    int full;
+
+    /* Audio: samples stereo pairs for a track. */
+    int stream;
+    int samples;
+
+    uint32_t data[];
+} capture_job_t;
+
+typedef struct capture_index_t {
+    uint32_t id;
+    uint32_t flags;
+    uint32_t offset;
+    uint32_t size;
+} capture_index_t;
+
+typedef struct capture_t {
+    thread_t    *thread;
+    event_t     *wake_event;
+    mutex_t     *mutex;
+    int          run;
+    volatile int failed;
+
+    capture_job_t *head;
+    capture_job_t *tail;
+    int            video_jobs;
+
+    /* Blit thread side. */
+    int last_w;
+    int last_h;
+    int resync;
+
+    /* Worker side. */
+    char  fn[1024];
+    int   part;
+    int   fps;
+    FILE *fp;
+    long  movi_pos;
+    long  movi_size_pos;
+    long  frames_pos;
+    long  length_pos[1 + CAPTURE_AUDIO_MAX];
+
+    int       w;
+    int       h;
+    uint32_t *frame;
+    uint32_t *prev;
+    int       dirty_y1;
+    int       dirty_y2;
+
+    uint64_t clock;        /* Main mixer samples since the first frame. */
+    uint64_t frames_total; /* Frames written, across all parts. */
+    uint32_t frames;       /* Frames written to this part. */
+    uint32_t samples[CAPTURE_AUDIO_MAX];
+    int      key_count;
+
+    capture_index_t *index;
+    int              index_num;
+    int              index_size;
+
+    z_stream z;
+    int      z_init;
+    uint8_t *work;
+    uint8_t *out;
+    size_t   out_size;
+} capture_t;
+
+volatile int capture_active = 0;
+
+static capture_t capture;
+
+static const int capture_freq[CAPTURE_AUDIO_MAX] = { SOUND_FREQ, MUSIC_FREQ, WT_FREQ, CD_FREQ };
+
+#ifdef ENABLE_CAPTURE_LOG
+int capture_do_log = ENABLE_CAPTURE_LOG;
+
+static void
+capture_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (capture_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define capture_log(fmt, ...)
+#endif
+
+static void
+capture_put16(FILE *fp, uint16_t val)
+{
+    fputc(val & 0xff, fp);
+    fputc(val >> 8, fp);
+}
+
+static void
+capture_put32(FILE *fp, uint32_t val)
+{
+    capture_put16(fp, val & 0xffff);
+    capture_put16(fp, val >> 16);
+}
+
+static uint32_t
+capture_id(const char *id)
+{
+    return id[0] | (id[1] << 8) | (id[2] << 16) | ((uint32_t) id[3] << 24);
+}
+
+static void
+capture_patch32(FILE *fp, long pos, uint32_t val)
+{
+    fseek(fp, pos, SEEK_SET);
+    capture_put32(fp, val);
+}
+
+static void
+capture_write_header(capture_t *dev)
+{
+    FILE *fp = dev->fp;
+
+    capture_put32(fp, capture_id("RIFF"));
+    capture_put32(fp, 0);
+    capture_put32(fp, capture_id("AVI "));
+
+    capture_put32(fp, capture_id("LIST"));
+    capture_put32(fp, 4 + (8 + 56) + (8 + 4 + (8 + 56) + (8 + 40)) + (CAPTURE_AUDIO_MAX * (8 + 4 + (8 + 56) + (8 + 16))));
+    capture_put32(fp, capture_id("hdrl"));
+
+    capture_put32(fp, capture_id("avih"));
+    capture_put32(fp, 56);
+    capture_put32(fp, 1000000 / dev->fps);
+    capture_put32(fp, 0);
+    capture_put32(fp, 0);
+    capture_put32(fp, AVIF_HASINDEX | AVIF_ISINTERLEAVED);
+    dev->frames_pos = ftell(fp);
+    capture_put32(fp, 0);
+    capture_put32(fp, 0);
+    capture_put32(fp, 1 + CAPTURE_AUDIO_MAX);
+    capture_put32(fp, 0);
+    capture_put32(fp, dev->w);
+    capture_put32(fp, dev->h);
+    for (int i = 0; i < 4; i++)
+        capture_put32(fp, 0);
+
+    capture_put32(fp, capture_id("LIST"));
+    capture_put32(fp, 4 + (8 + 56) + (8 + 40));
+    capture_put32(fp, capture_id("strl"));
+
+    capture_put32(fp, capture_id("strh"));
+    capture_put32(fp, 56);
+    capture_put32(fp, capture_id("vids"));
+    capture_put32(fp, capture_id("ZMBV"));
+    capture_put32(fp, 0);
+    capture_put16(fp, 0);
+    capture_put16(fp, 0);
+    capture_put32(fp, 0);
+    capture_put32(fp, 1);
+    capture_put32(fp, dev->fps);
+    capture_put32(fp, 0);
+    dev->length_pos[0] = ftell(fp);
+    capture_put32(fp, 0);
+    capture_put32(fp, 0);
+    capture_put32(fp, 0xffffffff);
+    capture_put32(fp, 0);
+    capture_put16(fp, 0);
+    capture_put16(fp, 0);
+    capture_put16(fp, dev->w);
+    capture_put16(fp, dev->h);
+
+    capture_put32(fp, capture_id("strf"));
+    capture_put32(fp, 40);
+    capture_put32(fp, 40);
+    capture_put32(fp, dev->w);
+    capture_put32(fp, dev->h);
+    capture_put16(fp, 1);
+    capture_put16(fp, 32);
+    capture_put32(fp, capture_id("ZMBV"));
+    capture_put32(fp, dev->w * dev->h * 4);
+    for (int i = 0; i < 4; i++)
+        capture_put32(fp, 0);
+
+    for (int i = 0; i < CAPTURE_AUDIO_MAX; i++) {
+        capture_put32(fp, capture_id("LIST"));
+        capture_put32(fp, 4 + (8 + 56) + (8 + 16));
+        capture_put32(fp, capture_id("strl"));
+
+        capture_put32(fp, capture_id("strh"));
+        capture_put32(fp, 56);
+        capture_put32(fp, capture_id("auds"));
+        capture_put32(fp, 0);
+        capture_put32(fp, 0);
+        capture_put16(fp, 0);
+        capture_put16(fp, 0);
+        capture_put32(fp, 0);
+        capture_put32(fp, 1);
+        capture_put32(fp, capture_freq[i]);
+        capture_put32(fp, 0);
+        dev->length_pos[1 + i] = ftell(fp);
+        capture_put32(fp, 0);
+        capture_put32(fp, 0);
+        capture_put32(fp, 0xffffffff);
+        capture_put32(fp, 4);
+        for (int j = 0; j < 4; j++)
+            capture_put16(fp, 0);
+
+        capture_put32(fp, capture_id("strf"));
+        capture_put32(fp, 16);
+        capture_put16(fp, 1); /* PCM */
+        capture_put16(fp, 2);
+        capture_put32(fp, capture_freq[i]);
+        capture_put32(fp, capture_freq[i] * 4);
+        capture_put16(fp, 4);
+        capture_put16(fp, 16);
+    }
+
+    capture_put32(fp, capture_id("LIST"));
+    dev->movi_size_pos = ftell(fp);
+    capture_put32(fp, 0);
+    dev->movi_pos = ftell(fp);
+    capture_put32(fp, capture_id("movi"));
+}
+
+static void
+capture_write_chunk(capture_t *dev, const char *id, uint32_t flags, const void *data, uint32_t len)
+{
+    capture_index_t *entry;
+
+    if (dev->index_num == dev->index_size) {
+        entry = (capture_index_t *) realloc(dev->index, (dev->index_size + 4096) * sizeof(capture_index_t));
+        if (entry == NULL) {
+            pclog("Capture: out of memory\n");
+            dev->failed = 1;
+            return;
+        }
+        dev->index = entry;
+        dev->index_size += 4096;
+    }
+
+    entry         = &dev->index[dev->index_num++];
+    entry->id     = capture_id(id);
+    entry->flags  = flags;
+    entry->offset = (uint32_t) (ftell(dev->fp) - dev->movi_pos);
+    entry->size   = len;
+
+    capture_put32(dev->fp, entry->id);
+    capture_put32(dev->fp, len);
+    if (fwrite(data, 1, len, dev->fp) != len) {
+        pclog("Capture: write error\n");
+        dev->failed = 1;
+    }
+    if (len & 1)
+        fputc(0, dev->fp);
+}
+
+static int
+capture_open_file(capture_t *dev)
+{
+    char   fn[1024];
+    size_t len = strlen(dev->fn);
+
+    if (dev->part == 0)
+        snprintf(fn, sizeof(fn), "%s", dev->fn);
+    else if ((len > 4) && !strcasecmp(&dev->fn[len - 4], ".avi"))
+        snprintf(fn, sizeof(fn), "%.*s-%i.avi", (int) (len - 4), dev->fn, dev->part);
+    else
+        snprintf(fn, sizeof(fn), "%s-%i", dev->fn, dev->part);
+
+    dev->fp = plat_fopen(fn, "wb");
+    if (dev->fp == NULL) {
+        pclog("Capture: unable to create \"%s\"\n", fn);
+        return 0;
+    }
+
+    dev->frames    = 0;
+    dev->index_num = 0;
+    dev->key_count = 0;
+    memset(dev->samples, 0, sizeof(dev->samples));
+
+    capture_write_header(dev);
+
+    pclog("Capture: recording %ix%i at %i fps to \"%s\"\n", dev->w, dev->h, dev->fps, fn);
+    return 1;
+}
+
+static void
+capture_close_file(capture_t *dev)
+{
+    long end;
+
+    if (dev->fp == NULL)
+        return;
+
+    end = ftell(dev->fp);
+    capture_put32(dev->fp, capture_id("idx1"));
+    capture_put32(dev->fp, dev->index_num * 16);
+    for (int i = 0; i < dev->index_num; i++) {
+        capture_put32(dev->fp, dev->index[i].id);
+        capture_put32(dev->fp, dev->index[i].flags);
+        capture_put32(dev->fp, dev->index[i].offset);
+        capture_put32(dev->fp, dev->index[i].size);
+    }
+
+    capture_patch32(dev->fp, 4, (uint32_t) (ftell(dev->fp) - 8));
+    capture_patch32(dev->fp, dev->movi_size_pos, (uint32_t) (end - dev->movi_pos));
+    capture_patch32(dev->fp, dev->frames_pos, dev->frames);
+    capture_patch32(dev->fp, dev->length_pos[0], dev->frames);
+    for (int i = 0; i < CAPTURE_AUDIO_MAX; i++)
+        capture_patch32(dev->fp, dev->length_pos[1 + i], dev->samples[i]);
+
+    (void) fclose(dev->fp);
+    dev->fp = NULL;
+}
+
+/* The geometry is fixed by the first frame, later frames of another size
+   are cropped or padded with black. */
+static int
+capture_init_video(capture_t *dev, int w, int h)
+{
+    size_t work_size;
+
+    dev->w = w;
+    dev->h = h;
+
+    work_size = ((size_t) w * h * 4) + (((w + CAPTURE_BLOCK - 1) / CAPTURE_BLOCK) * ((h + CAPTURE_BLOCK - 1) / CAPTURE_BLOCK) * 2) + 4;
+
+    if (deflateInit(&dev->z, 4) != Z_OK) {
+        pclog("Capture: unable to initialize zlib\n");
+        return 0;
+    }
+    dev->z_init = 1;
+
+    dev->out_size = deflateBound(&dev->z, work_size) + 64;
+    dev->frame    = (uint32_t *) calloc((size_t) w * h, sizeof(uint32_t));
+    dev->prev     = (uint32_t *) calloc((size_t) w * h, sizeof(uint32_t));
+    dev->work     = (uint8_t *) malloc(work_size);
+    dev->out      = (uint8_t *) malloc(dev->out_size);
+    if ((dev->frame == NULL) || (dev->prev == NULL) || (dev->work == NULL) || (dev->out == NULL)) {
+        pclog("Capture: out of memory\n");
+        return 0;
+    }
+
+    return capture_open_file(dev);
+}
+
+static void
+capture_encode_frame(capture_t *dev)
+{
+    int       key = (dev->key_count == 0);
+    int       bw  = (dev->w + CAPTURE_BLOCK - 1) / CAPTURE_BLOCK;
+    int       bh  = (dev->h + CAPTURE_BLOCK - 1) / CAPTURE_BLOCK;
+    size_t    len;
+    size_t    hdr;
+    uint8_t  *vectors;
+    uint32_t *xor;
+    int       x0;
+    int       y0;
+    int       xs;
+    int       ys;
+    int       changed;
+
+    if (key) {
+        len = (size_t) dev->w * dev->h * 4;
+        memcpy(dev->work, dev->frame, len);
+
+        dev->out[0] = 1; /* Key frame */
+        dev->out[1] = 0; /* Version 0.1 */
+        dev->out[2] = 1;
+        dev->out[3] = 1; /* zlib */
+        dev->out[4] = ZMBV_FORMAT_32BPP;
+        dev->out[5] = CAPTURE_BLOCK;
+        dev->out[6] = CAPTURE_BLOCK;
+        hdr         = 7;
+
+        deflateReset(&dev->z);
+    } else {
+        /* One motion vector per block, always zero here, with the low bit of
+           x set if the block is followed by its XOR against the last frame. */
+        vectors = dev->work;
+        len     = ((bw * bh * 2) + 3) & ~3;
+        memset(vectors, 0x00, len);
+
+        for (int by = dev->dirty_y1 / CAPTURE_BLOCK; (dev->dirty_y2 > dev->dirty_y1) && (by <= ((dev->dirty_y2 - 1) / CAPTURE_BLOCK)); by++) {
+            y0 = by * CAPTURE_BLOCK;
+            ys = MIN(CAPTURE_BLOCK, dev->h - y0);
+            for (int bx = 0; bx < bw; bx++) {
+                x0      = bx * CAPTURE_BLOCK;
+                xs      = MIN(CAPTURE_BLOCK, dev->w - x0);
+                changed = 0;
+                for (int y = 0; !changed && (y < ys); y++)
+                    changed = memcmp(&dev->frame[((y0 + y) * dev->w) + x0], &dev->prev[((y0 + y) * dev->w) + x0], xs * 4);
+                if (!changed)
+                    continue;
+
+                vectors[((by * bw) + bx) * 2] = 1;
+                xor                           = (uint32_t *) &dev->work[len];
+                for (int y = 0; y < ys; y++) {
+                    for (int x = 0; x < xs; x++)
+                        *xor++ = dev->frame[((y0 + y) * dev->w) + x0 + x] ^ dev->prev[((y0 + y) * dev->w) + x0 + x];
+                }
+                len += xs * ys * 4;
+            }
+        }
+
+        dev->out[0] = 0;
+        hdr         = 1;
+    }
+
+    dev->z.next_in   = dev->work;
+    dev->z.avail_in  = (uInt) len;
+    dev->z.next_out  = &dev->out[hdr];
+    dev->z.avail_out = (uInt) (dev->out_size - hdr);
+    (void) deflate(&dev->z, Z_SYNC_FLUSH);
+
+    capture_write_chunk(dev, "00dc", key ? AVIIF_KEYFRAME : 0, dev->out, (uint32_t) (dev->out_size - dev->z.avail_out));
+
+    if (key)
+        memcpy(dev->prev, dev->frame, (size_t) dev->w * dev->h * 4);
+    else if (dev->dirty_y2 > dev->dirty_y1)
+        memcpy(&dev->prev[dev->dirty_y1 * dev->w], &dev->frame[dev->dirty_y1 * dev->w],
+               (size_t) (dev->dirty_y2 - dev->dirty_y1) * dev->w * 4);
+    dev->dirty_y1 = 0;
+    dev->dirty_y2 = 0;
+
+    dev->frames++;
+    dev->frames_total++;
+    if (++dev->key_count == (dev->fps * CAPTURE_KEY_SECS))
+        dev->key_count = 0;
+
+    if (ftell(dev->fp) > CAPTURE_MAX_SIZE) {
+        capture_close_file(dev);
+        dev->part++;
+        if (!capture_open_file(dev))
+            dev->failed = 1;
+    }
+}
+
+static void
+capture_process_video(capture_t *dev, capture_job_t *job)
+{
+    int w  = MIN(job->w, dev->w);
+    int y2 = MIN(job->y2, dev->h);
+
+    if (job->full) {
+        memset(dev->frame, 0x00, (size_t) dev->w * dev->h * 4);
+        dev->dirty_y1 = 0;
+        dev->dirty_y2 = dev->h;
+    }
+
+    for (int y = job->y1; y < y2; y++)
+        memcpy(&dev->frame[y * dev->w], &job->data[(y - job->y1) * job->w], w * 4);
+
+    if (y2 > job->y1) {
+        if (dev->dirty_y2 > dev->dirty_y1) {
+            dev->dirty_y1 = MIN(dev->dirty_y1, job->y1);
+            dev->dirty_y2 = MAX(dev->dirty_y2, y2);
+        } else {
+            dev->dirty_y1 = job->y1;
+            dev->dirty_y2 = y2;
+        }
+    }
+}
+
+static void
+capture_process(capture_t *dev, capture_job_t *job)
+{
+    static const char *ids[CAPTURE_AUDIO_MAX] = { "01wb", "02wb", "03wb", "04wb" };
+    uint64_t           target;
+
+    if (job->type == CAPTURE_JOB_VIDEO) {
+        if ((dev->frame == NULL) && !capture_init_video(dev, job->w, job->h)) {
+            dev->failed = 1;
+            return;
+        }
+        capture_process_video(dev, job);
+        return;
+    }
+
+    /* Audio from before the first frame is not recorded. */
+    if (dev->fp == NULL)
+        return;
+
+    capture_write_chunk(dev, ids[job->stream], AVIIF_KEYFRAME, job->data, job->samples * 4);
+    dev->samples[job->stream] += job->samples;
+
+    if (job->stream == CAPTURE_AUDIO_SOUND) {
+        dev->clock += job->samples;
+        target = (dev->clock * dev->fps) / SOUND_FREQ;
+        while (!dev->failed && (dev->frames_total < target))
+            capture_encode_frame(dev);
+    }
+}
+
+static void
+capture_thread(void *param)
+{
+    capture_t     *dev = (capture_t *) param;
+    capture_job_t *job;
+    int            run;
+
+    while (1) {
+        thread_wait_event(dev->wake_event, -1);
+        thread_reset_event(dev->wake_event);
+
+        while (1) {
+            thread_wait_mutex(dev->mutex);
+            job = dev->head;
+            if (job != NULL) {
+                dev->head = job->next;
+                if (dev->head == NULL)
+                    dev->tail = NULL;
+                if (job->type == CAPTURE_JOB_VIDEO)
+                    dev->video_jobs--;
+            }
+            run = dev->run;
+            thread_release_mutex(dev->mutex);
+
+            if (job == NULL)
+                break;
+
+            if (!dev->failed)
+                capture_process(dev, job);
+            free(job);
+        }
+
+        /* Nothing can be queued once run is cleared, so the queue is done. */
+        if (!run)
+            break;
+    }
+
+    capture_close_file(dev);
+
+    pclog("Capture: stopped after %" PRIu64 " frames\n", dev->frames_total);
+
+    if (dev->z_init)
+        deflateEnd(&dev->z);
+    free(dev->frame);
+    free(dev->prev);
+    free(dev->work);
+    free(dev->out);
+    free(dev->index);
+}
+
+static void
+capture_queue(capture_job_t *job)
+{
+    int queued = 0;
+
+    job->next = NULL;
+
+    thread_wait_mutex(capture.mutex);
+    if (capture.run) {
+        if (capture.tail != NULL)
+            capture.tail->next = job;
+        else
+            capture.head = job;
+        capture.tail = job;
+        if (job->type == CAPTURE_JOB_VIDEO)
+            capture.video_jobs++;
+        queued = 1;
+    }
+    thread_release_mutex(capture.mutex);
+
+    if (queued)
+        thread_set_event(capture.wake_event);
+    else
+        free(job);
+}
+
+/* Called by the blit thread for the first monitor, with the target buffer
+   held; only the changed rows are copied. */
+void
+capture_video(int x, int y, int w, int h, int dirty_y1, int dirty_y2)
+{
+    const bitmap_t *buf = monitors[0].target_buffer;
+    capture_job_t  *job;
+    int             full;
+    int             y1;
+    int             y2;
+
+    if (capture.failed || (buf == NULL) || (x < 0) || (y < 0) || (w <= 0) || (h <= 0))
+        return;
+
+    w = MIN(w, buf->w - x);
+    h = MIN(h, buf->h - y);
+    if ((w <= 0) || (h <= 0))
+        return;
+
+    full = capture.resync || (w != capture.last_w) || (h != capture.last_h);
+    if (full) {
+        y1 = 0;
+        y2 = h;
+    } else {
+        y1 = MAX(dirty_y1 - y, 0);
+        y2 = MIN(dirty_y2 - y, h);
+        /* Nothing changed, the worker repeats the previous frame. */
+        if (y2 <= y1)
+            return;
+    }
+
+    /* The worker is behind, drop this update and resend the whole frame
+       once it has caught up. */
+    if (capture.video_jobs >= CAPTURE_MAX_JOBS) {
+        capture.resync = 1;
+        return;
+    }
+
+    job = (capture_job_t *) malloc(sizeof(capture_job_t) + ((size_t) (y2 - y1) * w * 4));
+    if (job == NULL) {
+        capture.resync = 1;
+        return;
+    }
+
+    job->type = CAPTURE_JOB_VIDEO;
+    job->w    = w;
+    job->h    = h;
+    job->y1   = y1;
+    job->y2   = y2;
+    job->full = full;
+    for (int row = y1; row < y2; row++)
+        memcpy(&job->data[(row - y1) * w], &buf->line[y + row][x], w * 4);
+
+    capture.last_w = w;
+    capture.last_h = h;
+    capture.resync = 0;
+
+    capture_queue(job);
+}
+
+void
+capture_audio(int stream, const void *buf, int samples, int format)
+{
+    capture_job_t *job;
+    int16_t       *out;
+    int32_t        val;
+
+    if (capture.failed)
+        return;
+
+    job = (capture_job_t *) malloc(sizeof(capture_job_t) + ((size_t) samples * 4));
+    if (job == NULL)
+        return;
+
+    job->type    = CAPTURE_JOB_AUDIO;
+    job->stream  = stream;
+    job->samples = samples;
+
+    out = (int16_t *) job->data;
+    for (int c = 0; c < (samples * 2); c++) {
+        switch (format) {
+            case CAPTURE_SAMPLES_INT16:
+                val = ((const int16_t *) buf)[c];
+                break;
+            case CAPTURE_SAMPLES_FLOAT:
+                val = (int32_t) (((const float *) buf)[c] * 32768.0f);
+                break;
+            default:
+                val = ((const int32_t *) buf)[c];
+                break;
+        }
+
+        if (val > 32767)
+            val = 32767;
+        if (val < -32768)
+            val = -32768;
+        out[c] = (int16_t) val;
+    }
+
+    capture_queue(job);
+}
+
+int
+capture_start(const char *fn)
+{
+    char path[1024];
+    char temp[256];
+
+    if (capture_active)
+        return 0;
+
+    if (capture.mutex == NULL)
+        capture.mutex = thread_create_mutex();
+
+    if (fn == NULL) {
+        memset(path, 0, sizeof(path));
+        memset(temp, 0, sizeof(temp));
+
+        path_append_filename(path, usr_path, SCREENSHOT_PATH);
+        if (!plat_dir_check(path))
+            plat_dir_create(path);
+        path_slash(path);
+        plat_tempfile(temp, NULL, ".avi");
+        strcat(path, temp);
+        fn = path;
+    }
+
+    thread_wait_mutex(capture.mutex);
+    capture.head       = NULL;
+    capture.tail       = NULL;
+    capture.video_jobs = 0;
+    capture.run        = 1;
+    thread_release_mutex(capture.mutex);
+
+    /* Everything the worker owns starts out clear. */
+    memset(((uint8_t *) &capture) + offsetof(capture_t, fn), 0x00, sizeof(capture_t) - offsetof(capture_t, fn));
+    snprintf(capture.fn, sizeof(capture.fn), "%s", fn);
+    capture.fps = (capture_fps > 0) ? capture_fps : 60;
+
+    capture.failed = 0;
+    capture.last_w = 0;
+    capture.last_h = 0;
+    capture.resync = 0;
+
+    capture.wake_event = thread_create_event();
+    capture.thread     = thread_create(capture_thread, &capture);
+
+    capture_active = 1;
+
+    capture_log("Capture: started, \"%s\"\n", fn);
+    return 1;
+}
+
+void
+capture_stop(void)
+{
+    if (!capture_active)
+        return;
+
+    capture_active = 0;
+
+    thread_wait_mutex(capture.mutex);
+    capture.run = 0;
+    thread_release_mutex(capture.mutex);
+
+    thread_set_event(capture.wake_event);
+    thread_wait(capture.thread);
+    thread_destroy_event(capture.wake_event);
+
+    capture.thread     = NULL;
+    capture.wake_event = NULL;
+}
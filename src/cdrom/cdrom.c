@@ -33,6 +33,8 @@
 #include <86box/scsi.h>
 #include <86box/scsi_device.h>
 #include <86box/sound.h>
+#include <86box/thread.h>
+#include <86box/metrics.h>
 
 /* The addresses sent from the guest are absolute, ie. a LBA of 0 corresponds to a MSF of 00:00:00. Otherwise, the counter displayed by the guest is wrong:
    there is a seeming 2 seconds in which audio plays but counter does not move, while a data track before audio jumps to 2 seconds before the actual start
@@ -46,6 +48,9 @@
 #define MIN_SEEK           2000
 #define MAX_SEEK           333333
 
+/* Four seconds of audio. */
+#define CD_PREFETCH_SECTORS (75 * 4)
+
 #pragma pack(push, 1)
 typedef struct {
     uint8_t user_data[2048],
@@ -428,6 +433,205 @@ cdrom_seek(cdrom_t *dev, uint32_t pos, uint8_t vendor_type)
     cdrom_stop(dev);
 }
 
+/* Audio read-ahead. While a drive plays, a thread of its own keeps a ring
+   of the sectors following the play position filled, so the audio thread
+   only copies out of memory. Sector reads from all sides go through the
+   read mutex, since the backends are not safe to enter twice. */
+typedef struct cdrom_prefetch_t {
+    cdrom_t      *dev;
+    thread_t     *thread;
+    event_t      *wake;
+    mutex_t      *ring_mutex;
+    mutex_t      *read_mutex;
+    volatile int  run;
+
+    /* Protected by ring_mutex; gen changes whenever the ring is dropped, so
+       that a read in flight does not land in it. */
+    uint32_t      lba;
+    uint32_t      gen;
+    int           head;
+    int           count;
+    uint8_t       ring[CD_PREFETCH_SECTORS][RAW_SECTOR_SIZE];
+} cdrom_prefetch_t;
+
+static int
+cdrom_read_sector(cdrom_t *dev, int type, uint8_t *b, uint32_t lba)
+{
+    cdrom_prefetch_t *pf  = (cdrom_prefetch_t *) dev->prefetch;
+    int               ret = 0;
+
+    if (pf)
+        thread_wait_mutex(pf->read_mutex);
+
+    if (dev->ops && dev->ops->read_sector)
+        ret = dev->ops->read_sector(dev, type, b, lba);
+
+    if (pf)
+        thread_release_mutex(pf->read_mutex);
+
+    return ret;
+}
+
+static int
+cdrom_read_sectors(cdrom_t *dev, uint8_t *b, uint32_t lba, int num)
+{
+    cdrom_prefetch_t *pf  = (cdrom_prefetch_t *) dev->prefetch;
+    int               ret = 0;
+
+    if (pf)
+        thread_wait_mutex(pf->read_mutex);
+
+    if (dev->ops && dev->ops->read_sectors)
+        ret = dev->ops->read_sectors(dev, b, lba, num);
+
+    if (pf)
+        thread_release_mutex(pf->read_mutex);
+
+    return ret;
+}
+
+static void
+cdrom_prefetch_thread(void *priv)
+{
+    cdrom_prefetch_t *pf  = (cdrom_prefetch_t *) priv;
+    cdrom_t          *dev = pf->dev;
+    uint8_t           buf[RAW_SECTOR_SIZE];
+    uint32_t          lba;
+    uint32_t          gen;
+    int               full;
+
+    while (pf->run) {
+        thread_wait_event(pf->wake, -1);
+        thread_reset_event(pf->wake);
+
+        while (pf->run) {
+            thread_wait_mutex(pf->ring_mutex);
+            lba  = pf->lba + pf->count;
+            gen  = pf->gen;
+            full = (pf->count == CD_PREFETCH_SECTORS);
+            thread_release_mutex(pf->ring_mutex);
+
+            if (full || (dev->cd_status != CD_STATUS_PLAYING) || (lba >= dev->cd_end))
+                break;
+
+            if (!cdrom_read_sector(dev, CD_READ_AUDIO, buf, lba))
+                break;
+
+            thread_wait_mutex(pf->ring_mutex);
+            if ((gen == pf->gen) && (pf->count < CD_PREFETCH_SECTORS)) {
+                memcpy(pf->ring[(pf->head + pf->count) % CD_PREFETCH_SECTORS], buf, RAW_SECTOR_SIZE);
+                pf->count++;
+            }
+            thread_release_mutex(pf->ring_mutex);
+        }
+    }
+}
+
+/* Reads an audio sector for playback, from the ring when the read-ahead has
+   got there first. Anything else means the play position has moved, and the
+   read-ahead starts over behind it. */
+static int
+cdrom_audio_read(cdrom_t *dev, uint8_t *b, uint32_t lba)
+{
+    cdrom_prefetch_t *pf  = (cdrom_prefetch_t *) dev->prefetch;
+    int               hit = 0;
+    int               ret = 1;
+
+    if (!pf)
+        return cdrom_read_sector(dev, CD_READ_AUDIO, b, lba);
+
+    thread_wait_mutex(pf->ring_mutex);
+    if (pf->count && (pf->lba == lba)) {
+        memcpy(b, pf->ring[pf->head], RAW_SECTOR_SIZE);
+        pf->head = (pf->head + 1) % CD_PREFETCH_SECTORS;
+        pf->count--;
+        hit = 1;
+    } else {
+        pf->head  = 0;
+        pf->count = 0;
+        pf->gen++;
+    }
+    pf->lba = lba + 1;
+    thread_release_mutex(pf->ring_mutex);
+
+    if (!hit)
+        ret = cdrom_read_sector(dev, CD_READ_AUDIO, b, lba);
+
+    thread_set_event(pf->wake);
+
+    return ret;
+}
+
+static void
+cdrom_prefetch_init(cdrom_t *dev)
+{
+    cdrom_prefetch_t *pf;
+
+    if (dev->prefetch)
+        return;
+
+    pf = (cdrom_prefetch_t *) calloc(1, sizeof(cdrom_prefetch_t));
+    if (pf == NULL)
+        return;
+
+    pf->dev        = dev;
+    pf->wake       = thread_create_event();
+    pf->ring_mutex = thread_create_mutex();
+    pf->read_mutex = thread_create_mutex();
+    pf->run        = 1;
+    dev->prefetch  = pf;
+
+    pf->thread = thread_create(cdrom_prefetch_thread, pf);
+}
+
+static void
+cdrom_prefetch_close(cdrom_t *dev)
+{
+    cdrom_prefetch_t *pf = (cdrom_prefetch_t *) dev->prefetch;
+
+    if (pf == NULL)
+        return;
+
+    pf->run = 0;
+    thread_set_event(pf->wake);
+    thread_wait(pf->thread);
+
+    dev->prefetch = NULL;
+
+    thread_destroy_event(pf->wake);
+    thread_close_mutex(pf->ring_mutex);
+    thread_close_mutex(pf->read_mutex);
+    free(pf);
+}
+
+/* Keeps the read-ahead off the medium while it is being closed, and drops
+   what was read from it. */
+void
+cdrom_media_lock(cdrom_t *dev)
+{
+    cdrom_prefetch_t *pf = (cdrom_prefetch_t *) dev->prefetch;
+
+    if (pf == NULL)
+        return;
+
+    thread_wait_mutex(pf->read_mutex);
+
+    thread_wait_mutex(pf->ring_mutex);
+    pf->head  = 0;
+    pf->count = 0;
+    pf->gen++;
+    thread_release_mutex(pf->ring_mutex);
+}
+
+void
+cdrom_media_unlock(cdrom_t *dev)
+{
+    cdrom_prefetch_t *pf = (cdrom_prefetch_t *) dev->prefetch;
+
+    if (pf)
+        thread_release_mutex(pf->read_mutex);
+}
+
 int
 cdrom_is_pre(cdrom_t *dev, uint32_t lba)
 {
@@ -452,8 +656,7 @@ cdrom_audio_callback(cdrom_t *dev, int16_t *output, int len)
 
     while (dev->cd_buflen < len) {
         if (dev->seek_pos < dev->cd_end) {
-            if (dev->ops->read_sector(dev, CD_READ_AUDIO, (uint8_t *) &(dev->cd_buffer[dev->cd_buflen]),
-                                      dev->seek_pos)) {
+            if (cdrom_audio_read(dev, (uint8_t *) &(dev->cd_buffer[dev->cd_buflen]), dev->seek_pos)) {
                 cdrom_log("CD-ROM %i: Read LBA %08X successful\n", dev->id, dev->seek_pos);
                 dev->seek_pos++;
                 dev->cd_buflen += (RAW_SECTOR_SIZE / 2);
@@ -1520,13 +1723,113 @@ track_type_is_valid(UNUSED(uint8_t id), int type, int flags, int audio, int mode
     return 1;
 }
 
+/* EDC and ECC of data sectors built from cooked images, ECMA-130 annex B and
+   A; only worked out when the guest asks for them. */
+static uint32_t edc_lut[256];
+static uint8_t  ecc_f_lut[256];
+static uint8_t  ecc_b_lut[256];
+static int      edc_ecc_ready = 0;
+
+static void
+edc_ecc_init(void)
+{
+    for (int i = 0; i < 256; i++) {
+        const uint32_t j   = (i << 1) ^ ((i & 0x80) ? 0x11d : 0x000);
+        uint32_t       edc = i;
+
+        ecc_f_lut[i]              = j & 0xff;
+        ecc_b_lut[(i ^ j) & 0xff] = i;
+
+        for (int k = 0; k < 8; k++)
+            edc = (edc >> 1) ^ ((edc & 1) ? 0xd8018001 : 0x00000000);
+        edc_lut[i] = edc;
+    }
+
+    edc_ecc_ready = 1;
+}
+
+static uint32_t
+edc_compute(const uint8_t *src, int size)
+{
+    uint32_t edc = 0;
+
+    while (size--)
+        edc = (edc >> 8) ^ edc_lut[(edc ^ *src++) & 0xff];
+
+    return edc;
+}
+
+/* One set of Reed-Solomon parity bytes, P (86 columns of 24) or Q (52
+   diagonals of 43), over the sector from the header on. */
+static void
+ecc_compute_block(const uint8_t *src, int major_count, int minor_count, int major_mult, int minor_inc, uint8_t *dest)
+{
+    const int size = major_count * minor_count;
+
+    for (int major = 0; major < major_count; major++) {
+        int     index = ((major >> 1) * major_mult) + (major & 1);
+        uint8_t ecc_a = 0;
+        uint8_t ecc_b = 0;
+
+        for (int minor = 0; minor < minor_count; minor++) {
+            const uint8_t temp = src[index];
+
+            index += minor_inc;
+            if (index >= size)
+                index -= size;
+            ecc_a ^= temp;
+            ecc_b ^= temp;
+            ecc_a = ecc_f_lut[ecc_a];
+        }
+
+        ecc_a                     = ecc_b_lut[ecc_f_lut[ecc_a] ^ ecc_b];
+        dest[major]               = ecc_a;
+        dest[major + major_count] = ecc_a ^ ecc_b;
+    }
+}
+
 static void
-read_sector_to_buffer(cdrom_t *dev, uint8_t *rbuf, uint32_t msf, uint32_t lba, int mode2, int len)
+sector_edc_ecc(uint8_t *rbuf, int mode2)
+{
+    uint8_t  header[4];
+    uint32_t edc;
+
+    if (!edc_ecc_ready)
+        edc_ecc_init();
+
+    if (mode2) {
+        /* XA Mode 2 Form 1: EDC over the sub-header and data, ECC with a zero header. */
+        edc = edc_compute(rbuf + 16, 2056);
+        rbuf[2072] = edc & 0xff;
+        rbuf[2073] = (edc >> 8) & 0xff;
+        rbuf[2074] = (edc >> 16) & 0xff;
+        rbuf[2075] = (edc >> 24) & 0xff;
+
+        memcpy(header, rbuf + 12, 4);
+        memset(rbuf + 12, 0x00, 4);
+    } else {
+        edc = edc_compute(rbuf, 2064);
+        rbuf[2064] = edc & 0xff;
+        rbuf[2065] = (edc >> 8) & 0xff;
+        rbuf[2066] = (edc >> 16) & 0xff;
+        rbuf[2067] = (edc >> 24) & 0xff;
+        memset(rbuf + 2068, 0x00, 8);
+    }
+
+    ecc_compute_block(rbuf + 12, 86, 24, 2, 86, rbuf + 2076);
+    ecc_compute_block(rbuf + 12, 52, 43, 86, 88, rbuf + 2248);
+
+    if (mode2)
+        memcpy(rbuf + 12, header, 4);
+}
+
+static void
+read_sector_to_buffer(cdrom_t *dev, uint8_t *rbuf, uint32_t msf, uint32_t lba, int mode2, int len, int cdrom_sector_flags)
 {
     uint8_t *bb = rbuf;
     const int offset = (!!(mode2 & 0x03)) ? 24 : 16;
 
-    dev->ops->read_sector(dev, CD_READ_DATA, rbuf + offset, lba);
+    cdrom_read_sector(dev, CD_READ_DATA, rbuf + offset, lba);
 
     /* Sync bytes */
     bb[0] = 0;
@@ -1546,12 +1849,15 @@ read_sector_to_buffer(cdrom_t *dev, uint8_t *rbuf, uint32_t msf, uint32_t lba, i
         memset(bb, 0, 280);
     else if (!mode2)
         memset(bb, 0, 288);
+
+    if ((cdrom_sector_flags & 0x08) && (len == 2048))
+        sector_edc_ecc(rbuf, mode2);
 }
 
 static void
 read_audio(cdrom_t *dev, uint32_t lba, uint8_t *b)
 {
-    dev->ops->read_sector(dev, CD_READ_RAW, raw_buffer, lba);
+    cdrom_read_sector(dev, CD_READ_RAW, raw_buffer, lba);
 
     memcpy(b, raw_buffer, 2352);
 
@@ -1562,9 +1868,9 @@ static void
 read_mode1(cdrom_t *dev, int cdrom_sector_flags, uint32_t lba, uint32_t msf, int mode2, uint8_t *b)
 {
     if ((dev->cd_status == CD_STATUS_DATA_ONLY) || (dev->ops->sector_size(dev, lba) == 2048))
-        read_sector_to_buffer(dev, raw_buffer, msf, lba, mode2, 2048);
+        read_sector_to_buffer(dev, raw_buffer, msf, lba, mode2, 2048, cdrom_sector_flags);
     else
-        dev->ops->read_sector(dev, CD_READ_RAW, raw_buffer, lba);
+        cdrom_read_sector(dev, CD_READ_RAW, raw_buffer, lba);
 
     cdrom_sector_size = 0;
 
@@ -1616,9 +1922,9 @@ static void
 read_mode2_non_xa(cdrom_t *dev, int cdrom_sector_flags, uint32_t lba, uint32_t msf, int mode2, uint8_t *b)
 {
     if ((dev->cd_status == CD_STATUS_DATA_ONLY) || (dev->ops->sector_size(dev, lba) == 2336))
-        read_sector_to_buffer(dev, raw_buffer, msf, lba, mode2, 2336);
+        read_sector_to_buffer(dev, raw_buffer, msf, lba, mode2, 2336, cdrom_sector_flags);
     else
-        dev->ops->read_sector(dev, CD_READ_RAW, raw_buffer, lba);
+        cdrom_read_sector(dev, CD_READ_RAW, raw_buffer, lba);
 
     cdrom_sector_size = 0;
 
@@ -1660,9 +1966,9 @@ static void
 read_mode2_xa_form1(cdrom_t *dev, int cdrom_sector_flags, uint32_t lba, uint32_t msf, int mode2, uint8_t *b)
 {
     if ((dev->cd_status == CD_STATUS_DATA_ONLY) || (dev->ops->sector_size(dev, lba) == 2048))
-        read_sector_to_buffer(dev, raw_buffer, msf, lba, mode2, 2048);
+        read_sector_to_buffer(dev, raw_buffer, msf, lba, mode2, 2048, cdrom_sector_flags);
     else
-        dev->ops->read_sector(dev, CD_READ_RAW, raw_buffer, lba);
+        cdrom_read_sector(dev, CD_READ_RAW, raw_buffer, lba);
 
     cdrom_sector_size = 0;
 
@@ -1711,9 +2017,9 @@ static void
 read_mode2_xa_form2(cdrom_t *dev, int cdrom_sector_flags, uint32_t lba, uint32_t msf, int mode2, uint8_t *b)
 {
     if ((dev->cd_status == CD_STATUS_DATA_ONLY) || (dev->ops->sector_size(dev, lba) == 2324))
-        read_sector_to_buffer(dev, raw_buffer, msf, lba, mode2, 2324);
+        read_sector_to_buffer(dev, raw_buffer, msf, lba, mode2, 2324, cdrom_sector_flags);
     else
-        dev->ops->read_sector(dev, CD_READ_RAW, raw_buffer, lba);
+        cdrom_read_sector(dev, CD_READ_RAW, raw_buffer, lba);
 
     cdrom_sector_size = 0;
 
@@ -1913,10 +2219,57 @@ cdrom_readsector_raw(cdrom_t *dev, uint8_t *buffer, int sector, int ismsf, int c
     }
 
     *len = cdrom_sector_size;
+    metrics.cdrom_read_bytes += cdrom_sector_size;
 
     return 1;
 }
 
+/* Reads a run of sectors wanting only their 2048 bytes of user data, what
+   READ (10) and READ (12) ask for, with one backend read per track rather
+   than a whole sector conversion each. Returns how many were read, which
+   falls short where the rest needs cdrom_readsector_raw(), which also keeps
+   its handling of reads past the end of the image. */
+int
+cdrom_readsectors_data(cdrom_t *dev, uint8_t *buffer, uint32_t lba, int num, int cdrom_sector_type,
+                       int cdrom_sector_flags, int *len)
+{
+    int done = 0;
+
+    *len = 0;
+
+    if ((dev->cd_status == CD_STATUS_EMPTY) || !dev->ops || !dev->ops->read_sectors || !dev->ops->track_type)
+        return 0;
+
+    /* User data alone: no sync, header, EDC/ECC, error flags or subchannel. */
+    if (cdrom_sector_flags != 0x10)
+        return 0;
+
+    while (done < num) {
+        const int track = dev->ops->track_type(dev, lba + done);
+        int       got;
+
+        if (track & CD_TRACK_AUDIO)
+            break;
+        if (track & ~CD_TRACK_AUDIO) {
+            /* XA Mode 2 Form 1. */
+            if (((track & 0x03) != 1) || ((cdrom_sector_type != 0) && (cdrom_sector_type != 4) && (cdrom_sector_type != 8)))
+                break;
+        } else if ((cdrom_sector_type != 0) && (cdrom_sector_type != 2) && (cdrom_sector_type != 8))
+            break;
+
+        got = cdrom_read_sectors(dev, buffer + (done * 2048), lba + done, num - done);
+        if (got <= 0)
+            break;
+
+        done += got;
+    }
+
+    *len = done * 2048;
+    metrics.cdrom_read_bytes += *len;
+
+    return done;
+}
+
 /* Peform a master init on the entire module. */
 void
 cdrom_global_init(void)
@@ -1948,6 +2301,7 @@ cdrom_hard_reset(void)
             dev->id = i;
 
             cdrom_drive_reset(dev);
+            cdrom_prefetch_init(dev);
 
             switch (dev->bus_type) {
                 case CDROM_BUS_ATAPI:
@@ -1996,6 +2350,8 @@ cdrom_close(void)
         if (dev->close)
             dev->close(dev->priv);
 
+        cdrom_prefetch_close(dev);
+
         if (dev->ops && dev->ops->exit)
             dev->ops->exit(dev);
 
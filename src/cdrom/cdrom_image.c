@@ -203,6 +203,14 @@ image_read_sector(struct cdrom *dev, int type, uint8_t *b, uint32_t lba)
     }
 }
 
+static int
+image_read_sectors(struct cdrom *dev, uint8_t *b, uint32_t lba, int num)
+{
+    cd_img_t *img = (cd_img_t *) dev->image;
+
+    return cdi_read_sectors(img, b, 0, lba, (uint32_t) num);
+}
+
 static int
 image_track_type(cdrom_t *dev, uint32_t lba)
 {
@@ -232,6 +240,7 @@ image_exit(cdrom_t *dev)
     cd_img_t *img = (cd_img_t *) dev->image;
 
     cdrom_image_log("CDROM: image_exit(%s)\n", dev->image_path);
+    cdrom_media_lock(dev);
     dev->cd_status = CD_STATUS_EMPTY;
 
     if (img) {
@@ -240,6 +249,8 @@ image_exit(cdrom_t *dev)
     }
 
     dev->ops = NULL;
+
+    cdrom_media_unlock(dev);
 }
 
 static const cdrom_ops_t cdrom_image_ops = {
@@ -251,7 +262,8 @@ static const cdrom_ops_t cdrom_image_ops = {
     image_read_sector,
     image_track_type,
     image_ext_medium_changed,
-    image_exit
+    image_exit,
+    image_read_sectors
 };
 
 static int
@@ -46,6 +46,25 @@
 #define MAX_FILENAME_LENGTH 256
 #define CROSS_LEN           512
 
+/* Read-ahead cache for .BIN files: a few windows per file, each filled with
+   one large read starting at the sector that missed, recycled LRU. */
+#define BIN_CACHE_WINDOWS   4
+#define BIN_CACHE_SIZE      (64 * 1024)
+
+typedef struct bin_window_t {
+    uint64_t start;
+    uint32_t len;
+    uint32_t stamp;
+    uint8_t *data;
+} bin_window_t;
+
+typedef struct bin_cache_t {
+    bin_window_t win[BIN_CACHE_WINDOWS];
+    uint32_t     stamp;
+    uint64_t     hits;
+    uint64_t     misses;
+} bin_cache_t;
+
 static char temp_keyword[1024];
 
 #ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
@@ -67,10 +86,32 @@ cdrom_image_backend_log(const char *fmt, ...)
 #endif
 
 /* Binary file functions. */
+static int
+bin_read_file(track_file_t *tf, uint8_t *buffer, uint64_t seek, size_t count)
+{
+    if (fseeko64(tf->fp, seek, SEEK_SET) == -1) {
+#ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
+        cdrom_image_backend_log("CDROM: binary_read failed during seek!\n");
+#endif
+        return 0;
+    }
+
+    if (fread(buffer, count, 1, tf->fp) != 1) {
+#ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
+        cdrom_image_backend_log("CDROM: binary_read failed during read!\n");
+#endif
+        return 0;
+    }
+
+    return 1;
+}
+
 static int
 bin_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
 {
     track_file_t *tf;
+    bin_cache_t  *cache;
+    bin_window_t *win;
 
     cdrom_image_backend_log("CDROM: binary_read(%08lx, pos=%" PRIu64 " count=%lu\n",
                             tf->fp, seek, count);
@@ -78,20 +119,48 @@ bin_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
     if ((tf = (track_file_t *) priv)->fp == NULL)
         return 0;
 
-    if (fseeko64(tf->fp, seek, SEEK_SET) == -1) {
-#ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
-        cdrom_image_backend_log("CDROM: binary_read failed during seek!\n");
-#endif
-        return 0;
+    cache = (bin_cache_t *) tf->priv;
+    if ((cache == NULL) || (count > BIN_CACHE_SIZE))
+        return bin_read_file(tf, buffer, seek, count);
+
+    win = &cache->win[0];
+    for (int i = 0; i < BIN_CACHE_WINDOWS; i++) {
+        bin_window_t *w = &cache->win[i];
+
+        if (w->len && (seek >= w->start) && ((seek + count) <= (w->start + w->len))) {
+            memcpy(buffer, &w->data[seek - w->start], count);
+            w->stamp = ++cache->stamp;
+            cache->hits++;
+            return 1;
+        }
+
+        if (!w->len || (w->stamp < win->stamp))
+            win = w;
     }
 
-    if (fread(buffer, count, 1, tf->fp) != 1) {
+    cache->misses++;
+
+    if (win->data == NULL)
+        win->data = (uint8_t *) malloc(BIN_CACHE_SIZE);
+    win->len = 0;
+
+    if ((win->data == NULL) || (fseeko64(tf->fp, seek, SEEK_SET) == -1))
+        return bin_read_file(tf, buffer, seek, count);
+
+    /* Short near the end of the file, only fail if the request itself is. */
+    win->len = (uint32_t) fread(win->data, 1, BIN_CACHE_SIZE, tf->fp);
+    if (win->len < count) {
+        win->len = 0;
 #ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
         cdrom_image_backend_log("CDROM: binary_read failed during read!\n");
 #endif
         return 0;
     }
 
+    win->start = seek;
+    win->stamp = ++cache->stamp;
+    memcpy(buffer, win->data, count);
+
     return 1;
 }
 
@@ -125,6 +194,18 @@ bin_close(void *priv)
         tf->fp = NULL;
     }
 
+    if (tf->priv != NULL) {
+        bin_cache_t *cache = (bin_cache_t *) tf->priv;
+
+        cdrom_image_backend_log("CDROM: binary_close(%s): %" PRIu64 " cache hits, %" PRIu64 " misses\n",
+                                tf->fn, cache->hits, cache->misses);
+
+        for (int i = 0; i < BIN_CACHE_WINDOWS; i++)
+            free(cache->win[i].data);
+        free(cache);
+        tf->priv = NULL;
+    }
+
     memset(tf->fn, 0x00, sizeof(tf->fn));
 
     free(priv);
@@ -142,6 +223,7 @@ bin_init(const char *filename, int *error)
     }
 
     memset(tf->fn, 0x00, sizeof(tf->fn));
+    tf->priv = NULL;
     strncpy(tf->fn, filename, sizeof(tf->fn) - 1);
     tf->fp = plat_fopen64(tf->fn, "rb");
     cdrom_image_backend_log("CDROM: binary_open(%s) = %08lx\n", tf->fn, tf->fp);
@@ -157,6 +239,7 @@ bin_init(const char *filename, int *error)
         tf->read       = bin_read;
         tf->get_length = bin_get_length;
         tf->close      = bin_close;
+        tf->priv       = calloc(1, sizeof(bin_cache_t));
     } else {
         /* From the check above, error may still be non-zero if opening a directory.
          * The error is set for viso to try and open the directory following this function.
@@ -176,8 +259,13 @@ bin_init(const char *filename, int *error)
 static track_file_t *
 track_file_init(const char *filename, int *error)
 {
-    /* Current we only support .BIN files, either combined or one per
-       track. In the future, more is planned. */
+    /* Compressed CSO images are recognized by their header, anything
+       else is a .BIN file, either combined or one per track. */
+    track_file_t *tf = cso_init(filename, error);
+
+    if (!*error)
+        return tf;
+
     return bin_init(filename, error);
 }
 
@@ -312,24 +400,35 @@ cdi_get_audio_track_info_lba(cd_img_t *cdi, UNUSED(int end), int track, int *tra
 int
 cdi_get_track(cd_img_t *cdi, uint32_t sector)
 {
+    int lo;
+    int hi;
+
     /* There must be at least two tracks - data and lead out. */
     if (cdi->tracks_num < 2)
         return -1;
 
+    /* Take into account cue sheets that do not start on sector 0. */
+    if (sector < cdi->tracks[0].start)
+        return cdi->tracks[0].number;
+
+    /* Track starts ascend as loaded, so look for the last track starting at
+       or before the sector. */
+    lo = 0;
     /* This has a problem - the code skips the last track, which is
        lead out - is that correct? */
-    for (int i = 0; i < (cdi->tracks_num - 1); i++) {
-        const track_t *cur  = &cdi->tracks[i];
-        const track_t *next = &cdi->tracks[i + 1];
+    hi = cdi->tracks_num - 2;
+    while (lo < hi) {
+        const int mid = (lo + hi + 1) >> 1;
 
-        /* Take into account cue sheets that do not start on sector 0. */
-        if ((i == 0) && (sector < cur->start))
-            return cur->number;
-
-        if ((cur->start <= sector) && (sector < next->start))
-            return cur->number;
+        if (cdi->tracks[mid].start <= sector)
+            lo = mid;
+        else
+            hi = mid - 1;
     }
 
+    if (sector < cdi->tracks[lo + 1].start)
+        return cdi->tracks[lo].number;
+
     return -1;
 }
 
@@ -417,34 +516,61 @@ cdi_read_sector(cd_img_t *cdi, uint8_t *buffer, int raw, uint32_t sector)
         return trk->file->read(trk->file, buffer, seek, length);
 }
 
+/* Reads up to num sectors, stopping at the end of the track holding the
+   first one, with a single file read when the track stores them the way
+   they are asked for; returns how many were read, 0 on error. */
 int
 cdi_read_sectors(cd_img_t *cdi, uint8_t *buffer, int raw, uint32_t sector, uint32_t num)
 {
-    int      success = 1;
+    const int track = cdi_get_track(cdi, sector) - 1;
+    int       sector_size;
+    int       whole;
 
-    /* TODO: This fails to account for Mode 2. Shouldn't we have a function
-             to get sector size? */
-    const int       sector_size = raw ? RAW_SECTOR_SIZE : COOKED_SECTOR_SIZE;
-    const uint32_t  buf_len     = num * sector_size;
-    uint8_t        *buf         = (uint8_t *) malloc(buf_len * sizeof(uint8_t));
+    if ((track < 0) || (num == 0))
+        return 0;
 
-    for (uint32_t i = 0; i < num; i++) {
-        success = cdi_read_sector(cdi, &buf[i * sector_size], raw, sector + i);
-        if (!success)
-            break;
-        /* Based on the DOSBox patch, but check all 8 bytes and makes sure it's not an
-           audio track. */
-        if (raw && (sector < cdi->tracks[0].length) &&
-            !cdi->tracks[0].mode2 && (cdi->tracks[0].attr != AUDIO_TRACK) &&
-            *(uint64_t *) &(buf[(i * sector_size) + 2068]))
+    const track_t *trk = &cdi->tracks[track];
+
+    /* The lead out entry follows the last track, so there always is a next one. */
+    if ((sector < trk->start) || ((track + 1) >= cdi->tracks_num))
+        num = 1;
+    else if ((sector + (uint64_t) num) > cdi->tracks[track + 1].start)
+        num = (uint32_t) (cdi->tracks[track + 1].start - sector);
+    if (num == 0)
+        num = 1;
+
+    if (raw)
+        sector_size = RAW_SECTOR_SIZE;
+    else if (trk->mode2 && (trk->form != 1))
+        sector_size = (trk->form == 2) ? 2328 : 2336;
+    else
+        sector_size = COOKED_SECTOR_SIZE;
+
+    whole = (num > 1) && (sector >= trk->start) && (trk->sector_size == sector_size);
+
+    if (whole) {
+        const uint64_t seek = trk->skip + (((uint64_t) sector - trk->start) * trk->sector_size);
+
+        if (!trk->file->read(trk->file, buffer, seek, (size_t) num * sector_size))
             return 0;
+    } else {
+        for (uint32_t i = 0; i < num; i++) {
+            if (!cdi_read_sector(cdi, &buffer[i * sector_size], raw, sector + i))
+                return 0;
+        }
     }
 
-    memcpy((void *) buffer, buf, buf_len);
-    free(buf);
-    buf = NULL;
+    /* Based on the DOSBox patch, but check all 8 bytes and makes sure it's not an
+       audio track. */
+    if (raw && (sector < cdi->tracks[0].length) &&
+        !cdi->tracks[0].mode2 && (cdi->tracks[0].attr != AUDIO_TRACK)) {
+        for (uint32_t i = 0; i < num; i++) {
+            if (*(uint64_t *) &(buffer[(i * sector_size) + 2068]))
+                return 0;
+        }
+    }
 
-    return success;
+    return (int) num;
 }
 
 /* TODO: Do CUE+BIN images with a sector size of 2448 even exist? */
@@ -550,7 +676,7 @@ cdi_load_iso(cd_img_t *cdi, const char *filename)
     memset(&trk, 0, sizeof(track_t));
 
     /* Data track (shouldn't there be a lead in track?). */
-    trk.file = bin_init(filename, &error);
+    trk.file = track_file_init(filename, &error);
     if (error) {
         if ((trk.file != NULL) && (trk.file->close != NULL))
             trk.file->close(trk.file);
@@ -0,0 +1,403 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Compressed ISO (CSO/CISO version 1) CD-ROM image back-end.
+ *
+ *          The image is a 24-byte header, a table of block offsets
+ *          and the blocks themselves, each one either stored as is
+ *          or deflated on its own. Decoded blocks are kept in a
+ *          small LRU cache, and a worker thread decodes the blocks
+ *          following the last one read so sequential reads do not
+ *          wait on zlib.
+ */
+#ifndef _LARGEFILE_SOURCE
+#    define _LARGEFILE_SOURCE
+#endif
+#ifndef _LARGEFILE64_SOURCE
+#    define _LARGEFILE64_SOURCE
+#endif
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <zlib.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/cdrom_image_backend.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+
+#define CSO_MAGIC           "CISO"
+#define CSO_HEADER_SIZE     24
+#define CSO_INDEX_PLAIN     0x80000000
+#define CSO_CACHE_BLOCKS    32
+#define CSO_PREFETCH_BLOCKS 8
+
+typedef struct cso_block_t {
+    uint32_t block;
+    uint32_t stamp;
+    uint8_t *data;
+} cso_block_t;
+
+typedef struct cso_t {
+    uint64_t    total_bytes;
+    uint32_t    block_size;
+    uint32_t    blocks;
+    uint8_t     align;
+    uint32_t   *index;
+
+    uint8_t    *comp_buf;
+    uint32_t    comp_size;
+    z_stream    zs;
+
+    /* Held around the file, the inflater and the cache. */
+    mutex_t    *mutex;
+    cso_block_t cache[CSO_CACHE_BLOCKS];
+    uint32_t    stamp;
+    uint64_t    hits;
+    uint64_t    misses;
+
+    thread_t   *thread;
+    event_t    *wake;
+    uint32_t    prefetch;
+    volatile int stop;
+} cso_t;
+
+#ifdef ENABLE_CDROM_IMAGE_CSO_LOG
+int cdrom_image_cso_do_log = ENABLE_CDROM_IMAGE_CSO_LOG;
+
+void
+cdrom_image_cso_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (cdrom_image_cso_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define cdrom_image_cso_log(fmt, ...)
+#endif
+
+static cso_block_t *
+cso_cache_find(cso_t *cso, uint32_t block)
+{
+    for (int i = 0; i < CSO_CACHE_BLOCKS; i++) {
+        if ((cso->cache[i].data != NULL) && (cso->cache[i].block == block))
+            return &cso->cache[i];
+    }
+
+    return NULL;
+}
+
+/* Decodes a block into the least recently used cache slot; called with the mutex held. */
+static cso_block_t *
+cso_decode(track_file_t *tf, uint32_t block)
+{
+    cso_t       *cso  = (cso_t *) tf->priv;
+    cso_block_t *slot = &cso->cache[0];
+    uint32_t     idx  = cso->index[block];
+    uint64_t     pos  = ((uint64_t) (idx & ~CSO_INDEX_PLAIN)) << cso->align;
+    uint64_t     end  = ((uint64_t) (cso->index[block + 1] & ~CSO_INDEX_PLAIN)) << cso->align;
+    uint32_t     out  = cso->block_size;
+    size_t       len;
+
+    for (int i = 1; i < CSO_CACHE_BLOCKS; i++) {
+        if (cso->cache[i].stamp < slot->stamp)
+            slot = &cso->cache[i];
+    }
+
+    if (slot->data == NULL) {
+        slot->data = (uint8_t *) malloc(cso->block_size);
+        if (slot->data == NULL)
+            return NULL;
+    }
+    slot->stamp = 0;
+    slot->block = block;
+
+    if ((end < pos) || ((end - pos) > cso->comp_size) || (fseeko64(tf->fp, pos, SEEK_SET) == -1))
+        goto fail;
+
+    /* The last block only holds what is left of the image. */
+    if (((uint64_t) block * cso->block_size + out) > cso->total_bytes)
+        out = (uint32_t) (cso->total_bytes - ((uint64_t) block * cso->block_size));
+
+    if (idx & CSO_INDEX_PLAIN) {
+        if (fread(slot->data, 1, out, tf->fp) != out)
+            goto fail;
+    } else {
+        /* Alignment padding may run past the end of the file. */
+        len = fread(cso->comp_buf, 1, (size_t) (end - pos), tf->fp);
+        if ((len == 0) || (inflateReset(&cso->zs) != Z_OK))
+            goto fail;
+
+        cso->zs.next_in   = cso->comp_buf;
+        cso->zs.avail_in  = (uInt) len;
+        cso->zs.next_out  = slot->data;
+        cso->zs.avail_out = out;
+
+        int ret = inflate(&cso->zs, Z_FINISH);
+        if (((ret != Z_STREAM_END) && (ret != Z_BUF_ERROR)) || (cso->zs.avail_out != 0))
+            goto fail;
+    }
+
+    slot->stamp = ++cso->stamp;
+    return slot;
+
+fail:
+    cdrom_image_cso_log("CSO: failed to decode block %u\n", block);
+    free(slot->data);
+    slot->data = NULL;
+    return NULL;
+}
+
+static void
+cso_prefetch_thread(void *priv)
+{
+    track_file_t *tf  = (track_file_t *) priv;
+    cso_t        *cso = (cso_t *) tf->priv;
+
+    while (1) {
+        thread_wait_event(cso->wake, -1);
+        thread_reset_event(cso->wake);
+
+        if (cso->stop)
+            break;
+
+        thread_wait_mutex(cso->mutex);
+        uint32_t first = cso->prefetch;
+        thread_release_mutex(cso->mutex);
+
+        for (uint32_t i = 0; (i < CSO_PREFETCH_BLOCKS) && !cso->stop; i++) {
+            uint32_t block = first + i;
+            int      stale;
+
+            if (block >= cso->blocks)
+                break;
+
+            thread_wait_mutex(cso->mutex);
+            /* A newer request supersedes this one. */
+            stale = (cso->prefetch != first);
+            if (!stale && (cso_cache_find(cso, block) == NULL))
+                cso_decode(tf, block);
+            thread_release_mutex(cso->mutex);
+
+            if (stale)
+                break;
+        }
+    }
+}
+
+int
+cso_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
+{
+    track_file_t *tf  = (track_file_t *) priv;
+    cso_t        *cso = (cso_t *) tf->priv;
+    cso_block_t  *slot;
+    uint32_t      block = 0;
+    uint32_t      ofs;
+    uint32_t      len;
+
+    if ((cso == NULL) || ((seek + count) > cso->total_bytes))
+        return 0;
+
+    thread_wait_mutex(cso->mutex);
+
+    while (count > 0) {
+        block = (uint32_t) (seek / cso->block_size);
+        ofs   = (uint32_t) (seek % cso->block_size);
+        len   = cso->block_size - ofs;
+        if (len > count)
+            len = (uint32_t) count;
+
+        if ((slot = cso_cache_find(cso, block)) != NULL) {
+            slot->stamp = ++cso->stamp;
+            cso->hits++;
+        } else {
+            cso->misses++;
+            if ((slot = cso_decode(tf, block)) == NULL) {
+                thread_release_mutex(cso->mutex);
+                return 0;
+            }
+        }
+
+        memcpy(buffer, &slot->data[ofs], len);
+        buffer += len;
+        seek += len;
+        count -= len;
+    }
+
+    /* Have the worker decode what a sequential read will want next. */
+    cso->prefetch = block + 1;
+    thread_release_mutex(cso->mutex);
+
+    if ((cso->thread != NULL) && ((block + 1) < cso->blocks))
+        thread_set_event(cso->wake);
+
+    return 1;
+}
+
+uint64_t
+cso_get_length(void *priv)
+{
+    const track_file_t *tf  = (track_file_t *) priv;
+    const cso_t        *cso = (cso_t *) tf->priv;
+
+    return (cso == NULL) ? 0ULL : cso->total_bytes;
+}
+
+void
+cso_close(void *priv)
+{
+    track_file_t *tf  = (track_file_t *) priv;
+    cso_t        *cso = (cso_t *) tf->priv;
+
+    if (cso != NULL) {
+        cdrom_image_cso_log("CSO: close(%s): %" PRIu64 " cache hits, %" PRIu64 " misses\n",
+                            tf->fn, cso->hits, cso->misses);
+
+        if (cso->thread != NULL) {
+            cso->stop = 1;
+            thread_set_event(cso->wake);
+            thread_wait(cso->thread);
+        }
+        if (cso->wake != NULL)
+            thread_destroy_event(cso->wake);
+        if (cso->mutex != NULL)
+            thread_close_mutex(cso->mutex);
+
+        for (int i = 0; i < CSO_CACHE_BLOCKS; i++)
+            free(cso->cache[i].data);
+
+        inflateEnd(&cso->zs);
+        free(cso->comp_buf);
+        free(cso->index);
+        free(cso);
+    }
+
+    if (tf->fp != NULL)
+        fclose(tf->fp);
+
+    free(tf);
+}
+
+static int
+cso_open(track_file_t *tf, cso_t *cso)
+{
+    uint8_t  header[CSO_HEADER_SIZE];
+    uint64_t max = 0;
+
+    if ((fread(header, 1, CSO_HEADER_SIZE, tf->fp) != CSO_HEADER_SIZE) || memcmp(header, CSO_MAGIC, 4))
+        return 0;
+
+    /* Everything is little endian; the header size field is unreliable, the index always follows. */
+    for (int i = 7; i >= 0; i--)
+        cso->total_bytes = (cso->total_bytes << 8) | header[8 + i];
+    cso->block_size = header[16] | (header[17] << 8) | (header[18] << 16) | ((uint32_t) header[19] << 24);
+    cso->align      = header[21];
+
+    if ((header[20] > 1) || (cso->align > 31) || (cso->total_bytes == 0ULL) ||
+        (cso->block_size < 512) || (cso->block_size > (1 << 20)) || (cso->block_size & (cso->block_size - 1))) {
+        cdrom_image_cso_log("CSO: unsupported header (version %i, block size %u)\n", header[20], cso->block_size);
+        return 0;
+    }
+
+    cso->blocks = (uint32_t) ((cso->total_bytes + cso->block_size - 1) / cso->block_size);
+    cso->index  = (uint32_t *) malloc((cso->blocks + 1) * sizeof(uint32_t));
+    if ((cso->index == NULL) || (fread(cso->index, sizeof(uint32_t), cso->blocks + 1, tf->fp) != (cso->blocks + 1)))
+        return 0;
+
+    for (uint32_t i = 0; i <= cso->blocks; i++) {
+        const uint8_t *p = (uint8_t *) &cso->index[i];
+
+        cso->index[i] = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+        if (i > 0) {
+            uint64_t pos = ((uint64_t) (cso->index[i - 1] & ~CSO_INDEX_PLAIN)) << cso->align;
+            uint64_t end = ((uint64_t) (cso->index[i] & ~CSO_INDEX_PLAIN)) << cso->align;
+
+            if ((end > pos) && ((end - pos) > max))
+                max = end - pos;
+        }
+    }
+
+    /* Deflate never grows a block by more than a few bytes, or it would have been stored. */
+    if (max > ((uint64_t) cso->block_size * 2) + (1ULL << cso->align))
+        return 0;
+
+    cso->comp_size = (uint32_t) max;
+    cso->comp_buf  = (uint8_t *) malloc(cso->comp_size + 1);
+    if (cso->comp_buf == NULL)
+        return 0;
+
+    if (inflateInit2(&cso->zs, -15) != Z_OK)
+        return 0;
+
+    cso->mutex = thread_create_mutex();
+    if (thread_get_cpu_count() >= 2) {
+        cso->wake   = thread_create_event();
+        cso->thread = thread_create(cso_prefetch_thread, tf);
+    }
+
+    return 1;
+}
+
+track_file_t *
+cso_init(const char *filename, int *error)
+{
+    track_file_t *tf = (track_file_t *) calloc(1, sizeof(track_file_t));
+    cso_t        *cso;
+
+    *error = 1;
+
+    if (tf == NULL)
+        return NULL;
+
+    strncpy(tf->fn, filename, sizeof(tf->fn) - 1);
+    tf->fp = plat_fopen64(tf->fn, "rb");
+    if (tf->fp == NULL) {
+        free(tf);
+        return NULL;
+    }
+
+    cso = (cso_t *) calloc(1, sizeof(cso_t));
+    if (cso == NULL) {
+        fclose(tf->fp);
+        free(tf);
+        return NULL;
+    }
+
+    /* Set before the worker thread starts. */
+    tf->priv = cso;
+    if (!cso_open(tf, cso)) {
+        /* Not ours, or broken; the caller falls back to a plain image. */
+        if (cso->zs.state != NULL)
+            inflateEnd(&cso->zs);
+        free(cso->comp_buf);
+        free(cso->index);
+        free(cso);
+        fclose(tf->fp);
+        free(tf);
+        return NULL;
+    }
+
+    cdrom_image_cso_log("CSO: open(%s): %" PRIu64 " bytes in %u blocks of %u\n",
+                        tf->fn, cso->total_bytes, cso->blocks, cso->block_size);
+
+    tf->read       = cso_read;
+    tf->get_length = cso_get_length;
+    tf->close      = cso_close;
+
+    *error = 0;
+    return tf;
+}
@@ -78,7 +78,8 @@ typedef struct stat stat_t;
     }
 
 #define VISO_SECTOR_SIZE COOKED_SECTOR_SIZE
-#define VISO_OPEN_FILES  32
+#define VISO_OPEN_FILES  128       /* must be a power of two */
+#define VISO_FILE_BUF    (64 * 1024) /* stdio buffer per open file */
 
 enum {
     VISO_CHARSET_D = 0,
@@ -704,6 +705,10 @@ viso_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
                     if ((entry->file = fopen(entry->path, "rb"))) {
                         cdrom_image_viso_log("\n");
 
+                        /* Sectors come in one at a time, let stdio read
+                           ahead in larger chunks. */
+                        setvbuf(entry->file, NULL, _IOFBF, VISO_FILE_BUF);
+
                         /* Add this entry to the FIFO. */
                         viso->file_fifo[viso->file_fifo_pos++] = entry;
                         viso->file_fifo_pos &= (sizeof(viso->file_fifo) / sizeof(viso->file_fifo[0])) - 1;
@@ -715,9 +720,15 @@ viso_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
                     }
                 }
 
-                /* Read data. */
-                if (entry->file && (fseeko64(entry->file, seek - entry->data_offset, SEEK_SET) != -1))
-                    read = fread(buffer, 1, sector_remain, entry->file);
+                /* Read data. Only seek when the read is not sequential, as
+                   seeking throws away what stdio has buffered. */
+                if (entry->file) {
+                    const uint64_t file_pos = seek - entry->data_offset;
+
+                    if ((ftello64(entry->file) == (int64_t) file_pos) ||
+                        (fseeko64(entry->file, file_pos, SEEK_SET) != -1))
+                        read = fread(buffer, 1, sector_remain, entry->file);
+                }
             }
 
             /* Fill remainder with 00 bytes if needed. */
@@ -29,6 +29,7 @@
 #include <86box/path.h>
 #include <86box/plat.h>
 #include <86box/plat_cdrom.h>
+#include <86box/thread.h>
 #include <86box/scsi_device.h>
 #include <86box/cdrom.h>
 
@@ -55,12 +56,250 @@ cdrom_ioctl_log(const char *fmt, ...)
    of the audio while audio still plays. With an absolute conversion, the counter is fine. */
 #define MSFtoLBA(m, s, f) ((((m * 60) + s) * 75) + f)
 
+/* Sequential read-ahead. Host optical drives take tens of milliseconds per
+   request, so once the guest reads data sectors in order, a thread of our
+   own reads the following ones in larger requests into a direct mapped
+   cache, and the next guest reads are copies. Every call into the host
+   drive goes through plat_mutex, the platform code is not reentrant. */
+#define IOCTL_CACHE_SECTORS 256 /* Must be a power of two. */
+#define IOCTL_READ_AHEAD    64
+#define IOCTL_READ_CHUNK    16
+
+typedef struct ioctl_cache_t {
+    thread_t    *thread;
+    event_t     *wake;
+    mutex_t     *plat_mutex;
+    mutex_t     *cache_mutex;
+    volatile int run;
+
+    /* Protected by cache_mutex; gen changes whenever the cache is dropped,
+       so that a read in flight does not land in it. */
+    uint32_t     gen;
+    uint32_t     ahead_from;
+    uint32_t     ahead_to;
+    int          sector_size;
+    int          sub_valid;
+    uint32_t     sub_lba;
+    subchannel_t sub;
+    uint32_t     tag[IOCTL_CACHE_SECTORS];
+    uint8_t      valid[IOCTL_CACHE_SECTORS];
+    uint8_t      data[IOCTL_CACHE_SECTORS][COOKED_SECTOR_SIZE];
+} ioctl_cache_t;
+
+/* The platform code drives a single host drive. */
+static ioctl_cache_t *ioctl_cache = NULL;
+
+static void
+ioctl_plat_lock(void)
+{
+    if (ioctl_cache)
+        thread_wait_mutex(ioctl_cache->plat_mutex);
+}
+
+static void
+ioctl_plat_unlock(void)
+{
+    if (ioctl_cache)
+        thread_release_mutex(ioctl_cache->plat_mutex);
+}
+
+static int
+ioctl_cache_lookup(ioctl_cache_t *ic, uint8_t *b, uint32_t lba)
+{
+    const int slot = lba & (IOCTL_CACHE_SECTORS - 1);
+    int       hit  = 0;
+
+    thread_wait_mutex(ic->cache_mutex);
+    if (ic->valid[slot] && (ic->tag[slot] == lba)) {
+        memcpy(b, ic->data[slot], COOKED_SECTOR_SIZE);
+        hit = 1;
+    }
+    thread_release_mutex(ic->cache_mutex);
+
+    return hit;
+}
+
+static void
+ioctl_cache_store(ioctl_cache_t *ic, const uint8_t *b, uint32_t lba, int num, uint32_t gen)
+{
+    thread_wait_mutex(ic->cache_mutex);
+    if (gen == ic->gen) {
+        for (int i = 0; i < num; i++) {
+            const int slot = (lba + i) & (IOCTL_CACHE_SECTORS - 1);
+
+            memcpy(ic->data[slot], b + (i * COOKED_SECTOR_SIZE), COOKED_SECTOR_SIZE);
+            ic->tag[slot]   = lba + i;
+            ic->valid[slot] = 1;
+        }
+    }
+    thread_release_mutex(ic->cache_mutex);
+}
+
+/* Medium changes and anything else that may make the cached sectors stale. */
+static void
+ioctl_cache_drop(ioctl_cache_t *ic)
+{
+    if (ic == NULL)
+        return;
+
+    thread_wait_mutex(ic->cache_mutex);
+    memset(ic->valid, 0x00, sizeof(ic->valid));
+    ic->gen++;
+    ic->ahead_from  = ic->ahead_to = 0;
+    ic->sector_size = 0;
+    ic->sub_valid   = 0;
+    thread_release_mutex(ic->cache_mutex);
+}
+
+static void
+ioctl_cache_thread(void *priv)
+{
+    ioctl_cache_t *ic = (ioctl_cache_t *) priv;
+    uint8_t       *buf;
+    uint32_t       lba;
+    uint32_t       gen;
+    int            num;
+
+    buf = (uint8_t *) malloc(IOCTL_READ_CHUNK * COOKED_SECTOR_SIZE);
+    if (buf == NULL)
+        return;
+
+    while (ic->run) {
+        thread_wait_event(ic->wake, -1);
+        thread_reset_event(ic->wake);
+
+        while (ic->run) {
+            /* Skip what is already there, then read up to the first sector that is. */
+            thread_wait_mutex(ic->cache_mutex);
+            while (ic->ahead_from < ic->ahead_to) {
+                const int slot = ic->ahead_from & (IOCTL_CACHE_SECTORS - 1);
+
+                if (!ic->valid[slot] || (ic->tag[slot] != ic->ahead_from))
+                    break;
+                ic->ahead_from++;
+            }
+            lba = ic->ahead_from;
+            gen = ic->gen;
+            num = 0;
+            while ((num < IOCTL_READ_CHUNK) && ((lba + num) < ic->ahead_to)) {
+                const int slot = (lba + num) & (IOCTL_CACHE_SECTORS - 1);
+
+                if (ic->valid[slot] && (ic->tag[slot] == (lba + num)))
+                    break;
+                num++;
+            }
+            thread_release_mutex(ic->cache_mutex);
+
+            if (num == 0)
+                break;
+
+            thread_wait_mutex(ic->plat_mutex);
+            if (!plat_cdrom_read_sectors(buf, lba, num)) {
+                thread_release_mutex(ic->plat_mutex);
+
+                /* Past the end of the disc or unreadable, leave it to the guest. */
+                thread_wait_mutex(ic->cache_mutex);
+                if (gen == ic->gen)
+                    ic->ahead_from = ic->ahead_to;
+                thread_release_mutex(ic->cache_mutex);
+                break;
+            }
+            ioctl_cache_store(ic, buf, lba, num, gen);
+            thread_release_mutex(ic->plat_mutex);
+        }
+    }
+
+    free(buf);
+}
+
+static void
+ioctl_cache_init(void)
+{
+    ioctl_cache_t *ic;
+
+    if (ioctl_cache)
+        return;
+
+    ic = (ioctl_cache_t *) calloc(1, sizeof(ioctl_cache_t));
+    if (ic == NULL)
+        return;
+
+    ic->wake        = thread_create_event();
+    ic->plat_mutex  = thread_create_mutex();
+    ic->cache_mutex = thread_create_mutex();
+    ic->run         = 1;
+    ic->thread      = thread_create(ioctl_cache_thread, ic);
+    ioctl_cache     = ic;
+}
+
+static void
+ioctl_cache_close(void)
+{
+    ioctl_cache_t *ic = ioctl_cache;
+
+    if (ic == NULL)
+        return;
+
+    ic->run = 0;
+    thread_set_event(ic->wake);
+    thread_wait(ic->thread);
+    ioctl_cache = NULL;
+
+    thread_destroy_event(ic->wake);
+    thread_close_mutex(ic->plat_mutex);
+    thread_close_mutex(ic->cache_mutex);
+    free(ic);
+}
+
+/* Cooked data sectors, from the cache or the drive; either way the
+   read-ahead is pushed on past this one. */
+static int
+ioctl_read_data(uint8_t *b, uint32_t lba)
+{
+    ioctl_cache_t *ic = ioctl_cache;
+    uint32_t       gen;
+    int            ret = 1;
+
+    if (ic == NULL)
+        return plat_cdrom_read_sector(b, 0, lba);
+
+    if (!ioctl_cache_lookup(ic, b, lba)) {
+        thread_wait_mutex(ic->plat_mutex);
+        /* The read-ahead may have got there while we waited. */
+        if (!ioctl_cache_lookup(ic, b, lba)) {
+            thread_wait_mutex(ic->cache_mutex);
+            gen = ic->gen;
+            thread_release_mutex(ic->cache_mutex);
+
+            ret = plat_cdrom_read_sector(b, 0, lba);
+            if (ret)
+                ioctl_cache_store(ic, b, lba, 1, gen);
+        }
+        thread_release_mutex(ic->plat_mutex);
+    }
+
+    if (ret) {
+        thread_wait_mutex(ic->cache_mutex);
+        ic->sub_valid = 0;
+        if ((lba < ic->ahead_from) || (lba > ic->ahead_to))
+            ic->ahead_from = lba + 1;
+        ic->ahead_to = lba + 1 + IOCTL_READ_AHEAD;
+        thread_release_mutex(ic->cache_mutex);
+
+        thread_set_event(ic->wake);
+    }
+
+    return ret;
+}
+
 static void
 ioctl_get_tracks(UNUSED(cdrom_t *dev), int *first, int *last)
 {
     TMSF        tmsf;
 
+    ioctl_plat_lock();
     plat_cdrom_get_audio_tracks(first, last, &tmsf);
+    ioctl_plat_unlock();
 }
 
 static void
@@ -68,7 +307,9 @@ ioctl_get_track_info(UNUSED(cdrom_t *dev), uint32_t track, int end, track_info_t
 {
     TMSF      tmsf;
 
+    ioctl_plat_lock();
     plat_cdrom_get_audio_track_info(end, track, &ti->number, &tmsf, &ti->attr);
+    ioctl_plat_unlock();
 
     ti->m = tmsf.min;
     ti->s = tmsf.sec;
@@ -82,7 +323,11 @@ ioctl_get_subchannel(UNUSED(cdrom_t *dev), uint32_t lba, subchannel_t *subc)
     TMSF      abs_pos;
 
     if ((dev->cd_status == CD_STATUS_PLAYING) || (dev->cd_status == CD_STATUS_PAUSED)) {
-        const uint32_t trk = plat_cdrom_get_track_start(lba, &subc->attr, &subc->track);
+        uint32_t trk;
+
+        ioctl_plat_lock();
+        trk = plat_cdrom_get_track_start(lba, &subc->attr, &subc->track);
+        ioctl_plat_unlock();
 
         FRAMES_TO_MSF(lba + 150, &abs_pos.min, &abs_pos.sec, &abs_pos.fr);
 
@@ -90,9 +335,23 @@ ioctl_get_subchannel(UNUSED(cdrom_t *dev), uint32_t lba, subchannel_t *subc)
         FRAMES_TO_MSF(lba - trk, &rel_pos.min, &rel_pos.sec, &rel_pos.fr);
 
         subc->index  = 1;
-    } else
+    } else {
+        /* Where the drive head is only changes when it is sent somewhere. */
+        if (ioctl_cache) {
+            thread_wait_mutex(ioctl_cache->cache_mutex);
+            if (ioctl_cache->sub_valid && (ioctl_cache->sub_lba == lba)) {
+                *subc = ioctl_cache->sub;
+                thread_release_mutex(ioctl_cache->cache_mutex);
+                return;
+            }
+            thread_release_mutex(ioctl_cache->cache_mutex);
+        }
+
+        ioctl_plat_lock();
         plat_cdrom_get_audio_sub(lba, &subc->attr, &subc->track, &subc->index,
                                  &rel_pos, &abs_pos);
+        ioctl_plat_unlock();
+    }
 
     subc->abs_m = abs_pos.min;
     subc->abs_s = abs_pos.sec;
@@ -102,6 +361,14 @@ ioctl_get_subchannel(UNUSED(cdrom_t *dev), uint32_t lba, subchannel_t *subc)
     subc->rel_s = rel_pos.sec;
     subc->rel_f = rel_pos.fr;
 
+    if (ioctl_cache && (dev->cd_status != CD_STATUS_PLAYING) && (dev->cd_status != CD_STATUS_PAUSED)) {
+        thread_wait_mutex(ioctl_cache->cache_mutex);
+        ioctl_cache->sub       = *subc;
+        ioctl_cache->sub_lba   = lba;
+        ioctl_cache->sub_valid = 1;
+        thread_release_mutex(ioctl_cache->cache_mutex);
+    }
+
     cdrom_ioctl_log("ioctl_get_subchannel(): %02X, %02X, %02i, %02i:%02i:%02i, %02i:%02i:%02i\n",
                     subc->attr, subc->track, subc->index, subc->abs_m, subc->abs_s, subc->abs_f, subc->rel_m, subc->rel_s, subc->rel_f);
 }
@@ -111,7 +378,9 @@ ioctl_get_capacity(UNUSED(cdrom_t *dev))
 {
     int ret;
 
+    ioctl_plat_lock();
     ret = plat_cdrom_get_last_block();
+    ioctl_plat_unlock();
     cdrom_ioctl_log("GetCapacity=%x.\n", ret);
     return ret;
 }
@@ -122,6 +391,7 @@ ioctl_is_track_audio(cdrom_t *dev, uint32_t pos, int ismsf)
     int       m;
     int       s;
     int       f;
+    int       ret;
 
     if (dev->cd_status == CD_STATUS_DATA_ONLY)
         return 0;
@@ -134,35 +404,67 @@ ioctl_is_track_audio(cdrom_t *dev, uint32_t pos, int ismsf)
     }
 
     /* GetTrack requires LBA. */
-    return plat_cdrom_is_track_audio(pos);
+    ioctl_plat_lock();
+    ret = plat_cdrom_is_track_audio(pos);
+    ioctl_plat_unlock();
+
+    return ret;
 }
 
 static int
 ioctl_is_track_pre(UNUSED(cdrom_t *dev), uint32_t lba)
 {
-    return plat_cdrom_is_track_pre(lba);
+    int ret;
+
+    ioctl_plat_lock();
+    ret = plat_cdrom_is_track_pre(lba);
+    ioctl_plat_unlock();
+
+    return ret;
 }
 
 static int
 ioctl_sector_size(UNUSED(cdrom_t *dev), uint32_t lba)
 {
+    int ret;
+
     cdrom_ioctl_log("LBA=%x.\n", lba);
-    return plat_cdrom_get_sector_size(lba);
+
+    /* The drive geometry does not change with the sector, ask once per medium. */
+    if (ioctl_cache && ioctl_cache->sector_size)
+        return ioctl_cache->sector_size;
+
+    ioctl_plat_lock();
+    ret = plat_cdrom_get_sector_size(lba);
+    ioctl_plat_unlock();
+
+    if (ioctl_cache)
+        ioctl_cache->sector_size = ret;
+
+    return ret;
 }
 
 static int
 ioctl_read_sector(UNUSED(cdrom_t *dev), int type, uint8_t *b, uint32_t lba)
 {
+    int ret;
+
     switch (type) {
         case CD_READ_DATA:
             cdrom_ioctl_log("cdrom_ioctl_read_sector(): Data.\n");
-            return plat_cdrom_read_sector(b, 0, lba);
+            return ioctl_read_data(b, lba);
         case CD_READ_AUDIO:
             cdrom_ioctl_log("cdrom_ioctl_read_sector(): Audio.\n");
-            return plat_cdrom_read_sector(b, 1, lba);
+            ioctl_plat_lock();
+            ret = plat_cdrom_read_sector(b, 1, lba);
+            ioctl_plat_unlock();
+            return ret;
         case CD_READ_RAW:
             cdrom_ioctl_log("cdrom_ioctl_read_sector(): Raw.\n");
-            return plat_cdrom_read_sector(b, 1, lba);
+            ioctl_plat_lock();
+            ret = plat_cdrom_read_sector(b, 1, lba);
+            ioctl_plat_unlock();
+            return ret;
         default:
             cdrom_ioctl_log("cdrom_ioctl_read_sector(): Unknown CD read type.\n");
             break;
@@ -190,8 +492,14 @@ ioctl_ext_medium_changed(cdrom_t *dev)
 
     if ((dev->cd_status == CD_STATUS_PLAYING) || (dev->cd_status == CD_STATUS_PAUSED))
         ret = 0;
-    else
+    else {
+        ioctl_plat_lock();
         ret = plat_cdrom_ext_medium_changed();
+        ioctl_plat_unlock();
+    }
+
+    if (ret != 0)
+        ioctl_cache_drop(ioctl_cache);
 
     if (ret == 1) {
         dev->cd_status      = CD_STATUS_STOPPED;
@@ -206,11 +514,15 @@ static void
 ioctl_exit(cdrom_t *dev)
 {
     cdrom_ioctl_log("CDROM: ioctl_exit(%s)\n", dev->image_path);
+    cdrom_media_lock(dev);
     dev->cd_status = CD_STATUS_EMPTY;
 
+    ioctl_cache_close();
     plat_cdrom_close();
 
     dev->ops = NULL;
+
+    cdrom_media_unlock(dev);
 }
 
 static const cdrom_ops_t cdrom_ioctl_ops = {
@@ -222,7 +534,8 @@ static const cdrom_ops_t cdrom_ioctl_ops = {
     ioctl_read_sector,
     ioctl_track_type,
     ioctl_ext_medium_changed,
-    ioctl_exit
+    ioctl_exit,
+    NULL
 };
 
 static int
@@ -248,10 +561,15 @@ cdrom_ioctl_open(cdrom_t *dev, const char *drv)
     if (strstr(drv, "ioctl://") != drv)
         return cdrom_ioctl_open_abort(dev);
     cdrom_ioctl_log("actual_drv = %s\n", actual_drv);
+    ioctl_plat_lock();
     int i = plat_cdrom_set_drive(actual_drv);
+    ioctl_plat_unlock();
     if (!i)
         return cdrom_ioctl_open_abort(dev);
 
+    ioctl_cache_init();
+    ioctl_cache_drop(ioctl_cache);
+
     /* All good, reset state. */
     dev->cd_status      = CD_STATUS_STOPPED;
     dev->is_dir         = 0;
@@ -129,7 +129,7 @@ ali1531_shadow_recalc(UNUSED(int cur_reg), ali1531_t *dev)
         mem_set_mem_state_both(base, 0x00004000, flags);
     }
 
-    flushmmucache_nopc();
+    flushmmucache_range(0x000c0000, 0x00040000);
 }
 
 static void
@@ -208,7 +208,7 @@ ali1621_shadow_recalc(UNUSED(int cur_reg), ali1621_t *dev)
                 (dev->pci_conf[reg] & (1 << r_bit)) ? 'I' : 'E', (dev->pci_conf[reg] & (1 << w_bit)) ? 'I' : 'E');
     mem_set_mem_state_both(base, 0x00010000, flags);
 
-    flushmmucache_nopc();
+    flushmmucache_range(0x000c0000, 0x00040000);
 }
 
 static void
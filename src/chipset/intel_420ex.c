@@ -109,7 +109,7 @@ i420ex_map(uint32_t addr, uint32_t size, int state)
         default:
             break;
     }
-    flushmmucache_nopc();
+    flushmmucache_range(addr, size);
 }
 
 static void
@@ -82,7 +82,7 @@ i450kx_map(i450kx_t *dev, int bus, uint32_t addr, uint32_t size, int state)
         else
             mem_set_mem_state_cpu_both(addr, size, states[state]);
         dev->mem_state[bus][base] = state;
-        flushmmucache_nopc();
+        flushmmucache_range(addr, size);
     }
 }
 
@@ -122,7 +122,7 @@ i450kx_vid_buf_recalc(i450kx_t *dev, int bus)
     else
         mem_set_mem_state_cpu_both(0x000a0000, 0x00020000, state);
 
-    flushmmucache_nopc();
+    flushmmucache_range(0x000a0000, 0x00020000);
 }
 
 static void
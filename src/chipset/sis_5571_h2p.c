@@ -111,7 +111,7 @@ sis_5571_shadow_recalc(sis_5571_host_to_pci_t *dev)
         dev->states[i & 0x0f] = dev->pci_conf[i];
     }
 
-    flushmmucache_nopc();
+    flushmmucache_range(0x000c0000, 0x00040000);
 }
 
 static void
@@ -135,7 +135,7 @@ sis_5600_shadow_recalc(sis_5600_host_to_pci_t *dev)
     for (uint8_t i = 0; i < 4; i++)
         dev->states[i] = dev->pci_conf[0x70 + i];
 
-    flushmmucache_nopc();
+    flushmmucache_range(0x000c0000, 0x00040000);
 }
 
 static void
@@ -155,7 +155,7 @@ sis_85c496_recalcmapping(sis_85c496_t *dev)
             mem_set_mem_state_both(base, 0x8000, MEM_READ_EXTANY | MEM_WRITE_EXTANY);
     }
 
-    flushmmucache_nopc();
+    flushmmucache_range(0x000c0000, 0x00040000);
 }
 
 static void
@@ -141,7 +141,7 @@ sis_85c50x_shadow_recalc(sis_85c50x_t *dev)
         }
     }
 
-    flushmmucache_nopc();
+    flushmmucache_range(0x000c0000, 0x00040000);
 }
 
 static void
@@ -77,7 +77,7 @@ apollo_map(uint32_t addr, uint32_t size, int state)
             break;
     }
 
-    flushmmucache_nopc();
+    flushmmucache_range(addr, size);
 }
 
 static void
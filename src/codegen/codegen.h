@@ -109,6 +109,10 @@ typedef struct codeblock_t {
     uint32_t status;
     uint32_t flags;
 
+    /*Block that was run right after this one last time, tried before the
+      hash when dispatching*/
+    struct codeblock_t *chain;
+
     uint8_t data[2048];
 } codeblock_t;
 
@@ -271,6 +275,8 @@ codeblock_tree_delete(codeblock_t *block)
 extern codeblock_t *codeblock;
 
 extern codeblock_t **codeblock_hash;
+extern int           codeblock_hash_bits;
+extern uint32_t      codeblock_hash_mask;
 
 extern void codegen_init(void);
 extern void codegen_reset(void);
@@ -49,6 +49,8 @@ int           host_reg_mapping[NR_HOST_REGS];
 int           host_reg_xmm_mapping[NR_HOST_XMM_REGS];
 codeblock_t  *codeblock;
 codeblock_t **codeblock_hash;
+int           codeblock_hash_bits;
+uint32_t      codeblock_hash_mask;
 int           codegen_mmx_entered = 0;
 
 int        block_current = 0;
@@ -75,10 +77,16 @@ codegen_init(void)
 #    else
     codeblock = malloc(BLOCK_SIZE * sizeof(codeblock_t));
 #    endif
-    codeblock_hash = malloc(HASH_SIZE * sizeof(codeblock_t *));
+    codeblock_hash_bits = cpu_dynarec_hash_bits ? cpu_dynarec_hash_bits : HASH_BITS_DEFAULT;
+    if (codeblock_hash_bits < HASH_BITS_MIN)
+        codeblock_hash_bits = HASH_BITS_MIN;
+    else if (codeblock_hash_bits > HASH_BITS_MAX)
+        codeblock_hash_bits = HASH_BITS_MAX;
+    codeblock_hash_mask = (1 << codeblock_hash_bits) - 1;
+    codeblock_hash      = malloc((codeblock_hash_mask + 1) * sizeof(codeblock_t *));
 
     memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
-    memset(codeblock_hash, 0, HASH_SIZE * sizeof(codeblock_t *));
+    memset(codeblock_hash, 0, (codeblock_hash_mask + 1) * sizeof(codeblock_t *));
 
     for (int c = 0; c < BLOCK_SIZE; c++)
         codeblock[c].valid = 0;
@@ -88,7 +96,7 @@ void
 codegen_reset(void)
 {
     memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
-    memset(codeblock_hash, 0, HASH_SIZE * sizeof(codeblock_t *));
+    memset(codeblock_hash, 0, (codeblock_hash_mask + 1) * sizeof(codeblock_t *));
     mem_reset_page_blocks();
 
     for (int c = 0; c < BLOCK_SIZE; c++)
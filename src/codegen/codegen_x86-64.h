@@ -2,10 +2,14 @@
 #define BLOCK_MASK        0x3fff
 #define BLOCK_START       0
 
-#define HASH_SIZE         0x20000
-#define HASH_MASK         0x1ffff
+/*Block hash, sized at init from cpu_dynarec_hash_bits. The upper address bits
+  are folded in so that code 2^bits apart, eg. BIOS and RAM copies, does not
+  keep evicting itself*/
+#define HASH_BITS_DEFAULT 18
+#define HASH_BITS_MIN     17
+#define HASH_BITS_MAX     24
 
-#define HASH(l)           ((l) &0x1ffff)
+#define HASH(l)           ((((l) >> codeblock_hash_bits) ^ (l)) & codeblock_hash_mask)
 
 #define BLOCK_EXIT_OFFSET 0x7e0
 #ifdef OLD_GPF
@@ -89,6 +89,8 @@ int           host_reg_mapping[NR_HOST_REGS];
 int           host_reg_xmm_mapping[NR_HOST_XMM_REGS];
 codeblock_t  *codeblock;
 codeblock_t **codeblock_hash;
+int           codeblock_hash_bits;
+uint32_t      codeblock_hash_mask;
 
 int        block_current = 0;
 static int block_num;
@@ -1201,10 +1203,16 @@ codegen_init(void)
 #    else
     codeblock = malloc((BLOCK_SIZE + 1) * sizeof(codeblock_t));
 #    endif
-    codeblock_hash = malloc(HASH_SIZE * sizeof(codeblock_t *));
+    codeblock_hash_bits = cpu_dynarec_hash_bits ? cpu_dynarec_hash_bits : HASH_BITS_DEFAULT;
+    if (codeblock_hash_bits < HASH_BITS_MIN)
+        codeblock_hash_bits = HASH_BITS_MIN;
+    else if (codeblock_hash_bits > HASH_BITS_MAX)
+        codeblock_hash_bits = HASH_BITS_MAX;
+    codeblock_hash_mask = (1 << codeblock_hash_bits) - 1;
+    codeblock_hash      = malloc((codeblock_hash_mask + 1) * sizeof(codeblock_t *));
 
     memset(codeblock, 0, (BLOCK_SIZE + 1) * sizeof(codeblock_t));
-    memset(codeblock_hash, 0, HASH_SIZE * sizeof(codeblock_t *));
+    memset(codeblock_hash, 0, (codeblock_hash_mask + 1) * sizeof(codeblock_t *));
 
     block_current = BLOCK_SIZE;
     block_pos     = 0;
@@ -1268,7 +1276,7 @@ void
 codegen_reset(void)
 {
     memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
-    memset(codeblock_hash, 0, HASH_SIZE * sizeof(codeblock_t *));
+    memset(codeblock_hash, 0, (codeblock_hash_mask + 1) * sizeof(codeblock_t *));
     mem_reset_page_blocks();
 }
 
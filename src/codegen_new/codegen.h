@@ -43,10 +43,22 @@ typedef struct codeblock_t {
       fails.*/
     uint16_t parent, left, right;
 
+    /*Saturating execution count, used by the clock sweep in
+      codegen_delete_lru_block() to pick an eviction victim.*/
+    uint16_t refs;
+    /*Number of times the block has run since it was last compiled, used to
+      promote hot blocks to the optimising tier.*/
+    uint16_t hits;
+
     uint8_t *data;
 
     uint64_t  page_mask, page_mask2;
     uint64_t *dirty_mask, *dirty_mask2;
+    /*Code present in the first page at 16 byte granularity. Only valid for
+      recompiled blocks without CODEBLOCK_BYTE_MASK, where it lets
+      codegen_check_flush() ignore writes to data that shares a 64 byte line
+      with the code.*/
+    uint64_t sub_mask[4];
 
     /*Previous and next pointers, for the codeblock list associated with
       each physical page. Two sets of pointers, as a codeblock can be
@@ -81,6 +93,21 @@ extern uint8_t *block_write_data;
 #define CODEBLOCK_IN_DIRTY_LIST 0x40
 /*Code block is not inlining immediate parameters, parameters must be fetched from memory*/
 #define CODEBLOCK_NO_IMMEDIATES 0x80
+/*Code block has run CODEGEN_HOT_THRESHOLD times and is (re)compiled with loop unrolling*/
+#define CODEBLOCK_HOT 0x100
+/*Code block contains a backwards branch within itself that could be unrolled*/
+#define CODEBLOCK_HAS_LOOP 0x200
+
+/*Upper limit for codeblock_t.refs. Each clock pass decrements refs, so a block
+  executed this many times survives that many sweeps without being used*/
+#define CODEBLOCK_REFS_MAX 8
+
+/*Blocks are compiled in tiers. A new block is first interpreted to find its
+  extent, then compiled without loop unrolling. Once a compiled block containing
+  a loop has run this many times it is marked CODEBLOCK_HOT and recompiled on its
+  next entry, this time with loop unrolling enabled. Blocks recovered from the dirty list
+  (self-modifying code) drop back to the baseline tier*/
+#define CODEGEN_HOT_THRESHOLD 256
 
 #define BLOCK_PC_INVALID        0xffffffff
 
@@ -268,6 +295,8 @@ codeblock_tree_delete(codeblock_t *block)
 #define PAGE_MASK_MASK  63
 #define PAGE_MASK_SHIFT 6
 
+#define PAGE_SUB_MASK_SHIFT 4
+
 void codegen_mark_code_present_multibyte(codeblock_t *block, uint32_t start_pc, int len);
 
 static inline void
@@ -281,8 +310,10 @@ codegen_mark_code_present(codeblock_t *block, uint32_t start_pc, int len)
                 block->page_mask2 |= ((uint64_t) 1 << (start_pc & PAGE_MASK_MASK));
         } else {
             if (!((start_pc ^ block->pc) & ~0xfff)) /*Starts in second page*/
+            {
                 block->page_mask |= ((uint64_t) 1 << ((start_pc >> PAGE_MASK_SHIFT) & PAGE_MASK_MASK));
-            else
+                block->sub_mask[(start_pc >> 10) & 3] |= ((uint64_t) 1 << ((start_pc >> PAGE_SUB_MASK_SHIFT) & 63));
+            } else
                 block->page_mask2 |= ((uint64_t) 1 << ((start_pc >> PAGE_MASK_SHIFT) & PAGE_MASK_MASK));
         }
     } else
@@ -308,9 +339,11 @@ extern void codegen_check_seg_read(codeblock_t *block, struct ir_data_t *ir, x86
 extern void codegen_check_seg_write(codeblock_t *block, struct ir_data_t *ir, x86seg *seg);
 
 extern int codegen_purge_purgable_list(void);
-/*Delete a random code block to free memory. This is obviously quite expensive, and
-  will only be called when the allocator is out of memory*/
-extern void codegen_delete_random_block(int required_mem_block);
+/*Delete the least recently used code block to free memory. Blocks are swept in
+  clock order; each pass ages a block's execution count, and a block is only
+  evicted once its count has reached zero. This is only called when the
+  allocator or the code block pool is out of space*/
+extern void codegen_delete_lru_block(int required_mem_block);
 
 extern int      cpu_block_end;
 extern uint32_t codegen_endpc;
@@ -7,9 +7,12 @@
 #    include <windows.h>
 #endif
 
+#include <inttypes.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#define HAVE_STDARG_H
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/mem.h>
@@ -24,34 +27,108 @@ typedef struct mem_block_t {
     uint16_t code_block;
 } mem_block_t;
 
-static mem_block_t mem_blocks[MEM_BLOCK_NR];
-static uint32_t    mem_block_free_list;
-static uint8_t    *mem_block_alloc = NULL;
+/*Number of mem_block_ts committed at a time as the cache grows*/
+#define MEM_BLOCK_GROW_NR 1024
 
-int codegen_allocator_usage = 0;
+static mem_block_t *mem_blocks = NULL;
+static uint32_t     mem_block_free_list;
+/*Number of mem_block_ts handed out so far. Blocks above this have never been
+  used, and on Windows their backing memory may not be committed yet*/
+static uint32_t     mem_block_top;
+static uint8_t     *mem_block_alloc = NULL;
+
+int      codegen_allocator_usage     = 0;
+int      codegen_allocator_size      = 0;
+uint64_t codegen_allocator_evictions = 0;
+
+#ifdef ENABLE_CODEGEN_ALLOCATOR_LOG
+int codegen_allocator_do_log = ENABLE_CODEGEN_ALLOCATOR_LOG;
+
+static void
+codegen_allocator_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (codegen_allocator_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define codegen_allocator_log(fmt, ...)
+#endif
 
 void
 codegen_allocator_init(void)
 {
+    size_t size;
+
+    codegen_allocator_size = MEM_BLOCK_NR_DEFAULT;
+    if (cpu_dynarec_cache_size > 0)
+        codegen_allocator_size = (int) (((uint64_t) cpu_dynarec_cache_size << 20) / MEM_BLOCK_SIZE);
+    if (codegen_allocator_size > MEM_BLOCK_NR)
+        codegen_allocator_size = MEM_BLOCK_NR;
+    if (codegen_allocator_size < MEM_BLOCK_GROW_NR)
+        codegen_allocator_size = MEM_BLOCK_GROW_NR;
+    size = (size_t) codegen_allocator_size * MEM_BLOCK_SIZE;
+
 #if defined WIN32 || defined _WIN32 || defined _WIN32
-    mem_block_alloc = VirtualAlloc(NULL, MEM_BLOCK_NR * MEM_BLOCK_SIZE, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+    /*Only reserve the address space here, memory is committed as the cache grows*/
+    mem_block_alloc = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_EXECUTE_READWRITE);
     /* TODO: check deployment target: older Intel-based versions of macOS don't play
        nice with MAP_JIT. */
 #elif defined(__APPLE__) && defined(MAP_JIT)
-    mem_block_alloc = mmap(0, MEM_BLOCK_NR * MEM_BLOCK_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE | MAP_JIT, -1, 0);
+    mem_block_alloc = mmap(0, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE | MAP_JIT, -1, 0);
 #else
-    mem_block_alloc = mmap(0, MEM_BLOCK_NR * MEM_BLOCK_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE, -1, 0);
+    mem_block_alloc = mmap(0, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE, -1, 0);
 #endif
+#if defined WIN32 || defined _WIN32 || defined _WIN32
+    if (mem_block_alloc == NULL)
+#else
+    if (mem_block_alloc == MAP_FAILED)
+#endif
+        fatal("codegen_allocator_init: unable to allocate %i kB of code cache\n", (int) (size >> 10));
 
-    for (uint32_t c = 0; c < MEM_BLOCK_NR; c++) {
-        mem_blocks[c].offset     = c * MEM_BLOCK_SIZE;
-        mem_blocks[c].code_block = BLOCK_INVALID;
-        if (c < MEM_BLOCK_NR - 1)
-            mem_blocks[c].next = c + 2;
-        else
-            mem_blocks[c].next = 0;
+    mem_blocks = calloc(codegen_allocator_size, sizeof(mem_block_t));
+    if (mem_blocks == NULL)
+        fatal("codegen_allocator_init: out of memory\n");
+
+    mem_block_free_list = 0;
+    mem_block_top       = 0;
+
+    codegen_allocator_log("codegen_allocator_init: %i blocks (%i kB)\n",
+                          codegen_allocator_size, (int) (size >> 10));
+}
+
+/*Hand out a mem_block_t that has never been used before. Returns 0 once the
+  cache has reached its full size*/
+static uint32_t
+codegen_allocator_grow(void)
+{
+    mem_block_t *block;
+
+    if (mem_block_top >= (uint32_t) codegen_allocator_size)
+        return 0;
+
+#if defined WIN32 || defined _WIN32 || defined _WIN32
+    if (!(mem_block_top % MEM_BLOCK_GROW_NR)) {
+        uint32_t nr = codegen_allocator_size - mem_block_top;
+
+        if (nr > MEM_BLOCK_GROW_NR)
+            nr = MEM_BLOCK_GROW_NR;
+        if (VirtualAlloc(&mem_block_alloc[mem_block_top * MEM_BLOCK_SIZE], nr * MEM_BLOCK_SIZE,
+                         MEM_COMMIT, PAGE_EXECUTE_READWRITE) == NULL)
+            fatal("codegen_allocator_grow: unable to commit code cache memory\n");
     }
-    mem_block_free_list = 1;
+#endif
+
+    block             = &mem_blocks[mem_block_top];
+    block->offset     = mem_block_top * MEM_BLOCK_SIZE;
+    block->code_block = BLOCK_INVALID;
+    block->next       = 0;
+
+    return ++mem_block_top;
 }
 
 mem_block_t *
@@ -60,20 +137,20 @@ codegen_allocator_allocate(mem_block_t *parent, int code_block)
     mem_block_t *block;
     uint32_t     block_nr;
 
-    while (!mem_block_free_list) {
-        /*Pick a random memory block and free the owning code block*/
-        block_nr = rand() & MEM_BLOCK_MASK;
-        block    = &mem_blocks[block_nr];
-
-        if (block->code_block && block->code_block != code_block)
-            codegen_delete_block(&codeblock[block->code_block]);
+    if (!mem_block_free_list && (block_nr = codegen_allocator_grow()))
+        block = &mem_blocks[block_nr - 1];
+    else {
+        while (!mem_block_free_list) {
+            /*Cache is full, free the least recently used code block*/
+            codegen_delete_lru_block(1);
+        }
+
+        /*Remove from free list*/
+        block_nr            = mem_block_free_list;
+        block               = &mem_blocks[block_nr - 1];
+        mem_block_free_list = block->next;
     }
 
-    /*Remove from free list*/
-    block_nr            = mem_block_free_list;
-    block               = &mem_blocks[block_nr - 1];
-    mem_block_free_list = block->next;
-
     block->code_block = code_block;
     if (parent) {
         /*Add to parent list*/
@@ -106,12 +183,34 @@ codegen_allocator_free(mem_block_t *block)
     }
 }
 
+void
+codegen_allocator_log_stats(void)
+{
+    codegen_allocator_log("codegen_allocator: %i/%i blocks in use (%i%%), %i ever used, %" PRIu64 " evictions\n",
+                          codegen_allocator_usage, codegen_allocator_size,
+                          (int) (((int64_t) codegen_allocator_usage * 100) / codegen_allocator_size),
+                          (int) mem_block_top, codegen_allocator_evictions);
+}
+
 uint8_t *
 codeblock_allocator_get_ptr(mem_block_t *block)
 {
     return &mem_block_alloc[block->offset];
 }
 
+int
+codegen_allocator_get_size(mem_block_t *block)
+{
+    int size = 0;
+
+    while (block) {
+        size += MEM_BLOCK_SIZE;
+        block = block->next ? &mem_blocks[block->next - 1] : NULL;
+    }
+
+    return size;
+}
+
 void
 codegen_allocator_clean_blocks(UNUSED(struct mem_block_t *block))
 {
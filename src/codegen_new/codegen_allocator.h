@@ -12,14 +12,22 @@
 
   Due to the chaining, the total memory size is limited by the range of a jump
   instruction. ARMv7 is restricted to +/- 32 MB, ARMv8 to +/- 128 MB, x86 to
-  +/- 2GB. As a result, total memory size is limited to 32 MB on ARMv7*/
+  +/- 2GB. As a result, total memory size is limited to 32 MB on ARMv7.
+
+  The actual size is taken from cpu_dynarec_cache_size (in MB, 0 selects the
+  default) and clamped to MEM_BLOCK_NR. Backing memory is only committed as the
+  cache grows, so a large limit costs little until it is actually used.*/
 #if defined __ARM_EABI__ || defined _ARM_ || defined _M_ARM
-#    define MEM_BLOCK_NR 32768
+#    define MEM_BLOCK_NR         32768
+#    define MEM_BLOCK_NR_DEFAULT 32768
+#elif defined __amd64__ || defined _M_X64
+#    define MEM_BLOCK_NR         524288
+#    define MEM_BLOCK_NR_DEFAULT 131072
 #else
-#    define MEM_BLOCK_NR 131072
+#    define MEM_BLOCK_NR         131072
+#    define MEM_BLOCK_NR_DEFAULT 131072
 #endif
 
-#define MEM_BLOCK_MASK (MEM_BLOCK_NR - 1)
 #define MEM_BLOCK_SIZE 0x3c0
 
 void codegen_allocator_init(void);
@@ -31,9 +39,18 @@ struct mem_block_t *codegen_allocator_allocate(struct mem_block_t *parent, int c
 void codegen_allocator_free(struct mem_block_t *block);
 /*Get a pointer to the backing memory associated with block*/
 uint8_t *codeblock_allocator_get_ptr(struct mem_block_t *block);
+/*Get the total size of backing memory in the list starting at block*/
+int codegen_allocator_get_size(struct mem_block_t *block);
 /*Cache clean memory block list*/
 void codegen_allocator_clean_blocks(struct mem_block_t *block);
 
+/*Log cache occupancy and eviction statistics*/
+void codegen_allocator_log_stats(void);
+
 extern int codegen_allocator_usage;
+/*Number of mem_block_ts available to the allocator*/
+extern int codegen_allocator_size;
+/*Number of code blocks evicted to make room for new code*/
+extern uint64_t codegen_allocator_evictions;
 
 #endif
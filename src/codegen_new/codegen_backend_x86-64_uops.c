@@ -1785,9 +1785,9 @@ codegen_PF2ID(codeblock_t *block, uop_t *uop)
     int src_size_a = IREG_GET_SIZE(uop->src_reg_a_real);
 
     if (REG_IS_Q(dest_size) && REG_IS_Q(src_size_a)) {
-        host_x86_LDMXCSR(block, &cpu_state.trunc_fp_control);
-        host_x86_CVTPS2DQ_XREG_XREG(block, dest_reg, src_reg_a);
-        host_x86_LDMXCSR(block, &cpu_state.old_fp_control);
+        /*CVTTPS2DQ always truncates, so there is no need to switch MXCSR
+          rounding mode around the conversion*/
+        host_x86_CVTTPS2DQ_XREG_XREG(block, dest_reg, src_reg_a);
     }
 #    ifdef RECOMPILER_DEBUG
     else
@@ -1924,9 +1924,9 @@ codegen_PFRCP(codeblock_t *block, uop_t *uop)
 
     if (REG_IS_Q(dest_size) && REG_IS_Q(src_size_a)) {
         /*TODO: This could be improved (use RCPSS + iteration)*/
-        host_x86_MOV32_REG_IMM(block, REG_ECX, 1);
+        host_x86_MOV32_REG_IMM(block, REG_ECX, 0x3f800000); /*1.0f*/
         host_x86_MOVQ_XREG_XREG(block, REG_XMM_TEMP, src_reg_a);
-        host_x86_CVTSI2SS_XREG_REG(block, dest_reg, REG_ECX);
+        host_x86_MOVD_XREG_REG(block, dest_reg, REG_ECX);
         host_x86_DIVSS_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
         host_x86_UNPCKLPS_XREG_XREG(block, dest_reg, dest_reg);
     }
@@ -1947,8 +1947,8 @@ codegen_PFRSQRT(codeblock_t *block, uop_t *uop)
     if (REG_IS_Q(dest_size) && REG_IS_Q(src_size_a)) {
         /*TODO: This could be improved (use RSQRTSS + iteration)*/
         host_x86_SQRTSS_XREG_XREG(block, REG_XMM_TEMP, src_reg_a);
-        host_x86_MOV32_REG_IMM(block, REG_ECX, 1);
-        host_x86_CVTSI2SS_XREG_REG(block, dest_reg, REG_ECX);
+        host_x86_MOV32_REG_IMM(block, REG_ECX, 0x3f800000); /*1.0f*/
+        host_x86_MOVD_XREG_REG(block, dest_reg, REG_ECX);
         host_x86_DIVSS_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
         host_x86_UNPCKLPS_XREG_XREG(block, dest_reg, dest_reg);
     }
@@ -22,6 +22,7 @@
 #include "codegen_allocator.h"
 #include "codegen_backend.h"
 #include "codegen_ir.h"
+#include "codegen_profile.h"
 #include "codegen_reg.h"
 
 uint8_t *block_write_data = NULL;
@@ -204,7 +205,7 @@ block_free_list_get(void)
         }
         /*Free list is empty - free up a block*/
         if (!codegen_purge_purgable_list())
-            codegen_delete_random_block(0);
+            codegen_delete_lru_block(0);
     }
 
     block           = &codeblock[block_free_list];
@@ -218,6 +219,7 @@ void
 codegen_init(void)
 {
     codegen_allocator_init();
+    codegen_profile_init();
 
     codegen_backend_init();
     block_free_list = 0;
@@ -235,10 +237,13 @@ codegen_reset(void)
 {
     int c;
 
+    codegen_allocator_log_stats();
+
     for (c = 1; c < BLOCK_SIZE; c++) {
         codeblock_t *block = &codeblock[c];
 
         if (block->pc != BLOCK_PC_INVALID) {
+            codegen_profile_invalidate(block, CODEGEN_PROFILE_INV_RESET);
             block->phys   = 0;
             block->phys_2 = 0;
             delete_block(block);
@@ -432,35 +437,80 @@ codegen_delete_block(codeblock_t *block)
 }
 
 void
-codegen_delete_random_block(int required_mem_block)
+codegen_delete_lru_block(int required_mem_block)
 {
-    int block_nr = rand() & BLOCK_MASK;
+    static int clock_hand = 0;
+    int        block_nr   = clock_hand;
 
     while (1) {
+        block_nr = (block_nr + 1) & BLOCK_MASK;
+
         if (block_nr && block_nr != block_current) {
             codeblock_t *block = &codeblock[block_nr];
 
             if (block->pc != BLOCK_PC_INVALID && (!required_mem_block || block->head_mem_block)) {
-                delete_block(block);
-                return;
+                if (block->refs)
+                    block->refs--;
+                else {
+                    codegen_profile_invalidate(block, CODEGEN_PROFILE_INV_EVICT);
+                    delete_block(block);
+                    codegen_allocator_evictions++;
+                    clock_hand = block_nr;
+                    return;
+                }
             }
         }
-        block_nr = (block_nr + 1) & BLOCK_MASK;
     }
 }
 
+/*Returns non-zero if the bytes written to page overlap the code of block at
+  16 byte granularity. page_mask only tells us that a write hit one of the 64
+  byte lines the block occupies, which is frequently just data placed next to
+  the code.*/
+static int
+block_sub_mask_dirty(codeblock_t *block, page_t *page)
+{
+    uint64_t mask = block->page_mask & page->dirty_mask;
+
+    if ((block->flags & (CODEBLOCK_WAS_RECOMPILED | CODEBLOCK_BYTE_MASK)) != CODEBLOCK_WAS_RECOMPILED)
+        return 1;
+    if ((page->dirty_mask == ~0ULL) || (page->mem == page_ff) || !page->byte_dirty_mask)
+        return 1;
+
+    for (int c = 0; c < 64; c++) {
+        if (mask & ((uint64_t) 1 << c)) {
+            uint64_t dirty = page->byte_dirty_mask[c];
+            uint32_t sub   = (block->sub_mask[c >> 4] >> ((c & 15) * 4)) & 0xf;
+
+            for (int d = 0; d < 4; d++) {
+                if ((sub & (1 << d)) && ((dirty >> (d * 16)) & 0xffff))
+                    return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
 void
 codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_addr))
 {
     uint16_t block_nr               = page->block;
     int      remove_from_evict_list = 0;
+    uint64_t keep_mask              = 0;
 
     while (block_nr) {
         codeblock_t *block      = &codeblock[block_nr];
         uint16_t     next_block = block->next;
 
         if (*block->dirty_mask & block->page_mask) {
-            invalidate_block(block);
+            if (block_sub_mask_dirty(block, page)) {
+                codegen_profile_invalidate(block, (*block->dirty_mask == ~0ULL) ? CODEGEN_PROFILE_INV_RANGE : CODEGEN_PROFILE_INV_WRITE);
+                invalidate_block(block);
+            } else {
+                codegen_profile_write_filtered(block);
+                keep_mask |= block->page_mask;
+            }
         }
 #ifndef RELEASE_BUILD
         if (block_nr == next_block)
@@ -476,6 +526,7 @@ codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_ad
         uint16_t     next_block = block->next_2;
 
         if (*block->dirty_mask2 & block->page_mask2) {
+            codegen_profile_invalidate(block, (*block->dirty_mask2 == ~0ULL) ? CODEGEN_PROFILE_INV_RANGE : CODEGEN_PROFILE_INV_WRITE);
             invalidate_block(block);
         }
 #ifndef RELEASE_BUILD
@@ -488,6 +539,8 @@ codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_ad
     if (page->code_present_mask & page->dirty_mask)
         remove_from_evict_list = 1;
     page->code_present_mask &= ~page->dirty_mask;
+    /*Blocks that survived the 16 byte check still need their lines marked*/
+    page->code_present_mask |= keep_mask;
     page->dirty_mask = 0;
 
     for (uint8_t c = 0; c < 64; c++) {
@@ -519,6 +572,8 @@ codegen_block_init(uint32_t phys_addr)
     codeblock_hash[block_num] = block_current;
 
     block->ins         = 0;
+    block->refs        = 0;
+    block->hits        = 0;
     block->pc          = cs + cpu_state.pc;
     block->_cs         = cs;
     block->phys        = phys_addr;
@@ -532,6 +587,7 @@ codegen_block_init(uint32_t phys_addr)
 
     recomp_page = block->phys & ~0xfff;
     codeblock_tree_add(block);
+    codegen_profile_block_init(block);
 }
 
 static ir_data_t *ir_data;
@@ -558,13 +614,20 @@ codegen_block_start_recompile(codeblock_t *block)
         fatal("Recompile to used block!\n");
 #endif
 
+    /*Blocks being promoted to a higher tier, or recompiled for a different FPU
+      top-of-stack, still own the memory from the previous compile*/
+    if (block->head_mem_block)
+        codegen_allocator_free(block->head_mem_block);
+    codegen_profile_compile_start(block);
     block->head_mem_block = codegen_allocator_allocate(NULL, block_current);
     block->data           = codeblock_allocator_get_ptr(block->head_mem_block);
 
     block->status = cpu_cur_status;
+    block->hits   = 0;
 
     block->page_mask = block->page_mask2 = 0;
     block->ins                           = 0;
+    memset(block->sub_mask, 0, sizeof(block->sub_mask));
 
     cpu_block_end = 0;
 
@@ -776,6 +839,7 @@ codegen_block_end_recompile(codeblock_t *block)
 
     codegen_accumulate_flush(ir_data);
     codegen_ir_compile(ir_data, block);
+    codegen_profile_compile_end(block);
 }
 
 void
@@ -784,6 +848,16 @@ codegen_flush(void)
     return;
 }
 
+static void
+mark_sub_mask(codeblock_t *block, uint32_t start_pc, uint32_t end_pc)
+{
+    uint32_t start = (start_pc & 0xfff) >> PAGE_SUB_MASK_SHIFT;
+    uint32_t end   = (end_pc & 0xfff) >> PAGE_SUB_MASK_SHIFT;
+
+    for (; start <= end; start++)
+        block->sub_mask[start >> 6] |= ((uint64_t) 1 << (start & 63));
+}
+
 void
 codegen_mark_code_present_multibyte(codeblock_t *block, uint32_t start_pc, int len)
 {
@@ -825,10 +899,12 @@ codegen_mark_code_present_multibyte(codeblock_t *block, uint32_t start_pc, int l
                     block->page_mask |= ((uint64_t) 1 << start_pc_shifted);
                 for (start_pc_shifted = 0; start_pc_shifted <= end_pc_shifted; start_pc_shifted++)
                     block->page_mask2 |= ((uint64_t) 1 << start_pc_shifted);
+                mark_sub_mask(block, start_pc, 0xfff);
             } else /*First page only*/
             {
                 for (; start_pc_shifted <= end_pc_shifted; start_pc_shifted++)
                     block->page_mask |= ((uint64_t) 1 << start_pc_shifted);
+                mark_sub_mask(block, start_pc, end_pc);
             }
         }
     }
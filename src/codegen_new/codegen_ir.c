@@ -21,6 +21,9 @@ codegen_ir_init(void)
 {
     ir_block.wr_pos = 0;
 
+    ir_block.flags_op_uop       = -1;
+    ir_block.flags_op_elided_nr = 0;
+
     codegen_unroll_count = 0;
 
     return &ir_block;
@@ -34,6 +37,17 @@ codegen_ir_set_unroll(int count, int start, int first_instruction)
     codegen_unroll_first_instruction = first_instruction;
 }
 
+int
+codegen_ir_flags_op_elided_across(ir_data_t *ir, int start)
+{
+    for (int c = 0; c < ir->flags_op_elided_nr; c++) {
+        if (ir->flags_op_elided[c].pos >= start && ir->flags_op_elided[c].ref < start)
+            return 1;
+    }
+
+    return 0;
+}
+
 static void
 duplicate_uop(ir_data_t *ir, uop_t *uop, int offset)
 {
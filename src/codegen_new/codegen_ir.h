@@ -3,4 +3,7 @@
 ir_data_t *codegen_ir_init(void);
 
 void codegen_ir_set_unroll(int count, int start, int first_instruction);
+/*Returns non-zero if a loop starting at uOP start would skip over the uOP that an
+  elided IREG_flags_op store relies on*/
+int  codegen_ir_flags_op_elided_across(ir_data_t *ir, int start);
 void codegen_ir_compile(ir_data_t *ir, codeblock_t *block);
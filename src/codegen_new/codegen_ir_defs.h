@@ -348,10 +348,26 @@ typedef struct uop_t {
 
 #define UOP_NR_MAX 4096
 
+/*Maximum number of IREG_flags_op stores that can be elided in one block*/
+#define FLAGS_OP_ELIDE_MAX 64
+
 typedef struct ir_data_t {
     uop_t               uops[UOP_NR_MAX];
     int                 wr_pos;
     struct codeblock_t *block;
+
+    /*uOP that last set IREG_flags_op to a known constant, or -1 if the value is
+      not known (block start, after a barrier, or at a jump destination)*/
+    int flags_op_uop;
+    /*Elided IREG_flags_op stores. pos is where the store would have been, ref is
+      the earlier uOP that already holds the same value. Loop unrolling must not
+      start between the two, as the unrolled copy would then see a different
+      value*/
+    int flags_op_elided_nr;
+    struct {
+        uint16_t pos;
+        uint16_t ref;
+    } flags_op_elided[FLAGS_OP_ELIDE_MAX];
 } ir_data_t;
 
 static inline uop_t *
@@ -376,6 +392,9 @@ uop_alloc(ir_data_t *ir, uint32_t uop_type)
 
     if (uop_type & (UOP_TYPE_BARRIER | UOP_TYPE_ORDER_BARRIER))
         codegen_reg_mark_as_required();
+    /*External functions may change cpu_state.flags_op*/
+    if (uop_type & UOP_TYPE_BARRIER)
+        ir->flags_op_uop = -1;
 
     return uop;
 }
@@ -386,6 +405,8 @@ uop_set_jump_dest(ir_data_t *ir, int jump_uop)
     uop_t *uop = &ir->uops[jump_uop];
 
     uop->jump_dest_uop = ir->wr_pos;
+    /*Control flow merges here, IREG_flags_op may differ between paths*/
+    ir->flags_op_uop = -1;
 }
 
 static inline int
@@ -430,14 +451,45 @@ uop_gen_reg_src1_imm(uint32_t uop_type, ir_data_t *ir, int src_reg, uint32_t imm
     return ir->wr_pos - 1;
 }
 
+/*Most instructions set IREG_flags_op to a constant. If the current version of
+  IREG_flags_op already holds that constant there is no need to write it again.
+  Without this, a store is materialised for every instruction separated by an
+  order barrier (eg any memory access), even when the value is unchanged*/
+static inline int
+uop_flags_op_elide(ir_data_t *ir, uint32_t imm)
+{
+    int            ref = ir->flags_op_uop;
+    reg_version_t *regv;
+
+    if (ref == -1 || ir->uops[ref].imm_data != imm || ir->flags_op_elided_nr >= FLAGS_OP_ELIDE_MAX)
+        return 0;
+    /*Make sure nothing else has written IREG_flags_op since*/
+    regv = &reg_version[IREG_flags_op][reg_last_version[IREG_flags_op]];
+    if (regv->parent_uop != ref)
+        return 0;
+
+    ir->flags_op_elided[ir->flags_op_elided_nr].pos = ir->wr_pos;
+    ir->flags_op_elided[ir->flags_op_elided_nr].ref = ref;
+    ir->flags_op_elided_nr++;
+    return 1;
+}
+
 static inline void
 uop_gen_reg_dst_imm(uint32_t uop_type, ir_data_t *ir, int dest_reg, uint32_t imm)
 {
-    uop_t *uop = uop_alloc(ir, uop_type);
+    uop_t *uop;
+
+    if (uop_type == UOP_MOV_IMM && dest_reg == IREG_flags_op && uop_flags_op_elide(ir, imm))
+        return;
+
+    uop = uop_alloc(ir, uop_type);
 
     uop->type       = uop_type;
     uop->dest_reg_a = codegen_reg_write(dest_reg, ir->wr_pos - 1);
     uop->imm_data   = imm;
+
+    if (dest_reg == IREG_flags_op)
+        ir->flags_op_uop = (uop_type == UOP_MOV_IMM) ? (ir->wr_pos - 1) : -1;
 }
 
 static inline void
@@ -62,6 +62,8 @@ codegen_can_unroll_full(codeblock_t *block, ir_data_t *ir, UNUSED(uint32_t next_
 
     if (TOP != cpu_state.TOP)
         return 0;
+    if (codegen_ir_flags_op_elided_across(ir, start))
+        return 0;
 
     max_unroll = UNROLL_MAX_UOPS / ((ir->wr_pos - start) + 6);
     if ((max_version_refcount != 0) && (max_unroll > (UNROLL_MAX_REG_REFERENCES / max_version_refcount)))
@@ -123,5 +123,12 @@ codegen_can_unroll(codeblock_t *block, ir_data_t *ir, uint32_t next_pc, uint32_t
     if ((cs + dest_addr) < block->pc)
         return 0;
 
+    /*Only unroll blocks that have been promoted to the optimising tier. Baseline
+      blocks just note that they contain a loop, so they are eligible for promotion*/
+    if (!(block->flags & CODEBLOCK_HOT)) {
+        block->flags |= CODEBLOCK_HAS_LOOP;
+        return 0;
+    }
+
     return codegen_can_unroll_full(block, ir, next_pc, dest_addr);
 }
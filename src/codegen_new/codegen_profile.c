@@ -0,0 +1,256 @@
+#if defined WIN32 || defined _WIN32 || defined _WIN32
+#    include <windows.h>
+#else
+#    include <time.h>
+#endif
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+#include <86box/path.h>
+#include <86box/plat.h>
+#include <86box/plat_unused.h>
+
+#include "codegen.h"
+#include "codegen_allocator.h"
+#include "codegen_backend.h"
+#include "codegen_profile.h"
+
+/*Number of distinct guest blocks that can be tracked. Blocks seen after the
+  table is full are not profiled*/
+#define PROFILE_ENTRIES      (1 << 16)
+#define PROFILE_ENTRIES_MASK (PROFILE_ENTRIES - 1)
+/*Number of blocks listed in the report*/
+#define PROFILE_REPORT_MAX 256
+
+typedef struct profile_entry_t {
+    uint32_t pc; /*Linear address*/
+    uint32_t cs_base;
+    uint32_t phys;
+    uint16_t cs_sel;
+    uint8_t  used;
+
+    uint64_t hits;
+    uint32_t compiles;
+    uint64_t compile_ns;
+    uint32_t host_size;
+    uint32_t invalidations[CODEGEN_PROFILE_INV_MAX];
+    /*Writes to the block's 64 byte lines that missed its code*/
+    uint32_t filtered;
+} profile_entry_t;
+
+static profile_entry_t *profile_entries = NULL;
+/*Index+1 of the profile entry for each codeblock_t, 0 if none*/
+static uint32_t *profile_block_entry = NULL;
+static int       profile_entries_used;
+static uint64_t  profile_compile_start;
+static uint64_t  profile_totals[CODEGEN_PROFILE_INV_MAX];
+static uint64_t  profile_filtered;
+
+static const char *profile_inv_names[CODEGEN_PROFILE_INV_MAX] = {
+    [CODEGEN_PROFILE_INV_WRITE] = "write",
+    [CODEGEN_PROFILE_INV_RANGE] = "range",
+    [CODEGEN_PROFILE_INV_EVICT] = "evict",
+    [CODEGEN_PROFILE_INV_RESET] = "reset"
+};
+
+static uint64_t
+profile_time_ns(void)
+{
+#if defined WIN32 || defined _WIN32 || defined _WIN32
+    static LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER        now;
+
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t) ((now.QuadPart * 1000000000.0) / freq.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+#endif
+}
+
+static profile_entry_t *
+profile_get_entry(codeblock_t *block)
+{
+    uint32_t nr = profile_block_entry[get_block_nr(block)];
+
+    return nr ? &profile_entries[nr - 1] : NULL;
+}
+
+void
+codegen_profile_init(void)
+{
+    if (profile_entries == NULL) {
+        profile_entries     = calloc(PROFILE_ENTRIES, sizeof(profile_entry_t));
+        profile_block_entry = calloc(BLOCK_SIZE, sizeof(uint32_t));
+        if ((profile_entries == NULL) || (profile_block_entry == NULL))
+            fatal("codegen_profile_init: out of memory\n");
+    } else {
+        memset(profile_entries, 0, PROFILE_ENTRIES * sizeof(profile_entry_t));
+        memset(profile_block_entry, 0, BLOCK_SIZE * sizeof(uint32_t));
+    }
+
+    profile_entries_used = 0;
+    memset(profile_totals, 0, sizeof(profile_totals));
+    profile_filtered = 0;
+}
+
+void
+codegen_profile_block_init(codeblock_t *block)
+{
+    uint32_t hash = (block->phys ^ (block->pc * 0x9e3779b1) ^ block->_cs) & PROFILE_ENTRIES_MASK;
+    int      nr   = get_block_nr(block);
+
+    profile_block_entry[nr] = 0;
+
+    /*Keep a little room free so that probe sequences stay short*/
+    for (int c = 0; c < 64; c++) {
+        profile_entry_t *entry = &profile_entries[hash];
+
+        if (!entry->used) {
+            if (profile_entries_used >= (PROFILE_ENTRIES - (PROFILE_ENTRIES / 8)))
+                return;
+            entry->used    = 1;
+            entry->pc      = block->pc;
+            entry->cs_base = block->_cs;
+            entry->phys    = block->phys;
+            entry->cs_sel  = cpu_state.seg_cs.seg;
+            profile_entries_used++;
+        }
+        if (entry->pc == block->pc && entry->cs_base == block->_cs && entry->phys == block->phys) {
+            profile_block_entry[nr] = hash + 1;
+            return;
+        }
+
+        hash = (hash + 1) & PROFILE_ENTRIES_MASK;
+    }
+}
+
+void
+codegen_profile_hit(codeblock_t *block)
+{
+    profile_entry_t *entry = profile_get_entry(block);
+
+    if (entry)
+        entry->hits++;
+}
+
+void
+codegen_profile_compile_start(UNUSED(codeblock_t *block))
+{
+    profile_compile_start = profile_time_ns();
+}
+
+void
+codegen_profile_compile_end(codeblock_t *block)
+{
+    profile_entry_t *entry = profile_get_entry(block);
+
+    if (entry) {
+        entry->compiles++;
+        entry->compile_ns += profile_time_ns() - profile_compile_start;
+        entry->host_size = codegen_allocator_get_size(block->head_mem_block);
+    }
+}
+
+void
+codegen_profile_invalidate(codeblock_t *block, int reason)
+{
+    profile_entry_t *entry = profile_get_entry(block);
+
+    profile_totals[reason]++;
+    if (entry)
+        entry->invalidations[reason]++;
+}
+
+void
+codegen_profile_write_filtered(codeblock_t *block)
+{
+    profile_entry_t *entry = profile_get_entry(block);
+
+    profile_filtered++;
+    if (entry)
+        entry->filtered++;
+}
+
+static int
+profile_compare(const void *a, const void *b)
+{
+    const profile_entry_t *entry_a = *(const profile_entry_t **) a;
+    const profile_entry_t *entry_b = *(const profile_entry_t **) b;
+
+    if (entry_a->hits != entry_b->hits)
+        return (entry_a->hits < entry_b->hits) ? 1 : -1;
+    return 0;
+}
+
+void
+codegen_profile_report(void)
+{
+    profile_entry_t **sorted;
+    char              path[1024];
+    FILE             *fp;
+    uint64_t          total_hits     = 0;
+    uint64_t          total_compiles = 0;
+    uint64_t          total_ns       = 0;
+    int               nr             = 0;
+
+    if (profile_entries == NULL)
+        return;
+
+    sorted = malloc((profile_entries_used + 1) * sizeof(profile_entry_t *));
+    if (sorted == NULL)
+        return;
+
+    for (int c = 0; c < PROFILE_ENTRIES; c++) {
+        profile_entry_t *entry = &profile_entries[c];
+
+        if (entry->used) {
+            sorted[nr++] = entry;
+            total_hits += entry->hits;
+            total_compiles += entry->compiles;
+            total_ns += entry->compile_ns;
+        }
+    }
+    qsort(sorted, nr, sizeof(profile_entry_t *), profile_compare);
+
+    path_append_filename(path, usr_path, "dynarec_profile.txt");
+    fp = plat_fopen(path, "w");
+    if (fp == NULL) {
+        free(sorted);
+        return;
+    }
+
+    fprintf(fp, "Blocks: %i  executions: %" PRIu64 "  compiles: %" PRIu64 "  compile time: %" PRIu64 " us\n",
+            nr, total_hits, total_compiles, total_ns / 1000);
+    fprintf(fp, "Code cache: %i/%i blocks in use, %" PRIu64 " evictions\n",
+            codegen_allocator_usage, codegen_allocator_size, codegen_allocator_evictions);
+    fprintf(fp, "Invalidations:");
+    for (int c = 0; c < CODEGEN_PROFILE_INV_MAX; c++)
+        fprintf(fp, " %s=%" PRIu64, profile_inv_names[c], profile_totals[c]);
+    fprintf(fp, "\nWrites filtered by 16 byte code mask: %" PRIu64 "\n\n", profile_filtered);
+
+    fprintf(fp, "%-14s %-8s %12s %8s %10s %6s %8s %8s %8s %8s %8s\n",
+            "CS:EIP", "phys", "hits", "compiles", "comp_us", "host", "write", "range", "evict", "reset", "filtered");
+    for (int c = 0; (c < nr) && (c < PROFILE_REPORT_MAX); c++) {
+        profile_entry_t *entry = sorted[c];
+
+        fprintf(fp, "%04X:%08X  %08X %12" PRIu64 " %8u %10" PRIu64 " %6u %8u %8u %8u %8u %8u\n",
+                entry->cs_sel, entry->pc - entry->cs_base, entry->phys, entry->hits, entry->compiles,
+                entry->compile_ns / 1000, entry->host_size,
+                entry->invalidations[CODEGEN_PROFILE_INV_WRITE], entry->invalidations[CODEGEN_PROFILE_INV_RANGE],
+                entry->invalidations[CODEGEN_PROFILE_INV_EVICT], entry->invalidations[CODEGEN_PROFILE_INV_RESET],
+                entry->filtered);
+    }
+
+    fclose(fp);
+    free(sorted);
+}
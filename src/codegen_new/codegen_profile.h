@@ -0,0 +1,48 @@
+#ifndef _CODEGEN_PROFILE_H_
+#define _CODEGEN_PROFILE_H_
+
+/*Optional recompiler profiling, enabled with the DYNAREC_PROFILE build option.
+
+  Statistics are kept per guest block, keyed on linear PC, physical address and
+  CS base, so they survive the codeblock_t being deleted and reused. The report
+  is written to dynarec_profile.txt in the user directory on exit, or whenever
+  codegen_profile_report() is called.*/
+
+/*Reasons for a block being thrown away*/
+enum {
+    /*Guest write to the page containing the block (codegen_check_flush)*/
+    CODEGEN_PROFILE_INV_WRITE = 0,
+    /*Whole page marked dirty, normally by mem_invalidate_range() on DMA or
+      shadow RAM changes*/
+    CODEGEN_PROFILE_INV_RANGE,
+    /*Evicted to make room in the code cache*/
+    CODEGEN_PROFILE_INV_EVICT,
+    /*Recompiler reset*/
+    CODEGEN_PROFILE_INV_RESET,
+
+    CODEGEN_PROFILE_INV_MAX
+};
+
+#ifdef USE_DYNAREC_PROFILE
+struct codeblock_t;
+
+extern void codegen_profile_init(void);
+extern void codegen_profile_block_init(struct codeblock_t *block);
+extern void codegen_profile_hit(struct codeblock_t *block);
+extern void codegen_profile_compile_start(struct codeblock_t *block);
+extern void codegen_profile_compile_end(struct codeblock_t *block);
+extern void codegen_profile_invalidate(struct codeblock_t *block, int reason);
+extern void codegen_profile_write_filtered(struct codeblock_t *block);
+extern void codegen_profile_report(void);
+#else
+#    define codegen_profile_init()
+#    define codegen_profile_block_init(block)
+#    define codegen_profile_hit(block)
+#    define codegen_profile_compile_start(block)
+#    define codegen_profile_compile_end(block)
+#    define codegen_profile_invalidate(block, reason)
+#    define codegen_profile_write_filtered(block)
+#    define codegen_profile_report()
+#endif
+
+#endif
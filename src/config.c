@@ -78,6 +78,8 @@
 #include <86box/ui.h>
 #include <86box/snd_opl.h>
 #include <86box/version.h>
+#include <86box/trace.h>
+#include <86box/metrics.h>
 
 static int   cx;
 static int   cy;
@@ -85,6 +87,13 @@ static int   cw;
 static int   ch;
 static ini_t config;
 
+/* Changed configurations are written out by a thread of their own, see config_save(). */
+static thread_t *config_thread;
+static event_t  *config_wake;
+static event_t  *config_idle;
+static mutex_t  *config_mutex;
+static ini_t     config_pending;
+
 #ifdef ENABLE_CONFIG_LOG
 int config_do_log = ENABLE_CONFIG_LOG;
 
@@ -132,10 +141,21 @@ load_general(void)
         scale = 9;
     dpi_scale = ini_section_get_int(cat, "dpi_scale", 1);
 
-    enable_overscan  = !!ini_section_get_int(cat, "enable_overscan", 0);
-    vid_cga_contrast = !!ini_section_get_int(cat, "vid_cga_contrast", 0);
-    video_grayscale  = ini_section_get_int(cat, "video_grayscale", 0);
-    video_graytype   = ini_section_get_int(cat, "video_graytype", 0);
+    enable_overscan    = !!ini_section_get_int(cat, "enable_overscan", 0);
+    vid_cga_contrast   = !!ini_section_get_int(cat, "vid_cga_contrast", 0);
+    vid_cga_comp_cache = !!ini_section_get_int(cat, "vid_cga_comp_cache", 1);
+    video_grayscale    = ini_section_get_int(cat, "video_grayscale", 0);
+    video_graytype     = ini_section_get_int(cat, "video_graytype", 0);
+
+    video_render_thread     = !!ini_section_get_int(cat, "video_render_thread", 0);
+    video_blit_mode         = ini_section_get_int(cat, "video_blit_mode", BLIT_MODE_WAIT);
+    video_bus_timing        = ini_section_get_int(cat, "video_bus_timing", VIDEO_BUS_TIMING_AGGREGATE);
+    video_frame_stats       = !!ini_section_get_int(cat, "video_frame_stats", 0);
+    video_screenshot_format = ini_section_get_int(cat, "video_screenshot_format", SCREENSHOT_FORMAT_PNG);
+    video_screenshot_level  = ini_section_get_int(cat, "video_screenshot_level", -1);
+    vnc_max_fps             = ini_section_get_int(cat, "vnc_max_fps", 0);
+    capture_fps             = ini_section_get_int(cat, "capture_fps", 60);
+    strncpy(video_shm_name, ini_section_get_string(cat, "video_shm_name", ""), sizeof(video_shm_name) - 1);
 
     rctrl_is_lalt = ini_section_get_int(cat, "rctrl_is_lalt", 0);
     update_icons  = ini_section_get_int(cat, "update_icons", 1);
@@ -164,7 +184,8 @@ load_general(void)
         fixed_size_x = fixed_size_y = 120;
     }
 
-    sound_gain = ini_section_get_int(cat, "sound_gain", 0);
+    sound_gain        = ini_section_get_int(cat, "sound_gain", 0);
+    sound_low_latency = !!ini_section_get_int(cat, "sound_low_latency", 0);
 
     kbd_req_capture = ini_section_get_int(cat, "kbd_req_capture", 0);
     hide_status_bar = ini_section_get_int(cat, "hide_status_bar", 0);
@@ -174,6 +195,10 @@ load_general(void)
     confirm_exit  = ini_section_get_int(cat, "confirm_exit", 1);
     confirm_save  = ini_section_get_int(cat, "confirm_save", 1);
 
+    turbo_post      = ini_section_get_int(cat, "turbo_post", TURBO_POST_OFF);
+    turbo_post_time = ini_section_get_int(cat, "turbo_post_time", 0);
+    max_speed       = !!ini_section_get_int(cat, "max_speed", 0);
+
     p = ini_section_get_string(cat, "language", NULL);
     if (p != NULL)
         lang_id = plat_language_code(p);
@@ -211,6 +236,28 @@ load_general(void)
 
     do_auto_pause = ini_section_get_int(cat, "do_auto_pause", 0);
 
+    metrics_enabled = !!ini_section_get_int(cat, "metrics", 0);
+
+    for (int i = 0; i < THREAD_CLASS_MAX; i++) {
+        sprintf(temp, "thread_%s_cpus", thread_class_names[i]);
+        p = ini_section_get_string(cat, temp, "");
+        strncpy(thread_class_cpus[i], p, THREAD_CPUS_LEN - 1);
+        thread_class_cpus[i][THREAD_CPUS_LEN - 1] = '\0';
+
+        sprintf(temp, "thread_%s_priority", thread_class_names[i]);
+        p = ini_section_get_string(cat, temp, "normal");
+        if (!strcmp(p, "low"))
+            thread_class_priority[i] = -1;
+        else if (!strcmp(p, "high"))
+            thread_class_priority[i] = 1;
+        else
+            thread_class_priority[i] = 0;
+    }
+
+#ifdef MTR_ENABLED
+    trace_categories = ini_section_get_int(cat, "trace_categories", TRACE_CAT_ALL) & TRACE_CAT_ALL;
+#endif
+
     p = ini_section_get_string(cat, "uuid", NULL);
     if (p != NULL)
         strncpy(uuid, p, sizeof(uuid) - 1);
@@ -389,9 +436,15 @@ load_machine(void)
         mem_size = machine_get_max_ram(machine);
 
     cpu_use_dynarec = !!ini_section_get_int(cat, "cpu_use_dynarec", 0);
+    cpu_dynarec_cache_size = ini_section_get_int(cat, "cpu_dynarec_cache_size", 0);
+    if (cpu_dynarec_cache_size < 0)
+        cpu_dynarec_cache_size = 0;
+    cpu_dynarec_hash_bits = ini_section_get_int(cat, "cpu_dynarec_hash_bits", 0);
+    cpu_808x_fast = !!ini_section_get_int(cat, "cpu_808x_fast", 0);
     fpu_softfloat = !!ini_section_get_int(cat, "fpu_softfloat", 0);
     if ((fpu_type != FPU_NONE) && machine_has_flags(machine, MACHINE_SOFTFLOAT_ONLY))
         fpu_softfloat = 1;
+    fpu_hybrid = !!ini_section_get_int(cat, "fpu_hybrid", 0);
 
     p = ini_section_get_string(cat, "time_sync", NULL);
     if (p != NULL) {
@@ -661,6 +714,10 @@ load_network(void)
                 nc->net_type = NET_TYPE_SLIRP;
             else if (!strcmp(p, "vde") || !strcmp(p, "2"))
                 nc->net_type = NET_TYPE_VDE;
+            else if (!strcmp(p, "tap"))
+                nc->net_type = NET_TYPE_TAP;
+            else if (!strcmp(p, "shm"))
+                nc->net_type = NET_TYPE_SHM;
             else
                 nc->net_type = NET_TYPE_NONE;
         } else
@@ -707,6 +764,10 @@ load_network(void)
                 nc->net_type = NET_TYPE_SLIRP;
             else if (!strcmp(p, "vde") || !strcmp(p, "2"))
                 nc->net_type = NET_TYPE_VDE;
+            else if (!strcmp(p, "tap"))
+                nc->net_type = NET_TYPE_TAP;
+            else if (!strcmp(p, "shm"))
+                nc->net_type = NET_TYPE_SHM;
             else
                 nc->net_type = NET_TYPE_NONE;
         } else
@@ -735,6 +796,10 @@ load_network(void)
                                               NET_LINK_100_HD | NET_LINK_100_FD |
                                               NET_LINK_1000_HD | NET_LINK_1000_FD));
     }
+
+    net_dump_enabled = !!ini_section_get_int(cat, "dump", 0);
+    net_dump_snaplen = ini_section_get_int(cat, "dump_snaplen", 0);
+    net_dump_limit   = ini_section_get_int(cat, "dump_limit", 0);
 }
 
 /* Load "Ports" section. */
@@ -1055,6 +1120,20 @@ load_hard_disks(void)
         p = ini_section_get_string(cat, temp, "");
         strncpy(hdd[c].vhd_parent, p, sizeof(hdd[c].vhd_parent) - 1);
 
+        sprintf(temp, "hdd_%02i_mmap", c + 1);
+        hdd[c].use_mmap = !!ini_section_get_int(cat, temp, 0);
+
+        sprintf(temp, "hdd_%02i_overlay", c + 1);
+        p = ini_section_get_string(cat, temp, "");
+        memset(hdd[c].overlay_fn, 0x00, sizeof(hdd[c].overlay_fn));
+        if (p[0] != 0x00) {
+            if (path_abs(p))
+                strncpy(hdd[c].overlay_fn, p, sizeof(hdd[c].overlay_fn) - 1);
+            else
+                path_append_filename(hdd[c].overlay_fn, usr_path, p);
+            path_normalize(hdd[c].overlay_fn);
+        }
+
         /* If disk is empty or invalid, mark it for deletion. */
         if (!hdd_is_valid(c)) {
             sprintf(temp, "hdd_%02i_parameters", c + 1);
@@ -1374,6 +1453,9 @@ load_other_removable_devices(void)
         sprintf(temp, "zip_%02i_scsi_id", c + 1);
         ini_section_delete_var(cat, temp);
 
+        sprintf(temp, "zip_%02i_turbo", c + 1);
+        zip_drives[c].turbo = !!ini_section_get_int(cat, temp, 0);
+
         sprintf(temp, "zip_%02i_image_path", c + 1);
         p = ini_section_get_string(cat, temp, "");
 
@@ -1421,6 +1503,9 @@ load_other_removable_devices(void)
             sprintf(temp, "zip_%02i_scsi_id", c + 1);
             ini_section_delete_var(cat, temp);
 
+            sprintf(temp, "zip_%02i_turbo", c + 1);
+            ini_section_delete_var(cat, temp);
+
             sprintf(temp, "zip_%02i_image_path", c + 1);
             ini_section_delete_var(cat, temp);
 
@@ -1487,6 +1572,9 @@ load_other_removable_devices(void)
         sprintf(temp, "mo_%02i_scsi_id", c + 1);
         ini_section_delete_var(cat, temp);
 
+        sprintf(temp, "mo_%02i_turbo", c + 1);
+        mo_drives[c].turbo = !!ini_section_get_int(cat, temp, 0);
+
         sprintf(temp, "mo_%02i_image_path", c + 1);
         p = ini_section_get_string(cat, temp, "");
 
@@ -1534,6 +1622,9 @@ load_other_removable_devices(void)
             sprintf(temp, "mo_%02i_scsi_id", c + 1);
             ini_section_delete_var(cat, temp);
 
+            sprintf(temp, "mo_%02i_turbo", c + 1);
+            ini_section_delete_var(cat, temp);
+
             sprintf(temp, "mo_%02i_image_path", c + 1);
             ini_section_delete_var(cat, temp);
 
@@ -1556,6 +1647,7 @@ load_other_peripherals(void)
     bugger_enabled         = !!ini_section_get_int(cat, "bugger_enabled", 0);
     postcard_enabled       = !!ini_section_get_int(cat, "postcard_enabled", 0);
     unittester_enabled     = !!ini_section_get_int(cat, "unittester_enabled", 0);
+    hostshare_enabled      = !!ini_section_get_int(cat, "hostshare_enabled", 0);
     novell_keycard_enabled = !!ini_section_get_int(cat, "novell_keycard_enabled", 0);
 
     for (uint8_t c = 0; c < ISAMEM_MAX; c++) {
@@ -1747,11 +1839,61 @@ save_general(void)
     else
         ini_section_set_int(cat, "enable_overscan", enable_overscan);
 
+    if (video_render_thread == 0)
+        ini_section_delete_var(cat, "video_render_thread");
+    else
+        ini_section_set_int(cat, "video_render_thread", video_render_thread);
+
+    if (video_blit_mode == BLIT_MODE_WAIT)
+        ini_section_delete_var(cat, "video_blit_mode");
+    else
+        ini_section_set_int(cat, "video_blit_mode", video_blit_mode);
+
+    if (video_bus_timing == VIDEO_BUS_TIMING_AGGREGATE)
+        ini_section_delete_var(cat, "video_bus_timing");
+    else
+        ini_section_set_int(cat, "video_bus_timing", video_bus_timing);
+
+    if (video_frame_stats == 0)
+        ini_section_delete_var(cat, "video_frame_stats");
+    else
+        ini_section_set_int(cat, "video_frame_stats", video_frame_stats);
+
+    if (video_screenshot_format == SCREENSHOT_FORMAT_PNG)
+        ini_section_delete_var(cat, "video_screenshot_format");
+    else
+        ini_section_set_int(cat, "video_screenshot_format", video_screenshot_format);
+
+    if (video_screenshot_level == -1)
+        ini_section_delete_var(cat, "video_screenshot_level");
+    else
+        ini_section_set_int(cat, "video_screenshot_level", video_screenshot_level);
+
+    if (vnc_max_fps == 0)
+        ini_section_delete_var(cat, "vnc_max_fps");
+    else
+        ini_section_set_int(cat, "vnc_max_fps", vnc_max_fps);
+
+    if (capture_fps == 60)
+        ini_section_delete_var(cat, "capture_fps");
+    else
+        ini_section_set_int(cat, "capture_fps", capture_fps);
+
+    if (strlen(video_shm_name) > 0)
+        ini_section_set_string(cat, "video_shm_name", video_shm_name);
+    else
+        ini_section_delete_var(cat, "video_shm_name");
+
     if (vid_cga_contrast == 0)
         ini_section_delete_var(cat, "vid_cga_contrast");
     else
         ini_section_set_int(cat, "vid_cga_contrast", vid_cga_contrast);
 
+    if (vid_cga_comp_cache == 1)
+        ini_section_delete_var(cat, "vid_cga_comp_cache");
+    else
+        ini_section_set_int(cat, "vid_cga_comp_cache", vid_cga_comp_cache);
+
     if (video_grayscale == 0)
         ini_section_delete_var(cat, "video_grayscale");
     else
@@ -1788,6 +1930,11 @@ save_general(void)
     else
         ini_section_delete_var(cat, "sound_gain");
 
+    if (sound_low_latency != 0)
+        ini_section_set_int(cat, "sound_low_latency", sound_low_latency);
+    else
+        ini_section_delete_var(cat, "sound_low_latency");
+
     if (kbd_req_capture != 0)
         ini_section_set_int(cat, "kbd_req_capture", kbd_req_capture);
     else
@@ -1818,6 +1965,21 @@ save_general(void)
     else
         ini_section_delete_var(cat, "confirm_save");
 
+    if (turbo_post != TURBO_POST_OFF)
+        ini_section_set_int(cat, "turbo_post", turbo_post);
+    else
+        ini_section_delete_var(cat, "turbo_post");
+
+    if (turbo_post_time != 0)
+        ini_section_set_int(cat, "turbo_post_time", turbo_post_time);
+    else
+        ini_section_delete_var(cat, "turbo_post_time");
+
+    if (max_speed)
+        ini_section_set_int(cat, "max_speed", max_speed);
+    else
+        ini_section_delete_var(cat, "max_speed");
+
     if (mouse_sensitivity != 1.0)
         ini_section_set_double(cat, "mouse_sensitivity", mouse_sensitivity);
     else
@@ -1863,6 +2025,32 @@ save_general(void)
     else
         ini_section_delete_var(cat, "do_auto_pause");
 
+    if (metrics_enabled)
+        ini_section_set_int(cat, "metrics", metrics_enabled);
+    else
+        ini_section_delete_var(cat, "metrics");
+
+    for (int i = 0; i < THREAD_CLASS_MAX; i++) {
+        sprintf(temp, "thread_%s_cpus", thread_class_names[i]);
+        if (thread_class_cpus[i][0] != '\0')
+            ini_section_set_string(cat, temp, thread_class_cpus[i]);
+        else
+            ini_section_delete_var(cat, temp);
+
+        sprintf(temp, "thread_%s_priority", thread_class_names[i]);
+        if (thread_class_priority[i])
+            ini_section_set_string(cat, temp, (thread_class_priority[i] > 0) ? "high" : "low");
+        else
+            ini_section_delete_var(cat, temp);
+    }
+
+#ifdef MTR_ENABLED
+    if (trace_categories != TRACE_CAT_ALL)
+        ini_section_set_int(cat, "trace_categories", trace_categories);
+    else
+        ini_section_delete_var(cat, "trace_categories");
+#endif
+
     char cpu_buf[128] = { 0 };
     plat_get_cpu_string(cpu_buf, 128);
     ini_section_set_string(cat, "host_cpu", cpu_buf);
@@ -1951,7 +2139,23 @@ save_machine(void)
     ini_section_set_int(cat, "mem_size", mem_size);
 
     ini_section_set_int(cat, "cpu_use_dynarec", cpu_use_dynarec);
+    if (cpu_dynarec_cache_size == 0)
+        ini_section_delete_var(cat, "cpu_dynarec_cache_size");
+    else
+        ini_section_set_int(cat, "cpu_dynarec_cache_size", cpu_dynarec_cache_size);
+    if (cpu_dynarec_hash_bits == 0)
+        ini_section_delete_var(cat, "cpu_dynarec_hash_bits");
+    else
+        ini_section_set_int(cat, "cpu_dynarec_hash_bits", cpu_dynarec_hash_bits);
+    if (cpu_808x_fast == 0)
+        ini_section_delete_var(cat, "cpu_808x_fast");
+    else
+        ini_section_set_int(cat, "cpu_808x_fast", cpu_808x_fast);
     ini_section_set_int(cat, "fpu_softfloat", fpu_softfloat);
+    if (fpu_hybrid == 0)
+        ini_section_delete_var(cat, "fpu_hybrid");
+    else
+        ini_section_set_int(cat, "fpu_hybrid", fpu_hybrid);
 
     if (time_sync & TIME_SYNC_ENABLED)
         if (time_sync & TIME_SYNC_UTC)
@@ -2184,6 +2388,12 @@ save_network(void)
             case NET_TYPE_VDE:
                 ini_section_set_string(cat, temp, "vde");
                 break;
+            case NET_TYPE_TAP:
+                ini_section_set_string(cat, temp, "tap");
+                break;
+            case NET_TYPE_SHM:
+                ini_section_set_string(cat, temp, "shm");
+                break;
 
             default:
                 break;
@@ -2207,6 +2417,21 @@ save_network(void)
             ini_section_set_int(cat, temp, nc->link_state);
     }
 
+    if (net_dump_enabled)
+        ini_section_set_int(cat, "dump", net_dump_enabled);
+    else
+        ini_section_delete_var(cat, "dump");
+
+    if (net_dump_snaplen)
+        ini_section_set_int(cat, "dump_snaplen", net_dump_snaplen);
+    else
+        ini_section_delete_var(cat, "dump_snaplen");
+
+    if (net_dump_limit)
+        ini_section_set_int(cat, "dump_limit", net_dump_limit);
+    else
+        ini_section_delete_var(cat, "dump_limit");
+
     ini_delete_section_if_empty(config, cat);
 }
 
@@ -2376,6 +2601,11 @@ save_other_peripherals(void)
     else
         ini_section_set_int(cat, "unittester_enabled", unittester_enabled);
 
+    if (hostshare_enabled == 0)
+        ini_section_delete_var(cat, "hostshare_enabled");
+    else
+        ini_section_set_int(cat, "hostshare_enabled", hostshare_enabled);
+
     if (novell_keycard_enabled == 0)
         ini_section_delete_var(cat, "novell_keycard_enabled");
     else
@@ -2481,6 +2711,22 @@ save_hard_disks(void)
         } else
             ini_section_delete_var(cat, temp);
 
+        sprintf(temp, "hdd_%02i_mmap", c + 1);
+        if (hdd_is_valid(c) && hdd[c].use_mmap)
+            ini_section_set_int(cat, temp, hdd[c].use_mmap);
+        else
+            ini_section_delete_var(cat, temp);
+
+        sprintf(temp, "hdd_%02i_overlay", c + 1);
+        if (hdd_is_valid(c) && hdd[c].overlay_fn[0]) {
+            path_normalize(hdd[c].overlay_fn);
+            if (!strnicmp(hdd[c].overlay_fn, usr_path, strlen(usr_path)))
+                ini_section_set_string(cat, temp, &hdd[c].overlay_fn[strlen(usr_path)]);
+            else
+                ini_section_set_string(cat, temp, hdd[c].overlay_fn);
+        } else
+            ini_section_delete_var(cat, temp);
+
         sprintf(temp, "hdd_%02i_speed", c + 1);
         if (!hdd_is_valid(c) || ((hdd[c].bus != HDD_BUS_ESDI) && (hdd[c].bus != HDD_BUS_IDE) &&
             (hdd[c].bus != HDD_BUS_SCSI) && (hdd[c].bus != HDD_BUS_ATAPI)))
@@ -2677,6 +2923,12 @@ save_other_removable_devices(void)
             ini_section_set_string(cat, temp, tmp2);
         }
 
+        sprintf(temp, "zip_%02i_turbo", c + 1);
+        if ((zip_drives[c].bus_type == 0) || !zip_drives[c].turbo)
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, zip_drives[c].turbo);
+
         sprintf(temp, "zip_%02i_image_path", c + 1);
         if ((zip_drives[c].bus_type == 0) || (strlen(zip_drives[c].image_path) == 0))
             ini_section_delete_var(cat, temp);
@@ -2720,6 +2972,12 @@ save_other_removable_devices(void)
             ini_section_set_string(cat, temp, tmp2);
         }
 
+        sprintf(temp, "mo_%02i_turbo", c + 1);
+        if ((mo_drives[c].bus_type == 0) || !mo_drives[c].turbo)
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, mo_drives[c].turbo);
+
         sprintf(temp, "mo_%02i_image_path", c + 1);
         if ((mo_drives[c].bus_type == 0) || (strlen(mo_drives[c].image_path) == 0))
             ini_section_delete_var(cat, temp);
@@ -2735,9 +2993,61 @@ save_other_removable_devices(void)
     ini_delete_section_if_empty(config, cat);
 }
 
+/* Write to a temporary file first, so the old file stays whole if this fails half way. */
+static void
+config_write(ini_t ini)
+{
+    char temp[1024 + 8];
+
+    snprintf(temp, sizeof(temp), "%s.tmp", cfg_path);
+    ini_write(ini, temp);
+
+    if (plat_rename(temp, cfg_path)) {
+        config_log("CONFIG: unable to replace '%s', writing it in place\n", cfg_path);
+        plat_remove(temp);
+        ini_write(ini, cfg_path);
+    }
+}
+
+static void
+config_writer(void *priv)
+{
+    ini_t ini;
+
+    while (1) {
+        thread_wait_event(config_wake, -1);
+        thread_reset_event(config_wake);
+
+        while (1) {
+            thread_wait_mutex(config_mutex);
+            ini            = config_pending;
+            config_pending = NULL;
+            if (ini == NULL)
+                thread_set_event(config_idle);
+            thread_release_mutex(config_mutex);
+
+            if (ini == NULL)
+                break;
+
+            config_write(ini);
+            ini_close(ini);
+        }
+    }
+}
+
+/* Wait for the configuration to be on disk, before quitting. */
+void
+config_flush(void)
+{
+    if (config_thread != NULL)
+        thread_wait_event(config_idle, -1);
+}
+
 void
 config_save(void)
 {
+    ini_t ini;
+
     save_general();                 /* General */
     for (uint8_t i = 0; i < MONITORS_NUM; i++)
         save_monitor(i);            /* Monitors */
@@ -2753,7 +3063,30 @@ config_save(void)
     save_other_removable_devices(); /* Other removable devices */
     save_other_peripherals();       /* Other peripherals */
 
-    ini_write(config, cfg_path);
+    if (!ini_has_changed(config))
+        return;
+
+    if (config_thread == NULL) {
+        config_wake   = thread_create_event();
+        config_idle   = thread_create_event();
+        config_mutex  = thread_create_mutex();
+        config_thread = thread_create(config_writer, NULL);
+    }
+
+    /*
+     * Hand a copy over to the writer. A copy still waiting to be written
+     * is out of date by now, so bursts of changes only write the last.
+     */
+    ini = ini_snapshot(config);
+
+    thread_wait_mutex(config_mutex);
+    if (config_pending != NULL)
+        ini_close(config_pending);
+    config_pending = ini;
+    thread_reset_event(config_idle);
+    thread_release_mutex(config_mutex);
+
+    thread_set_event(config_wake);
 }
 
 ini_t
@@ -227,21 +227,19 @@ exec386_2386(int32_t cycs)
 
     int      vector;
     int      tempi;
-    int32_t  cycdiff;
-    int32_t  oldcyc;
-    int32_t  cycle_period;
     int32_t  ins_cycles;
+    int      timer_due;
     uint32_t addr;
 
     cycles += cycs;
 
     while (cycles > 0) {
-        cycle_period = (timer_target - (uint32_t) tsc) + 1;
-
         x86_was_reset = 0;
-        cycdiff       = 0;
-        oldcyc        = cycles;
-        while (cycdiff < cycle_period) {
+
+        /* Run up to the next timer deadline. The deadline is re-read after every
+           instruction, as the instruction itself may have armed an earlier
+           timer, which is all the per-instruction timer bookkeeping there is. */
+        do {
             int ins_fetch_fault = 0;
             ins_cycles = cycles;
 
@@ -375,7 +373,8 @@ exec386_2386(int32_t cycs)
             ins_cycles -= cycles;
             tsc += ins_cycles;
 
-            cycdiff = oldcyc - cycles;
+            if (cpu_hlt_idle)
+                cycles -= cpu_hlt_skip(cycles);
 
             if (timetolive) {
                 timetolive--;
@@ -383,13 +382,14 @@ exec386_2386(int32_t cycs)
                     fatal("Life expired\n");
             }
 
-            if (TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) tsc))
+            timer_due = TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) tsc);
+            if (timer_due)
                 timer_process();
 
 #ifdef USE_GDBSTUB
             if (gdbstub_instruction())
                 return;
 #endif
-        }
+        } while (!timer_due);
     }
 }
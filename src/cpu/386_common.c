@@ -58,6 +58,34 @@ uint32_t *eal_w;
 
 int nmi_enable = 1;
 
+int cpu_hlt_idle = 0;
+
+/* A halted CPU can only be woken by something a timer callback does, so
+   rather than running HLT again every 100 clocks, spend the clocks up to the
+   next timer deadline (at most max) in one go. Returns the clocks skipped,
+   which have already been added to the TSC. */
+int32_t
+cpu_hlt_skip(int32_t max)
+{
+    int32_t skip;
+
+    cpu_hlt_idle = 0;
+
+    if ((max <= 0) || smi_line || (nmi && nmi_enable && nmi_mask) ||
+        ((cpu_state.flags & I_FLAG) && pic.int_pending))
+        return 0;
+
+    skip = (int32_t) (timer_target - (uint32_t) tsc);
+    if (skip <= 0)
+        return 0;
+    if (skip > max)
+        skip = max;
+
+    tsc += skip;
+
+    return skip;
+}
+
 int alt_access;
 int cpl_override = 0;
 
@@ -1554,6 +1582,9 @@ x86_int_sw(int num)
 {
     uint32_t addr;
 
+    if (num == 0x19)
+        pc_turbo_post_trigger(TURBO_POST_INT19);
+
     flags_rebuild();
     cycles -= timing_int;
 
@@ -1602,6 +1633,9 @@ x86_int_sw_rm(int num)
     uint16_t new_pc;
     uint16_t new_cs;
 
+    if (num == 0x19)
+        pc_turbo_post_trigger(TURBO_POST_INT19);
+
     flags_rebuild();
     cycles -= timing_int;
 
@@ -297,11 +297,50 @@ int checkio(uint32_t port, int mask);
     }
 
 #ifdef OPS_286_386
-/* TODO: Introduce functions to read exec. */
+/*
+ * Code fetch cache: the page the CPU is executing from, when it is plain RAM,
+ * so the instruction stream can be read directly instead of walking the page
+ * tables and the memory mappings for every byte. Writes land in the same RAM,
+ * so self-modifying code needs no invalidation; the cache is dropped with the
+ * rest of the MMU state on TLB flushes and memory mapping changes, and is
+ * tagged with the privilege level so that user/supervisor checks still apply.
+ */
+static __inline int
+pccache_2386_lookup(uint32_t a, int len)
+{
+    uint32_t tag = (a >> 12) | ((CPL == 3) << 20);
+    uint8_t *t;
+
+    if (cpu_state.abrt || (dr[7] & 0xff) || ((a & 0xfff) > (0x1000 - len)))
+        return 0;
+#    ifdef USE_GDBSTUB
+    if (gdbstub_watching)
+        return 0;
+#    endif
+
+    if (tag != pccache_2386) {
+        read_type = 1;
+        t = getpccache_2386(a);
+        read_type = 4;
+        if (t == NULL)
+            return 0;
+        pccache_2386  = tag;
+        pccache2_2386 = t;
+    }
+
+    return 1;
+}
+
 static __inline uint8_t
 fastreadb(uint32_t a)
 {
     uint8_t ret;
+
+    if (pccache_2386_lookup(a, 1))
+        return pccache2_2386[a & 0xfff];
+    if (cpu_state.abrt)
+        return 0;
+
     read_type = 1;
     ret = readmembl_2386(a);
     read_type = 4;
@@ -314,6 +353,15 @@ static __inline uint16_t
 fastreadw(uint32_t a)
 {
     uint16_t ret;
+
+    if (pccache_2386_lookup(a, 2)) {
+        if ((a & 1) && (!cpu_cyrix_alignment || (a & 7) == 7))
+            cycles -= timing_misaligned;
+        return *(uint16_t *) &pccache2_2386[a & 0xfff];
+    }
+    if (cpu_state.abrt)
+        return 0;
+
     read_type = 1;
     ret = readmemwl_2386(a);
     read_type = 4;
@@ -326,6 +374,15 @@ static __inline uint32_t
 fastreadl(uint32_t a)
 {
     uint32_t ret;
+
+    if (pccache_2386_lookup(a, 4)) {
+        if ((a & 3) && (!cpu_cyrix_alignment || (a & 7) > 4))
+            cycles -= timing_misaligned;
+        return *(uint32_t *) &pccache2_2386[a & 0xfff];
+    }
+    if (cpu_state.abrt)
+        return 0;
+
     read_type = 1;
     ret = readmemll_2386(a);
     read_type = 4;
@@ -461,6 +518,10 @@ fastreadw_fetch(uint32_t a)
         ret = fastreadb(a);
         if (!cpu_state.abrt && (opcode_length[ret & 0xff] > 1))
             ret |= ((uint16_t) fastreadb(a + 1) << 8);
+    } else if (pccache_2386_lookup(a, 2)) {
+        if ((a & 1) && (!cpu_cyrix_alignment || (a & 7) == 7))
+            cycles -= timing_misaligned;
+        ret = *(uint16_t *) &pccache2_2386[a & 0xfff];
     } else if (cpu_state.abrt)
         ret = 0;
     else {
@@ -481,6 +542,10 @@ fastreadl_fetch(uint32_t a)
         ret = fastreadw_fetch(a);
         if (!cpu_state.abrt && (opcode_length[ret & 0xff] > 2))
             ret |= ((uint32_t) fastreadw(a + 2) << 16);
+    } else if (pccache_2386_lookup(a, 4)) {
+        if ((a & 3) && (!cpu_cyrix_alignment || (a & 7) > 4))
+            cycles -= timing_misaligned;
+        ret = *(uint32_t *) &pccache2_2386[a & 0xfff];
     } else if (cpu_state.abrt)
         ret = 0;
     else {
@@ -815,4 +880,9 @@ seteaq(uint64_t v)
 /* Resume Flag handling. */
 extern int rf_flag_no_clear;
 
+/* Set by HLT when the CPU really halted. */
+extern int cpu_hlt_idle;
+
+extern int32_t cpu_hlt_skip(int32_t max);
+
 int cpu_386_check_instruction_fault(void);
\ No newline at end of file
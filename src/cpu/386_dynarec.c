@@ -31,10 +31,13 @@
 #include <86box/machine.h>
 #include <86box/plat_fallthrough.h>
 #include <86box/gdbstub.h>
+#include <86box/trace.h>
+#include <86box/metrics.h>
 #ifdef USE_DYNAREC
 #    include "codegen.h"
 #    ifdef USE_NEW_DYNAREC
 #        include "codegen_backend.h"
+#        include "codegen_profile.h"
 #    endif
 #endif
 
@@ -386,6 +389,11 @@ block_ended:
     cpu_end_block_after_ins = 0;
 }
 
+#    ifndef USE_NEW_DYNAREC
+/* Block run by the previous dispatch, whose chain pointer is updated next. */
+static codeblock_t *last_block = NULL;
+#    endif
+
 static __inline void
 exec386_dynarec_dyn(void)
 {
@@ -396,6 +404,14 @@ exec386_dynarec_dyn(void)
     codeblock_t *block = &codeblock[codeblock_hash[hash]];
 #    else
     codeblock_t *block = codeblock_hash[hash];
+    codeblock_t *prev  = last_block;
+
+    /* On a hash miss, try the block that followed the previous one last
+       time before walking the page tree; slots are never freed, so a
+       stale chain only fails the checks below. */
+    last_block = NULL;
+    if ((!block || (block->phys != phys_addr) || (block->pc != cs + cpu_state.pc)) && prev && prev->chain)
+        block = prev->chain;
 #    endif
     int valid_block = 0;
 
@@ -485,7 +501,7 @@ exec386_dynarec_dyn(void)
         }
 #    ifdef USE_NEW_DYNAREC
         if (valid_block && (block->flags & CODEBLOCK_IN_DIRTY_LIST)) {
-            block->flags &= ~CODEBLOCK_WAS_RECOMPILED;
+            block->flags &= ~(CODEBLOCK_WAS_RECOMPILED | CODEBLOCK_HOT);
             if (block->flags & CODEBLOCK_BYTE_MASK)
                 block->flags |= CODEBLOCK_NO_IMMEDIATES;
             else
@@ -515,8 +531,19 @@ exec386_dynarec_dyn(void)
     {
         void (*code)(void) = (void *) &block->data[BLOCK_START];
 
-#    ifndef USE_NEW_DYNAREC
+#    ifdef USE_NEW_DYNAREC
+        if (block->refs < CODEBLOCK_REFS_MAX)
+            block->refs++;
+        codegen_profile_hit(block);
+        /*Promote hot blocks, they will be recompiled with loop
+          unrolling the next time they are entered*/
+        if (((block->flags & (CODEBLOCK_HOT | CODEBLOCK_BYTE_MASK | CODEBLOCK_HAS_LOOP)) == CODEBLOCK_HAS_LOOP) && (++block->hits >= CODEGEN_HOT_THRESHOLD))
+            block->flags = (block->flags | CODEBLOCK_HOT) & ~CODEBLOCK_WAS_RECOMPILED;
+#    else
         codeblock_hash[hash] = block;
+        if (prev)
+            prev->chain = block;
+        last_block = block;
 #    endif
         inrecomp = 1;
         code();
@@ -545,6 +572,8 @@ exec386_dynarec_dyn(void)
             pthread_jit_write_protect_np(0);
         }
 #    endif
+        TRACE_BEGIN(dynarec, "recompile");
+        metrics.dynarec_blocks++;
         codegen_block_start_recompile(block);
         codegen_in_recompile = 1;
 
@@ -629,6 +658,7 @@ exec386_dynarec_dyn(void)
             codegen_reset();
 
         codegen_in_recompile = 0;
+        TRACE_END(dynarec, "recompile");
 #    if defined(__APPLE__) && defined(__aarch64__)
         if (__builtin_available(macOS 11.0, *)) {
             pthread_jit_write_protect_np(1);
@@ -744,6 +774,7 @@ exec386_dynarec(int32_t cycs)
     int32_t  oldcyc2;
     uint64_t oldtsc;
     uint64_t delta;
+    int32_t  hlt_skip;
 
     int32_t cyc_period = cycs / 2000; /*5us*/
 
@@ -851,6 +882,20 @@ exec386_dynarec(int32_t cycs)
                     timer_process();
             }
 
+            if (cpu_hlt_idle) {
+                /* The skip may run past this 5 us period into the rest of
+                   the budget, which is then taken off cycles_main directly. */
+                hlt_skip = cpu_hlt_skip(cycles_main - (cycles_start - cycles));
+                if (hlt_skip > cycles) {
+                    cycles_main -= (hlt_skip - cycles);
+                    cycles = 0;
+                } else
+                    cycles -= hlt_skip;
+
+                if (TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) tsc))
+                    timer_process();
+            }
+
 #    ifdef USE_GDBSTUB
             if (gdbstub_instruction())
                 return;
@@ -867,21 +912,19 @@ exec386(int32_t cycs)
 {
     int      vector;
     int      tempi;
-    int32_t  cycdiff;
-    int32_t  oldcyc;
-    int32_t  cycle_period;
     int32_t  ins_cycles;
+    int      timer_due;
     uint32_t addr;
 
     cycles += cycs;
 
     while (cycles > 0) {
-        cycle_period = (timer_target - (uint32_t) tsc) + 1;
-
         x86_was_reset = 0;
-        cycdiff       = 0;
-        oldcyc        = cycles;
-        while (cycdiff < cycle_period) {
+
+        /* Run up to the next timer deadline. The deadline is re-read after every
+           instruction, as the instruction itself may have armed an earlier
+           timer, which is all the per-instruction timer bookkeeping there is. */
+        do {
             ins_cycles = cycles;
 
 #ifndef USE_NEW_DYNAREC
@@ -1026,7 +1069,8 @@ block_ended:
             ins_cycles -= cycles;
             tsc += ins_cycles;
 
-            cycdiff = oldcyc - cycles;
+            if (cpu_hlt_idle)
+                cycles -= cpu_hlt_skip(cycles);
 
             if (timetolive) {
                 timetolive--;
@@ -1034,13 +1078,14 @@ block_ended:
                     fatal("Life expired\n");
             }
 
-            if (TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) tsc))
+            timer_due = TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) tsc);
+            if (timer_due)
                 timer_process();
 
 #ifdef USE_GDBSTUB
             if (gdbstub_instruction())
                 return;
 #endif
-        }
+        } while (!timer_due);
     }
 }
@@ -176,6 +176,21 @@ clock_end(void)
         timer_process();
 }
 
+/*
+ * In the fast 808x mode the emulated clock is only brought up to date at
+ * instruction boundaries and before I/O, instead of after every bus cycle,
+ * so timers are processed once per instruction. Cycle counts and the
+ * prefetch queue are still modelled exactly.
+ */
+static void
+clock_sync(void)
+{
+    if (cpu_808x_fast) {
+        clock_end();
+        clock_start();
+    }
+}
+
 static void
 fetch_and_bus(int c, int bus)
 {
@@ -191,7 +206,7 @@ fetch_and_bus(int c, int bus)
     }
 
     pfq_add(c, !bus);
-    if (bus < 2) {
+    if ((bus < 2) && !cpu_808x_fast) {
         clock_end();
         clock_start();
     }
@@ -243,15 +258,18 @@ cpu_io(int bits, int out, uint16_t port)
         wait(4, 1);
         if (bits == 16) {
             if (is8086 && !(port & 1)) {
+                clock_sync();
                 old_cycles = cycles;
                 outw(port, AX);
             } else {
                 wait(4, 1);
+                clock_sync();
                 old_cycles = cycles;
                 outb(port++, AL);
                 outb(port, AH);
             }
         } else {
+            clock_sync();
             old_cycles = cycles;
             outb(port, AL);
         }
@@ -259,15 +277,18 @@ cpu_io(int bits, int out, uint16_t port)
         wait(4, 1);
         if (bits == 16) {
             if (is8086 && !(port & 1)) {
+                clock_sync();
                 old_cycles = cycles;
                 AX         = inw(port);
             } else {
                 wait(4, 1);
+                clock_sync();
                 old_cycles = cycles;
                 AL         = inb(port++);
                 AH         = inb(port);
             }
         } else {
+            clock_sync();
             old_cycles = cycles;
             AL         = inb(port);
         }
@@ -506,14 +527,22 @@ static void
 pfq_add(int c, int add)
 {
     int d;
+    int pos;
 
     if ((c <= 0) || (pfq_pos >= pfq_size))
         return;
 
-    for (d = 0; d < c; d++) {
-        biu_cycles = (biu_cycles + 1) & 0x03;
-        if (prefetching && add && (biu_cycles == 0x00))
-            pfq_write();
+    /* Only the cycles that complete a bus cycle can fetch, skip straight to them. */
+    d          = biu_cycles + c;
+    biu_cycles = d & 0x03;
+    if (!prefetching || !add)
+        return;
+
+    for (d >>= 2; d > 0; d--) {
+        pos = pfq_pos;
+        pfq_write();
+        if (pfq_pos == pos)
+            break;
     }
 }
 
@@ -3019,7 +3048,10 @@ execx86(int cycs)
                     break;
                 case 0xCD: /*INT*/
                     wait(1, 0);
-                    interrupt(pfq_fetchb());
+                    temp = pfq_fetchb();
+                    if (temp == 0x19)
+                        pc_turbo_post_trigger(TURBO_POST_INT19);
+                    interrupt(temp);
                     break;
                 case 0xCE: /*INTO*/
                     wait(3, 0);
@@ -3583,6 +3615,9 @@ execx86(int cycs)
                 noint = 0;
 
             cpu_alu_op = 0;
+        } else if (cpu_808x_fast && !repeating) {
+            /* Prefixes, the bus cycles did not bring the clock up to date. */
+            clock_end();
         }
 
 #ifdef USE_GDBSTUB
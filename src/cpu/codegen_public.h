@@ -51,6 +51,9 @@
 
 extern void codegen_init(void);
 extern void codegen_flush(void);
+#if defined(USE_NEW_DYNAREC) && defined(USE_DYNAREC_PROFILE)
+extern void codegen_profile_report(void);
+#endif
 
 /*Current physical page of block being recompiled. -1 if no recompilation taking place */
 extern uint32_t recomp_page;
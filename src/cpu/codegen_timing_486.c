@@ -297,6 +297,52 @@ static int *opcode_timings_81_mod3[8] = {
     // clang-format on
 };
 
+/* How the timing and dependency tables of a group are indexed. */
+enum {
+    TIMING_INDEX_OPCODE = 0, /* by the opcode byte */
+    TIMING_INDEX_REG,        /* by the reg field of the ModR/M byte */
+    TIMING_INDEX_FPU,        /* by the reg field, whole ModR/M when mod == 3 */
+    TIMING_INDEX_FPU_REG     /* by the reg field, always */
+};
+
+typedef struct timing_group_t {
+    int           **timings[2]; /* [mod3] */
+    const uint64_t *deps[2];
+    int             index;
+} timing_group_t;
+
+static const timing_group_t group_base  = { { opcode_timings, opcode_timings_mod3 }, { opcode_deps, opcode_deps_mod3 }, TIMING_INDEX_OPCODE };
+static const timing_group_t group_0f    = { { opcode_timings_0f, opcode_timings_0f_mod3 }, { opcode_deps_0f, opcode_deps_0f_mod3 }, TIMING_INDEX_OPCODE };
+static const timing_group_t group_8x    = { { opcode_timings_8x, opcode_timings_8x_mod3 }, { opcode_deps_8x, opcode_deps_8x_mod3 }, TIMING_INDEX_REG };
+static const timing_group_t group_81    = { { opcode_timings_81, opcode_timings_81_mod3 }, { opcode_deps_81, opcode_deps_81_mod3 }, TIMING_INDEX_REG };
+static const timing_group_t group_shift = { { opcode_timings_shift, opcode_timings_shift_mod3 }, { opcode_deps_shift, opcode_deps_shift_mod3 }, TIMING_INDEX_REG };
+static const timing_group_t group_f6    = { { opcode_timings_f6, opcode_timings_f6_mod3 }, { opcode_deps_f6, opcode_deps_f6_mod3 }, TIMING_INDEX_REG };
+static const timing_group_t group_f7    = { { opcode_timings_f7, opcode_timings_f7_mod3 }, { opcode_deps_f7, opcode_deps_f7_mod3 }, TIMING_INDEX_REG };
+static const timing_group_t group_ff    = { { opcode_timings_ff, opcode_timings_ff_mod3 }, { opcode_deps_ff, opcode_deps_ff_mod3 }, TIMING_INDEX_REG };
+static const timing_group_t group_d8    = { { opcode_timings_d8, opcode_timings_d8_mod3 }, { opcode_deps_d8, opcode_deps_d8_mod3 }, TIMING_INDEX_FPU_REG };
+static const timing_group_t group_d9    = { { opcode_timings_d9, opcode_timings_d9_mod3 }, { opcode_deps_d9, opcode_deps_d9_mod3 }, TIMING_INDEX_FPU };
+static const timing_group_t group_da    = { { opcode_timings_da, opcode_timings_da_mod3 }, { opcode_deps_da, opcode_deps_da_mod3 }, TIMING_INDEX_FPU_REG };
+static const timing_group_t group_db    = { { opcode_timings_db, opcode_timings_db_mod3 }, { opcode_deps_db, opcode_deps_db_mod3 }, TIMING_INDEX_FPU };
+static const timing_group_t group_dc    = { { opcode_timings_dc, opcode_timings_dc_mod3 }, { opcode_deps_dc, opcode_deps_dc_mod3 }, TIMING_INDEX_FPU_REG };
+static const timing_group_t group_dd    = { { opcode_timings_dd, opcode_timings_dd_mod3 }, { opcode_deps_dd, opcode_deps_dd_mod3 }, TIMING_INDEX_FPU_REG };
+static const timing_group_t group_de    = { { opcode_timings_de, opcode_timings_de_mod3 }, { opcode_deps_de, opcode_deps_de_mod3 }, TIMING_INDEX_FPU_REG };
+static const timing_group_t group_df    = { { opcode_timings_df, opcode_timings_df_mod3 }, { opcode_deps_df, opcode_deps_df_mod3 }, TIMING_INDEX_FPU_REG };
+
+/* Group selected by the 0F and FPU escape prefixes, NULL for none. */
+static const timing_group_t *prefix_groups[256] = {
+    [0x0f] = &group_0f,
+    [0xd8] = &group_d8, [0xd9] = &group_d9, [0xda] = &group_da, [0xdb] = &group_db,
+    [0xdc] = &group_dc, [0xdd] = &group_dd, [0xde] = &group_de, [0xdf] = &group_df
+};
+
+/* Group selected by the opcode byte without one of those prefixes, NULL for the base tables. */
+static const timing_group_t *opcode_groups[256] = {
+    [0x80] = &group_8x, [0x81] = &group_81, [0x82] = &group_8x, [0x83] = &group_8x,
+    [0xc0] = &group_shift, [0xc1] = &group_shift,
+    [0xd0] = &group_shift, [0xd1] = &group_shift, [0xd2] = &group_shift, [0xd3] = &group_shift,
+    [0xf6] = &group_f6, [0xf7] = &group_f7, [0xff] = &group_ff
+};
+
 static int      timing_count;
 static uint8_t  last_prefix;
 static uint32_t regmask_modified;
@@ -337,108 +383,32 @@ codegen_timing_486_prefix(uint8_t prefix, uint32_t fetchdat)
 void
 codegen_timing_486_opcode(uint8_t opcode, uint32_t fetchdat, int op_32, UNUSED(uint32_t op_pc))
 {
-    int           **timings;
-    const uint64_t *deps;
-    int             mod3 = ((fetchdat & 0xc0) == 0xc0);
-    int             bit8 = !(opcode & 1);
-
-    switch (last_prefix) {
-        case 0x0f:
-            timings = mod3 ? opcode_timings_0f_mod3 : opcode_timings_0f;
-            deps    = mod3 ? opcode_deps_0f_mod3 : opcode_deps_0f;
-            break;
+    const timing_group_t *group = prefix_groups[last_prefix];
+    const uint64_t       *deps;
+    int                   mod3 = ((fetchdat & 0xc0) == 0xc0);
+    int                   bit8 = !(opcode & 1);
 
-        case 0xd8:
-            timings = mod3 ? opcode_timings_d8_mod3 : opcode_timings_d8;
-            deps    = mod3 ? opcode_deps_d8_mod3 : opcode_deps_d8;
-            opcode  = (opcode >> 3) & 7;
-            break;
-        case 0xd9:
-            timings = mod3 ? opcode_timings_d9_mod3 : opcode_timings_d9;
-            deps    = mod3 ? opcode_deps_d9_mod3 : opcode_deps_d9;
-            opcode  = mod3 ? opcode & 0x3f : (opcode >> 3) & 7;
-            break;
-        case 0xda:
-            timings = mod3 ? opcode_timings_da_mod3 : opcode_timings_da;
-            deps    = mod3 ? opcode_deps_da_mod3 : opcode_deps_da;
-            opcode  = (opcode >> 3) & 7;
-            break;
-        case 0xdb:
-            timings = mod3 ? opcode_timings_db_mod3 : opcode_timings_db;
-            deps    = mod3 ? opcode_deps_db_mod3 : opcode_deps_db;
-            opcode  = mod3 ? opcode & 0x3f : (opcode >> 3) & 7;
-            break;
-        case 0xdc:
-            timings = mod3 ? opcode_timings_dc_mod3 : opcode_timings_dc;
-            deps    = mod3 ? opcode_deps_dc_mod3 : opcode_deps_dc;
-            opcode  = (opcode >> 3) & 7;
-            break;
-        case 0xdd:
-            timings = mod3 ? opcode_timings_dd_mod3 : opcode_timings_dd;
-            deps    = mod3 ? opcode_deps_dd_mod3 : opcode_deps_dd;
-            opcode  = (opcode >> 3) & 7;
+    if ((group == NULL) && ((group = opcode_groups[opcode]) == NULL))
+        group = &group_base;
+
+    switch (group->index) {
+        case TIMING_INDEX_REG:
+            opcode = (fetchdat >> 3) & 7;
             break;
-        case 0xde:
-            timings = mod3 ? opcode_timings_de_mod3 : opcode_timings_de;
-            deps    = mod3 ? opcode_deps_de_mod3 : opcode_deps_de;
-            opcode  = (opcode >> 3) & 7;
+        case TIMING_INDEX_FPU:
+            opcode = mod3 ? (opcode & 0x3f) : ((opcode >> 3) & 7);
             break;
-        case 0xdf:
-            timings = mod3 ? opcode_timings_df_mod3 : opcode_timings_df;
-            deps    = mod3 ? opcode_deps_df_mod3 : opcode_deps_df;
-            opcode  = (opcode >> 3) & 7;
+        case TIMING_INDEX_FPU_REG:
+            opcode = (opcode >> 3) & 7;
             break;
 
         default:
-            switch (opcode) {
-                case 0x80:
-                case 0x82:
-                case 0x83:
-                    timings = mod3 ? opcode_timings_8x_mod3 : opcode_timings_8x;
-                    deps    = mod3 ? opcode_deps_8x_mod3 : opcode_deps_8x;
-                    opcode  = (fetchdat >> 3) & 7;
-                    break;
-                case 0x81:
-                    timings = mod3 ? opcode_timings_81_mod3 : opcode_timings_81;
-                    deps    = mod3 ? opcode_deps_81_mod3 : opcode_deps_81;
-                    opcode  = (fetchdat >> 3) & 7;
-                    break;
-
-                case 0xc0:
-                case 0xc1:
-                case 0xd0:
-                case 0xd1:
-                case 0xd2:
-                case 0xd3:
-                    timings = mod3 ? opcode_timings_shift_mod3 : opcode_timings_shift;
-                    deps    = mod3 ? opcode_deps_shift_mod3 : opcode_deps_shift;
-                    opcode  = (fetchdat >> 3) & 7;
-                    break;
-
-                case 0xf6:
-                    timings = mod3 ? opcode_timings_f6_mod3 : opcode_timings_f6;
-                    deps    = mod3 ? opcode_deps_f6_mod3 : opcode_deps_f6;
-                    opcode  = (fetchdat >> 3) & 7;
-                    break;
-                case 0xf7:
-                    timings = mod3 ? opcode_timings_f7_mod3 : opcode_timings_f7;
-                    deps    = mod3 ? opcode_deps_f7_mod3 : opcode_deps_f7;
-                    opcode  = (fetchdat >> 3) & 7;
-                    break;
-                case 0xff:
-                    timings = mod3 ? opcode_timings_ff_mod3 : opcode_timings_ff;
-                    deps    = mod3 ? opcode_deps_ff_mod3 : opcode_deps_ff;
-                    opcode  = (fetchdat >> 3) & 7;
-                    break;
-
-                default:
-                    timings = mod3 ? opcode_timings_mod3 : opcode_timings;
-                    deps    = mod3 ? opcode_deps_mod3 : opcode_deps;
-                    break;
-            }
+            break;
     }
 
-    timing_count += COUNT(timings[opcode], op_32);
+    deps = group->deps[mod3];
+
+    timing_count += COUNT(group->timings[mod3][opcode], op_32);
     if (regmask_modified & get_addr_regmask(deps[opcode], fetchdat, op_32))
         timing_count++; /*AGI stall*/
     codegen_block_cycles += timing_count;
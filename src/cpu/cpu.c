@@ -41,6 +41,8 @@
 #include <86box/pic.h>
 #include <86box/pci.h>
 #include <86box/gdbstub.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 #include <86box/plat_fallthrough.h>
 #include <86box/plat_unused.h>
 
@@ -4382,3 +4384,53 @@ cpu_update_waitstates(void)
     if (cpu_s->rspeed <= 8000000)
         cpu_rom_prefetch_cycles = cpu_mem_prefetch_cycles;
 }
+
+void
+cpu_snapshot(snapshot_t *snap)
+{
+    uint64_t old_tsc = tsc;
+
+    snapshot_var(snap, cpu_state);
+    snapshot_var(snap, cr2);
+    snapshot_var(snap, cr3);
+    snapshot_var(snap, cr4);
+    snapshot_var(snap, dr);
+    snapshot_var(snap, _tr);
+    snapshot_var(snap, gdt);
+    snapshot_var(snap, ldt);
+    snapshot_var(snap, idt);
+    snapshot_var(snap, tr);
+    snapshot_var(snap, msr);
+    snapshot_var(snap, cyrix);
+    snapshot_var(snap, amd_efer);
+    snapshot_var(snap, star);
+    snapshot_var(snap, cs_msr);
+    snapshot_var(snap, esp_msr);
+    snapshot_var(snap, eip_msr);
+    snapshot_var(snap, fpu_state);
+    snapshot_var(snap, cpu_cur_status);
+    snapshot_var(snap, in_sys);
+    snapshot_var(snap, smi_latched);
+    snapshot_var(snap, smm_in_hlt);
+    snapshot_var(snap, smi_block);
+    snapshot_var(snap, cpu_fast_off_count);
+    snapshot_var(snap, cpu_fast_off_val);
+    snapshot_var(snap, cpu_fast_off_flags);
+    snapshot_var(snap, nmi);
+    snapshot_var(snap, nmi_mask);
+    snapshot_var(snap, tsc);
+
+    if (!snapshot_loading(snap))
+        return;
+
+    cpu_state.ea_seg = &cpu_state.seg_ds;
+
+    /* Timers that are not part of the snapshot keep their distance from
+       the TSC; the ones that are get their own timestamps back later. */
+    timer_rebase((int64_t) (tsc - old_tsc));
+
+#ifdef USE_DYNAREC
+    codegen_reset();
+#endif
+    flushmmucache();
+}
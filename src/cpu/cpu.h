@@ -559,6 +559,8 @@ extern uint32_t olddslimitw;
 extern uint32_t oldsslimitw;
 extern uint32_t pccache;
 extern uint8_t *pccache2;
+extern uint32_t pccache_2386;
+extern uint8_t *pccache2_2386;
 
 extern double   bus_timing;
 extern double   isa_timing;
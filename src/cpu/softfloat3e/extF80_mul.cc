@@ -59,12 +59,6 @@ extFloat80_t extF80_mul(extFloat80_t a, extFloat80_t b, struct softfloat_status_
     uint16_t uiZ64;
     uint64_t uiZ0;
 
-    // handle unsupported extended double-precision floating encodings
-    if (extF80_isUnsupported(a) || extF80_isUnsupported(b)) {
-        softfloat_raiseFlags(status, softfloat_flag_invalid);
-        return packToExtF80_twoargs(defaultNaNExtF80UI64, defaultNaNExtF80UI0);
-    }
-
     /*------------------------------------------------------------------------
     *------------------------------------------------------------------------*/
     uiA64 = a.signExp;
@@ -78,6 +72,18 @@ extFloat80_t extF80_mul(extFloat80_t a, extFloat80_t b, struct softfloat_status_
     expB  = expExtF80UI64(uiB64);
     sigB  = uiB0;
     signZ = signA ^ signB;
+
+    // two normal operands, the usual case, need none of the checks below
+    if (((uint32_t) (expA - 1) < 0x7FFE) && ((uint32_t) (expB - 1) < 0x7FFE) &&
+        (sigA & sigB & UINT64_C(0x8000000000000000)))
+        goto multiply;
+
+    // handle unsupported extended double-precision floating encodings
+    if (extF80_isUnsupported(a) || extF80_isUnsupported(b)) {
+        softfloat_raiseFlags(status, softfloat_flag_invalid);
+        return packToExtF80_twoargs(defaultNaNExtF80UI64, defaultNaNExtF80UI0);
+    }
+
     /*------------------------------------------------------------------------
     *------------------------------------------------------------------------*/
     if (expA == 0x7FFF) {
@@ -124,6 +130,7 @@ extFloat80_t extF80_mul(extFloat80_t a, extFloat80_t b, struct softfloat_status_
     }
     /*------------------------------------------------------------------------
     *------------------------------------------------------------------------*/
+ multiply:
     expZ = expA + expB - 0x3FFE;
     sig128Z = softfloat_mul64To128(sigA, sigB);
     if (sig128Z.v64 < UINT64_C(0x8000000000000000)) {
@@ -42,13 +42,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #ifdef SOFTFLOAT_BUILTIN_CLZ
 
+#ifndef softfloat_countLeadingZeros16
 static __inline uint8_t softfloat_countLeadingZeros16(uint16_t a)
     { return a ? __builtin_clz(a) - 16 : 16; }
 #define softfloat_countLeadingZeros16 softfloat_countLeadingZeros16
+#endif
 
+#ifndef softfloat_countLeadingZeros32
 static __inline uint8_t softfloat_countLeadingZeros32(uint32_t a)
     { return a ? __builtin_clz(a) : 32; }
 #define softfloat_countLeadingZeros32 softfloat_countLeadingZeros32
+#endif
 
 static __inline uint8_t softfloat_countLeadingZeros64(uint64_t a)
     { return a ? __builtin_clzll(a) : 64; }
@@ -106,5 +110,3 @@ void
 #endif
 
 #endif
-
-#endif
@@ -40,6 +40,32 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdint.h>
 #include "softfloat_types.h"
 
+/* Let the compiler do the 128-bit products and the leading zero counts. */
+#if defined(__GNUC__)
+#    define SOFTFLOAT_BUILTIN_CLZ
+#    if defined(__SIZEOF_INT128__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#        define SOFTFLOAT_INTRINSIC_INT128
+#    endif
+#    include "opts-GCC.h"
+#elif defined(_MSC_VER) && defined(_M_X64)
+#    include <intrin.h>
+
+static __inline struct uint128 softfloat_mul64To128(uint64_t a, uint64_t b)
+{
+    struct uint128 z;
+    z.v0 = _umul128(a, b, &z.v64);
+    return z;
+}
+#    define softfloat_mul64To128 softfloat_mul64To128
+
+static __inline uint8_t softfloat_countLeadingZeros64(uint64_t a)
+{
+    unsigned long index;
+    return _BitScanReverse64(&index, a) ? (uint8_t) (63 - index) : 64;
+}
+#    define softfloat_countLeadingZeros64 softfloat_countLeadingZeros64
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -478,6 +504,7 @@ void
 /*----------------------------------------------------------------------------
 | Returns the 128-bit product of 'a', 'b', and 2^32.
 *----------------------------------------------------------------------------*/
+#ifndef softfloat_mul64ByShifted32To128
 static __inline struct uint128 softfloat_mul64ByShifted32To128(uint64_t a, uint32_t b)
 {
     uint64_t mid;
@@ -487,17 +514,21 @@ static __inline struct uint128 softfloat_mul64ByShifted32To128(uint64_t a, uint3
     z.v64 = (uint64_t) (uint32_t) (a>>32) * b + (mid>>32);
     return z;
 }
+#endif
 
 /*----------------------------------------------------------------------------
 | Returns the 128-bit product of 'a' and 'b'.
 *----------------------------------------------------------------------------*/
+#ifndef softfloat_mul64To128
 struct uint128 softfloat_mul64To128(uint64_t a, uint64_t b);
+#endif
 
 /*----------------------------------------------------------------------------
 | Returns the product of the 128-bit integer formed by concatenating 'a64' and
 | 'a0', multiplied by 'b'.  The multiplication is modulo 2^128; any overflow
 | bits are discarded.
 *----------------------------------------------------------------------------*/
+#ifndef softfloat_mul128By32
 static __inline
 struct uint128 softfloat_mul128By32(uint64_t a64, uint64_t a0, uint32_t b)
 {
@@ -510,6 +541,7 @@ struct uint128 softfloat_mul128By32(uint64_t a64, uint64_t a0, uint32_t b)
     z.v64 = a64 * b + (uint32_t) ((mid + carry)>>32);
     return z;
 }
+#endif
 
 /*----------------------------------------------------------------------------
 | Multiplies the 128-bit unsigned integer formed by concatenating 'a64' and
@@ -518,8 +550,10 @@ struct uint128 softfloat_mul128By32(uint64_t a64, uint64_t a0, uint32_t b)
 | Argument 'zPtr' points to an array of four 64-bit elements that concatenate
 | in the platform's normal endian order to form a 256-bit integer.
 *----------------------------------------------------------------------------*/
+#ifndef softfloat_mul128To256M
 void
  softfloat_mul128To256M(uint64_t a64, uint64_t a0, uint64_t b64, uint64_t b0, uint64_t *zPtr);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -35,12 +35,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 =============================================================================*/
 
 #include <stdint.h>
+#include "primitives.h"
 
 #ifndef softfloat_countLeadingZeros64
 
-#define softfloat_countLeadingZeros64 softfloat_countLeadingZeros64
-#include "primitives.h"
-
 uint8_t softfloat_countLeadingZeros64(uint64_t a)
 {
     uint8_t count;
@@ -38,6 +38,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "primitives.h"
 #include "primitiveTypes.h"
 
+#ifndef softfloat_mul128To256M
+
 void softfloat_mul128To256M(uint64_t a64, uint64_t a0, uint64_t b64, uint64_t b0, uint64_t *zPtr)
 {
     struct uint128 p0, p64, p128;
@@ -60,3 +62,4 @@ void softfloat_mul128To256M(uint64_t a64, uint64_t a0, uint64_t b64, uint64_t b0
     zPtr[indexWord(4, 3)] = z192 + (z128 < p64.v64);
 }
 
+#endif
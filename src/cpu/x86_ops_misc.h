@@ -711,8 +711,10 @@ opHLT(uint32_t fetchdat)
         enter_smm_check(1);
     else if (!((cpu_state.flags & I_FLAG) && pic.int_pending)) {
         CLOCK_CYCLES_ALWAYS(100);
-        if (!((cpu_state.flags & I_FLAG) && pic.int_pending))
+        if (!((cpu_state.flags & I_FLAG) && pic.int_pending)) {
             cpu_state.pc--;
+            cpu_hlt_idle = 1;
+        }
     } else {
         CLOCK_CYCLES(5);
     }
@@ -1,3 +1,5 @@
+#include "x86_ops_rep_fast.h"
+
 #define REP_OPS(size, CNT_REG, SRC_REG, DEST_REG)                                                                 \
     static int opREP_INSB_##size(uint32_t fetchdat)                                                               \
     {                                                                                                             \
@@ -38,25 +40,32 @@
                                                                                                                   \
         if (CNT_REG > 0) {                                                                                        \
             uint16_t temp;                                                                                        \
+            uint32_t done;                                                                                        \
                                                                                                                   \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
             check_io_perm(DX, 2);                                                                                 \
             CHECK_WRITE(&cpu_state.seg_es, DEST_REG, DEST_REG + 1UL);                                             \
-            high_page = 0;                                                                                        \
-            do_mmut_ww(es, DEST_REG, addr64a);                                                                    \
-            if (cpu_state.abrt)                                                                                   \
-                return 1;                                                                                         \
-            temp = inw(DX);                                                                                       \
-            writememw_n(es, DEST_REG, addr64a, temp);                                                             \
-            if (cpu_state.abrt)                                                                                   \
-                return 1;                                                                                         \
+            done = rep_ins_fast(DEST_REG, REP_ADDR_MASK(DEST_REG), CNT_REG, 2, 15);                               \
+            if (done) {                                                                                           \
+                DEST_REG += done * 2;                                                                             \
+                CNT_REG -= done;                                                                                  \
+            } else {                                                                                              \
+                high_page = 0;                                                                                    \
+                do_mmut_ww(es, DEST_REG, addr64a);                                                                \
+                if (cpu_state.abrt)                                                                               \
+                    return 1;                                                                                     \
+                temp = inw(DX);                                                                                   \
+                writememw_n(es, DEST_REG, addr64a, temp);                                                         \
+                if (cpu_state.abrt)                                                                               \
+                    return 1;                                                                                     \
                                                                                                                   \
-            if (cpu_state.flags & D_FLAG)                                                                         \
-                DEST_REG -= 2;                                                                                    \
-            else                                                                                                  \
-                DEST_REG += 2;                                                                                    \
-            CNT_REG--;                                                                                            \
-            cycles -= 15;                                                                                         \
+                if (cpu_state.flags & D_FLAG)                                                                     \
+                    DEST_REG -= 2;                                                                                \
+                else                                                                                              \
+                    DEST_REG += 2;                                                                                \
+                CNT_REG--;                                                                                        \
+                cycles -= 15;                                                                                     \
+            }                                                                                                     \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -71,25 +80,32 @@
                                                                                                                   \
         if (CNT_REG > 0) {                                                                                        \
             uint32_t temp;                                                                                        \
+            uint32_t done;                                                                                        \
                                                                                                                   \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
             check_io_perm(DX, 4);                                                                                 \
             CHECK_WRITE(&cpu_state.seg_es, DEST_REG, DEST_REG + 3UL);                                             \
-            high_page = 0;                                                                                        \
-            do_mmut_wl(es, DEST_REG, addr64a);                                                                    \
-            if (cpu_state.abrt)                                                                                   \
-                return 1;                                                                                         \
-            temp = inl(DX);                                                                                       \
-            writememl_n(es, DEST_REG, addr64a, temp);                                                             \
-            if (cpu_state.abrt)                                                                                   \
-                return 1;                                                                                         \
+            done = rep_ins_fast(DEST_REG, REP_ADDR_MASK(DEST_REG), CNT_REG, 4, 15);                               \
+            if (done) {                                                                                           \
+                DEST_REG += done * 4;                                                                             \
+                CNT_REG -= done;                                                                                  \
+            } else {                                                                                              \
+                high_page = 0;                                                                                    \
+                do_mmut_wl(es, DEST_REG, addr64a);                                                                \
+                if (cpu_state.abrt)                                                                               \
+                    return 1;                                                                                     \
+                temp = inl(DX);                                                                                   \
+                writememl_n(es, DEST_REG, addr64a, temp);                                                         \
+                if (cpu_state.abrt)                                                                               \
+                    return 1;                                                                                     \
                                                                                                                   \
-            if (cpu_state.flags & D_FLAG)                                                                         \
-                DEST_REG -= 4;                                                                                    \
-            else                                                                                                  \
-                DEST_REG += 4;                                                                                    \
-            CNT_REG--;                                                                                            \
-            cycles -= 15;                                                                                         \
+                if (cpu_state.flags & D_FLAG)                                                                     \
+                    DEST_REG -= 4;                                                                                \
+                else                                                                                              \
+                    DEST_REG += 4;                                                                                \
+                CNT_REG--;                                                                                        \
+                cycles -= 15;                                                                                     \
+            }                                                                                                     \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -128,19 +144,30 @@
     {                                                                                                             \
         if (CNT_REG > 0) {                                                                                        \
             uint16_t temp;                                                                                        \
+            uint32_t done;                                                                                        \
             SEG_CHECK_READ(cpu_state.ea_seg);                                                                     \
             CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG + 1UL);                                                 \
-            temp = readmemw(cpu_state.ea_seg->base, SRC_REG);                                                     \
-            if (cpu_state.abrt)                                                                                   \
-                return 1;                                                                                         \
-            check_io_perm(DX, 2);                                                                                 \
-            outw(DX, temp);                                                                                       \
-            if (cpu_state.flags & D_FLAG)                                                                         \
-                SRC_REG -= 2;                                                                                     \
-            else                                                                                                  \
-                SRC_REG += 2;                                                                                     \
-            CNT_REG--;                                                                                            \
-            cycles -= 14;                                                                                         \
+            done = rep_outs_fast_count(SRC_REG, REP_ADDR_MASK(SRC_REG), CNT_REG, 2);                              \
+            if (done) {                                                                                           \
+                check_io_perm(DX, 2);                                                                             \
+                done = rep_outs_fast(SRC_REG, done, 2, 14);                                                       \
+            }                                                                                                     \
+            if (done) {                                                                                           \
+                SRC_REG += done * 2;                                                                              \
+                CNT_REG -= done;                                                                                  \
+            } else {                                                                                              \
+                temp = readmemw(cpu_state.ea_seg->base, SRC_REG);                                                 \
+                if (cpu_state.abrt)                                                                               \
+                    return 1;                                                                                     \
+                check_io_perm(DX, 2);                                                                             \
+                outw(DX, temp);                                                                                   \
+                if (cpu_state.flags & D_FLAG)                                                                     \
+                    SRC_REG -= 2;                                                                                 \
+                else                                                                                              \
+                    SRC_REG += 2;                                                                                 \
+                CNT_REG--;                                                                                        \
+                cycles -= 14;                                                                                     \
+            }                                                                                                     \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -153,19 +180,30 @@
     {                                                                                                             \
         if (CNT_REG > 0) {                                                                                        \
             uint32_t temp;                                                                                        \
+            uint32_t done;                                                                                        \
             SEG_CHECK_READ(cpu_state.ea_seg);                                                                     \
             CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG + 3UL);                                                 \
-            temp = readmeml(cpu_state.ea_seg->base, SRC_REG);                                                     \
-            if (cpu_state.abrt)                                                                                   \
-                return 1;                                                                                         \
-            check_io_perm(DX, 4);                                                                                 \
-            outl(DX, temp);                                                                                       \
-            if (cpu_state.flags & D_FLAG)                                                                         \
-                SRC_REG -= 4;                                                                                     \
-            else                                                                                                  \
-                SRC_REG += 4;                                                                                     \
-            CNT_REG--;                                                                                            \
-            cycles -= 14;                                                                                         \
+            done = rep_outs_fast_count(SRC_REG, REP_ADDR_MASK(SRC_REG), CNT_REG, 4);                              \
+            if (done) {                                                                                           \
+                check_io_perm(DX, 4);                                                                             \
+                done = rep_outs_fast(SRC_REG, done, 4, 14);                                                       \
+            }                                                                                                     \
+            if (done) {                                                                                           \
+                SRC_REG += done * 4;                                                                              \
+                CNT_REG -= done;                                                                                  \
+            } else {                                                                                              \
+                temp = readmeml(cpu_state.ea_seg->base, SRC_REG);                                                 \
+                if (cpu_state.abrt)                                                                               \
+                    return 1;                                                                                     \
+                check_io_perm(DX, 4);                                                                             \
+                outl(DX, temp);                                                                                   \
+                if (cpu_state.flags & D_FLAG)                                                                     \
+                    SRC_REG -= 4;                                                                                 \
+                else                                                                                              \
+                    SRC_REG += 4;                                                                                 \
+                CNT_REG--;                                                                                        \
+                cycles -= 14;                                                                                     \
+            }                                                                                                     \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -186,10 +224,21 @@
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         }                                                                                                         \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t done;                                                                                        \
             uint8_t temp;                                                                                         \
                                                                                                                   \
             CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG);                                                   \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG);                                               \
+            done = rep_movs_fast(SRC_REG, DEST_REG, REP_ADDR_MASK(DEST_REG), CNT_REG, 1,                          \
+                                 cycles_end, is486 ? 3 : 4);                                                      \
+            if (done) {                                                                                           \
+                DEST_REG += done;                                                                                 \
+                SRC_REG += done;                                                                                  \
+                CNT_REG -= done;                                                                                  \
+                if (cycles < cycles_end)                                                                          \
+                    break;                                                                                        \
+                continue;                                                                                         \
+            }                                                                                                     \
             high_page = 0;                                                                                        \
             do_mmut_rb(cpu_state.ea_seg->base, SRC_REG, &addr64);                                                 \
             if (cpu_state.abrt)                                                                                   \
@@ -235,10 +284,21 @@
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         }                                                                                                         \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t done;                                                                                        \
             uint16_t temp;                                                                                        \
                                                                                                                   \
             CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG + 1UL);                                             \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 1UL);                                         \
+            done = rep_movs_fast(SRC_REG, DEST_REG, REP_ADDR_MASK(DEST_REG), CNT_REG, 2,                          \
+                                 cycles_end, is486 ? 3 : 4);                                                      \
+            if (done) {                                                                                           \
+                DEST_REG += done * 2;                                                                             \
+                SRC_REG += done * 2;                                                                              \
+                CNT_REG -= done;                                                                                  \
+                if (cycles < cycles_end)                                                                          \
+                    break;                                                                                        \
+                continue;                                                                                         \
+            }                                                                                                     \
             high_page = 0;                                                                                        \
             do_mmut_rw(cpu_state.ea_seg->base, SRC_REG, addr64a);                                                 \
             if (cpu_state.abrt)                                                                                   \
@@ -284,10 +344,21 @@
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         }                                                                                                         \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t done;                                                                                        \
             uint32_t temp;                                                                                        \
                                                                                                                   \
             CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG + 3UL);                                             \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 3UL);                                         \
+            done = rep_movs_fast(SRC_REG, DEST_REG, REP_ADDR_MASK(DEST_REG), CNT_REG, 4,                          \
+                                 cycles_end, is486 ? 3 : 4);                                                      \
+            if (done) {                                                                                           \
+                DEST_REG += done * 4;                                                                             \
+                SRC_REG += done * 4;                                                                              \
+                CNT_REG -= done;                                                                                  \
+                if (cycles < cycles_end)                                                                          \
+                    break;                                                                                        \
+                continue;                                                                                         \
+            }                                                                                                     \
             high_page = 0;                                                                                        \
             do_mmut_rl(cpu_state.ea_seg->base, SRC_REG, addr64a);                                                 \
             if (cpu_state.abrt)                                                                                   \
@@ -330,7 +401,17 @@
         if (CNT_REG > 0)                                                                                          \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t done;                                                                                        \
+                                                                                                                  \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG);                                               \
+            done = rep_stos_fast(DEST_REG, REP_ADDR_MASK(DEST_REG), CNT_REG, AL, 1, cycles_end, is486 ? 4 : 5);   \
+            if (done) {                                                                                           \
+                DEST_REG += done;                                                                                 \
+                CNT_REG -= done;                                                                                  \
+                if (cycles < cycles_end)                                                                          \
+                    break;                                                                                        \
+                continue;                                                                                         \
+            }                                                                                                     \
             writememb(es, DEST_REG, AL);                                                                          \
             if (cpu_state.abrt)                                                                                   \
                 return 1;                                                                                         \
@@ -358,7 +439,17 @@
         if (CNT_REG > 0)                                                                                          \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t done;                                                                                        \
+                                                                                                                  \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 1UL);                                         \
+            done = rep_stos_fast(DEST_REG, REP_ADDR_MASK(DEST_REG), CNT_REG, AX, 2, cycles_end, is486 ? 4 : 5);   \
+            if (done) {                                                                                           \
+                DEST_REG += done * 2;                                                                             \
+                CNT_REG -= done;                                                                                  \
+                if (cycles < cycles_end)                                                                          \
+                    break;                                                                                        \
+                continue;                                                                                         \
+            }                                                                                                     \
             writememw(es, DEST_REG, AX);                                                                          \
             if (cpu_state.abrt)                                                                                   \
                 return 1;                                                                                         \
@@ -386,7 +477,17 @@
         if (CNT_REG > 0)                                                                                          \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t done;                                                                                        \
+                                                                                                                  \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 3UL);                                         \
+            done = rep_stos_fast(DEST_REG, REP_ADDR_MASK(DEST_REG), CNT_REG, EAX, 4, cycles_end, is486 ? 4 : 5);  \
+            if (done) {                                                                                           \
+                DEST_REG += done * 4;                                                                             \
+                CNT_REG -= done;                                                                                  \
+                if (cycles < cycles_end)                                                                          \
+                    break;                                                                                        \
+                continue;                                                                                         \
+            }                                                                                                     \
             writememl(es, DEST_REG, EAX);                                                                         \
             if (cpu_state.abrt)                                                                                   \
                 return 1;                                                                                         \
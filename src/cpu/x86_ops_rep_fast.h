@@ -0,0 +1,158 @@
+/*Fast paths for forward REP MOVS/STOS/INS/OUTS. When the destination (and for
+  MOVS the source) is plain RAM with a valid lookup entry, as many elements as
+  fit in the current page, the segment limits, the address size and the
+  remaining cycle budget are moved with a single host memset/memcpy, or for
+  INS/OUTS with a single call to the port's block handler. Pages holding
+  recompiled code never get a write lookup entry, so those writes still go
+  through mem_write_ram*_page() and are marked dirty as before. Anything the
+  fast path can't handle returns 0 and is done one element at a time.*/
+#define REP_ADDR_MASK(reg) ((sizeof(reg) == 2) ? 0xffff : 0xffffffff)
+
+static __inline uint32_t
+rep_fast_count(x86seg *chseg, uint32_t addr, uint32_t addr_mask, uint32_t count, int size)
+{
+    uint32_t n = (0x1000 - ((chseg->base + addr) & 0xfff)) / size;
+
+    if (n > count)
+        n = count;
+    if (!n || (chseg->base == 0xffffffff) || (addr < chseg->limit_low))
+        return 0;
+    if (((uint64_t) addr + (n * size) - 1) > addr_mask)
+        n = ((uint64_t) addr_mask - addr + 1) / size;
+    if (((uint64_t) addr + (n * size) - 1) > chseg->limit_high)
+        n = (chseg->limit_high >= addr) ? (((uint64_t) chseg->limit_high - addr + 1) / size) : 0;
+
+    return n;
+}
+
+static __inline uint32_t
+rep_fast_budget(uint32_t n, int cycles_end, int cost)
+{
+    int budget = ((cycles - cycles_end) / cost) + 1;
+
+    if (budget < 1)
+        budget = 1;
+    return (n > (uint32_t) budget) ? budget : n;
+}
+
+static __inline uint32_t
+rep_stos_fast(uint32_t dest, uint32_t addr_mask, uint32_t count, uint32_t val, int size, int cycles_end, int cost)
+{
+    uint32_t n;
+    uint8_t *p;
+
+    if (cpu_state.flags & D_FLAG)
+        return 0;
+#ifdef USE_DEBUG_REGS_486
+    if (dr[7] & 0xFF)
+        return 0;
+#endif
+    n = rep_fast_count(&cpu_state.seg_es, dest, addr_mask, count, size);
+    if (!n || (writelookup2[(es + dest) >> 12] == (uintptr_t) LOOKUP_INV))
+        return 0;
+    n = rep_fast_budget(n, cycles_end, cost);
+    p = (uint8_t *) (writelookup2[(es + dest) >> 12] + (uintptr_t) (es + dest));
+
+    if (size == 1)
+        memset(p, val, n);
+    else if (size == 2) {
+        for (uint32_t c = 0; c < n; c++)
+            ((uint16_t *) p)[c] = val;
+    } else {
+        for (uint32_t c = 0; c < n; c++)
+            ((uint32_t *) p)[c] = val;
+    }
+    cycles -= n * cost;
+
+    return n;
+}
+
+static __inline uint32_t
+rep_movs_fast(uint32_t src, uint32_t dest, uint32_t addr_mask, uint32_t count, int size, int cycles_end, int cost)
+{
+    uint32_t n;
+    uint32_t n_src;
+    uint8_t *s;
+    uint8_t *d;
+
+    if (cpu_state.flags & D_FLAG)
+        return 0;
+#ifdef USE_DEBUG_REGS_486
+    if (dr[7] & 0xFF)
+        return 0;
+#endif
+    n     = rep_fast_count(&cpu_state.seg_es, dest, addr_mask, count, size);
+    n_src = rep_fast_count(cpu_state.ea_seg, src, addr_mask, count, size);
+    if (n_src < n)
+        n = n_src;
+    if (!n || (readlookup2[(cpu_state.ea_seg->base + src) >> 12] == (uintptr_t) LOOKUP_INV) ||
+        (writelookup2[(es + dest) >> 12] == (uintptr_t) LOOKUP_INV))
+        return 0;
+    n = rep_fast_budget(n, cycles_end, cost);
+    s = (uint8_t *) (readlookup2[(cpu_state.ea_seg->base + src) >> 12] + (uintptr_t) (cpu_state.ea_seg->base + src));
+    d = (uint8_t *) (writelookup2[(es + dest) >> 12] + (uintptr_t) (es + dest));
+
+    /*Overlapping forward copies replicate the source pattern, which memcpy()
+      and memmove() don't*/
+    if ((d > s) && (d < (s + (n * size))))
+        return 0;
+    memmove(d, s, n * size);
+    cycles -= n * cost;
+
+    return n;
+}
+
+/*INS/OUTS only go through the block handler when the port has one (the IDE
+  and NE2000 data ports), and only for whole runs that the handler accepts; what it turns
+  down is done one element at a time.*/
+static __inline uint32_t
+rep_ins_fast(uint32_t dest, uint32_t addr_mask, uint32_t count, int size, int cost)
+{
+    uint32_t n;
+
+    if ((cpu_state.flags & D_FLAG) || trap || (count < 2))
+        return 0;
+#ifdef USE_DEBUG_REGS_486
+    if (dr[7] & 0xFF)
+        return 0;
+#endif
+    n = rep_fast_count(&cpu_state.seg_es, dest, addr_mask, count, size);
+    if ((n < 2) || (writelookup2[(es + dest) >> 12] == (uintptr_t) LOOKUP_INV))
+        return 0;
+    n = io_read_block(DX, (void *) (writelookup2[(es + dest) >> 12] + (uintptr_t) (es + dest)), n, size);
+    cycles -= n * cost;
+
+    return n;
+}
+
+static __inline uint32_t
+rep_outs_fast_count(uint32_t src, uint32_t addr_mask, uint32_t count, int size)
+{
+    uint32_t n;
+
+    if ((cpu_state.flags & D_FLAG) || trap || (count < 2))
+        return 0;
+#ifdef USE_DEBUG_REGS_486
+    if (dr[7] & 0xFF)
+        return 0;
+#endif
+    n = rep_fast_count(cpu_state.ea_seg, src, addr_mask, count, size);
+    if ((n < 2) || (readlookup2[(cpu_state.ea_seg->base + src) >> 12] == (uintptr_t) LOOKUP_INV))
+        return 0;
+
+    return n;
+}
+
+/*Only called once rep_outs_fast_count() has found the source in RAM, so the
+  I/O permission check can go first without reordering a page fault.*/
+static __inline uint32_t
+rep_outs_fast(uint32_t src, uint32_t n, int size, int cost)
+{
+    const uint8_t *s = (const uint8_t *) (readlookup2[(cpu_state.ea_seg->base + src) >> 12] +
+                                          (uintptr_t) (cpu_state.ea_seg->base + src));
+
+    n = io_write_block(DX, s, n, size);
+    cycles -= n * cost;
+
+    return n;
+}
@@ -30,6 +30,7 @@
 #include <86box/timer.h>
 #include <86box/machine.h>
 #include <86box/mem.h>
+#include <86box/gdbstub.h>
 #include <86box/nvr.h>
 #include <86box/plat_fallthrough.h>
 #include <86box/plat_unused.h>
@@ -433,7 +434,8 @@ loadseg(uint16_t seg, x86seg *s)
         do_seg_load(s, segdat);
 
         cpl_override = 1;
-        writememw(0, addr + 4, segdat[2] | 0x100); /* Set accessed bit */
+        if (!(segdat[2] & 0x0100))
+            writememw(0, addr + 4, segdat[2] | 0x0100); /* Set accessed bit */
         cpl_override = 0;
         s->checked   = 0;
 #ifdef USE_DYNAREC
@@ -539,7 +541,8 @@ loadcs(uint16_t seg)
 #endif
 
             cpl_override = 1;
-            writememw(0, addr + 4, segdat[2] | 0x0100); /* Set accessed bit */
+            if (!(segdat[2] & 0x0100))
+                writememw(0, addr + 4, segdat[2] | 0x0100); /* Set accessed bit */
             cpl_override = 0;
         } else {
             /* System segment */
@@ -624,7 +627,8 @@ loadcsjmp(uint16_t seg, uint32_t old_pc)
             set_use32(segdat[3] & 0x0040);
 
             cpl_override = 1;
-            writememw(0, addr + 4, segdat[2] | 0x0100); /* Set accessed bit */
+            if (!(segdat[2] & 0x0100))
+                writememw(0, addr + 4, segdat[2] | 0x0100); /* Set accessed bit */
             cpl_override = 0;
 
             CS        = (seg & 0xfffc) | CPL;
@@ -718,7 +722,8 @@ loadcsjmp(uint16_t seg, uint32_t old_pc)
                             cpu_state.pc = newpc;
 
                             cpl_override = 1;
-                            writememw(0, addr + 4, segdat[2] | 0x100); /* Set accessed bit */
+                            if (!(segdat[2] & 0x0100))
+                                writememw(0, addr + 4, segdat[2] | 0x0100); /* Set accessed bit */
                             cpl_override = 0;
                             break;
 
@@ -922,7 +927,8 @@ loadcscall(uint16_t seg)
             set_use32(segdat[3] & 0x0040);
 
             cpl_override = 1;
-            writememw(0, addr + 4, segdat[2] | 0x100); /* Set accessed bit */
+            if (!(segdat[2] & 0x0100))
+                writememw(0, addr + 4, segdat[2] | 0x0100); /* Set accessed bit */
             cpl_override = 0;
 
             /* Conforming segments don't change CPL, so preserve existing CPL */
@@ -1071,7 +1077,8 @@ loadcscall(uint16_t seg)
 
                                 x86seg_log("Set access 1\n");
                                 cpl_override = 1;
-                                writememw(0, addr + 4, segdat2[2] | 0x100); /* Set accessed bit */
+                                if (!(segdat2[2] & 0x0100))
+                                    writememw(0, addr + 4, segdat2[2] | 0x0100); /* Set accessed bit */
                                 cpl_override = 0;
 
                                 CS = seg2;
@@ -1087,7 +1094,8 @@ loadcscall(uint16_t seg)
                                 x86seg_log("Set access 2\n");
 
                                 cpl_override = 1;
-                                writememw(0, oaddr + 4, segdat[2] | 0x100); /* Set accessed bit */
+                                if (!(segdat[2] & 0x0100))
+                                    writememw(0, oaddr + 4, segdat[2] | 0x0100); /* Set accessed bit */
                                 cpl_override = 0;
 
                                 x86seg_log("Type %04X\n", type);
@@ -1167,7 +1175,8 @@ loadcscall(uint16_t seg)
                             cpu_state.pc = newpc;
 
                             cpl_override = 1;
-                            writememw(0, addr + 4, segdat[2] | 0x100); /* Set accessed bit */
+                            if (!(segdat[2] & 0x0100))
+                                writememw(0, addr + 4, segdat[2] | 0x0100); /* Set accessed bit */
                             cpl_override = 0;
                             cycles -= timing_call_pm_gate;
                             break;
@@ -1309,7 +1318,8 @@ pmoderetf(int is32, uint16_t off)
         }
 
         cpl_override = 1;
-        writememw(0, addr + 4, segdat[2] | 0x100); /* Set accessed bit */
+        if (!(segdat[2] & 0x0100))
+            writememw(0, addr + 4, segdat[2] | 0x0100); /* Set accessed bit */
         cpl_override = 0;
 
         cpu_state.pc = newpc;
@@ -1422,8 +1432,10 @@ pmoderetf(int is32, uint16_t off)
         do_seg_load(&cpu_state.seg_ss, segdat2);
 
         cpl_override = 1;
-        writememw(0, addr + 4, segdat2[2] | 0x100); /* Set accessed bit */
-        writememw(0, oaddr + 4, segdat[2] | 0x100); /* Set accessed bit */
+        if (!(segdat2[2] & 0x0100))
+            writememw(0, addr + 4, segdat2[2] | 0x0100); /* Set accessed bit */
+        if (!(segdat[2] & 0x0100))
+            writememw(0, oaddr + 4, segdat[2] | 0x0100); /* Set accessed bit */
         cpl_override = 0;
         /* Conforming segments don't change CPL, so CPL = RPL */
         if (segdat[2] & 0x0400)
@@ -1615,7 +1627,8 @@ pmodeint(int num, int soft)
                         do_seg_load(&cpu_state.seg_ss, segdat3);
 
                         cpl_override = 1;
-                        writememw(0, addr + 4, segdat3[2] | 0x100); /* Set accessed bit */
+                        if (!(segdat3[2] & 0x0100))
+                            writememw(0, addr + 4, segdat3[2] | 0x0100); /* Set accessed bit */
                         cpl_override = 0;
 
                         x86seg_log("New stack %04X:%08X\n", SS, ESP);
@@ -1704,7 +1717,8 @@ pmodeint(int num, int soft)
             set_use32(segdat2[3] & 0x40);
 
             cpl_override = 1;
-            writememw(0, oaddr + 4, segdat2[2] | 0x100); /* Set accessed bit */
+            if (!(segdat2[2] & 0x0100))
+                writememw(0, oaddr + 4, segdat2[2] | 0x0100); /* Set accessed bit */
             cpl_override = 0;
 
             cpu_state.eflags &= ~VM_FLAG;
@@ -1962,7 +1976,8 @@ pmodeiret(int is32)
         set_use32(segdat[3] & 0x0040);
 
         cpl_override = 1;
-        writememw(0, addr + 4, segdat[2] | 0x100); /* Set accessed bit */
+        if (!(segdat[2] & 0x0100))
+            writememw(0, addr + 4, segdat[2] | 0x0100); /* Set accessed bit */
         cpl_override = 0;
         cycles -= timing_iret_pm;
     } else { /* Return to outer level */
@@ -2033,8 +2048,10 @@ pmodeiret(int is32)
         do_seg_load(&cpu_state.seg_ss, segdat2);
 
         cpl_override = 1;
-        writememw(0, addr + 4, segdat2[2] | 0x100); /* Set accessed bit */
-        writememw(0, oaddr + 4, segdat[2] | 0x100); /* Set accessed bit */
+        if (!(segdat2[2] & 0x0100))
+            writememw(0, addr + 4, segdat2[2] | 0x0100); /* Set accessed bit */
+        if (!(segdat[2] & 0x0100))
+            writememw(0, oaddr + 4, segdat[2] | 0x0100); /* Set accessed bit */
         cpl_override = 0;
         /* Conforming segments don't change CPL, so CPL = RPL */
         if (segdat[2] & 0x0400)
@@ -2199,7 +2216,7 @@ taskswitch286(uint16_t seg, uint16_t *segdat, int is32)
         cr0 |= 8;
 
         cr3 = new_cr3;
-        flushmmucache();
+        flushmmucache_cr3();
 
         cpu_state.pc     = new_pc;
         cpu_state.flags  = new_flags;
@@ -4,12 +4,17 @@
 #include <string.h>
 #include <wchar.h>
 #define fplog 0
+#include <float.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
 #include <math.h>
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/mem.h>
 #include <86box/pic.h>
+#include <86box/plat_fallthrough.h>
 #include "x86.h"
 #include "x86_flags.h"
 #include "x86_ops.h"
@@ -319,6 +324,9 @@ FPU_exception(uint32_t fetchdat, uint16_t exceptions, int store)
 
     /* Extract only the bits which we use to set the status word */
     exceptions &= FPU_SW_Exceptions_Mask;
+    /* Most operations raise nothing, there is nothing to merge then. */
+    if (!exceptions)
+        return 0;
     status = fpu_state.swd;
 
     unmasked = (exceptions & ~fpu_state.cwd) & FPU_CW_Exceptions_Mask;
@@ -546,6 +554,214 @@ unpack_FPU_TW(uint16_t tag_byte)
     return (twd >> 2);
 }
 
+/*
+ * Hybrid SoftFloat mode: ADD, SUB(R), MUL and DIV(R) are done with the host's
+ * x87 extended precision when the result is provably identical to what
+ * SoftFloat would return, and fall back to SoftFloat otherwise.
+ *
+ * That is the case with 64-bit precision control, round to nearest, normal
+ * operands, and exponents far enough from the limits that neither the result
+ * nor the error terms below can overflow or underflow; the only exception
+ * that can then be raised is precision. The rounding error is recovered
+ * exactly with Knuth's two-sum or Dekker's two-product, which gives both the
+ * precision flag and C1 (rounded up) as SoftFloat would set them.
+ */
+#if (defined __i386__ || defined __x86_64__) && !defined _MSC_VER && (LDBL_MANT_DIG == 64)
+#    define X87_HYBRID_HOST 1
+#endif
+
+#define X87_HYBRID_EXP_MAX  16000
+#define X87_HYBRID_LOG_MASK ((1ULL << 24) - 1)
+
+enum {
+    X87_HYBRID_ADD = 0,
+    X87_HYBRID_SUB,
+    X87_HYBRID_MUL,
+    X87_HYBRID_DIV
+};
+
+uint64_t fpu_hybrid_native   = 0;
+uint64_t fpu_hybrid_fallback = 0;
+
+#ifdef X87_HYBRID_HOST
+static int x87_hybrid_host = -1;
+
+/* Make sure the host FPU rounds to nearest at full precision. */
+static int
+x87_hybrid_host_check(void)
+{
+    volatile long double one = 1.0L;
+
+    return ((one + 0x1.8p-64L) == (one + 0x1p-63L)) && ((one + 0x1p-64L) == one);
+}
+
+/* Unbiased exponent of a normal operand, or INT_MAX for anything else. */
+static int
+x87_hybrid_exp(floatx80 a)
+{
+    int exp = a.signExp & 0x7fff;
+
+    if ((exp == 0) || (exp == 0x7fff) || !(a.signif >> 63))
+        return INT_MAX;
+
+    return exp - FLOATX80_EXP_BIAS;
+}
+
+static long double
+x87_hybrid_to_host(floatx80 a)
+{
+    long double ret = 0.0L;
+
+    memcpy(&ret, &a, 10);
+    return ret;
+}
+
+static floatx80
+x87_hybrid_from_host(long double a)
+{
+    floatx80 ret;
+
+    memcpy(&ret, &a, 10);
+    return ret;
+}
+
+/* Exact error of the rounded product p = a * b. */
+static long double
+x87_hybrid_mul_err(long double a, long double b, long double p)
+{
+    const long double split = 4294967297.0L; /* 2^32 + 1 */
+    long double       c;
+    long double       a_hi;
+    long double       a_lo;
+    long double       b_hi;
+    long double       b_lo;
+
+    c    = a * split;
+    a_hi = c - (c - a);
+    a_lo = a - a_hi;
+    c    = b * split;
+    b_hi = c - (c - b);
+    b_lo = b - b_hi;
+
+    return (((a_hi * b_hi - p) + a_hi * b_lo) + a_lo * b_hi) + a_lo * b_lo;
+}
+
+static int
+x87_hybrid_op(int op, floatx80 a, floatx80 b, floatx80 *r, struct softfloat_status_t *status)
+{
+    int         exp_a = x87_hybrid_exp(a);
+    int         exp_b = x87_hybrid_exp(b);
+    long double x;
+    long double y;
+    long double z;
+    long double t;
+    long double err;
+
+    if ((abs(exp_a) >= X87_HYBRID_EXP_MAX) || (abs(exp_b) >= X87_HYBRID_EXP_MAX))
+        return 0;
+    if ((op == X87_HYBRID_MUL) && (abs(exp_a + exp_b) >= X87_HYBRID_EXP_MAX))
+        return 0;
+    if ((op == X87_HYBRID_DIV) && (abs(exp_a - exp_b) >= X87_HYBRID_EXP_MAX))
+        return 0;
+
+    x = x87_hybrid_to_host(a);
+    y = x87_hybrid_to_host(b);
+
+    switch (op) {
+        case X87_HYBRID_SUB:
+            y = -y;
+            fallthrough;
+        case X87_HYBRID_ADD:
+            z   = x + y;
+            t   = z - x;
+            err = (x - (z - t)) + (y - t);
+            break;
+        case X87_HYBRID_MUL:
+            z   = x * y;
+            err = x87_hybrid_mul_err(x, y, z);
+            break;
+        default:
+            /* x - q * y is exact, and has the sign of the error times that of y. */
+            z   = x / y;
+            t   = z * y;
+            err = (x - t) - x87_hybrid_mul_err(z, y, t);
+            if (y < 0.0L)
+                err = -err;
+            break;
+    }
+
+    if (err != 0.0L) {
+        softfloat_raiseFlags(status, softfloat_flag_inexact);
+        if ((err < 0.0L) != (z < 0.0L))
+            softfloat_setRoundingUp(status);
+    }
+
+    *r = x87_hybrid_from_host(z);
+    return 1;
+}
+#endif
+
+static floatx80
+x87_hybrid(int op, floatx80 a, floatx80 b, struct softfloat_status_t *status)
+{
+#ifdef X87_HYBRID_HOST
+    floatx80 ret;
+
+    if (x87_hybrid_host == -1) {
+        x87_hybrid_host = x87_hybrid_host_check();
+        fpu_log("FPU: hybrid mode %s\n", x87_hybrid_host ? "available" : "unavailable, host FPU precision");
+    }
+
+    if (fpu_hybrid && x87_hybrid_host) {
+        if ((status->extF80_roundingPrecision == 80) &&
+            (status->softfloat_roundingMode == softfloat_round_near_even) &&
+            x87_hybrid_op(op, a, b, &ret, status)) {
+            fpu_hybrid_native++;
+            return ret;
+        }
+
+        if (!(++fpu_hybrid_fallback & X87_HYBRID_LOG_MASK))
+            fpu_log("FPU: hybrid mode fell back %" PRIu64 " times out of %" PRIu64 "\n",
+                    fpu_hybrid_fallback, fpu_hybrid_fallback + fpu_hybrid_native);
+    }
+#endif
+
+    switch (op) {
+        case X87_HYBRID_ADD:
+            return extF80_add(a, b, status);
+        case X87_HYBRID_SUB:
+            return extF80_sub(a, b, status);
+        case X87_HYBRID_MUL:
+            return extF80_mul(a, b, status);
+        default:
+            return extF80_div(a, b, status);
+    }
+}
+
+floatx80
+x87_hybrid_add(floatx80 a, floatx80 b, struct softfloat_status_t *status)
+{
+    return x87_hybrid(X87_HYBRID_ADD, a, b, status);
+}
+
+floatx80
+x87_hybrid_sub(floatx80 a, floatx80 b, struct softfloat_status_t *status)
+{
+    return x87_hybrid(X87_HYBRID_SUB, a, b, status);
+}
+
+floatx80
+x87_hybrid_mul(floatx80 a, floatx80 b, struct softfloat_status_t *status)
+{
+    return x87_hybrid(X87_HYBRID_MUL, a, b, status);
+}
+
+floatx80
+x87_hybrid_div(floatx80 a, floatx80 b, struct softfloat_status_t *status)
+{
+    return x87_hybrid(X87_HYBRID_DIV, a, b, status);
+}
+
 #ifdef ENABLE_808X_LOG
 void
 x87_dumpregs(void)
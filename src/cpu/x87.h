@@ -152,6 +152,13 @@ int                   FPU_handle_NaN64(extFloat80_t a, float64 b, extFloat80_t *
 int                   FPU_tagof(const extFloat80_t reg);
 uint8_t               pack_FPU_TW(uint16_t twd);
 uint16_t              unpack_FPU_TW(uint16_t tag_byte);
+floatx80              x87_hybrid_add(floatx80 a, floatx80 b, struct softfloat_status_t *status);
+floatx80              x87_hybrid_sub(floatx80 a, floatx80 b, struct softfloat_status_t *status);
+floatx80              x87_hybrid_mul(floatx80 a, floatx80 b, struct softfloat_status_t *status);
+floatx80              x87_hybrid_div(floatx80 a, floatx80 b, struct softfloat_status_t *status);
+
+extern uint64_t fpu_hybrid_native;
+extern uint64_t fpu_hybrid_fallback;
 
 static __inline uint16_t
 i387_get_control_word(void)
@@ -41,6 +41,7 @@
  */
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -54,6 +55,8 @@
 #include <86box/mem.h>
 #include <86box/rom.h>
 #include <86box/sound.h>
+#include <86box/snapshot.h>
+#include <86box/thread.h>
 
 #define DEVICE_MAX 256 /* max # of devices */
 
@@ -219,6 +222,71 @@ device_get_internal_name(const device_t *dev)
     return dev->internal_name;
 }
 
+static uint32_t
+device_name_hash(const char *s)
+{
+    uint32_t hash = 0x811c9dc5;
+
+    while (*s)
+        hash = (hash ^ (uint8_t) *s++) * 0x01000193;
+
+    return hash;
+}
+
+static void
+device_name_index_build(device_name_index_t *index)
+{
+    const char *name;
+    int        *slots;
+    int         num  = 0;
+    int         size = 16;
+    int         h;
+
+    while (index->get_name(num) != NULL)
+        num++;
+
+    /* At most half full, so probe chains stay short. */
+    while (size < (num * 2))
+        size <<= 1;
+
+    slots = calloc(size, sizeof(int));
+
+    for (int c = 0; c < num; c++) {
+        name = index->get_name(c);
+        h    = device_name_hash(name) & (size - 1);
+
+        /* The first entry of a name wins, as with a scan of the table. */
+        while (slots[h] && strcmp(index->get_name(slots[h] - 1), name))
+            h = (h + 1) & (size - 1);
+
+        if (!slots[h])
+            slots[h] = c + 1;
+    }
+
+    index->mask  = size - 1;
+    index->slots = slots;
+}
+
+/* Returns the entry with internal name s, or -1 if there is none. */
+int
+device_name_index_find(device_name_index_t *index, const char *s)
+{
+    int h;
+
+    if (index->slots == NULL)
+        device_name_index_build(index);
+
+    h = device_name_hash(s) & index->mask;
+    while (index->slots[h]) {
+        if (!strcmp(index->get_name(index->slots[h] - 1), s))
+            return index->slots[h] - 1;
+
+        h = (h + 1) & index->mask;
+    }
+
+    return -1;
+}
+
 void *
 device_add(const device_t *dev)
 {
@@ -335,6 +403,17 @@ device_find_first_priv(uint32_t match_flags)
     return ret;
 }
 
+const device_t *
+device_find_by_priv(const void *priv)
+{
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] != NULL) && (device_priv[c] == priv))
+            return devices[c];
+    }
+
+    return NULL;
+}
+
 void *
 device_get_priv(const device_t *dev)
 {
@@ -578,6 +657,20 @@ device_force_redraw(void)
     }
 }
 
+void
+device_snapshot_all(snapshot_t *snap)
+{
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if (devices[c] != NULL) {
+            if (devices[c]->snapshot != NULL)
+                snapshot_device(snap, devices[c]->internal_name ? devices[c]->internal_name : devices[c]->name,
+                                c, devices[c]->snapshot, device_priv[c]);
+            else if (!snapshot_loading(snap))
+                pclog("Snapshot: device \"%s\" has no state handler\n", devices[c]->name);
+        }
+    }
+}
+
 int
 device_get_instance(void)
 {
@@ -842,3 +935,64 @@ device_context_get_device(void)
 {
     return device_current.dev;
 }
+
+/*
+ * Devices that have slow work to do before they are of any use, such
+ * as loading sound fonts or synthesizer ROMs, hand it to a task at init
+ * time. The tasks of all the devices being added run side by side while
+ * the rest of the machine comes up; the device waits for its own task
+ * when it is first used for real, and at the latest when it is closed.
+ * A task must not call the device_get_config_*() functions, the device
+ * context is long gone by the time it runs.
+ */
+struct device_task_t {
+    thread_t   *thread;
+    atomic_int  done;
+    void      (*func)(void *priv);
+    void       *priv;
+};
+
+static void
+device_task_thread(void *priv)
+{
+    device_task_t *task = (device_task_t *) priv;
+
+    task->func(task->priv);
+    atomic_store(&task->done, 1);
+}
+
+device_task_t *
+device_task_start(void (*func)(void *priv), void *priv)
+{
+    device_task_t *task = calloc(1, sizeof(device_task_t));
+
+    task->func   = func;
+    task->priv   = priv;
+    task->thread = thread_create(device_task_thread, task);
+    if (task->thread == NULL) {
+        /* No thread to be had, do the work here and now. */
+        device_task_thread(task);
+    }
+
+    return task;
+}
+
+/* Returns 1 once the work is finished; never blocks. */
+int
+device_task_done(device_task_t *task)
+{
+    return (task == NULL) || atomic_load(&task->done);
+}
+
+/* Waits for the work to finish and frees the task. */
+void
+device_task_wait(device_task_t **task)
+{
+    if (*task == NULL)
+        return;
+
+    if ((*task)->thread != NULL)
+        thread_wait((*task)->thread);
+    free(*task);
+    *task = NULL;
+}
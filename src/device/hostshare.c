@@ -0,0 +1,806 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Paravirtual host file share.
+ *          See doc/specifications/86box-host-share.md for more info.
+ *          If modifying the protocol, you MUST modify the specification
+ *          and increment the version number.
+ *
+ *          Exposes a host directory to the guest through a ring of file
+ *          requests in guest memory. A write to the doorbell register
+ *          runs every request queued since the last one, before the I/O
+ *          write returns, with file data copied straight between the
+ *          host file and guest memory; there is no emulated hardware
+ *          timing involved. The guest side is a DOS redirector or a
+ *          Windows file system driver talking this protocol.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#ifndef _LARGEFILE64_SOURCE
+#    define _LARGEFILE64_SOURCE
+#endif
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <wchar.h>
+#ifdef _WIN32
+#    include <direct.h>
+#else
+#    include <unistd.h>
+#endif
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/io.h>
+#include <86box/mem.h>
+#include <86box/dma.h>
+#include <86box/device.h>
+#include <86box/path.h>
+#include <86box/plat.h>
+#include <86box/plat_dir.h>
+#include <86box/plat_unused.h>
+#include <86box/hostshare.h>
+
+#ifndef S_ISDIR
+#    define S_ISDIR(m) (((m) &S_IFMT) == S_IFDIR)
+#endif
+#ifndef S_IWUSR
+#    define S_IWUSR S_IWRITE
+#endif
+
+#ifdef _WIN32
+#    define stat  _stat64
+#    define rmdir _rmdir
+typedef struct __stat64 stat_t;
+#else
+typedef struct stat stat_t;
+#endif
+
+#define HS_SIGNATURE    0x53483638 /* "86HS" */
+#define HS_VERSION      1
+#define HS_HANDLES      32
+#define HS_RING_MAX     8 /* log2 of the largest ring, in requests */
+#define HS_NAME_MAX     260
+#define HS_PATH_MAX     1024
+#define HS_CHUNK        65536
+#define HS_STAT_SIZE    16
+
+/* Registers */
+#define HS_REG_SIGNATURE 0x00
+#define HS_REG_VERSION   0x04
+#define HS_REG_STATUS    0x05
+#define HS_REG_HANDLES   0x06
+#define HS_REG_RING      0x08
+#define HS_REG_RING_SIZE 0x0c
+#define HS_REG_DOORBELL  0x0d
+#define HS_REG_RESET     0x0e
+
+/* Status register bits */
+#define HS_STATUS_PRESENT   (1 << 0)
+#define HS_STATUS_READ_ONLY (1 << 1)
+
+/* Requests */
+enum hostshare_op {
+    HS_OP_NOP     = 0x00,
+    HS_OP_OPEN    = 0x01,
+    HS_OP_CLOSE   = 0x02,
+    HS_OP_READ    = 0x03,
+    HS_OP_WRITE   = 0x04,
+    HS_OP_STAT    = 0x05,
+    HS_OP_READDIR = 0x06,
+    HS_OP_MKDIR   = 0x07,
+    HS_OP_DELETE  = 0x08,
+    HS_OP_RENAME  = 0x09,
+};
+
+/* Open flags */
+#define HS_OPEN_WRITE    (1 << 0)
+#define HS_OPEN_CREATE   (1 << 1)
+#define HS_OPEN_TRUNCATE (1 << 2)
+
+/* Request completion status */
+enum hostshare_status {
+    HS_OK         = 0x00,
+    HS_INVALID    = 0x01,
+    HS_NOT_FOUND  = 0x02,
+    HS_DENIED     = 0x03,
+    HS_EXISTS     = 0x04,
+    HS_NO_HANDLES = 0x05,
+    HS_IO_ERROR   = 0x06,
+    HS_READ_ONLY  = 0x07,
+    HS_NO_MORE    = 0x08,
+    HS_BAD_HANDLE = 0x09,
+};
+
+/* One ring entry, as laid out in guest memory. */
+typedef struct hostshare_req_t {
+    uint8_t  op;
+    uint8_t  flags;
+    uint16_t status;
+    uint32_t handle;
+    uint32_t length;
+    uint32_t buffer;
+    uint64_t offset;
+    uint32_t name;
+    uint32_t result;
+} hostshare_req_t;
+
+/* Ring header: producer, consumer, reserved. */
+#define HS_RING_HEADER 16
+
+typedef struct hostshare_t {
+    uint16_t base;
+    int      read_only;
+    char     root[HS_PATH_MAX];
+
+    uint32_t ring;
+    uint8_t  ring_size;
+    uint32_t ring_latch;
+
+    FILE *files[HS_HANDLES];
+
+    /* Directory being listed, to carry on from the last entry handed out. */
+    DIR     *dir;
+    char     dir_path[HS_PATH_MAX];
+    uint64_t dir_index;
+
+    uint8_t buf[HS_CHUNK];
+} hostshare_t;
+
+#ifdef ENABLE_HOSTSHARE_LOG
+int hostshare_do_log = ENABLE_HOSTSHARE_LOG;
+
+static void
+hostshare_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (hostshare_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define hostshare_log(fmt, ...)
+#endif
+
+static int
+hostshare_errno(void)
+{
+    switch (errno) {
+        case ENOENT:
+        case ENOTDIR:
+            return HS_NOT_FOUND;
+        case EACCES:
+        case EPERM:
+        case ENOTEMPTY:
+        case EISDIR:
+            return HS_DENIED;
+        case EEXIST:
+            return HS_EXISTS;
+        case EMFILE:
+        case ENFILE:
+            return HS_NO_HANDLES;
+        default:
+            return HS_IO_ERROR;
+    }
+}
+
+static void
+hostshare_dir_close(hostshare_t *dev)
+{
+    if (dev->dir != NULL)
+        closedir(dev->dir);
+    dev->dir         = NULL;
+    dev->dir_path[0] = '\0';
+}
+
+static void
+hostshare_close_all(hostshare_t *dev)
+{
+    for (int i = 0; i < HS_HANDLES; i++) {
+        if (dev->files[i] != NULL)
+            fclose(dev->files[i]);
+        dev->files[i] = NULL;
+    }
+
+    hostshare_dir_close(dev);
+}
+
+/*
+ * Turns a guest path, relative to the share, into a host path. Either
+ * separator is taken, ".." and drive letters are refused, and each part
+ * that does not exist as given is looked up without regard to case, for
+ * the benefit of DOS guests on case sensitive hosts.
+ */
+static int
+hostshare_path(hostshare_t *dev, uint32_t addr, char *out)
+{
+    char           name[HS_NAME_MAX + 1];
+    char          *part;
+    char          *next;
+    size_t         len;
+    stat_t         st;
+    DIR           *dirp;
+    struct dirent *de;
+
+    dma_bm_read(addr, (uint8_t *) name, HS_NAME_MAX, 1);
+    name[HS_NAME_MAX] = '\0';
+    if (strlen(name) == HS_NAME_MAX)
+        return HS_INVALID;
+
+    for (char *p = name; *p != '\0'; p++) {
+        if (*p == '\\')
+            *p = '/';
+        else if (*p == ':')
+            return HS_INVALID;
+    }
+
+    strcpy(out, dev->root);
+    for (part = name; part != NULL; part = next) {
+        next = strchr(part, '/');
+        if (next != NULL)
+            *next++ = '\0';
+
+        if ((part[0] == '\0') || !strcmp(part, "."))
+            continue;
+        if (!strcmp(part, ".."))
+            return HS_INVALID;
+
+        len = strlen(out);
+        if ((len + strlen(part) + 2) > HS_PATH_MAX)
+            return HS_INVALID;
+        path_slash(out);
+        strcat(out, part);
+
+        if (stat(out, &st) == 0)
+            continue;
+
+        out[len] = '\0';
+        dirp = opendir(out);
+        if (dirp != NULL) {
+            while ((de = readdir(dirp)) != NULL) {
+                if (!stricmp(de->d_name, part)) {
+                    strcpy(part, de->d_name);
+                    break;
+                }
+            }
+            closedir(dirp);
+        }
+        path_slash(out);
+        strcat(out, part);
+    }
+
+    return HS_OK;
+}
+
+/* Size, attributes and DOS date and time of a host file. */
+static void
+hostshare_stat_info(const stat_t *st, uint8_t *info)
+{
+    uint64_t   size = S_ISDIR(st->st_mode) ? 0 : (uint64_t) st->st_size;
+    uint32_t   attr = S_ISDIR(st->st_mode) ? 0x01 : 0x00;
+    uint32_t   dos  = 0;
+    time_t     t    = st->st_mtime;
+    struct tm *tm   = localtime(&t);
+
+    if (!(st->st_mode & S_IWUSR))
+        attr |= 0x02;
+
+    if ((tm != NULL) && (tm->tm_year >= 80))
+        dos = ((uint32_t) (tm->tm_year - 80) << 25) | ((uint32_t) (tm->tm_mon + 1) << 21) |
+              ((uint32_t) tm->tm_mday << 16) | ((uint32_t) tm->tm_hour << 11) |
+              ((uint32_t) tm->tm_min << 5) | ((uint32_t) tm->tm_sec >> 1);
+
+    memcpy(&info[0], &size, 8);
+    memcpy(&info[8], &attr, 4);
+    memcpy(&info[12], &dos, 4);
+}
+
+static int
+hostshare_open(hostshare_t *dev, hostshare_req_t *req)
+{
+    char        path[HS_PATH_MAX];
+    const char *mode;
+    stat_t      st;
+    int         handle;
+    int         ret;
+
+    if ((req->flags & (HS_OPEN_WRITE | HS_OPEN_CREATE | HS_OPEN_TRUNCATE)) && dev->read_only)
+        return HS_READ_ONLY;
+
+    for (handle = 0; handle < HS_HANDLES; handle++) {
+        if (dev->files[handle] == NULL)
+            break;
+    }
+    if (handle == HS_HANDLES)
+        return HS_NO_HANDLES;
+
+    if ((ret = hostshare_path(dev, req->name, path)) != HS_OK)
+        return ret;
+
+    if (stat(path, &st) == 0) {
+        if (S_ISDIR(st.st_mode))
+            return HS_DENIED;
+    } else if (!(req->flags & HS_OPEN_CREATE))
+        return HS_NOT_FOUND;
+    else {
+        /* Created empty, then opened like any other. */
+        FILE *fp = plat_fopen(path, "wb");
+
+        if (fp == NULL)
+            return hostshare_errno();
+        fclose(fp);
+    }
+
+    if (req->flags & HS_OPEN_TRUNCATE)
+        mode = "w+b";
+    else if (req->flags & HS_OPEN_WRITE)
+        mode = "r+b";
+    else
+        mode = "rb";
+
+    dev->files[handle] = plat_fopen64(path, mode);
+    if (dev->files[handle] == NULL)
+        return hostshare_errno();
+
+    fseeko64(dev->files[handle], 0, SEEK_END);
+    req->handle = handle;
+    req->result = (uint32_t) ftello64(dev->files[handle]);
+
+    hostshare_log("HOSTSHARE: open %s (%02X) = %i\n", path, req->flags, handle);
+    return HS_OK;
+}
+
+static int
+hostshare_rw(hostshare_t *dev, hostshare_req_t *req, int write)
+{
+    FILE    *fp;
+    uint32_t done = 0;
+    uint32_t chunk;
+    size_t   n;
+    int      ret;
+
+    if ((req->handle >= HS_HANDLES) || (dev->files[req->handle] == NULL))
+        return HS_BAD_HANDLE;
+    if (write && dev->read_only)
+        return HS_READ_ONLY;
+
+    fp = dev->files[req->handle];
+    if (fseeko64(fp, (int64_t) req->offset, SEEK_SET) != 0)
+        return HS_IO_ERROR;
+
+    while (done < req->length) {
+        chunk = req->length - done;
+        if (chunk > HS_CHUNK)
+            chunk = HS_CHUNK;
+
+        if (write) {
+            dma_bm_read(req->buffer + done, dev->buf, chunk, 4);
+            n = fwrite(dev->buf, 1, chunk, fp);
+        } else {
+            n = fread(dev->buf, 1, chunk, fp);
+            if (n > 0) {
+                dma_bm_write(req->buffer + done, dev->buf, n, 4);
+                mem_invalidate_range(req->buffer + done, req->buffer + done + n - 1);
+            }
+        }
+
+        done += n;
+        if (n < chunk)
+            break;
+    }
+
+    ret         = (write && (done < req->length)) ? HS_IO_ERROR : HS_OK;
+    req->length = done;
+
+    return ret;
+}
+
+static int
+hostshare_stat(hostshare_t *dev, hostshare_req_t *req)
+{
+    char    path[HS_PATH_MAX];
+    uint8_t info[HS_STAT_SIZE];
+    stat_t  st;
+    int     ret;
+
+    if ((ret = hostshare_path(dev, req->name, path)) != HS_OK)
+        return ret;
+    if (stat(path, &st) != 0)
+        return hostshare_errno();
+
+    hostshare_stat_info(&st, info);
+    if (req->length > HS_STAT_SIZE)
+        req->length = HS_STAT_SIZE;
+    dma_bm_write(req->buffer, info, req->length, 1);
+    req->result = (uint32_t) st.st_size;
+
+    return HS_OK;
+}
+
+/* Next entry of the directory being listed, "." and ".." left out. */
+static struct dirent *
+hostshare_dir_next(hostshare_t *dev)
+{
+    struct dirent *de;
+
+    do {
+        de = readdir(dev->dir);
+    } while ((de != NULL) && (de->d_name[0] == '.') &&
+             ((de->d_name[1] == '\0') || !strcmp(de->d_name, "..")));
+
+    return de;
+}
+
+/* Entry number offset of a directory, as its information followed by its name. */
+static int
+hostshare_readdir(hostshare_t *dev, hostshare_req_t *req)
+{
+    char           path[HS_PATH_MAX];
+    char           file[HS_PATH_MAX];
+    stat_t         st;
+    struct dirent *de;
+    size_t         len;
+    int            ret;
+
+    if ((ret = hostshare_path(dev, req->name, path)) != HS_OK)
+        return ret;
+    if (req->length < (HS_STAT_SIZE + 2))
+        return HS_INVALID;
+
+    /* Carry on if this is the next entry of the same directory, start over otherwise. */
+    if ((dev->dir == NULL) || strcmp(dev->dir_path, path) || (req->offset != dev->dir_index)) {
+        hostshare_dir_close(dev);
+        dev->dir = opendir(path);
+        if (dev->dir == NULL)
+            return hostshare_errno();
+        strcpy(dev->dir_path, path);
+        dev->dir_index = 0;
+    }
+
+    do {
+        de = hostshare_dir_next(dev);
+        if (de == NULL) {
+            hostshare_dir_close(dev);
+            return HS_NO_MORE;
+        }
+    } while (dev->dir_index++ < req->offset);
+
+    path_append_filename(file, path, de->d_name);
+    if (stat(file, &st) != 0)
+        memset(&st, 0x00, sizeof(st));
+    hostshare_stat_info(&st, dev->buf);
+
+    len = strlen(de->d_name);
+    if (len > (req->length - HS_STAT_SIZE - 1))
+        len = req->length - HS_STAT_SIZE - 1;
+    memcpy(&dev->buf[HS_STAT_SIZE], de->d_name, len);
+    dev->buf[HS_STAT_SIZE + len] = '\0';
+
+    req->length = (uint32_t) (HS_STAT_SIZE + len + 1);
+    dma_bm_write(req->buffer, dev->buf, req->length, 1);
+    req->result = (uint32_t) st.st_size;
+
+    return HS_OK;
+}
+
+static int
+hostshare_modify(hostshare_t *dev, hostshare_req_t *req)
+{
+    char   path[HS_PATH_MAX];
+    char   path2[HS_PATH_MAX];
+    stat_t st;
+    int    ret;
+
+    if (dev->read_only)
+        return HS_READ_ONLY;
+    if ((ret = hostshare_path(dev, req->name, path)) != HS_OK)
+        return ret;
+
+    /* A listing in progress may be about to change under us. */
+    hostshare_dir_close(dev);
+
+    switch (req->op) {
+        case HS_OP_MKDIR:
+            if (stat(path, &st) == 0)
+                return HS_EXISTS;
+            if (plat_dir_create(path) != 0)
+                return hostshare_errno();
+            break;
+
+        case HS_OP_DELETE:
+            if (stat(path, &st) != 0)
+                return hostshare_errno();
+            if (S_ISDIR(st.st_mode) ? rmdir(path) : remove(path))
+                return hostshare_errno();
+            break;
+
+        case HS_OP_RENAME:
+            if ((ret = hostshare_path(dev, req->buffer, path2)) != HS_OK)
+                return ret;
+            if (stat(path2, &st) == 0)
+                return HS_EXISTS;
+            if (rename(path, path2) != 0)
+                return hostshare_errno();
+            break;
+
+        default:
+            return HS_INVALID;
+    }
+
+    return HS_OK;
+}
+
+static int
+hostshare_request(hostshare_t *dev, hostshare_req_t *req)
+{
+    if (dev->root[0] == '\0')
+        return HS_NOT_FOUND;
+
+    switch (req->op) {
+        case HS_OP_NOP:
+            return HS_OK;
+
+        case HS_OP_OPEN:
+            return hostshare_open(dev, req);
+
+        case HS_OP_CLOSE:
+            if ((req->handle >= HS_HANDLES) || (dev->files[req->handle] == NULL))
+                return HS_BAD_HANDLE;
+            fclose(dev->files[req->handle]);
+            dev->files[req->handle] = NULL;
+            return HS_OK;
+
+        case HS_OP_READ:
+        case HS_OP_WRITE:
+            return hostshare_rw(dev, req, req->op == HS_OP_WRITE);
+
+        case HS_OP_STAT:
+            return hostshare_stat(dev, req);
+
+        case HS_OP_READDIR:
+            return hostshare_readdir(dev, req);
+
+        case HS_OP_MKDIR:
+        case HS_OP_DELETE:
+        case HS_OP_RENAME:
+            return hostshare_modify(dev, req);
+
+        default:
+            return HS_INVALID;
+    }
+}
+
+/* Runs every request queued since the last doorbell, at most a ring's worth. */
+static void
+hostshare_doorbell(hostshare_t *dev)
+{
+    hostshare_req_t req;
+    uint32_t        mask = (1 << dev->ring_size) - 1;
+    uint32_t        producer;
+    uint32_t        consumer;
+    uint32_t        addr;
+
+    if (dev->ring == 0)
+        return;
+
+    dma_bm_read(dev->ring, (uint8_t *) &producer, 4, 4);
+    dma_bm_read(dev->ring + 4, (uint8_t *) &consumer, 4, 4);
+
+    for (uint32_t n = 0; (consumer != producer) && (n <= mask); n++) {
+        addr = dev->ring + HS_RING_HEADER + ((consumer & mask) * sizeof(hostshare_req_t));
+        dma_bm_read(addr, (uint8_t *) &req, sizeof(req), 4);
+
+        req.status = hostshare_request(dev, &req);
+        hostshare_log("HOSTSHARE: request %08X: op %02X, status %02X\n", consumer, req.op, req.status);
+
+        dma_bm_write(addr, (uint8_t *) &req, sizeof(req), 4);
+        consumer++;
+    }
+
+    dma_bm_write(dev->ring + 4, (uint8_t *) &consumer, 4, 4);
+}
+
+static void
+hostshare_write(uint16_t port, uint8_t val, void *priv)
+{
+    hostshare_t *dev = (hostshare_t *) priv;
+    int          reg = port - dev->base;
+
+    switch (reg) {
+        case HS_REG_RING:
+        case HS_REG_RING + 1:
+        case HS_REG_RING + 2:
+        case HS_REG_RING + 3:
+            dev->ring_latch &= ~(0xff << ((reg & 3) << 3));
+            dev->ring_latch |= (uint32_t) val << ((reg & 3) << 3);
+            dev->ring = dev->ring_latch & ~0x0f;
+            break;
+
+        case HS_REG_RING_SIZE:
+            dev->ring_size = (val > HS_RING_MAX) ? HS_RING_MAX : val;
+            break;
+
+        case HS_REG_DOORBELL:
+            hostshare_doorbell(dev);
+            break;
+
+        case HS_REG_RESET:
+            hostshare_close_all(dev);
+            if (dev->ring != 0) {
+                uint32_t zero = 0;
+
+                dma_bm_write(dev->ring + 4, (uint8_t *) &zero, 4, 4);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static uint8_t
+hostshare_read(uint16_t port, void *priv)
+{
+    const hostshare_t *dev = (hostshare_t *) priv;
+    int                reg = port - dev->base;
+    uint8_t            ret = 0xff;
+
+    switch (reg) {
+        case HS_REG_SIGNATURE:
+        case HS_REG_SIGNATURE + 1:
+        case HS_REG_SIGNATURE + 2:
+        case HS_REG_SIGNATURE + 3:
+            ret = (HS_SIGNATURE >> ((reg & 3) << 3)) & 0xff;
+            break;
+
+        case HS_REG_VERSION:
+            ret = HS_VERSION;
+            break;
+
+        case HS_REG_STATUS:
+            ret = (dev->root[0] != '\0') ? HS_STATUS_PRESENT : 0x00;
+            if (dev->read_only)
+                ret |= HS_STATUS_READ_ONLY;
+            break;
+
+        case HS_REG_HANDLES:
+            ret = HS_HANDLES;
+            break;
+
+        case HS_REG_RING:
+        case HS_REG_RING + 1:
+        case HS_REG_RING + 2:
+        case HS_REG_RING + 3:
+            ret = (dev->ring_latch >> ((reg & 3) << 3)) & 0xff;
+            break;
+
+        case HS_REG_RING_SIZE:
+            ret = dev->ring_size;
+            break;
+
+        default:
+            break;
+    }
+
+    return ret;
+}
+
+static void
+hostshare_reset(void *priv)
+{
+    hostshare_t *dev = (hostshare_t *) priv;
+
+    hostshare_close_all(dev);
+    dev->ring       = 0;
+    dev->ring_latch = 0;
+    dev->ring_size  = 0;
+}
+
+static void *
+hostshare_init(UNUSED(const device_t *info))
+{
+    hostshare_t *dev = (hostshare_t *) calloc(1, sizeof(hostshare_t));
+    const char  *root;
+    stat_t       st;
+
+    dev->base      = device_get_config_hex16("base");
+    dev->read_only = device_get_config_int("read_only");
+
+    root = device_get_config_string("path");
+    if ((root != NULL) && (root[0] != '\0') && (strlen(root) < (HS_PATH_MAX - HS_NAME_MAX))) {
+        if ((stat(root, &st) == 0) && S_ISDIR(st.st_mode))
+            strcpy(dev->root, root);
+        else
+            pclog("HOSTSHARE: %s is not a directory, nothing shared\n", root);
+    }
+
+    io_sethandler(dev->base, 16, hostshare_read, NULL, NULL, hostshare_write, NULL, NULL, dev);
+
+    hostshare_log("HOSTSHARE: sharing \"%s\" at %04X%s\n", dev->root, dev->base, dev->read_only ? ", read-only" : "");
+
+    return dev;
+}
+
+static void
+hostshare_close(void *priv)
+{
+    hostshare_t *dev = (hostshare_t *) priv;
+
+    io_removehandler(dev->base, 16, hostshare_read, NULL, NULL, hostshare_write, NULL, NULL, dev);
+    hostshare_close_all(dev);
+
+    free(dev);
+}
+
+static const device_config_t hostshare_config[] = {
+  // clang-format off
+    {
+        .name = "base",
+        .description = "Address",
+        .type = CONFIG_HEX16,
+        .default_string = "",
+        .default_int = 0x02a0,
+        .file_filter = "",
+        .spinner = { 0 },
+        .selection = {
+            { .description = "280H", .value = 0x0280 },
+            { .description = "2A0H", .value = 0x02a0 },
+            { .description = "2C0H", .value = 0x02c0 },
+            { .description = "2E0H", .value = 0x02e0 },
+            { .description = ""                      }
+        },
+    },
+    {
+        .name = "path",
+        .description = "Host directory",
+        .type = CONFIG_STRING,
+        .default_string = "",
+        .default_int = 0,
+        .file_filter = "",
+        .spinner = { 0 },
+        .selection = { { 0 } }
+    },
+    {
+        .name = "read_only",
+        .description = "Read-only",
+        .type = CONFIG_BINARY,
+        .default_string = "",
+        .default_int = 0,
+        .file_filter = "",
+        .spinner = { 0 },
+        .selection = { { 0 } }
+    },
+    { .name = "", .description = "", .type = CONFIG_END }
+  // clang-format on
+};
+
+const device_t hostshare_device = {
+    .name          = "86Box Host File Share",
+    .internal_name = "hostshare",
+    .flags         = DEVICE_ISA,
+    .local         = 0,
+    .init          = hostshare_init,
+    .close         = hostshare_close,
+    .reset         = hostshare_reset,
+    { .available = NULL },
+    .speed_changed = NULL,
+    .force_redraw  = NULL,
+    .config        = hostshare_config,
+};
@@ -32,6 +32,7 @@ typedef struct _i2c_ {
     uint8_t (*read)(void *bus, uint8_t addr, void *priv);
     uint8_t (*write)(void *bus, uint8_t addr, uint8_t data, void *priv);
     void (*stop)(void *bus, uint8_t addr, void *priv);
+    void (*read_block)(void *bus, uint8_t addr, uint8_t *data, int len, void *priv);
 
     void *priv;
 
@@ -202,6 +203,27 @@ i2c_handler(int set, void *bus_handle, uint8_t base, int size,
         i2c_removehandler(bus_handle, base, size, start, read, write, stop, priv);
 }
 
+/* Optional: lets the device with the given handlers hand over a run of
+   read bytes in one go, instead of one read() call per byte. */
+void
+i2c_set_read_block(void *bus_handle, uint8_t base, int size,
+                   void (*read_block)(void *bus, uint8_t addr, uint8_t *data, int len, void *priv),
+                   void *priv)
+{
+    i2c_t     *p;
+    i2c_bus_t *bus = (i2c_bus_t *) bus_handle;
+
+    if (!bus_handle || ((base + size) > NADDRS))
+        return;
+
+    for (int c = 0; c < size; c++) {
+        for (p = bus->devices[base + c]; p; p = p->next) {
+            if (p->priv == priv)
+                p->read_block = read_block;
+        }
+    }
+}
+
 uint8_t
 i2c_start(void *bus_handle, uint8_t addr, uint8_t read)
 {
@@ -278,6 +300,66 @@ i2c_write(void *bus_handle, uint8_t addr, uint8_t data)
     return ret;
 }
 
+/* Reads len bytes in a row, as that many i2c_read() calls would. */
+void
+i2c_read_block(void *bus_handle, uint8_t addr, uint8_t *data, int len)
+{
+    const i2c_bus_t *bus = (i2c_bus_t *) bus_handle;
+    i2c_t           *p   = NULL;
+
+    if (len <= 0)
+        return;
+
+    if (bus) {
+        for (p = bus->devices[addr]; p; p = p->next) {
+            if (p->read)
+                break;
+        }
+    }
+
+    if (!p)
+        memset(data, 0x00, len);
+    else if (p->read_block)
+        p->read_block(bus_handle, addr, data, len, p->priv);
+    else {
+        for (int i = 0; i < len; i++)
+            data[i] = p->read(bus_handle, addr, p->priv);
+    }
+
+    i2c_log("I2C %s: read_block(%02X, %d)\n", bus ? bus->name : "", addr, len);
+}
+
+/* Writes up to len bytes in a row, as that many i2c_write() calls would,
+   stopping at the first byte not acknowledged. Returns the number of bytes
+   acknowledged. */
+int
+i2c_write_block(void *bus_handle, uint8_t addr, const uint8_t *data, int len)
+{
+    const i2c_bus_t *bus = (i2c_bus_t *) bus_handle;
+    const i2c_t     *first;
+    const i2c_t     *p;
+    uint8_t          ack;
+    int              i;
+
+    if (!bus)
+        return 0;
+
+    first = bus->devices[addr];
+    for (i = 0; i < len; i++) {
+        ack = 0;
+        for (p = first; p; p = p->next) {
+            if (p->write)
+                ack |= p->write(bus_handle, addr, data[i], p->priv);
+        }
+        if (!ack)
+            break;
+    }
+
+    i2c_log("I2C %s: write_block(%02X, %d) = %d\n", bus->name, addr, len, i);
+
+    return i;
+}
+
 void
 i2c_stop(void *bus_handle, uint8_t addr)
 {
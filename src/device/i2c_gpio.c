@@ -89,6 +89,12 @@ i2c_gpio_set(void *dev_handle, uint8_t scl, uint8_t sda)
 {
     i2c_gpio_t *dev = (i2c_gpio_t *) dev_handle;
 
+    /* Drivers rewrite the same levels while they wait out bit times or
+       change other bits of the same register; without an edge there is
+       nothing to do. */
+    if ((scl == dev->prev_scl) && (sda == dev->prev_sda))
+        return;
+
     i2c_gpio_log(3, "I2C GPIO %s: write scl=%d->%d sda=%d->%d read=%d\n", dev->bus_name, dev->prev_scl, scl, dev->prev_sda, sda, dev->slave_read);
 
     if (dev->prev_scl && scl) {
@@ -93,6 +93,9 @@
 
 #define KBC_FLAG_IS_ASIC   0x80000000
 
+#define KBC_POLL_PERIOD    (100ULL * TIMER_USEC)
+#define KBC_IDLE_PERIOD    (10000ULL * TIMER_USEC)
+
 #define FLAG_CLOCK         0x01
 #define FLAG_CACHE         0x02
 #define FLAG_PS2           0x04
@@ -741,29 +744,76 @@ kbc_at_poll_ps2(atkbc_t *dev)
     }
 }
 
+/* While the controller and both ports have nothing to do, the two poll
+   timers drop to a slow rate; port accesses by the host bring them back at
+   once, input from the host side is picked up by the next slow poll. */
+static int
+kbc_at_port_idle(kbc_at_port_t *port)
+{
+    if ((port == NULL) || (port->priv == NULL))
+        return 1;
+
+    return (port->idle != NULL) && port->idle(port->priv);
+}
+
+static int
+kbc_at_idle(atkbc_t *dev)
+{
+    switch (dev->state) {
+        case STATE_RESET:
+        case STATE_MAIN_IBF:
+        case STATE_MAIN_KBD:
+        case STATE_MAIN_AUX:
+        case STATE_MAIN_BOTH:
+            break;
+        default:
+            return 0;
+    }
+
+    if ((dev->status & STAT_IFULL) || dev->do_irq)
+        return 0;
+
+    return kbc_at_port_idle(kbc_at_ports[0]) && kbc_at_port_idle(kbc_at_ports[1]);
+}
+
+static void
+kbc_at_wake(atkbc_t *dev)
+{
+    timer_wake_u64(&dev->kbc_poll_timer, KBC_POLL_PERIOD);
+    timer_wake_u64(&dev->kbc_dev_poll_timer, KBC_POLL_PERIOD);
+}
+
 static void
 kbc_at_poll(void *priv)
 {
-    atkbc_t *dev = (atkbc_t *) priv;
+    atkbc_t *dev  = (atkbc_t *) priv;
+    int      idle = kbc_at_idle(dev);
 
-    timer_advance_u64(&dev->kbc_poll_timer, (100ULL * TIMER_USEC));
+    timer_advance_u64(&dev->kbc_poll_timer, idle ? KBC_IDLE_PERIOD : KBC_POLL_PERIOD);
 
     /* TODO: Implement the password security state. */
     kbc_at_do_poll(dev);
+
+    if (!idle)
+        timer_wake_u64(&dev->kbc_dev_poll_timer, KBC_POLL_PERIOD);
 }
 
 static void
 kbc_at_dev_poll(void *priv)
 {
-    atkbc_t *dev = (atkbc_t *) priv;
+    atkbc_t *dev  = (atkbc_t *) priv;
+    int      idle = kbc_at_idle(dev);
 
-    timer_advance_u64(&dev->kbc_dev_poll_timer, (100ULL * TIMER_USEC));
+    timer_advance_u64(&dev->kbc_dev_poll_timer, idle ? KBC_IDLE_PERIOD : KBC_POLL_PERIOD);
 
     if ((kbc_at_ports[0] != NULL) && (kbc_at_ports[0]->priv != NULL))
         kbc_at_ports[0]->poll(kbc_at_ports[0]->priv);
 
     if ((kbc_at_ports[1] != NULL) && (kbc_at_ports[1]->priv != NULL))
         kbc_at_ports[1]->poll(kbc_at_ports[1]->priv);
+
+    if (!idle)
+        timer_wake_u64(&dev->kbc_poll_timer, KBC_POLL_PERIOD);
 }
 
 static void
@@ -2076,6 +2126,8 @@ kbc_at_write(uint16_t port, uint8_t val, void *priv)
 
     kbc_at_log("ATkbc: [%04X:%08X] write(%04X) = %02X\n", CS, cpu_state.pc, port, val);
 
+    kbc_at_wake(dev);
+
     switch (port) {
         case 0x60:
             dev->status &= ~STAT_CD;
@@ -2124,6 +2176,8 @@ kbc_at_read(uint16_t port, void *priv)
     if ((dev->flags & KBC_TYPE_MASK) >= KBC_TYPE_PS2_1)
         cycles -= ISA_CYCLES(8);
 
+    kbc_at_wake(dev);
+
     switch (port) {
         case 0x60:
             ret = dev->ob;
@@ -118,6 +118,10 @@ kbc_at_dev_poll(void *priv)
                 dev->state = DEV_STATE_MAIN_2;
             break;
         case DEV_STATE_MAIN_2:
+            /* Pull in more host input once the controller has taken the last byte. */
+            if ((dev->fill_queue != NULL) && !dev->ignore && *dev->scan && (dev->port->out_new == -1) &&
+                (dev->queue_start == dev->queue_end))
+                dev->input_waiting = dev->fill_queue(dev);
             /* Output from scan queue if needed and then return to main loop #1. */
             if (!dev->ignore && *dev->scan && (dev->port->out_new == -1) &&
                 (dev->queue_start != dev->queue_end)) {
@@ -176,6 +180,23 @@ kbc_at_dev_poll(void *priv)
     }
 }
 
+/* Waiting in the main loop with nothing to send. */
+static int
+kbc_at_dev_idle(void *priv)
+{
+    const atkbc_dev_t *dev = (atkbc_dev_t *) priv;
+
+    if ((dev->state != DEV_STATE_MAIN_1) && (dev->state != DEV_STATE_MAIN_2) &&
+        (dev->state != DEV_STATE_MAIN_IN))
+        return 0;
+
+    if (dev->port->wantcmd || (dev->port->out_new != -1) ||
+        (dev->cmd_queue_start != dev->cmd_queue_end))
+        return 0;
+
+    return ((dev->queue_start == dev->queue_end) && !dev->input_waiting) || dev->ignore || !(*dev->scan);
+}
+
 void
 kbc_at_dev_reset(atkbc_dev_t *dev, int do_fa)
 {
@@ -185,6 +206,7 @@ kbc_at_dev_reset(atkbc_dev_t *dev, int do_fa)
     kbc_at_dev_queue_reset(dev, 1);
 
     dev->last_scan_code = 0x00;
+    dev->input_waiting  = 0;
 
     *dev->scan = 1;
 
@@ -207,6 +229,7 @@ kbc_at_dev_init(uint8_t inst)
     if (dev->port != NULL) {
         dev->port->priv = dev;
         dev->port->poll = kbc_at_dev_poll;
+        dev->port->idle = kbc_at_dev_idle;
     }
 
     /* Return our private data to the I/O layer. */
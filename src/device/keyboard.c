@@ -20,11 +20,15 @@
  */
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
+#include <stdatomic.h>
 #include <86box/86box.h>
 #include <86box/machine.h>
 #include <86box/keyboard.h>
+#include <86box/mem.h>
+#include <86box/thread.h>
 
 #include "cpu.h"
 
@@ -57,6 +61,49 @@ static int keydelay[512];
 #endif
 static scancode *scan_table; /* scancode table for keyboard */
 
+/*
+ * Keystrokes come in from the UI and VNC threads and are handed to the
+ * emulated keyboard by the emulation thread, through a bounded lock-free
+ * queue. A slot is free for the producer at position pos when its seq
+ * equals pos, and holds an event for the consumer when it equals pos + 1;
+ * seq is kept minus the slot number so that the all-zero queue is the
+ * empty one.
+ */
+#define KEY_QUEUE_SIZE 256
+#define KEY_QUEUE_MASK (KEY_QUEUE_SIZE - 1)
+
+typedef struct key_event_t {
+    atomic_uint seq;
+    uint16_t    scan;
+    uint8_t     down;
+} key_event_t;
+
+static key_event_t key_queue[KEY_QUEUE_SIZE];
+static atomic_uint key_queue_head; /* next to fill, any thread */
+static uint32_t    key_queue_tail; /* next to hand over, emulation thread */
+
+/*
+ * Pasted text, as key events (scan code, bit 15 set on a press). The UI
+ * and VNC threads append, the emulation thread takes one event at a time:
+ * from keyboard_paste_poll() where the keyboard device asks for the next
+ * one as soon as the controller has taken everything before it, and the
+ * guest has read it, otherwise once per frame from keyboard_process().
+ */
+#define PASTE_MAX      (1 << 20)
+#define PASTE_BDA_FULL 8     /* keystrokes waiting in the BIOS buffer */
+#define PASTE_BDA_WAIT 20000 /* polls to wait on a BIOS buffer that does not drain */
+
+int keyboard_paste_paced = 0;
+
+static mutex_t    *paste_mutex;
+static uint16_t   *paste_buf;
+static uint32_t    paste_len;
+static uint32_t    paste_pos;
+static atomic_int  paste_pending;
+static int         paste_bda   = 1;
+static uint16_t    paste_bda_head;
+static uint32_t    paste_bda_wait;
+
 static uint8_t caps_lock   = 0;
 static uint8_t num_lock    = 0;
 static uint8_t scroll_lock = 0;
@@ -67,6 +114,9 @@ keyboard_init(void)
 {
     memset(recv_key, 0x00, sizeof(recv_key));
 
+    if (paste_mutex == NULL)
+        paste_mutex = thread_create_mutex();
+
     keyboard_scan = 1;
     scan_table    = NULL;
 
@@ -145,6 +195,33 @@ key_process(uint16_t scan, int down)
     }
 }
 
+static void
+key_queue_push(uint16_t scan, int down)
+{
+    key_event_t *ev;
+    uint32_t     pos = atomic_load_explicit(&key_queue_head, memory_order_relaxed);
+    int32_t      diff;
+
+    while (1) {
+        ev   = &key_queue[pos & KEY_QUEUE_MASK];
+        diff = (int32_t) (atomic_load_explicit(&ev->seq, memory_order_acquire) + (pos & KEY_QUEUE_MASK) - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&key_queue_head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            /* Full, the emulation is not keeping up (or is paused). */
+            return;
+        } else
+            pos = atomic_load_explicit(&key_queue_head, memory_order_relaxed);
+    }
+
+    ev->scan = scan;
+    ev->down = down;
+    atomic_store_explicit(&ev->seq, pos + 1 - (pos & KEY_QUEUE_MASK), memory_order_release);
+}
+
 /* Handle a keystroke event from the UI layer. */
 void
 keyboard_input(int down, uint16_t scan)
@@ -247,7 +324,169 @@ keyboard_input(int down, uint16_t scan)
     /* pclog("Received scan code: %03X (%s)\n", scan & 0x1ff, down ? "down" : "up"); */
     recv_key[scan & 0x1ff] = down;
 
-    key_process(scan & 0x1ff, down);
+    key_queue_push(scan & 0x1ff, down);
+}
+
+/* Hand the keystrokes queued by keyboard_input() to the emulated keyboard. */
+void
+keyboard_process(void)
+{
+    key_event_t *ev;
+    uint32_t     slot;
+
+    while (1) {
+        slot = key_queue_tail & KEY_QUEUE_MASK;
+        ev   = &key_queue[slot];
+        if ((atomic_load_explicit(&ev->seq, memory_order_acquire) + slot) != (key_queue_tail + 1))
+            break;
+
+        key_process(ev->scan, ev->down);
+
+        atomic_store_explicit(&ev->seq, key_queue_tail + KEY_QUEUE_SIZE - slot, memory_order_release);
+        key_queue_tail++;
+    }
+
+    if (!keyboard_paste_paced)
+        (void) keyboard_paste_poll();
+}
+
+/* US layout scan code of each printable ASCII character, bit 8 set if shifted. */
+static const uint16_t paste_ascii[0x5f] = {
+    0x039, 0x102, 0x128, 0x104, 0x105, 0x106, 0x108, 0x028, /*  !"#$%&' */
+    0x10a, 0x10b, 0x109, 0x10d, 0x033, 0x00c, 0x034, 0x035, /* ()*+,-./ */
+    0x00b, 0x002, 0x003, 0x004, 0x005, 0x006, 0x007, 0x008, /* 01234567 */
+    0x009, 0x00a, 0x127, 0x027, 0x133, 0x00d, 0x134, 0x135, /* 89:;<=>? */
+    0x103, 0x11e, 0x130, 0x12e, 0x120, 0x112, 0x121, 0x122, /* @ABCDEFG */
+    0x123, 0x117, 0x124, 0x125, 0x126, 0x132, 0x131, 0x118, /* HIJKLMNO */
+    0x119, 0x110, 0x113, 0x11f, 0x114, 0x116, 0x12f, 0x111, /* PQRSTUVW */
+    0x12d, 0x115, 0x12c, 0x01a, 0x02b, 0x01b, 0x107, 0x10c, /* XYZ[\]^_ */
+    0x029, 0x01e, 0x030, 0x02e, 0x020, 0x012, 0x021, 0x022, /* `abcdefg */
+    0x023, 0x017, 0x024, 0x025, 0x026, 0x032, 0x031, 0x018, /* hijklmno */
+    0x019, 0x010, 0x013, 0x01f, 0x014, 0x016, 0x02f, 0x011, /* pqrstuvw */
+    0x02d, 0x015, 0x02c, 0x11a, 0x12b, 0x11b, 0x129        /* xyz{|}~  */
+};
+
+/* Queue text (UTF-8, only its ASCII part is typed) to be typed in, US layout. */
+void
+keyboard_paste_text(const char *text)
+{
+    const uint8_t *p = (const uint8_t *) text;
+    uint16_t      *buf;
+    uint32_t       len;
+    uint16_t       key;
+    int            shifted;
+
+    if ((text == NULL) || (paste_mutex == NULL))
+        return;
+
+    thread_wait_mutex(paste_mutex);
+
+    /* Start over once everything pasted before has been typed. */
+    if (paste_pos == paste_len)
+        paste_pos = paste_len = 0;
+
+    /* Four events per character at most. */
+    len = paste_len + (strlen(text) * 4);
+    if (len > PASTE_MAX)
+        len = PASTE_MAX;
+    buf = (uint16_t *) realloc(paste_buf, len * sizeof(uint16_t));
+    if (buf == NULL) {
+        thread_release_mutex(paste_mutex);
+        return;
+    }
+    paste_buf = buf;
+
+    for (; (*p != '\0') && ((paste_len + 4) <= len); p++) {
+        if ((*p == '\r') || (*p == '\n')) {
+            /* CR LF is one Enter. */
+            if ((p[0] == '\r') && (p[1] == '\n'))
+                p++;
+            key = 0x01c;
+        } else if (*p == '\t')
+            key = 0x00f;
+        else if ((*p >= 0x20) && (*p < 0x7f))
+            key = paste_ascii[*p - 0x20];
+        else
+            continue;
+
+        /* Letters come out the other way around with Caps Lock on. */
+        shifted = !!(key & 0x100);
+        if (caps_lock && (((*p | 0x20) >= 'a') && ((*p | 0x20) <= 'z')))
+            shifted ^= 1;
+        key &= 0xff;
+
+        if (shifted)
+            paste_buf[paste_len++] = 0x802a;
+        paste_buf[paste_len++] = 0x8000 | key;
+        paste_buf[paste_len++] = key;
+        if (shifted)
+            paste_buf[paste_len++] = 0x002a;
+    }
+
+    paste_bda      = 1;
+    paste_bda_wait = 0;
+    atomic_store_explicit(&paste_pending, paste_pos != paste_len, memory_order_release);
+
+    thread_release_mutex(paste_mutex);
+}
+
+/*
+ * With a DOS or BIOS program reading the keyboard through the BIOS, a
+ * guest that takes scan codes as fast as they come still only buffers 16
+ * keystrokes; hold back while that buffer is half full. A buffer that does
+ * not drain for a while is taken as not being in use.
+ */
+static int
+keyboard_paste_bda_full(void)
+{
+    uint16_t start = mem_readw_phys(0x480);
+    uint16_t end   = mem_readw_phys(0x482);
+    uint16_t head  = mem_readw_phys(0x41a);
+    uint16_t tail  = mem_readw_phys(0x41c);
+
+    if (!paste_bda || (start >= end) || ((end - start) > 0x100) || (start & 1) ||
+        (head < start) || (head >= end) || (tail < start) || (tail >= end))
+        return 0;
+
+    if ((((tail - head + end - start) % (end - start)) >> 1) < PASTE_BDA_FULL) {
+        paste_bda_wait = 0;
+        return 0;
+    }
+
+    if (head != paste_bda_head) {
+        paste_bda_head = head;
+        paste_bda_wait = 0;
+    } else if (++paste_bda_wait >= PASTE_BDA_WAIT)
+        paste_bda = 0;
+
+    return paste_bda;
+}
+
+/* Type the next pasted key event; returns 1 while more are waiting. */
+int
+keyboard_paste_poll(void)
+{
+    uint16_t ev;
+    int      more;
+
+    if (!atomic_load_explicit(&paste_pending, memory_order_acquire))
+        return 0;
+
+    thread_wait_mutex(paste_mutex);
+
+    if (paste_pos != paste_len) {
+        ev = paste_buf[paste_pos];
+        if (!(ev & 0x8000) || !keyboard_paste_bda_full()) {
+            key_process(ev & 0x1ff, !!(ev & 0x8000));
+            paste_pos++;
+        }
+    }
+    more = (paste_pos != paste_len);
+    atomic_store_explicit(&paste_pending, more, memory_order_relaxed);
+
+    thread_release_mutex(paste_mutex);
+
+    return more;
 }
 
 static uint8_t
@@ -25,6 +25,7 @@
 #include <86box/device.h>
 #include <86box/keyboard.h>
 #include <86box/mouse.h>
+#include <86box/plat_unused.h>
 
 #define FLAG_PS2       0x08  /* dev is AT or PS/2 */
 #define FLAG_AT        0x00  /* dev is AT or PS/2 */
@@ -519,6 +520,13 @@ add_data_vals(atkbc_dev_t *dev, uint8_t *val, uint8_t len)
         kbc_at_dev_queue_add(dev, val[i], 1);
 }
 
+/* Pasted text goes in one key at a time, as fast as the guest takes it. */
+static int
+keyboard_at_fill_queue(UNUSED(void *priv))
+{
+    return keyboard_paste_poll();
+}
+
 static void
 add_data_kbd(uint16_t val)
 {
@@ -987,6 +995,7 @@ keyboard_at_init(const device_t *info)
 
     dev->process_cmd = keyboard_at_write;
     dev->execute_bat = keyboard_at_bat;
+    dev->fill_queue  = keyboard_at_fill_queue;
 
     dev->scan        = &keyboard_scan;
 
@@ -1000,6 +1009,8 @@ keyboard_at_init(const device_t *info)
     keyboard_send = add_data_kbd;
     SavedKbd = dev;
 
+    keyboard_paste_paced = 1;
+
     inv_cmd_response = (dev->type & FLAG_PS2) ? 0xfe : 0xfa;
 
     /* Return our private data to the I/O layer. */
@@ -1014,6 +1025,8 @@ keyboard_at_close(void *priv)
     keyboard_scan = 0;
     keyboard_send = NULL;
 
+    keyboard_paste_paced = 0;
+
     /* Disable the scancode maps. */
     keyboard_set_table(NULL);
 
@@ -200,10 +200,22 @@ mouse_scale_coord_y(double y, int mul)
     return y;
 }
 
+/* The host side adds movement while the emulated mouse takes it away, so
+   both go through a compare and swap, or one of them would get lost. */
+static void
+atomic_double_add(_Atomic double *var, double val)
+{
+    double temp = atomic_load(var);
+
+    while (!atomic_compare_exchange_weak(var, &temp, temp + val))
+        ;
+}
+
 void
 mouse_subtract_x(int *delta_x, int *o_x, int min, int max, int abs)
 {
-    double real_x = atomic_load(&mouse_x);
+    double start_x = atomic_load(&mouse_x);
+    double real_x  = start_x;
     double smax_x;
     double rsmin_x;
     double smin_x;
@@ -261,7 +273,7 @@ mouse_subtract_x(int *delta_x, int *o_x, int min, int max, int abs)
     if (abs)
         real_x -= rsmin_x;
 
-    atomic_store(&mouse_x, real_x);
+    atomic_double_add(&mouse_x, real_x - start_x);
 }
 
 /* It appears all host platforms give us y in the Microsoft format
@@ -270,7 +282,8 @@ mouse_subtract_x(int *delta_x, int *o_x, int min, int max, int abs)
 void
 mouse_subtract_y(int *delta_y, int *o_y, int min, int max, int invert, int abs)
 {
-    double real_y = atomic_load(&mouse_y);
+    double start_y = atomic_load(&mouse_y);
+    double real_y  = start_y;
     double smax_y;
     double rsmin_y;
     double smin_y;
@@ -334,7 +347,7 @@ mouse_subtract_y(int *delta_y, int *o_y, int min, int max, int invert, int abs)
     if (invert)
         real_y = -real_y;
 
-    atomic_store(&mouse_y, real_y);
+    atomic_double_add(&mouse_y, real_y - start_y);
 }
 
 /* It appears all host platforms give us y in the Microsoft format
@@ -407,16 +420,6 @@ mouse_timer_poll(UNUSED(void *priv))
 #endif
 }
 
-static void
-atomic_double_add(_Atomic double *var, double val)
-{
-    double temp = atomic_load(var);
-
-    temp += val;
-
-    atomic_store(var, temp);
-}
-
 void
 mouse_scale_fx(double x)
 {
@@ -493,7 +496,7 @@ mouse_subtract_z(int *delta_z, int min, int max, int invert)
         real_z = 0;
     }
 
-    atomic_store(&mouse_z, invert ? -real_z : real_z);
+    atomic_fetch_add(&mouse_z, (invert ? -real_z : real_z) - z);
 }
 
 void
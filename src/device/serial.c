@@ -161,8 +161,6 @@ serial_receive_timer(void *priv)
 
     serial_log("serial_receive_timer()\n");
 
-    timer_on_auto(&dev->receive_timer, /* dev->bits * */ dev->transmit_period);
-
     if (dev->fifo_enabled) {
         /* FIFO mode. */
         if (dev->out_new != 0xffff) {
@@ -213,6 +211,10 @@ write_fifo(serial_t *dev, uint8_t dat)
 
     /* Do this here, because in non-FIFO mode, this is read directly. */
     dev->out_new = (uint16_t) dat;
+
+    /* The receive timer only runs while there is a byte in the RSR. */
+    if (!timer_is_on(&dev->receive_timer))
+        timer_on_auto(&dev->receive_timer, /* dev->bits * */ dev->transmit_period);
 }
 
 void
@@ -357,7 +359,8 @@ static void
 serial_update_speed(serial_t *dev)
 {
     serial_log("serial_update_speed(%lf)\n", dev->transmit_period);
-    timer_on_auto(&dev->receive_timer, /* dev->bits * */ dev->transmit_period);
+    if (dev->out_new != 0xffff)
+        timer_on_auto(&dev->receive_timer, /* dev->bits * */ dev->transmit_period);
 
     if (dev->transmit_enabled & 3)
         timer_on_auto(&dev->transmit_timer, dev->transmit_period);
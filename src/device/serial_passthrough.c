@@ -17,6 +17,7 @@
  */
 
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -27,11 +28,27 @@
 #include <86box/device.h>
 #include <86box/fifo.h>
 #include <86box/timer.h>
+#include <86box/thread.h>
+#include <86box/plat.h>
 #include <86box/serial.h>
 #include <86box/serial_passthrough.h>
 #include <86box/plat_serial_passthrough.h>
 #include <86box/plat_unused.h>
 
+#define SERPT_RX_SIZE    4096 /* power of two */
+#define SERPT_RX_TIMEOUT 10   /* ms the reader waits for data before checking for close */
+#define SERPT_RX_POLL    1000 /* us between checks of an empty buffer */
+
+/* Filled by the reader thread, drained by the timer; one producer and one
+   consumer, the indices only ever grow. */
+typedef struct serpt_reader_s {
+    thread_t   *thread;
+    atomic_int  stop;
+    atomic_uint head;
+    atomic_uint tail;
+    uint8_t     buf[SERPT_RX_SIZE];
+} serpt_reader_t;
+
 #define ENABLE_SERIAL_PASSTHROUGH_LOG 1
 #ifdef ENABLE_SERIAL_PASSTHROUGH_LOG
 int serial_passthrough_do_log = ENABLE_SERIAL_PASSTHROUGH_LOG;
@@ -68,12 +85,46 @@ serial_passthrough_write(UNUSED(serial_t *s), void *priv, uint8_t val)
     plat_serpt_write(priv, val);
 }
 
+/* Reads from the host in bulk, so that an idle port costs one blocking
+   call per timeout instead of two system calls per character time. */
+static void
+serial_passthrough_reader_thread(void *priv)
+{
+    serial_passthrough_t *dev    = (serial_passthrough_t *) priv;
+    serpt_reader_t       *reader = dev->reader;
+    uint8_t               temp[256];
+    unsigned int          head;
+    unsigned int          space;
+    int                   n;
+
+    while (!atomic_load(&reader->stop)) {
+        head  = atomic_load_explicit(&reader->head, memory_order_relaxed);
+        space = SERPT_RX_SIZE - (head - atomic_load_explicit(&reader->tail, memory_order_acquire));
+        if (!space) {
+            plat_delay_ms(1);
+            continue;
+        }
+
+        n = plat_serpt_read_block(dev, temp, (space < sizeof(temp)) ? space : sizeof(temp), SERPT_RX_TIMEOUT);
+        for (int i = 0; i < n; i++)
+            reader->buf[(head + i) & (SERPT_RX_SIZE - 1)] = temp[i];
+        if (n > 0)
+            atomic_store_explicit(&reader->head, head + n, memory_order_release);
+    }
+}
+
 static void
 host_to_serial_cb(void *priv)
 {
-    serial_passthrough_t *dev = (serial_passthrough_t *) priv;
+    serial_passthrough_t *dev    = (serial_passthrough_t *) priv;
+    serpt_reader_t       *reader = dev->reader;
+    unsigned int          tail   = atomic_load_explicit(&reader->tail, memory_order_relaxed);
 
-    uint8_t byte;
+    /* Nothing from the host, look again later rather than every character time. */
+    if (atomic_load_explicit(&reader->head, memory_order_acquire) == tail) {
+        timer_on_auto(&dev->host_to_serial_timer, SERPT_RX_POLL);
+        return;
+    }
 
     /* write_fifo has no failure indication, but if we write to fast, the host
      * can never fetch the bytes in time, so check if the fifo is full if in
@@ -87,15 +138,11 @@ host_to_serial_cb(void *priv)
             goto no_write_to_machine;
         }
     }
-    if (plat_serpt_read(dev, &byte)) {
+    serial_write_fifo(dev->serial, reader->buf[tail & (SERPT_RX_SIZE - 1)]);
+    atomic_store_explicit(&reader->tail, tail + 1, memory_order_release);
 #if 0
-        printf("got byte %02X\n", byte);
-#endif
-        serial_write_fifo(dev->serial, byte);
-#if 0
-        serial_set_dsr(dev->serial, 1);
+    serial_set_dsr(dev->serial, 1);
 #endif
-    }
 no_write_to_machine:
 #if 0
     serial_device_timeout(dev->serial);
@@ -142,7 +189,13 @@ serial_passthrough_dev_close(void *priv)
     if (dev->serial && dev->serial->sd)
         memset(dev->serial->sd, 0, sizeof(serial_device_t));
 
+    if (dev->reader && dev->reader->thread) {
+        atomic_store(&dev->reader->stop, 1);
+        thread_wait(dev->reader->thread);
+    }
+
     plat_serpt_close(dev);
+    free(dev->reader);
     free(dev);
 }
 
@@ -209,6 +262,12 @@ serial_passthrough_dev_init(const device_t *info)
     }
     serial_passthrough_log("%s: running\n", info->name);
 
+    dev->reader = (serpt_reader_t *) calloc(1, sizeof(serpt_reader_t));
+    atomic_init(&dev->reader->stop, 0);
+    atomic_init(&dev->reader->head, 0);
+    atomic_init(&dev->reader->tail, 0);
+    dev->reader->thread = thread_create(serial_passthrough_reader_thread, dev);
+
     memset(&dev->host_to_serial_timer, 0, sizeof(pc_timer_t));
     timer_add(&dev->host_to_serial_timer, host_to_serial_cb, dev, 1);
     serial_set_cts(dev->serial, 1);
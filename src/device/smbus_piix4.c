@@ -105,6 +105,7 @@ smbus_piix4_write(uint16_t addr, uint8_t val, void *priv)
     uint8_t        prev_stat;
     uint16_t       timer_bytes = 0;
     uint16_t       i = 0;
+    uint8_t        block[256];
 
     smbus_piix4_log("SMBus PIIX4: write(%02X, %02X)\n", addr, val);
 
@@ -223,16 +224,16 @@ smbus_piix4_write(uint16_t addr, uint8_t val, void *priv)
                             /* block read [data0] (I2C) or [first byte] (SMBus) bytes */
                             if (cmd == 0x5)
                                 dev->data0 = i2c_read(i2c_smbus, smbus_addr);
+                            i2c_read_block(i2c_smbus, smbus_addr, block, dev->data0);
                             for (i = 0; i < dev->data0; i++)
-                                dev->data[i & SMBUS_PIIX4_BLOCK_DATA_MASK] = i2c_read(i2c_smbus, smbus_addr);
+                                dev->data[i & SMBUS_PIIX4_BLOCK_DATA_MASK] = block[i];
                         } else {
                             if (cmd == 0x5) /* send length [data0] as first byte on SMBus */
                                 i2c_write(i2c_smbus, smbus_addr, dev->data0);
                             /* block write [data0] bytes */
-                            for (i = 0; i < dev->data0; i++) {
-                                if (!i2c_write(i2c_smbus, smbus_addr, dev->data[i & SMBUS_PIIX4_BLOCK_DATA_MASK]))
-                                    break;
-                            }
+                            for (i = 0; i < dev->data0; i++)
+                                block[i] = dev->data[i & SMBUS_PIIX4_BLOCK_DATA_MASK];
+                            i = i2c_write_block(i2c_smbus, smbus_addr, block, dev->data0);
                         }
                         timer_bytes += i;
 
@@ -256,23 +257,24 @@ smbus_piix4_write(uint16_t addr, uint8_t val, void *priv)
 
                         /* block read [first byte] bytes */
                         block_len = dev->data[0];
+                        i2c_read_block(i2c_smbus, smbus_addr, block, block_len);
                         for (i = 0; i < block_len; i++)
-                            dev->data[i & SMBUS_PIIX4_BLOCK_DATA_MASK] = i2c_read(i2c_smbus, smbus_addr);
+                            dev->data[i & SMBUS_PIIX4_BLOCK_DATA_MASK] = block[i];
                         timer_bytes += i;
 
                         break;
 
                     case 0xf: /* universal */
                         /* block write [data0] bytes */
-                        for (i = 0; i < dev->data0; i++) {
-                            if (!i2c_write(i2c_smbus, smbus_addr, dev->data[i & SMBUS_PIIX4_BLOCK_DATA_MASK]))
-                                break; /* write NAK behavior is unknown */
-                        }
+                        for (i = 0; i < dev->data0; i++)
+                            block[i] = dev->data[i & SMBUS_PIIX4_BLOCK_DATA_MASK];
+                        i = i2c_write_block(i2c_smbus, smbus_addr, block, dev->data0); /* write NAK behavior is unknown */
                         timer_bytes += i;
 
                         /* block read [data1] bytes */
+                        i2c_read_block(i2c_smbus, smbus_addr, block, dev->data1);
                         for (i = 0; i < dev->data1; i++)
-                            dev->data[i & SMBUS_PIIX4_BLOCK_DATA_MASK] = i2c_read(i2c_smbus, smbus_addr);
+                            dev->data[i & SMBUS_PIIX4_BLOCK_DATA_MASK] = block[i];
                         timer_bytes += i;
 
                         break;
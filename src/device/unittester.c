@@ -26,10 +26,12 @@
 #include <wchar.h>
 #define HAVE_STDARG_H
 #include <86box/86box.h>
+#include "cpu.h"
 #include <86box/io.h>
 #include <86box/plat.h>
 #include <86box/unittester.h>
 #include <86box/video.h>
+#include <86box/bench.h>
 
 enum fsm1_value {
     UT_FSM1_WAIT_8,
@@ -57,6 +59,16 @@ enum unittester_cmd {
     UT_CMD_READ_SCREEN_SNAPSHOT_RECTANGLE   = 0x02,
     UT_CMD_VERIFY_SCREEN_SNAPSHOT_RECTANGLE = 0x03,
     UT_CMD_EXIT                             = 0x04,
+    UT_CMD_READ_PERFORMANCE_COUNTERS        = 0x05,
+    UT_CMD_PHASE_MARKER                     = 0x06,
+};
+
+/* Performance counters, in the order they are read */
+enum unittester_perf {
+    UT_PERF_HOST_NS     = 0,
+    UT_PERF_TSC         = 1,
+    UT_PERF_HOST_CPU_NS = 2,
+    UT_PERF_COUNT       = 3,
 };
 
 struct unittester_state {
@@ -103,6 +115,13 @@ struct unittester_state {
 
     /* 0x04: Exit */
     uint8_t exit_code;
+
+    /* 0x05: Read Performance Counters */
+    uint64_t perf_counters[UT_PERF_COUNT];
+
+    /* 0x06: Phase Marker */
+    uint8_t phase_id;
+    uint8_t phase_event;
 };
 static struct unittester_state       unittester;
 static const struct unittester_state unittester_defaults = {
@@ -212,6 +231,24 @@ unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
                 unittester.write_len = 1;
                 break;
 
+            /* 0x05: Read Performance Counters */
+            case UT_CMD_READ_PERFORMANCE_COUNTERS:
+                /* Sampled now, so the guest gets them as of the command write. */
+                unittester.perf_counters[UT_PERF_HOST_NS]     = bench_host_ns();
+                unittester.perf_counters[UT_PERF_TSC]         = tsc;
+                unittester.perf_counters[UT_PERF_HOST_CPU_NS] = bench_host_cpu_ns();
+                unittester.cmd_id                             = UT_CMD_READ_PERFORMANCE_COUNTERS;
+                unittester.status                             = UT_STATUS_AWAITING_READ;
+                unittester.read_len                           = UT_PERF_COUNT * 8;
+                break;
+
+            /* 0x06: Phase Marker */
+            case UT_CMD_PHASE_MARKER:
+                unittester.cmd_id    = UT_CMD_PHASE_MARKER;
+                unittester.status    = UT_STATUS_AWAITING_WRITE;
+                unittester.write_len = 2;
+                break;
+
             /* Unsupported command - terminate here */
             default:
                 unittester.cmd_id = UT_CMD_NOOP;
@@ -248,6 +285,19 @@ unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
                 }
                 break;
 
+            case UT_CMD_PHASE_MARKER:
+                switch (unittester.write_offs) {
+                    case 0:
+                        unittester.phase_id = val;
+                        break;
+                    case 1:
+                        unittester.phase_event = val;
+                        break;
+                    default:
+                        break;
+                }
+                break;
+
             case UT_CMD_READ_SCREEN_SNAPSHOT_RECTANGLE:
             case UT_CMD_VERIFY_SCREEN_SNAPSHOT_RECTANGLE:
                 switch (unittester.write_offs) {
@@ -294,8 +344,11 @@ unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
                 case UT_CMD_EXIT:
                     unittester_log("[UT] Exit received - code = %02X\n", unittester.exit_code);
 
+                    /* A benchmark run ends here whatever the device setting. */
+                    bench_guest_exit(unittester.exit_code);
+
                     /* CHECK: Do we actually exit? */
-                    if (unittester_exit_enabled) {
+                    if (unittester_exit_enabled || bench_enabled) {
                         /* Yes - call exit! */
                         /* Clamp exit code */
                         if (unittester.exit_code > 0x7F)
@@ -313,6 +366,16 @@ unittester_write(uint16_t port, uint8_t val, UNUSED(void *priv))
                     unittester.status = UT_STATUS_IDLE;
                     break;
 
+                case UT_CMD_PHASE_MARKER:
+                    unittester_log("[UT] Phase %02X %s\n", unittester.phase_id,
+                                   unittester.phase_event ? "stop" : "start");
+
+                    bench_phase_marker(unittester.phase_id, !!unittester.phase_event);
+
+                    unittester.cmd_id = UT_CMD_NOOP;
+                    unittester.status = UT_STATUS_IDLE;
+                    break;
+
                 case UT_CMD_CAPTURE_SCREEN_SNAPSHOT:
                     /* Recompute screen */
                     unittester.snap_img_width       = 0;
@@ -489,6 +552,10 @@ unittester_read(uint16_t port, UNUSED(void *priv))
                 outval = (uint8_t) (unittester.read_snap_crc >> (8 * unittester.read_offs));
                 break;
 
+            case UT_CMD_READ_PERFORMANCE_COUNTERS:
+                outval = (uint8_t) (unittester.perf_counters[unittester.read_offs >> 3] >> (8 * (unittester.read_offs & 7)));
+                break;
+
             /* This should not be reachable, but just in case... */
             default:
                 break;
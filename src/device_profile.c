@@ -0,0 +1,247 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Device callback profiler.
+ *
+ *          Every profiled callback is timed with the host's monotonic
+ *          clock and charged to the device owning its private pointer.
+ *          Callbacks nest (a timer callback mixing sound calls the sound
+ *          buffer handlers, a port write can touch memory), so each one
+ *          is only charged its own time, with the time of the callbacks
+ *          it made subtracted.
+ *
+ *          Private pointers that do not belong to a device_t (such as a
+ *          sub-structure of a card, or the callback itself for timers
+ *          without one) are reported by address.
+ *
+ *          Only the emulation thread is expected to call in here.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#if defined WIN32 || defined _WIN32
+#    include <windows.h>
+#else
+#    include <time.h>
+#endif
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/device_profile.h>
+#include <86box/path.h>
+#include <86box/plat.h>
+
+#define PROFILE_FILE         "device_profile.txt"
+#define PROFILE_ENTRIES      1024 /* must be a power of two */
+#define PROFILE_ENTRIES_MASK (PROFILE_ENTRIES - 1)
+#define PROFILE_DEPTH        16
+#define PROFILE_INTERVAL     10000000000ULL /* ns between reports */
+
+typedef struct profile_entry_t {
+    const void *key;
+    uint64_t    calls[DEVICE_PROFILE_MAX];
+    uint64_t    ns[DEVICE_PROFILE_MAX];
+    uint64_t    total_ns;
+} profile_entry_t;
+
+static profile_entry_t profile_entries[PROFILE_ENTRIES];
+/* Charged with everything once the table is full. */
+static profile_entry_t profile_other;
+static int             profile_entries_used;
+
+/* Time spent in nested callbacks, per nesting level. */
+static uint64_t profile_child_ns[PROFILE_DEPTH + 1];
+static int      profile_depth;
+
+static uint64_t profile_start_ns;
+static uint64_t profile_last_report;
+
+static const char *profile_type_names[DEVICE_PROFILE_MAX] = {
+    [DEVICE_PROFILE_IO]    = "I/O",
+    [DEVICE_PROFILE_MEM]   = "memory",
+    [DEVICE_PROFILE_TIMER] = "timer",
+    [DEVICE_PROFILE_SOUND] = "sound",
+    [DEVICE_PROFILE_IRQ]   = "IRQ"
+};
+
+static uint64_t
+profile_time_ns(void)
+{
+#if defined WIN32 || defined _WIN32
+    static LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER        now;
+
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t) ((now.QuadPart * 1000000000.0) / freq.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+#endif
+}
+
+static profile_entry_t *
+profile_get_entry(const void *key)
+{
+    uint32_t hash = (uint32_t) (((uintptr_t) key >> 3) * 0x9e3779b1) & PROFILE_ENTRIES_MASK;
+
+    /* Keep a little room free so that probe sequences stay short. */
+    for (int c = 0; c < 64; c++) {
+        profile_entry_t *entry = &profile_entries[hash];
+
+        if (entry->key == key)
+            return entry;
+
+        if (entry->key == NULL) {
+            if (profile_entries_used >= (PROFILE_ENTRIES - (PROFILE_ENTRIES / 8)))
+                break;
+            entry->key = key;
+            profile_entries_used++;
+            return entry;
+        }
+
+        hash = (hash + 1) & PROFILE_ENTRIES_MASK;
+    }
+
+    return &profile_other;
+}
+
+uint64_t
+device_profile_start(void)
+{
+    if (++profile_depth <= PROFILE_DEPTH)
+        profile_child_ns[profile_depth] = 0;
+
+    return profile_time_ns();
+}
+
+void
+device_profile_end(int type, const void *key, uint64_t start)
+{
+    profile_entry_t *entry;
+    uint64_t         now   = profile_time_ns();
+    uint64_t         total = now - start;
+    uint64_t         self  = total;
+
+    if ((profile_depth > 0) && (profile_depth <= PROFILE_DEPTH))
+        self = (profile_child_ns[profile_depth] < total) ? (total - profile_child_ns[profile_depth]) : 0;
+    if (profile_depth > 0)
+        profile_depth--;
+    if (profile_depth <= PROFILE_DEPTH)
+        profile_child_ns[profile_depth] += total;
+
+    entry = profile_get_entry(key);
+    entry->calls[type]++;
+    entry->ns[type] += self;
+    entry->total_ns += self;
+
+    if (!profile_start_ns) {
+        profile_start_ns    = start;
+        profile_last_report = now;
+    } else if ((profile_depth == 0) && ((now - profile_last_report) >= PROFILE_INTERVAL)) {
+        profile_last_report = now;
+        device_profile_report();
+    }
+}
+
+static int
+profile_compare(const void *a, const void *b)
+{
+    const profile_entry_t *ea = *(profile_entry_t *const *) a;
+    const profile_entry_t *eb = *(profile_entry_t *const *) b;
+
+    if (ea->total_ns > eb->total_ns)
+        return -1;
+    if (ea->total_ns < eb->total_ns)
+        return 1;
+    return 0;
+}
+
+static void
+profile_write_entry(FILE *fp, const profile_entry_t *entry, const char *name, uint64_t elapsed)
+{
+    fprintf(fp, "%10.3f %6.2f%%",
+            entry->total_ns / 1000000.0, elapsed ? ((entry->total_ns * 100.0) / elapsed) : 0.0);
+    for (int c = 0; c < DEVICE_PROFILE_MAX; c++)
+        fprintf(fp, " %12" PRIu64 " %10.3f", entry->calls[c], entry->ns[c] / 1000000.0);
+    fprintf(fp, "  %s\n", name);
+}
+
+/* Write the table out, busiest device first. */
+void
+device_profile_report(void)
+{
+    profile_entry_t **sorted;
+    const device_t   *dev;
+    char              path[1024];
+    char              name[128];
+    uint64_t          elapsed;
+    FILE             *fp;
+    int               n = 0;
+
+    if (!profile_start_ns)
+        return;
+
+    sorted = malloc((profile_entries_used + 1) * sizeof(profile_entry_t *));
+    if (sorted == NULL)
+        return;
+    for (int c = 0; c < PROFILE_ENTRIES; c++) {
+        if (profile_entries[c].key != NULL)
+            sorted[n++] = &profile_entries[c];
+    }
+    qsort(sorted, n, sizeof(profile_entry_t *), profile_compare);
+
+    path_append_filename(path, usr_path, PROFILE_FILE);
+    fp = plat_fopen(path, "w");
+    if (fp == NULL) {
+        free(sorted);
+        return;
+    }
+
+    elapsed = profile_time_ns() - profile_start_ns;
+    fprintf(fp, "Device callback profile over %.3f s of host time\n\n", elapsed / 1000000000.0);
+    fprintf(fp, "  self (ms)  share");
+    for (int c = 0; c < DEVICE_PROFILE_MAX; c++)
+        fprintf(fp, " %6s calls %7s ms", profile_type_names[c], profile_type_names[c]);
+    fprintf(fp, "  device\n");
+
+    for (int c = 0; c < n; c++) {
+        dev = device_find_by_priv(sorted[c]->key);
+        if ((dev != NULL) && (dev->name != NULL))
+            snprintf(name, sizeof(name), "%s", dev->name);
+        else
+            snprintf(name, sizeof(name), "(%p)", sorted[c]->key);
+        profile_write_entry(fp, sorted[c], name, elapsed);
+    }
+    if (profile_other.total_ns)
+        profile_write_entry(fp, &profile_other, "(table full)", elapsed);
+
+    fclose(fp);
+    free(sorted);
+}
+
+/* Forget everything, the private pointers are about to go away. */
+void
+device_profile_reset(void)
+{
+    memset(profile_entries, 0, sizeof(profile_entries));
+    memset(&profile_other, 0, sizeof(profile_other));
+    profile_entries_used = 0;
+    profile_start_ns     = 0;
+}
@@ -148,18 +148,20 @@ hdc_get_internal_name(int hdc)
     return device_get_internal_name(controllers[hdc].device);
 }
 
+static const char *
+hdc_get_name(int c)
+{
+    return (controllers[c].device != NULL) ? controllers[c].device->internal_name : NULL;
+}
+
+static device_name_index_t hdc_names = { .get_name = hdc_get_name };
+
 int
 hdc_get_from_internal_name(char *s)
 {
-    int c = 0;
-
-    while (controllers[c].device != NULL) {
-        if (!strcmp(controllers[c].device->internal_name, s))
-            return c;
-        c++;
-    }
+    int c = device_name_index_find(&hdc_names, s);
 
-    return 0;
+    return (c >= 0) ? c : 0;
 }
 
 const device_t *
@@ -256,6 +256,42 @@ esdi_mca_set_callback(esdi_t *dev, double callback)
     }
 }
 
+/* Moves the rest of the sector in dev->data to the host, returns 0 if
+   the DMA channel stopped accepting data before the end of it. */
+static int
+esdi_mca_dma_to_host(esdi_t *dev)
+{
+    int n;
+
+    while (dev->data_pos < 256) {
+        n = dma_channel_write_block(dev->dma, &dev->data[dev->data_pos], 256 - dev->data_pos);
+        if (!n)
+            return 0;
+        dev->data_pos += n;
+    }
+
+    return 1;
+}
+
+/* Fills the rest of the sector in dev->data from the host, returns 0 if
+   the DMA channel ran dry before the end of it. */
+static int
+esdi_mca_dma_from_host(esdi_t *dev)
+{
+    int buf[256];
+    int n;
+
+    while (dev->data_pos < 256) {
+        n = dma_channel_read_block(dev->dma, buf, 256 - dev->data_pos);
+        if (!n)
+            return 0;
+        for (int c = 0; c < n; c++)
+            dev->data[dev->data_pos++] = buf[c] & 0xffff;
+    }
+
+    return 1;
+}
+
 static double
 esdi_mca_get_xfer_time(UNUSED(esdi_t *esdi), int size)
 {
@@ -364,7 +400,6 @@ esdi_callback(void *priv)
 {
     esdi_t        *dev = (esdi_t *) priv;
     const drive_t *drive;
-    int            val;
     double         cmd_time = 0.0;
 
     /* If we are returning from a RESET, handle this first. */
@@ -425,15 +460,9 @@ esdi_callback(void *priv)
                             cmd_time += esdi_mca_get_xfer_time(dev, 1);
                         }
 
-                        while (dev->data_pos < 256) {
-                            val = dma_channel_write(dev->dma, dev->data[dev->data_pos]);
-
-                            if (val == DMA_NODATA) {
-                                esdi_mca_set_callback(dev, ESDI_TIME + cmd_time);
-                                return;
-                            }
-
-                            dev->data_pos++;
+                        if (!esdi_mca_dma_to_host(dev)) {
+                            esdi_mca_set_callback(dev, ESDI_TIME + cmd_time);
+                            return;
                         }
 
                         dev->data_pos = 0;
@@ -496,15 +525,9 @@ esdi_callback(void *priv)
                     }
 
                     while (dev->sector_pos < dev->sector_count) {
-                        while (dev->data_pos < 256) {
-                            val = dma_channel_read(dev->dma);
-
-                            if (val == DMA_NODATA) {
-                                esdi_mca_set_callback(dev, ESDI_TIME + cmd_time);
-                                return;
-                            }
-
-                            dev->data[dev->data_pos++] = val & 0xffff;
+                        if (!esdi_mca_dma_from_host(dev)) {
+                            esdi_mca_set_callback(dev, ESDI_TIME + cmd_time);
+                            return;
                         }
 
                         if (dev->rba >= drive->sectors)
@@ -711,15 +734,9 @@ esdi_callback(void *priv)
                         return;
                     }
                     while (dev->sector_pos < dev->sector_count) {
-                        while (dev->data_pos < 256) {
-                            val = dma_channel_read(dev->dma);
-
-                            if (val == DMA_NODATA) {
-                                esdi_mca_set_callback(dev, ESDI_TIME);
-                                return;
-                            }
-
-                            dev->data[dev->data_pos++] = val & 0xffff;
+                        if (!esdi_mca_dma_from_host(dev)) {
+                            esdi_mca_set_callback(dev, ESDI_TIME);
+                            return;
                         }
 
                         memcpy(dev->sector_buffer[dev->sector_pos++], dev->data, 512);
@@ -772,15 +789,9 @@ esdi_callback(void *priv)
                     while (dev->sector_pos < dev->sector_count) {
                         if (!dev->data_pos)
                             memcpy(dev->data, dev->sector_buffer[dev->sector_pos++], 512);
-                        while (dev->data_pos < 256) {
-                            val = dma_channel_write(dev->dma, dev->data[dev->data_pos]);
-
-                            if (val == DMA_NODATA) {
-                                esdi_mca_set_callback(dev, ESDI_TIME);
-                                return;
-                            }
-
-                            dev->data_pos++;
+                        if (!esdi_mca_dma_to_host(dev)) {
+                            esdi_mca_set_callback(dev, ESDI_TIME);
+                            return;
                         }
 
                         dev->data_pos = 0;
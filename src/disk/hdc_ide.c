@@ -1230,6 +1230,26 @@ ide_atapi_packet_write(ide_t *ide, const uint16_t val)
     }
 }
 
+static void
+ide_write_data_end(ide_t *ide)
+{
+    ide->tf->pos     = 0;
+    ide->tf->atastat = BSY_STAT;
+    const double seek_time = hdd_timing_write(&hdd[ide->hdd_num], ide_get_sector(ide), 1);
+    const double xfer_time = ide_get_xfer_time(ide, 512);
+    const double wait_time = seek_time + xfer_time;
+    if (ide->command == WIN_WRITE_MULTIPLE) {
+        if ((ide->blockcount + 1) >= ide->blocksize || ide->tf->secount == 1) {
+            ide_set_callback(ide, seek_time + xfer_time + ide->pending_delay);
+            ide->pending_delay = 0;
+        } else {
+            ide->pending_delay += wait_time;
+            ide_callback(ide);
+        }
+    } else
+        ide_set_callback(ide, wait_time);
+}
+
 static void
 ide_write_data(ide_t *ide, const uint16_t val)
 {
@@ -1245,27 +1265,50 @@ ide_write_data(ide_t *ide, const uint16_t val)
             idebufferw[ide->tf->pos >> 1] = val & 0xffff;
             ide->tf->pos += 2;
 
-            if (ide->tf->pos >= 512) {
-                ide->tf->pos     = 0;
-                ide->tf->atastat = BSY_STAT;
-                const double seek_time = hdd_timing_write(&hdd[ide->hdd_num], ide_get_sector(ide), 1);
-                const double xfer_time = ide_get_xfer_time(ide, 512);
-                const double wait_time = seek_time + xfer_time;
-                if (ide->command == WIN_WRITE_MULTIPLE) {
-                    if ((ide->blockcount + 1) >= ide->blocksize || ide->tf->secount == 1) {
-                        ide_set_callback(ide, seek_time + xfer_time + ide->pending_delay);
-                        ide->pending_delay = 0;
-                    } else {
-                        ide->pending_delay += wait_time;
-                        ide_callback(ide);
-                    }
-                } else
-                    ide_set_callback(ide, wait_time);
-            }
+            if (ide->tf->pos >= 512)
+                ide_write_data_end(ide);
         }
     }
 }
 
+/* Bulk form of ide_write_data() for REP OUTSW/OUTSD, moving whole runs of the
+   sector buffer at a time with the same end of sector handling. */
+static int
+ide_write_block(UNUSED(uint16_t addr), const void *buf, int count, int size, void *priv)
+{
+    const ide_board_t *dev = (ide_board_t *) priv;
+    ide_t             *ide = ide_drives[dev->cur_dev];
+    const uint8_t     *src = (const uint8_t *) buf;
+    int                len = count * size;
+    int                done = 0;
+    int                n;
+
+    if ((size == 4) && !dev->bit32)
+        return 0;
+
+    while (done < len) {
+        if ((ide->type == IDE_NONE) || (ide->type & IDE_SHADOW) || (ide->buffer == NULL) ||
+            (ide->command == WIN_PACKETCMD))
+            break;
+
+        n = MIN(len - done, 512 - ide->tf->pos);
+        memcpy(((uint8_t *) ide->buffer) + ide->tf->pos, src + done, n);
+        ide->tf->pos += n;
+        done += n;
+
+        if (ide->tf->pos >= 512)
+            ide_write_data_end(ide);
+    }
+
+    /* Never leave a unit half done. */
+    if (done % size) {
+        ide_write_data(ide, src[done] | (src[done + 1] << 8));
+        done += 2;
+    }
+
+    return done / size;
+}
+
 void
 ide_writew(uint16_t addr, uint16_t val, void *priv)
 {
@@ -1645,6 +1688,9 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
                         ui_sb_update_icon(SB_HDD | hdd[ide->hdd_num].bus, 1);
                         uint32_t sec_count;
                         double   wait_time;
+                        /* Let the host read the data while the seek time elapses. */
+                        if (ide->tf->lba || ide->cfg_spt)
+                            hdd_image_prefetch(ide->hdd_num, ide_get_sector(ide), ide->tf->secount ? ide->tf->secount : 256);
                         if ((val == WIN_READ_DMA) || (val == WIN_READ_DMA_ALT)) {
                             /* TODO: Make DMA timing more accurate. */
                             sec_count        = ide->tf->secount ? ide->tf->secount : 256;
@@ -1808,6 +1854,46 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
     }
 }
 
+static void
+ide_read_data_end(ide_t *ide)
+{
+    ide->tf->pos     = 0;
+    ide->tf->atastat = DRDY_STAT | DSC_STAT;
+    if (ide->type == IDE_ATAPI)
+        ide->sc->packet_status = PHASE_IDLE;
+
+    if ((ide->command == WIN_READ) ||
+        (ide->command == WIN_READ_NORETRY) ||
+        (ide->command == WIN_READ_MULTIPLE)) {
+
+        ide->tf->secount--;
+
+        if (ide->tf->secount) {
+            ide_next_sector(ide);
+            ide->tf->atastat = BSY_STAT | READY_STAT | DSC_STAT;
+            if (ide->command == WIN_READ_MULTIPLE) {
+                if (!ide->blockcount) {
+                    uint32_t cnt = ide->tf->secount ?
+                                   ide->tf->secount : 256;
+                    if (cnt > ide->blocksize)
+                        cnt = ide->blocksize;
+                    const double seek_us = hdd_timing_read(&hdd[ide->hdd_num],
+                                           ide_get_sector(ide), cnt);
+                    const double xfer_us = ide_get_xfer_time(ide, 512 * cnt);
+                    ide_set_callback(ide, seek_us + xfer_us);
+                } else
+                    ide_callback(ide);
+            } else {
+                const double seek_us = hdd_timing_read(&hdd[ide->hdd_num],
+                                                       ide_get_sector(ide), 1);
+                const double xfer_us = ide_get_xfer_time(ide, 512);
+                ide_set_callback(ide, seek_us + xfer_us);
+            }
+        } else
+            ui_sb_update_icon(SB_HDD | hdd[ide->hdd_num].bus, 0);
+    }
+}
+
 static uint16_t
 ide_read_data(ide_t *ide)
 {
@@ -1832,46 +1918,51 @@ ide_read_data(ide_t *ide)
         ret = idebufferw[ide->tf->pos >> 1];
         ide->tf->pos += 2;
 
-        if (ide->tf->pos >= 512) {
-            ide->tf->pos     = 0;
-            ide->tf->atastat = DRDY_STAT | DSC_STAT;
-            if (ide->type == IDE_ATAPI)
-                ide->sc->packet_status = PHASE_IDLE;
+        if (ide->tf->pos >= 512)
+            ide_read_data_end(ide);
+    }
 
-            if ((ide->command == WIN_READ) ||
-                (ide->command == WIN_READ_NORETRY) ||
-                (ide->command == WIN_READ_MULTIPLE)) {
+    return ret;
+}
 
-                ide->tf->secount--;
+/* Bulk form of ide_read_data() for REP INSW/INSD. */
+static int
+ide_read_block(UNUSED(uint16_t addr), void *buf, int count, int size, void *priv)
+{
+    const ide_board_t *dev = (ide_board_t *) priv;
+    ide_t             *ide = ide_drives[dev->cur_dev];
+    uint8_t           *dst = (uint8_t *) buf;
+    int                len = count * size;
+    int                done = 0;
+    int                n;
 
-                if (ide->tf->secount) {
-                    ide_next_sector(ide);
-                    ide->tf->atastat = BSY_STAT | READY_STAT | DSC_STAT;
-                    if (ide->command == WIN_READ_MULTIPLE) {
-                        if (!ide->blockcount) {
-                            uint32_t cnt = ide->tf->secount ?
-                                           ide->tf->secount : 256;
-                            if (cnt > ide->blocksize)
-                                cnt = ide->blocksize;
-                            const double seek_us = hdd_timing_read(&hdd[ide->hdd_num],
-                                                   ide_get_sector(ide), cnt);
-                            const double xfer_us = ide_get_xfer_time(ide, 512 * cnt);
-                            ide_set_callback(ide, seek_us + xfer_us);
-                        } else
-                            ide_callback(ide);
-                    } else {
-                        const double seek_us = hdd_timing_read(&hdd[ide->hdd_num],
-                                                               ide_get_sector(ide), 1);
-                        const double xfer_us = ide_get_xfer_time(ide, 512);
-                        ide_set_callback(ide, seek_us + xfer_us);
-                    }
-                } else
-                    ui_sb_update_icon(SB_HDD | hdd[ide->hdd_num].bus, 0);
-            }
-        }
+    if ((size == 4) && !dev->bit32)
+        return 0;
+
+    while (done < len) {
+        if ((ide->type == IDE_NONE) || (ide->type & IDE_SHADOW) || (ide->buffer == NULL) ||
+            (ide->command == WIN_PACKETCMD))
+            break;
+
+        n = MIN(len - done, 512 - ide->tf->pos);
+        memcpy(dst + done, ((uint8_t *) ide->buffer) + ide->tf->pos, n);
+        ide->tf->pos += n;
+        done += n;
+
+        if (ide->tf->pos >= 512)
+            ide_read_data_end(ide);
     }
 
-    return ret;
+    /* Never leave a unit half done. */
+    if (done % size) {
+        const uint16_t val = ide_read_data(ide);
+
+        dst[done]     = val & 0xff;
+        dst[done + 1] = val >> 8;
+        done += 2;
+    }
+
+    return done / size;
 }
 
 static uint8_t
@@ -2228,12 +2319,16 @@ ide_callback(void *priv)
                 ide_log("IDE %i: DMA read aborted (SPECIFY failed)\n", ide->channel);
                 err = IDNF_ERR;
             } else {
-                ide->sector_pos = 0;
                 if (ide->tf->secount)
                     ide->sector_pos = ide->tf->secount;
                 else
                     ide->sector_pos = 256;
-                hdd_image_read(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
+                /* Read the whole command once, not again each time the host
+                   has yet to start the bus master. */
+                if (ide->do_initial_read) {
+                    ide->do_initial_read = 0;
+                    hdd_image_read(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
+                }
 
                 ide->tf->pos = 0;
 
@@ -2381,9 +2476,13 @@ ide_callback(void *priv)
             else if (!ide->tf->lba && (ide->cfg_spt == 0))
                 err = IDNF_ERR;
             else {
-                hdd_image_write(ide->hdd_num, ide_get_sector(ide), 1, (uint8_t *) ide->buffer);
+                /* Gather the block and write it to the image in one go once
+                   it is complete, the host only sees the end of the block. */
+                memcpy(&ide->sector_buffer[ide->blockcount * 512], ide->buffer, 512);
                 ide->blockcount++;
                 if (ide->blockcount >= ide->blocksize || ide->tf->secount == 1) {
+                    hdd_image_write(ide->hdd_num, ide_get_sector(ide) - (ide->blockcount - 1),
+                                    ide->blockcount, ide->sector_buffer);
                     ide->blockcount = 0;
                     ide_irq_raise(ide);
                 }
@@ -2595,6 +2694,9 @@ ide_handlers(uint8_t board, int set)
                        ide_readb, ide_readw, ide_readl,
                        ide_writeb, ide_writew, ide_writel,
                        ide_boards[board]);
+            io_block_handler(set, ide_boards[board]->base[0],
+                             ide_read_block, ide_write_block,
+                             ide_boards[board]);
         }
 
         if (ide_boards[board]->base[1]) {
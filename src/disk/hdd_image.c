@@ -20,18 +20,30 @@
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 #include <wchar.h>
 #include <errno.h>
+#include <stdatomic.h>
+#ifdef _WIN32
+#    include <windows.h>
+#    include <io.h>
+#else
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/path.h>
 #include <86box/plat.h>
 #include <86box/random.h>
+#include <86box/thread.h>
 #include <86box/hdd.h>
+#include <86box/trace.h>
+#include <86box/metrics.h>
 #include "minivhd/minivhd.h"
 #include "minivhd/internal.h"
 
@@ -40,6 +52,17 @@
 #define HDD_IMAGE_HDX 2
 #define HDD_IMAGE_VHD 3
 
+#define HDD_IO_IDLE    0
+#define HDD_IO_PENDING 1
+#define HDD_IO_DONE    2
+
+#define HDD_IO_MAX_SECTORS 256
+
+#define HDD_OV_MAGIC             "86BoxCOW"
+#define HDD_OV_VERSION           1
+#define HDD_OV_BLOCK_SECTORS     8
+#define HDD_OV_MAX_BLOCK_SECTORS 2048
+
 typedef struct hdd_image_t {
     FILE     *file; /* Used for HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */
     MVHDMeta *vhd;  /* Used for HDD_IMAGE_VHD. */
@@ -48,6 +71,33 @@ typedef struct hdd_image_t {
     uint32_t  last_sector;
     uint8_t   type; /* HDD_IMAGE_RAW, HDD_IMAGE_HDI, HDD_IMAGE_HDX, or HDD_IMAGE_VHD */
     uint8_t   loaded;
+
+    /* Asynchronous read-ahead, see hdd_image_prefetch(). */
+    thread_t  *io_thread;
+    event_t   *io_wake;
+    event_t   *io_done;
+    mutex_t   *io_mutex; /* Serializes file access on hosts without pread(). */
+    atomic_int io_state;
+    atomic_int io_run;
+    uint32_t   io_sector;
+    uint32_t   io_count; /* Sectors requested... */
+    uint32_t   io_valid; /* ...and sectors actually read. */
+    uint8_t   *io_buffer;
+
+    /* Optional memory mapping of the whole file, see hdd_image_map(). */
+    uint8_t *map;
+    uint64_t map_size;
+#ifdef _WIN32
+    HANDLE map_handle;
+#endif
+
+    /* Copy-on-write overlay over a read-only base, see hdd_image_ov_open(). */
+    FILE    *overlay;
+    uint8_t *ov_bitmap;
+    uint8_t *ov_block;
+    uint32_t ov_block_sectors;
+    uint32_t ov_bitmap_offset;
+    uint32_t ov_data_offset;
 } hdd_image_t;
 
 hdd_image_t hdd_images[HDD_NUM];
@@ -73,6 +123,470 @@ hdd_image_log(const char *fmt, ...)
 #    define hdd_image_log(fmt, ...)
 #endif
 
+/* Read or write file data at a byte offset. Positional I/O is used where
+   available so that the read-ahead thread never shares a file position with
+   the emulation thread. Return the number of bytes transferred. */
+static uint32_t
+hdd_image_pread(hdd_image_t *img, FILE *fp, uint64_t offset, uint8_t *buffer, uint32_t size)
+{
+    uint32_t done = 0;
+
+#ifdef _WIN32
+    thread_wait_mutex(img->io_mutex);
+    if (fseeko64(fp, offset, SEEK_SET) != -1)
+        done = fread(buffer, 1, size, fp);
+    thread_release_mutex(img->io_mutex);
+#else
+    (void) img;
+
+    while (done < size) {
+        ssize_t ret = pread(fileno(fp), buffer + done, size - done, (off_t) (offset + done));
+
+        if (ret <= 0)
+            break;
+        done += ret;
+    }
+#endif
+
+    return done;
+}
+
+static uint32_t
+hdd_image_pwrite(hdd_image_t *img, FILE *fp, uint64_t offset, const uint8_t *buffer, uint32_t size)
+{
+    uint32_t done = 0;
+
+#ifdef _WIN32
+    thread_wait_mutex(img->io_mutex);
+    if (fseeko64(fp, offset, SEEK_SET) != -1)
+        done = fwrite(buffer, 1, size, fp);
+    thread_release_mutex(img->io_mutex);
+#else
+    (void) img;
+
+    while (done < size) {
+        ssize_t ret = pwrite(fileno(fp), buffer + done, size - done, (off_t) (offset + done));
+
+        if (ret <= 0)
+            break;
+        done += ret;
+    }
+#endif
+
+    return done;
+}
+
+/* Raw image data, taken from the mapping if there is one. */
+static uint32_t
+hdd_image_file_read(hdd_image_t *img, uint64_t offset, uint8_t *buffer, uint32_t size)
+{
+    if (img->map != NULL) {
+        if (offset >= img->map_size)
+            return 0;
+        if ((img->map_size - offset) < size)
+            size = (uint32_t) (img->map_size - offset);
+        memcpy(buffer, &img->map[offset], size);
+        return size;
+    }
+
+    return hdd_image_pread(img, img->file, offset, buffer, size);
+}
+
+static uint32_t
+hdd_image_file_write(hdd_image_t *img, uint64_t offset, const uint8_t *buffer, uint32_t size)
+{
+    if (img->map != NULL) {
+        if (offset >= img->map_size)
+            return 0;
+        if ((img->map_size - offset) < size)
+            size = (uint32_t) (img->map_size - offset);
+        memcpy(&img->map[offset], buffer, size);
+        return size;
+    }
+
+    return hdd_image_pwrite(img, img->file, offset, buffer, size);
+}
+
+/* Copy-on-write overlay.
+
+   The overlay file starts with a 512-byte header, followed by a bitmap with
+   one bit per block of ov_block_sectors sectors, followed by the sector data
+   at data_offset + (sector * 512). A set bit means the whole block lives in
+   the overlay, a clear bit means it is still read from the base image, which
+   is opened read-only. Blocks that were never written are never touched in
+   the overlay file, so on hosts with sparse files it only takes up space for
+   the data the guest actually changed. */
+static int
+hdd_image_ov_allocated(hdd_image_t *img, uint32_t block)
+{
+    return !!(img->ov_bitmap[block >> 3] & (1 << (block & 7)));
+}
+
+static uint32_t
+hdd_image_ov_read(hdd_image_t *img, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    uint32_t done = 0;
+
+    while (done < count) {
+        uint32_t s         = sector + done;
+        int      allocated = hdd_image_ov_allocated(img, s / img->ov_block_sectors);
+        uint32_t n         = 0;
+        uint32_t ret;
+
+        /* Gather the run of sectors that come from the same file. */
+        while ((done + n) < count) {
+            uint32_t b = (s + n) / img->ov_block_sectors;
+
+            if (hdd_image_ov_allocated(img, b) != allocated)
+                break;
+            n += MIN(img->ov_block_sectors - ((s + n) % img->ov_block_sectors), count - done - n);
+        }
+
+        if (allocated)
+            ret = hdd_image_pread(img, img->overlay, img->ov_data_offset + ((uint64_t) s << 9),
+                                  buffer + (done << 9), n << 9);
+        else
+            ret = hdd_image_file_read(img, ((uint64_t) s << 9) + img->base, buffer + (done << 9), n << 9);
+
+        done += ret >> 9;
+        if (ret != (n << 9))
+            break;
+    }
+
+    return done;
+}
+
+static uint32_t
+hdd_image_ov_write(hdd_image_t *img, uint32_t sector, uint32_t count, const uint8_t *buffer)
+{
+    uint32_t done = 0;
+
+    while (done < count) {
+        uint32_t s      = sector + done;
+        uint32_t block  = s / img->ov_block_sectors;
+        uint32_t offset = s % img->ov_block_sectors;
+        uint32_t n      = MIN(img->ov_block_sectors - offset, count - done);
+        uint64_t addr   = img->ov_data_offset + ((uint64_t) s << 9);
+
+        if (!hdd_image_ov_allocated(img, block)) {
+            if (n != img->ov_block_sectors) {
+                /* Partial block, copy the rest of it up from the base image. */
+                uint32_t first = block * img->ov_block_sectors;
+
+                memset(img->ov_block, 0, img->ov_block_sectors << 9);
+                hdd_image_file_read(img, ((uint64_t) first << 9) + img->base, img->ov_block,
+                                    MIN(img->ov_block_sectors, img->last_sector + 1 - first) << 9);
+                memcpy(&img->ov_block[offset << 9], buffer + (done << 9), n << 9);
+                if (hdd_image_pwrite(img, img->overlay, img->ov_data_offset + ((uint64_t) first << 9),
+                                     img->ov_block, img->ov_block_sectors << 9) != (img->ov_block_sectors << 9))
+                    break;
+            } else if (hdd_image_pwrite(img, img->overlay, addr, buffer + (done << 9), n << 9) != (n << 9))
+                break;
+
+            /* Only mark the block once its data is in place. */
+            img->ov_bitmap[block >> 3] |= (1 << (block & 7));
+            hdd_image_pwrite(img, img->overlay, img->ov_bitmap_offset + (block >> 3),
+                             &img->ov_bitmap[block >> 3], 1);
+        } else if (hdd_image_pwrite(img, img->overlay, addr, buffer + (done << 9), n << 9) != (n << 9))
+            break;
+
+        done += n;
+    }
+
+    return done;
+}
+
+static void
+hdd_image_ov_close(hdd_image_t *img)
+{
+    if (img->overlay != NULL) {
+        fclose(img->overlay);
+        img->overlay = NULL;
+    }
+
+    free(img->ov_bitmap);
+    img->ov_bitmap = NULL;
+    free(img->ov_block);
+    img->ov_block = NULL;
+}
+
+/* Open the overlay file of a disk, creating an empty one if it does not
+   exist yet. The base image has already been opened and sized. */
+static int
+hdd_image_ov_open(uint8_t id)
+{
+    hdd_image_t *img     = &hdd_images[id];
+    uint64_t     sectors = (uint64_t) img->last_sector + 1;
+    uint8_t      header[512];
+    uint32_t     blocks;
+    uint32_t     bitmap_size;
+
+    img->overlay = plat_fopen(hdd[id].overlay_fn, "rb+");
+    if (img->overlay == NULL) {
+        if ((errno != ENOENT) || hdd[id].wp) {
+            hdd_image_log("HDD overlay: Unable to open '%s'\n", hdd[id].overlay_fn);
+            return 0;
+        }
+
+        img->overlay = plat_fopen(hdd[id].overlay_fn, "wb+");
+        if (img->overlay == NULL) {
+            hdd_image_log("HDD overlay: Unable to create '%s'\n", hdd[id].overlay_fn);
+            return 0;
+        }
+
+        img->ov_block_sectors = HDD_OV_BLOCK_SECTORS;
+        blocks                = (uint32_t) ((sectors + HDD_OV_BLOCK_SECTORS - 1) / HDD_OV_BLOCK_SECTORS);
+        bitmap_size           = (blocks + 7) >> 3;
+
+        memset(header, 0, sizeof(header));
+        memcpy(header, HDD_OV_MAGIC, 8);
+        *(uint32_t *) &header[0x08] = HDD_OV_VERSION;
+        *(uint32_t *) &header[0x0c] = img->ov_block_sectors;
+        *(uint64_t *) &header[0x10] = sectors;
+        *(uint32_t *) &header[0x18] = 512;
+        *(uint32_t *) &header[0x1c] = (512 + bitmap_size + 4095) & ~4095;
+
+        img->ov_bitmap = (uint8_t *) calloc(1, bitmap_size);
+        if ((fwrite(header, 1, sizeof(header), img->overlay) != sizeof(header)) ||
+            (fwrite(img->ov_bitmap, 1, bitmap_size, img->overlay) != bitmap_size)) {
+            hdd_image_log("HDD overlay: Unable to write header\n");
+            hdd_image_ov_close(img);
+            return 0;
+        }
+        fflush(img->overlay);
+    } else {
+        if ((fread(header, 1, sizeof(header), img->overlay) != sizeof(header)) ||
+            memcmp(header, HDD_OV_MAGIC, 8) || (*(uint32_t *) &header[0x08] != HDD_OV_VERSION)) {
+            hdd_image_log("HDD overlay: '%s' is not an overlay file\n", hdd[id].overlay_fn);
+            hdd_image_ov_close(img);
+            return 0;
+        }
+
+        img->ov_block_sectors = *(uint32_t *) &header[0x0c];
+        if ((*(uint64_t *) &header[0x10] != sectors) || (img->ov_block_sectors == 0) ||
+            (img->ov_block_sectors > HDD_OV_MAX_BLOCK_SECTORS)) {
+            hdd_image_log("HDD overlay: '%s' does not match the base image\n", hdd[id].overlay_fn);
+            hdd_image_ov_close(img);
+            return 0;
+        }
+
+        blocks         = (uint32_t) ((sectors + img->ov_block_sectors - 1) / img->ov_block_sectors);
+        bitmap_size    = (blocks + 7) >> 3;
+        img->ov_bitmap = (uint8_t *) malloc(bitmap_size);
+        if ((fseeko64(img->overlay, *(uint32_t *) &header[0x18], SEEK_SET) == -1) ||
+            (fread(img->ov_bitmap, 1, bitmap_size, img->overlay) != bitmap_size)) {
+            hdd_image_log("HDD overlay: Unable to read the block bitmap\n");
+            hdd_image_ov_close(img);
+            return 0;
+        }
+    }
+
+    img->ov_bitmap_offset = *(uint32_t *) &header[0x18];
+    img->ov_data_offset   = *(uint32_t *) &header[0x1c];
+    img->ov_block         = (uint8_t *) malloc(img->ov_block_sectors << 9);
+
+    return 1;
+}
+
+/* Sector data of raw, HDI and HDX images, with the overlay applied. Return
+   the number of sectors transferred. */
+static uint32_t
+hdd_image_data_read(hdd_image_t *img, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if (img->overlay != NULL)
+        return hdd_image_ov_read(img, sector, count, buffer);
+
+    return hdd_image_file_read(img, ((uint64_t) sector << 9) + img->base, buffer, count << 9) >> 9;
+}
+
+static uint32_t
+hdd_image_data_write(hdd_image_t *img, uint32_t sector, uint32_t count, const uint8_t *buffer)
+{
+    if (img->overlay != NULL)
+        return hdd_image_ov_write(img, sector, count, buffer);
+
+    return hdd_image_file_write(img, ((uint64_t) sector << 9) + img->base, buffer, count << 9) >> 9;
+}
+
+/* Map the whole image file into memory, so that sector accesses become plain
+   copies served by the host page cache. Falls back to file I/O on failure. */
+static void
+hdd_image_map(hdd_image_t *img)
+{
+    uint64_t size;
+
+    if ((img->file == NULL) || (img->map != NULL))
+        return;
+
+    fflush(img->file);
+    if (fseeko64(img->file, 0, SEEK_END) == -1)
+        return;
+    size = ftello64(img->file);
+    if ((size == 0) || (size != (uint64_t) (size_t) size))
+        return;
+
+#ifdef _WIN32
+    img->map_handle = CreateFileMapping((HANDLE) _get_osfhandle(_fileno(img->file)), NULL,
+                                        PAGE_READWRITE, (DWORD) (size >> 32), (DWORD) size, NULL);
+    if (img->map_handle == NULL)
+        return;
+    img->map = (uint8_t *) MapViewOfFile(img->map_handle, FILE_MAP_WRITE, 0, 0, (SIZE_T) size);
+    if (img->map == NULL) {
+        CloseHandle(img->map_handle);
+        img->map_handle = NULL;
+        return;
+    }
+#else
+    img->map = (uint8_t *) mmap(NULL, (size_t) size, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(img->file), 0);
+    if (img->map == MAP_FAILED) {
+        img->map = NULL;
+        return;
+    }
+#endif
+
+    img->map_size = size;
+    hdd_image_log("HDD image: Mapped %" PRIu64 " bytes\n", size);
+}
+
+static void
+hdd_image_unmap(hdd_image_t *img)
+{
+    if (img->map == NULL)
+        return;
+
+#ifdef _WIN32
+    FlushViewOfFile(img->map, 0);
+    UnmapViewOfFile(img->map);
+    CloseHandle(img->map_handle);
+    img->map_handle = NULL;
+#else
+    msync(img->map, (size_t) img->map_size, MS_SYNC);
+    munmap(img->map, (size_t) img->map_size);
+#endif
+
+    img->map      = NULL;
+    img->map_size = 0;
+}
+
+static void
+hdd_image_io_thread(void *priv)
+{
+    hdd_image_t *img = (hdd_image_t *) priv;
+
+    while (img->io_run) {
+        thread_wait_event(img->io_wake, -1);
+        thread_reset_event(img->io_wake);
+
+        if (img->io_state == HDD_IO_PENDING) {
+            img->io_valid = hdd_image_data_read(img, img->io_sector, img->io_count, img->io_buffer);
+            img->io_state = HDD_IO_DONE;
+            thread_set_event(img->io_done);
+        }
+    }
+}
+
+/* Wait for an in-flight read-ahead to finish. */
+static void
+hdd_image_io_wait(hdd_image_t *img)
+{
+    while (img->io_state == HDD_IO_PENDING)
+        thread_wait_event(img->io_done, -1);
+}
+
+/* Drop the read-ahead buffer, done before anything modifies the image. */
+static void
+hdd_image_io_invalidate(hdd_image_t *img)
+{
+    hdd_image_io_wait(img);
+    img->io_state = HDD_IO_IDLE;
+}
+
+/* Copy the requested sectors out of the read-ahead buffer if it covers them. */
+static int
+hdd_image_io_lookup(hdd_image_t *img, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if ((img->io_state == HDD_IO_IDLE) || (sector < img->io_sector) ||
+        ((sector + count) > (img->io_sector + img->io_count)))
+        return 0;
+
+    hdd_image_io_wait(img);
+
+    if ((sector + count) > (img->io_sector + img->io_valid))
+        return 0;
+
+    memcpy(buffer, &img->io_buffer[(sector - img->io_sector) << 9], count << 9);
+
+    return 1;
+}
+
+static void
+hdd_image_io_close(hdd_image_t *img)
+{
+    if (img->io_thread != NULL) {
+        hdd_image_io_wait(img);
+        img->io_run = 0;
+        thread_set_event(img->io_wake);
+        thread_wait(img->io_thread);
+        img->io_thread = NULL;
+
+        thread_destroy_event(img->io_wake);
+        thread_destroy_event(img->io_done);
+        free(img->io_buffer);
+        img->io_buffer = NULL;
+    }
+
+    if (img->io_mutex != NULL) {
+        thread_close_mutex(img->io_mutex);
+        img->io_mutex = NULL;
+    }
+
+    img->io_state = HDD_IO_IDLE;
+}
+
+/* Start reading sectors in the background, so that a later hdd_image_read()
+   of (part of) the range does not have to wait for the host. Controllers call
+   this when a read command is issued, before its emulated seek and transfer
+   time has elapsed. VHD images are read synchronously by minivhd. */
+void
+hdd_image_prefetch(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    if (!img->loaded || (img->type == HDD_IMAGE_VHD) || (img->file == NULL) ||
+        (img->map != NULL) || !count)
+        return;
+
+    if (count > HDD_IO_MAX_SECTORS)
+        count = HDD_IO_MAX_SECTORS;
+    if (sector > img->last_sector)
+        return;
+    if ((img->last_sector - sector + 1) < count)
+        count = img->last_sector - sector + 1;
+
+    if (img->io_thread == NULL) {
+        img->io_buffer = (uint8_t *) malloc(HDD_IO_MAX_SECTORS << 9);
+        img->io_wake   = thread_create_event();
+        img->io_done   = thread_create_event();
+        img->io_state  = HDD_IO_IDLE;
+        img->io_run    = 1;
+        img->io_thread = thread_create(hdd_image_io_thread, img);
+    }
+
+    hdd_image_io_wait(img);
+
+    /* Already buffered, nothing to do. */
+    if ((img->io_state == HDD_IO_DONE) && (sector >= img->io_sector) &&
+        ((sector + count) <= (img->io_sector + img->io_valid)))
+        return;
+
+    img->io_sector = sector;
+    img->io_count  = count;
+    img->io_valid  = 0;
+    thread_reset_event(img->io_done);
+    img->io_state = HDD_IO_PENDING;
+    thread_set_event(img->io_wake);
+}
+
 int
 image_is_hdi(const char *s)
 {
@@ -178,6 +692,38 @@ hdd_image_calc_chs(uint32_t *c, uint32_t *h, uint32_t *s, uint32_t size)
     *s  = spt;
 }
 
+/* Extend the file to new_size without writing the data, leaving a sparse
+   file where the host file system allows it. Returns 0 if this is not
+   possible, so that the caller falls back to writing zeros. */
+static int
+hdd_image_grow(FILE *fp, uint64_t new_size)
+{
+#ifdef _WIN32
+    HANDLE        h = (HANDLE) _get_osfhandle(_fileno(fp));
+    LARGE_INTEGER pos;
+    DWORD         bytes;
+
+    if (h == INVALID_HANDLE_VALUE)
+        return 0;
+
+    fflush(fp);
+
+    /* Not all file systems can do this, the file is then just not sparse. */
+    (void) DeviceIoControl(h, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytes, NULL);
+
+    pos.QuadPart = (LONGLONG) new_size;
+    if (!SetFilePointerEx(h, pos, NULL, FILE_BEGIN) || !SetEndOfFile(h))
+        return 0;
+#else
+    fflush(fp);
+
+    if (ftruncate(fileno(fp), (off_t) new_size) != 0)
+        return 0;
+#endif
+
+    return 1;
+}
+
 static int
 prepare_new_hard_disk(uint8_t id, uint64_t full_size)
 {
@@ -186,6 +732,11 @@ prepare_new_hard_disk(uint8_t id, uint64_t full_size)
     uint32_t size;
     uint32_t t;
 
+    if (hdd_image_grow(hdd_images[id].file, full_size + hdd_images[id].base)) {
+        fseeko64(hdd_images[id].file, 0, SEEK_END);
+        goto done;
+    }
+
     t    = (uint32_t) (target_size >> 20);     /* Amount of 1 MB blocks. */
     size = (uint32_t) (target_size & 0xfffff); /* 1 MB mask. */
 
@@ -218,10 +769,17 @@ prepare_new_hard_disk(uint8_t id, uint64_t full_size)
 
     free(empty_sector_1mb);
 
+done:
+    /* Sector data is accessed with positional I/O from now on. */
+    fflush(hdd_images[id].file);
+
     hdd_images[id].last_sector = (uint32_t) (full_size >> 9) - 1;
 
     hdd_images[id].loaded = 1;
 
+    if (hdd[id].use_mmap)
+        hdd_image_map(&hdd_images[id]);
+
     return 1;
 }
 
@@ -256,7 +814,12 @@ hdd_image_load(int id)
 
     hdd_images[id].base = 0;
 
+    hdd_image_io_close(&hdd_images[id]);
+    hdd_images[id].io_mutex = thread_create_mutex();
+
     if (hdd_images[id].loaded) {
+        hdd_image_unmap(&hdd_images[id]);
+        hdd_image_ov_close(&hdd_images[id]);
         if (hdd_images[id].file) {
             fclose(hdd_images[id].file);
             hdd_images[id].file = NULL;
@@ -281,14 +844,15 @@ hdd_image_load(int id)
         memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
         return 0;
     }
-    hdd_images[id].file = plat_fopen(fn, "rb+");
+    /* With an overlay, the base image is never written to. */
+    hdd_images[id].file = plat_fopen(fn, hdd[id].overlay_fn[0] ? "rb" : "rb+");
     if (hdd_images[id].file == NULL) {
         /* Failed to open existing hard disk image */
         if (errno == ENOENT) {
             /* Failed because it does not exist,
                so try to create new file */
-            if (hdd[id].wp) {
-                hdd_image_log("A write-protected image must exist\n");
+            if (hdd[id].wp || hdd[id].overlay_fn[0]) {
+                hdd_image_log("A write-protected or overlaid image must exist\n");
                 memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
                 return 0;
             }
@@ -476,12 +1040,33 @@ retry_vhd:
     if (fseeko64(hdd_images[id].file, 0, SEEK_END) == -1)
         fatal("hdd_image_load(): Error seeking to the end of file\n");
     s = ftello64(hdd_images[id].file);
-    if (s < (full_size + hdd_images[id].base))
+    if (hdd[id].overlay_fn[0]) {
+        if (s < (full_size + hdd_images[id].base)) {
+            hdd_image_log("The base image of an overlay is too short\n");
+            fclose(hdd_images[id].file);
+            hdd_images[id].file = NULL;
+            memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
+            return 0;
+        }
+
+        hdd_images[id].last_sector = (uint32_t) (full_size >> 9) - 1;
+        if (!hdd_image_ov_open(id)) {
+            fclose(hdd_images[id].file);
+            hdd_images[id].file = NULL;
+            memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
+            return 0;
+        }
+        hdd_images[id].loaded = 1;
+        ret                   = 1;
+    } else if (s < (full_size + hdd_images[id].base))
         ret = prepare_new_hard_disk(id, full_size);
     else {
         hdd_images[id].last_sector = (uint32_t) (full_size >> 9) - 1;
         hdd_images[id].loaded      = 1;
         ret                        = 1;
+
+        if (hdd[id].use_mmap)
+            hdd_image_map(&hdd_images[id]);
     }
 
     return ret;
@@ -506,18 +1091,22 @@ hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     int    non_transferred_sectors;
     size_t num_read;
 
+    pc_turbo_post_trigger(TURBO_POST_DISK);
+
+    TRACE_BEGIN_I(disk, "hdd_image_read", "sectors", count);
+    metrics.disk_read_bytes += (uint64_t) count << 9;
+
     if (hdd_images[id].type == HDD_IMAGE_VHD) {
         non_transferred_sectors = mvhd_read_sectors(hdd_images[id].vhd, sector, count, buffer);
         hdd_images[id].pos      = sector + count - non_transferred_sectors - 1;
+    } else if (hdd_image_io_lookup(&hdd_images[id], sector, count, buffer)) {
+        hdd_images[id].pos = sector + count;
     } else {
-        if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-            fatal("Hard disk image %i: Read error during seek\n", id);
-            return;
-        }
-
-        num_read           = fread(buffer, 512, count, hdd_images[id].file);
+        num_read           = hdd_image_data_read(&hdd_images[id], sector, count, buffer);
         hdd_images[id].pos = sector + num_read;
     }
+
+    TRACE_END(disk, "hdd_image_read");
 }
 
 uint32_t
@@ -554,18 +1143,20 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     int    non_transferred_sectors;
     size_t num_write;
 
+    TRACE_BEGIN_I(disk, "hdd_image_write", "sectors", count);
+    metrics.disk_write_bytes += (uint64_t) count << 9;
+
     if (hdd_images[id].type == HDD_IMAGE_VHD) {
         non_transferred_sectors = mvhd_write_sectors(hdd_images[id].vhd, sector, count, buffer);
         hdd_images[id].pos      = sector + count - non_transferred_sectors - 1;
     } else {
-        if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-            fatal("Hard disk image %i: Write error during seek\n", id);
-            return;
-        }
+        hdd_image_io_invalidate(&hdd_images[id]);
 
-        num_write          = fwrite(buffer, 512, count, hdd_images[id].file);
+        num_write          = hdd_image_data_write(&hdd_images[id], sector, count, buffer);
         hdd_images[id].pos = sector + num_write;
     }
+
+    TRACE_END(disk, "hdd_image_write");
 }
 
 int
@@ -593,17 +1184,25 @@ hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
     } else {
         memset(empty_sector, 0, 512);
 
-        if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-            fatal("Hard disk image %i: Zero error during seek\n", id);
+        hdd_image_io_invalidate(&hdd_images[id]);
+
+        if (hdd_images[id].map != NULL) {
+            uint64_t addr = ((uint64_t) sector << 9LL) + hdd_images[id].base;
+            uint64_t size = (uint64_t) count << 9LL;
+
+            if (addr < hdd_images[id].map_size) {
+                if ((hdd_images[id].map_size - addr) < size)
+                    size = hdd_images[id].map_size - addr;
+                memset(&hdd_images[id].map[addr], 0, size);
+            }
+            hdd_images[id].pos = sector + count - 1;
             return;
         }
 
         for (uint32_t i = 0; i < count; i++) {
-            if (feof(hdd_images[id].file))
-                break;
-
             hdd_images[id].pos = sector + i;
-            fwrite(empty_sector, 512, 1, hdd_images[id].file);
+            if (hdd_image_data_write(&hdd_images[id], sector + i, 1, (uint8_t *) empty_sector) != 1)
+                break;
         }
     }
 }
@@ -642,6 +1241,10 @@ hdd_image_unload(uint8_t id, UNUSED(int fn_preserve))
     if (strlen(hdd[id].fn) == 0)
         return;
 
+    hdd_image_io_close(&hdd_images[id]);
+    hdd_image_unmap(&hdd_images[id]);
+    hdd_image_ov_close(&hdd_images[id]);
+
     if (hdd_images[id].loaded) {
         if (hdd_images[id].file != NULL) {
             fclose(hdd_images[id].file);
@@ -663,6 +1266,10 @@ hdd_image_close(uint8_t id)
 {
     hdd_image_log("hdd_image_close(%i)\n", id);
 
+    hdd_image_io_close(&hdd_images[id]);
+    hdd_image_unmap(&hdd_images[id]);
+    hdd_image_ov_close(&hdd_images[id]);
+
     if (!hdd_images[id].loaded)
         return;
 
@@ -670,6 +1277,13 @@ hdd_image_close(uint8_t id)
         fclose(hdd_images[id].file);
         hdd_images[id].file = NULL;
     } else if (hdd_images[id].vhd != NULL) {
+#ifdef ENABLE_HDD_IMAGE_LOG
+        MVHDCacheStats stats;
+
+        mvhd_get_cache_stats(hdd_images[id].vhd, &stats);
+        hdd_image_log("VHD: Bitmap cache %" PRIu64 " hits, %" PRIu64 " misses; read-ahead %" PRIu64 " hits, %" PRIu64 " misses\n",
+                      stats.bitmap_hits, stats.bitmap_misses, stats.read_ahead_hits, stats.read_ahead_misses);
+#endif
         mvhd_close(hdd_images[id].vhd);
         hdd_images[id].vhd = NULL;
     }
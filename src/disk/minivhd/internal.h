@@ -60,11 +60,20 @@
 
 #define MVHD_START_TS          946684800
 
+#define MVHD_BITMAP_CACHE_ENTRIES 32
+#define MVHD_READ_AHEAD_SECTORS   128
+
 
 typedef struct MVHDSectorBitmap {
     uint8_t* curr_bitmap;
     int      sector_count;
     int      curr_block;
+    /* Copies of recently used sector bitmaps, so that moving between blocks
+       does not have to go back to the file. May be NULL. */
+    uint8_t* cache;
+    int      cache_block[MVHD_BITMAP_CACHE_ENTRIES];
+    uint32_t cache_used[MVHD_BITMAP_CACHE_ENTRIES];
+    uint32_t cache_clock;
 } MVHDSectorBitmap;
 
 typedef struct MVHDFooter {
@@ -128,6 +137,13 @@ struct MVHDMeta {
         uint8_t* zero_data;
         int      sector_count;
     } format_buffer;
+    struct {
+        uint8_t* data;  /* Allocated on the first sequential read */
+        uint32_t start;
+        int      count;
+        uint32_t next;  /* Sector following the previous read */
+    } read_ahead;
+    MVHDCacheStats stats;
 };
 
 
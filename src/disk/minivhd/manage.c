@@ -202,6 +202,14 @@ init_sector_bitmap(MVHDMeta* vhdm, MVHDError* err)
 
     vhdm->bitmap.curr_block = -1;
 
+    /* The bitmap cache is only an optimisation, so carry on without it. */
+    vhdm->bitmap.cache = calloc((size_t) vhdm->bitmap.sector_count * MVHD_BITMAP_CACHE_ENTRIES, MVHD_SECTOR_SIZE);
+    for (int i = 0; i < MVHD_BITMAP_CACHE_ENTRIES; i++) {
+        vhdm->bitmap.cache_block[i] = -1;
+        vhdm->bitmap.cache_used[i] = 0;
+    }
+    vhdm->bitmap.cache_clock = 0;
+
     return 0;
 }
 
@@ -597,6 +605,8 @@ cleanup_format_buff:
 cleanup_bitmap:
     free(vhdm->bitmap.curr_bitmap);
     vhdm->bitmap.curr_bitmap = NULL;
+    free(vhdm->bitmap.cache);
+    vhdm->bitmap.cache = NULL;
 
 cleanup_bat:
     free(vhdm->block_offset);
@@ -634,6 +644,14 @@ mvhd_close(MVHDMeta* vhdm)
         free(vhdm->bitmap.curr_bitmap);
         vhdm->bitmap.curr_bitmap = NULL;
     }
+    if (vhdm->bitmap.cache != NULL) {
+        free(vhdm->bitmap.cache);
+        vhdm->bitmap.cache = NULL;
+    }
+    if (vhdm->read_ahead.data != NULL) {
+        free(vhdm->read_ahead.data);
+        vhdm->read_ahead.data = NULL;
+    }
     if (vhdm->format_buffer.zero_data != NULL) {
         free(vhdm->format_buffer.zero_data);
         vhdm->format_buffer.zero_data = NULL;
@@ -678,16 +696,72 @@ mvhd_diff_update_par_timestamp(MVHDMeta* vhdm, int* err)
 }
 
 
+/**
+ * \brief Drop the read-ahead buffer if it overlaps a range about to be written
+ *
+ * \param [in] vhdm MiniVHD data structure
+ * \param [in] offset The first sector being written
+ * \param [in] num_sectors The number of sectors being written
+ */
+static void
+invalidate_read_ahead(MVHDMeta* vhdm, uint32_t offset, int num_sectors)
+{
+    if (vhdm->read_ahead.count > 0 && num_sectors > 0 &&
+        offset < vhdm->read_ahead.start + (uint32_t) vhdm->read_ahead.count &&
+        vhdm->read_ahead.start < offset + (uint32_t) num_sectors)
+        vhdm->read_ahead.count = 0;
+}
+
+
 MVHDAPI int
 mvhd_read_sectors(MVHDMeta* vhdm, uint32_t offset, int num_sectors, void* out_buff)
 {
-    return vhdm->read_sectors(vhdm, offset, num_sectors, out_buff);
+    uint32_t total_sectors = (uint32_t)(vhdm->footer.curr_sz / MVHD_SECTOR_SIZE);
+    uint32_t sequential = (offset == vhdm->read_ahead.next);
+    int count = MVHD_READ_AHEAD_SECTORS;
+
+    /* Fixed images are plain files, stdio buffering does the job there. */
+    if (vhdm->footer.disk_type == MVHD_TYPE_FIXED || num_sectors <= 0)
+        return vhdm->read_sectors(vhdm, offset, num_sectors, out_buff);
+
+    vhdm->read_ahead.next = offset + num_sectors;
+
+    if (vhdm->read_ahead.count > 0 && offset >= vhdm->read_ahead.start &&
+        (offset + num_sectors) <= (vhdm->read_ahead.start + vhdm->read_ahead.count)) {
+        memcpy(out_buff, &vhdm->read_ahead.data[(offset - vhdm->read_ahead.start) * MVHD_SECTOR_SIZE],
+               (size_t) num_sectors * MVHD_SECTOR_SIZE);
+        vhdm->stats.read_ahead_hits++;
+        return 0;
+    }
+    vhdm->stats.read_ahead_misses++;
+
+    /* Only read ahead of guests that are reading sequentially, and only
+       when the whole request fits in the buffer. */
+    if (offset < total_sectors && (total_sectors - offset) < (uint32_t) count)
+        count = total_sectors - offset;
+    if (!sequential || offset >= total_sectors || num_sectors > count)
+        return vhdm->read_sectors(vhdm, offset, num_sectors, out_buff);
+
+    if (vhdm->read_ahead.data == NULL) {
+        vhdm->read_ahead.data = malloc(MVHD_READ_AHEAD_SECTORS * MVHD_SECTOR_SIZE);
+        if (vhdm->read_ahead.data == NULL)
+            return vhdm->read_sectors(vhdm, offset, num_sectors, out_buff);
+    }
+
+    vhdm->read_sectors(vhdm, offset, count, vhdm->read_ahead.data);
+    vhdm->read_ahead.start = offset;
+    vhdm->read_ahead.count = count;
+    memcpy(out_buff, vhdm->read_ahead.data, (size_t) num_sectors * MVHD_SECTOR_SIZE);
+
+    return 0;
 }
 
 
 MVHDAPI int
 mvhd_write_sectors(MVHDMeta* vhdm, uint32_t offset, int num_sectors, void* in_buff)
 {
+    invalidate_read_ahead(vhdm, offset, num_sectors);
+
     return vhdm->write_sectors(vhdm, offset, num_sectors, in_buff);
 }
 
@@ -695,6 +769,8 @@ mvhd_write_sectors(MVHDMeta* vhdm, uint32_t offset, int num_sectors, void* in_bu
 MVHDAPI int
 mvhd_format_sectors(MVHDMeta* vhdm, uint32_t offset, int num_sectors)
 {
+    invalidate_read_ahead(vhdm, offset, num_sectors);
+
     int num_full = num_sectors / vhdm->format_buffer.sector_count;
     int remain = num_sectors % vhdm->format_buffer.sector_count;
 
@@ -714,3 +790,18 @@ mvhd_get_type(MVHDMeta* vhdm)
 {
     return vhdm->footer.disk_type;
 }
+
+
+MVHDAPI void
+mvhd_get_cache_stats(MVHDMeta* vhdm, MVHDCacheStats* stats)
+{
+    stats->read_ahead_hits = vhdm->stats.read_ahead_hits;
+    stats->read_ahead_misses = vhdm->stats.read_ahead_misses;
+    stats->bitmap_hits = 0;
+    stats->bitmap_misses = 0;
+
+    for (MVHDMeta* curr = vhdm; curr != NULL; curr = curr->parent) {
+        stats->bitmap_hits += curr->stats.bitmap_hits;
+        stats->bitmap_misses += curr->stats.bitmap_misses;
+    }
+}
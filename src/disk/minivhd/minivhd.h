@@ -103,6 +103,13 @@ typedef struct MVHDCreationOptions {
 
 typedef struct MVHDMeta MVHDMeta;
 
+typedef struct MVHDCacheStats {
+    uint64_t bitmap_hits;     /** Sector bitmaps found in the bitmap cache */
+    uint64_t bitmap_misses;   /** Sector bitmaps read from the file */
+    uint64_t read_ahead_hits; /** Reads served from the read-ahead buffer */
+    uint64_t read_ahead_misses;
+} MVHDCacheStats;
+
 
 extern int mvhd_errno;
 
@@ -395,6 +402,16 @@ MVHDAPI int mvhd_write_sectors(MVHDMeta* vhdm, uint32_t offset, int num_sectors,
  */
 MVHDAPI int mvhd_format_sectors(MVHDMeta* vhdm, uint32_t offset, int num_sectors);
 
+/**
+ * \brief Get the block cache statistics of a VHD
+ *
+ * Bitmap counters are summed over the whole differencing chain.
+ *
+ * \param [in] vhdm MiniVHD data structure
+ * \param [out] stats the cache hit and miss counters
+ */
+MVHDAPI void mvhd_get_cache_stats(MVHDMeta* vhdm, MVHDCacheStats* stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -86,11 +86,43 @@ mvhd_write_empty_sectors(FILE *f, int sector_count)
         fwrite(zero_bytes, sizeof zero_bytes, 1, f);
 }
 
+/**
+ * \brief Store the current sector bitmap in the bitmap cache
+ *
+ * Replaces the cached copy of the same block, or else the least recently
+ * used entry.
+ *
+ * \param [in] vhdm MiniVHD data structure
+ */
+static void
+cache_curr_sect_bitmap(MVHDMeta *vhdm)
+{
+    int bm_size = vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE;
+    int victim = 0;
+
+    if (vhdm->bitmap.cache == NULL || vhdm->bitmap.curr_block < 0)
+        return;
+
+    for (int i = 0; i < MVHD_BITMAP_CACHE_ENTRIES; i++) {
+        if (vhdm->bitmap.cache_block[i] == vhdm->bitmap.curr_block) {
+            victim = i;
+            break;
+        }
+        if (vhdm->bitmap.cache_used[i] < vhdm->bitmap.cache_used[victim])
+            victim = i;
+    }
+
+    vhdm->bitmap.cache_block[victim] = vhdm->bitmap.curr_block;
+    vhdm->bitmap.cache_used[victim] = ++vhdm->bitmap.cache_clock;
+    memcpy(&vhdm->bitmap.cache[victim * bm_size], vhdm->bitmap.curr_bitmap, bm_size);
+}
+
 /**
  * \brief Read the sector bitmap for a block.
  *
  * If the block is sparse, the sector bitmap in memory will be
- * zeroed. Otherwise, the sector bitmap is read from the VHD file.
+ * zeroed. Otherwise, the sector bitmap is taken from the bitmap
+ * cache, or read from the VHD file.
  *
  * \param [in] vhdm MiniVHD data structure
  * \param [in] blk The block for which to read the sector bitmap from
@@ -98,13 +130,31 @@ mvhd_write_empty_sectors(FILE *f, int sector_count)
 static void
 read_sect_bitmap(MVHDMeta *vhdm, int blk)
 {
-    if (vhdm->block_offset[blk] != MVHD_SPARSE_BLK) {
-        mvhd_fseeko64(vhdm->f, (uint64_t)vhdm->block_offset[blk] * MVHD_SECTOR_SIZE, SEEK_SET);
-        (void) !fread(vhdm->bitmap.curr_bitmap, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE, 1, vhdm->f);
-    } else
-        memset(vhdm->bitmap.curr_bitmap, 0, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE);
+    int bm_size = vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE;
 
     vhdm->bitmap.curr_block = blk;
+
+    if (vhdm->block_offset[blk] == MVHD_SPARSE_BLK) {
+        memset(vhdm->bitmap.curr_bitmap, 0, bm_size);
+        return;
+    }
+
+    if (vhdm->bitmap.cache != NULL) {
+        for (int i = 0; i < MVHD_BITMAP_CACHE_ENTRIES; i++) {
+            if (vhdm->bitmap.cache_block[i] == blk) {
+                memcpy(vhdm->bitmap.curr_bitmap, &vhdm->bitmap.cache[i * bm_size], bm_size);
+                vhdm->bitmap.cache_used[i] = ++vhdm->bitmap.cache_clock;
+                vhdm->stats.bitmap_hits++;
+                return;
+            }
+        }
+    }
+
+    mvhd_fseeko64(vhdm->f, (uint64_t)vhdm->block_offset[blk] * MVHD_SECTOR_SIZE, SEEK_SET);
+    (void) !fread(vhdm->bitmap.curr_bitmap, bm_size, 1, vhdm->f);
+    vhdm->stats.bitmap_misses++;
+
+    cache_curr_sect_bitmap(vhdm);
 }
 
 /**
@@ -119,6 +169,7 @@ write_curr_sect_bitmap(MVHDMeta* vhdm)
         int64_t abs_offset = (int64_t)vhdm->block_offset[vhdm->bitmap.curr_block] * MVHD_SECTOR_SIZE;
         mvhd_fseeko64(vhdm->f, abs_offset, SEEK_SET);
         fwrite(vhdm->bitmap.curr_bitmap, MVHD_SECTOR_SIZE, vhdm->bitmap.sector_count, vhdm->f);
+        cache_curr_sect_bitmap(vhdm);
     }
 }
 
@@ -223,38 +274,70 @@ mvhd_sparse_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buf
     int64_t addr = 0ULL;
     uint32_t s = 0;
     uint32_t ls = 0;
+    uint32_t n = 0;
+    uint32_t k = 0;
     int blk = 0;
-    int prev_blk = -1;
     int sib = 0;
+    int present = 0;
     ls = offset + transfer_sectors;
 
-    for (s = offset; s < ls; s++) {
+    for (s = offset; s < ls; s += n) {
         blk = s / vhdm->sect_per_block;
         sib = s % vhdm->sect_per_block;
-        if (blk != prev_blk) {
-            prev_blk = blk;
-            if (vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(vhdm, blk);
-                mvhd_fseeko64(vhdm->f, (uint64_t)sib * MVHD_SECTOR_SIZE, SEEK_CUR);
-            } else {
-                addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
-                       MVHD_SECTOR_SIZE;
-                mvhd_fseeko64(vhdm->f, addr, SEEK_SET);
-            }
-        }
+        if (vhdm->bitmap.curr_block != blk)
+            read_sect_bitmap(vhdm, blk);
 
-        if (VHD_TESTBIT(vhdm->bitmap.curr_bitmap, sib))
-            (void) !fread(buff, MVHD_SECTOR_SIZE, 1, vhdm->f);
-        else {
-            memset(buff, 0, MVHD_SECTOR_SIZE);
-            mvhd_fseeko64(vhdm->f, MVHD_SECTOR_SIZE, SEEK_CUR);
+        /* Gather the run of sectors in this block that are all present, or
+           all absent, so that each run costs a single read. */
+        present = !!VHD_TESTBIT(vhdm->bitmap.curr_bitmap, sib);
+        for (n = 1; (s + n) < ls && (sib + n) < (uint32_t) vhdm->sect_per_block; n++) {
+            k = sib + n;
+            if (!!VHD_TESTBIT(vhdm->bitmap.curr_bitmap, k) != present)
+                break;
         }
-        buff += MVHD_SECTOR_SIZE;
+
+        if (present) {
+            addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
+                   MVHD_SECTOR_SIZE;
+            mvhd_fseeko64(vhdm->f, addr, SEEK_SET);
+            (void) !fread(buff, MVHD_SECTOR_SIZE, n, vhdm->f);
+        } else
+            memset(buff, 0, (size_t) n * MVHD_SECTOR_SIZE);
+        buff += n * MVHD_SECTOR_SIZE;
     }
 
     return truncated_sectors;
 }
 
+/**
+ * \brief Find the image in a differencing chain that holds a sector
+ *
+ * \param [in] vhdm MiniVHD data structure of the child
+ * \param [in] s The sector to look up
+ *
+ * \return the first image in the chain whose sector bitmap has the sector,
+ * or the fixed or dynamic image at the root of the chain
+ */
+static MVHDMeta*
+diff_sector_owner(MVHDMeta *vhdm, uint32_t s)
+{
+    MVHDMeta *curr_vhdm = vhdm;
+    int blk = 0;
+    int sib = 0;
+
+    while (curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) {
+        blk = s / curr_vhdm->sect_per_block;
+        sib = s % curr_vhdm->sect_per_block;
+        if (curr_vhdm->bitmap.curr_block != blk)
+            read_sect_bitmap(curr_vhdm, blk);
+        if (VHD_TESTBIT(curr_vhdm->bitmap.curr_bitmap, sib))
+            break;
+        curr_vhdm = curr_vhdm->parent;
+    }
+
+    return curr_vhdm;
+}
+
 int
 mvhd_diff_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
 {
@@ -265,35 +348,30 @@ mvhd_diff_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
     check_sectors(offset, num_sectors, total_sectors, &transfer_sectors, &truncated_sectors);
 
     uint8_t *buff = (uint8_t*)out_buff;
-    MVHDMeta *curr_vhdm = vhdm;
+    MVHDMeta *curr_vhdm = NULL;
     uint32_t s = 0;
     uint32_t ls = 0;
-    int blk = 0;
-    int sib = 0;
+    uint32_t n = 0;
     ls = offset + transfer_sectors;
 
-    for (s = offset; s < ls; s++) {
-        while (curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) {
-            blk = s / curr_vhdm->sect_per_block;
-            sib = s % curr_vhdm->sect_per_block;
-            if (curr_vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(curr_vhdm, blk);
-            }
-            if (!VHD_TESTBIT(curr_vhdm->bitmap.curr_bitmap, sib)) {
-                curr_vhdm = curr_vhdm->parent;
-            } else { break; }
+    for (s = offset; s < ls; s += n) {
+        curr_vhdm = diff_sector_owner(vhdm, s);
+
+        /* Read the whole run of sectors that live in the same image at once */
+        for (n = 1; (s + n) < ls; n++) {
+            if (diff_sector_owner(vhdm, s + n) != curr_vhdm)
+                break;
         }
 
         /* We handle actual sector reading using the fixed or sparse functions,
            as a differencing VHD is also a sparse VHD */
         if ((curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) ||
             (curr_vhdm->footer.disk_type == MVHD_TYPE_DYNAMIC))
-            mvhd_sparse_read(curr_vhdm, s, 1, buff);
+            mvhd_sparse_read(curr_vhdm, s, n, buff);
         else
-            mvhd_fixed_read(curr_vhdm, s, 1, buff);
+            mvhd_fixed_read(curr_vhdm, s, n, buff);
 
-        curr_vhdm = vhdm;
-        buff += MVHD_SECTOR_SIZE;
+        buff += n * MVHD_SECTOR_SIZE;
     }
 
     return truncated_sectors;
@@ -350,14 +428,12 @@ mvhd_sparse_diff_write(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *i
         }
 
         if (blk != prev_blk) {
-            if (vhdm->bitmap.curr_block != blk) {
+            /* The bitmap may come from the cache, so always seek explicitly */
+            if (vhdm->bitmap.curr_block != blk)
                 read_sect_bitmap(vhdm, blk);
-                mvhd_fseeko64(vhdm->f, (uint64_t)sib * MVHD_SECTOR_SIZE, SEEK_CUR);
-            } else {
-                addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
-                       MVHD_SECTOR_SIZE;
-                mvhd_fseeko64(vhdm->f, addr, SEEK_SET);
-            }
+            addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
+                   MVHD_SECTOR_SIZE;
+            mvhd_fseeko64(vhdm->f, addr, SEEK_SET);
             prev_blk = blk;
         }
 
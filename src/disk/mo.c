@@ -693,6 +693,10 @@ mo_command_common(mo_t *dev)
 
         period        = 1000000.0 / bytes_per_second;
         dev->callback = period * (double) (dev->packet_len);
+
+        /* Turbo drives only take the command overhead. */
+        if (dev->drv->turbo && (dev->callback > MO_TIME))
+            dev->callback = MO_TIME;
     }
 
     mo_set_callback(dev);
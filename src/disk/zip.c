@@ -867,6 +867,10 @@ zip_command_common(zip_t *dev)
 
         period        = 1000000.0 / bytes_per_second;
         dev->callback = period * (double) (dev->packet_len);
+
+        /* Turbo drives only take the command overhead. */
+        if (dev->drv->turbo && (dev->callback > ZIP_TIME))
+            dev->callback = ZIP_TIME;
     }
 
     zip_set_callback(dev);
@@ -32,6 +32,7 @@
 #include <86box/io.h>
 #include <86box/pic.h>
 #include <86box/dma.h>
+#include <86box/snapshot.h>
 #include <86box/plat_unused.h>
 
 dma_t   dma[8];
@@ -1562,27 +1563,37 @@ dma_channel_advance(int channel)
     return tc;
 }
 
-int
-dma_channel_read(int channel)
+/* Whether the channel is set up to be read from. */
+static int
+dma_channel_read_ready(int channel)
 {
-    dma_t   *dma_c = &dma[channel];
-    uint16_t temp;
-    int      tc = 0;
+    const dma_t *dma_c = &dma[channel];
 
     if (channel < 4) {
         if (dma_command[0] & 0x04)
-            return (DMA_NODATA);
+            return 0;
     } else {
         if (dma_command[1] & 0x04)
-            return (DMA_NODATA);
+            return 0;
     }
 
     if (!(dma_e & (1 << channel)))
-        return (DMA_NODATA);
+        return 0;
     if ((dma_m & (1 << channel)) && !dma_req_is_soft)
-        return (DMA_NODATA);
+        return 0;
     if ((dma_c->mode & 0xC) != 8)
-        return (DMA_NODATA);
+        return 0;
+
+    return 1;
+}
+
+/* Transfers one unit from a channel that is ready to be read from. */
+static int
+dma_channel_read_unit(int channel)
+{
+    dma_t   *dma_c = &dma[channel];
+    uint16_t temp;
+    int      tc = 0;
 
     if (dma_stat_adv_pend & (1 << channel))
         dma_channel_advance(channel);
@@ -1658,24 +1669,64 @@ dma_channel_read(int channel)
 }
 
 int
-dma_channel_write(int channel, uint16_t val)
+dma_channel_read(int channel)
 {
-    dma_t *dma_c = &dma[channel];
+    if (!dma_channel_read_ready(channel))
+        return (DMA_NODATA);
+
+    return dma_channel_read_unit(channel);
+}
+
+/* Reads up to len units in one go, each stored as dma_channel_read() would
+   have returned it. Only terminal count can change whether the channel is
+   ready, so it is checked once and the block ends after the unit that
+   reached it. Returns the number of units read. */
+int
+dma_channel_read_block(int channel, int *buf, int len)
+{
+    int c;
+
+    if (!dma_channel_read_ready(channel))
+        return 0;
+
+    for (c = 0; c < len; ) {
+        buf[c] = dma_channel_read_unit(channel);
+        if (buf[c++] & DMA_OVER)
+            break;
+    }
+
+    return c;
+}
+
+/* Whether the channel is set up to be written to. */
+static int
+dma_channel_write_ready(int channel)
+{
+    const dma_t *dma_c = &dma[channel];
 
     if (channel < 4) {
         if (dma_command[0] & 0x04)
-            return (DMA_NODATA);
+            return 0;
     } else {
         if (dma_command[1] & 0x04)
-            return (DMA_NODATA);
+            return 0;
     }
 
     if (!(dma_e & (1 << channel)))
-        return (DMA_NODATA);
+        return 0;
     if ((dma_m & (1 << channel)) && !dma_req_is_soft)
-        return (DMA_NODATA);
+        return 0;
     if ((dma_c->mode & 0xC) != 4)
-        return (DMA_NODATA);
+        return 0;
+
+    return 1;
+}
+
+/* Transfers one unit to a channel that is ready to be written to. */
+static int
+dma_channel_write_unit(int channel, uint16_t val)
+{
+    dma_t *dma_c = &dma[channel];
 
     if (!dma_c->size) {
         _dma_write(dma_c->ac, val & 0xff, dma_c);
@@ -1746,6 +1797,33 @@ dma_channel_write(int channel, uint16_t val)
     return 0;
 }
 
+int
+dma_channel_write(int channel, uint16_t val)
+{
+    if (!dma_channel_write_ready(channel))
+        return (DMA_NODATA);
+
+    return dma_channel_write_unit(channel, val);
+}
+
+/* Writes up to len units in one go, the block ends after the unit that
+   reached terminal count. Returns the number of units written. */
+int
+dma_channel_write_block(int channel, const uint16_t *buf, int len)
+{
+    int c;
+
+    if (!dma_channel_write_ready(channel))
+        return 0;
+
+    for (c = 0; c < len; ) {
+        if (dma_channel_write_unit(channel, buf[c++]) & DMA_OVER)
+            break;
+    }
+
+    return c;
+}
+
 static void
 dma_ps2_run(int channel)
 {
@@ -1841,8 +1919,8 @@ dma_mode(int channel)
 }
 
 /* DMA Bus Master Page Read/Write */
-void
-dma_bm_read(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize, int TransferSize)
+static void
+dma_bm_read_slow(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize, int TransferSize)
 {
     uint32_t n;
     uint32_t n2;
@@ -1864,8 +1942,8 @@ dma_bm_read(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize, int Tra
     }
 }
 
-void
-dma_bm_write(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize, int TransferSize)
+static void
+dma_bm_write_slow(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize, int TransferSize)
 {
     uint32_t n;
     uint32_t n2;
@@ -1886,7 +1964,84 @@ dma_bm_write(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize,
         memcpy(bytes, (void *) &(DataWrite[n]), n2);
         mem_write_phys((void *) bytes, PhysAddress + n, TransferSize);
     }
+}
+
+/* Bus master transfers are split at memory granularity boundaries. Granules
+   backed by plain RAM are copied with a single memcpy each, everything else
+   (MMIO, ROM, mappings with handlers) is accumulated into runs that go through
+   the regular phys accessors in TransferSize units, exactly as before. */
+void
+dma_bm_read(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize, int TransferSize)
+{
+    uint32_t       pos      = 0;
+    uint32_t       slow_pos = 0;
+    uint32_t       chunk;
+    const uint8_t *ptr;
+
+    while (pos < TotalSize) {
+        chunk = MEM_GRANULARITY_SIZE - ((PhysAddress + pos) & MEM_GRANULARITY_MASK);
+        if (chunk > (TotalSize - pos))
+            chunk = TotalSize - pos;
+
+        ptr = mem_get_phys_ptr(PhysAddress + pos, chunk, 0);
+        if (ptr != NULL) {
+            if (slow_pos < pos)
+                dma_bm_read_slow(PhysAddress + slow_pos, &(DataRead[slow_pos]), pos - slow_pos, TransferSize);
+            memcpy(&(DataRead[pos]), ptr, chunk);
+            slow_pos = pos + chunk;
+        }
+
+        pos += chunk;
+    }
+
+    if (slow_pos < TotalSize)
+        dma_bm_read_slow(PhysAddress + slow_pos, &(DataRead[slow_pos]), TotalSize - slow_pos, TransferSize);
+}
+
+void
+dma_bm_write(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize, int TransferSize)
+{
+    uint32_t pos      = 0;
+    uint32_t slow_pos = 0;
+    uint32_t chunk;
+    uint8_t *ptr;
+
+    while (pos < TotalSize) {
+        chunk = MEM_GRANULARITY_SIZE - ((PhysAddress + pos) & MEM_GRANULARITY_MASK);
+        if (chunk > (TotalSize - pos))
+            chunk = TotalSize - pos;
+
+        ptr = mem_get_phys_ptr(PhysAddress + pos, chunk, 1);
+        if (ptr != NULL) {
+            if (slow_pos < pos)
+                dma_bm_write_slow(PhysAddress + slow_pos, &(DataWrite[slow_pos]), pos - slow_pos, TransferSize);
+            memcpy(ptr, &(DataWrite[pos]), chunk);
+            slow_pos = pos + chunk;
+        }
+
+        pos += chunk;
+    }
+
+    if (slow_pos < TotalSize)
+        dma_bm_write_slow(PhysAddress + slow_pos, &(DataWrite[slow_pos]), TotalSize - slow_pos, TransferSize);
 
     if (dma_at)
         mem_invalidate_range(PhysAddress, PhysAddress + TotalSize - 1);
 }
+
+void
+dma_snapshot(snapshot_t *snap)
+{
+    snapshot_var(snap, dma);
+    snapshot_var(snap, dma_e);
+    snapshot_var(snap, dma_m);
+    snapshot_var(snap, dmaregs);
+    snapshot_var(snap, dma_wp);
+    snapshot_var(snap, dma_stat);
+    snapshot_var(snap, dma_stat_rq);
+    snapshot_var(snap, dma_stat_rq_pc);
+    snapshot_var(snap, dma_stat_adv_pend);
+    snapshot_var(snap, dma_command);
+    snapshot_var(snap, dma_req_is_soft);
+    snapshot_var(snap, dma_sg_base);
+}
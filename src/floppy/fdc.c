@@ -608,6 +608,16 @@ real_drive(fdc_t *fdc, int drive)
         return drive;
 }
 
+/* Seeks and recalibrations on turbo drives complete almost at once. */
+static uint64_t
+fdc_seek_time(fdc_t *fdc, uint64_t usec)
+{
+    if (fdd_get_turbo(real_drive(fdc, fdc->rw_drive)))
+        return 8 * TIMER_USEC;
+
+    return usec * TIMER_USEC;
+}
+
 void
 fdc_seek(fdc_t *fdc, int drive, int params)
 {
@@ -1022,9 +1032,9 @@ fdc_write(uint16_t addr, uint8_t val, void *priv)
                         case 0x07: /* Recalibrate */
                         case 0x0f: /* Seek */
                             if (fdc->flags & FDC_FLAG_PCJR)
-                                timer_set_delay_u64(&fdc->timer, 1000 * TIMER_USEC);
+                                timer_set_delay_u64(&fdc->timer, fdc_seek_time(fdc, 1000));
                             else
-                                timer_set_delay_u64(&fdc->timer, 256 * TIMER_USEC);
+                                timer_set_delay_u64(&fdc->timer, fdc_seek_time(fdc, 256));
                             break;
                         default:
                             timer_set_delay_u64(&fdc->timer, 256 * TIMER_USEC);
@@ -1739,7 +1749,7 @@ fdc_callback(void *priv)
                 fdc->interrupt = -4;
             } else
                 fdc->interrupt = -3;
-            timer_set_delay_u64(&fdc->timer, 2048 * TIMER_USEC);
+            timer_set_delay_u64(&fdc->timer, fdc_seek_time(fdc, 2048));
             fdc->stat = 0x80 | (1 << fdc->rw_drive);
             return;
         case 0x0d: /*Format track*/
@@ -1787,7 +1797,7 @@ fdc_callback(void *priv)
             if (fdc->flags & FDC_FLAG_PCJR) {
                 fdc->fintr     = 1;
                 fdc->interrupt = -4;
-                timer_set_delay_u64(&fdc->timer, 1024 * TIMER_USEC);
+                timer_set_delay_u64(&fdc->timer, fdc_seek_time(fdc, 1024));
             } else {
                 fdc->interrupt = -3;
                 fdc_callback(fdc);
@@ -38,6 +38,18 @@
 #include <86box/fdd_86f.h>
 #ifdef D86F_COMPRESS
 #    include <lzf.h>
+
+/*
+ * Chunked compressed images ("86bc") have the same 8 byte header and track
+ * table as a plain 86F, but each table entry points to a block holding
+ * that track alone: a 12 byte header (space reserved for the data, length
+ * of the data, length of the track once decompressed) followed by the LZF
+ * data, or by the track itself if it did not compress. Tracks are
+ * decompressed when first read, and a write-back recompresses only the
+ * tracks that were written, in place if the new block fits.
+ */
+#    define D86F_CHUNKED_MAGIC 0x63623638
+#    define D86F_LZF_MAGIC     0x66623638
 #endif
 
 /*
@@ -160,6 +172,20 @@ typedef struct sector_t {
     void   *prev;
 } sector_t;
 
+/* Number of tracks of a sector image kept encoded per drive. */
+#define D86F_TRACK_CACHE 32
+
+/* An encoded track of a sector image, as its seek routine built it. */
+typedef struct d86f_cached_track_t {
+    int         track; /* -1 if unused */
+    uint32_t    stamp;
+    uint32_t    words[2];
+    uint16_t   *encoded_data[2];
+    sector_t   *sectors[2]; /* Oldest first, as they were prepared. */
+    int         sectors_num[2];
+    sector_id_t last_sector;
+} d86f_cached_track_t;
+
 /* Disk flags:
  *  Bit 0   Has surface data (1 = yes, 0 = no)
  *  Bits 2, 1   Hole (3 = ED + 2000 kbps, 2 = ED, 1 = HD, 0 = DD)
@@ -202,12 +228,18 @@ typedef struct d86f_t {
     uint16_t  current_bit[2];
     uint16_t  last_word[2];
 #ifdef D86F_COMPRESS
-    int is_compressed;
+    int      is_compressed;
+    int      is_chunked;
+    FILE    *chunk_fp; /* The compressed image, the tracks are in fp. */
+    uint32_t chunk_offset[512];
+    uint8_t  chunk_loaded[512];
+    uint8_t  chunk_dirty[512];
 #endif
     int32_t     extra_bit_cells[2];
     uint32_t    file_size;
     uint32_t    index_count;
     uint32_t    track_pos;
+    uint32_t    poll_words;
     uint32_t    datac;
     uint32_t    id_pos;
     uint32_t    dma_over;
@@ -223,6 +255,9 @@ typedef struct d86f_t {
     uint8_t    *filebuf;
     uint8_t    *outbuf;
     sector_t   *last_side_sector[2];
+
+    d86f_cached_track_t *track_cache;
+    uint32_t             track_cache_stamp;
 } d86f_t;
 
 static const uint8_t encoded_fm[64] = {
@@ -257,6 +292,8 @@ void     d86f_writeback(int drive);
 uint8_t  d86f_poll_read_data(int drive, int side, uint16_t pos);
 void     d86f_poll_write_data(int drive, int side, uint16_t pos, uint8_t data);
 int      d86f_format_conditions(int drive);
+static void d86f_poll_bit(int drive, int side, int mfm);
+static void d86f_poll_words(int drive, int side, int mfm);
 
 #ifdef ENABLE_D86F_LOG
 int d86f_do_log = ENABLE_D86F_LOG;
@@ -767,12 +804,38 @@ d86f_get_encoding(int drive)
     return (d86f_track_flags(drive) & 0x18) >> 3;
 }
 
+/* Tracks that are word aligned, with the index hole on a word boundary and
+   no weak bits, are polled a word of bit cells at a time; anything else gets
+   one poll per bit cell so copy protection sees every transition. */
+static int
+d86f_can_poll_words(int drive)
+{
+    const d86f_t *dev = d86f[drive];
+    int           side;
+
+    if ((dev->track_pos & 15) || d86f_has_surface_desc(drive) ||
+        (dev->state == STATE_0D_FORMAT_TRACK))
+        return 0;
+
+    side = fdd_get_head(drive);
+    if (!fdd_is_double_sided(drive))
+        side = 0;
+
+    return !(d86f_handler[drive].get_raw_size(drive, side) & 15) &&
+           !(d86f_handler[drive].index_hole_pos(drive, side) & 15);
+}
+
 uint64_t
 d86f_byteperiod(int drive)
 {
     double dusec = (double) TIMER_USEC;
     double p     = 2.0;
 
+    /* Turbo mode services proxied images a byte per poll; real 86F
+       images keep their bit cell timing, as they need it. */
+    if (fdd_get_turbo(drive) && (d86f[drive]->version == 0x0063))
+        return 32ULL * TIMER_USEC;
+
     switch (d86f_track_flags(drive) & 0x0f) {
         case 0x02: /* 125 kbps, FM */
             p = 4.0;
@@ -799,6 +862,11 @@ d86f_byteperiod(int drive)
             break;
     }
 
+    /* A poll covers a whole word of bit cells on standard tracks. */
+    d86f[drive]->poll_words = d86f_can_poll_words(drive);
+    if (d86f[drive]->poll_words)
+        return ((uint64_t) (p * dusec)) << 4;
+
     return (uint64_t) (p * dusec);
 }
 
@@ -1121,6 +1189,19 @@ d86f_get_bit(int drive, int side)
         dev->last_word[side] |= current_bit;
 }
 
+/* Shifts in a whole aligned word at once, the same as sixteen d86f_get_bit() calls without weak bits. */
+static void
+d86f_get_word(int drive, int side)
+{
+    d86f_t  *dev          = d86f[drive];
+    uint16_t encoded_data = d86f_handler[drive].encoded_data(drive, side)[dev->track_pos >> 4];
+
+    if (!d86f_reverse_bytes(drive))
+        encoded_data = (uint16_t) ((encoded_data << 8) | (encoded_data >> 8));
+
+    dev->last_word[side] = encoded_data;
+}
+
 void
 d86f_put_bit(int drive, int side, int bit)
 {
@@ -2442,6 +2523,19 @@ d86f_poll(int drive)
         return;
     }
 
+    if (dev->poll_words) {
+        d86f_poll_words(drive, side, mfm);
+        return;
+    }
+
+    d86f_poll_bit(drive, side, mfm);
+}
+
+static void
+d86f_poll_bit(int drive, int side, int mfm)
+{
+    d86f_t *dev = d86f[drive];
+
     if ((dev->state != STATE_IDLE) && (dev->state != STATE_SECTOR_NOT_FOUND) && ((dev->state & 0xF8) != 0xE8)) {
         if (!d86f_can_read_address(drive))
             dev->state = STATE_SECTOR_NOT_FOUND;
@@ -2608,6 +2702,33 @@ d86f_poll(int drive)
     }
 }
 
+static void
+d86f_poll_words(int drive, int side, int mfm)
+{
+    d86f_t *dev = d86f[drive];
+
+    if (dev->state == STATE_IDLE) {
+        d86f_get_word(drive, side ^ 1);
+        d86f_get_word(drive, side);
+
+        dev->track_pos += 16;
+        dev->track_pos %= d86f_handler[drive].get_raw_size(drive, side);
+
+        if (dev->track_pos == d86f_handler[drive].index_hole_pos(drive, side))
+            d86f_handler[drive].read_revolution(drive);
+        return;
+    }
+
+    /* Commands still run bit by bit, only without a timer event for each one. */
+    for (int i = 0; i < 16; i++) {
+        d86f_poll_bit(drive, side, mfm);
+
+        /* Formatting already writes a word per poll. */
+        if (dev->state == STATE_0D_FORMAT_TRACK)
+            break;
+    }
+}
+
 void
 d86f_reset_index_hole_pos(int drive, int side)
 {
@@ -2914,6 +3035,198 @@ d86f_track_header_size(int drive)
     return temp;
 }
 
+#ifdef D86F_COMPRESS
+static int
+d86f_chunk_entries(const d86f_t *dev)
+{
+    return (dev->disk_flags & 0x08) ? 512 : 256;
+}
+
+/* Size of a track in the uncompressed file, up to the next track or the end. */
+static uint32_t
+d86f_chunk_track_size(const d86f_t *dev, int track, int entries)
+{
+    uint32_t next = dev->file_size;
+
+    for (int i = 0; i < entries; i++) {
+        if ((dev->track_offset[i] > dev->track_offset[track]) && (dev->track_offset[i] < next))
+            next = dev->track_offset[i];
+    }
+
+    return next - dev->track_offset[track];
+}
+
+/* Decompresses a track into the uncompressed file the first time it is read. */
+static void
+d86f_chunk_load(int drive, int track)
+{
+    d86f_t  *dev = d86f[drive];
+    uint32_t blk[3];
+    uint8_t *in;
+    uint8_t *out;
+
+    if (!dev->is_chunked || dev->chunk_loaded[track])
+        return;
+    dev->chunk_loaded[track] = 1;
+
+    /* Added since the image was loaded, it has been written already. */
+    if (!dev->chunk_offset[track])
+        return;
+
+    if ((fseek(dev->chunk_fp, dev->chunk_offset[track], SEEK_SET) == -1) || (fread(blk, 4, 3, dev->chunk_fp) != 3))
+        fatal("d86f_chunk_load(): Error reading the block header of track %i\n", track);
+
+    in  = (uint8_t *) malloc(blk[1]);
+    out = (uint8_t *) malloc(blk[2]);
+    if (fread(in, 1, blk[1], dev->chunk_fp) != blk[1])
+        fatal("d86f_chunk_load(): Error reading track %i\n", track);
+
+    if (blk[1] == blk[2])
+        memcpy(out, in, blk[2]);
+    else if (lzf_decompress(in, blk[1], out, blk[2]) != blk[2])
+        fatal("d86f_chunk_load(): Error decompressing track %i\n", track);
+
+    if ((fseek(dev->fp, dev->track_offset[track], SEEK_SET) == -1) || (fwrite(out, 1, blk[2], dev->fp) != blk[2]))
+        fatal("d86f_chunk_load(): Error writing track %i\n", track);
+
+    free(out);
+    free(in);
+}
+
+/* Recompresses the tracks written since the last write-back. */
+static void
+d86f_chunk_writeback(int drive)
+{
+    d86f_t  *dev     = d86f[drive];
+    uint32_t magic   = D86F_CHUNKED_MAGIC;
+    int      entries = d86f_chunk_entries(dev);
+    uint32_t blk[3];
+    uint32_t len;
+    uint32_t clen;
+    uint8_t *in;
+    uint8_t *out;
+    int      append;
+
+    if (!dev->is_chunked) {
+        /* A whole file LZF image is rewritten in the chunked layout, all tracks at once. */
+        dev->chunk_fp = plat_fopen(dev->original_file_name, "wb+");
+        if (!dev->chunk_fp) {
+            d86f_log("86F: Unable to rewrite the compressed image\n");
+            return;
+        }
+
+        memset(dev->chunk_offset, 0x00, sizeof(dev->chunk_offset));
+        memset(dev->chunk_loaded, 0x01, sizeof(dev->chunk_loaded));
+        memset(dev->chunk_dirty, 0x01, sizeof(dev->chunk_dirty));
+
+        fwrite(&magic, 4, 1, dev->chunk_fp);
+        fwrite(&dev->version, 2, 1, dev->chunk_fp);
+        fwrite(&dev->disk_flags, 2, 1, dev->chunk_fp);
+        fwrite(dev->chunk_offset, 4, entries, dev->chunk_fp);
+        dev->is_chunked = 1;
+    }
+
+    for (int i = 0; i < entries; i++) {
+        if (!dev->track_offset[i] || !dev->chunk_dirty[i])
+            continue;
+        dev->chunk_dirty[i] = 0;
+
+        len = d86f_chunk_track_size(dev, i, entries);
+        in  = (uint8_t *) malloc(len);
+        out = (uint8_t *) malloc(len);
+        if ((fseek(dev->fp, dev->track_offset[i], SEEK_SET) == -1) || (fread(in, 1, len, dev->fp) != len))
+            fatal("d86f_chunk_writeback(): Error reading track %i\n", i);
+
+        /* Store the track as it is if it does not compress. */
+        clen = lzf_compress(in, len, out, len - 1);
+        if (!clen) {
+            clen = len;
+            memcpy(out, in, len);
+        }
+
+        /* Rewrite the block in place if the data still fits in it, else move it to the end. */
+        append = 1;
+        if (dev->chunk_offset[i] && (fseek(dev->chunk_fp, dev->chunk_offset[i], SEEK_SET) != -1) &&
+            (fread(blk, 4, 1, dev->chunk_fp) == 1) && (blk[0] >= clen))
+            append = 0;
+        if (append) {
+            fseek(dev->chunk_fp, 0, SEEK_END);
+            dev->chunk_offset[i] = ftell(dev->chunk_fp);
+            blk[0]               = clen + (clen >> 3) + 64;
+        }
+        blk[1] = clen;
+        blk[2] = len;
+
+        if ((fseek(dev->chunk_fp, dev->chunk_offset[i], SEEK_SET) == -1) || (fwrite(blk, 4, 3, dev->chunk_fp) != 3) ||
+            (fwrite(out, 1, clen, dev->chunk_fp) != clen))
+            fatal("d86f_chunk_writeback(): Error writing track %i\n", i);
+        if (append) {
+            /* Room for the track to compress worse next time. */
+            memset(out, 0x00, blk[0] - clen);
+            fwrite(out, 1, blk[0] - clen, dev->chunk_fp);
+        }
+
+        free(out);
+        free(in);
+    }
+
+    if ((fseek(dev->chunk_fp, 8, SEEK_SET) == -1) || (fwrite(dev->chunk_offset, 4, entries, dev->chunk_fp) != entries))
+        fatal("d86f_chunk_writeback(): Error writing the track table\n");
+    fflush(dev->chunk_fp);
+}
+
+/* Opens a chunked image: the uncompressed file gets the header and the track
+   table of a plain 86F, with the tracks left to be filled in when read. */
+static int
+d86f_chunk_open(d86f_t *dev, char *fn, char *temp_file_name, int read_only)
+{
+    uint32_t magic   = 0x46423638;
+    int      entries = d86f_chunk_entries(dev);
+    uint32_t pos     = 8 + (entries << 2);
+    uint32_t blk[3];
+
+    dev->chunk_fp = plat_fopen(fn, read_only ? "rb" : "rb+");
+    if (!dev->chunk_fp)
+        return 0;
+
+    if ((fseek(dev->chunk_fp, 8, SEEK_SET) == -1) || (fread(dev->chunk_offset, 4, entries, dev->chunk_fp) != entries))
+        goto fail;
+
+    memset(dev->track_offset, 0x00, sizeof(dev->track_offset));
+    for (int i = 0; i < entries; i++) {
+        if (!dev->chunk_offset[i])
+            continue;
+        if ((fseek(dev->chunk_fp, dev->chunk_offset[i], SEEK_SET) == -1) || (fread(blk, 4, 3, dev->chunk_fp) != 3) ||
+            !blk[2] || (blk[1] > blk[0]) || (blk[1] > blk[2]))
+            goto fail;
+        dev->track_offset[i] = pos;
+        pos += blk[2];
+    }
+
+    dev->fp = plat_fopen(temp_file_name, "wb+");
+    if (!dev->fp)
+        goto fail;
+
+    fwrite(&magic, 4, 1, dev->fp);
+    fwrite(&dev->version, 2, 1, dev->fp);
+    fwrite(&dev->disk_flags, 2, 1, dev->fp);
+    fwrite(dev->track_offset, 4, entries, dev->fp);
+    if (pos > (uint32_t) ftell(dev->fp)) {
+        fseek(dev->fp, pos - 1, SEEK_SET);
+        fputc(0x00, dev->fp);
+    }
+
+    memset(dev->chunk_loaded, 0x00, sizeof(dev->chunk_loaded));
+    memset(dev->chunk_dirty, 0x00, sizeof(dev->chunk_dirty));
+    return 1;
+
+fail:
+    fclose(dev->chunk_fp);
+    dev->chunk_fp = NULL;
+    return 0;
+}
+#endif
+
 void
 d86f_read_track(int drive, int track, int thin_track, int side, uint16_t *da, uint16_t *sa)
 {
@@ -2927,6 +3240,9 @@ d86f_read_track(int drive, int track, int thin_track, int side, uint16_t *da, ui
         logical_track = track + thin_track;
 
     if (dev->track_offset[logical_track]) {
+#ifdef D86F_COMPRESS
+        d86f_chunk_load(drive, logical_track);
+#endif
         if (!thin_track) {
             if (fseek(dev->fp, dev->track_offset[logical_track], SEEK_SET) == -1)
                 fatal("d86f_read_track(): Error seeking to offset dev->track_offset[logical_track]\n");
@@ -3069,6 +3385,152 @@ d86f_set_cur_track(int drive, int track)
     dev->cur_track = track;
 }
 
+static uint32_t
+d86f_cache_words(int drive, int side)
+{
+    return (d86f_handler[drive].get_raw_size(drive, side) + 15) >> 4;
+}
+
+/* Restores a track of a sector image encoded by an earlier seek, returns 1 if found.
+   The caller still sets up its own per-track state, and must have set up the side
+   flags already, so a track at a different data rate is not mistaken for the cached one. */
+int
+d86f_load_cached_track(int drive, int track)
+{
+    d86f_t              *dev = d86f[drive];
+    d86f_cached_track_t *ct  = NULL;
+    sector_t            *s;
+
+    if ((dev->track_cache == NULL) || fdd_get_turbo(drive))
+        return 0;
+
+    for (int i = 0; i < D86F_TRACK_CACHE; i++) {
+        if (dev->track_cache[i].track == track) {
+            ct = &dev->track_cache[i];
+            break;
+        }
+    }
+
+    if ((ct == NULL) || (ct->words[0] != d86f_cache_words(drive, 0)) || (ct->words[1] != d86f_cache_words(drive, 1)))
+        return 0;
+
+    for (int side = 0; side < 2; side++) {
+        memcpy(d86f_handler[drive].encoded_data(drive, side), ct->encoded_data[side], ct->words[side] << 1);
+
+        dev->index_hole_pos[side] = 0;
+        d86f_destroy_linked_lists(drive, side);
+        for (int i = 0; i < ct->sectors_num[side]; i++) {
+            s = (sector_t *) malloc(sizeof(sector_t));
+            *s = ct->sectors[side][i];
+            s->prev = dev->last_side_sector[side];
+            dev->last_side_sector[side] = s;
+        }
+    }
+
+    dev->last_sector = ct->last_sector;
+    ct->stamp        = ++dev->track_cache_stamp;
+
+    return 1;
+}
+
+/* Keeps the track a sector image's seek routine just built, replacing the least recently used one. */
+void
+d86f_cache_track(int drive, int track)
+{
+    d86f_t              *dev = d86f[drive];
+    d86f_cached_track_t *ct;
+    const sector_t      *s;
+    int                  n;
+
+    if (fdd_get_turbo(drive))
+        return;
+
+    if (dev->track_cache == NULL) {
+        dev->track_cache = (d86f_cached_track_t *) calloc(D86F_TRACK_CACHE, sizeof(d86f_cached_track_t));
+        if (dev->track_cache == NULL)
+            return;
+        for (int i = 0; i < D86F_TRACK_CACHE; i++)
+            dev->track_cache[i].track = -1;
+    }
+
+    ct = &dev->track_cache[0];
+    for (int i = 0; i < D86F_TRACK_CACHE; i++) {
+        if (dev->track_cache[i].track == track) {
+            ct = &dev->track_cache[i];
+            break;
+        }
+        if (dev->track_cache[i].stamp < ct->stamp)
+            ct = &dev->track_cache[i];
+    }
+
+    ct->track = -1;
+
+    for (int side = 0; side < 2; side++) {
+        uint32_t words = d86f_cache_words(drive, side);
+
+        if (ct->words[side] != words) {
+            free(ct->encoded_data[side]);
+            ct->encoded_data[side] = (uint16_t *) malloc(words << 1);
+            ct->words[side]        = (ct->encoded_data[side] == NULL) ? 0 : words;
+            if (ct->encoded_data[side] == NULL)
+                return;
+        }
+        memcpy(ct->encoded_data[side], d86f_handler[drive].encoded_data(drive, side), words << 1);
+
+        n = 0;
+        for (s = dev->last_side_sector[side]; s != NULL; s = s->prev)
+            n++;
+
+        free(ct->sectors[side]);
+        ct->sectors[side]     = (n == 0) ? NULL : (sector_t *) malloc(n * sizeof(sector_t));
+        ct->sectors_num[side] = (ct->sectors[side] == NULL) ? 0 : n;
+        if ((n != 0) && (ct->sectors[side] == NULL))
+            return;
+
+        /* The list runs newest first. */
+        for (s = dev->last_side_sector[side]; s != NULL; s = s->prev)
+            ct->sectors[side][--n] = *s;
+    }
+
+    ct->last_sector = dev->last_sector;
+    ct->stamp       = ++dev->track_cache_stamp;
+    ct->track       = track;
+}
+
+/* Drops the current track from the cache, once a write or format is about to change it. */
+static void
+d86f_uncache_track(int drive)
+{
+    d86f_t *dev = d86f[drive];
+
+    if (dev->track_cache == NULL)
+        return;
+
+    for (int i = 0; i < D86F_TRACK_CACHE; i++) {
+        if (dev->track_cache[i].track == dev->cur_track)
+            dev->track_cache[i].track = -1;
+    }
+}
+
+static void
+d86f_free_track_cache(int drive)
+{
+    d86f_t *dev = d86f[drive];
+
+    if (dev->track_cache == NULL)
+        return;
+
+    for (int i = 0; i < D86F_TRACK_CACHE; i++) {
+        for (int side = 0; side < 2; side++) {
+            free(dev->track_cache[i].encoded_data[side]);
+            free(dev->track_cache[i].sectors[side]);
+        }
+    }
+
+    free(dev->track_cache);
+    dev->track_cache = NULL;
+}
+
 void
 d86f_write_tracks(int drive, FILE **fp, uint32_t *track_table)
 {
@@ -3107,6 +3569,10 @@ d86f_write_tracks(int drive, FILE **fp, uint32_t *track_table)
                 if (tbl[logical_track]) {
                     fseek(*fp, tbl[logical_track], SEEK_SET);
                     d86f_write_track(drive, fp, side, dev->thin_track_encoded_data[thin_track][side], dev->thin_track_surface_data[thin_track][side]);
+#ifdef D86F_COMPRESS
+                    if (!track_table)
+                        dev->chunk_loaded[logical_track] = dev->chunk_dirty[logical_track] = 1;
+#endif
                 }
             }
         }
@@ -3127,6 +3593,10 @@ d86f_write_tracks(int drive, FILE **fp, uint32_t *track_table)
                 if (fseek(*fp, tbl[logical_track], SEEK_SET) == -1)
                     fatal("d86f_write_tracks(): Error seeking to offset tbl[logical_track]\n");
                 d86f_write_track(drive, fp, side, d86f_handler[drive].encoded_data(drive, side), dev->track_surface_data[side]);
+#ifdef D86F_COMPRESS
+                if (!track_table)
+                    dev->chunk_loaded[logical_track] = dev->chunk_dirty[logical_track] = 1;
+#endif
             }
         }
     }
@@ -3141,11 +3611,7 @@ d86f_writeback(int drive)
     uint8_t header[32];
     int     header_size;
     int     size;
-#ifdef D86F_COMPRESS
-    uint32_t len;
-    int      ret = 0;
-    FILE    *cf;
-#endif
+
     header_size = d86f_header_size(drive);
 
     if (!dev->fp)
@@ -3166,34 +3632,8 @@ d86f_writeback(int drive)
     d86f_write_tracks(drive, &dev->fp, NULL);
 
 #ifdef D86F_COMPRESS
-    if (dev->is_compressed) {
-        /* The image is compressed. */
-
-        /* Open the original, compressed file. */
-        cf = plat_fopen(dev->original_file_name, L"wb");
-
-        /* Write the header to the original file. */
-        fwrite(header, 1, header_size, cf);
-
-        fseek(dev->fp, 0, SEEK_END);
-        len = ftell(dev->fp);
-        len -= header_size;
-
-        fseek(dev->fp, header_size, SEEK_SET);
-
-        /* Compress data from the temporary uncompressed file to the original, compressed file. */
-        dev->filebuf = (uint8_t *) malloc(len);
-        dev->outbuf  = (uint8_t *) malloc(len - 1);
-        fread(dev->filebuf, 1, len, dev->fp);
-        ret = lzf_compress(dev->filebuf, len, dev->outbuf, len - 1);
-
-        if (!ret)
-            d86f_log("86F: Error compressing file\n");
-
-        fwrite(dev->outbuf, 1, ret, cf);
-        free(dev->outbuf);
-        free(dev->filebuf);
-    }
+    if (dev->is_compressed)
+        d86f_chunk_writeback(drive);
 #endif
 }
 
@@ -3274,6 +3714,8 @@ d86f_writesector(int drive, int sector, int track, int side, int rate, int secto
     if (!ret)
         return;
 
+    d86f_uncache_track(drive);
+
     dev->state = fdc_is_deleted(d86f_fdc) ? STATE_09_FIND_ID : STATE_05_FIND_ID;
 }
 
@@ -3362,6 +3804,8 @@ d86f_common_format(int drive, int side, UNUSED(int rate), uint8_t fill, int prox
         return;
     }
 
+    d86f_uncache_track(drive);
+
     if (!side || (d86f_get_sides(drive) == 2)) {
         if (!proxy) {
             d86f_reset_index_hole_pos(drive, side);
@@ -3546,7 +3990,11 @@ d86f_load(int drive, char *fn)
         return;
     }
 
+#ifdef D86F_COMPRESS
+    if ((magic != 0x46423638) && (magic != D86F_LZF_MAGIC) && (magic != D86F_CHUNKED_MAGIC)) {
+#else
     if ((magic != 0x46423638) && (magic != 0x66623638)) {
+#endif
         /* File is not of the valid format, abort. */
         d86f_log("86F: Unrecognized magic bytes: %08X\n", magic);
         fclose(dev->fp);
@@ -3589,7 +4037,8 @@ d86f_load(int drive, char *fn)
     }
 
 #ifdef D86F_COMPRESS
-    dev->is_compressed = (magic == 0x66623638) ? 1 : 0;
+    dev->is_compressed = ((magic == D86F_LZF_MAGIC) || (magic == D86F_CHUNKED_MAGIC)) ? 1 : 0;
+    dev->is_chunked    = (magic == D86F_CHUNKED_MAGIC) ? 1 : 0;
     if ((len < 51052) && !dev->is_compressed) {
 #else
     if (len < 51052) {
@@ -3634,44 +4083,55 @@ d86f_load(int drive, char *fn)
         fclose(dev->fp);
         dev->fp = NULL;
 
-        dev->fp = plat_fopen(temp_file_name, "wb");
-        if (!dev->fp) {
-            d86f_log("86F: Unable to create temporary decompressed file\n");
-            memset(floppyfns[drive], 0, sizeof(floppyfns[drive]));
-            free(dev);
-            return;
-        }
-
-        tf = plat_fopen(fn, "rb");
+        if (dev->is_chunked) {
+            if (!d86f_chunk_open(dev, fn, temp_file_name, writeprot[drive])) {
+                d86f_log("86F: Unable to open the chunked compressed image\n");
+                plat_remove(temp_file_name);
+                memset(floppyfns[drive], 0, sizeof(floppyfns[drive]));
+                free(dev);
+                return;
+            }
+        } else {
+            dev->fp = plat_fopen(temp_file_name, "wb");
+            if (!dev->fp) {
+                d86f_log("86F: Unable to create temporary decompressed file\n");
+                memset(floppyfns[drive], 0, sizeof(floppyfns[drive]));
+                free(dev);
+                return;
+            }
 
-        for (uint8_t i = 0; i < 8; i++) {
-            fread(&temp, 1, 2, tf);
-            fwrite(&temp, 1, 2, dev->fp);
-        }
+            tf = plat_fopen(fn, "rb");
 
-        dev->filebuf = (uint8_t *) malloc(len);
-        dev->outbuf  = (uint8_t *) malloc(67108864);
-        fread(dev->filebuf, 1, len, tf);
-        temp = lzf_decompress(dev->filebuf, len, dev->outbuf, 67108864);
-        if (temp) {
-            fwrite(dev->outbuf, 1, temp, dev->fp);
-        }
-        free(dev->outbuf);
-        free(dev->filebuf);
+            for (uint8_t i = 0; i < 8; i++) {
+                fread(&temp, 1, 2, tf);
+                fwrite(&temp, 1, 2, dev->fp);
+            }
 
-        fclose(tf);
-        fclose(dev->fp);
-        dev->fp = NULL;
+            dev->filebuf = (uint8_t *) malloc(len);
+            dev->outbuf  = (uint8_t *) malloc(67108864);
+            fread(dev->filebuf, 1, len, tf);
+            temp = lzf_decompress(dev->filebuf, len, dev->outbuf, 67108864);
+            if (temp) {
+                fwrite(dev->outbuf, 1, temp, dev->fp);
+            }
+            free(dev->outbuf);
+            free(dev->filebuf);
+
+            fclose(tf);
+            fclose(dev->fp);
+            dev->fp = NULL;
+
+            if (!temp) {
+                d86f_log("86F: Error decompressing file\n");
+                plat_remove(temp_file_name);
+                memset(floppyfns[drive], 0, sizeof(floppyfns[drive]));
+                free(dev);
+                return;
+            }
 
-        if (!temp) {
-            d86f_log("86F: Error decompressing file\n");
-            plat_remove(temp_file_name);
-            memset(floppyfns[drive], 0, sizeof(floppyfns[drive]));
-            free(dev);
-            return;
+            dev->fp = plat_fopen(temp_file_name, "rb+");
+            memset(dev->chunk_loaded, 0x01, sizeof(dev->chunk_loaded));
         }
-
-        dev->fp = plat_fopen(temp_file_name, "rb+");
     }
 #endif
 
@@ -3681,6 +4141,8 @@ d86f_load(int drive, char *fn)
         fclose(dev->fp);
         dev->fp = NULL;
 #ifdef D86F_COMPRESS
+        if (dev->chunk_fp)
+            fclose(dev->chunk_fp);
         if (dev->is_compressed)
             plat_remove(temp_file_name);
 #endif
@@ -3695,6 +4157,8 @@ d86f_load(int drive, char *fn)
         fclose(dev->fp);
         dev->fp = NULL;
 #ifdef D86F_COMPRESS
+        if (dev->chunk_fp)
+            fclose(dev->chunk_fp);
         if (dev->is_compressed)
             plat_remove(temp_file_name);
 #endif
@@ -3713,7 +4177,10 @@ d86f_load(int drive, char *fn)
         dev->fp = NULL;
 
 #ifdef D86F_COMPRESS
-        if (dev->is_compressed)
+        if (dev->is_chunked) {
+            /* Tracks are still decompressed into the temporary file. */
+            dev->fp = plat_fopen(temp_file_name, "rb+");
+        } else if (dev->is_compressed)
             dev->fp = plat_fopen(temp_file_name, "rb");
         else
 #endif
@@ -3749,6 +4216,12 @@ d86f_load(int drive, char *fn)
         return;
     }
 
+#ifdef D86F_COMPRESS
+    d86f_chunk_load(drive, 0);
+    if (d86f_get_sides(drive) == 2)
+        d86f_chunk_load(drive, 1);
+#endif
+
     /* Load track 0 flags as default. */
     if (fseek(dev->fp, dev->track_offset[0], SEEK_SET) == -1)
         fatal("d86f_load(): Track 0: Error seeking to the beginning of the file\n");
@@ -3875,6 +4348,10 @@ d86f_close(int drive)
         dev->fp = NULL;
     }
 #ifdef D86F_COMPRESS
+    if (dev->chunk_fp) {
+        fclose(dev->chunk_fp);
+        dev->chunk_fp = NULL;
+    }
     if (dev->is_compressed)
         plat_remove(temp_file_name);
 #endif
@@ -3928,6 +4405,8 @@ d86f_destroy(int drive)
     d86f_destroy_linked_lists(drive, 0);
     d86f_destroy_linked_lists(drive, 1);
 
+    d86f_free_track_cache(drive);
+
     free(d86f[drive]);
     d86f[drive] = NULL;
 
@@ -43,6 +43,8 @@ typedef struct fdi_t {
     int lasttrack;
     int sides;
     int track;
+    int loaded_track; /* Track in track_data, -1 if none. */
+    int multirev;     /* It has weak bits, decode each revolution anew. */
     int tracklen[2][4];
     int trackindex[2][4];
 
@@ -216,8 +218,16 @@ read_revolution(int drive)
     fdi_t *dev = fdi[drive];
     int    c;
     int    den;
+    int    mr;
     int    track = dev->track;
 
+    /* Other tracks come out the same on every revolution. */
+    if ((track == dev->loaded_track) && !dev->multirev)
+        return;
+
+    dev->loaded_track = track;
+    dev->multirev     = 0;
+
     if (track > dev->lasttrack) {
         for (den = 0; den < 4; den++) {
             memset(dev->track_data[0][den], 0, 106096);
@@ -229,12 +239,14 @@ read_revolution(int drive)
 
     for (den = 0; den < 4; den++) {
         for (int side = 0; side < dev->sides; side++) {
-            c = fdi2raw_loadtrack(dev->h,
-                                  (uint16_t *) dev->track_data[side][den],
-                                  (uint16_t *) dev->track_timing[side][den],
-                                  (track * dev->sides) + side,
-                                  &dev->tracklen[side][den],
-                                  &dev->trackindex[side][den], NULL, den);
+            mr = 0;
+            c  = fdi2raw_loadtrack(dev->h,
+                                   (uint16_t *) dev->track_data[side][den],
+                                   (uint16_t *) dev->track_timing[side][den],
+                                   (track * dev->sides) + side,
+                                   &dev->tracklen[side][den],
+                                   &dev->trackindex[side][den], &mr, den);
+            dev->multirev |= mr;
             if (!c)
                 memset(dev->track_data[side][den], 0, dev->tracklen[side][den]);
         }
@@ -345,9 +357,10 @@ fdi_load(int drive, char *fn)
     /* Set up the drive unit. */
     fdi[drive] = dev;
 
-    dev->h         = fdi2raw_header(dev->fp);
-    dev->lasttrack = fdi2raw_get_last_track(dev->h);
-    dev->sides     = fdi2raw_get_last_head(dev->h) + 1;
+    dev->h            = fdi2raw_header(dev->fp);
+    dev->lasttrack    = fdi2raw_get_last_track(dev->h);
+    dev->sides        = fdi2raw_get_last_head(dev->h) + 1;
+    dev->loaded_track = -1;
 
     /* Attach this format to the D86F engine. */
     d86f_handler[drive].disk_flags        = disk_flags;
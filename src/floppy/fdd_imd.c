@@ -308,6 +308,7 @@ imd_seek(int drive, int track)
     const char *n_map = NULL;
     uint8_t    *data;
     int         flags = 0x00;
+    int         cached;
 
     if (dev->fp == NULL)
         return;
@@ -335,6 +336,9 @@ imd_seek(int drive, int track)
     if (track > dev->track_count)
         return;
 
+    /* The sector buffers are still filled, only the encoding can be skipped. */
+    cached = d86f_load_cached_track(drive, track);
+
     for (int side = 0; side < dev->sides; side++) {
         if (!dev->tracks[track][side].is_present)
             continue;
@@ -370,7 +374,8 @@ imd_seek(int drive, int track)
 
         interleave_type = track_is_interleave(drive, side, track);
 
-        current_pos = d86f_prepare_pretrack(drive, side, 0);
+        if (!cached)
+            current_pos = d86f_prepare_pretrack(drive, side, 0);
 
         if (!xdf_type) {
             for (sector = 0; sector < dev->tracks[track][side].params[3]; sector++) {
@@ -401,7 +406,8 @@ imd_seek(int drive, int track)
 
                 sector_to_buffer(drive, track, side, data, actual_sector, ssize);
 
-                current_pos = d86f_prepare_sector(drive, side, current_pos, id, data, ssize, 22, track_gap3, flags);
+                if (!cached)
+                    current_pos = d86f_prepare_sector(drive, side, current_pos, id, data, ssize, 22, track_gap3, flags);
                 track_buf_pos[side] += ssize;
 
                 if (sector == 0)
@@ -434,9 +440,9 @@ imd_seek(int drive, int track)
 
                 sector_to_buffer(drive, track, side, data, ordered_pos, ssize);
 
-                if (is_trackx)
+                if (!cached && is_trackx)
                     current_pos = d86f_prepare_sector(drive, side, xdf_trackx_spos[xdf_type][xdf_sector], id, data, ssize, track_gap2, xdf_gap3_sizes[xdf_type][is_trackx], flags);
-                else
+                else if (!cached)
                     current_pos = d86f_prepare_sector(drive, side, current_pos, id, data, ssize, track_gap2, xdf_gap3_sizes[xdf_type][is_trackx], flags);
 
                 track_buf_pos[side] += ssize;
@@ -446,6 +452,9 @@ imd_seek(int drive, int track)
             }
         }
     }
+
+    if (!cached)
+        d86f_cache_track(drive, track);
 }
 
 static uint16_t
@@ -505,6 +505,7 @@ img_seek(int drive, int track)
     int      buf_side;
     int      buf_pos;
     int      ssize   = 128 << ((int) dev->sector_size);
+    int      cached;
     uint32_t cur_pos = 0;
 
     if (dev->fp == NULL)
@@ -545,9 +546,13 @@ img_seek(int drive, int track)
         return;
     }
 
+    /* The sector positions are still needed, only the encoding can be skipped. */
+    cached = d86f_load_cached_track(drive, track);
+
     if (!dev->xdf_type || dev->is_cqm) {
         for (side = 0; side < dev->sides; side++) {
-            current_pos = d86f_prepare_pretrack(drive, side, 0);
+            if (!cached)
+                current_pos = d86f_prepare_pretrack(drive, side, 0);
 
             for (sector = 0; sector < dev->sectors; sector++) {
                 if (dev->is_cqm) {
@@ -571,7 +576,8 @@ img_seek(int drive, int track)
                 id[3]                          = dev->sector_size;
                 dev->sector_pos_side[side][sr] = side;
                 dev->sector_pos[side][sr]      = (sr - 1) * ssize;
-                current_pos                    = d86f_prepare_sector(drive, side, current_pos, id, &dev->track_data[side][(sr - 1) * ssize], ssize, dev->gap2_size, dev->gap3_size, 0);
+                if (!cached)
+                    current_pos = d86f_prepare_sector(drive, side, current_pos, id, &dev->track_data[side][(sr - 1) * ssize], ssize, dev->gap2_size, dev->gap3_size, 0);
 
                 if (sector == 0)
                     d86f_initialize_last_sector_id(drive, id[0], id[1], id[2], id[3]);
@@ -604,6 +610,9 @@ img_seek(int drive, int track)
 
         /* Pass 2, prepare the actual track. */
         for (side = 0; side < dev->sides; side++) {
+            if (cached)
+                break;
+
             current_pos = d86f_prepare_pretrack(drive, side, 0);
 
             for (sector = 0; sector < xdf_physical_sectors[current_xdft][!is_t0]; sector++) {
@@ -629,6 +638,9 @@ img_seek(int drive, int track)
             }
         }
     }
+
+    if (!cached)
+        d86f_cache_track(drive, track);
 }
 
 void
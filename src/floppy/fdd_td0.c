@@ -1092,6 +1092,9 @@ td0_seek(int drive, int track)
         return;
     }
 
+    if (d86f_load_cached_track(drive, track))
+        return;
+
     for (int side = 0; side < dev->sides; side++) {
         track_rate = dev->current_side_flags[side] & 7;
         /* Make sure 300 kbps @ 360 rpm is treated the same as 250 kbps @ 300 rpm. */
@@ -1168,6 +1171,8 @@ td0_seek(int drive, int track)
             }
         }
     }
+
+    d86f_cache_track(drive, track);
 }
 
 void
@@ -34,7 +34,9 @@
 #include <86box/plat_unused.h>
 
 typedef struct g_axis_t {
-    pc_timer_t                  timer;
+    pc_timer_t                  timer; /* axis 0 only, for a0_over() */
+    uint64_t                    expiry; /* 32:32, when the one-shot runs out */
+    uint8_t                     running;
     int                         axis_nr;
     struct _joystick_instance_ *joystick;
 } g_axis_t;
@@ -197,17 +199,47 @@ joystick_get_pov_name(int js, int id)
     return joysticks[js].joystick->pov_names[id];
 }
 
+/*
+ * The one-shots are worked out when the port is triggered. Games read the
+ * port in tight loops while they wait, so the axis bits are then cleared
+ * by comparing against the expiry time on read instead of by a timer per
+ * axis; only axis 0 keeps a timer, for the interfaces that want to hear
+ * about it running out.
+ */
 static void
 gameport_time(joystick_instance_t *joystick, int nr, int axis)
 {
-    if (axis == AXIS_NOT_PRESENT)
-        timer_disable(&joystick->axis[nr].timer);
-    else {
+    g_axis_t *a = &joystick->axis[nr];
+    uint64_t  delay;
+
+    if (axis == AXIS_NOT_PRESENT) {
+        a->running = 0;
+        if (nr == 0)
+            timer_disable(&a->timer);
+    } else {
         /* Convert axis value to 555 timing. */
         axis += 32768;
         axis = (axis * 100) / 65; /* axis now in ohms */
         axis = (axis * 11) / 1000;
-        timer_set_delay_u64(&joystick->axis[nr].timer, TIMER_USEC * (axis + 24)); /* max = 11.115 ms */
+        delay = TIMER_USEC * (axis + 24); /* max = 11.115 ms */
+
+        a->expiry  = (tsc << 32) + delay;
+        a->running = 1;
+        if (nr == 0)
+            timer_set_delay_u64(&a->timer, delay);
+    }
+}
+
+static void
+gameport_expire(joystick_instance_t *joystick)
+{
+    uint64_t now = tsc << 32;
+
+    for (int nr = 0; nr < 4; nr++) {
+        if (joystick->axis[nr].running && ((int64_t) (now - joystick->axis[nr].expiry) >= 0)) {
+            joystick->axis[nr].running = 0;
+            joystick->state &= ~(1 << nr);
+        }
     }
 }
 
@@ -245,6 +277,9 @@ gameport_read(UNUSED(uint16_t addr), void *priv)
     if (!joystick || (active_gameports != dev))
         return 0xff;
 
+    if (joystick->state & 0x0f)
+        gameport_expire(joystick);
+
     /* Merge axis state with button state. */
     uint8_t ret = joystick->state | joystick->intf->read(joystick->dat);
 
@@ -259,10 +294,10 @@ timer_over(void *priv)
     g_axis_t *axis = (g_axis_t *) priv;
 
     axis->joystick->state &= ~(1 << axis->axis_nr);
+    axis->running = 0;
 
     /* Notify the joystick when the first axis' period is finished. */
-    if (axis == &axis->joystick->axis[0])
-        axis->joystick->intf->a0_over(axis->joystick->dat);
+    axis->joystick->intf->a0_over(axis->joystick->dat);
 }
 
 void
@@ -376,9 +411,6 @@ gameport_init(const device_t *info)
         joystick_instance->axis[3].axis_nr = 3;
 
         timer_add(&joystick_instance->axis[0].timer, timer_over, &joystick_instance->axis[0], 0);
-        timer_add(&joystick_instance->axis[1].timer, timer_over, &joystick_instance->axis[1], 0);
-        timer_add(&joystick_instance->axis[2].timer, timer_over, &joystick_instance->axis[2], 0);
-        timer_add(&joystick_instance->axis[3].timer, timer_over, &joystick_instance->axis[3], 0);
 
         joystick_instance->intf = joysticks[joystick_type].joystick;
         joystick_instance->dat  = joystick_instance->intf->init();
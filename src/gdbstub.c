@@ -133,6 +133,22 @@ typedef struct _gdbstub_client_ {
     event_t *processed_event;
     event_t *response_event;
 
+    /* Held while a response goes out, responses come from two threads. */
+    mutex_t    *send_mutex;
+    const char *last_sent;
+    int         last_sent_len;
+
+    /* Reads answered while the CPU runs, see gdbstub_client_peek(). */
+    event_t     *peek_event;
+    volatile int peek_pending;
+    char         peek_type;
+    uint32_t     peek_addr;
+    int          peek_len;
+    uint8_t      peek_buf[8192];
+    uint8_t      peek_regs[GDB_REG_MAX][10];
+    uint8_t      peek_regs_len[GDB_REG_MAX];
+    char         peek_response[16384];
+
     uint16_t last_io_base;
     uint16_t last_io_len;
     uint16_t last_io_value;
@@ -352,6 +368,7 @@ static gdbstub_breakpoint_t *first_awatch = NULL;
 
 int      gdbstub_step = 0;
 int      gdbstub_next_asap = 0;
+int      gdbstub_watching  = 0;
 uint64_t gdbstub_watch_pages[(((uint32_t) -1) >> (MEM_GRANULARITY_BITS + 6)) + 1];
 
 static void
@@ -620,26 +637,37 @@ gdbstub_client_write_reg(int index, uint8_t *buf)
 }
 
 static void
-gdbstub_client_respond(gdbstub_client_t *client)
+gdbstub_client_send(gdbstub_client_t *client, const char *response, int len)
 {
     /* Calculate checksum. */
     int checksum = 0;
-    int i;
-    for (i = 0; i < client->response_pos; i++)
-        checksum += client->response[i];
+    for (int i = 0; i < len; i++)
+        checksum += response[i];
 
     /* Send response packet. */
+    thread_wait_mutex(client->send_mutex);
+    send(client->socket, "$", 1, 0);
+    send(client->socket, response, len, 0);
+    char response_cksum[3] = { '#', gdbstub_hex_encode((checksum >> 4) & 0x0f), gdbstub_hex_encode(checksum & 0x0f) };
+    send(client->socket, response_cksum, sizeof(response_cksum), 0);
+
+    /* Remember it for retransmission. */
+    client->last_sent     = response;
+    client->last_sent_len = len;
+    thread_release_mutex(client->send_mutex);
+}
+
+static void
+gdbstub_client_respond(gdbstub_client_t *client)
+{
     client->response[client->response_pos] = '\0';
 #ifdef ENABLE_GDBSTUB_LOG
-    i                     = client->response[994]; /* pclog_ex buffer too small */
+    int i                 = client->response[994]; /* pclog_ex buffer too small */
     client->response[994] = '\0';
     gdbstub_log("GDB Stub: Sending response: %s\n", client->response);
     client->response[994] = i;
 #endif
-    send(client->socket, "$", 1, 0);
-    send(client->socket, client->response, client->response_pos, 0);
-    char response_cksum[3] = { '#', gdbstub_hex_encode((checksum >> 4) & 0x0f), gdbstub_hex_encode(checksum & 0x0f) };
-    send(client->socket, response_cksum, sizeof(response_cksum), 0);
+    gdbstub_client_send(client, client->response, client->response_pos);
 }
 
 static void
@@ -740,22 +768,52 @@ gdbstub_client_read_reg(int index, uint8_t *buf)
     return width;
 }
 
+/* Copies guest memory at a linear address, the way a run of readmembl()
+   calls would see it; pages backed by host memory are copied directly. */
 static void
-gdbstub_client_packet(gdbstub_client_t *client)
+gdbstub_mem_read_block(uint32_t addr, uint8_t *buf, int len)
 {
-    gdbstub_breakpoint_t *breakpoint;
-    gdbstub_breakpoint_t *prev_breakpoint = NULL;
-    gdbstub_breakpoint_t **first_breakpoint = NULL;
+    uint64_t phys;
+    int      n;
+
+    while (len > 0) {
+        n = MEM_GRANULARITY_SIZE - (addr & MEM_GRANULARITY_MASK);
+        if (n > len)
+            n = len;
+
+        phys = addr;
+        if (cr0 >> 31)
+            phys = mmutranslate_noabrt(addr, 0);
 
+        if (phys > 0xffffffffULL) {
+            memset(buf, 0xff, n);
+        } else {
+            phys &= rammask;
+            if (_mem_exec[phys >> MEM_GRANULARITY_BITS]) {
+                memcpy(buf, &_mem_exec[phys >> MEM_GRANULARITY_BITS][phys & MEM_GRANULARITY_MASK], n);
+            } else {
+                for (int i = 0; i < n; i++)
+                    buf[i] = readmembl_no_mmut(addr + i, (uint32_t) (phys + i));
+            }
+        }
+
+        addr += n;
+        buf += n;
+        len -= n;
+    }
+}
+
+/* Strips and validates the checksum, then acknowledges the packet. Returns 0
+   if it was rejected. */
+static int
+gdbstub_client_packet_ack(gdbstub_client_t *client)
+{
 #ifdef GDBSTUB_CHECK_CHECKSUM /* msys2 gdb 11.1 transmits qSupported and H with invalid checksum... */
     uint8_t rcv_checksum = 0, checksum = 0;
 #endif
-    int     i;
-    int     j = 0;
-    int     k = 0;
-    int     l;
-    uint8_t buf[10] = { 0 };
-    char   *p;
+#if defined(GDBSTUB_CHECK_CHECKSUM) || defined(ENABLE_GDBSTUB_LOG)
+    int i;
+#endif
 
     /* Validate checksum. */
     client->packet_pos -= 2;
@@ -776,7 +834,7 @@ gdbstub_client_packet(gdbstub_client_t *client)
         client->packet[953] = i;
 #    endif
         send(client->socket, "-", 1, 0);
-        return;
+        return 0;
     }
 #endif
 
@@ -789,6 +847,26 @@ gdbstub_client_packet(gdbstub_client_t *client)
 #endif
     send(client->socket, "+", 1, 0);
 
+    return 1;
+}
+
+static void
+gdbstub_client_packet(gdbstub_client_t *client)
+{
+    gdbstub_breakpoint_t *breakpoint;
+    gdbstub_breakpoint_t *prev_breakpoint = NULL;
+    gdbstub_breakpoint_t **first_breakpoint = NULL;
+
+    int     i;
+    int     j = 0;
+    int     k = 0;
+    int     l;
+    uint8_t buf[10] = { 0 };
+    char   *p;
+
+    if (!gdbstub_client_packet_ack(client))
+        return;
+
     /* Block other responses from being written while this one (if any is produced) isn't acknowledged. */
     if ((client->packet[0] != 'c') && (client->packet[0] != 's') && (client->packet[0] != 'v')) {
         thread_wait_event(client->response_event, -1);
@@ -884,29 +962,9 @@ e22:
             if (k >= (sizeof(client->response) >> 1))
                 k = (sizeof(client->response) >> 1) - 1;
 
-            /* Read by qwords, then by dwords, then by words, then by bytes. */
-            i = 0;
-            if (is386) {
-                for (; i < (k & ~7); i += 8) {
-                    *((uint64_t *) buf) = readmemql(j);
-                    j += 8;
-                    gdbstub_client_respond_hex(client, buf, 8);
-                }
-                for (; i < (k & ~3); i += 4) {
-                    *((uint32_t *) buf) = readmemll(j);
-                    j += 4;
-                    gdbstub_client_respond_hex(client, buf, 4);
-                }
-            }
-            for (; i < (k & ~1); i += 2) {
-                *((uint16_t *) buf) = readmemwl(j);
-                j += 2;
-                gdbstub_client_respond_hex(client, buf, 2);
-            }
-            for (; i < k; i++) {
-                buf[0] = readmembl(j++);
-                gdbstub_client_respond_hex(client, buf, 1);
-            }
+            /* Read the whole range at once. */
+            gdbstub_mem_read_block(j, client->peek_buf, k);
+            gdbstub_client_respond_hex(client, client->peek_buf, k);
             break;
 
         case 'M': /* write memory */
@@ -1362,6 +1420,8 @@ unknown:
                         l++;
                     }
                 }
+
+                gdbstub_watching = first_rwatch || first_wwatch || first_awatch;
             }
 
             /* Respond positively. */
@@ -1372,6 +1432,112 @@ end:
     gdbstub_client_respond(client);
 }
 
+/* Called at a slice boundary for a read posted by gdbstub_client_peek(). */
+static void
+gdbstub_client_peek_service(gdbstub_client_t *client)
+{
+    if (client->peek_type == 'm') {
+        gdbstub_mem_read_block(client->peek_addr, client->peek_buf, client->peek_len);
+    } else {
+        /* Take all registers at once, so that they belong to the same instant. */
+        for (int i = 0; i < GDB_REG_MAX; i++)
+            client->peek_regs_len[i] = gdbstub_client_read_reg(i, client->peek_regs[i]);
+    }
+}
+
+/* Memory and register reads while the CPU runs are answered on the client
+   thread: the CPU thread only copies the data out at its next slice boundary,
+   and never waits on the connection. Returns 1 if the packet was handled. */
+static int
+gdbstub_client_peek(gdbstub_client_t *client)
+{
+    char *p   = client->peek_response;
+    int   len = 0;
+    int   j   = 0;
+    int   k   = 0;
+    int   i;
+
+    if ((gdbstub_step != GDBSTUB_EXEC) || !client->first_packet_received)
+        return 0;
+    if ((client->packet[0] != 'm') && (client->packet[0] != 'g') && (client->packet[0] != 'p'))
+        return 0;
+
+    if (!gdbstub_client_packet_ack(client))
+        return 1;
+    client->packet_pos = 1;
+
+    client->peek_type = client->packet[0];
+    switch (client->packet[0]) {
+        case 'm':
+            if (!(i = gdbstub_client_read_word(client, &j)))
+                goto e22;
+            client->packet_pos += i + 1;
+            gdbstub_client_read_word(client, &k);
+            if (!k)
+                goto e22;
+            if (k > (int) sizeof(client->peek_buf))
+                k = (int) sizeof(client->peek_buf);
+            client->peek_addr = j;
+            client->peek_len  = k;
+            break;
+
+        case 'p':
+            if (!gdbstub_client_read_word(client, &j) || (j < 0) || (j >= GDB_REG_MAX))
+                goto e14;
+            break;
+
+        default:
+            break;
+    }
+
+    /* Have the CPU thread copy the data out. */
+    thread_reset_event(client->peek_event);
+    client->peek_pending = 1;
+    gdbstub_next_asap    = 1;
+    thread_wait_event(client->peek_event, -1);
+
+    switch (client->packet[0]) {
+        case 'm':
+            for (i = 0; i < k; i++) {
+                p[len++] = gdbstub_hex_encode(client->peek_buf[i] >> 4);
+                p[len++] = gdbstub_hex_encode(client->peek_buf[i] & 0x0f);
+            }
+            break;
+
+        case 'g':
+            for (j = 0; j < GDB_REG_MAX; j++) {
+                for (i = 0; i < client->peek_regs_len[j]; i++) {
+                    p[len++] = gdbstub_hex_encode(client->peek_regs[j][i] >> 4);
+                    p[len++] = gdbstub_hex_encode(client->peek_regs[j][i] & 0x0f);
+                }
+            }
+            break;
+
+        case 'p':
+            if (!client->peek_regs_len[j])
+                goto e14;
+            for (i = 0; i < client->peek_regs_len[j]; i++) {
+                p[len++] = gdbstub_hex_encode(client->peek_regs[j][i] >> 4);
+                p[len++] = gdbstub_hex_encode(client->peek_regs[j][i] & 0x0f);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    gdbstub_client_send(client, p, len);
+    return 1;
+
+e22:
+    gdbstub_client_send(client, "E22", 3);
+    return 1;
+
+e14:
+    gdbstub_client_send(client, "E14", 3);
+    return 1;
+}
+
 static void
 gdbstub_cpu_exec(int32_t cycs)
 {
@@ -1481,6 +1647,12 @@ gdbstub_cpu_exec(int32_t cycs)
             }
         }
 
+        if (client->peek_pending) {
+            gdbstub_client_peek_service(client);
+            client->peek_pending = 0;
+            thread_set_event(client->peek_event);
+        }
+
         if (client->has_packet) {
             gdbstub_client_packet(client);
             client->has_packet = client->packet_pos = 0;
@@ -1523,8 +1695,9 @@ gdbstub_client_thread(void *priv)
                     break;
 
                 case '-': /* negative acknowledgement */
-                    /* Retransmit the current response. */
-                    gdbstub_client_respond(client);
+                    /* Retransmit the last response. */
+                    if (client->last_sent)
+                        gdbstub_client_send(client, client->last_sent, client->last_sent_len);
                     break;
 
                 case '+': /* positive acknowledgement */
@@ -1560,8 +1733,15 @@ gdbstub_client_thread(void *priv)
                                 continue;
                             }
 
-                            /* Flag that a packet should be processed. */
                             client->packet[client->packet_pos] = '\0';
+
+                            /* Reads while the CPU runs are answered from here. */
+                            if (gdbstub_client_peek(client)) {
+                                client->packet_pos = 0;
+                                continue;
+                            }
+
+                            /* Flag that a packet should be processed. */
                             thread_reset_event(client->processed_event);
                             gdbstub_next_asap = client->has_packet = 1;
                         }
@@ -1607,6 +1787,8 @@ gdbstub_client_thread(void *priv)
     }
 #endif
 
+    thread_close_mutex(client->send_mutex);
+    thread_destroy_event(client->peek_event);
     free(client);
     thread_release_mutex(client_list_mutex);
 }
@@ -1626,6 +1808,8 @@ gdbstub_server_thread(void *priv)
         memset(client, 0, sizeof(gdbstub_client_t));
         client->processed_event = thread_create_event();
         client->response_event  = thread_create_event();
+        client->send_mutex      = thread_create_mutex();
+        client->peek_event      = thread_create_event();
 
         /* Accept connection. */
         client->socket = accept(gdbstub_socket, (struct sockaddr *) &client->addr, &sl);
@@ -1657,6 +1841,8 @@ gdbstub_server_thread(void *priv)
     /* Deallocate the redundant client structure. */
     thread_destroy_event(client->processed_event);
     thread_destroy_event(client->response_event);
+    thread_close_mutex(client->send_mutex);
+    thread_destroy_event(client->peek_event);
     free(client);
 }
 
@@ -1817,6 +2003,7 @@ gdbstub_init(void)
 
     /* Clear watchpoint page map. */
     memset(gdbstub_watch_pages, 0, sizeof(gdbstub_watch_pages));
+    gdbstub_watching = 0;
 
     /* Start server thread. */
     pclog("GDB Stub: Listening on port %d\n", port);
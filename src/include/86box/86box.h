@@ -44,6 +44,12 @@
 #define POSTCARDS_NUM 4
 #define POSTCARD_MASK (POSTCARDS_NUM - 1)
 
+/* Events that end turbo POST. */
+#define TURBO_POST_OFF   0
+#define TURBO_POST_INT19 1 /* first INT 19h (bootstrap loader) */
+#define TURBO_POST_DISK  2 /* first IDE hard disk read */
+#define TURBO_POST_TIME  3 /* only turbo_post_time */
+
 #ifdef MIN
 #    undef MIN
 #endif
@@ -116,6 +122,7 @@ extern int      scale;                      /* (C) screen scale factor */
 extern int      dpi_scale;                  /* (C) DPI scaling of the emulated screen */
 extern int      vid_api;                    /* (C) video renderer */
 extern int      vid_cga_contrast;           /* (C) video */
+extern int      vid_cga_comp_cache;         /* (C) video, reuse decoded composite lines */
 extern int      video_fullscreen;           /* (C) video */
 extern int      video_fullscreen_first;     /* (C) video */
 extern int      video_fullscreen_scale;     /* (C) video */
@@ -124,12 +131,22 @@ extern int      force_43;                   /* (C) video */
 extern int      video_filter_method;        /* (C) video */
 extern int      video_vsync;                /* (C) video */
 extern int      video_framerate;            /* (C) video */
+extern int      video_render_thread;        /* (C) video */
+extern int      video_blit_mode;            /* (C) video */
+extern int      video_bus_timing;           /* (C) video */
+extern int      video_frame_stats;          /* (C) video */
+extern int      video_screenshot_format;    /* (C) video */
+extern int      video_screenshot_level;     /* (C) video, PNG zlib level */
+extern int      capture_fps;                /* (C) video capture frame rate */
+extern int      vnc_max_fps;                /* (C) VNC update rate cap */
+extern char     video_shm_name[64];         /* (C) video */
 extern int      gfxcard[2];                 /* (C) graphics/video card */
 extern char     video_shader[512];          /* (C) video */
 extern int      bugger_enabled;             /* (C) enable ISAbugger */
 extern int      novell_keycard_enabled;     /* (C) enable Novell NetWare 2.x key card emulation. */
 extern int      postcard_enabled;           /* (C) enable POST card */
 extern int      unittester_enabled;         /* (C) enable unit tester device */
+extern int      hostshare_enabled;          /* (C) enable host file share device */
 extern int      isamem_type[];              /* (C) enable ISA mem cards */
 extern int      isartc_type;                /* (C) enable ISA RTC card */
 extern int      sound_is_float;             /* (C) sound uses FP values */
@@ -140,14 +157,22 @@ extern uint32_t mem_size;                   /* (C) memory size (Installed on sys
 extern uint32_t isa_mem_size;               /* (C) memory size (ISA Memory Cards) */
 extern int      cpu;                        /* (C) cpu type */
 extern int      cpu_use_dynarec;            /* (C) cpu uses/needs Dyna */
+extern int      cpu_dynarec_cache_size;     /* (C) recompiler code cache size in MB */
+extern int      cpu_dynarec_hash_bits;      /* (C) old recompiler block hash size, log2 */
+extern int      cpu_808x_fast;              /* (C) 808x batches bus timing */
 extern int      fpu_type;                   /* (C) fpu type */
 extern int      fpu_softfloat;              /* (C) fpu uses softfloat */
+extern int      fpu_hybrid;                 /* (C) softfloat fpu uses host fast path */
 extern int      time_sync;                  /* (C) enable time sync */
 extern int      hdd_format_type;            /* (C) hard disk file format */
 extern int      lba_enhancer_enabled;       /* (C) enable Vision Systems LBA Enhancer */
 extern int      confirm_reset;              /* (C) enable reset confirmation */
 extern int      confirm_exit;               /* (C) enable exit confirmation */
 extern int      confirm_save;               /* (C) enable save confirmation */
+extern int      turbo_post;                 /* (C) run unthrottled until this trigger is hit */
+extern int      turbo_post_time;            /* (C) turbo POST limit in emulated seconds */
+extern int      turbo_post_active;          /* turbo POST is currently running */
+extern int      max_speed;                  /* (C) run unthrottled, dropping audio and most frames */
 extern int      enable_discord;             /* (C) enable Discord integration */
 extern int      other_ide_present;          /* IDE controllers from non-IDE cards are present */
 extern int      other_scsi_present;         /* SCSI controllers from non-SCSI cards are present */
@@ -188,6 +213,8 @@ extern void pclog_ex(const char *fmt, va_list);
 extern void fatal_ex(const char *fmt, va_list);
 #endif
 extern void pclog_toggle_suppr(void);
+extern void pclog_defer_flush(void);
+extern void pclog_flush(void);
 extern void pclog(const char *fmt, ...) __attribute__ ((format (printf, 1, 2)));
 extern void fatal(const char *fmt, ...) __attribute__ ((format (printf, 1, 2)));
 extern void set_screen_size(int x, int y);
@@ -213,6 +240,8 @@ extern void pc_send_cab(void);
 extern void pc_run(void);
 extern void pc_start(void);
 extern void pc_onesec(void);
+extern void pc_turbo_post_trigger(int trigger);
+extern int  pc_unthrottled(void);
 
 extern uint16_t get_last_addr(void);
 
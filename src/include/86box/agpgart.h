@@ -18,6 +18,17 @@
 #ifndef EMU_AGPGART_H
 #define EMU_AGPGART_H
 
+#define AGPGART_TLB_SIZE 256
+
+typedef struct agpgart_tlb_t {
+    uint32_t       page;      /* Aperture page, 0xffffffff if unused. */
+    uint32_t       gen;       /* mem_mapping_gen when filled. */
+    uint32_t       entry;     /* GART entry it was filled from. */
+    uint32_t       phys;      /* Translated page address. */
+    const uint8_t *entry_ptr; /* Host pointer to the GART entry. */
+    const uint8_t *read_ptr;  /* Host pointer to the page, NULL if not directly readable. */
+} agpgart_tlb_t;
+
 typedef struct agpgart_s {
     int           aperture_enable;
     uint32_t      aperture_base;
@@ -25,6 +36,7 @@ typedef struct agpgart_s {
     uint32_t      aperture_mask;
     uint32_t      gart_base;
     mem_mapping_t aperture_mapping;
+    agpgart_tlb_t tlb[AGPGART_TLB_SIZE];
 } agpgart_t;
 
 extern void agpgart_set_aperture(agpgart_t *dev, uint32_t base, uint32_t size, int enable);
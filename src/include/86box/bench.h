@@ -0,0 +1,38 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the benchmark mode.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#ifndef EMU_BENCH_H
+#define EMU_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int      bench_enabled; /* (O) run unthrottled, without output */
+extern uint64_t bench_run_ms;  /* (O) emulated run time, 0 = until the guest exits */
+
+extern void     bench_start(void);
+extern int      bench_frame(void);
+extern void     bench_guest_exit(int code);
+extern void     bench_phase_marker(uint8_t phase, int stop);
+extern uint64_t bench_host_ns(void);
+extern uint64_t bench_host_cpu_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_BENCH_H*/
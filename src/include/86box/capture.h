@@ -0,0 +1,46 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the lossless video capture.
+ */
+#ifndef EMU_CAPTURE_H
+#define EMU_CAPTURE_H
+
+/* Audio tracks, one per mixer. */
+enum {
+    CAPTURE_AUDIO_SOUND = 0,
+    CAPTURE_AUDIO_MUSIC,
+    CAPTURE_AUDIO_WT,
+    CAPTURE_AUDIO_CD,
+
+    CAPTURE_AUDIO_MAX
+};
+
+/* Sample formats accepted by capture_audio(), always interleaved stereo. */
+#define CAPTURE_SAMPLES_INT32 0 /* Mixer accumulators, clipped to 16 bits. */
+#define CAPTURE_SAMPLES_INT16 1
+#define CAPTURE_SAMPLES_FLOAT 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile int capture_active;
+
+/* A NULL file name records into the screenshots directory. */
+extern int  capture_start(const char *fn);
+extern void capture_stop(void);
+
+extern void capture_video(int x, int y, int w, int h, int dirty_y1, int dirty_y2);
+extern void capture_audio(int stream, const void *buf, int samples, int format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_CAPTURE_H*/
@@ -205,6 +205,8 @@ typedef struct cdrom_ops_t {
     int  (*track_type)(struct cdrom *dev, uint32_t lba);
     int  (*ext_medium_changed)(struct cdrom *dev);
     void (*exit)(struct cdrom *dev);
+    /* Optional: cooked sectors from the track holding lba, returns how many. */
+    int  (*read_sectors)(struct cdrom *dev, uint8_t *b, uint32_t lba, int num);
 } cdrom_ops_t;
 
 typedef struct cdrom {
@@ -249,6 +251,7 @@ typedef struct cdrom {
     const cdrom_ops_t *ops;
 
     void *image;
+    void *prefetch; /* Audio read-ahead, owned by cdrom.c. */
 
     void (*insert)(void *priv);
     void (*close)(void *priv);
@@ -272,6 +275,8 @@ extern double  cdrom_seek_time(cdrom_t *dev);
 extern void    cdrom_stop(cdrom_t *dev);
 extern int     cdrom_is_pre(cdrom_t *dev, uint32_t lba);
 extern int     cdrom_audio_callback(cdrom_t *dev, int16_t *output, int len);
+extern void    cdrom_media_lock(cdrom_t *dev);
+extern void    cdrom_media_unlock(cdrom_t *dev);
 extern uint8_t cdrom_audio_play(cdrom_t *dev, uint32_t pos, uint32_t len, int ismsf);
 extern uint8_t cdrom_audio_track_search(cdrom_t *dev, uint32_t pos, int type, uint8_t playbit);
 extern uint8_t cdrom_audio_track_search_pioneer(cdrom_t *dev, uint32_t pos, uint8_t playbit);
@@ -293,6 +298,8 @@ extern void    cdrom_get_q(cdrom_t *dev, uint8_t *buf, int *curtoctrk, uint8_t m
 extern uint8_t cdrom_mitsumi_audio_play(cdrom_t *dev, uint32_t pos, uint32_t len);
 extern int     cdrom_readsector_raw(cdrom_t *dev, uint8_t *buffer, int sector, int ismsf,
                                     int cdrom_sector_type, int cdrom_sector_flags, int *len, uint8_t vendor_type);
+extern int     cdrom_readsectors_data(cdrom_t *dev, uint8_t *buffer, uint32_t lba, int num,
+                                      int cdrom_sector_type, int cdrom_sector_flags, int *len);
 extern uint8_t cdrom_read_disc_info_toc(cdrom_t *dev, unsigned char *b, unsigned char track, int type);
 
 extern void cdrom_seek(cdrom_t *dev, uint32_t pos, uint8_t vendor_type);
@@ -102,4 +102,10 @@ extern uint64_t      viso_get_length(void *priv);
 extern void          viso_close(void *priv);
 extern track_file_t *viso_init(const char *dirname, int *error);
 
+/* CSO */
+extern int           cso_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count);
+extern uint64_t      cso_get_length(void *priv);
+extern void          cso_close(void *priv);
+extern track_file_t *cso_init(const char *filename, int *error);
+
 #endif /*CDROM_IMAGE_BACKEND_H*/
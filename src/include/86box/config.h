@@ -136,6 +136,7 @@ typedef struct config_t {
 
 extern void config_load(void);
 extern void config_save(void);
+extern void config_flush(void);
 
 #ifdef EMU_INI_H
 extern ini_t config_get_ini(void);
@@ -163,6 +163,8 @@ typedef struct _device_config_ {
     const device_config_bios_t      bios[32];
 } device_config_t;
 
+struct snapshot_t;
+
 typedef struct _device_ {
     const char *name;
     const char *internal_name;
@@ -183,6 +185,9 @@ typedef struct _device_ {
     void (*force_redraw)(void *priv);
 
     const device_config_t *config;
+
+    /* Saves or restores the state, see snapshot.h. */
+    void (*snapshot)(void *priv, struct snapshot_t *snap);
 } device_t;
 
 typedef struct device_context_t {
@@ -191,6 +196,17 @@ typedef struct device_context_t {
     int             instance;
 } device_context_t;
 
+/*
+ * Hash of the internal names in a device table, built on the first
+ * lookup. get_name() returns the name of entry c, or NULL past the end
+ * of the table; static tables only, entries must not move or change.
+ */
+typedef struct device_name_index_t {
+    const char *(*get_name)(int c);
+    int         *slots; /* Entry + 1, 0 = empty. */
+    int          mask;
+} device_name_index_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -214,16 +230,25 @@ extern void  device_close_all(void);
 extern void  device_reset_all(uint32_t match_flags);
 extern void *device_find_first_priv(uint32_t match_flags);
 extern void *device_get_priv(const device_t *dev);
+extern const device_t *device_find_by_priv(const void *priv);
 extern int   device_available(const device_t *dev);
 extern int   device_poll(const device_t *dev);
 extern void  device_speed_changed(void);
 extern void  device_force_redraw(void);
+extern void  device_snapshot_all(struct snapshot_t *snap);
 extern void  device_get_name(const device_t *dev, int bus, char *name);
 extern int   device_has_config(const device_t *dev);
 extern const char *device_get_bios_file(const device_t *dev, const char *internal_name, int file_no);
 
 extern int device_is_valid(const device_t *, int m);
 
+/* Expensive initialization work, run on a thread of its own. */
+typedef struct device_task_t device_task_t;
+
+extern device_task_t *device_task_start(void (*func)(void *priv), void *priv);
+extern int            device_task_done(device_task_t *task);
+extern void           device_task_wait(device_task_t **task);
+
 extern const device_t* device_context_get_device(void);
 
 extern int         device_get_config_int(const char *name);
@@ -240,6 +265,7 @@ extern int         device_get_instance(void);
 #define device_get_config_bios device_get_config_string
 
 extern const char *device_get_internal_name(const device_t *dev);
+extern int         device_name_index_find(device_name_index_t *index, const char *s);
 
 extern int   machine_get_config_int(char *s);
 extern char *machine_get_config_string(char *s);
@@ -0,0 +1,67 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the device callback profiler.
+ *
+ *          Enabled with the DEVICE_PROFILE build option. Host time and
+ *          call counts of I/O, memory mapping, timer and sound buffer
+ *          callbacks are kept per device, keyed on the callback's
+ *          private pointer, and written to device_profile.txt in the
+ *          machine directory every few seconds and on exit. Interrupt
+ *          acknowledges by the CPU are counted against the master PIC.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#ifndef EMU_DEVICE_PROFILE_H
+#define EMU_DEVICE_PROFILE_H
+
+enum {
+    DEVICE_PROFILE_IO = 0,
+    DEVICE_PROFILE_MEM,
+    DEVICE_PROFILE_TIMER,
+    DEVICE_PROFILE_SOUND,
+    DEVICE_PROFILE_IRQ,
+
+    DEVICE_PROFILE_MAX
+};
+
+#ifdef USE_DEVICE_PROFILE
+#    ifdef __cplusplus
+extern "C" {
+#    endif
+
+extern uint64_t device_profile_start(void);
+extern void     device_profile_end(int type, const void *key, uint64_t start);
+extern void     device_profile_report(void);
+extern void     device_profile_reset(void);
+
+#    ifdef __cplusplus
+}
+#    endif
+
+/* Time a callback; key identifies the device, normally its private pointer. */
+#    define device_profile_call(type, key, call)                                 \
+        do {                                                                     \
+            uint64_t device_profile_t = device_profile_start();                  \
+            call;                                                                \
+            device_profile_end((type), (key), device_profile_t);                 \
+        } while (0)
+#else
+#    define device_profile_report()
+#    define device_profile_reset()
+#    define device_profile_call(type, key, call) \
+        do {                                     \
+            call;                                \
+        } while (0)
+#endif
+
+#endif /*EMU_DEVICE_PROFILE_H*/
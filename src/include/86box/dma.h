@@ -99,7 +99,9 @@ extern void dma_set_drq(int channel, int set);
 extern int dma_channel_read_only(int channel);
 extern int dma_channel_advance(int channel);
 extern int dma_channel_read(int channel);
+extern int dma_channel_read_block(int channel, int *buf, int len);
 extern int dma_channel_write(int channel, uint16_t val);
+extern int dma_channel_write_block(int channel, const uint16_t *buf, int len);
 
 extern void dma_alias_set(void);
 extern void dma_alias_set_piix(void);
@@ -151,13 +151,14 @@ typedef struct hard_disk_t {
     uint8_t bus_mode;  /* Bit 0 = PIO suported;
                           Bit 1 = DMA supportd. */
     uint8_t wp; /* Disk has been mounted READ-ONLY */
-    uint8_t pad;
+    uint8_t use_mmap; /* Access raw/HDI/HDX image data through a file mapping */
     uint8_t pad0;
 
     void *priv;
 
     char fn[1024];         /* Name of current image file */
     char vhd_parent[1041]; /* Differential VHD parent file */
+    char overlay_fn[1024]; /* Copy-on-write overlay over a read-only fn */
 
     uint32_t seek_pos;
     uint32_t seek_len;
@@ -199,6 +200,7 @@ extern void     hdd_image_init(void);
 extern int      hdd_image_load(int id);
 extern void     hdd_image_seek(uint8_t id, uint32_t sector);
 extern void     hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern void     hdd_image_prefetch(uint8_t id, uint32_t sector, uint32_t count);
 extern int      hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern void     hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern int      hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
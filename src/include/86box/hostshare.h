@@ -0,0 +1,31 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the paravirtual host file share.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#ifndef EMU_HOSTSHARE_H
+#define EMU_HOSTSHARE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Global variables. */
+extern const device_t hostshare_device;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_HOSTSHARE_H*/
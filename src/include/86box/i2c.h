@@ -46,9 +46,15 @@ extern void i2c_handler(int set, void *bus_handle, uint8_t base, int size,
                         void (*stop)(void *bus, uint8_t addr, void *priv),
                         void *priv);
 
+extern void i2c_set_read_block(void *bus_handle, uint8_t base, int size,
+                               void (*read_block)(void *bus, uint8_t addr, uint8_t *data, int len, void *priv),
+                               void *priv);
+
 extern uint8_t i2c_start(void *bus_handle, uint8_t addr, uint8_t read);
 extern uint8_t i2c_read(void *bus_handle, uint8_t addr);
 extern uint8_t i2c_write(void *bus_handle, uint8_t addr, uint8_t data);
+extern void    i2c_read_block(void *bus_handle, uint8_t addr, uint8_t *data, int len);
+extern int     i2c_write_block(void *bus_handle, uint8_t addr, const uint8_t *data, int len);
 extern void    i2c_stop(void *bus_handle, uint8_t addr);
 
 /* i2c_eeprom.c */
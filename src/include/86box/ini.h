@@ -34,6 +34,8 @@ extern ini_t ini_read(const char *fn);
 extern void  ini_write(ini_t ini, const char *fn);
 extern void  ini_dump(ini_t ini);
 extern void  ini_close(ini_t ini);
+extern int   ini_has_changed(ini_t ini);
+extern ini_t ini_snapshot(ini_t ini);
 
 extern void     ini_section_delete_var(ini_section_t section, const char *name);
 extern int      ini_section_get_int(ini_section_t section, const char *name, int def);
@@ -110,6 +110,15 @@ extern void     outw(uint16_t port, uint16_t val);
 extern uint32_t inl(uint16_t port);
 extern void     outl(uint16_t port, uint32_t val);
 
+/* Block handlers move count units of size bytes per call and return how many
+   they moved; the REP INS/OUTS fast path falls back to single units on 0. */
+extern void io_block_handler(int set, uint16_t port,
+                             int (*read)(uint16_t addr, void *buf, int count, int size, void *priv),
+                             int (*write)(uint16_t addr, const void *buf, int count, int size, void *priv),
+                             void *priv);
+extern int  io_read_block(uint16_t port, void *buf, int count, int size);
+extern int  io_write_block(uint16_t port, const void *buf, int count, int size);
+
 extern void *io_trap_add(void (*func)(int size, uint16_t addr, uint8_t write, uint8_t val, void *priv),
                          void *priv);
 extern void  io_trap_remap(void *handle, int enable, uint16_t addr, uint16_t size);
@@ -48,6 +48,8 @@ typedef struct kbc_at_port_t {
     void *priv;
 
     void (*poll)(void *priv);
+    int  (*idle)(void *priv); /* Nothing to do until the controller or the host
+                                 talks to it, NULL if it cannot tell. */
 } kbc_at_port_t;
 
 /* Used by the AT / PS/2 common device, keyboard, and mouse. */
@@ -80,11 +82,15 @@ typedef struct atkbc_dev_t {
     int     z;
     int     b;
     int     ignore;
+    int     input_waiting;
 
     int     *scan;
 
     void    (*process_cmd)(void *priv);
     void    (*execute_bat)(void *priv);
+    /* Optional, queues more host input once the scan queue has been sent
+       out, returns non-zero while there is still more waiting. */
+    int     (*fill_queue)(void *priv);
 
     kbc_at_port_t *port;
 } atkbc_dev_t;
@@ -196,6 +202,7 @@ extern "C" {
 
 extern uint8_t keyboard_mode;
 extern int     keyboard_scan;
+extern int     keyboard_paste_paced;
 
 extern void (*keyboard_send)(uint16_t val);
 extern void kbd_adddata_process(uint16_t val, void (*adddata)(uint16_t val));
@@ -267,6 +274,8 @@ extern void     keyboard_poll_host(void);
 extern void     keyboard_process(void);
 extern uint16_t keyboard_convert(int ch);
 extern void     keyboard_input(int down, uint16_t scan);
+extern void     keyboard_paste_text(const char *text);
+extern int      keyboard_paste_poll(void);
 extern void     keyboard_update_states(uint8_t cl, uint8_t nl, uint8_t sl);
 extern uint8_t  keyboard_get_shift(void);
 extern void     keyboard_get_states(uint8_t *cl, uint8_t *nl, uint8_t *sl);
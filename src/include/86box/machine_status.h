@@ -1,13 +1,17 @@
 #ifndef EMU_MACHINE_STATUS_H
 #define EMU_MACHINE_STATUS_H
 
+/* seen latches activity until the status bar next polls it, so it can
+   show bursts shorter than its refresh interval. */
 typedef struct dev_status_empty_active_t {
     atomic_bool_t empty;
     atomic_bool_t active;
+    atomic_bool_t seen;
 } dev_status_empty_active_t;
 
 typedef struct dev_status_active_t {
     atomic_bool_t active;
+    atomic_bool_t seen;
 } dev_status_active_t;
 
 typedef struct dev_status_empty_t {
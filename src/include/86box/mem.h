@@ -197,6 +197,50 @@ typedef struct _mem_mapping_ {
     void *priv; /* backpointer to device */
 } mem_mapping_t;
 
+/*
+ * Calls into a mapping's handlers. With the DEVICE_PROFILE build option the
+ * time spent in them is charged to the mapping's device; mappings without
+ * private data (plain RAM) are not timed.
+ */
+#ifdef USE_DEVICE_PROFILE
+#    include <86box/device_profile.h>
+
+#    define MEM_MAP_READ(type, sz)                                                \
+        static __inline type mem_map_read_##sz(mem_mapping_t *map, uint32_t addr) \
+        {                                                                         \
+            type ret;                                                             \
+                                                                                  \
+            if (map->priv == NULL)                                                \
+                return map->read_##sz(addr, NULL);                                \
+            device_profile_call(DEVICE_PROFILE_MEM, map->priv,                    \
+                                ret = map->read_##sz(addr, map->priv));           \
+            return ret;                                                           \
+        }
+#    define MEM_MAP_WRITE(type, sz)                                                          \
+        static __inline void mem_map_write_##sz(mem_mapping_t *map, uint32_t addr, type val) \
+        {                                                                                    \
+            if (map->priv == NULL)                                                           \
+                map->write_##sz(addr, val, NULL);                                            \
+            else                                                                             \
+                device_profile_call(DEVICE_PROFILE_MEM, map->priv,                           \
+                                    map->write_##sz(addr, val, map->priv));                  \
+        }
+
+MEM_MAP_READ(uint8_t, b)
+MEM_MAP_READ(uint16_t, w)
+MEM_MAP_READ(uint32_t, l)
+MEM_MAP_WRITE(uint8_t, b)
+MEM_MAP_WRITE(uint16_t, w)
+MEM_MAP_WRITE(uint32_t, l)
+#else
+#    define mem_map_read_b(map, addr)       (map)->read_b((addr), (map)->priv)
+#    define mem_map_read_w(map, addr)       (map)->read_w((addr), (map)->priv)
+#    define mem_map_read_l(map, addr)       (map)->read_l((addr), (map)->priv)
+#    define mem_map_write_b(map, addr, val) (map)->write_b((addr), (val), (map)->priv)
+#    define mem_map_write_w(map, addr, val) (map)->write_w((addr), (val), (map)->priv)
+#    define mem_map_write_l(map, addr, val) (map)->write_l((addr), (val), (map)->priv)
+#endif
+
 #ifdef USE_NEW_DYNAREC
 extern uint64_t *byte_dirty_mask;
 extern uint64_t *byte_code_present_mask;
@@ -286,6 +330,12 @@ extern mem_mapping_t bios_high_mapping;
 
 extern uint32_t mem_logical_addr;
 
+extern uint32_t mem_mapping_gen;
+
+extern uint64_t mem_remap_count;
+extern uint64_t mem_remap_granules;
+extern uint64_t mem_remap_time;
+
 extern page_t  *pages;
 extern page_t **page_lookup;
 
@@ -353,10 +403,13 @@ extern void     writememll_no_mmut_2386(uint32_t addr, uint32_t *a64, uint32_t v
 extern void     do_mmutranslate_2386(uint32_t addr, uint32_t *a64, int num, int write);
 
 extern uint8_t *getpccache(uint32_t a);
+extern uint8_t *getpccache_2386(uint32_t a);
 extern uint64_t mmutranslatereal(uint32_t addr, int rw);
 extern uint32_t mmutranslatereal32(uint32_t addr, int rw);
 extern void     addreadlookup(uint32_t virt, uint32_t phys);
 extern void     addwritelookup(uint32_t virt, uint32_t phys);
+extern void     mem_add_direct_lookup(uint32_t virt, uint8_t *ptr, int write);
+extern void     mem_flush_direct_lookups(const uint8_t *base, uint32_t size);
 
 extern void mem_mapping_set(mem_mapping_t *,
                             uint32_t base,
@@ -412,6 +465,8 @@ extern void     mem_writeb_phys(uint32_t addr, uint8_t val);
 extern void     mem_writew_phys(uint32_t addr, uint16_t val);
 extern void     mem_writel_phys(uint32_t addr, uint32_t val);
 extern void     mem_write_phys(void *src, uint32_t addr, int tranfer_size);
+extern uint8_t *mem_get_phys_ptr(uint32_t addr, uint32_t len, int write);
+extern mem_mapping_t *mem_get_phys_mapping(uint32_t addr, int write);
 
 extern uint8_t  mem_read_ram(uint32_t addr, void *priv);
 extern uint16_t mem_read_ramw(uint32_t addr, void *priv);
@@ -442,8 +497,17 @@ extern void mem_reset_page_blocks(void);
 
 extern void flushmmucache(void);
 extern void flushmmucache_nopc(void);
+extern void flushmmucache_cr3(void);
+extern void flushmmucache_range(uint32_t base, uint32_t size);
 
 extern void mem_debug_check_addr(uint32_t addr, int write);
+/* Only call out when a breakpoint is enabled in DR7. Any file using this
+   needs cpu.h for dr[]. */
+#define mem_debug_check_addr(addr, write)            \
+    do {                                             \
+        if (dr[7] & 0x000000ff)                      \
+            (mem_debug_check_addr)((addr), (write)); \
+    } while (0)
 
 extern void mem_a20_init(void);
 extern void mem_a20_recalc(void);
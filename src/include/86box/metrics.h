@@ -0,0 +1,56 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the emulation speed metrics.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#ifndef EMU_METRICS_H
+#define EMU_METRICS_H
+
+/*
+ * Running totals, only ever incremented, by the emulation thread unless
+ * noted otherwise. The once a second report works on differences, so a
+ * torn read costs at most one odd sample.
+ */
+typedef struct metrics_counters_t {
+    uint64_t io_accesses;
+    uint64_t disk_read_bytes;
+    uint64_t disk_write_bytes;
+    uint64_t cdrom_read_bytes;
+    uint64_t net_rx_packets;
+    uint64_t net_tx_packets;
+    uint64_t dynarec_blocks;
+    uint64_t mmu_flushes;       /* Whole TLB. */
+    uint64_t mmu_range_flushes; /* Chipset remaps, one range. */
+    uint64_t svga_recalcs;
+    uint64_t blits;   /* Blit threads. */
+    uint64_t blit_us; /* Blit threads. */
+} metrics_counters_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int                metrics_enabled;
+extern metrics_counters_t metrics;
+
+extern void metrics_init(void);
+extern void metrics_onesec(int speed);
+extern void metrics_phase(uint8_t phase, int stop, double host_ms, double cpu_ms, double clocks);
+extern void metrics_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_METRICS_H*/
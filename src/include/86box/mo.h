@@ -106,6 +106,7 @@ typedef struct mo_drive_t {
                           Bit 1 = DMA supportd. */
     uint8_t read_only; /* Struct variable reserved for
                           media status. */
+    uint8_t turbo;     /* Skip the transfer time. */
     uint8_t pad;
     uint8_t pad0;
 
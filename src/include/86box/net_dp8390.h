@@ -198,6 +198,9 @@ extern int            dp3890_inst;
 extern uint32_t dp8390_chipmem_read(dp8390_t *dev, uint32_t addr, unsigned int len);
 extern void     dp8390_chipmem_write(dp8390_t *dev, uint32_t addr, uint32_t val, unsigned len);
 
+extern int dp8390_remote_read(dp8390_t *dev, uint8_t *buf, int len, int step);
+extern int dp8390_remote_write(dp8390_t *dev, const uint8_t *buf, int len, int step);
+
 extern uint32_t dp8390_read_cr(dp8390_t *dev);
 extern void     dp8390_write_cr(dp8390_t *dev, uint32_t val);
 
@@ -46,12 +46,21 @@
 #ifndef EMU_NETWORK_H
 #define EMU_NETWORK_H
 #include <stdint.h>
+#ifdef __cplusplus
+#    include <atomic>
+using atomic_int = std::atomic_int;
+using atomic_bool = std::atomic_bool;
+#else
+#    include <stdatomic.h>
+#endif
 
 /* Network provider types. */
 #define NET_TYPE_NONE  0 /* use the null network driver */
 #define NET_TYPE_SLIRP 1 /* use the SLiRP port forwarder */
 #define NET_TYPE_PCAP  2 /* use the (Win)Pcap API */
 #define NET_TYPE_VDE   3 /* use the VDE plug API */
+#define NET_TYPE_TAP   4 /* use a Linux TAP interface */
+#define NET_TYPE_SHM   5 /* use a shared memory segment between instances */
 
 #define NET_MAX_FRAME  1518
 /* Queue size must be a power of 2 */
@@ -64,6 +73,9 @@
 #define NET_PERIOD_10M     0.8
 #define NET_PERIOD_100M    0.08
 
+/* Time without traffic (in us) after which the card timer is disarmed */
+#define NET_IDLE_TIME      100000
+
 /* Error buffers for network driver init */
 #define NET_DRV_ERRBUF_SIZE 384
 
@@ -107,10 +119,11 @@ typedef struct netpkt {
     int      len;
 } netpkt_t;
 
+/* Lock-free, single producer and single consumer. */
 typedef struct netqueue_t {
-    netpkt_t packets[NET_QUEUE_LEN];
-    int      head;
-    int      tail;
+    netpkt_t   packets[NET_QUEUE_LEN];
+    atomic_int head;
+    atomic_int tail;
 } netqueue_t;
 
 typedef struct _netcard_t netcard_t;
@@ -125,6 +138,8 @@ typedef struct netdrv_t {
 extern const netdrv_t net_pcap_drv;
 extern const netdrv_t net_slirp_drv;
 extern const netdrv_t net_vde_drv;
+extern const netdrv_t net_tap_drv;
+extern const netdrv_t net_shm_drv;
 extern const netdrv_t net_null_drv;
 
 struct _netcard_t {
@@ -135,14 +150,15 @@ struct _netcard_t {
     NETSETLINKSTATE set_link_state;
     netqueue_t      queues[NET_QUEUE_COUNT];
     netpkt_t        queued_pkt;
-    mutex_t        *tx_mutex;
-    mutex_t        *rx_mutex;
     pc_timer_t      timer;
     uint16_t        card_num;
     double          byte_period;
     uint32_t        led_timer;
     uint32_t        led_state;
     uint32_t        link_state;
+    uint32_t        idle_time;
+    int             idle;
+    atomic_bool     wake;
 };
 
 typedef struct {
@@ -154,10 +170,12 @@ typedef struct {
     int has_slirp;
     int has_pcap;
     int has_vde;
+    int has_tap;
+    int has_shm;
 } network_devmap_t;
 
 
-#define HAS_NOSLIRP_NET(x)  (x.has_pcap || x.has_vde)
+#define HAS_NOSLIRP_NET(x)  (x.has_pcap || x.has_vde || x.has_tap || x.has_shm)
 
 #ifdef __cplusplus
 extern "C" {
@@ -179,9 +197,13 @@ extern void       network_close(void);
 extern void       network_reset(void);
 extern int        network_available(void);
 extern void       network_tx(netcard_t *card, uint8_t *, int);
+extern uint8_t   *network_tx_buf_get(netcard_t *card);
+extern int        network_tx_buf_commit(netcard_t *card, int len);
+extern void       network_process(void);
 
 extern int net_pcap_prepare(netdev_t *);
 extern int net_vde_prepare(void);
+extern int net_tap_prepare(void);
 
 
 extern void            network_connect(int id, int connect);
@@ -200,6 +222,16 @@ extern int network_tx_pop(netcard_t *card, netpkt_t *out_pkt);
 extern int network_tx_popv(netcard_t *card, netpkt_t *pkt_vec, int vec_size);
 extern int network_rx_put(netcard_t *card, uint8_t *bufp, int len);
 extern int network_rx_put_pkt(netcard_t *card, netpkt_t *pkt);
+extern int network_rx_space(netcard_t *card);
+
+/* Packet trace, see net_dump.c. */
+extern int      net_dump_enabled;
+extern uint32_t net_dump_snaplen; /* bytes kept per frame, 0 for whole frames */
+extern uint32_t net_dump_limit;   /* MB per trace file before rotating, 0 for no limit */
+
+extern void net_dump_init(void);
+extern void net_dump_close(void);
+extern void net_dump_packet(int card_num, int outbound, const uint8_t *data, int len);
 
 #ifdef EMU_DEVICE_H
 /* 3Com Etherlink */
@@ -67,6 +67,7 @@ typedef struct PIT {
     int        flags;
     int        clock;
     pc_timer_t callback_timer;
+    uint32_t   fast_ticks; /* Clocks the timer is skipping over, see pit_schedule(). */
 
     ctr_t counters[3];
 
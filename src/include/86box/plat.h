@@ -134,6 +134,7 @@ extern int hide_tool_bar;
 extern FILE    *plat_fopen(const char *path, const char *mode);
 extern FILE    *plat_fopen64(const char *path, const char *mode);
 extern void     plat_remove(char *path);
+extern int      plat_rename(const char *from, const char *to);
 extern int      plat_getcwd(char *bufp, int max);
 extern int      plat_chdir(char *path);
 extern void     plat_tempfile(char *bufp, char *prefix, char *suffix);
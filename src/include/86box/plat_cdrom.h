@@ -57,6 +57,7 @@ extern int      plat_cdrom_get_audio_track_info(int end, int track, int *track_n
 extern int      plat_cdrom_get_audio_sub(uint32_t sector, uint8_t *attr, uint8_t *track, uint8_t *index, TMSF *rel_pos, TMSF *abs_pos);
 extern int      plat_cdrom_get_sector_size(uint32_t sector);
 extern int      plat_cdrom_read_sector(uint8_t *buffer, int raw, uint32_t sector);
+extern int      plat_cdrom_read_sectors(uint8_t *buffer, uint32_t sector, int count);
 extern void     plat_cdrom_eject(void);
 extern void     plat_cdrom_close(void);
 extern int      plat_cdrom_set_drive(const char *drv);
@@ -26,7 +26,7 @@ extern "C" {
 #endif
 
 extern void plat_serpt_write(void *priv, uint8_t data);
-extern int  plat_serpt_read(void *priv, uint8_t *data);
+extern int  plat_serpt_read_block(void *priv, uint8_t *buf, int len, int timeout_ms);
 extern int  plat_serpt_open_device(void *priv);
 extern void plat_serpt_close(void *priv);
 extern void plat_serpt_set_params(void *priv);
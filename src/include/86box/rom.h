@@ -47,6 +47,7 @@ typedef struct rom_path_t {
 extern rom_path_t rom_paths;
 
 extern void rom_add_path(const char *path);
+extern void rom_cache_flush(void);
 
 extern uint8_t  rom_read(uint32_t addr, void *priv);
 extern uint16_t rom_readw(uint32_t addr, void *priv);
@@ -64,6 +64,11 @@ typedef struct scsi_disk_t {
     uint32_t packet_len;
 
     double callback;
+
+    /* Kept across commands so that temp_buffer does not have to be allocated
+       and freed for each one. */
+    uint8_t *buf_pool;
+    uint32_t buf_pool_len;
 } scsi_disk_t;
 
 extern scsi_disk_t *scsi_disk[HDD_NUM];
@@ -53,6 +53,7 @@ typedef struct serial_passthrough_s {
     char  host_serial_path[1024];              /* Path to TTY/host serial port on the host */
     char  named_pipe[1024];                    /* (Windows only) Name of the pipe. */
     void *backend_priv;                        /* Private platform backend data */
+    struct serpt_reader_s *reader;             /* Host reader thread and its buffer */
 } serial_passthrough_t;
 
 extern bool           serial_passthrough_enabled[SERIAL_MAX];
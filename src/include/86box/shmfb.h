@@ -0,0 +1,73 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the shared memory frame output.
+ *
+ *          Every blitted frame is published into a POSIX shared memory
+ *          object named after the video_shm_name option, with "-<n>"
+ *          appended for monitors other than the first. The object
+ *          starts with a shmfb_header_t followed by SHMFB_SLOTS frame
+ *          slots of SHMFB_MAX_Y rows of SHMFB_STRIDE bytes, each pixel
+ *          being 0x00RRGGBB in host byte order.
+ *
+ *          Readers look up the slot of the frame they want through
+ *          header->seq, and use the slot's seq as a sequence lock: it
+ *          is odd while the slot is being written, and the frame is
+ *          only consistent when it reads the same even value before
+ *          and after copying the pixels out.
+ */
+#ifndef EMU_SHMFB_H
+#define EMU_SHMFB_H
+
+#include <stdint.h>
+
+#define SHMFB_MAGIC   "86BoxFB1"
+#define SHMFB_VERSION 1
+#define SHMFB_SLOTS   3
+#define SHMFB_MAX_X   2048
+#define SHMFB_MAX_Y   2048
+#define SHMFB_STRIDE  (SHMFB_MAX_X * 4)
+
+typedef struct shmfb_slot_t {
+    volatile uint64_t seq;      /* frame number * 2, odd while being written */
+    uint32_t          w;
+    uint32_t          h;
+    uint32_t          dirty_y1; /* rows dirty_y1 to (dirty_y2 - 1) changed */
+    uint32_t          dirty_y2; /* since the previous frame */
+    uint64_t          offset;   /* of the pixels, from the start of the object */
+} shmfb_slot_t;
+
+typedef struct shmfb_header_t {
+    char              magic[8];
+    uint32_t          version;
+    uint32_t          slots;
+    uint32_t          max_x;
+    uint32_t          max_y;
+    uint32_t          stride;
+    uint32_t          monitor;
+    volatile uint64_t seq; /* number of the latest complete frame, 0 if none */
+    shmfb_slot_t      slot[SHMFB_SLOTS];
+} shmfb_header_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef USE_SHMFB
+extern void shmfb_publish(int x, int y, int w, int h, int dirty_y1, int dirty_y2, int monitor_index);
+extern void shmfb_close(int monitor_index);
+#else
+#    define shmfb_publish(x, y, w, h, dirty_y1, dirty_y2, monitor_index)
+#    define shmfb_close(monitor_index)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SHMFB_H*/
@@ -0,0 +1,59 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the machine state snapshot facility.
+ *
+ *          A snapshot is only valid for the build and the machine
+ *          configuration it was taken with: state is serialized as
+ *          raw host structures, and devices are matched by order
+ *          and internal name.
+ */
+#ifndef EMU_SNAPSHOT_H
+#define EMU_SNAPSHOT_H
+
+#include <stddef.h>
+
+typedef struct snapshot_t snapshot_t;
+
+struct pc_timer_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Requests from the UI or monitor threads, carried out by pc_run(). */
+extern volatile int snapshot_pending;
+
+extern void snapshot_request(const char *fn, int load);
+extern void snapshot_process(void);
+
+extern int snapshot_save(const char *fn);
+extern int snapshot_load(const char *fn);
+
+/* For the state handlers: the same handler both saves and loads. */
+extern int  snapshot_loading(snapshot_t *snap);
+extern int  snapshot_failed(snapshot_t *snap);
+extern void snapshot_error(snapshot_t *snap, const char *fmt, ...);
+extern void snapshot_data(snapshot_t *snap, void *data, size_t len);
+extern void snapshot_timer(snapshot_t *snap, struct pc_timer_t *timer);
+extern void snapshot_device(snapshot_t *snap, const char *name, int nr,
+                            void (*handler)(void *priv, snapshot_t *snap), void *priv);
+
+#define snapshot_var(snap, var) snapshot_data((snap), &(var), sizeof(var))
+
+/* Core state that does not belong to a device_t. */
+extern void cpu_snapshot(snapshot_t *snap);
+extern void mem_snapshot(snapshot_t *snap);
+extern void pic_snapshot(snapshot_t *snap);
+extern void dma_snapshot(snapshot_t *snap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SNAPSHOT_H*/
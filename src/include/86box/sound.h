@@ -23,6 +23,9 @@
 #define SOUND_CARD_MAX 4 /* currently we support up to 4 sound cards and a standalome MPU401 */
 
 extern int sound_gain;
+extern int sound_low_latency;
+
+extern uint32_t sound_underruns;
 
 #define FREQ_44100  44100
 #define FREQ_48000  48000
@@ -42,6 +45,12 @@ extern int sound_gain;
 #define WT_FREQ     FREQ_44100
 #define WTBUFLEN    (MUSIC_FREQ / 45)
 
+/* Output queue depth in SOUNDBUFLEN periods. The low latency mode starts at
+   the minimum and only grows when the backend reports an underrun. */
+#define SOUND_QUEUE_MIN     2
+#define SOUND_QUEUE_DEFAULT 4
+#define SOUND_QUEUE_MAX     8
+
 enum {
     SOUND_NONE = 0,
     SOUND_INTERNAL
@@ -52,11 +61,20 @@ extern int gated;
 extern int speakval;
 extern int speakon;
 
+/* Positions within the current output buffers. They are only brought up to
+   date by the matching *_pos_sync() call, which sources catching up to the
+   current time have to make first. */
 extern int sound_pos_global;
 
 extern int music_pos_global;
 extern int wavetable_pos_global;
 
+extern void     sound_pos_sync(void);
+extern int      sound_pos_at(uint64_t ts);
+extern uint64_t sound_buf_end_ts(void);
+extern void     music_pos_sync(void);
+extern void     wavetable_pos_sync(void);
+
 extern int sound_card_current[SOUND_CARD_MAX];
 
 extern void sound_add_handler(void (*get_buffer)(int32_t *buffer,
@@ -104,9 +122,17 @@ extern void sound_cd_thread_reset(void);
 extern void closeal(void);
 extern void inital(void);
 extern void givealbuffer(const void *buf);
-extern void givealbuffer_music(const void *buf);
-extern void givealbuffer_wt(const void *buf);
-extern void givealbuffer_cd(const void *buf);
+
+/* Backend side of the output queue controller. */
+extern int  sound_queue_depth(void);
+extern void sound_queue_reset(void);
+extern void sound_queue_underrun(void);
+
+/* Shared render worker pool, see sound.c. */
+extern int  sound_render_add(void (*render)(void *priv), void *priv);
+extern void sound_render_request(int id);
+extern void sound_render_wait(int id);
+extern void sound_render_remove(int id);
 
 #define sb_vibra16c_onboard_relocate_base sb_vibra16s_onboard_relocate_base
 extern void sb_vibra16s_onboard_relocate_base(uint16_t new_addr, void *priv);
@@ -34,6 +34,7 @@ extern "C" {
 #    define thread_set_event                    plat_thread_set_event
 #    define thread_reset_event                  plat_thread_reset_event
 #    define thread_wait_event                   plat_thread_wait_event
+#    define thread_wait_event_spin              plat_thread_wait_event_spin
 #    define thread_destroy_event                plat_thread_destroy_event
 
 #    define thread_create_mutex                 plat_thread_create_mutex
@@ -41,6 +42,8 @@ extern "C" {
 #    define thread_close_mutex                  plat_thread_close_mutex
 #    define thread_wait_mutex                   plat_thread_wait_mutex
 #    define thread_release_mutex                plat_thread_release_mutex
+
+#    define thread_get_cpu_count                plat_thread_get_cpu_count
 #endif
 
 /* Thread support. */
@@ -55,6 +58,8 @@ extern event_t  *thread_create_event(void);
 extern void      thread_set_event(event_t *arg);
 extern void      thread_reset_event(event_t *arg);
 extern int       thread_wait_event(event_t *arg, int timeout);
+/* Polls the event spins times before blocking, for waits that are usually short. */
+extern int       thread_wait_event_spin(event_t *arg, int timeout, int spins);
 extern void      thread_destroy_event(event_t *arg);
 
 extern mutex_t *thread_create_mutex(void);
@@ -63,6 +68,29 @@ extern int      thread_test_mutex(mutex_t *arg);
 extern int      thread_wait_mutex(mutex_t *arg);
 extern int      thread_release_mutex(mutex_t *mutex);
 
+/* Number of host CPU cores available for worker threads, at least 1. */
+extern int thread_get_cpu_count(void);
+
+/* Thread classes for host CPU placement, see thread_placement.c. */
+enum {
+    THREAD_CLASS_OTHER = 0,
+    THREAD_CLASS_CPU,
+    THREAD_CLASS_BLIT,
+    THREAD_CLASS_VOODOO_RENDER,
+    THREAD_CLASS_VOODOO_FIFO,
+    THREAD_CLASS_SOUND,
+    THREAD_CLASS_NET,
+    THREAD_CLASS_MAX
+};
+
+#define THREAD_CPUS_LEN 64
+
+extern char        thread_class_cpus[THREAD_CLASS_MAX][THREAD_CPUS_LEN]; /* (C) host CPU list, empty = default */
+extern int         thread_class_priority[THREAD_CLASS_MAX];              /* (C) -1 = low, 0 = unchanged, 1 = high */
+extern const char *thread_class_names[THREAD_CLASS_MAX];
+
+extern void thread_placement_apply(const char *name);
+
 #ifdef __cplusplus
 }
 #endif
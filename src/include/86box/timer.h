@@ -50,8 +50,11 @@ typedef struct pc_timer_t {
     void (*callback)(void *priv);
     void *priv;
 
-    struct pc_timer_t *prev;
-    struct pc_timer_t *next;
+    uint32_t heap_idx; /* Position in the timer heap, valid while enabled. */
+    uint32_t seq;      /* Insertion order, breaks ties between equal timestamps. */
+
+    uint32_t inserts; /* Statistics: number of times the timer was armed... */
+    uint32_t fires;   /* ...and number of times its callback was called. */
 } pc_timer_t;
 
 #ifdef __cplusplus
@@ -62,6 +65,10 @@ extern "C" {
   when TSC matches or exceeds this.*/
 extern uint32_t timer_target;
 
+/*Total number of timer insertions and expirations since timer_init()*/
+extern uint64_t timer_total_inserts;
+extern uint64_t timer_total_fires;
+
 /*Enable timer, without updating timestamp*/
 extern void timer_enable(pc_timer_t *timer);
 /*Disable timer*/
@@ -70,6 +77,10 @@ extern void timer_disable(pc_timer_t *timer);
 /*Process any pending timers*/
 extern void timer_process(void);
 
+/*Move every enabled timer by delta TSC cycles, for when the TSC itself is
+  changed (snapshot load)*/
+extern void timer_rebase(int64_t delta);
+
 /*Reset timer system*/
 extern void timer_close(void);
 extern void timer_init(void);
@@ -167,6 +178,17 @@ timer_get_remaining_u64(pc_timer_t *timer)
     return 0;
 }
 
+/*Bring a timer that is waiting out a long period forward so that it expires
+  within delay, specified in 32:32 format. Lets a polling device slow down
+  while idle and wake up on activity; timers due sooner or disabled are left
+  alone*/
+static __inline void
+timer_wake_u64(pc_timer_t *timer, uint64_t delay)
+{
+    if (timer_is_enabled(timer) && (timer_get_remaining_u64(timer) > delay))
+        timer_set_delay_u64(timer, delay);
+}
+
 /*Set timer callback function*/
 static __inline void
 timer_set_callback(pc_timer_t *timer, void (*callback)(void *priv))
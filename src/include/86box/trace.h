@@ -0,0 +1,82 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the Chrome trace instrumentation.
+ *
+ *          Enabled with the MINITRACE build option, recorded between
+ *          Begin trace and End trace. Every event belongs to a category
+ *          that can be turned on and off while the trace is running,
+ *          through the trace_categories mask (set from the configuration
+ *          file); the category name is also the event category shown in
+ *          the trace viewer.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#ifndef EMU_TRACE_H
+#define EMU_TRACE_H
+
+#define TRACE_CAT_cpu     (1 << 0) /* CPU execution slices */
+#define TRACE_CAT_timer   (1 << 1) /* timer callbacks */
+#define TRACE_CAT_dynarec (1 << 2) /* block recompilation */
+#define TRACE_CAT_video   (1 << 3) /* blitting and screenshots */
+#define TRACE_CAT_voodoo  (1 << 4) /* Voodoo FIFO and render threads */
+#define TRACE_CAT_sound   (1 << 5) /* sound buffer generation */
+#define TRACE_CAT_network (1 << 6) /* network card queues */
+#define TRACE_CAT_disk    (1 << 7) /* hard disk image I/O */
+#define TRACE_CAT_ALL     0xff
+
+#ifdef MTR_ENABLED
+#    include <minitrace/minitrace.h>
+
+#    ifdef __cplusplus
+extern "C" {
+#    endif
+
+extern uint32_t trace_categories;
+
+#    ifdef __cplusplus
+}
+#    endif
+
+#    define trace_enabled(cat) (trace_categories & TRACE_CAT_##cat)
+
+/* cat is one of the bare category names above, e.g. TRACE_BEGIN(cpu, "exec"). */
+#    define TRACE_BEGIN(cat, name)     \
+        do {                           \
+            if (trace_enabled(cat))    \
+                MTR_BEGIN(#cat, name); \
+        } while (0)
+#    define TRACE_END(cat, name)     \
+        do {                         \
+            if (trace_enabled(cat))  \
+                MTR_END(#cat, name); \
+        } while (0)
+#    define TRACE_BEGIN_I(cat, name, arg, val)     \
+        do {                                       \
+            if (trace_enabled(cat))                \
+                MTR_BEGIN_I(#cat, name, arg, val); \
+        } while (0)
+#    define TRACE_COUNTER(cat, name, val)     \
+        do {                                  \
+            if (trace_enabled(cat))           \
+                MTR_COUNTER(#cat, name, val); \
+        } while (0)
+#else
+#    define trace_enabled(cat) 0
+
+#    define TRACE_BEGIN(cat, name)
+#    define TRACE_END(cat, name)
+#    define TRACE_BEGIN_I(cat, name, arg, val)
+#    define TRACE_COUNTER(cat, name, val)
+#endif
+
+#endif /*EMU_TRACE_H*/
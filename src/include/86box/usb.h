@@ -22,6 +22,31 @@
 extern "C" {
 #endif
 
+#define USB_NUM_PORTS 2
+
+/* Results of a transaction, as returned by usb_device_c.handle_packet. */
+enum {
+    USB_ERROR_NO_ERROR = 0,
+    USB_ERROR_NAK,
+    USB_ERROR_STALL,
+    USB_ERROR_OVERRUN
+};
+
+enum {
+    USB_PID_OUT   = 0xe1,
+    USB_PID_IN    = 0x69,
+    USB_PID_SETUP = 0x2d
+};
+
+/* A function plugged into a root hub port. */
+typedef struct usb_device_c {
+    uint8_t address; /* Kept by the device, from SET_ADDRESS. */
+    int     low_speed;
+    /* *len is the buffer size on entry, the bytes moved on return. */
+    int   (*handle_packet)(void *priv, uint8_t pid, uint8_t endpoint, uint8_t *data, uint32_t *len);
+    void   *priv;
+} usb_device_c;
+
 typedef struct usb_t {
     uint8_t       uhci_io[32];
     uint8_t       ohci_mmio[4096];
@@ -30,6 +55,19 @@ typedef struct usb_t {
     int           ohci_enable;
     uint32_t      ohci_mem_base;
     mem_mapping_t ohci_mmio_mapping;
+
+    /* Schedule engine; both controllers run one frame per 1 ms timer tick
+       while they are running. */
+    pc_timer_t    uhci_frame_timer;
+    pc_timer_t    ohci_frame_timer;
+    uint32_t      ohci_done_head; /* Retired TDs not written to the HCCA yet. */
+    usb_device_c *ports[USB_NUM_PORTS];
+    int           ports_used;
+
+    int     slot;
+    int     irq_pin;
+    int     irq_level;
+    uint8_t irq_state;
 } usb_t;
 
 /* Global variables. */
@@ -38,6 +76,9 @@ extern const device_t usb_device;
 /* Functions. */
 extern void uhci_update_io_mapping(usb_t *dev, uint8_t base_l, uint8_t base_h, int enable);
 extern void ohci_update_mem_mapping(usb_t *dev, uint8_t base1, uint8_t base2, uint8_t base3, int enable);
+extern void usb_set_slot(usb_t *dev, int slot, int irq_pin);
+extern int  usb_attach_device(usb_t *dev, usb_device_c *device);
+extern void usb_detach_device(usb_t *dev, usb_device_c *device);
 
 #ifdef __cplusplus
 }
@@ -229,4 +229,8 @@ typedef struct ibm8514_t {
     latch8514_t latch;
 } ibm8514_t;
 
+extern int ibm8514_accel_row(ibm8514_t *dev, int mix, int blit, uint16_t color, uint16_t wrt_mask,
+                             uint32_t dest, int x, int xdir, int y, uint32_t src, int sx, int sxdir, int n,
+                             int clip_l, int clip_r, int clip_t, int clip_b);
+
 #endif /*VIDEO_8514A_H*/
@@ -186,8 +186,8 @@ extern int      cgablink;
 
 extern int scrollcache;
 
-extern uint8_t edatlookup[4][4];
-extern uint8_t egaremap2bpp[256];
+extern uint32_t edatlookup8[256];
+extern uint8_t  egaremap2bpp[256];
 
 #if defined(EMU_MEM_H) && defined(EMU_ROM_H)
 void ega_render_blank(ega_t *ega);
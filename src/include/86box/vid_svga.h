@@ -57,6 +57,10 @@ typedef struct svga_t {
     mem_mapping_t mapping;
 
     uint8_t fast;
+    uint8_t lfb_direct; /* the CPU has direct lookups to linear frame buffer pages */
+    uint8_t *lfb_charged; /* pages charged their bus time this frame, one byte each */
+    uint32_t lfb_pages;
+    uint8_t recalc_pending; /* CRTC timings changed, recalculate at the next line */
     uint8_t chain4;
     uint8_t chain2_write;
     uint8_t chain2_read;
@@ -112,6 +116,7 @@ typedef struct svga_t {
     int lastline;
     int firstline_draw;
     int lastline_draw;
+    int dirty_blit; /* Only the lines drawn this frame need to reach the host. */
     int displine;
     int fullchange;
     int x_add;
@@ -159,6 +164,7 @@ typedef struct svga_t {
     uint32_t  banked_mask;
     uint32_t  ca;
     uint32_t  overscan_color;
+    uint32_t  dirty_overscan_color;
     uint32_t *map8;
     uint32_t  pallook[512];
 
@@ -292,6 +298,9 @@ typedef struct svga_t {
     void *  ext8514;
     void *  clock_gen8514;
     void *  xga;
+
+    /* Scanline render worker, NULL when lines are rendered in svga_poll(). */
+    void *render_thread;
 } svga_t;
 
 extern int      vga_on;
@@ -328,6 +337,8 @@ extern int  svga_init(const device_t *info, svga_t *svga, void *priv, int memsiz
                       void (*hwcursor_draw)(struct svga_t *svga, int displine),
                       void (*overlay_draw)(struct svga_t *svga, int displine));
 extern void svga_recalctimings(svga_t *svga);
+extern void svga_recalctimings_crtc(svga_t *svga);
+extern void svga_lfb_direct_flush(svga_t *svga);
 extern void svga_close(svga_t *svga);
 
 uint8_t  svga_read(uint32_t addr, void *priv);
@@ -431,6 +442,7 @@ extern uint8_t tkd8001_ramdac_in(uint16_t addr, void *priv, svga_t *svga);
 
 extern void     tvp3026_ramdac_out(uint16_t addr, int rs2, int rs3, uint8_t val, void *priv, svga_t *svga);
 extern uint8_t  tvp3026_ramdac_in(uint16_t addr, int rs2, int rs3, void *priv, svga_t *svga);
+extern uint32_t svga_conv_16to32(struct svga_t *svga, uint16_t color, uint8_t bpp);
 extern uint32_t tvp3026_conv_16to32(svga_t* svga, uint16_t color, uint8_t bpp);
 extern void     tvp3026_recalctimings(void *priv, svga_t *svga);
 extern void     tvp3026_hwcursor_draw(svga_t *svga, int displine);
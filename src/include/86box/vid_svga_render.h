@@ -33,8 +33,8 @@ extern int      cgablink;
 
 extern int scrollcache;
 
-extern uint8_t edatlookup[4][4];
-extern uint8_t egaremap2bpp[256];
+extern uint32_t edatlookup8[256];
+extern uint8_t  egaremap2bpp[256];
 
 extern void svga_recalc_remap_func(svga_t *svga);
 
@@ -87,4 +87,9 @@ extern void ibm8514_render_RGBA8888(svga_t *svga);
 
 extern void (*svga_render)(svga_t *svga);
 
+extern void svga_render_thread_init(svga_t *svga);
+extern void svga_render_thread_close(svga_t *svga);
+extern int  svga_render_thread_queue(svga_t *svga);
+extern void svga_render_thread_wait(svga_t *svga);
+
 #endif /*VID_SVGA_RENDER_H*/
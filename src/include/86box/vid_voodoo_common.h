@@ -29,8 +29,13 @@
 #define LOD_MAX         8
 
 #define TEX_DIRTY_SHIFT 10
+#define TEX_DIRTY_PAGES 16384 /*16 MB of texture memory in 1 kB pages*/
 
-#define TEX_CACHE_MAX   64
+#define TEX_CACHE_MAX   256
+#define TEX_HASH_SHIFT  7
+#define TEX_HASH_SIZE   (1 << TEX_HASH_SHIFT)
+
+#define VOODOO_MAX_RENDER_THREADS 16
 
 #ifdef __cplusplus
 #    include <atomic>
@@ -234,12 +239,15 @@ typedef struct texture_t {
     uint32_t   base;
     uint32_t   tLOD;
     atomic_int refcount;
-    atomic_int refcount_r[4];
+    atomic_int refcount_r[VOODOO_MAX_RENDER_THREADS];
     int        is16;
     uint32_t   palette_checksum;
     uint32_t   addr_start[4];
     uint32_t   addr_end[4];
-    uint32_t  *data;
+    uint32_t  *data; /*allocated on first use*/
+    int        hash_next; /*next entry in the same hash bucket, -1 at the end*/
+    int        lru_prev;  /*towards the most recently used entry*/
+    int        lru_next;  /*towards the least recently used entry*/
 } texture_t;
 
 typedef struct vert_t {
@@ -266,6 +274,11 @@ typedef struct clip_t {
     int y_max;
 } clip_t;
 
+typedef struct voodoo_render_thread_t {
+    struct voodoo_t *voodoo;
+    int              odd_even; /* Index of the thread, selects the scanlines it renders. */
+} voodoo_render_thread_t;
+
 typedef struct voodoo_t {
     mem_mapping_t mapping;
 
@@ -362,25 +375,26 @@ typedef struct voodoo_t {
     int    ncc_dirty[2];
 
     thread_t *fifo_thread;
-    thread_t *render_thread[4];
+    thread_t *render_thread[VOODOO_MAX_RENDER_THREADS];
     event_t  *wake_fifo_thread;
     event_t  *wake_main_thread;
     event_t  *fifo_not_full_event;
-    event_t  *render_not_full_event[4];
-    event_t  *wake_render_thread[4];
+    event_t  *render_not_full_event[VOODOO_MAX_RENDER_THREADS];
+    event_t  *wake_render_thread[VOODOO_MAX_RENDER_THREADS];
+
+    voodoo_render_thread_t render_thread_data[VOODOO_MAX_RENDER_THREADS];
 
     int voodoo_busy;
-    int render_voodoo_busy[4];
+    int render_voodoo_busy[VOODOO_MAX_RENDER_THREADS];
 
     int render_threads;
-    int odd_even_mask;
 
-    int pixel_count[4];
-    int texel_count[4];
+    int pixel_count[VOODOO_MAX_RENDER_THREADS];
+    int texel_count[VOODOO_MAX_RENDER_THREADS];
     int tri_count;
     int frame_count;
-    int pixel_count_old[4];
-    int texel_count_old[4];
+    int pixel_count_old[VOODOO_MAX_RENDER_THREADS];
+    int texel_count_old[VOODOO_MAX_RENDER_THREADS];
     int wr_count;
     int rd_count;
     int tex_count;
@@ -403,14 +417,24 @@ typedef struct voodoo_t {
     int type;
 
     fifo_entry_t fifo[FIFO_SIZE];
+    /*fifo_read_idx is only written by the FIFO thread and fifo_write_idx by
+      the CPU thread; keep them on separate cache lines*/
     atomic_int   fifo_read_idx;
+    uint8_t      fifo_read_pad[64 - sizeof(atomic_int)];
     atomic_int   fifo_write_idx;
+    int          fifo_read_idx_cached; /*CPU thread's last look at fifo_read_idx*/
+    atomic_int   fifo_waiting;         /*CPU thread is waiting on fifo_not_full_event*/
+    uint8_t      fifo_write_pad[64 - (3 * sizeof(int))];
+    int          fifo_max_depth;
+    uint64_t     fifo_stalls;
+    uint64_t     fifo_stall_time;
+    uint64_t     fifo_wakes;
     atomic_int   cmd_read;
     atomic_int   cmd_written;
     atomic_int   cmd_written_fifo;
 
     voodoo_params_t params_buffer[PARAM_SIZE];
-    atomic_int      params_read_idx[4];
+    atomic_int      params_read_idx[VOODOO_MAX_RENDER_THREADS];
     atomic_int      params_write_idx;
 
     uint32_t   cmdfifo_base;
@@ -641,16 +665,24 @@ typedef struct voodoo_t {
     uint8_t  thefilterg[256][256];
     uint8_t  thefilterb[256][256];
     uint16_t purpleline[256][3];
+    int      filter_v2;     /* which generator built the tables */
+    int      filter_cap[3]; /* thresholds they were built with, blue, green, red */
 
     texture_t texture_cache[2][TEX_CACHE_MAX];
-    uint8_t   texture_present[2][16384];
-    int       texture_last_removed;
+    uint16_t  texture_present[2][TEX_DIRTY_PAGES]; /*number of cached textures on each page*/
+    uint32_t  texture_pages[2][TEX_DIRTY_PAGES][TEX_CACHE_MAX / 32]; /*which ones*/
+    int       texture_hash[2][TEX_HASH_SIZE];
+    int       texture_lru_head[2];
+    int       texture_lru_tail[2];
+    uint64_t  texture_hits[2];
+    uint64_t  texture_misses[2];
+    uint64_t  texture_evictions[2];
 
     uint32_t palette_checksum[2];
     int      palette_dirty[2];
 
     uint64_t time;
-    int      render_time[4];
+    int      render_time[VOODOO_MAX_RENDER_THREADS]; /* Time spent rendering, per thread. */
 
     int      force_blit_count;
     int      can_blit;
@@ -662,7 +694,7 @@ typedef struct voodoo_t {
     struct voodoo_set_t *set;
 
     uint8_t fifo_thread_run;
-    uint8_t render_thread_run[4];
+    uint8_t render_thread_run[VOODOO_MAX_RENDER_THREADS];
 
     uint8_t *vram;
     uint8_t *changedvram;
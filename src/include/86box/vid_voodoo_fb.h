@@ -23,5 +23,6 @@ uint16_t voodoo_fb_readw(uint32_t addr, void *priv);
 uint32_t voodoo_fb_readl(uint32_t addr, void *priv);
 void     voodoo_fb_writew(uint32_t addr, uint16_t val, void *priv);
 void     voodoo_fb_writel(uint32_t addr, uint32_t val, void *priv);
+void     voodoo_fb_writel_run(voodoo_t *voodoo, uint32_t addr, const uint32_t *val, int count);
 
 #endif /*VIDEO_VOODOO_FB_H*/
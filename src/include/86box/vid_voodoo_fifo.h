@@ -27,5 +27,6 @@ void voodoo_flush(voodoo_t *voodoo);
 void voodoo_wake_fifo_threads(voodoo_set_t *set, voodoo_t *voodoo);
 void voodoo_wait_for_swap_complete(voodoo_t *voodoo);
 void voodoo_fifo_thread(void *param);
+void voodoo_fifo_log_stats(voodoo_t *voodoo);
 
 #endif /*VIDEO_VOODOO_FIFO_H*/
@@ -69,6 +69,18 @@ enum {
 #define VIDEO_FLAG_TYPE_NONE    5
 #define VIDEO_FLAG_TYPE_MASK    7
 
+/* What video_blit_memtoscreen_monitor() does while the previous blit is
+   still running. */
+#define BLIT_MODE_WAIT    0 /* Wait for it, every frame is shown. */
+#define BLIT_MODE_MAILBOX 1 /* Drop the new frame, the emulation never waits. */
+
+/* How the bus time of video memory accesses is charged to the CPU. */
+#define VIDEO_BUS_TIMING_AGGREGATE 0 /* Per page and frame, lets the CPU map frame buffer pages directly. */
+#define VIDEO_BUS_TIMING_EXACT     1 /* On every access, all of them go through the handlers. */
+
+#define SCREENSHOT_FORMAT_PNG 0
+#define SCREENSHOT_FORMAT_QOI 1
+
 typedef struct video_timings_t {
     int type;
     int write_b;
@@ -202,6 +214,7 @@ extern uint32_t    *video_8togs;
 extern uint32_t    *video_8to32;
 extern uint32_t    *video_15to32;
 extern uint32_t    *video_16to32;
+extern uint32_t     video_glyphmask[256][8];
 extern int          enable_overscan;
 extern int          force_43;
 extern int          vid_resize;
@@ -254,9 +267,15 @@ extern void video_blend_monitor(int x, int y, int monitor_index);
 extern void video_process_8_monitor(int x, int y, int monitor_index);
 extern void video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index);
 extern void video_blit_complete_monitor(int monitor_index);
+extern void video_blit_dirty_monitor(int y1, int y2, int monitor_index);
+extern void video_blit_get_dirty_monitor(int *y1, int *y2, int monitor_index);
 extern void video_wait_for_blit_monitor(int monitor_index);
 extern void video_wait_for_buffer_monitor(int monitor_index);
 
+typedef void (*video_line_func_t)(int monitor_index, int y, const void *data);
+
+extern int video_line_queue_monitor(int monitor_index, int y, video_line_func_t func, const void *data, int size);
+
 extern bitmap_t *create_bitmap(int w, int h);
 extern void      destroy_bitmap(bitmap_t *b);
 extern void      cgapal_rebuild_monitor(int monitor_index);
@@ -284,6 +303,28 @@ extern int get_actual_size_y(void);
 
 extern uint32_t video_color_transform(uint32_t color);
 
+/* Draws the 8 pixels of a font row, leftmost pixel from bit 7. */
+static __inline void
+video_glyph_row(uint32_t *p, uint8_t dat, uint32_t fg, uint32_t bg)
+{
+    const uint32_t *mask = video_glyphmask[dat];
+    const uint32_t  diff = fg ^ bg;
+
+    for (int c = 0; c < 8; c++)
+        p[c] = bg ^ (diff & mask[c]);
+}
+
+/* Same, every pixel twice as wide. */
+static __inline void
+video_glyph_row_wide(uint32_t *p, uint8_t dat, uint32_t fg, uint32_t bg)
+{
+    const uint32_t *mask = video_glyphmask[dat];
+    const uint32_t  diff = fg ^ bg;
+
+    for (int c = 0; c < 8; c++)
+        p[c << 1] = p[(c << 1) + 1] = bg ^ (diff & mask[c]);
+}
+
 #define video_inform(type, video_timings_ptr) video_inform_monitor(type, video_timings_ptr, monitor_index_global)
 #define video_get_type()                      video_get_type_monitor(0)
 #define video_blend(x, y)                     video_blend_monitor(x, y, monitor_index_global)
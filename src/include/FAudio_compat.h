@@ -15,6 +15,7 @@ typedef uint8_t BOOL;
 #define XAUDIO2_DEFAULT_PROCESSOR FAUDIO_DEFAULT_PROCESSOR
 #define XAUDIO2_COMMIT_NOW FAUDIO_COMMIT_NOW
 #define XAUDIO2_END_OF_STREAM FAUDIO_END_OF_STREAM
+#define XAUDIO2_VOICE_NOSAMPLESPLAYED FAUDIO_VOICE_NOSAMPLESPLAYED
 
 #define WAVE_FORMAT_PCM FAUDIO_FORMAT_PCM
 #define WAVE_FORMAT_IEEE_FLOAT FAUDIO_FORMAT_IEEE_FLOAT
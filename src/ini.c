@@ -38,17 +38,17 @@
 #include <86box/ini.h>
 #include <86box/plat.h>
 
+/* Sections and entries are kept in lists in file order, for writing the
+   file back out, and hashed by name for lookups. Lookups find the first
+   of several entries with the same name, as a walk of the list would. */
+#define INI_SECTION_HASH 64
+#define INI_ENTRY_HASH   64
+
 typedef struct _list_ {
     struct _list_ *next;
 } list_t;
 
-typedef struct section_t {
-    list_t list;
-
-    char name[128];
-
-    list_t entry_head;
-} section_t;
+struct ini_head_t;
 
 typedef struct entry_t {
     list_t list;
@@ -56,31 +56,161 @@ typedef struct entry_t {
     char    name[128];
     char    data[512];
     wchar_t wdata[512];
+
+    struct entry_t *hash_next;
 } entry_t;
 
-#define list_add(new, head)        \
-    {                              \
-        list_t *next = head;       \
-                                   \
-        while (next->next != NULL) \
-            next = next->next;     \
-                                   \
-        (next)->next = new;        \
-        (new)->next  = NULL;       \
-    }
+typedef struct section_t {
+    list_t list;
 
-#define list_delete(old, head)          \
-    {                                   \
-        list_t *next = head;            \
-                                        \
-        while ((next)->next != old) {   \
-            next = (next)->next;        \
-        }                               \
-                                        \
-        (next)->next = (old)->next;     \
-        if ((next) == (head))           \
-            (head)->next = (old)->next; \
-    }
+    char name[128];
+
+    list_t  entry_head;
+    list_t *entry_tail;
+    entry_t *entry_hash[INI_ENTRY_HASH];
+
+    struct ini_head_t *head;
+    struct section_t  *hash_next;
+
+    int saved; /* Was in the file last read or written. */
+} section_t;
+
+typedef struct ini_head_t {
+    list_t     list;
+    list_t    *tail;
+    section_t *hash[INI_SECTION_HASH];
+
+    int changed; /* Differs from the file last read or written. */
+} ini_head_t;
+
+static void
+list_add(list_t *item, list_t **tail)
+{
+    (*tail)->next = item;
+    item->next    = NULL;
+    *tail         = item;
+}
+
+static void
+list_delete(list_t *item, list_t *head, list_t **tail)
+{
+    list_t *prev = head;
+
+    while ((prev->next != NULL) && (prev->next != item))
+        prev = prev->next;
+
+    if (prev->next == NULL)
+        return;
+
+    prev->next = item->next;
+    if (*tail == item)
+        *tail = prev;
+}
+
+/* Names compare equal on their first 128 characters, so hash just those. */
+static uint32_t
+ini_hash(const char *name)
+{
+    uint32_t hash = 0x811c9dc5;
+
+    for (int i = 0; (i < 128) && name[i]; i++)
+        hash = (hash ^ (uint8_t) name[i]) * 0x01000193;
+
+    return hash;
+}
+
+static void
+section_hash_add(ini_head_t *head, section_t *sec)
+{
+    section_t **link = &head->hash[ini_hash(sec->name) & (INI_SECTION_HASH - 1)];
+
+    while (*link != NULL)
+        link = &(*link)->hash_next;
+
+    sec->hash_next = NULL;
+    *link          = sec;
+}
+
+static void
+section_hash_remove(ini_head_t *head, section_t *sec)
+{
+    section_t **link = &head->hash[ini_hash(sec->name) & (INI_SECTION_HASH - 1)];
+
+    while ((*link != NULL) && (*link != sec))
+        link = &(*link)->hash_next;
+
+    if (*link != NULL)
+        *link = sec->hash_next;
+}
+
+static void
+entry_hash_add(section_t *sec, entry_t *ent)
+{
+    entry_t **link = &sec->entry_hash[ini_hash(ent->name) & (INI_ENTRY_HASH - 1)];
+
+    while (*link != NULL)
+        link = &(*link)->hash_next;
+
+    ent->hash_next = NULL;
+    *link          = ent;
+}
+
+static void
+entry_hash_remove(section_t *sec, entry_t *ent)
+{
+    entry_t **link = &sec->entry_hash[ini_hash(ent->name) & (INI_ENTRY_HASH - 1)];
+
+    while ((*link != NULL) && (*link != ent))
+        link = &(*link)->hash_next;
+
+    if (*link != NULL)
+        *link = ent->hash_next;
+}
+
+static ini_head_t *
+head_new(void)
+{
+    ini_head_t *head = malloc(sizeof(ini_head_t));
+
+    memset(head, 0x00, sizeof(ini_head_t));
+    head->tail = &head->list;
+
+    return head;
+}
+
+/* Allocates a section and adds it at the end of the file. */
+static section_t *
+section_new(ini_head_t *head, const char *name)
+{
+    section_t *ns = malloc(sizeof(section_t));
+
+    memset(ns, 0x00, sizeof(section_t));
+    memcpy(ns->name, name, MIN(sizeof(ns->name), strlen(name) + 1));
+    ns->name[sizeof(ns->name) - 1] = '\0';
+    ns->entry_tail                 = &ns->entry_head;
+    ns->head                       = head;
+
+    list_add(&ns->list, &head->tail);
+    section_hash_add(head, ns);
+
+    return ns;
+}
+
+/* Allocates an entry and adds it at the end of the section. */
+static entry_t *
+entry_new(section_t *section, const char *name)
+{
+    entry_t *ne = malloc(sizeof(entry_t));
+
+    memset(ne, 0x00, sizeof(entry_t));
+    memcpy(ne->name, name, MIN(sizeof(ne->name), strlen(name) + 1));
+    ne->name[sizeof(ne->name) - 1] = '\0';
+
+    list_add(&ne->list, &section->entry_tail);
+    entry_hash_add(section, ne);
+
+    return ne;
+}
 
 #ifdef ENABLE_INI_LOG
 int ini_do_log = ENABLE_INI_LOG;
@@ -101,19 +231,20 @@ ini_log(const char *fmt, ...)
 #endif
 
 static section_t *
-find_section(list_t *head, const char *name)
+find_section(ini_head_t *head, const char *name)
 {
-    section_t *sec     = (section_t *) head->next;
+    section_t *sec;
     const char blank[] = "";
 
     if (name == NULL)
         name = blank;
 
+    sec = head->hash[ini_hash(name) & (INI_SECTION_HASH - 1)];
     while (sec != NULL) {
         if (!strncmp(sec->name, name, sizeof(sec->name)))
             return sec;
 
-        sec = (section_t *) sec->list.next;
+        sec = sec->hash_next;
     }
 
     return NULL;
@@ -125,7 +256,7 @@ ini_find_section(ini_t ini, const char *name)
     if (ini == NULL)
         return NULL;
 
-    return (ini_section_t) find_section((list_t *) ini, name);
+    return (ini_section_t) find_section((ini_head_t *) ini, name);
 }
 
 void
@@ -136,8 +267,12 @@ ini_rename_section(ini_section_t section, const char *name)
     if (sec == NULL)
         return;
 
+    section_hash_remove(sec->head, sec);
     memset(sec->name, 0x00, sizeof(sec->name));
     memcpy(sec->name, name, MIN(128, strlen(name) + 1));
+    section_hash_add(sec->head, sec);
+
+    sec->head->changed = 1;
 }
 
 static entry_t *
@@ -145,13 +280,13 @@ find_entry(section_t *section, const char *name)
 {
     entry_t *ent;
 
-    ent = (entry_t *) section->entry_head.next;
+    ent = section->entry_hash[ini_hash(name) & (INI_ENTRY_HASH - 1)];
 
     while (ent != NULL) {
         if (!strncmp(ent->name, name, sizeof(ent->name)))
             return ent;
 
-        ent = (entry_t *) ent->list.next;
+        ent = ent->hash_next;
     }
 
     return (NULL);
@@ -176,13 +311,30 @@ entries_num(section_t *section)
 }
 
 static void
-delete_section_if_empty(list_t *head, section_t *section)
+delete_section_if_empty(ini_head_t *head, section_t *section)
 {
+    entry_t *ent;
+
     if (section == NULL)
         return;
 
     if (entries_num(section) == 0) {
-        list_delete(&section->list, head);
+        /* Only nameless entries can be left, and nothing can find those. */
+        ent = (entry_t *) section->entry_head.next;
+        while (ent != NULL) {
+            entry_t *nent = (entry_t *) ent->list.next;
+
+            free(ent);
+            ent = nent;
+        }
+
+        /* Sections are created before they are filled in, dropping one
+           that never made it to the file changes nothing. */
+        if (section->saved)
+            head->changed = 1;
+
+        section_hash_remove(head, section);
+        list_delete(&section->list, &head->list, &head->tail);
         free(section);
     }
 }
@@ -193,19 +345,13 @@ ini_delete_section_if_empty(ini_t ini, ini_section_t section)
     if (ini == NULL || section == NULL)
         return;
 
-    delete_section_if_empty((list_t *) ini, (section_t *) section);
+    delete_section_if_empty((ini_head_t *) ini, (section_t *) section);
 }
 
 static section_t *
-create_section(list_t *head, const char *name)
+create_section(ini_head_t *head, const char *name)
 {
-    section_t *ns = malloc(sizeof(section_t));
-
-    memset(ns, 0x00, sizeof(section_t));
-    memcpy(ns->name, name, strlen(name) + 1);
-    list_add(&ns->list, head);
-
-    return ns;
+    return section_new(head, name);
 }
 
 ini_section_t
@@ -214,9 +360,9 @@ ini_find_or_create_section(ini_t ini, const char *name)
     if (ini == NULL)
         return NULL;
 
-    section_t *section = find_section((list_t *) ini, name);
+    section_t *section = find_section((ini_head_t *) ini, name);
     if (section == NULL)
-        section = create_section((list_t *) ini, name);
+        section = create_section((ini_head_t *) ini, name);
 
     return (ini_section_t) section;
 }
@@ -224,13 +370,9 @@ ini_find_or_create_section(ini_t ini, const char *name)
 static entry_t *
 create_entry(section_t *section, const char *name)
 {
-    entry_t *ne = malloc(sizeof(entry_t));
-
-    memset(ne, 0x00, sizeof(entry_t));
-    memcpy(ne->name, name, strlen(name) + 1);
-    list_add(&ne->list, &section->entry_head);
+    section->head->changed = 1;
 
-    return ne;
+    return entry_new(section, name);
 }
 
 void
@@ -324,7 +466,7 @@ ini_read(const char *fn)
     int        d;
     int        bom;
     FILE      *fp;
-    list_t    *head;
+    ini_head_t *head;
 
     bom = ini_detect_bom(fn);
 #if defined(ANSI_CFG) || !defined(_WIN32)
@@ -335,13 +477,11 @@ ini_read(const char *fn)
     if (fp == NULL)
         return NULL;
 
-    head = malloc(sizeof(list_t));
-    memset(head, 0x00, sizeof(list_t));
+    head = head_new();
 
-    sec = malloc(sizeof(section_t));
-    memset(sec, 0x00, sizeof(section_t));
+    sec        = section_new(head, "");
+    sec->saved = 1;
 
-    list_add(&sec->list, head);
     if (bom)
         fseek(fp, 3, SEEK_SET);
 
@@ -388,10 +528,8 @@ ini_read(const char *fn)
                 continue;
 
             /* Create a new section and insert it. */
-            ns = malloc(sizeof(section_t));
-            memset(ns, 0x00, sizeof(section_t));
-            memcpy(ns->name, sname, 128);
-            list_add(&ns->list, head);
+            ns        = section_new(head, sname);
+            ns->saved = 1;
 
             /* New section is now the current one. */
             sec = ns;
@@ -419,10 +557,8 @@ ini_read(const char *fn)
         /* This is where the value part starts. */
         d = c;
 
-        /* Allocate a new variable entry.. */
-        ne = malloc(sizeof(entry_t));
-        memset(ne, 0x00, sizeof(entry_t));
-        memcpy(ne->name, ename, 128);
+        /* Allocate a new variable entry and insert it.. */
+        ne = entry_new(sec, ename);
         wcsncpy(ne->wdata, &buff[d], sizeof_w(ne->wdata) - 1);
         ne->wdata[sizeof_w(ne->wdata) - 1] = L'\0';
 #ifdef _WIN32 /* Make sure the string is converted to UTF-8 rather than a legacy codepage */
@@ -431,9 +567,6 @@ ini_read(const char *fn)
         wcstombs(ne->data, ne->wdata, sizeof(ne->data));
 #endif
         ne->data[sizeof(ne->data) - 1] = '\0';
-
-        /* .. and insert it. */
-        list_add(&ne->list, &sec->entry_head);
     }
 
     (void) fclose(fp);
@@ -490,18 +623,71 @@ ini_write(ini_t ini, const char *fn)
             ent = (entry_t *) ent->list.next;
         }
 
-        sec = (section_t *) sec->list.next;
+        sec->saved = 1;
+        sec        = (section_t *) sec->list.next;
     }
 
     (void) fclose(fp);
+
+    ((ini_head_t *) ini)->changed = 0;
 }
 
 ini_t
 ini_new(void)
 {
-    ini_t ini = malloc(sizeof(list_t));
-    memset(ini, 0, sizeof(list_t));
-    return ini;
+    return (ini_t) head_new();
+}
+
+/* Has anything been set, deleted or renamed since the file was read or written? */
+int
+ini_has_changed(ini_t ini)
+{
+    if (ini == NULL)
+        return 0;
+
+    return ((ini_head_t *) ini)->changed;
+}
+
+/*
+ * Copy the configuration for writing out elsewhere, e.g. from another
+ * thread while this one goes on changing it. The original is treated as
+ * written from here on.
+ */
+ini_t
+ini_snapshot(ini_t ini)
+{
+    ini_head_t *head = (ini_head_t *) ini;
+    ini_head_t *copy;
+    section_t  *sec;
+    section_t  *ns;
+    entry_t    *ent;
+    entry_t    *ne;
+
+    if (head == NULL)
+        return NULL;
+
+    copy = head_new();
+
+    sec = (section_t *) head->list.next;
+    while (sec != NULL) {
+        ns = section_new(copy, sec->name);
+
+        ent = (entry_t *) sec->entry_head.next;
+        while (ent != NULL) {
+            ne = entry_new(ns, ent->name);
+            memcpy(ne->data, ent->data, sizeof(ne->data));
+            memcpy(ne->wdata, ent->wdata, sizeof(ne->wdata));
+
+            ent = (entry_t *) ent->list.next;
+        }
+
+        sec->saved = 1;
+        sec        = (section_t *) sec->list.next;
+    }
+
+    head->changed = 0;
+
+    return (ini_t) copy;
 }
 
 void
@@ -536,7 +722,9 @@ ini_section_delete_var(ini_section_t self, const char *name)
 
     entry = find_entry(section, name);
     if (entry != NULL) {
-        list_delete(&entry->list, &section->entry_head);
+        section->head->changed = 1;
+        entry_hash_remove(section, entry);
+        list_delete(&entry->list, &section->entry_head, &section->entry_tail);
         free(entry);
     }
 }
@@ -710,38 +898,47 @@ ini_section_get_wstring(ini_section_t self, const char *name, wchar_t *def)
     return (entry->wdata);
 }
 
+/* Sets a plain ASCII value, noting whether it actually changed. */
+static void
+set_entry(section_t *section, const char *name, const char *data)
+{
+    entry_t *ent;
+
+    ent = find_entry(section, name);
+    if (ent == NULL)
+        ent = create_entry(section, name);
+    else if (!strcmp(ent->data, data))
+        return;
+
+    section->head->changed = 1;
+    strcpy(ent->data, data);
+    mbstowcs(ent->wdata, ent->data, sizeof_w(ent->wdata));
+}
+
 void
 ini_section_set_int(ini_section_t self, const char *name, int val)
 {
     section_t *section = (section_t *) self;
-    entry_t   *ent;
+    char       data[32];
 
     if (section == NULL)
         return;
 
-    ent = find_entry(section, name);
-    if (ent == NULL)
-        ent = create_entry(section, name);
-
-    sprintf(ent->data, "%i", val);
-    mbstowcs(ent->wdata, ent->data, 512);
+    sprintf(data, "%i", val);
+    set_entry(section, name, data);
 }
 
 void
 ini_section_set_uint(ini_section_t self, const char *name, uint32_t val)
 {
     section_t *section = (section_t *) self;
-    entry_t   *ent;
+    char       data[32];
 
     if (section == NULL)
         return;
 
-    ent = find_entry(section, name);
-    if (ent == NULL)
-        ent = create_entry(section, name);
-
-    sprintf(ent->data, "%i", val);
-    mbstowcs(ent->wdata, ent->data, 512);
+    sprintf(data, "%i", val);
+    set_entry(section, name, data);
 }
 
 #if 0
@@ -749,17 +946,13 @@ void
 ini_section_set_float(ini_section_t self, const char *name, float val)
 {
     section_t *section = (section_t *) self;
-    entry_t   *ent;
+    char       data[32];
 
     if (section == NULL)
         return;
 
-    ent = find_entry(section, name);
-    if (ent == NULL)
-        ent = create_entry(section, name);
-
-    sprintf(ent->data, "%g", val);
-    mbstowcs(ent->wdata, ent->data, 512);
+    sprintf(data, "%g", val);
+    set_entry(section, name, data);
 }
 #endif
 
@@ -767,69 +960,53 @@ void
 ini_section_set_double(ini_section_t self, const char *name, double val)
 {
     section_t *section = (section_t *) self;
-    entry_t   *ent;
+    char       data[32];
 
     if (section == NULL)
         return;
 
-    ent = find_entry(section, name);
-    if (ent == NULL)
-        ent = create_entry(section, name);
-
-    sprintf(ent->data, "%lg", val);
-    mbstowcs(ent->wdata, ent->data, 512);
+    sprintf(data, "%lg", val);
+    set_entry(section, name, data);
 }
 
 void
 ini_section_set_hex16(ini_section_t self, const char *name, int val)
 {
     section_t *section = (section_t *) self;
-    entry_t   *ent;
+    char       data[32];
 
     if (section == NULL)
         return;
 
-    ent = find_entry(section, name);
-    if (ent == NULL)
-        ent = create_entry(section, name);
-
-    sprintf(ent->data, "%04X", val);
-    mbstowcs(ent->wdata, ent->data, sizeof_w(ent->wdata));
+    sprintf(data, "%04X", val);
+    set_entry(section, name, data);
 }
 
 void
 ini_section_set_hex20(ini_section_t self, const char *name, int val)
 {
     section_t *section = (section_t *) self;
-    entry_t   *ent;
+    char       data[32];
 
     if (section == NULL)
         return;
 
-    ent = find_entry(section, name);
-    if (ent == NULL)
-        ent = create_entry(section, name);
-
-    sprintf(ent->data, "%05X", val);
-    mbstowcs(ent->wdata, ent->data, sizeof_w(ent->wdata));
+    sprintf(data, "%05X", val);
+    set_entry(section, name, data);
 }
 
 void
 ini_section_set_mac(ini_section_t self, const char *name, int val)
 {
     section_t *section = (section_t *) self;
-    entry_t   *ent;
+    char       data[32];
 
     if (section == NULL)
         return;
 
-    ent = find_entry(section, name);
-    if (ent == NULL)
-        ent = create_entry(section, name);
-
-    sprintf(ent->data, "%02x:%02x:%02x",
+    sprintf(data, "%02x:%02x:%02x",
             (val >> 16) & 0xff, (val >> 8) & 0xff, val & 0xff);
-    mbstowcs(ent->wdata, ent->data, 512);
+    set_entry(section, name, data);
 }
 
 void
@@ -844,7 +1021,10 @@ ini_section_set_string(ini_section_t self, const char *name, const char *val)
     ent = find_entry(section, name);
     if (ent == NULL)
         ent = create_entry(section, name);
+    else if (!strncmp(ent->data, val, sizeof(ent->data)))
+        return;
 
+    section->head->changed = 1;
     if ((strlen(val) + 1) <= sizeof(ent->data))
         memcpy(ent->data, val, strlen(val) + 1);
     else
@@ -868,7 +1048,10 @@ ini_section_set_wstring(ini_section_t self, const char *name, wchar_t *val)
     ent = find_entry(section, name);
     if (ent == NULL)
         ent = create_entry(section, name);
+    else if (!wcsncmp(ent->wdata, val, sizeof_w(ent->wdata)))
+        return;
 
+    section->head->changed = 1;
     memcpy(ent->wdata, val, sizeof_w(ent->wdata));
 #ifdef _WIN32 /* Make sure the string is converted to UTF-8 rather than a legacy codepage */
     c16stombs(ent->data, ent->wdata, sizeof(ent->data));
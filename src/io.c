@@ -25,12 +25,18 @@
 #include <wchar.h>
 #define HAVE_STDARG_H
 #include <86box/86box.h>
+#include <86box/device_profile.h>
 #include <86box/io.h>
+#include <86box/metrics.h>
 #include <86box/timer.h>
 #include "cpu.h"
 #include <86box/m_amstrad.h>
 #include <86box/pci.h>
 
+/* Charge a handler call to its device, or to the handler itself without one. */
+#define io_profile_call(p, fn, call) \
+    device_profile_call(DEVICE_PROFILE_IO, (p)->priv ? (p)->priv : (void *) (p)->fn, call)
+
 #define NPORTS 65536 /* PC/AT supports 64K ports */
 
 typedef struct _io_ {
@@ -55,9 +61,32 @@ typedef struct {
     void     *priv;
 } io_trap_t;
 
-int   initialized = 0;
-io_t *io[NPORTS];
-io_t *io_last[NPORTS];
+/* Bulk data port handlers, used by REP INS/OUTS to move a run of units in one
+   call. They only stand in for a port whose chain is just the one handler. */
+#define IO_BLOCK_MAX 16
+
+typedef struct {
+    uint16_t port;
+    int    (*read)(uint16_t addr, void *buf, int count, int size, void *priv);
+    int    (*write)(uint16_t addr, const void *buf, int count, int size, void *priv);
+    void    *priv;
+} io_block_t;
+
+/* Per-port summary of which handlers only implement narrower accesses, so
+   that word and dword accesses only walk the chains they have to split into. */
+#define IO_SPLIT_INB   0x01 /* inb without inw */
+#define IO_SPLIT_INW   0x02 /* inw without inl */
+#define IO_SPLIT_INBL  0x04 /* inb without inw or inl */
+#define IO_SPLIT_OUTB  0x10
+#define IO_SPLIT_OUTW  0x20
+#define IO_SPLIT_OUTBL 0x40
+
+int            initialized = 0;
+io_t          *io[NPORTS];
+io_t          *io_last[NPORTS];
+static uint8_t io_split[NPORTS];
+static io_block_t io_block[IO_BLOCK_MAX];
+static int        io_block_num = 0;
 
 #ifdef ENABLE_IO_LOG
 int io_do_log = ENABLE_IO_LOG;
@@ -105,7 +134,33 @@ io_init(void)
 
         /* io[c] should be NULL. */
         io[c] = io_last[c] = NULL;
+        io_split[c]        = 0;
     }
+
+    io_block_num = 0;
+}
+
+static void
+io_update_split(uint16_t port)
+{
+    uint8_t split = 0;
+
+    for (io_t *p = io[port]; p; p = p->next) {
+        if (p->inb && !p->inw)
+            split |= IO_SPLIT_INB;
+        if (p->inw && !p->inl)
+            split |= IO_SPLIT_INW;
+        if (p->inb && !p->inw && !p->inl)
+            split |= IO_SPLIT_INBL;
+        if (p->outb && !p->outw)
+            split |= IO_SPLIT_OUTB;
+        if (p->outw && !p->outl)
+            split |= IO_SPLIT_OUTW;
+        if (p->outb && !p->outw && !p->outl)
+            split |= IO_SPLIT_OUTBL;
+    }
+
+    io_split[port] = split;
 }
 
 void
@@ -145,6 +200,7 @@ io_sethandler_common(uint16_t base, int size,
         q->next = NULL;
 
         io_last[base + c] = q;
+        io_update_split(base + c);
     }
 }
 
@@ -182,6 +238,7 @@ io_removehandler_common(uint16_t base, int size,
             }
             p = q;
         }
+        io_update_split(base + c);
     }
 }
 
@@ -279,21 +336,99 @@ io_handler_interleaved(int set, uint16_t base, int size,
     io_handler_common(set, base, size, inb, inw, inl, outb, outw, outl, priv, 2);
 }
 
+void
+io_block_handler(int set, uint16_t port,
+                 int (*read)(uint16_t addr, void *buf, int count, int size, void *priv),
+                 int (*write)(uint16_t addr, const void *buf, int count, int size, void *priv),
+                 void *priv)
+{
+    for (int i = 0; i < io_block_num; i++) {
+        if ((io_block[i].port == port) && (io_block[i].priv == priv)) {
+            if (!set)
+                io_block[i] = io_block[--io_block_num];
+            return;
+        }
+    }
+
+    if (set && (io_block_num < IO_BLOCK_MAX)) {
+        io_block[io_block_num].port  = port;
+        io_block[io_block_num].read  = read;
+        io_block[io_block_num].write = write;
+        io_block[io_block_num].priv  = priv;
+        io_block_num++;
+    }
+}
+
+/* Returns the block handler that can stand in for size-byte accesses to port,
+   or NULL if the access has to go through the normal dispatch. */
+static const io_block_t *
+io_block_find(uint16_t port, int size, uint8_t split_mask)
+{
+    const io_t *p = io[port];
+
+    if ((p == NULL) || (p->next != NULL) || (amstrad_latch & 0x80000000))
+        return NULL;
+
+    if ((pci_flags & FLAG_CONFIG_IO_ON) && (port >= pci_base) && (port < (pci_base + pci_size)))
+        return NULL;
+    if ((pci_flags & FLAG_CONFIG_DEV0_IO_ON) && (port >= 0xc000) && (port < 0xc100))
+        return NULL;
+
+#ifdef USE_DEBUG_REGS_486
+    if ((dr[7] & 0xFF) && (cr4 & 0x8))
+        return NULL;
+#endif
+
+    for (int i = 0; i < size; i++) {
+        if (io_split[(port + i) & 0xffff] & split_mask)
+            return NULL;
+    }
+
+    for (int i = 0; i < io_block_num; i++) {
+        if ((io_block[i].port == port) && (io_block[i].priv == p->priv))
+            return &io_block[i];
+    }
+
+    return NULL;
+}
+
+/* Word accesses only split where there is no inw, dword ones where there is no
+   inl, so a 16-bit only port can still take REP INSW in blocks. */
+int
+io_read_block(uint16_t port, void *buf, int count, int size)
+{
+    const io_block_t *b = io_block_find(port, size, (size == 4) ? (IO_SPLIT_INW | IO_SPLIT_INBL) : IO_SPLIT_INB);
+
+    if ((b == NULL) || (b->read == NULL))
+        return 0;
+
+    device_profile_call(DEVICE_PROFILE_IO, b->priv, count = b->read(port, buf, count, size, b->priv));
+    metrics.io_accesses += count;
+    return count;
+}
+
+int
+io_write_block(uint16_t port, const void *buf, int count, int size)
+{
+    const io_block_t *b = io_block_find(port, size, (size == 4) ? (IO_SPLIT_OUTW | IO_SPLIT_OUTBL) : IO_SPLIT_OUTB);
+
+    if ((b == NULL) || (b->write == NULL))
+        return 0;
+
+    device_profile_call(DEVICE_PROFILE_IO, b->priv, count = b->write(port, buf, count, size, b->priv));
+    metrics.io_accesses += count;
+    return count;
+}
+
 #ifdef USE_DEBUG_REGS_486
 extern int trap;
 /* Set trap for I/O address breakpoints. */
-void
-io_debug_check_addr(uint16_t addr)
+static void
+io_debug_check_bp(uint16_t addr)
 {
     int i = 0;
     int set_trap = 0;
 
-    if (!(dr[7] & 0xFF))
-        return;
-    
-    if (!(cr4 & 0x8))
-        return; /* No I/O debug trap. */
-
     for (i = 0; i < 4; i++) {
         uint16_t dr_addr = dr[i] & 0xFFFF;
         int breakpoint_enabled = !!(dr[7] & (0x3 << (2 * i)));
@@ -329,6 +464,15 @@ io_debug_check_addr(uint16_t addr)
     if (set_trap)
         trap |= 4;
 }
+
+/* Kept inline so that port accesses only pay for a DR7 test when no
+   breakpoints are enabled. */
+static __inline void
+io_debug_check_addr(uint16_t addr)
+{
+    if ((dr[7] & 0xFF) && (cr4 & 0x8))
+        io_debug_check_bp(addr);
+}
 #endif
 
 uint8_t
@@ -342,6 +486,8 @@ inb(uint16_t port)
     int     qfound = 0;
 #endif
 
+    metrics.io_accesses++;
+
 #ifdef USE_DEBUG_REGS_486
     io_debug_check_addr(port);
 #endif
@@ -363,7 +509,7 @@ inb(uint16_t port)
         while (p) {
             q = p->next;
             if (p->inb) {
-                ret &= p->inb(port, p->priv);
+                io_profile_call(p, inb, ret &= p->inb(port, p->priv));
                 found |= 1;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -406,6 +552,8 @@ outb(uint16_t port, uint8_t val)
     int   qfound = 0;
 #endif
 
+    metrics.io_accesses++;
+
 #ifdef USE_DEBUG_REGS_486
     io_debug_check_addr(port);
 #endif
@@ -427,7 +575,7 @@ outb(uint16_t port, uint8_t val)
         while (p) {
             q = p->next;
             if (p->outb) {
-                p->outb(port, val, p->priv);
+                io_profile_call(p, outb, p->outb(port, val, p->priv));
                 found |= 1;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -462,6 +610,8 @@ inw(uint16_t port)
 #endif
     uint8_t  ret8[2];
 
+    metrics.io_accesses++;
+
 #ifdef USE_DEBUG_REGS_486
     io_debug_check_addr(port);
 #endif
@@ -483,7 +633,7 @@ inw(uint16_t port)
         while (p) {
             q = p->next;
             if (p->inw) {
-                ret &= p->inw(port, p->priv);
+                io_profile_call(p, inw, ret &= p->inw(port, p->priv));
                 found |= 2;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -495,11 +645,13 @@ inw(uint16_t port)
         ret8[0] = ret & 0xff;
         ret8[1] = (ret >> 8) & 0xff;
         for (uint8_t i = 0; i < 2; i++) {
+            if (!(io_split[(port + i) & 0xffff] & IO_SPLIT_INB))
+                continue;
             p = io[(port + i) & 0xffff];
             while (p) {
                 q = p->next;
                 if (p->inb && !p->inw) {
-                    ret8[i] &= p->inb(port + i, p->priv);
+                    io_profile_call(p, inb, ret8[i] &= p->inb(port + i, p->priv));
                     found |= 1;
 #ifdef ENABLE_IO_LOG
                     qfound++;
@@ -538,6 +690,8 @@ outw(uint16_t port, uint16_t val)
     int   qfound = 0;
 #endif
 
+    metrics.io_accesses++;
+
 #ifdef USE_DEBUG_REGS_486
     io_debug_check_addr(port);
 #endif
@@ -559,7 +713,7 @@ outw(uint16_t port, uint16_t val)
         while (p) {
             q = p->next;
             if (p->outw) {
-                p->outw(port, val, p->priv);
+                io_profile_call(p, outw, p->outw(port, val, p->priv));
                 found |= 2;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -569,11 +723,13 @@ outw(uint16_t port, uint16_t val)
         }
 
         for (uint8_t i = 0; i < 2; i++) {
+            if (!(io_split[(port + i) & 0xffff] & IO_SPLIT_OUTB))
+                continue;
             p = io[(port + i) & 0xffff];
             while (p) {
                 q = p->next;
                 if (p->outb && !p->outw) {
-                    p->outb(port + i, val >> (i << 3), p->priv);
+                    io_profile_call(p, outb, p->outb(port + i, val >> (i << 3), p->priv));
                     found |= 1;
 #ifdef ENABLE_IO_LOG
                     qfound++;
@@ -610,6 +766,8 @@ inl(uint16_t port)
     int      qfound = 0;
 #endif
 
+    metrics.io_accesses++;
+
 #ifdef USE_DEBUG_REGS_486
     io_debug_check_addr(port);
 #endif
@@ -631,7 +789,7 @@ inl(uint16_t port)
         while (p) {
             q = p->next;
             if (p->inl) {
-                ret &= p->inl(port, p->priv);
+                io_profile_call(p, inl, ret &= p->inl(port, p->priv));
                 found |= 4;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -642,11 +800,11 @@ inl(uint16_t port)
 
         ret16[0] = ret & 0xffff;
         ret16[1] = (ret >> 16) & 0xffff;
-        p        = io[port & 0xffff];
+        p        = (io_split[port] & IO_SPLIT_INW) ? io[port] : NULL;
         while (p) {
             q = p->next;
             if (p->inw && !p->inl) {
-                ret16[0] &= p->inw(port, p->priv);
+                io_profile_call(p, inw, ret16[0] &= p->inw(port, p->priv));
                 found |= 2;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -655,11 +813,11 @@ inl(uint16_t port)
             p = q;
         }
 
-        p = io[(port + 2) & 0xffff];
+        p = (io_split[(port + 2) & 0xffff] & IO_SPLIT_INW) ? io[(port + 2) & 0xffff] : NULL;
         while (p) {
             q = p->next;
             if (p->inw && !p->inl) {
-                ret16[1] &= p->inw(port + 2, p->priv);
+                io_profile_call(p, inw, ret16[1] &= p->inw(port + 2, p->priv));
                 found |= 2;
 #ifdef ENABLE_IO_LOG
                 qfound++;
@@ -674,11 +832,13 @@ inl(uint16_t port)
         ret8[2] = (ret >> 16) & 0xff;
         ret8[3] = (ret >> 24) & 0xff;
         for (uint8_t i = 0; i < 4; i++) {
+            if (!(io_split[(port + i) & 0xffff] & IO_SPLIT_INBL))
+                continue;
             p = io[(port + i) & 0xffff];
             while (p) {
                 q = p->next;
                 if (p->inb && !p->inw && !p->inl) {
-                    ret8[i] &= p->inb(port + i, p->priv);
+                    io_profile_call(p, inb, ret8[i] &= p->inb(port + i, p->priv));
                     found |= 1;
 #ifdef ENABLE_IO_LOG
                     qfound++;
@@ -718,6 +878,8 @@ outl(uint16_t port, uint32_t val)
 #endif
     int   i      = 0;
 
+    metrics.io_accesses++;
+
 #ifdef USE_DEBUG_REGS_486
     io_debug_check_addr(port);
 #endif
@@ -740,7 +902,7 @@ outl(uint16_t port, uint32_t val)
             while (p) {
                 q = p->next;
                 if (p->outl) {
-                    p->outl(port, val, p->priv);
+                    io_profile_call(p, outl, p->outl(port, val, p->priv));
                     found |= 4;
 #ifdef ENABLE_IO_LOG
                     qfound++;
@@ -751,11 +913,13 @@ outl(uint16_t port, uint32_t val)
         }
 
         for (i = 0; i < 4; i += 2) {
+            if (!(io_split[(port + i) & 0xffff] & IO_SPLIT_OUTW))
+                continue;
             p = io[(port + i) & 0xffff];
             while (p) {
                 q = p->next;
                 if (p->outw && !p->outl) {
-                    p->outw(port + i, val >> (i << 3), p->priv);
+                    io_profile_call(p, outw, p->outw(port + i, val >> (i << 3), p->priv));
                     found |= 2;
 #ifdef ENABLE_IO_LOG
                     qfound++;
@@ -766,11 +930,13 @@ outl(uint16_t port, uint32_t val)
         }
 
         for (i = 0; i < 4; i++) {
+            if (!(io_split[(port + i) & 0xffff] & IO_SPLIT_OUTBL))
+                continue;
             p = io[(port + i) & 0xffff];
             while (p) {
                 q = p->next;
                 if (p->outb && !p->outw && !p->outl) {
-                    p->outb(port + i, val >> (i << 3), p->priv);
+                    io_profile_call(p, outb, p->outb(port + i, val >> (i << 3), p->priv));
                     found |= 1;
 #ifdef ENABLE_IO_LOG
                     qfound++;
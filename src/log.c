@@ -35,11 +35,18 @@
 #include <86box/log.h>
 
 #ifndef RELEASE_BUILD
+/* Lines per second a single log may write, the rest are counted and dropped. */
+#    define LOG_RATE_LIMIT 1000
+
 typedef struct log_t {
     char  buff[1024];
     char *dev_name;
     int   seen;
     int   suppr_seen;
+
+    uint32_t rate_start;
+    int      rate_lines;
+    int      rate_dropped;
 } log_t;
 
 extern FILE *stdlog; /* file to log output to */
@@ -81,9 +88,10 @@ log_copy(log_t *log, char *dest, const char *src, size_t dest_size)
 void
 log_out(void *priv, const char *fmt, va_list ap)
 {
-    log_t *log = (log_t *) priv;
-    char   temp[1024];
-    char   fmt2[1024];
+    log_t   *log = (log_t *) priv;
+    char     temp[1024];
+    char     fmt2[1024];
+    uint32_t now;
 
     if (log == NULL)
         return;
@@ -91,6 +99,22 @@ log_out(void *priv, const char *fmt, va_list ap)
     if (strcmp(fmt, "") == 0)
         return;
 
+    /* Checked before formatting, a flooding log should cost next to nothing. */
+    now = plat_get_ticks();
+    if ((now - log->rate_start) >= 1000) {
+        if (log->rate_dropped && (stdlog != NULL)) {
+            log_copy(log, fmt2, "*** %d lines dropped ***\n", 1024);
+            fprintf(stdlog, fmt2, log->rate_dropped);
+        }
+        log->rate_start   = now;
+        log->rate_lines   = 0;
+        log->rate_dropped = 0;
+    }
+    if (++log->rate_lines > LOG_RATE_LIMIT) {
+        log->rate_dropped++;
+        return;
+    }
+
     if (stdlog == NULL) {
         if (log_path[0] != '\0') {
             stdlog = plat_fopen(log_path, "w");
@@ -111,10 +135,10 @@ log_out(void *priv, const char *fmt, va_list ap)
         log->seen = 0;
         strcpy(log->buff, temp);
         log_copy(log, fmt2, temp, 1024);
-        fprintf(stdlog, fmt2, ap);
+        fputs(fmt2, stdlog);
     }
 
-    fflush(stdlog);
+    pclog_defer_flush();
 }
 
 void
@@ -15803,18 +15803,20 @@ machine_get_type(int m)
     return (machines[m].type);
 }
 
+static const char *
+machine_get_name(int c)
+{
+    return (machines[c].init != NULL) ? machines[c].internal_name : NULL;
+}
+
+static device_name_index_t machine_names = { .get_name = machine_get_name };
+
 int
 machine_get_machine_from_internal_name(const char *s)
 {
-    int c = 0;
-
-    while (machines[c].init != NULL) {
-        if (!strcmp(machines[c].internal_name, s))
-            return c;
-        c++;
-    }
+    int c = device_name_index_find(&machine_names, s);
 
-    return 0;
+    return (c >= 0) ? c : 0;
 }
 
 int
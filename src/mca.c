@@ -5,53 +5,54 @@
 #include <86box/io.h>
 #include <86box/mca.h>
 
-void (*mca_card_write[8])(int addr, uint8_t val, void *priv);
-uint8_t (*mca_card_read[8])(int addr, void *priv);
-uint8_t (*mca_card_feedb[8])(void *priv);
-void (*mca_card_reset[8])(void *priv);
-void *mca_priv[8];
+#define MCA_SLOTS 8
 
-static int mca_index;
-static int mca_nr_cards;
+typedef struct mca_card_t {
+    uint8_t (*read)(int addr, void *priv);
+    void (*write)(int addr, uint8_t val, void *priv);
+    uint8_t (*feedb)(void *priv);
+    void (*reset)(void *priv);
+    void *priv;
+} mca_card_t;
+
+/* Indexed by slot, a POS access is a single lookup of the selected card. */
+static mca_card_t  mca_cards[MCA_SLOTS];
+static mca_card_t *mca_card;
+static int         mca_index;
+static int         mca_nr_cards;
 
 void
 mca_init(int nr_cards)
 {
-    for (uint8_t c = 0; c < 8; c++) {
-        mca_card_read[c]  = NULL;
-        mca_card_write[c] = NULL;
-        mca_card_reset[c] = NULL;
-        mca_priv[c]       = NULL;
-    }
+    memset(mca_cards, 0x00, sizeof(mca_cards));
 
-    mca_index    = 0;
-    mca_nr_cards = nr_cards;
+    mca_nr_cards = (nr_cards > MCA_SLOTS) ? MCA_SLOTS : nr_cards;
+    mca_set_index(0);
 }
 
 void
 mca_set_index(int index)
 {
     mca_index = index;
+    mca_card  = ((index >= 0) && (index < mca_nr_cards)) ? &mca_cards[index] : NULL;
 }
 
 uint8_t
 mca_read(uint16_t port)
 {
-    if (mca_index >= mca_nr_cards)
-        return 0xff;
-    if (!mca_card_read[mca_index])
+    if (!mca_card || !mca_card->read)
         return 0xff;
-    return mca_card_read[mca_index](port, mca_priv[mca_index]);
+    return mca_card->read(port, mca_card->priv);
 }
 
 uint8_t
 mca_read_index(uint16_t port, int index)
 {
-    if (mca_index >= mca_nr_cards)
+    if ((index < 0) || (index >= mca_nr_cards))
         return 0xff;
-    if (!mca_card_read[index])
+    if (!mca_cards[index].read)
         return 0xff;
-    return mca_card_read[index](port, mca_priv[index]);
+    return mca_cards[index].read(port, mca_cards[index].priv);
 }
 
 int
@@ -63,17 +64,15 @@ mca_get_nr_cards(void)
 void
 mca_write(uint16_t port, uint8_t val)
 {
-    if (mca_index >= mca_nr_cards)
-        return;
-    if (mca_card_write[mca_index])
-        mca_card_write[mca_index](port, val, mca_priv[mca_index]);
+    if (mca_card && mca_card->write)
+        mca_card->write(port, val, mca_card->priv);
 }
 
 uint8_t
 mca_feedb(void)
 {
-    if (mca_card_feedb[mca_index])
-        return !!(mca_card_feedb[mca_index](mca_priv[mca_index]));
+    if (mca_card && mca_card->feedb)
+        return !!(mca_card->feedb(mca_card->priv));
     else
         return 0;
 }
@@ -81,9 +80,9 @@ mca_feedb(void)
 void
 mca_reset(void)
 {
-    for (uint8_t c = 0; c < 8; c++) {
-        if (mca_card_reset[c])
-            mca_card_reset[c](mca_priv[c]);
+    for (uint8_t c = 0; c < MCA_SLOTS; c++) {
+        if (mca_cards[c].reset)
+            mca_cards[c].reset(mca_cards[c].priv);
     }
 }
 
@@ -91,12 +90,12 @@ void
 mca_add(uint8_t (*read)(int addr, void *priv), void (*write)(int addr, uint8_t val, void *priv), uint8_t (*feedb)(void *priv), void (*reset)(void *priv), void *priv)
 {
     for (int c = 0; c < mca_nr_cards; c++) {
-        if (!mca_card_read[c] && !mca_card_write[c]) {
-            mca_card_read[c]  = read;
-            mca_card_write[c] = write;
-            mca_card_feedb[c] = feedb;
-            mca_card_reset[c] = reset;
-            mca_priv[c]       = priv;
+        if (!mca_cards[c].read && !mca_cards[c].write) {
+            mca_cards[c].read  = read;
+            mca_cards[c].write = write;
+            mca_cards[c].feedb = feedb;
+            mca_cards[c].reset = reset;
+            mca_cards[c].priv  = priv;
             return;
         }
     }
@@ -82,6 +82,25 @@ i2c_eeprom_read(UNUSED(void *bus), UNUSED(uint8_t addr), void *priv)
     return ret;
 }
 
+static void
+i2c_eeprom_read_block(UNUSED(void *bus), UNUSED(uint8_t addr), uint8_t *data, int len, void *priv)
+{
+    i2c_eeprom_t *dev = (i2c_eeprom_t *) priv;
+    uint32_t      chunk;
+
+    i2c_eeprom_log("I2C EEPROM %s %02X: read_block(%06X, %d)\n", i2c_getbusname(dev->i2c), dev->addr, dev->addr_register, len);
+
+    while (len > 0) {
+        chunk = dev->addr_mask + 1 - dev->addr_register;
+        if (chunk > (uint32_t) len)
+            chunk = len;
+        memcpy(data, &dev->data[dev->addr_register], chunk);
+        dev->addr_register = (dev->addr_register + chunk) & dev->addr_mask; /* roll-over */
+        data += chunk;
+        len -= chunk;
+    }
+}
+
 static uint8_t
 i2c_eeprom_write(UNUSED(void *bus), uint8_t addr, uint8_t data, void *priv)
 {
@@ -150,6 +169,7 @@ i2c_eeprom_init(void *i2c, uint8_t addr, uint8_t *data, uint32_t size, uint8_t w
 
     uint8_t i2c_mask = dev->addr_mask >> dev->addr_len;
     i2c_sethandler(dev->i2c, dev->addr & ~i2c_mask, i2c_mask + 1, i2c_eeprom_start, i2c_eeprom_read, i2c_eeprom_write, i2c_eeprom_stop, dev);
+    i2c_set_read_block(dev->i2c, dev->addr & ~i2c_mask, i2c_mask + 1, i2c_eeprom_read_block, dev);
 
     return dev;
 }
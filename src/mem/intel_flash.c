@@ -88,9 +88,12 @@ flash_read(uint32_t addr, void *priv)
         addr ^= 0x10000;
     addr &= biosmask;
 
+    /* By far the most common case, BIOS data and shadowing copies. */
+    if (dev->command == CMD_READ_ARRAY)
+        return dev->array[addr];
+
     switch (dev->command) {
         default:
-        case CMD_READ_ARRAY:
             ret = dev->array[addr];
             break;
 
@@ -318,6 +321,10 @@ intel_flash_add_mappings(flash_t *dev)
 
         memcpy(&dev->array[fbase], &rom[base & biosmask], 0x10000);
 
+        /* Code is fetched straight from the array through the exec pointer,
+           in every mode: instruction fetches have no callback path, so
+           unmapping it while a command is in progress would make them
+           read 0xff instead of the status or ID. */
         if ((max == 2) || (i >= 2)) {
             mem_mapping_add(&(dev->mapping[i]), base, 0x10000,
                             flash_read, flash_readw, flash_readl,
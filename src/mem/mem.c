@@ -38,6 +38,8 @@
 #include <86box/plat.h>
 #include <86box/rom.h>
 #include <86box/gdbstub.h>
+#include <86box/snapshot.h>
+#include <86box/metrics.h>
 #ifdef USE_DYNAREC
 #    include "codegen_public.h"
 #else
@@ -83,6 +85,9 @@ uint32_t biosaddr;
 uint32_t pccache;
 uint8_t *pccache2;
 
+uint32_t pccache_2386 = 0xffffffff;
+uint8_t *pccache2_2386;
+
 int        readlnext;
 int        readlookup[256];
 uintptr_t *readlookup2;
@@ -94,6 +99,16 @@ uintptr_t *writelookup2;
 
 uint32_t mem_logical_addr;
 
+/* Remap statistics, for finding chipsets that spend BIOS POST time toggling
+   shadow RAM and SMRAM. Time is in plat_timer_read() ticks. */
+uint64_t mem_remap_count;
+uint64_t mem_remap_granules;
+uint64_t mem_remap_time;
+
+/* Bumped on every change to the mapping tables, so that devices caching host
+   pointers into guest memory know when to look them up again. */
+uint32_t mem_mapping_gen;
+
 int shadowbios = 0;
 int shadowbios_write;
 int readlnum  = 0;
@@ -134,6 +149,8 @@ static mem_mapping_t *last_mapping;
 static mem_mapping_t *read_mapping_bus[MEM_MAPPINGS_NO];
 static mem_mapping_t *write_mapping_bus[MEM_MAPPINGS_NO];
 static uint8_t       _mem_wp[MEM_MAPPINGS_NO];
+static uint8_t       readlookupg[256]; /* lookup came from a global page */
+static uint8_t       writelookupg[256];
 static uint8_t       _mem_wp_bus[MEM_MAPPINGS_NO];
 static uint8_t        ff_pccache[4] = { 0xff, 0xff, 0xff, 0xff };
 static mem_state_t    _mem_state[MEM_MAPPINGS_NO];
@@ -173,6 +190,58 @@ mem_addr_is_ram(uint32_t addr)
            (mapping == &ram_mid_mapping2) || (mapping == &ram_remapped_mapping);
 }
 
+/*
+ * Page directory entries (and PAE page directory pointers) read by recent
+ * page walks. As on the paging structure caches of later processors, only
+ * present entries pointing to a page table are kept, once their accessed
+ * bit is set, and they are dropped on every TLB flush and whenever CR3 or
+ * the paging mode changes; a TLB miss next to a recent one then only has
+ * to read the page table entry. All entries are dropped at once by bumping
+ * the generation.
+ */
+typedef struct mmu_pde_t {
+    uint32_t gen;
+    uint64_t val;
+} mmu_pde_t;
+
+static mmu_pde_t mmu_pde_cache[2048];
+static mmu_pde_t mmu_pdpte_cache[4];
+static uint32_t  mmu_pde_gen = 1;
+static uint32_t  mmu_pde_key;
+
+/* Virtual page of the last page walk when it ended on a global page. */
+static uint32_t mmu_global_page = 0xffffffff;
+
+static void
+mmu_walk_cache_flush(void)
+{
+    if (++mmu_pde_gen == 0) {
+        memset(mmu_pde_cache, 0x00, sizeof(mmu_pde_cache));
+        memset(mmu_pdpte_cache, 0x00, sizeof(mmu_pdpte_cache));
+        mmu_pde_gen = 1;
+    }
+    mmu_global_page = 0xffffffff;
+}
+
+static __inline void
+mmu_walk_cache_check(void)
+{
+    /* SMM entry and exit reload CR3 and CR4 without a flush, and a PSE
+       change does not flush either. */
+    uint32_t key = (cr3 & ~0x1f) | ((cr4 & CR4_PAE) ? 1 : 0) | ((cr4 & CR4_PSE) ? 2 : 0);
+
+    if (key != mmu_pde_key) {
+        mmu_pde_key = key;
+        mmu_walk_cache_flush();
+    }
+}
+
+static __inline uint8_t
+mmu_lookup_global(uint32_t virt)
+{
+    return (cr0 >> 31) && (mmu_global_page == (virt >> 12));
+}
+
 void
 resetreadlookup(void)
 {
@@ -192,10 +261,13 @@ resetreadlookup(void)
     memset(writelookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
     memset(writelookupp, 0x04, (1 << 20) * sizeof(uint8_t));
 
-    readlnext  = 0;
-    writelnext = 0;
-    pccache    = 0xffffffff;
-    high_page  = 0;
+    readlnext    = 0;
+    writelnext   = 0;
+    pccache      = 0xffffffff;
+    pccache_2386 = 0xffffffff;
+    high_page    = 0;
+
+    mmu_walk_cache_flush();
 }
 
 void
@@ -216,10 +288,56 @@ flushmmucache(void)
         }
     }
     mmuflush++;
+    metrics.mmu_flushes++;
+    mmu_walk_cache_flush();
+
+    pccache  = (uint32_t) 0xffffffff;
+    pccache2 = (uint8_t *) 0xffffffff;
+
+    pccache_2386 = 0xffffffff;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
+}
+
+/*
+ * Flush on a CR3 load. With CR4.PGE set, the lookups that came from global
+ * pages, normally the kernel's half of the address space, are kept, as the
+ * processor keeps their TLB entries; so on a context switch only the user
+ * half has to be walked again. Everything else is as flushmmucache().
+ */
+void
+flushmmucache_cr3(void)
+{
+    if (!(cr4 & CR4_PGE)) {
+        flushmmucache();
+        return;
+    }
+
+    for (uint16_t c = 0; c < 256; c++) {
+        if ((readlookup[c] != (int) 0xffffffff) && !readlookupg[c]) {
+            readlookup2[readlookup[c]] = LOOKUP_INV;
+            readlookupp[readlookup[c]] = 4;
+            readlookup[c]              = 0xffffffff;
+        }
+        if ((writelookup[c] != (int) 0xffffffff) && !writelookupg[c]) {
+            page_lookup[writelookup[c]]  = NULL;
+            page_lookupp[writelookup[c]] = 4;
+            writelookup2[writelookup[c]] = LOOKUP_INV;
+            writelookupp[writelookup[c]] = 4;
+            writelookup[c]               = 0xffffffff;
+        }
+    }
+    mmuflush++;
+    metrics.mmu_flushes++;
+    mmu_walk_cache_flush();
 
     pccache  = (uint32_t) 0xffffffff;
     pccache2 = (uint8_t *) 0xffffffff;
 
+    pccache_2386 = 0xffffffff;
+
 #ifdef USE_DYNAREC
     codegen_flush();
 #endif
@@ -242,6 +360,74 @@ flushmmucache_nopc(void)
             writelookup[c]               = 0xffffffff;
         }
     }
+
+    metrics.mmu_flushes++;
+    mmu_walk_cache_flush();
+
+    /* The mappings may have changed under the 286/386 fetch cache. */
+    pccache_2386 = 0xffffffff;
+}
+
+/*
+ * Same as flushmmucache_nopc(), but only drops the lookups that lead to
+ * RAM in the given physical range; meant for the chipsets' shadow RAM
+ * toggles, which would otherwise throw away the whole TLB every time the
+ * BIOS touches one 16K segment. Only RAM and linear frame buffers get
+ * lookups, the latter never below 1 MB, and the remapped RAM handlers
+ * store the backing address, so comparing the host pointers is enough.
+ * Paging mode changes still need the full flush.
+ */
+void
+flushmmucache_range(uint32_t base, uint32_t size)
+{
+    uintptr_t     lo;
+    uintptr_t     hi;
+    const page_t *page_lo;
+    const page_t *page_hi;
+    const page_t *page;
+    uintptr_t     host;
+
+    if (!size)
+        return;
+
+    /* Only lower RAM is known to sit in ram[] on every host. */
+    if (((uint64_t) base + size) > 0x00100000) {
+        flushmmucache_nopc();
+        return;
+    }
+
+    lo      = (uintptr_t) &ram[base & ~0xfff];
+    hi      = (uintptr_t) &ram[(base + size + 0xfff) & ~0xfff];
+    page_lo = &pages[base >> 12];
+    page_hi = &pages[(base + size + 0xfff) >> 12];
+
+    for (uint16_t c = 0; c < 256; c++) {
+        if (readlookup[c] != (int) 0xffffffff) {
+            host = readlookup2[readlookup[c]] + ((uintptr_t) readlookup[c] << 12);
+            if ((host >= lo) && (host < hi)) {
+                readlookup2[readlookup[c]] = LOOKUP_INV;
+                readlookupp[readlookup[c]] = 4;
+                readlookup[c]              = 0xffffffff;
+            }
+        }
+        if (writelookup[c] != (int) 0xffffffff) {
+            /* Pages holding code are looked up through page_lookup instead. */
+            page = page_lookup[writelookup[c]];
+            host = writelookup2[writelookup[c]] + ((uintptr_t) writelookup[c] << 12);
+            if (page ? ((page >= page_lo) && (page < page_hi)) : ((host >= lo) && (host < hi))) {
+                page_lookup[writelookup[c]]  = NULL;
+                page_lookupp[writelookup[c]] = 4;
+                writelookup2[writelookup[c]] = LOOKUP_INV;
+                writelookupp[writelookup[c]] = 4;
+                writelookup[c]               = 0xffffffff;
+            }
+        }
+    }
+
+    metrics.mmu_range_flushes++;
+    mmu_walk_cache_flush();
+
+    pccache_2386 = 0xffffffff;
 }
 
 void
@@ -283,15 +469,22 @@ mem_flush_write_page(uint32_t addr, uint32_t virt)
 static __inline uint64_t
 mmutranslatereal_normal(uint32_t addr, int rw)
 {
-    uint32_t temp;
-    uint32_t temp2;
-    uint32_t temp3;
-    uint32_t addr2;
+    mmu_pde_t *pde = &mmu_pde_cache[addr >> 22];
+    uint32_t   temp;
+    uint32_t   temp2;
+    uint32_t   temp3;
+    uint32_t   addr2;
 
     if (cpu_state.abrt)
         return 0xffffffffffffffffULL;
 
+    mmu_walk_cache_check();
+
     addr2 = ((cr3 & ~0xfff) + ((addr >> 20) & 0xffc));
+    if (pde->gen == mmu_pde_gen) {
+        temp = temp2 = (uint32_t) pde->val;
+        goto walk_pte;
+    }
     temp = temp2 = rammap(addr2);
     if (!(temp & 1)) {
         cr2 = addr;
@@ -320,12 +513,14 @@ mmutranslatereal_normal(uint32_t addr, int rw)
             return 0xffffffffffffffffULL;
         }
 
-        mmu_perm = temp & 4;
+        mmu_perm        = temp & 4;
+        mmu_global_page = ((cr4 & CR4_PGE) && (temp & 0x100)) ? (addr >> 12) : 0xffffffff;
         rammap(addr2) |= (rw ? 0x60 : 0x20);
 
         return (temp & ~0x3fffff) + (addr & 0x3fffff);
     }
 
+walk_pte:
     temp  = rammap((temp & ~0xfff) + ((addr >> 10) & 0xffc));
     temp3 = temp & temp2;
     if (!(temp & 1) || ((CPL == 3) && !(temp3 & 4) && !cpl_override) || (rw && !(temp3 & 2) && (((CPL == 3) && !cpl_override) || ((is486 || isibm486) && (cr0 & WP_FLAG))))) {
@@ -340,8 +535,13 @@ mmutranslatereal_normal(uint32_t addr, int rw)
         return 0xffffffffffffffffULL;
     }
 
-    mmu_perm = temp & 4;
-    rammap(addr2) |= 0x20;
+    mmu_perm        = temp & 4;
+    mmu_global_page = ((cr4 & CR4_PGE) && (temp & 0x100)) ? (addr >> 12) : 0xffffffff;
+    if (pde->gen != mmu_pde_gen) {
+        rammap(addr2) |= 0x20;
+        pde->val = temp2 | 0x20;
+        pde->gen = mmu_pde_gen;
+    }
     rammap((temp2 & ~0xfff) + ((addr >> 10) & 0xffc)) |= (rw ? 0x60 : 0x20);
 
     return (uint64_t) ((temp & ~0xfff) + (addr & 0xfff));
@@ -350,19 +550,31 @@ mmutranslatereal_normal(uint32_t addr, int rw)
 static __inline uint64_t
 mmutranslatereal_pae(uint32_t addr, int rw)
 {
-    uint64_t temp;
-    uint64_t temp2;
-    uint64_t temp3;
-    uint64_t temp4;
-    uint64_t addr2;
-    uint64_t addr3;
-    uint64_t addr4;
+    mmu_pde_t *pdpte = &mmu_pdpte_cache[addr >> 30];
+    mmu_pde_t *pde   = &mmu_pde_cache[addr >> 21];
+    uint64_t   temp;
+    uint64_t   temp2;
+    uint64_t   temp3;
+    uint64_t   temp4;
+    uint64_t   addr2;
+    uint64_t   addr3 = 0;
+    uint64_t   addr4;
 
     if (cpu_state.abrt)
         return 0xffffffffffffffffULL;
 
+    mmu_walk_cache_check();
+
+    if (pde->gen == mmu_pde_gen) {
+        temp = temp4 = pde->val;
+        goto walk_pte;
+    }
+
     addr2 = (cr3 & ~0x1f) + ((addr >> 27) & 0x18);
-    temp = temp2 = rammap64(addr2) & 0x000000ffffffffffULL;
+    if (pdpte->gen == mmu_pde_gen)
+        temp = temp2 = pdpte->val;
+    else
+        temp = temp2 = rammap64(addr2) & 0x000000ffffffffffULL;
     if (!(temp & 1)) {
         cr2 = addr;
         temp &= 1;
@@ -374,6 +586,8 @@ mmutranslatereal_pae(uint32_t addr, int rw)
         abrt_error     = temp;
         return 0xffffffffffffffffULL;
     }
+    pdpte->val = temp2;
+    pdpte->gen = mmu_pde_gen;
 
     addr3 = (temp & ~0xfffULL) + ((addr >> 18) & 0xff8);
     temp = temp4 = rammap64(addr3) & 0x000000ffffffffffULL;
@@ -404,12 +618,14 @@ mmutranslatereal_pae(uint32_t addr, int rw)
 
             return 0xffffffffffffffffULL;
         }
-        mmu_perm = temp & 4;
+        mmu_perm        = temp & 4;
+        mmu_global_page = ((cr4 & CR4_PGE) && (temp & 0x100)) ? (addr >> 12) : 0xffffffff;
         rammap64(addr3) |= (rw ? 0x60 : 0x20);
 
         return ((temp & ~0x1fffffULL) + (addr & 0x1fffffULL)) & 0x000000ffffffffffULL;
     }
 
+walk_pte:
     addr4 = (temp & ~0xfffULL) + ((addr >> 9) & 0xff8);
     temp  = rammap64(addr4) & 0x000000ffffffffffULL;
     temp3 = temp & temp4;
@@ -425,8 +641,13 @@ mmutranslatereal_pae(uint32_t addr, int rw)
         return 0xffffffffffffffffULL;
     }
 
-    mmu_perm = temp & 4;
-    rammap64(addr3) |= 0x20;
+    mmu_perm        = temp & 4;
+    mmu_global_page = ((cr4 & CR4_PGE) && (temp & 0x100)) ? (addr >> 12) : 0xffffffff;
+    if (pde->gen != mmu_pde_gen) {
+        rammap64(addr3) |= 0x20;
+        pde->val = temp4 | 0x20;
+        pde->gen = mmu_pde_gen;
+    }
     rammap64(addr4) |= (rw ? 0x60 : 0x20);
 
     return ((temp & ~0xfffULL) + ((uint64_t) (addr & 0xfff))) & 0x000000ffffffffffULL;
@@ -599,6 +820,7 @@ addreadlookup(uint32_t virt, uint32_t phys)
 #endif
     readlookupp[virt >> 12] = mmu_perm;
 
+    readlookupg[readlnext]  = mmu_lookup_global(virt);
     readlookup[readlnext++] = virt >> 12;
     readlnext &= (cachesize - 1);
 
@@ -652,12 +874,91 @@ addwritelookup(uint32_t virt, uint32_t phys)
     }
     writelookupp[virt >> 12] = mmu_perm;
 
+    writelookupg[writelnext]  = mmu_lookup_global(virt);
     writelookup[writelnext++] = virt >> 12;
     writelnext &= (cachesize - 1);
 
     cycles -= 9;
 }
 
+/*
+ * Same as addreadlookup() and addwritelookup(), for a page of device
+ * memory the CPU may access as plain memory, at host address ptr; meant
+ * for linear frame buffers. The device takes the lookups back with
+ * mem_flush_direct_lookups() as soon as accesses have to go through its
+ * handlers again.
+ */
+void
+mem_add_direct_lookup(uint32_t virt, uint8_t *ptr, int write)
+{
+    if ((virt == 0xffffffff) || !cpu_use_exec)
+        return;
+
+    if (write) {
+        if (page_lookup[virt >> 12] || (writelookup2[virt >> 12] != (uintptr_t) LOOKUP_INV))
+            return;
+
+        if (writelookup[writelnext] != -1) {
+            page_lookup[writelookup[writelnext]]  = NULL;
+            writelookup2[writelookup[writelnext]] = LOOKUP_INV;
+        }
+
+        writelookup2[virt >> 12] = (uintptr_t) ptr - (uintptr_t) (virt & ~0xfff);
+        writelookupp[virt >> 12] = mmu_perm;
+
+        writelookupg[writelnext]  = mmu_lookup_global(virt);
+        writelookup[writelnext++] = virt >> 12;
+        writelnext &= (cachesize - 1);
+    } else {
+        if (readlookup2[virt >> 12] != (uintptr_t) LOOKUP_INV)
+            return;
+
+        if (readlookup[readlnext] != (int) 0xffffffff) {
+            if ((readlookup[readlnext] == ((es + DI) >> 12)) || (readlookup[readlnext] == ((es + EDI) >> 12)))
+                uncached = 1;
+            readlookup2[readlookup[readlnext]] = LOOKUP_INV;
+        }
+
+        readlookup2[virt >> 12] = (uintptr_t) ptr - (uintptr_t) (virt & ~0xfff);
+        readlookupp[virt >> 12] = mmu_perm;
+
+        readlookupg[readlnext]  = mmu_lookup_global(virt);
+        readlookup[readlnext++] = virt >> 12;
+        readlnext &= (cachesize - 1);
+    }
+
+    cycles -= 9;
+}
+
+/* Drops the lookups leading to host memory in [base, base + size). */
+void
+mem_flush_direct_lookups(const uint8_t *base, uint32_t size)
+{
+    uintptr_t lo = (uintptr_t) base;
+    uintptr_t hi = lo + size;
+    uintptr_t host;
+
+    for (uint16_t c = 0; c < 256; c++) {
+        if (readlookup[c] != (int) 0xffffffff) {
+            host = readlookup2[readlookup[c]] + ((uintptr_t) readlookup[c] << 12);
+            if ((readlookup2[readlookup[c]] != (uintptr_t) LOOKUP_INV) && (host >= lo) && (host < hi)) {
+                readlookup2[readlookup[c]] = LOOKUP_INV;
+                readlookupp[readlookup[c]] = 4;
+                readlookup[c]              = 0xffffffff;
+            }
+        }
+        if ((writelookup[c] != (int) 0xffffffff) && (page_lookup[writelookup[c]] == NULL) &&
+            (writelookup2[writelookup[c]] != (uintptr_t) LOOKUP_INV)) {
+            host = writelookup2[writelookup[c]] + ((uintptr_t) writelookup[c] << 12);
+            if ((host >= lo) && (host < hi)) {
+                writelookup2[writelookup[c]] = LOOKUP_INV;
+                writelookupp[writelookup[c]] = 4;
+                writelookup[c]               = 0xffffffff;
+            }
+        }
+    }
+}
+
 uint8_t *
 getpccache(uint32_t a)
 {
@@ -710,7 +1011,7 @@ read_mem_b(uint32_t addr)
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->read_b)
-        ret = map->read_b(addr, map->priv);
+        ret = mem_map_read_b(map, addr);
 
     resub_cycles(old_cycles);
 
@@ -733,9 +1034,9 @@ read_mem_w(uint32_t addr)
         map = read_mapping[addr >> MEM_GRANULARITY_BITS];
 
         if (map && map->read_w)
-            ret = map->read_w(addr, map->priv);
+            ret = mem_map_read_w(map, addr);
         else if (map && map->read_b)
-            ret = map->read_b(addr, map->priv) | (map->read_b(addr + 1, map->priv) << 8);
+            ret = mem_map_read_b(map, addr) | (mem_map_read_b(map, addr + 1) << 8);
     }
 
     resub_cycles(old_cycles);
@@ -754,7 +1055,7 @@ write_mem_b(uint32_t addr, uint8_t val)
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->write_b)
-        map->write_b(addr, val, map->priv);
+        mem_map_write_b(map, addr, val);
 
     resub_cycles(old_cycles);
 }
@@ -775,10 +1076,10 @@ write_mem_w(uint32_t addr, uint16_t val)
         map = write_mapping[addr >> MEM_GRANULARITY_BITS];
         if (map) {
             if (map->write_w)
-                map->write_w(addr, val, map->priv);
+                mem_map_write_w(map, addr, val);
             else if (map->write_b) {
-                map->write_b(addr, val, map->priv);
-                map->write_b(addr + 1, val >> 8, map->priv);
+                mem_map_write_b(map, addr, val);
+                mem_map_write_b(map, addr + 1, val >> 8);
             }
         }
     }
@@ -813,7 +1114,7 @@ readmembl(uint32_t addr)
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->read_b)
-        return map->read_b(addr, map->priv);
+        return mem_map_read_b(map, addr);
 
     return 0xff;
 }
@@ -850,7 +1151,7 @@ writemembl(uint32_t addr, uint8_t val)
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->write_b)
-        map->write_b(addr, val, map->priv);
+        mem_map_write_b(map, addr, val);
 }
 
 /* Read a byte from memory without MMU translation - result of previous MMU translation passed as value. */
@@ -873,7 +1174,7 @@ readmembl_no_mmut(uint32_t addr, uint32_t a64)
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->read_b)
-        return map->read_b(addr, map->priv);
+        return mem_map_read_b(map, addr);
 
     return 0xff;
 }
@@ -903,7 +1204,35 @@ writemembl_no_mmut(uint32_t addr, uint32_t a64, uint8_t val)
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->write_b)
-        map->write_b(addr, val, map->priv);
+        mem_map_write_b(map, addr, val);
+}
+
+/* Accesses straddling two pages that both have valid lookups are assembled
+   straight from the two host pointers, without walking the page tables again. */
+static __inline int
+mem_straddle_lookup(const uintptr_t *lookup, uint32_t addr, int width)
+{
+    return (lookup[addr >> 12] != (uintptr_t) LOOKUP_INV) && (lookup[(addr + width - 1) >> 12] != (uintptr_t) LOOKUP_INV);
+}
+
+static __inline uint64_t
+mem_straddle_read(uint32_t addr, int width)
+{
+    uint64_t val = 0;
+
+    for (int i = 0; i < width; i++)
+        val |= ((uint64_t) *(uint8_t *) (readlookup2[(addr + i) >> 12] + (uintptr_t) (addr + i))) << (i << 3);
+    mmu_perm = readlookupp[(addr + width - 1) >> 12];
+
+    return val;
+}
+
+static __inline void
+mem_straddle_write(uint32_t addr, uint64_t val, int width)
+{
+    for (int i = 0; i < width; i++)
+        *(uint8_t *) (writelookup2[(addr + i) >> 12] + (uintptr_t) (addr + i)) = val >> (i << 3);
+    mmu_perm = writelookupp[(addr + width - 1) >> 12];
 }
 
 uint16_t
@@ -928,6 +1257,9 @@ readmemwl(uint32_t addr)
         if (!cpu_cyrix_alignment || (addr & 7) == 7)
             cycles -= timing_misaligned;
         if ((addr & 0xfff) > 0xffe) {
+            if (mem_straddle_lookup(readlookup2, addr, 2))
+                return mem_straddle_read(addr, 2);
+
             if (cr0 >> 31) {
                 for (uint8_t i = 0; i < 2; i++) {
                     a          = mmutranslate_read(addr + i);
@@ -959,10 +1291,10 @@ readmemwl(uint32_t addr)
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv);
+        return mem_map_read_w(map, addr);
 
     if (map && map->read_b) {
-        return map->read_b(addr, map->priv) | ((uint16_t) (map->read_b(addr + 1, map->priv)) << 8);
+        return mem_map_read_b(map, addr) | ((uint16_t) (mem_map_read_b(map, addr + 1)) << 8);
     }
 
     return 0xffff;
@@ -990,6 +1322,11 @@ writememwl(uint32_t addr, uint16_t val)
         if (!cpu_cyrix_alignment || (addr & 7) == 7)
             cycles -= timing_misaligned;
         if ((addr & 0xfff) > 0xffe) {
+            if (mem_straddle_lookup(writelookup2, addr, 2)) {
+                mem_straddle_write(addr, val, 2);
+                return;
+            }
+
             if (cr0 >> 31) {
                 for (uint8_t i = 0; i < 2; i++) {
                     /* Do not translate a page that has a valid lookup, as that is by definition valid
@@ -1035,13 +1372,13 @@ writememwl(uint32_t addr, uint16_t val)
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
+        mem_map_write_w(map, addr, val);
         return;
     }
 
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
+        mem_map_write_b(map, addr, val);
+        mem_map_write_b(map, addr + 1, val >> 8);
         return;
     }
 }
@@ -1083,10 +1420,10 @@ readmemwl_no_mmut(uint32_t addr, uint32_t *a64)
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv);
+        return mem_map_read_w(map, addr);
 
     if (map && map->read_b) {
-        return map->read_b(addr, map->priv) | ((uint16_t) (map->read_b(addr + 1, map->priv)) << 8);
+        return mem_map_read_b(map, addr) | ((uint16_t) (mem_map_read_b(map, addr + 1)) << 8);
     }
 
     return 0xffff;
@@ -1138,13 +1475,13 @@ writememwl_no_mmut(uint32_t addr, uint32_t *a64, uint16_t val)
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
+        mem_map_write_w(map, addr, val);
         return;
     }
 
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
+        mem_map_write_b(map, addr, val);
+        mem_map_write_b(map, addr + 1, val >> 8);
         return;
     }
 }
@@ -1172,6 +1509,9 @@ readmemll(uint32_t addr)
         if (!cpu_cyrix_alignment || (addr & 7) > 4)
             cycles -= timing_misaligned;
         if ((addr & 0xfff) > 0xffc) {
+            if (mem_straddle_lookup(readlookup2, addr, 4))
+                return mem_straddle_read(addr, 4);
+
             if (cr0 >> 31) {
                 for (i = 0; i < 4; i++) {
                     if (i == 0) {
@@ -1216,13 +1556,13 @@ readmemll(uint32_t addr)
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->read_l)
-        return map->read_l(addr, map->priv);
+        return mem_map_read_l(map, addr);
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv) | ((uint32_t) (map->read_w(addr + 2, map->priv)) << 16);
+        return mem_map_read_w(map, addr) | ((uint32_t) (mem_map_read_w(map, addr + 2)) << 16);
 
     if (map && map->read_b)
-        return map->read_b(addr, map->priv) | ((uint32_t) (map->read_b(addr + 1, map->priv)) << 8) | ((uint32_t) (map->read_b(addr + 2, map->priv)) << 16) | ((uint32_t) (map->read_b(addr + 3, map->priv)) << 24);
+        return mem_map_read_b(map, addr) | ((uint32_t) (mem_map_read_b(map, addr + 1)) << 8) | ((uint32_t) (mem_map_read_b(map, addr + 2)) << 16) | ((uint32_t) (mem_map_read_b(map, addr + 3)) << 24);
 
     return 0xffffffff;
 }
@@ -1250,6 +1590,11 @@ writememll(uint32_t addr, uint32_t val)
         if (!cpu_cyrix_alignment || (addr & 7) > 4)
             cycles -= timing_misaligned;
         if ((addr & 0xfff) > 0xffc) {
+            if (mem_straddle_lookup(writelookup2, addr, 4)) {
+                mem_straddle_write(addr, val, 4);
+                return;
+            }
+
             if (cr0 >> 31) {
                 for (i = 0; i < 4; i++) {
                     /* Do not translate a page that has a valid lookup, as that is by definition valid
@@ -1307,19 +1652,19 @@ writememll(uint32_t addr, uint32_t val)
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->write_l) {
-        map->write_l(addr, val, map->priv);
+        mem_map_write_l(map, addr, val);
         return;
     }
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
-        map->write_w(addr + 2, val >> 16, map->priv);
+        mem_map_write_w(map, addr, val);
+        mem_map_write_w(map, addr + 2, val >> 16);
         return;
     }
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
-        map->write_b(addr + 2, val >> 16, map->priv);
-        map->write_b(addr + 3, val >> 24, map->priv);
+        mem_map_write_b(map, addr, val);
+        mem_map_write_b(map, addr + 1, val >> 8);
+        mem_map_write_b(map, addr + 2, val >> 16);
+        mem_map_write_b(map, addr + 3, val >> 24);
         return;
     }
 }
@@ -1361,13 +1706,13 @@ readmemll_no_mmut(uint32_t addr, uint32_t *a64)
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->read_l)
-        return map->read_l(addr, map->priv);
+        return mem_map_read_l(map, addr);
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv) | ((uint32_t) (map->read_w(addr + 2, map->priv)) << 16);
+        return mem_map_read_w(map, addr) | ((uint32_t) (mem_map_read_w(map, addr + 2)) << 16);
 
     if (map && map->read_b)
-        return map->read_b(addr, map->priv) | ((uint32_t) (map->read_b(addr + 1, map->priv)) << 8) | ((uint32_t) (map->read_b(addr + 2, map->priv)) << 16) | ((uint32_t) (map->read_b(addr + 3, map->priv)) << 24);
+        return mem_map_read_b(map, addr) | ((uint32_t) (mem_map_read_b(map, addr + 1)) << 8) | ((uint32_t) (mem_map_read_b(map, addr + 2)) << 16) | ((uint32_t) (mem_map_read_b(map, addr + 3)) << 24);
 
     return 0xffffffff;
 }
@@ -1418,19 +1763,19 @@ writememll_no_mmut(uint32_t addr, uint32_t *a64, uint32_t val)
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->write_l) {
-        map->write_l(addr, val, map->priv);
+        mem_map_write_l(map, addr, val);
         return;
     }
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
-        map->write_w(addr + 2, val >> 16, map->priv);
+        mem_map_write_w(map, addr, val);
+        mem_map_write_w(map, addr + 2, val >> 16);
         return;
     }
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
-        map->write_b(addr + 2, val >> 16, map->priv);
-        map->write_b(addr + 3, val >> 24, map->priv);
+        mem_map_write_b(map, addr, val);
+        mem_map_write_b(map, addr + 1, val >> 8);
+        mem_map_write_b(map, addr + 2, val >> 16);
+        mem_map_write_b(map, addr + 3, val >> 24);
         return;
     }
 }
@@ -1457,6 +1802,9 @@ readmemql(uint32_t addr)
     if (addr & 7) {
         cycles -= timing_misaligned;
         if ((addr & 0xfff) > 0xff8) {
+            if (mem_straddle_lookup(readlookup2, addr, 8))
+                return mem_straddle_read(addr, 8);
+
             if (cr0 >> 31) {
                 for (i = 0; i < 8; i++) {
                     if (i == 0) {
@@ -1500,7 +1848,7 @@ readmemql(uint32_t addr)
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->read_l)
-        return map->read_l(addr, map->priv) | ((uint64_t) map->read_l(addr + 4, map->priv) << 32);
+        return mem_map_read_l(map, addr) | ((uint64_t) mem_map_read_l(map, addr + 4) << 32);
 
     return readmemll(addr) | ((uint64_t) readmemll(addr + 4) << 32);
 }
@@ -1527,6 +1875,11 @@ writememql(uint32_t addr, uint64_t val)
     if (addr & 7) {
         cycles -= timing_misaligned;
         if ((addr & 0xfff) > 0xff8) {
+            if (mem_straddle_lookup(writelookup2, addr, 8)) {
+                mem_straddle_write(addr, val, 8);
+                return;
+            }
+
             if (cr0 >> 31) {
                 for (i = 0; i < 8; i++) {
                     /* Do not translate a page that has a valid lookup, as that is by definition valid
@@ -1583,26 +1936,26 @@ writememql(uint32_t addr, uint64_t val)
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->write_l) {
-        map->write_l(addr, val, map->priv);
-        map->write_l(addr + 4, val >> 32, map->priv);
+        mem_map_write_l(map, addr, val);
+        mem_map_write_l(map, addr + 4, val >> 32);
         return;
     }
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
-        map->write_w(addr + 2, val >> 16, map->priv);
-        map->write_w(addr + 4, val >> 32, map->priv);
-        map->write_w(addr + 6, val >> 48, map->priv);
+        mem_map_write_w(map, addr, val);
+        mem_map_write_w(map, addr + 2, val >> 16);
+        mem_map_write_w(map, addr + 4, val >> 32);
+        mem_map_write_w(map, addr + 6, val >> 48);
         return;
     }
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
-        map->write_b(addr + 2, val >> 16, map->priv);
-        map->write_b(addr + 3, val >> 24, map->priv);
-        map->write_b(addr + 4, val >> 32, map->priv);
-        map->write_b(addr + 5, val >> 40, map->priv);
-        map->write_b(addr + 6, val >> 48, map->priv);
-        map->write_b(addr + 7, val >> 56, map->priv);
+        mem_map_write_b(map, addr, val);
+        mem_map_write_b(map, addr + 1, val >> 8);
+        mem_map_write_b(map, addr + 2, val >> 16);
+        mem_map_write_b(map, addr + 3, val >> 24);
+        mem_map_write_b(map, addr + 4, val >> 32);
+        mem_map_write_b(map, addr + 5, val >> 40);
+        mem_map_write_b(map, addr + 6, val >> 48);
+        mem_map_write_b(map, addr + 7, val >> 56);
         return;
     }
 }
@@ -1669,7 +2022,7 @@ mem_readb_phys(uint32_t addr)
         if (cpu_use_exec && map->exec)
             ret = map->exec[(addr - map->base) & map->mask];
         else if (map->read_b)
-            ret = map->read_b(addr, map->priv);
+            ret = mem_map_read_b(map, addr);
     }
 
     return ret;
@@ -1688,7 +2041,7 @@ mem_readw_phys(uint32_t addr)
         p   = (uint16_t *) &(map->exec[(addr - map->base) & map->mask]);
         ret = *p;
     } else if (((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_HBOUND) && (map && map->read_w))
-        ret = map->read_w(addr, map->priv);
+        ret = mem_map_read_w(map, addr);
     else {
         ret = mem_readb_phys(addr + 1) << 8;
         ret |= mem_readb_phys(addr);
@@ -1710,7 +2063,7 @@ mem_readl_phys(uint32_t addr)
         p   = (uint32_t *) &(map->exec[(addr - map->base) & map->mask]);
         ret = *p;
     } else if (((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_QBOUND) && (map && map->read_l))
-        ret = map->read_l(addr, map->priv);
+        ret = mem_map_read_l(map, addr);
     else {
         ret = mem_readw_phys(addr + 2) << 16;
         ret |= mem_readw_phys(addr);
@@ -1749,7 +2102,7 @@ mem_writeb_phys(uint32_t addr, uint8_t val)
         if (cpu_use_exec && map->exec)
             map->exec[(addr - map->base) & map->mask] = val;
         else if (map->write_b)
-            map->write_b(addr, val, map->priv);
+            mem_map_write_b(map, addr, val);
     }
 }
 
@@ -1765,7 +2118,7 @@ mem_writew_phys(uint32_t addr, uint16_t val)
         p  = (uint16_t *) &(map->exec[(addr - map->base) & map->mask]);
         *p = val;
     } else if (((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_HBOUND) && (map && map->write_w))
-        map->write_w(addr, val, map->priv);
+        mem_map_write_w(map, addr, val);
     else {
         mem_writeb_phys(addr, val & 0xff);
         mem_writeb_phys(addr + 1, (val >> 8) & 0xff);
@@ -1784,7 +2137,7 @@ mem_writel_phys(uint32_t addr, uint32_t val)
         p  = (uint32_t *) &(map->exec[(addr - map->base) & map->mask]);
         *p = val;
     } else if (((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_QBOUND) && (map && map->write_l))
-        map->write_l(addr, val, map->priv);
+        mem_map_write_l(map, addr, val);
     else {
         mem_writew_phys(addr, val & 0xffff);
         mem_writew_phys(addr + 2, (val >> 16) & 0xffff);
@@ -1810,6 +2163,36 @@ mem_write_phys(void *src, uint32_t addr, int transfer_size)
     }
 }
 
+/* Return a host pointer to the memory backing the physical range starting at
+   addr, if the range lies within one granule and that granule is plain RAM
+   that the phys accessors would read or write directly. Returns NULL if the
+   range has to go through the mapping handlers. */
+uint8_t *
+mem_get_phys_ptr(uint32_t addr, uint32_t len, int write)
+{
+    mem_mapping_t *map = write ? write_mapping_bus[addr >> MEM_GRANULARITY_BITS] : read_mapping_bus[addr >> MEM_GRANULARITY_BITS];
+    uint32_t       offset;
+
+    if (!cpu_use_exec || !len || !map || !map->exec || ((addr & MEM_GRANULARITY_MASK) + len) > MEM_GRANULARITY_SIZE)
+        return NULL;
+
+    offset = (addr - map->base) & map->mask;
+    if ((offset + len - 1) > map->mask)
+        return NULL;
+
+    mem_logical_addr = 0xffffffff;
+
+    return &(map->exec[offset]);
+}
+
+/* Return the mapping the phys accessors would use for addr, or NULL if
+   nothing is mapped there. */
+mem_mapping_t *
+mem_get_phys_mapping(uint32_t addr, int write)
+{
+    return write ? write_mapping_bus[addr >> MEM_GRANULARITY_BITS] : read_mapping_bus[addr >> MEM_GRANULARITY_BITS];
+}
+
 uint8_t
 mem_read_ram(uint32_t addr, UNUSED(void *priv))
 {
@@ -2318,11 +2701,13 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
     int            n;
     uint64_t       c;
     uint8_t        wp;
+    uint64_t       start_time;
 
     if (!size || (base_mapping == NULL))
         return;
 
-    map = base_mapping;
+    start_time = plat_timer_read();
+    map        = base_mapping;
 
     /* Clear out old mappings. */
     for (c = base; c < base + size; c += MEM_GRANULARITY_SIZE) {
@@ -2341,6 +2726,8 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
             uint64_t start = (map->base < base) ? map->base : base;
             uint64_t end   = (((uint64_t) map->base + (uint64_t) map->size) < (base + size)) ?
                              ((uint64_t) map->base + (uint64_t) map->size) : (base + size);
+            int      has_read  = map->read_b || map->read_w || map->read_l;
+            int      has_write = map->write_b || map->write_w || map->write_l;
             if (start < map->base)
                 start = map->base;
 
@@ -2352,11 +2739,11 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
                 if (map->exec && mem_mapping_access_allowed(map->flags,
                                  _mem_state[c >> MEM_GRANULARITY_BITS].states[n].x))
                     _mem_exec[c >> MEM_GRANULARITY_BITS] = map->exec + (c - map->base);
-                if (!wp && (map->write_b || map->write_w || map->write_l) &&
+                if (!wp && has_write &&
                     mem_mapping_access_allowed(map->flags,
                                                _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
                     write_mapping[c >> MEM_GRANULARITY_BITS] = map;
-                if ((map->read_b || map->read_w || map->read_l) &&
+                if (has_read &&
                     mem_mapping_access_allowed(map->flags,
                                                _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
                     read_mapping[c >> MEM_GRANULARITY_BITS] = map;
@@ -2365,11 +2752,11 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
                 n |= STATE_BUS;
                 wp = _mem_wp_bus[c >> MEM_GRANULARITY_BITS];
 
-                if (!wp && (map->write_b || map->write_w || map->write_l) &&
+                if (!wp && has_write &&
                     mem_mapping_access_allowed(map->flags,
                                                _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
                     write_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
-                if ((map->read_b || map->read_w || map->read_l) &&
+                if (has_read &&
                     mem_mapping_access_allowed(map->flags,
                                                _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
                     read_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
@@ -2380,6 +2767,13 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
 
     flushmmucache_nopc();
 
+    start_time = plat_timer_read() - start_time;
+    mem_remap_count++;
+    mem_mapping_gen++;
+    mem_remap_granules += size >> MEM_GRANULARITY_BITS;
+    mem_remap_time += start_time;
+    mem_log("mem_mapping_recalc(%08X, %08X): %" PRIu64 " ticks\n", (uint32_t) base, (uint32_t) size, start_time);
+
 #ifdef ENABLE_MEM_LOG
     pclog("\nMemory map:\n");
     mem_mapping_t *write = (mem_mapping_t *) -1, *read = (mem_mapping_t *) -1, *write_bus = (mem_mapping_t *) -1, *read_bus = (mem_mapping_t *) -1;
@@ -2682,6 +3076,10 @@ mem_close(void)
     mem_mapping_t *map = base_mapping;
     mem_mapping_t *next;
 
+    mem_log("Memory remaps: %" PRIu64 " calls, %" PRIu64 " granules, %" PRIu64 " ticks\n",
+            mem_remap_count, mem_remap_granules, mem_remap_time);
+    mem_remap_count = mem_remap_granules = mem_remap_time = 0;
+
     while (map != NULL) {
         next      = map->next;
         map->prev = map->next = NULL;
@@ -2751,18 +3149,23 @@ mem_reset(void)
 
     m = 1024UL * (size_t) mem_size;
 
+    /*
+     * The RAM blocks are not cleared here: plat_mmap() hands out anonymous
+     * memory, which is already zero and is only backed by the host once the
+     * guest touches it, so a guest that never uses most of a large RAM size
+     * does not cost that much host memory.
+     */
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
     if (mem_size > 1048576) {
         ram_size = 1 << 30;
-        ram      = (uint8_t *) plat_mmap(ram_size, 0); /* allocate and clear the RAM block of the first 1 GB */
+        ram      = (uint8_t *) plat_mmap(ram_size, 0); /* allocate the RAM block of the first 1 GB */
         if (ram == NULL) {
             fatal("Failed to allocate primary RAM block. Make sure you have enough RAM available.\n");
             return;
         }
-        memset(ram, 0x00, ram_size);
         ram2_size = m - (1 << 30);
         /* Allocate 16 extra bytes of RAM to mitigate some dynarec recompiler memory access quirks. */
-        ram2      = (uint8_t *) plat_mmap(ram2_size + 16, 0); /* allocate and clear the RAM block above 1 GB */
+        ram2      = (uint8_t *) plat_mmap(ram2_size + 16, 0); /* allocate the RAM block above 1 GB */
         if (ram2 == NULL) {
             if (config_changed == 2)
                 fatal(EMU_NAME " must be restarted for the memory amount change to be applied.\n");
@@ -2770,18 +3173,16 @@ mem_reset(void)
                 fatal("Failed to allocate secondary RAM block. Make sure you have enough RAM available.\n");
             return;
         }
-        memset(ram2, 0x00, ram2_size + 16);
     } else
 #endif
     {
         ram_size = m;
         /* Allocate 16 extra bytes of RAM to mitigate some dynarec recompiler memory access quirks. */
-        ram      = (uint8_t *) plat_mmap(ram_size + 16, 0); /* allocate and clear the RAM block */
+        ram      = (uint8_t *) plat_mmap(ram_size + 16, 0); /* allocate the RAM block */
         if (ram == NULL) {
             fatal("Failed to allocate RAM block. Make sure you have enough RAM available.\n");
             return;
         }
-        memset(ram, 0x00, ram_size + 16);
         if (mem_size > 1048576)
             ram2 = &(ram[1 << 30]);
     }
@@ -3147,3 +3548,156 @@ mem_a20_recalc(void)
 
     mem_a20_state = state;
 }
+
+/* Guest RAM page records in a snapshot. */
+#define MEM_SNAP_ZERO 0 /* followed by the number of all-zero pages */
+#define MEM_SNAP_DUP  1 /* followed by the number of an earlier identical page */
+#define MEM_SNAP_RAW  2 /* followed by the page */
+
+static uint8_t *
+mem_snapshot_page(uint32_t page)
+{
+    uint32_t addr = page << 12;
+
+    return (addr < (1 << 30)) ? &ram[addr] : &ram2[addr - (1 << 30)];
+}
+
+static uint64_t
+mem_snapshot_hash(const uint8_t *p)
+{
+    const uint64_t *q    = (const uint64_t *) p;
+    uint64_t        hash = 0xcbf29ce484222325ULL;
+
+    for (int i = 0; i < (4096 / 8); i++) {
+        hash = (hash ^ q[i]) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+
+    return hash;
+}
+
+static int
+mem_snapshot_zero(const uint8_t *p)
+{
+    const uint64_t *q = (const uint64_t *) p;
+
+    for (int i = 0; i < (4096 / 8); i++) {
+        if (q[i])
+            return 0;
+    }
+
+    return 1;
+}
+
+static void
+mem_snapshot_save(snapshot_t *snap, uint32_t count)
+{
+    uint32_t  hash_size = 1;
+    uint32_t *hash_tab;
+    uint32_t  zeroes = 0;
+    uint8_t   type;
+
+    /* Open addressing, page number + 1 per slot, at most half full. */
+    while (hash_size < (count << 1))
+        hash_size <<= 1;
+    hash_tab = calloc(hash_size, sizeof(uint32_t));
+
+    for (uint32_t c = 0; c < count; c++) {
+        uint8_t *p = mem_snapshot_page(c);
+        uint32_t dup = 0;
+
+        if (mem_snapshot_zero(p)) {
+            zeroes++;
+            continue;
+        }
+
+        if (zeroes) {
+            type = MEM_SNAP_ZERO;
+            snapshot_var(snap, type);
+            snapshot_var(snap, zeroes);
+            zeroes = 0;
+        }
+
+        if (hash_tab != NULL) {
+            uint32_t slot = mem_snapshot_hash(p) & (hash_size - 1);
+
+            while (hash_tab[slot]) {
+                if (!memcmp(mem_snapshot_page(hash_tab[slot] - 1), p, 4096)) {
+                    dup = hash_tab[slot];
+                    break;
+                }
+                slot = (slot + 1) & (hash_size - 1);
+            }
+            if (!dup)
+                hash_tab[slot] = c + 1;
+        }
+
+        if (dup) {
+            dup--;
+            type = MEM_SNAP_DUP;
+            snapshot_var(snap, type);
+            snapshot_var(snap, dup);
+        } else {
+            type = MEM_SNAP_RAW;
+            snapshot_var(snap, type);
+            snapshot_data(snap, p, 4096);
+        }
+    }
+
+    if (zeroes) {
+        type = MEM_SNAP_ZERO;
+        snapshot_var(snap, type);
+        snapshot_var(snap, zeroes);
+    }
+
+    free(hash_tab);
+}
+
+static void
+mem_snapshot_load(snapshot_t *snap, uint32_t count)
+{
+    uint32_t c = 0;
+    uint32_t val;
+    uint8_t  type;
+
+    while ((c < count) && !snapshot_failed(snap)) {
+        type = 0xff;
+        val  = 0;
+        snapshot_var(snap, type);
+        if (type != MEM_SNAP_RAW)
+            snapshot_var(snap, val);
+
+        if ((type == MEM_SNAP_ZERO) && val && (val <= (count - c))) {
+            /* Reading an untouched page does not make the host back it. */
+            for (; val; val--, c++) {
+                if (!mem_snapshot_zero(mem_snapshot_page(c)))
+                    memset(mem_snapshot_page(c), 0x00, 4096);
+            }
+        } else if ((type == MEM_SNAP_DUP) && (val < c)) {
+            memcpy(mem_snapshot_page(c), mem_snapshot_page(val), 4096);
+            c++;
+        } else if (type == MEM_SNAP_RAW) {
+            snapshot_data(snap, mem_snapshot_page(c), 4096);
+            c++;
+        } else
+            snapshot_error(snap, "Snapshot: bad RAM page record at page %08X\n", c);
+    }
+}
+
+void
+mem_snapshot(snapshot_t *snap)
+{
+    uint32_t count = mem_size >> 2;
+
+    snapshot_var(snap, mem_a20_key);
+    snapshot_var(snap, mem_a20_alt);
+    snapshot_var(snap, mem_a20_state);
+    snapshot_var(snap, rammask);
+
+    if (snapshot_loading(snap)) {
+        mem_snapshot_load(snap, count);
+        mem_invalidate_range(0, (mem_size << 10) - 1);
+        flushmmucache();
+    } else
+        mem_snapshot_save(snap, count);
+}
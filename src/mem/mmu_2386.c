@@ -44,7 +44,7 @@ int    read_type = 4;
 
 /* Set trap for data address breakpoints - 1 = exec, 2 = write, 4 = read. */
 void
-mem_debug_check_addr(uint32_t addr, int flags)
+(mem_debug_check_addr)(uint32_t addr, int flags)
 {
     uint32_t bp_addr;
     uint32_t bp_mask;
@@ -86,7 +86,7 @@ mem_readb_map(uint32_t addr)
     mem_logical_addr = 0xffffffff;
 
     if (map && map->read_b)
-        ret = map->read_b(addr, map->priv);
+        ret = mem_map_read_b(map, addr);
 
     return ret;
 }
@@ -100,7 +100,7 @@ mem_readw_map(uint32_t addr)
     mem_logical_addr = 0xffffffff;
 
     if (((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_HBOUND) && (map && map->read_w))
-        ret = map->read_w(addr, map->priv);
+        ret = mem_map_read_w(map, addr);
     else {
         ret = mem_readb_phys(addr + 1) << 8;
         ret |= mem_readb_phys(addr);
@@ -118,7 +118,7 @@ mem_readl_map(uint32_t addr)
     mem_logical_addr = 0xffffffff;
 
     if (!cpu_16bitbus && ((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_QBOUND) && (map && map->read_l))
-        ret = map->read_l(addr, map->priv);
+        ret = mem_map_read_l(map, addr);
     else {
         ret = mem_readw_phys(addr + 2) << 16;
         ret |= mem_readw_phys(addr);
@@ -135,7 +135,7 @@ mem_writeb_map(uint32_t addr, uint8_t val)
     mem_logical_addr = 0xffffffff;
 
     if (map && map->write_b)
-        map->write_b(addr, val, map->priv);
+        mem_map_write_b(map, addr, val);
 }
 
 void
@@ -146,7 +146,7 @@ mem_writew_map(uint32_t addr, uint16_t val)
     mem_logical_addr = 0xffffffff;
 
     if (((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_HBOUND) && (map && map->write_w))
-        map->write_w(addr, val, map->priv);
+        mem_map_write_w(map, addr, val);
     else {
         mem_writeb_phys(addr, val & 0xff);
         mem_writeb_phys(addr + 1, val >> 8);
@@ -161,7 +161,7 @@ mem_writel_map(uint32_t addr, uint32_t val)
     mem_logical_addr = 0xffffffff;
 
     if (!cpu_16bitbus && ((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_QBOUND) && (map && map->write_l))
-         map->write_l(addr, val, map->priv);
+         mem_map_write_l(map, addr, val);
     else {
         mem_writew_phys(addr, val & 0xffff);
         mem_writew_phys(addr + 2, val >> 16);
@@ -273,6 +273,35 @@ mmutranslate_noabrt_2386(uint32_t addr, int rw)
     return (uint64_t) ((temp & ~0xfff) + (addr & 0xfff));
 }
 
+/*
+ * Look up the page holding a code fetch, for the fetch cache of the 286/386
+ * interpreter. Only plain RAM is cached, so that a direct load returns the
+ * same as the read handler would; anything else returns NULL and is fetched
+ * through the normal path. The page walk is done here, so a fault is raised
+ * and the accessed bit set exactly as on the first uncached fetch.
+ */
+uint8_t *
+getpccache_2386(uint32_t a)
+{
+    mem_mapping_t *map;
+    uint64_t       a64 = (uint64_t) a;
+
+    if (cr0 >> 31) {
+        a64 = mmutranslate_read_2386(a);
+
+        if (a64 > 0xffffffffULL)
+            return NULL;
+    }
+    a64 &= rammask;
+
+    map = read_mapping[a64 >> MEM_GRANULARITY_BITS];
+    if ((map == NULL) || (map->read_l != mem_read_raml) || (a64 >= mem_size * 1024ULL) ||
+        (_mem_exec[a64 >> MEM_GRANULARITY_BITS] != &ram[a64 & ~0xfffULL]))
+        return NULL;
+
+    return &ram[a64 & ~0xfffULL];
+}
+
 uint8_t
 readmembl_2386(uint32_t addr)
 {
@@ -298,7 +327,7 @@ readmembl_2386(uint32_t addr)
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->read_b)
-        return map->read_b(addr, map->priv);
+        return mem_map_read_b(map, addr);
 
     return 0xff;
 }
@@ -328,7 +357,7 @@ writemembl_2386(uint32_t addr, uint8_t val)
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->write_b)
-        map->write_b(addr, val, map->priv);
+        mem_map_write_b(map, addr, val);
 }
 
 /* Read a byte from memory without MMU translation - result of previous MMU translation passed as value. */
@@ -351,7 +380,7 @@ readmembl_no_mmut_2386(uint32_t addr, uint32_t a64)
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->read_b)
-        return map->read_b(addr, map->priv);
+        return mem_map_read_b(map, addr);
 
     return 0xff;
 }
@@ -376,7 +405,7 @@ writemembl_no_mmut_2386(uint32_t addr, uint32_t a64, uint8_t val)
 
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->write_b)
-        map->write_b(addr, val, map->priv);
+        mem_map_write_b(map, addr, val);
 }
 
 uint16_t
@@ -428,10 +457,10 @@ readmemwl_2386(uint32_t addr)
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv);
+        return mem_map_read_w(map, addr);
 
     if (map && map->read_b) {
-        return map->read_b(addr, map->priv) | ((uint16_t) (map->read_b(addr + 1, map->priv)) << 8);
+        return mem_map_read_b(map, addr) | ((uint16_t) (mem_map_read_b(map, addr + 1)) << 8);
     }
 
     return 0xffff;
@@ -492,13 +521,13 @@ writememwl_2386(uint32_t addr, uint16_t val)
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
+        mem_map_write_w(map, addr, val);
         return;
     }
 
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
+        mem_map_write_b(map, addr, val);
+        mem_map_write_b(map, addr + 1, val >> 8);
         return;
     }
 }
@@ -538,10 +567,10 @@ readmemwl_no_mmut_2386(uint32_t addr, uint32_t *a64)
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv);
+        return mem_map_read_w(map, addr);
 
     if (map && map->read_b) {
-        return map->read_b(addr, map->priv) | ((uint16_t) (map->read_b(addr + 1, map->priv)) << 8);
+        return mem_map_read_b(map, addr) | ((uint16_t) (mem_map_read_b(map, addr + 1)) << 8);
     }
 
     return 0xffff;
@@ -583,13 +612,13 @@ writememwl_no_mmut_2386(uint32_t addr, uint32_t *a64, uint16_t val)
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
+        mem_map_write_w(map, addr, val);
         return;
     }
 
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
+        mem_map_write_b(map, addr, val);
+        mem_map_write_b(map, addr + 1, val >> 8);
         return;
     }
 }
@@ -657,13 +686,13 @@ readmemll_2386(uint32_t addr)
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->read_l)
-        return map->read_l(addr, map->priv);
+        return mem_map_read_l(map, addr);
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv) | ((uint32_t) (map->read_w(addr + 2, map->priv)) << 16);
+        return mem_map_read_w(map, addr) | ((uint32_t) (mem_map_read_w(map, addr + 2)) << 16);
 
     if (map && map->read_b)
-        return map->read_b(addr, map->priv) | ((uint32_t) (map->read_b(addr + 1, map->priv)) << 8) | ((uint32_t) (map->read_b(addr + 2, map->priv)) << 16) | ((uint32_t) (map->read_b(addr + 3, map->priv)) << 24);
+        return mem_map_read_b(map, addr) | ((uint32_t) (mem_map_read_b(map, addr + 1)) << 8) | ((uint32_t) (mem_map_read_b(map, addr + 2)) << 16) | ((uint32_t) (mem_map_read_b(map, addr + 3)) << 24);
 
     return 0xffffffff;
 }
@@ -736,19 +765,19 @@ writememll_2386(uint32_t addr, uint32_t val)
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->write_l) {
-        map->write_l(addr, val, map->priv);
+        mem_map_write_l(map, addr, val);
         return;
     }
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
-        map->write_w(addr + 2, val >> 16, map->priv);
+        mem_map_write_w(map, addr, val);
+        mem_map_write_w(map, addr + 2, val >> 16);
         return;
     }
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
-        map->write_b(addr + 2, val >> 16, map->priv);
-        map->write_b(addr + 3, val >> 24, map->priv);
+        mem_map_write_b(map, addr, val);
+        mem_map_write_b(map, addr + 1, val >> 8);
+        mem_map_write_b(map, addr + 2, val >> 16);
+        mem_map_write_b(map, addr + 3, val >> 24);
         return;
     }
 }
@@ -788,13 +817,13 @@ readmemll_no_mmut_2386(uint32_t addr, uint32_t *a64)
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->read_l)
-        return map->read_l(addr, map->priv);
+        return mem_map_read_l(map, addr);
 
     if (map && map->read_w)
-        return map->read_w(addr, map->priv) | ((uint32_t) (map->read_w(addr + 2, map->priv)) << 16);
+        return mem_map_read_w(map, addr) | ((uint32_t) (mem_map_read_w(map, addr + 2)) << 16);
 
     if (map && map->read_b)
-        return map->read_b(addr, map->priv) | ((uint32_t) (map->read_b(addr + 1, map->priv)) << 8) | ((uint32_t) (map->read_b(addr + 2, map->priv)) << 16) | ((uint32_t) (map->read_b(addr + 3, map->priv)) << 24);
+        return mem_map_read_b(map, addr) | ((uint32_t) (mem_map_read_b(map, addr + 1)) << 8) | ((uint32_t) (mem_map_read_b(map, addr + 2)) << 16) | ((uint32_t) (mem_map_read_b(map, addr + 3)) << 24);
 
     return 0xffffffff;
 }
@@ -835,19 +864,19 @@ writememll_no_mmut_2386(uint32_t addr, uint32_t *a64, uint32_t val)
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->write_l) {
-        map->write_l(addr, val, map->priv);
+        mem_map_write_l(map, addr, val);
         return;
     }
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
-        map->write_w(addr + 2, val >> 16, map->priv);
+        mem_map_write_w(map, addr, val);
+        mem_map_write_w(map, addr + 2, val >> 16);
         return;
     }
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
-        map->write_b(addr + 2, val >> 16, map->priv);
-        map->write_b(addr + 3, val >> 24, map->priv);
+        mem_map_write_b(map, addr, val);
+        mem_map_write_b(map, addr + 1, val >> 8);
+        mem_map_write_b(map, addr + 2, val >> 16);
+        mem_map_write_b(map, addr + 3, val >> 24);
         return;
     }
 }
@@ -913,7 +942,7 @@ readmemql_2386(uint32_t addr)
 
     map = read_mapping[addr >> MEM_GRANULARITY_BITS];
     if (map && map->read_l)
-        return map->read_l(addr, map->priv) | ((uint64_t) map->read_l(addr + 4, map->priv) << 32);
+        return mem_map_read_l(map, addr) | ((uint64_t) mem_map_read_l(map, addr + 4) << 32);
 
     return readmemll(addr) | ((uint64_t) readmemll(addr + 4) << 32);
 }
@@ -983,26 +1012,26 @@ writememql_2386(uint32_t addr, uint64_t val)
     map = write_mapping[addr >> MEM_GRANULARITY_BITS];
 
     if (map && map->write_l) {
-        map->write_l(addr, val, map->priv);
-        map->write_l(addr + 4, val >> 32, map->priv);
+        mem_map_write_l(map, addr, val);
+        mem_map_write_l(map, addr + 4, val >> 32);
         return;
     }
     if (map && map->write_w) {
-        map->write_w(addr, val, map->priv);
-        map->write_w(addr + 2, val >> 16, map->priv);
-        map->write_w(addr + 4, val >> 32, map->priv);
-        map->write_w(addr + 6, val >> 48, map->priv);
+        mem_map_write_w(map, addr, val);
+        mem_map_write_w(map, addr + 2, val >> 16);
+        mem_map_write_w(map, addr + 4, val >> 32);
+        mem_map_write_w(map, addr + 6, val >> 48);
         return;
     }
     if (map && map->write_b) {
-        map->write_b(addr, val, map->priv);
-        map->write_b(addr + 1, val >> 8, map->priv);
-        map->write_b(addr + 2, val >> 16, map->priv);
-        map->write_b(addr + 3, val >> 24, map->priv);
-        map->write_b(addr + 4, val >> 32, map->priv);
-        map->write_b(addr + 5, val >> 40, map->priv);
-        map->write_b(addr + 6, val >> 48, map->priv);
-        map->write_b(addr + 7, val >> 56, map->priv);
+        mem_map_write_b(map, addr, val);
+        mem_map_write_b(map, addr + 1, val >> 8);
+        mem_map_write_b(map, addr + 2, val >> 16);
+        mem_map_write_b(map, addr + 3, val >> 24);
+        mem_map_write_b(map, addr + 4, val >> 32);
+        mem_map_write_b(map, addr + 5, val >> 40);
+        mem_map_write_b(map, addr + 6, val >> 48);
+        mem_map_write_b(map, addr + 7, val >> 56);
         return;
     }
 }
@@ -28,6 +28,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <wchar.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include "cpu.h"
@@ -35,6 +38,7 @@
 #include <86box/rom.h>
 #include <86box/path.h>
 #include <86box/plat.h>
+#include <86box/plat_dir.h>
 #include <86box/machine.h>
 #include <86box/m_xt_xi8088.h>
 
@@ -56,6 +60,220 @@ rom_log(const char *fmt, ...)
 #    define rom_log(fmt, ...)
 #endif
 
+/* Cache of "roms/..." names that were found, and where. Every machine and
+   device availability check probes its images across all the ROM paths, and
+   those checks are repeated on every settings dialog and hard reset, so only
+   the first probe of each image needs to touch the file system.
+
+   Misses are cached as well, as most machines and cards in the tables have
+   no images installed. They are dropped whenever the modification time of a
+   ROM path or of one of its immediate subdirectories (roms/machines,
+   roms/video and so on) changes, which is checked at most once a second, so
+   that image sets added while running are still picked up.
+
+   Images that are actually loaded also keep their contents, so that a hard
+   reset copies them from memory; the size and modification time are checked
+   on every load and the image is read again if either has changed. */
+#define ROM_CACHE_BUCKETS  1024
+#define ROM_CACHE_MAX_SIZE (16 * 1024 * 1024)
+
+typedef struct rom_cache_t {
+    char               *name;
+    char               *path;
+    uint8_t            *data;
+    long                size;
+    time_t              mtime;
+    struct rom_cache_t *next;
+} rom_cache_t;
+
+typedef struct rom_miss_t {
+    struct rom_miss_t *next;
+    char               name[];
+} rom_miss_t;
+
+static rom_cache_t *rom_cache[ROM_CACHE_BUCKETS];
+static rom_miss_t  *rom_misses[ROM_CACHE_BUCKETS];
+static uint32_t     rom_misses_sig;
+static time_t       rom_misses_checked;
+
+static uint32_t
+rom_cache_hash(const char *fn)
+{
+    uint32_t hash = 0x811c9dc5;
+
+    while (*fn)
+        hash = (hash ^ (uint8_t) *fn++) * 0x01000193;
+
+    return hash & (ROM_CACHE_BUCKETS - 1);
+}
+
+static rom_cache_t *
+rom_cache_find(const char *fn)
+{
+    for (rom_cache_t *entry = rom_cache[rom_cache_hash(fn)]; entry != NULL; entry = entry->next) {
+        if (!strcmp(entry->name, fn))
+            return entry;
+    }
+
+    return NULL;
+}
+
+static void
+rom_cache_add(const char *fn, const char *path)
+{
+    uint32_t     hash = rom_cache_hash(fn);
+    rom_cache_t *entry;
+
+    if (rom_cache_find(fn) != NULL)
+        return;
+
+    entry = calloc(1, sizeof(rom_cache_t));
+    if (entry == NULL)
+        return;
+
+    entry->name = strdup(fn);
+    entry->path = strdup(path);
+    if ((entry->name == NULL) || (entry->path == NULL)) {
+        free(entry->name);
+        free(entry->path);
+        free(entry);
+        return;
+    }
+
+    entry->next     = rom_cache[hash];
+    rom_cache[hash] = entry;
+}
+
+static void
+rom_cache_remove(const char *fn)
+{
+    rom_cache_t **prev = &rom_cache[rom_cache_hash(fn)];
+
+    for (rom_cache_t *entry = *prev; entry != NULL; prev = &entry->next, entry = entry->next) {
+        if (!strcmp(entry->name, fn)) {
+            *prev = entry->next;
+            free(entry->name);
+            free(entry->path);
+            free(entry->data);
+            free(entry);
+            return;
+        }
+    }
+}
+
+static void
+rom_miss_flush(void)
+{
+    rom_miss_t *next;
+
+    for (int i = 0; i < ROM_CACHE_BUCKETS; i++) {
+        for (rom_miss_t *miss = rom_misses[i]; miss != NULL; miss = next) {
+            next = miss->next;
+            free(miss);
+        }
+        rom_misses[i] = NULL;
+    }
+}
+
+static uint32_t
+rom_dir_sig(uint32_t sig, const char *path)
+{
+    struct stat st;
+
+    if (stat(path, &st) == 0)
+        sig = (sig ^ (uint32_t) st.st_mtime) * 0x01000193;
+
+    return sig;
+}
+
+/* Sums up the modification times of the ROM paths and their subdirectories. */
+static uint32_t
+rom_paths_sig(void)
+{
+    char           temp[1024];
+    uint32_t       sig = 0x811c9dc5;
+    DIR           *dir;
+    struct dirent *ent;
+
+    for (rom_path_t *rom_path = &rom_paths; rom_path != NULL; rom_path = rom_path->next) {
+        sig = rom_dir_sig(sig, rom_path->path);
+
+        if ((dir = opendir(rom_path->path)) == NULL)
+            continue;
+
+        while ((ent = readdir(dir)) != NULL) {
+            if (ent->d_name[0] == '.')
+                continue;
+
+            path_append_filename(temp, rom_path->path, ent->d_name);
+            sig = rom_dir_sig(sig, temp);
+        }
+
+        closedir(dir);
+    }
+
+    return sig;
+}
+
+static int
+rom_miss_find(const char *fn)
+{
+    time_t   now = time(NULL);
+    uint32_t sig;
+
+    if (now != rom_misses_checked) {
+        rom_misses_checked = now;
+
+        sig = rom_paths_sig();
+        if (sig != rom_misses_sig) {
+            rom_misses_sig = sig;
+            rom_miss_flush();
+            return 0;
+        }
+    }
+
+    for (rom_miss_t *miss = rom_misses[rom_cache_hash(fn)]; miss != NULL; miss = miss->next) {
+        if (!strcmp(miss->name, fn))
+            return 1;
+    }
+
+    return 0;
+}
+
+static void
+rom_miss_add(const char *fn)
+{
+    uint32_t    hash = rom_cache_hash(fn);
+    rom_miss_t *miss = malloc(sizeof(rom_miss_t) + strlen(fn) + 1);
+
+    if (miss == NULL)
+        return;
+
+    strcpy(miss->name, fn);
+    miss->next       = rom_misses[hash];
+    rom_misses[hash] = miss;
+}
+
+void
+rom_cache_flush(void)
+{
+    rom_cache_t *next;
+
+    rom_miss_flush();
+    rom_misses_checked = 0;
+
+    for (int i = 0; i < ROM_CACHE_BUCKETS; i++) {
+        for (rom_cache_t *entry = rom_cache[i]; entry != NULL; entry = next) {
+            next = entry->next;
+            free(entry->name);
+            free(entry->path);
+            free(entry->data);
+            free(entry);
+        }
+        rom_cache[i] = NULL;
+    }
+}
+
 void
 rom_add_path(const char *path)
 {
@@ -84,24 +302,39 @@ rom_add_path(const char *path)
 
     // Ensure the path ends with a separator.
     path_slash(rom_path->path);
+
+    // An earlier path may now be shadowed by the new one.
+    rom_cache_flush();
 }
 
 FILE *
 rom_fopen(const char *fn, char *mode)
 {
-    char        temp[1024];
-    FILE       *fp = NULL;
+    char               temp[1024];
+    FILE              *fp = NULL;
+    const rom_cache_t *entry;
 
     if (strstr(fn, "roms/") == fn) {
         /* Relative path */
+        if ((entry = rom_cache_find(fn)) != NULL) {
+            if ((fp = plat_fopen(entry->path, mode)) != NULL)
+                return fp;
+
+            /* Gone since it was found, search again. */
+            rom_cache_remove(fn);
+        } else if (rom_miss_find(fn))
+            return NULL;
+
         for (rom_path_t *rom_path = &rom_paths; rom_path != NULL; rom_path = rom_path->next) {
             path_append_filename(temp, rom_path->path, fn + 5);
 
             if ((fp = plat_fopen(temp, mode)) != NULL) {
+                rom_cache_add(fn, temp);
                 return fp;
             }
         }
 
+        rom_miss_add(fn);
         return fp;
     } else {
         /* Absolute path */
@@ -112,10 +345,19 @@ rom_fopen(const char *fn, char *mode)
 int
 rom_getfile(char *fn, char *s, int size)
 {
-    char        temp[1024];
+    char               temp[1024];
+    const rom_cache_t *entry;
 
     if (strstr(fn, "roms/") == fn) {
         /* Relative path */
+        if ((entry = rom_cache_find(fn)) != NULL) {
+            strncpy(s, entry->path, size);
+            return 1;
+        }
+
+        if (rom_miss_find(fn))
+            return 0;
+
         for (rom_path_t *rom_path = &rom_paths; rom_path != NULL; rom_path = rom_path->next) {
             path_append_filename(temp, rom_path->path, fn + 5);
 
@@ -125,6 +367,7 @@ rom_getfile(char *fn, char *s, int size)
             }
         }
 
+        rom_miss_add(fn);
         return 0;
     } else {
         /* Absolute path */
@@ -142,6 +385,9 @@ rom_present(const char *fn)
 {
     FILE *fp;
 
+    if ((strstr(fn, "roms/") == fn) && (rom_cache_find(fn) != NULL))
+        return 1;
+
     fp = rom_fopen(fn, "rb");
     if (fp != NULL) {
         (void) fclose(fp);
@@ -151,6 +397,66 @@ rom_present(const char *fn)
     return 0;
 }
 
+/* Return the cached contents of a roms/ image, reading it in if it is not
+   cached yet or has changed on disk. NULL means use the file directly. */
+static const rom_cache_t *
+rom_cache_image(const char *fn)
+{
+    rom_cache_t *entry;
+    struct stat  st;
+    FILE        *fp;
+
+    if ((strstr(fn, "roms/") != fn) || !rom_present(fn) || ((entry = rom_cache_find(fn)) == NULL))
+        return NULL;
+
+    if (stat(entry->path, &st) != 0) {
+        rom_cache_remove(fn);
+        return NULL;
+    }
+
+    if ((entry->data != NULL) && (entry->size == (long) st.st_size) && (entry->mtime == st.st_mtime))
+        return entry;
+
+    free(entry->data);
+    entry->data = NULL;
+
+    if ((st.st_size <= 0) || (st.st_size > ROM_CACHE_MAX_SIZE))
+        return NULL;
+
+    if ((entry->data = malloc(st.st_size)) == NULL)
+        return NULL;
+
+    fp = plat_fopen(entry->path, "rb");
+    if ((fp == NULL) || (fread(entry->data, 1, st.st_size, fp) != (size_t) st.st_size)) {
+        if (fp != NULL)
+            (void) fclose(fp);
+        free(entry->data);
+        entry->data = NULL;
+        return NULL;
+    }
+    (void) fclose(fp);
+
+    entry->size  = (long) st.st_size;
+    entry->mtime = st.st_mtime;
+    rom_log("ROM: cached image '%s' (%li bytes)\n", fn, entry->size);
+
+    return entry;
+}
+
+/* Copy up to len bytes at off from a cached image, like fseek() + fread(). */
+static int
+rom_cache_copy(const rom_cache_t *entry, long off, uint8_t *dst, int len)
+{
+    if ((off < 0) || (off >= entry->size) || (len <= 0))
+        return 0;
+
+    if (len > (entry->size - off))
+        len = entry->size - off;
+    memcpy(dst, &entry->data[off], len);
+
+    return len;
+}
+
 uint8_t
 rom_read(uint32_t addr, void *priv)
 {
@@ -205,12 +511,12 @@ rom_readl(uint32_t addr, void *priv)
 int
 rom_load_linear_oddeven(const char *fn, uint32_t addr, int sz, int off, uint8_t *ptr)
 {
-    FILE *fp = rom_fopen(fn, "rb");
+    FILE              *fp;
+    const rom_cache_t *entry;
 
-    if (fp == NULL) {
-        rom_log("ROM: image '%s' not found\n", fn);
-        return 0;
-    }
+    /* Availability check only. */
+    if (ptr == NULL)
+        return rom_present(fn);
 
     /* Make sure we only look at the base-256K offset. */
     if (addr >= 0x40000)
@@ -218,6 +524,23 @@ rom_load_linear_oddeven(const char *fn, uint32_t addr, int sz, int off, uint8_t
     else
         addr &= 0x03ffff;
 
+    if ((entry = rom_cache_image(fn)) != NULL) {
+        if ((off < 0) || ((off + ((sz >> 1) << 1)) > entry->size))
+            fatal("rom_load_linear(): Error reading data\n");
+        for (int i = 0; i < (sz >> 1); i++) {
+            ptr[addr + (i << 1)]     = entry->data[off + i];
+            ptr[addr + (i << 1) + 1] = entry->data[off + (sz >> 1) + i];
+        }
+        return 1;
+    }
+
+    fp = rom_fopen(fn, "rb");
+
+    if (fp == NULL) {
+        rom_log("ROM: image '%s' not found\n", fn);
+        return 0;
+    }
+
     if (ptr != NULL) {
         if (fseek(fp, off, SEEK_SET) == -1)
             fatal("rom_load_linear(): Error seeking to the beginning of the file\n");
@@ -240,12 +563,12 @@ rom_load_linear_oddeven(const char *fn, uint32_t addr, int sz, int off, uint8_t
 int
 rom_load_linear(const char *fn, uint32_t addr, int sz, int off, uint8_t *ptr)
 {
-    FILE *fp = rom_fopen(fn, "rb");
+    FILE              *fp;
+    const rom_cache_t *entry;
 
-    if (fp == NULL) {
-        rom_log("ROM: image '%s' not found\n", fn);
-        return 0;
-    }
+    /* Availability check only. */
+    if (ptr == NULL)
+        return rom_present(fn);
 
     /* Make sure we only look at the base-256K offset. */
     if (addr >= 0x40000)
@@ -253,6 +576,18 @@ rom_load_linear(const char *fn, uint32_t addr, int sz, int off, uint8_t *ptr)
     else
         addr &= 0x03ffff;
 
+    if ((entry = rom_cache_image(fn)) != NULL) {
+        (void) rom_cache_copy(entry, off, ptr + addr, sz);
+        return 1;
+    }
+
+    fp = rom_fopen(fn, "rb");
+
+    if (fp == NULL) {
+        rom_log("ROM: image '%s' not found\n", fn);
+        return 0;
+    }
+
     if (ptr != NULL) {
         if (fseek(fp, off, SEEK_SET) == -1)
             fatal("rom_load_linear(): Error seeking to the beginning of the file\n");
@@ -313,8 +648,33 @@ rom_load_linear_inverted(const char *fn, uint32_t addr, int sz, int off, uint8_t
 int
 rom_load_interleaved(const char *fnl, const char *fnh, uint32_t addr, int sz, int off, uint8_t *ptr)
 {
-    FILE *fpl = rom_fopen(fnl, "rb");
-    FILE *fph = rom_fopen(fnh, "rb");
+    FILE              *fpl;
+    FILE              *fph;
+    const rom_cache_t *entl;
+    const rom_cache_t *enth;
+
+    /* Availability check only. */
+    if (ptr == NULL)
+        return rom_present(fnl) && rom_present(fnh);
+
+    if (((entl = rom_cache_image(fnl)) != NULL) && ((enth = rom_cache_image(fnh)) != NULL)) {
+        if (addr >= 0x40000)
+            addr = 0;
+        else
+            addr &= 0x03ffff;
+
+        /* Past the end of either image reads as 0xff, as with fgetc(). */
+        for (int c = 0; c < sz; c += 2) {
+            long pos = off + (c >> 1);
+
+            ptr[addr + c]     = ((pos >= 0) && (pos < entl->size)) ? entl->data[pos] : 0xff;
+            ptr[addr + c + 1] = ((pos >= 0) && (pos < enth->size)) ? enth->data[pos] : 0xff;
+        }
+        return 1;
+    }
+
+    fpl = rom_fopen(fnl, "rb");
+    fph = rom_fopen(fnh, "rb");
 
     if (fpl == NULL || fph == NULL) {
         if (fpl == NULL)
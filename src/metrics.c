@@ -0,0 +1,209 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Emulation speed metrics.
+ *
+ *          Once a second, one JSON object per line is appended to
+ *          metrics.jsonl in the machine directory, carrying what the
+ *          emulator did over the last second: speed relative to real
+ *          time, emulated clock rate, recompiled blocks and code cache
+ *          use, TLB flushes, timer callbacks, I/O port accesses, disk
+ *          and CD-ROM bytes, network packets, SVGA timing recalculations,
+ *          audio underruns and blit times.
+ *
+ *          Meant to be tailed by whatever watches a set of machines, so
+ *          every line stands on its own and is flushed as written. Phase
+ *          markers sent by the guest through the unit tester device get
+ *          lines of their own, as they come.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/timer.h>
+#include <86box/path.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/sound.h>
+#include <86box/metrics.h>
+#include <cJSON.h>
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+#    include "codegen_allocator.h"
+#endif
+
+#define METRICS_FILE "metrics.jsonl"
+
+int                metrics_enabled = 0;
+metrics_counters_t metrics;
+
+static FILE    *metrics_fp;
+static mutex_t *metrics_mutex;
+
+/* Totals at the previous report. */
+static metrics_counters_t metrics_last;
+static uint64_t           metrics_last_tsc;
+static uint64_t           metrics_last_timer_fires;
+static uint64_t           metrics_last_underruns;
+
+void
+metrics_init(void)
+{
+    char path[1024];
+
+    if (!metrics_enabled || (metrics_fp != NULL))
+        return;
+
+    path_append_filename(path, usr_path, METRICS_FILE);
+    metrics_fp = plat_fopen(path, "a");
+    if (metrics_fp == NULL) {
+        pclog("METRICS: unable to open %s\n", path);
+        return;
+    }
+
+    /* Kept for good, the UI thread may still be about to report. */
+    if (metrics_mutex == NULL)
+        metrics_mutex = thread_create_mutex();
+
+    metrics_last             = metrics;
+    metrics_last_tsc         = tsc;
+    metrics_last_timer_fires = timer_total_fires;
+    metrics_last_underruns   = sound_underruns;
+}
+
+static double
+metrics_delta(uint64_t now, uint64_t *last)
+{
+    /* Counters are cleared on hard reset, start over rather than go negative. */
+    uint64_t delta = (now >= *last) ? (now - *last) : now;
+
+    *last = now;
+    return (double) delta;
+}
+
+static void
+metrics_write(cJSON *obj)
+{
+    char *line = cJSON_PrintUnformatted(obj);
+
+    if (line != NULL) {
+        fputs(line, metrics_fp);
+        fputc('\n', metrics_fp);
+        fflush(metrics_fp);
+        cJSON_free(line);
+    }
+}
+
+/* Called once a second, from the UI thread; speed is the 10 ms slices run. */
+void
+metrics_onesec(int speed)
+{
+    metrics_counters_t now = metrics;
+    uint64_t           blits;
+    double             blit_us;
+    cJSON             *obj;
+
+    if (metrics_mutex == NULL)
+        return;
+
+    thread_wait_mutex(metrics_mutex);
+    if (metrics_fp == NULL) {
+        thread_release_mutex(metrics_mutex);
+        return;
+    }
+
+    obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(obj, "time", (double) time(NULL));
+    cJSON_AddNumberToObject(obj, "speed", speed);
+    cJSON_AddNumberToObject(obj, "emulated_mhz", metrics_delta(tsc, &metrics_last_tsc) / 1000000.0);
+
+    cJSON_AddNumberToObject(obj, "dynarec_blocks", metrics_delta(now.dynarec_blocks, &metrics_last.dynarec_blocks));
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    if (codegen_allocator_size)
+        cJSON_AddNumberToObject(obj, "dynarec_cache_percent", (codegen_allocator_usage * 100.0) / codegen_allocator_size);
+#endif
+
+    cJSON_AddNumberToObject(obj, "mmu_flushes", metrics_delta(now.mmu_flushes, &metrics_last.mmu_flushes));
+    cJSON_AddNumberToObject(obj, "mmu_range_flushes", metrics_delta(now.mmu_range_flushes, &metrics_last.mmu_range_flushes));
+
+    cJSON_AddNumberToObject(obj, "timer_callbacks", metrics_delta(timer_total_fires, &metrics_last_timer_fires));
+    cJSON_AddNumberToObject(obj, "io_accesses", metrics_delta(now.io_accesses, &metrics_last.io_accesses));
+
+    cJSON_AddNumberToObject(obj, "disk_read_bytes", metrics_delta(now.disk_read_bytes, &metrics_last.disk_read_bytes));
+    cJSON_AddNumberToObject(obj, "disk_write_bytes", metrics_delta(now.disk_write_bytes, &metrics_last.disk_write_bytes));
+    cJSON_AddNumberToObject(obj, "cdrom_read_bytes", metrics_delta(now.cdrom_read_bytes, &metrics_last.cdrom_read_bytes));
+
+    cJSON_AddNumberToObject(obj, "net_rx_packets", metrics_delta(now.net_rx_packets, &metrics_last.net_rx_packets));
+    cJSON_AddNumberToObject(obj, "net_tx_packets", metrics_delta(now.net_tx_packets, &metrics_last.net_tx_packets));
+
+    cJSON_AddNumberToObject(obj, "svga_recalcs", metrics_delta(now.svga_recalcs, &metrics_last.svga_recalcs));
+
+    cJSON_AddNumberToObject(obj, "audio_underruns", metrics_delta(sound_underruns, &metrics_last_underruns));
+
+    blits   = (uint64_t) metrics_delta(now.blits, &metrics_last.blits);
+    blit_us = metrics_delta(now.blit_us, &metrics_last.blit_us);
+    cJSON_AddNumberToObject(obj, "blits", (double) blits);
+    cJSON_AddNumberToObject(obj, "blit_avg_ms", blits ? ((blit_us / blits) / 1000.0) : 0.0);
+
+    metrics_write(obj);
+    cJSON_Delete(obj);
+
+    thread_release_mutex(metrics_mutex);
+}
+
+/* Called from the emulation thread when the guest marks a phase. */
+void
+metrics_phase(uint8_t phase, int stop, double host_ms, double cpu_ms, double clocks)
+{
+    cJSON *obj;
+
+    if (metrics_mutex == NULL)
+        return;
+
+    thread_wait_mutex(metrics_mutex);
+    if (metrics_fp == NULL) {
+        thread_release_mutex(metrics_mutex);
+        return;
+    }
+
+    obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(obj, "time", (double) time(NULL));
+    cJSON_AddNumberToObject(obj, "phase", phase);
+    cJSON_AddStringToObject(obj, "event", stop ? "stop" : "start");
+    if (stop) {
+        cJSON_AddNumberToObject(obj, "host_ms", host_ms);
+        cJSON_AddNumberToObject(obj, "host_cpu_ms", cpu_ms);
+        cJSON_AddNumberToObject(obj, "emulated_clocks", clocks);
+    }
+    metrics_write(obj);
+    cJSON_Delete(obj);
+
+    thread_release_mutex(metrics_mutex);
+}
+
+void
+metrics_close(void)
+{
+    if (metrics_mutex == NULL)
+        return;
+
+    thread_wait_mutex(metrics_mutex);
+    if (metrics_fp != NULL)
+        fclose(metrics_fp);
+    metrics_fp = NULL;
+    thread_release_mutex(metrics_mutex);
+}
@@ -141,6 +141,104 @@ dp8390_chipmem_write(dp8390_t *dev, uint32_t addr, uint32_t val, unsigned len)
     }
 }
 
+/*
+ * Bulk remote DMA, for the data port block handlers. Moves up to len
+ * bytes between buf and buffer memory in units of step bytes, bumping
+ * the remote DMA address (with the page_stop to page_start wrap) and
+ * the byte count just as the same run of single accesses would. The
+ * transfer stops short at the end of the byte count, outside buffer
+ * memory or where a unit would straddle the ring end, and returns the
+ * number of bytes moved; the rest is left to single accesses.
+ */
+static int
+dp8390_remote_chunk(const dp8390_t *dev, int len, int step)
+{
+    uint32_t addr = dev->remote_dma;
+    uint32_t stop = dev->page_stop << 8;
+    uint32_t n    = MIN((uint32_t) len, dev->remote_bytes);
+
+    if ((addr < dev->mem_start) || (addr >= dev->mem_end))
+        return 0;
+
+    n = MIN(n, dev->mem_end - addr);
+    if (addr < stop)
+        n = MIN(n, stop - addr);
+
+    return n - (n % step);
+}
+
+static void
+dp8390_remote_advance(dp8390_t *dev, int n)
+{
+    dev->remote_dma += n;
+    if (dev->remote_dma == (dev->page_stop << 8))
+        dev->remote_dma = dev->page_start << 8;
+
+    dev->remote_bytes -= n;
+}
+
+static void
+dp8390_remote_done(dp8390_t *dev)
+{
+    /* If all bytes have been moved, signal remote-DMA complete. */
+    if (dev->remote_bytes == 0) {
+        dev->ISR.rdma_done = 1;
+        if (dev->IMR.rdma_inte && dev->interrupt)
+            dev->interrupt(dev->priv, 1);
+    }
+}
+
+int
+dp8390_remote_read(dp8390_t *dev, uint8_t *buf, int len, int step)
+{
+    int done = 0;
+    int n;
+
+    while ((done < len) && (n = dp8390_remote_chunk(dev, len - done, step)) > 0) {
+        memcpy(buf + done, &dev->mem[dev->remote_dma - dev->mem_start], n);
+        dp8390_remote_advance(dev, n);
+        done += n;
+    }
+
+    if (done)
+        dp8390_remote_done(dev);
+
+    return done;
+}
+
+int
+dp8390_remote_write(dp8390_t *dev, const uint8_t *buf, int len, int step)
+{
+    int done = 0;
+    int n;
+
+    while ((done < len) && (n = dp8390_remote_chunk(dev, len - done, step)) > 0) {
+        memcpy(&dev->mem[dev->remote_dma - dev->mem_start], buf + done, n);
+        dp8390_remote_advance(dev, n);
+        done += n;
+    }
+
+    if (done)
+        dp8390_remote_done(dev);
+
+    return done;
+}
+
+/*
+ * Copy into the receive ring at buffer memory address addr, wrapping
+ * from page_stop back to page_start.
+ */
+static void
+dp8390_ring_write(dp8390_t *dev, uint32_t addr, const uint8_t *buf, int len)
+{
+    uint32_t stop = dev->page_stop << 8;
+    int      n    = MIN((uint32_t) len, stop - addr);
+
+    memcpy(&dev->mem[addr - dev->mem_start], buf, n);
+    if (n < len)
+        memcpy(&dev->mem[(dev->page_start << 8) - dev->mem_start], buf + n, len - n);
+}
+
 /* Routines for handling reads/writes to the Command Register. */
 uint32_t
 dp8390_read_cr(dp8390_t *dev)
@@ -267,12 +365,10 @@ dp8390_rx_common(void *priv, uint8_t *buf, int io_len)
     dp8390_t      *dev           = (dp8390_t *) priv;
     static uint8_t bcast_addr[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
     uint8_t        pkthdr[4];
-    uint8_t       *startptr;
     int            pages;
     int            avail;
     int            idx;
     int            nextpage;
-    int            endbytes;
 
     if (io_len != 60)
         dp8390_log("rx_frame with length %d\n", io_len);
@@ -384,16 +480,8 @@ dp8390_rx_common(void *priv, uint8_t *buf, int io_len)
                pkthdr[0], pkthdr[1], pkthdr[2], pkthdr[3]);
 
     /* Copy into buffer, update curpage, and signal interrupt if config'd */
-    startptr = &dev->mem[(dev->curr_page * 256) - dev->mem_start];
-    memcpy(startptr, pkthdr, sizeof(pkthdr));
-    if ((nextpage > dev->curr_page) || ((dev->curr_page + pages) == dev->page_stop)) {
-        memcpy(startptr + sizeof(pkthdr), buf, io_len);
-    } else {
-        endbytes = (dev->page_stop - dev->curr_page) * 256;
-        memcpy(startptr + sizeof(pkthdr), buf, endbytes - sizeof(pkthdr));
-        startptr = &dev->mem[((dev->tx_page_start * 256) - dev->mem_start) & dev->mem_wrap];
-        memcpy(startptr, buf + endbytes - sizeof(pkthdr), io_len - endbytes + 8);
-    }
+    dp8390_ring_write(dev, dev->curr_page << 8, pkthdr, sizeof(pkthdr));
+    dp8390_ring_write(dev, (dev->curr_page << 8) + sizeof(pkthdr), buf, io_len);
     dev->curr_page = nextpage;
 
     dev->RSR.rx_ok   = 1;
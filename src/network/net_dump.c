@@ -0,0 +1,372 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Packet trace of the emulated network cards, in pcapng format.
+ *
+ *          The emulation thread only formats each frame into an Enhanced
+ *          Packet Block in a memory ring; a background thread writes the
+ *          ring out to network.pcapng in the machine directory. Frames are
+ *          dropped rather than waited for if the writer falls behind.
+ *
+ *          Every card slot gets its own interface in the trace, and frames
+ *          are stamped with emulated time, so the trace lines up with what
+ *          the guest saw rather than with host scheduling. With a size
+ *          limit set, the trace is rotated into network.pcapng.1 whenever
+ *          it reaches the limit, keeping at most twice the limit on disk.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <time.h>
+#include <stdbool.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/device.h>
+#include <86box/plat.h>
+#include <86box/path.h>
+#include <86box/thread.h>
+#include <86box/timer.h>
+#include <86box/video.h>
+#include <86box/network.h>
+
+#define NET_DUMP_FILE      "network.pcapng"
+#define NET_DUMP_RING      (1 << 20) /* must be a power of two */
+#define NET_DUMP_RING_MASK (NET_DUMP_RING - 1)
+#define NET_DUMP_KICK      (NET_DUMP_RING / 4) /* wake the writer early past this fill */
+#define NET_DUMP_INTERVAL  100                 /* ms between writer passes */
+
+#define PCAPNG_SHB         0x0a0d0d0a
+#define PCAPNG_IDB         0x00000001
+#define PCAPNG_EPB         0x00000006
+#define PCAPNG_BOM         0x1a2b3c4d
+#define PCAPNG_OPT_IF_NAME 2
+#define PCAPNG_OPT_FLAGS   2
+#define PCAPNG_LINK_ETHER  1
+
+#define PCAPNG_PAD(x)      (((x) + 3) & ~3)
+
+int      net_dump_enabled = 0;
+uint32_t net_dump_snaplen = 0;
+uint32_t net_dump_limit   = 0;
+
+static struct {
+    FILE         *fp;
+    char          path[1024];
+    uint64_t      written;
+
+    thread_t     *thread;
+    event_t      *wake;
+    atomic_bool   stop;
+
+    /* Byte ring of formatted blocks; head is only written by the emulation
+       thread and tail only by the writer thread. */
+    uint8_t      *ring;
+    atomic_uint   head;
+    atomic_uint   tail;
+    uint32_t      dropped;
+
+    uint64_t      last_tsc;
+    uint64_t      time_us;
+} net_dump;
+
+#ifdef ENABLE_NET_DUMP_LOG
+int net_dump_do_log = ENABLE_NET_DUMP_LOG;
+
+static void
+net_dump_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (net_dump_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define net_dump_log(fmt, ...)
+#endif
+
+static void
+net_dump_put32(uint8_t *p, uint32_t val)
+{
+    memcpy(p, &val, sizeof(val));
+}
+
+/* Section header plus one interface per card slot, at the start of each file. */
+static void
+net_dump_header(void)
+{
+    uint8_t  blk[128];
+    char     name[64];
+    uint32_t len;
+    uint32_t name_len;
+    uint16_t val16;
+    int64_t  section_len = -1;
+
+    net_dump_put32(&blk[0], PCAPNG_SHB);
+    net_dump_put32(&blk[4], 28);
+    net_dump_put32(&blk[8], PCAPNG_BOM);
+    val16 = 1;
+    memcpy(&blk[12], &val16, 2);
+    val16 = 0;
+    memcpy(&blk[14], &val16, 2);
+    memcpy(&blk[16], &section_len, 8);
+    net_dump_put32(&blk[24], 28);
+    fwrite(blk, 1, 28, net_dump.fp);
+    net_dump.written = 28;
+
+    for (int i = 0; i < NET_CARD_MAX; i++) {
+        if (net_cards_conf[i].device_num != 0)
+            snprintf(name, sizeof(name), "net_%02i: %s", i + 1,
+                     network_card_get_internal_name(net_cards_conf[i].device_num));
+        else
+            snprintf(name, sizeof(name), "net_%02i", i + 1);
+        name_len = strlen(name);
+
+        len = 16 + 4 + PCAPNG_PAD(name_len) + 4 + 4;
+        memset(blk, 0, len);
+        net_dump_put32(&blk[0], PCAPNG_IDB);
+        net_dump_put32(&blk[4], len);
+        val16 = PCAPNG_LINK_ETHER;
+        memcpy(&blk[8], &val16, 2);
+        net_dump_put32(&blk[12], net_dump_snaplen);
+        val16 = PCAPNG_OPT_IF_NAME;
+        memcpy(&blk[16], &val16, 2);
+        val16 = name_len;
+        memcpy(&blk[18], &val16, 2);
+        memcpy(&blk[20], name, name_len);
+        net_dump_put32(&blk[len - 4], len);
+        fwrite(blk, 1, len, net_dump.fp);
+        net_dump.written += len;
+    }
+}
+
+static int
+net_dump_open_file(void)
+{
+    net_dump.fp = plat_fopen(net_dump.path, "wb");
+    if (net_dump.fp == NULL) {
+        net_dump_log("NET_DUMP: unable to open %s\n", net_dump.path);
+        return 0;
+    }
+
+    net_dump_header();
+    return 1;
+}
+
+static void
+net_dump_rotate(void)
+{
+    char old[1024 + 2];
+
+    fclose(net_dump.fp);
+
+    snprintf(old, sizeof(old), "%s.1", net_dump.path);
+    plat_remove(old);
+    rename(net_dump.path, old);
+
+    net_dump_open_file();
+}
+
+static uint32_t
+net_dump_ring_get32(uint32_t pos)
+{
+    uint32_t val = 0;
+
+    for (int i = 0; i < 4; i++)
+        val |= (uint32_t) net_dump.ring[(pos + i) & NET_DUMP_RING_MASK] << (i << 3);
+
+    return val;
+}
+
+/* Write out whatever the emulation thread has queued so far. */
+static void
+net_dump_flush(void)
+{
+    uint32_t tail = atomic_load_explicit(&net_dump.tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&net_dump.head, memory_order_acquire);
+    uint32_t off;
+    uint32_t len;
+    uint32_t n;
+
+    /* Blocks are written whole, so that rotation never splits one. */
+    while ((tail != head) && (net_dump.fp != NULL)) {
+        off = tail & NET_DUMP_RING_MASK;
+        len = net_dump_ring_get32(tail + 4);
+        n   = MIN(len, NET_DUMP_RING - off);
+
+        fwrite(&net_dump.ring[off], 1, n, net_dump.fp);
+        if (n < len)
+            fwrite(net_dump.ring, 1, len - n, net_dump.fp);
+        net_dump.written += len;
+
+        tail += len;
+        atomic_store_explicit(&net_dump.tail, tail, memory_order_release);
+
+        if (net_dump_limit && (net_dump.written >= ((uint64_t) net_dump_limit << 20)))
+            net_dump_rotate();
+    }
+
+    if (net_dump.fp != NULL)
+        fflush(net_dump.fp);
+}
+
+static void
+net_dump_thread(UNUSED(void *priv))
+{
+    while (!atomic_load(&net_dump.stop)) {
+        thread_wait_event(net_dump.wake, NET_DUMP_INTERVAL);
+        thread_reset_event(net_dump.wake);
+        net_dump_flush();
+    }
+
+    net_dump_flush();
+}
+
+/* Emulated time, kept monotonic across CPU speed changes and resets. */
+static uint64_t
+net_dump_time(void)
+{
+    if (tsc > net_dump.last_tsc)
+        net_dump.time_us += (uint64_t) ((double) (tsc - net_dump.last_tsc) * 1000000.0 / cpuclock);
+    net_dump.last_tsc = tsc;
+
+    return net_dump.time_us;
+}
+
+static void
+net_dump_copy(uint32_t pos, const void *src, uint32_t len)
+{
+    uint32_t off = pos & NET_DUMP_RING_MASK;
+    uint32_t n   = MIN(len, NET_DUMP_RING - off);
+
+    memcpy(&net_dump.ring[off], src, n);
+    if (n < len)
+        memcpy(net_dump.ring, (const uint8_t *) src + n, len - n);
+}
+
+/*
+ * Queue a frame for the trace; only called from the emulation thread.
+ * outbound is set for frames sent by the guest.
+ */
+void
+net_dump_packet(int card_num, int outbound, const uint8_t *data, int len)
+{
+    uint8_t  hdr[28];
+    uint8_t  trl[19] = { 0 };
+    uint8_t *opt;
+    uint32_t cap_len;
+    uint32_t pad;
+    uint32_t blk_len;
+    uint32_t head;
+    uint32_t tail;
+    uint64_t ts;
+    uint16_t val16;
+
+    if (net_dump.ring == NULL)
+        return;
+
+    cap_len = len;
+    if (net_dump_snaplen && (cap_len > net_dump_snaplen))
+        cap_len = net_dump_snaplen;
+    pad     = PCAPNG_PAD(cap_len) - cap_len;
+    blk_len = sizeof(hdr) + cap_len + pad + 16;
+
+    head = atomic_load_explicit(&net_dump.head, memory_order_relaxed);
+    tail = atomic_load_explicit(&net_dump.tail, memory_order_acquire);
+    if ((NET_DUMP_RING - (head - tail)) < blk_len) {
+        if (!net_dump.dropped++)
+            net_dump_log("NET_DUMP: writer behind, dropping frames\n");
+        return;
+    }
+
+    ts = net_dump_time();
+    net_dump_put32(&hdr[0], PCAPNG_EPB);
+    net_dump_put32(&hdr[4], blk_len);
+    net_dump_put32(&hdr[8], card_num);
+    net_dump_put32(&hdr[12], ts >> 32);
+    net_dump_put32(&hdr[16], ts & 0xffffffff);
+    net_dump_put32(&hdr[20], cap_len);
+    net_dump_put32(&hdr[24], len);
+
+    /* Padding, epb_flags with the direction, opt_endofopt, block length. */
+    opt   = &trl[pad];
+    val16 = PCAPNG_OPT_FLAGS;
+    memcpy(&opt[0], &val16, 2);
+    val16 = 4;
+    memcpy(&opt[2], &val16, 2);
+    net_dump_put32(&opt[4], outbound ? 2 : 1);
+    net_dump_put32(&opt[12], blk_len);
+
+    net_dump_copy(head, hdr, sizeof(hdr));
+    net_dump_copy(head + sizeof(hdr), data, cap_len);
+    net_dump_copy(head + sizeof(hdr) + cap_len, trl, pad + 16);
+
+    atomic_store_explicit(&net_dump.head, head + blk_len, memory_order_release);
+
+    if ((head + blk_len - tail) >= NET_DUMP_KICK)
+        thread_set_event(net_dump.wake);
+}
+
+void
+net_dump_init(void)
+{
+    if (!net_dump_enabled || (net_dump.ring != NULL))
+        return;
+
+    path_append_filename(net_dump.path, usr_path, NET_DUMP_FILE);
+    if (!net_dump_open_file())
+        return;
+
+    net_dump.ring = malloc(NET_DUMP_RING);
+    atomic_init(&net_dump.head, 0);
+    atomic_init(&net_dump.tail, 0);
+    atomic_init(&net_dump.stop, false);
+    net_dump.dropped  = 0;
+    net_dump.last_tsc = tsc;
+    net_dump.time_us  = (uint64_t) time(NULL) * 1000000ULL;
+
+    net_dump.wake   = thread_create_event();
+    net_dump.thread = thread_create_named(net_dump_thread, NULL, "Network trace");
+
+    net_dump_log("NET_DUMP: tracing to %s\n", net_dump.path);
+}
+
+void
+net_dump_close(void)
+{
+    if (net_dump.ring == NULL)
+        return;
+
+    atomic_store(&net_dump.stop, true);
+    thread_set_event(net_dump.wake);
+    thread_wait(net_dump.thread);
+    thread_destroy_event(net_dump.wake);
+
+    if (net_dump.dropped)
+        pclog("NET_DUMP: %u frames dropped from the trace\n", net_dump.dropped);
+
+    if (net_dump.fp != NULL)
+        fclose(net_dump.fp);
+    net_dump.fp = NULL;
+
+    free(net_dump.ring);
+    net_dump.ring = NULL;
+}
@@ -487,6 +487,41 @@ nic_writel(uint16_t addr, uint32_t val, void *priv)
     nic_write((nic_t *) priv, addr, val, 4);
 }
 
+/*
+ * Bulk forms of the data port access for REP INSW/INSD and OUTSW/OUTSD,
+ * as used by packet drivers to move whole frames. Only word mode is
+ * handled here, where every access moves exactly its own size; byte
+ * mode and anything the block does not cover go through asic_read()
+ * and asic_write() one access at a time.
+ */
+static int
+nic_read_block(UNUSED(uint16_t addr), void *buf, int count, int size, void *priv)
+{
+    nic_t *dev = (nic_t *) priv;
+
+    if (!dev->dp8390->DCR.wdsize)
+        return 0;
+
+    nelog(3, "%s: DMA block read: addr=%4x remote_bytes=%d count=%d\n",
+          dev->name, dev->dp8390->remote_dma, dev->dp8390->remote_bytes, count);
+
+    return dp8390_remote_read(dev->dp8390, (uint8_t *) buf, count * size, size) / size;
+}
+
+static int
+nic_write_block(UNUSED(uint16_t addr), const void *buf, int count, int size, void *priv)
+{
+    nic_t *dev = (nic_t *) priv;
+
+    if (!dev->dp8390->DCR.wdsize)
+        return 0;
+
+    nelog(3, "%s: DMA block write: addr=%4x remote_bytes=%d count=%d\n",
+          dev->name, dev->dp8390->remote_dma, dev->dp8390->remote_bytes, count);
+
+    return dp8390_remote_write(dev->dp8390, (const uint8_t *) buf, count * size, size) / size;
+}
+
 static void nic_ioset(nic_t *dev, uint16_t addr);
 static void nic_ioremove(nic_t *dev, uint16_t addr);
 
@@ -565,6 +600,8 @@ nic_ioset(nic_t *dev, uint16_t addr)
         io_sethandler(addr, 32,
                       nic_readb, nic_readw, nic_readl,
                       nic_writeb, nic_writew, nic_writel, dev);
+        io_block_handler(1, addr + 0x10,
+                         nic_read_block, nic_write_block, dev);
     } else {
         io_sethandler(addr, 16,
                       nic_readb, NULL, NULL,
@@ -577,6 +614,8 @@ nic_ioset(nic_t *dev, uint16_t addr)
             io_sethandler(addr + 16, 16,
                           nic_readb, nic_readw, NULL,
                           nic_writeb, nic_writew, NULL, dev);
+            io_block_handler(1, addr + 16,
+                             nic_read_block, nic_write_block, dev);
         }
     }
 }
@@ -588,6 +627,8 @@ nic_ioremove(nic_t *dev, uint16_t addr)
         io_removehandler(addr, 32,
                          nic_readb, nic_readw, nic_readl,
                          nic_writeb, nic_writew, nic_writel, dev);
+        io_block_handler(0, addr + 0x10,
+                         nic_read_block, nic_write_block, dev);
     } else {
         io_removehandler(addr, 16,
                          nic_readb, NULL, NULL,
@@ -600,6 +641,8 @@ nic_ioremove(nic_t *dev, uint16_t addr)
             io_removehandler(addr + 16, 16,
                              nic_readb, nic_readw, NULL,
                              nic_writeb, nic_writew, NULL, dev);
+            io_block_handler(0, addr + 16,
+                             nic_read_block, nic_write_block, dev);
         }
     }
 }
@@ -75,6 +75,12 @@ typedef struct RTNETETHERHDR {
 /** Maximum frame size we handle */
 #define MAX_FRAME 1536
 
+/** Number of descriptors fetched ahead in one bus master burst */
+#define PCNET_DESC_BURST 8
+
+/** Log the transmit interrupt coalescing ratio every this many frames */
+#define PCNET_STATS_FRAMES 4096
+
 /** @name Bus configuration registers
  * @{ */
 #define BCR_MSRDA     0
@@ -207,6 +213,19 @@ static const uint8_t am79c961_pnp_rom[] = {
     0x79, 0x00 /* end tag, dummy checksum (filled in by isapnp_add_card) */
 };
 
+/**
+ * Descriptors read ahead from a ring in one burst. The cache is only filled
+ * while a ring walk is in progress, since the guest cannot touch the ring
+ * before the walk returns; descriptors written back during the walk are
+ * updated in place, and everything is dropped when the walk ends.
+ */
+typedef struct {
+    int      depth;
+    uint32_t addr;
+    uint32_t len;
+    uint8_t  data[PCNET_DESC_BURST << 4];
+} pcnet_desc_cache_t;
+
 typedef struct {
     mem_mapping_t mmio_mapping;
     const char   *name;
@@ -257,6 +276,11 @@ typedef struct {
     int fLinkTempDown;
     /** Number of times we've reported the link down. */
     uint32_t cLinkDownReported;
+    /** Descriptors read ahead from the RX and TX rings. */
+    pcnet_desc_cache_t rx_cache, tx_cache;
+    /** Frames transmitted and received, and the interrupts that reported them. */
+    uint32_t cTxFrames, cTxInts;
+    uint32_t cRxFrames, cRxInts;
     /** MS to wait before we enable the link. */
     uint32_t   cMsLinkUpDelay;
     int        transfer_size;
@@ -437,6 +461,79 @@ pcnetIsLinkUp(nic_t *dev)
     return !dev->fLinkTempDown && dev->fLinkUp;
 }
 
+static void
+pcnetDescBegin(pcnet_desc_cache_t *cache)
+{
+    if (cache->depth++ == 0)
+        cache->len = 0;
+}
+
+static void
+pcnetDescEnd(pcnet_desc_cache_t *cache)
+{
+    if (--cache->depth == 0)
+        cache->len = 0;
+}
+
+/**
+ * Read part of the descriptor at desc, going through the read ahead cache
+ * while a ring walk is in progress. On a miss, the cache is refilled with as
+ * many descriptors from desc on as fit before the end of the ring.
+ */
+static void
+pcnetDescRead(nic_t *dev, pcnet_desc_cache_t *cache, uint32_t ring, int ring_len,
+              uint32_t desc, uint32_t off, uint8_t *buf, uint32_t len)
+{
+    uint32_t ring_end = ring + (ring_len << dev->iLog2DescSize);
+    uint32_t addr     = desc + off;
+    uint32_t burst;
+
+    if (cache->depth && (desc >= ring) && (desc < ring_end)) {
+        if ((addr < cache->addr) || ((addr + len) > (cache->addr + cache->len))) {
+            burst = MIN(ring_end - desc, PCNET_DESC_BURST << dev->iLog2DescSize);
+            if ((off + len) <= burst) {
+                dma_bm_read(desc, cache->data, burst, dev->transfer_size);
+                cache->addr = desc;
+                cache->len  = burst;
+            }
+        }
+        if ((cache->len != 0) && (addr >= cache->addr) && ((addr + len) <= (cache->addr + cache->len))) {
+            memcpy(buf, &cache->data[addr - cache->addr], len);
+            return;
+        }
+    }
+
+    dma_bm_read(addr, buf, len, dev->transfer_size);
+}
+
+/**
+ * Write a descriptor back to the guest, keeping the read ahead cache coherent.
+ */
+static void
+pcnetDescWrite(nic_t *dev, pcnet_desc_cache_t *cache, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    dma_bm_write(addr, buf, len, dev->transfer_size);
+
+    if ((cache->len != 0) && (addr < (cache->addr + cache->len)) && ((addr + len) > cache->addr)) {
+        if ((addr >= cache->addr) && ((addr + len) <= (cache->addr + cache->len)))
+            memcpy(&cache->data[addr - cache->addr], buf, len);
+        else
+            cache->len = 0;
+    }
+}
+
+static __inline void
+pcnetTmdRead(nic_t *dev, uint32_t desc, uint32_t off, void *buf, uint32_t len)
+{
+    pcnetDescRead(dev, &dev->tx_cache, PHYSADDR(dev, dev->GCTDRA), CSR_XMTRL(dev), desc, off, (uint8_t *) buf, len);
+}
+
+static __inline void
+pcnetRmdRead(nic_t *dev, uint32_t desc, uint32_t off, void *buf, uint32_t len)
+{
+    pcnetDescRead(dev, &dev->rx_cache, PHYSADDR(dev, dev->GCRDRA), CSR_RCVRL(dev), desc, off, (uint8_t *) buf, len);
+}
+
 /**
  * Load transmit message descriptor
  * Make sure we read the own flag first.
@@ -455,27 +552,27 @@ pcnetTmdLoad(nic_t *dev, TMD *tmd, uint32_t addr, int fRetIfNotOwn)
     uint32_t xda32[4];
 
     if (BCR_SWSTYLE(dev) == 0) {
-        dma_bm_read(addr, (uint8_t *) bytes, 4, dev->transfer_size);
+        pcnetTmdRead(dev, addr, 0, bytes, 4);
         ownbyte = bytes[3];
         if (!(ownbyte & 0x80) && fRetIfNotOwn)
             return 0;
-        dma_bm_read(addr, (uint8_t *) &xda[0], sizeof(xda), dev->transfer_size);
+        pcnetTmdRead(dev, addr, 0, xda, sizeof(xda));
         ((uint32_t *) tmd)[0] = (uint32_t) xda[0] | ((uint32_t) (xda[1] & 0x00ff) << 16);
         ((uint32_t *) tmd)[1] = (uint32_t) xda[2] | ((uint32_t) (xda[1] & 0xff00) << 16);
         ((uint32_t *) tmd)[2] = (uint32_t) xda[3] << 16;
         ((uint32_t *) tmd)[3] = 0;
     } else if (BCR_SWSTYLE(dev) != 3) {
-        dma_bm_read(addr + 4, (uint8_t *) bytes, 4, dev->transfer_size);
+        pcnetTmdRead(dev, addr, 4, bytes, 4);
         ownbyte = bytes[3];
         if (!(ownbyte & 0x80) && fRetIfNotOwn)
             return 0;
-        dma_bm_read(addr, (uint8_t *) tmd, 16, dev->transfer_size);
+        pcnetTmdRead(dev, addr, 0, tmd, 16);
     } else {
-        dma_bm_read(addr + 4, (uint8_t *) bytes, 4, dev->transfer_size);
+        pcnetTmdRead(dev, addr, 4, bytes, 4);
         ownbyte = bytes[3];
         if (!(ownbyte & 0x80) && fRetIfNotOwn)
             return 0;
-        dma_bm_read(addr, (uint8_t *) &xda32[0], sizeof(xda32), dev->transfer_size);
+        pcnetTmdRead(dev, addr, 0, xda32, sizeof(xda32));
         ((uint32_t *) tmd)[0] = xda32[2];
         ((uint32_t *) tmd)[1] = xda32[1];
         ((uint32_t *) tmd)[2] = xda32[0];
@@ -510,14 +607,14 @@ pcnetTmdStorePassHost(nic_t *dev, TMD *tmd, uint32_t addr)
         dma_bm_write(addr, (uint8_t*)&xda[0], sizeof(xda), dev->transfer_size);
 #endif
         xda[1] &= ~0x8000;
-        dma_bm_write(addr, (uint8_t *) &xda[0], sizeof(xda), dev->transfer_size);
+        pcnetDescWrite(dev, &dev->tx_cache, addr, (uint8_t *) &xda[0], sizeof(xda));
     } else if (BCR_SWSTYLE(dev) != 3) {
 #if 0
         ((uint32_t*)tmd)[1] |=  0x80000000;
         dma_bm_write(addr, (uint8_t*)tmd, 12, dev->transfer_size);
 #endif
         ((uint32_t *) tmd)[1] &= ~0x80000000;
-        dma_bm_write(addr, (uint8_t *) tmd, 12, dev->transfer_size);
+        pcnetDescWrite(dev, &dev->tx_cache, addr, (uint8_t *) tmd, 12);
     } else {
         xda32[0] = ((uint32_t *) tmd)[2];
         xda32[1] = ((uint32_t *) tmd)[1];
@@ -527,7 +624,7 @@ pcnetTmdStorePassHost(nic_t *dev, TMD *tmd, uint32_t addr)
         dma_bm_write(addr, (uint8_t*)&xda32[0], sizeof(xda32), dev->transfer_size);
 #endif
         xda32[1] &= ~0x80000000;
-        dma_bm_write(addr, (uint8_t *) &xda32[0], sizeof(xda32), dev->transfer_size);
+        pcnetDescWrite(dev, &dev->tx_cache, addr, (uint8_t *) &xda32[0], sizeof(xda32));
     }
 }
 
@@ -549,27 +646,27 @@ pcnetRmdLoad(nic_t *dev, RMD *rmd, uint32_t addr, int fRetIfNotOwn)
     uint32_t rda32[4];
 
     if (BCR_SWSTYLE(dev) == 0) {
-        dma_bm_read(addr, (uint8_t *) bytes, 4, dev->transfer_size);
+        pcnetRmdRead(dev, addr, 0, bytes, 4);
         ownbyte = bytes[3];
         if (!(ownbyte & 0x80) && fRetIfNotOwn)
             return 0;
-        dma_bm_read(addr, (uint8_t *) &rda[0], sizeof(rda), dev->transfer_size);
+        pcnetRmdRead(dev, addr, 0, rda, sizeof(rda));
         ((uint32_t *) rmd)[0] = (uint32_t) rda[0] | ((rda[1] & 0x00ff) << 16);
         ((uint32_t *) rmd)[1] = (uint32_t) rda[2] | ((rda[1] & 0xff00) << 16);
         ((uint32_t *) rmd)[2] = (uint32_t) rda[3];
         ((uint32_t *) rmd)[3] = 0;
     } else if (BCR_SWSTYLE(dev) != 3) {
-        dma_bm_read(addr + 4, (uint8_t *) bytes, 4, dev->transfer_size);
+        pcnetRmdRead(dev, addr, 4, bytes, 4);
         ownbyte = bytes[3];
         if (!(ownbyte & 0x80) && fRetIfNotOwn)
             return 0;
-        dma_bm_read(addr, (uint8_t *) rmd, 16, dev->transfer_size);
+        pcnetRmdRead(dev, addr, 0, rmd, 16);
     } else {
-        dma_bm_read(addr + 4, (uint8_t *) bytes, 4, dev->transfer_size);
+        pcnetRmdRead(dev, addr, 4, bytes, 4);
         ownbyte = bytes[3];
         if (!(ownbyte & 0x80) && fRetIfNotOwn)
             return 0;
-        dma_bm_read(addr, (uint8_t *) &rda32[0], sizeof(rda32), dev->transfer_size);
+        pcnetRmdRead(dev, addr, 0, rda32, sizeof(rda32));
         ((uint32_t *) rmd)[0] = rda32[2];
         ((uint32_t *) rmd)[1] = rda32[1];
         ((uint32_t *) rmd)[2] = rda32[0];
@@ -605,14 +702,14 @@ pcnetRmdStorePassHost(nic_t *dev, RMD *rmd, uint32_t addr)
         dma_bm_write(addr, (uint8_t*)&rda[0], sizeof(rda), dev->transfer_size);
 #endif
         rda[1] &= ~0x8000;
-        dma_bm_write(addr, (uint8_t *) &rda[0], sizeof(rda), dev->transfer_size);
+        pcnetDescWrite(dev, &dev->rx_cache, addr, (uint8_t *) &rda[0], sizeof(rda));
     } else if (BCR_SWSTYLE(dev) != 3) {
 #if 0
         ((uint32_t*)rmd)[1] |=  0x80000000;
         dma_bm_write(addr, (uint8_t*)rmd, 12, dev->transfer_size);
 #endif
         ((uint32_t *) rmd)[1] &= ~0x80000000;
-        dma_bm_write(addr, (uint8_t *) rmd, 12, dev->transfer_size);
+        pcnetDescWrite(dev, &dev->rx_cache, addr, (uint8_t *) rmd, 12);
     } else {
         rda32[0] = ((uint32_t *) rmd)[2];
         rda32[1] = ((uint32_t *) rmd)[1];
@@ -622,7 +719,7 @@ pcnetRmdStorePassHost(nic_t *dev, RMD *rmd, uint32_t addr)
         dma_bm_write(addr, (uint8_t*)&rda32[0], sizeof(rda32), dev->transfer_size);
 #endif
         rda32[1] &= ~0x80000000;
-        dma_bm_write(addr, (uint8_t *) &rda32[0], sizeof(rda32), dev->transfer_size);
+        pcnetDescWrite(dev, &dev->rx_cache, addr, (uint8_t *) &rda32[0], sizeof(rda32));
     }
 }
 
@@ -1051,7 +1148,7 @@ pcnetStop(nic_t *dev)
  * definition.
  */
 static void
-pcnetRdtePoll(nic_t *dev)
+pcnetRdteLoad(nic_t *dev)
 {
     /* assume lack of a next receive descriptor */
     CSR_NRST(dev) = 0;
@@ -1123,6 +1220,14 @@ pcnetRdtePoll(nic_t *dev)
     }
 }
 
+static void
+pcnetRdtePoll(nic_t *dev)
+{
+    pcnetDescBegin(&dev->rx_cache);
+    pcnetRdteLoad(dev);
+    pcnetDescEnd(&dev->rx_cache);
+}
+
 /**
  * Poll Transmit Descriptor Table Entry
  * @return true if transmit descriptors available
@@ -1206,13 +1311,31 @@ pcnetCalcPacketLen(nic_t *dev, int cb)
     return cbPacket;
 }
 
+/**
+ * Report how many frames each transmit and receive interrupt covered. An
+ * interrupt is only counted when its status bit was clear, so frames that
+ * complete while the guest has yet to acknowledge the previous ones are
+ * coalesced into it.
+ */
+static void
+pcnetUpdateStats(nic_t *dev)
+{
+    if ((dev->cTxFrames < PCNET_STATS_FRAMES) && (dev->cRxFrames < PCNET_STATS_FRAMES))
+        return;
+
+    pcnet_log(2, "%s: %u TX frames in %u interrupts, %u RX frames in %u interrupts\n",
+              dev->name, dev->cTxFrames, dev->cTxInts, dev->cRxFrames, dev->cRxInts);
+
+    dev->cTxFrames = dev->cTxInts = 0;
+    dev->cRxFrames = dev->cRxInts = 0;
+}
+
 /**
  * Write data into guest receive buffers.
  */
 static int
-pcnetReceiveNoSync(void *priv, uint8_t *buf, int size)
+pcnetReceiveFrame(nic_t *dev, uint8_t *buf, int size)
 {
-    nic_t   *dev      = (nic_t *) priv;
     int      is_padr  = 0;
     int      is_bcast = 0;
     int      is_ladr  = 0;
@@ -1424,6 +1547,11 @@ pcnetReceiveNoSync(void *priv, uint8_t *buf, int size)
             /* write back, clear the own bit */
             pcnetRmdStorePassHost(dev, &rmd, PHYSADDR(dev, crda));
 
+            if (!(dev->aCSR[0] & 0x0400))
+                dev->cRxInts++;
+            dev->cRxFrames++;
+            pcnetUpdateStats(dev);
+
             dev->aCSR[0] |= 0x0400;
             pcnet_log(1, "%s: RINT set, RCVRC=%d CRDA=%#010x\n", dev->name,
                       CSR_RCVRC(dev), PHYSADDR(dev, CSR_CRDA(dev)));
@@ -1438,6 +1566,19 @@ pcnetReceiveNoSync(void *priv, uint8_t *buf, int size)
     return 1;
 }
 
+static int
+pcnetReceiveNoSync(void *priv, uint8_t *buf, int size)
+{
+    nic_t *dev = (nic_t *) priv;
+    int    ret;
+
+    pcnetDescBegin(&dev->rx_cache);
+    ret = pcnetReceiveFrame(dev, buf, size);
+    pcnetDescEnd(&dev->rx_cache);
+
+    return ret;
+}
+
 /**
  * Fails a TMD with a link down error.
  */
@@ -1482,6 +1623,7 @@ pcnetAsyncTransmit(nic_t *dev)
      */
     unsigned cFlushIrq = 0;
     int      cMax      = 32;
+    pcnetDescBegin(&dev->tx_cache);
     do {
         TMD tmd;
         if (!pcnetTdtePoll(dev, &tmd))
@@ -1510,17 +1652,26 @@ pcnetAsyncTransmit(nic_t *dev)
                  * ENP = 1).'' That means that the first buffer might have a
                  * zero length if it is not the last one in the chain. */
                 if (cb <= MAX_FRAME) {
+                    uint8_t *txbuf = (fLoopback || (cb > NET_MAX_FRAME)) ? NULL : network_tx_buf_get(dev->netcard);
+
                     dev->xmit_pos = cb;
-                    dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), dev->abLoopBuf, cb, dev->transfer_size);
+                    if (txbuf != NULL) {
+                        /* Read the frame straight into the transmit queue. */
+                        dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), txbuf, cb, dev->transfer_size);
+                        pcnet_log(3, "%s: pcnetAsyncTransmit: transmit stp and enp, xmit pos = %d\n", dev->name, dev->xmit_pos);
+                        network_tx_buf_commit(dev->netcard, dev->xmit_pos);
+                    } else {
+                        dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), dev->abLoopBuf, cb, dev->transfer_size);
 
-                    if (fLoopback) {
-                        if (HOST_IS_OWNER(CSR_CRST(dev)))
-                            pcnetRdtePoll(dev);
+                        if (fLoopback) {
+                            if (HOST_IS_OWNER(CSR_CRST(dev)))
+                                pcnetRdtePoll(dev);
 
-                        pcnetReceiveNoSync(dev, dev->abLoopBuf, dev->xmit_pos);
-                    } else {
-                        pcnet_log(3, "%s: pcnetAsyncTransmit: transmit loopbuf stp and enp, xmit pos = %d\n", dev->name, dev->xmit_pos);
-                        network_tx(dev->netcard, dev->abLoopBuf, dev->xmit_pos);
+                            pcnetReceiveNoSync(dev, dev->abLoopBuf, dev->xmit_pos);
+                        } else {
+                            pcnet_log(3, "%s: pcnetAsyncTransmit: transmit loopbuf stp and enp, xmit pos = %d\n", dev->name, dev->xmit_pos);
+                            network_tx(dev->netcard, dev->abLoopBuf, dev->xmit_pos);
+                        }
                     }
                 } else if (cb == 4096) {
                     /* The Windows NT4 pcnet driver sometimes marks the first
@@ -1576,9 +1727,22 @@ pcnetAsyncTransmit(nic_t *dev)
              * waste time finding out how much space we actually need even if
              * we could reliably do that on SMP guests.
              */
-            unsigned cb   = 4096 - tmd.tmd1.bcnt;
-            dev->xmit_pos = pcnetCalcPacketLen(dev, cb);
-            dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), dev->abLoopBuf, cb, dev->transfer_size);
+            unsigned cb    = 4096 - tmd.tmd1.bcnt;
+            uint8_t *txbuf = NULL;
+            uint8_t *frame = dev->abLoopBuf;
+            int      limit = MAX_FRAME;
+
+            /* Gather the fragments straight into the transmit queue if the
+             * whole frame is going to fit there. */
+            if (!fLoopback && (pcnetCalcPacketLen(dev, cb) <= NET_MAX_FRAME))
+                txbuf = network_tx_buf_get(dev->netcard);
+            if (txbuf != NULL) {
+                frame = txbuf;
+                limit = NET_MAX_FRAME;
+            }
+
+            dev->xmit_pos = cb;
+            dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), frame, cb, dev->transfer_size);
 
             for (;;) {
                 /*
@@ -1615,10 +1779,10 @@ pcnetAsyncTransmit(nic_t *dev)
                  */
                 pcnetTmdLoad(dev, &tmd, PHYSADDR(dev, CSR_CXDA(dev)), 0);
                 cb = 4096 - tmd.tmd1.bcnt;
-                if (dev->xmit_pos + cb <= MAX_FRAME) { /** @todo this used to be ... + cb < MAX_FRAME. */
+                if (dev->xmit_pos + cb <= limit) { /** @todo this used to be ... + cb < MAX_FRAME. */
                     int off       = dev->xmit_pos;
                     dev->xmit_pos = cb + off;
-                    dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), dev->abLoopBuf + off, cb, dev->transfer_size);
+                    dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), frame + off, cb, dev->transfer_size);
                 }
 
                 /*
@@ -1631,6 +1795,9 @@ pcnetAsyncTransmit(nic_t *dev)
 
                         pcnet_log(3, "%s: pcnetAsyncTransmit: receive loopback enp\n", dev->name);
                         pcnetReceiveNoSync(dev, dev->abLoopBuf, dev->xmit_pos);
+                    } else if (txbuf != NULL) {
+                        pcnet_log(3, "%s: pcnetAsyncTransmit: transmit enp, xmit pos = %d\n", dev->name, dev->xmit_pos);
+                        network_tx_buf_commit(dev->netcard, dev->xmit_pos);
                     } else {
                         pcnet_log(3, "%s: pcnetAsyncTransmit: transmit loopbuf enp\n", dev->name);
                         network_tx(dev->netcard, dev->abLoopBuf, dev->xmit_pos);
@@ -1658,11 +1825,17 @@ pcnetAsyncTransmit(nic_t *dev)
             || tmd.tmd1.err) {
             cFlushIrq++;
         }
+        dev->cTxFrames++;
         if (--cMax == 0)
             break;
     } while (CSR_TXON(dev)); /* transfer on */
+    pcnetDescEnd(&dev->tx_cache);
 
     if (cFlushIrq) {
+        if (!(dev->aCSR[0] & 0x0200))
+            dev->cTxInts++;
+        pcnetUpdateStats(dev);
+
         dev->aCSR[0] |= 0x0200; /* set TINT */
         /* Don't allow the guest to clear TINT before reading it */
         dev->u16CSR0LastSeenByGuest &= ~0x0200;
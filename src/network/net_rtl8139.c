@@ -393,6 +393,7 @@ struct RTL8139State {
     uint32_t RxBufferSize;                         /* internal variable, receive ring buffer size in C mode */
     uint32_t RxBufPtr;
     uint32_t RxBufAddr;
+    uint8_t  rx_frame[0x2008]; /* packet staged for the ring in C mode */
 
     uint16_t IntrStatus;
     uint16_t IntrMask;
@@ -795,19 +796,18 @@ rtl8139_do_receive(void *priv, uint8_t *buf, int size_)
                 s->RxRingAddrLO, cplus_rx_ring_desc);
 
         uint32_t val;
+        uint32_t desc[4];
         uint32_t rxdw0;
         uint32_t rxdw1;
         uint32_t rxbufLO;
         uint32_t rxbufHI;
 
-        dma_bm_read(cplus_rx_ring_desc, (uint8_t *) &val, 4, 4);
-        rxdw0 = val;
-        dma_bm_read(cplus_rx_ring_desc + 4, (uint8_t *) &val, 4, 4);
-        rxdw1 = val;
-        dma_bm_read(cplus_rx_ring_desc + 8, (uint8_t *) &val, 4, 4);
-        rxbufLO = val;
-        dma_bm_read(cplus_rx_ring_desc + 12, (uint8_t *) &val, 4, 4);
-        rxbufHI = val;
+        /* Fetch the whole descriptor in one go. */
+        dma_bm_read(cplus_rx_ring_desc, (uint8_t *) desc, sizeof(desc), 4);
+        rxdw0   = desc[0];
+        rxdw1   = desc[1];
+        rxbufLO = desc[2];
+        rxbufHI = desc[3];
 
         rtl8139_log("+++ C+ mode RX descriptor %d %08x %08x %08x %08x\n",
                     descriptor, rxdw0, rxdw1, rxbufLO, rxbufHI);
@@ -930,10 +930,9 @@ rtl8139_do_receive(void *priv, uint8_t *buf, int size_)
         rxdw0 |= (size + 4);
 
         /* update ring data */
-        val = rxdw0;
-        dma_bm_write(cplus_rx_ring_desc, (uint8_t *) &val, 4, 4);
-        val = rxdw1;
-        dma_bm_write(cplus_rx_ring_desc + 4, (uint8_t *) &val, 4, 4);
+        desc[0] = rxdw0;
+        desc[1] = rxdw1;
+        dma_bm_write(cplus_rx_ring_desc, (uint8_t *) desc, 8, 4);
 
         /* update tally counter */
         ++s->tally_counters.RxOk;
@@ -975,13 +974,24 @@ rtl8139_do_receive(void *priv, uint8_t *buf, int size_)
         /* write header */
         uint32_t val = packet_header;
 
-        rtl8139_write_buffer(s, (uint8_t *) &val, 4);
+        if ((size + 8) <= sizeof(s->rx_frame)) {
+            /* Lay out header, frame and checksum contiguously, so that the
+               whole packet goes to the ring in at most two writes. */
+            memcpy(s->rx_frame, &val, 4);
+            memcpy(s->rx_frame + 4, buf, size);
+            val = net_crc32_le(buf, size);
+            memcpy(s->rx_frame + 4 + size, &val, 4);
 
-        rtl8139_write_buffer(s, buf, size);
+            rtl8139_write_buffer(s, s->rx_frame, size + 8);
+        } else {
+            rtl8139_write_buffer(s, (uint8_t *) &val, 4);
 
-        /* write checksum */
-        val = (net_crc32_le(buf, size));
-        rtl8139_write_buffer(s, (uint8_t *) &val, 4);
+            rtl8139_write_buffer(s, buf, size);
+
+            /* write checksum */
+            val = (net_crc32_le(buf, size));
+            rtl8139_write_buffer(s, (uint8_t *) &val, 4);
+        }
 
         /* correct buffer write pointer */
         s->RxBufAddr = MOD2(RX_ALIGN(s->RxBufAddr), s->RxBufferSize);
@@ -1531,10 +1541,12 @@ rtl8139_RxConfig_read(RTL8139State *s)
     return ret;
 }
 
+/* Loopback frames are received right away instead of going through the
+   receive queue, which only the host backend thread may fill. */
 void
 rtl8139_network_rx_put(netcard_t *card, uint8_t *bufp, int len)
 {
-    (void) network_rx_put(card, bufp, len);
+    (void) card->rx(card->card_drv, bufp, len);
 }
 
 static void
@@ -1548,6 +1560,20 @@ rtl8139_transfer_frame(RTL8139State *s, uint8_t *buf, int size,
     }
 
     if (dot1q_buf && size >= ETH_ALEN * 2) {
+        uint8_t *txbuf = NULL;
+
+        /* Insert the VLAN tag while assembling the frame in the transmit
+           queue, so that it goes out as a single frame. */
+        if ((network_func == network_tx) && ((size + VLAN_HLEN) <= NET_MAX_FRAME))
+            txbuf = network_tx_buf_get(s->nic);
+        if (txbuf != NULL) {
+            memcpy(txbuf, buf, ETH_ALEN * 2);
+            memcpy(txbuf + ETH_ALEN * 2, dot1q_buf, VLAN_HLEN);
+            memcpy(txbuf + ETH_ALEN * 2 + VLAN_HLEN, buf + ETH_ALEN * 2, size - ETH_ALEN * 2);
+            network_tx_buf_commit(s->nic, size + VLAN_HLEN);
+            return;
+        }
+
         network_func(s->nic, buf, ETH_ALEN * 2);
         network_func(s->nic, (uint8_t *) dot1q_buf, VLAN_HLEN);
         network_func(s->nic, buf + ETH_ALEN * 2, size - ETH_ALEN * 2);
@@ -1561,8 +1587,9 @@ rtl8139_transfer_frame(RTL8139State *s, uint8_t *buf, int size,
 static int
 rtl8139_transmit_one(RTL8139State *s, int descriptor)
 {
-    int     txsize = s->TxStatus[descriptor] & 0x1fff;
-    uint8_t txbuffer[0x2000];
+    int      txsize = s->TxStatus[descriptor] & 0x1fff;
+    uint8_t  txbuffer[0x2000];
+    uint8_t *txbuf  = NULL;
 
     if (!rtl8139_transmitter_enabled(s)) {
         rtl8139_log("+++ cannot transmit from descriptor %d: transmitter "
@@ -1581,13 +1608,20 @@ rtl8139_transmit_one(RTL8139State *s, int descriptor)
     rtl8139_log("+++ transmit reading %d bytes from host memory at 0x%08x\n",
                 txsize, s->TxAddr[descriptor]);
 
-    dma_bm_read(s->TxAddr[descriptor], txbuffer, txsize, 1);
+    /* Unless looping back, read the frame straight into the transmit queue. */
+    if (txsize && (txsize <= NET_MAX_FRAME) && (TxLoopBack != (s->TxConfig & TxLoopBack)))
+        txbuf = network_tx_buf_get(s->nic);
+
+    dma_bm_read(s->TxAddr[descriptor], txbuf ? txbuf : txbuffer, txsize, 1);
 
     /* Mark descriptor as transferred */
     s->TxStatus[descriptor] |= TxHostOwns;
     s->TxStatus[descriptor] |= TxStatOK;
 
-    rtl8139_transfer_frame(s, txbuffer, txsize, 0, NULL);
+    if (txbuf != NULL)
+        network_tx_buf_commit(s->nic, txsize);
+    else
+        rtl8139_transfer_frame(s, txbuffer, txsize, 0, NULL);
 
     rtl8139_log("+++ transmitted %d bytes from descriptor %d\n", txsize,
                 descriptor);
@@ -1710,19 +1744,18 @@ rtl8139_cplus_transmit_one(RTL8139State *s)
                 s->TxAddr[0], cplus_tx_ring_desc);
 
     uint32_t val;
+    uint32_t desc[4];
     uint32_t txdw0;
     uint32_t txdw1;
     uint32_t txbufLO;
     uint32_t txbufHI;
 
-    dma_bm_read(cplus_tx_ring_desc, (uint8_t *) &val, 4, 4);
-    txdw0 = le32_to_cpu(val);
-    dma_bm_read(cplus_tx_ring_desc + 4, (uint8_t *) &val, 4, 4);
-    txdw1 = le32_to_cpu(val);
-    dma_bm_read(cplus_tx_ring_desc + 8, (uint8_t *) &val, 4, 4);
-    txbufLO = le32_to_cpu(val);
-    dma_bm_read(cplus_tx_ring_desc + 12, (uint8_t *) &val, 4, 4);
-    txbufHI = le32_to_cpu(val);
+    /* Fetch the whole descriptor in one go. */
+    dma_bm_read(cplus_tx_ring_desc, (uint8_t *) desc, sizeof(desc), 4);
+    txdw0   = le32_to_cpu(desc[0]);
+    txdw1   = le32_to_cpu(desc[1]);
+    txbufLO = le32_to_cpu(desc[2]);
+    txbufHI = le32_to_cpu(desc[3]);
 
     rtl8139_log("+++ C+ mode TX descriptor %d %08x %08x %08x %08x\n", descriptor,
                 txdw0, txdw1, txbufLO, txbufHI);
@@ -0,0 +1,457 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Shared memory network driver.
+ *
+ *          Cards of 86Box instances on the same host that are configured
+ *          with the same segment name are joined through a POSIX shared
+ *          memory segment that acts as an Ethernet hub.
+ *
+ *          Every port of the segment owns a ring of frame slots that only
+ *          it writes to; all other ports read it. Slots are guarded by a
+ *          sequence count, so there are no locks: a reader that falls a
+ *          whole ring behind or sees a slot being rewritten under it just
+ *          loses those frames, like a congested segment would. Moving a
+ *          frame is one copy into the ring and one out of it, with no
+ *          system calls while there is traffic; an idle port sleeps for up
+ *          to NET_SHM_IDLE_MS between scans.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/thread.h>
+#include <86box/timer.h>
+#include <86box/network.h>
+#include <86box/net_event.h>
+
+#define NET_SHM_MAGIC   0x4d485338 /* "8SHM" */
+#define NET_SHM_VERSION 1
+#define NET_SHM_PORTS   16
+#define NET_SHM_SLOTS   64 /* Must be a power of 2 */
+#define NET_SHM_BATCH   NET_QUEUE_LEN
+#define NET_SHM_SPINS   256
+#define NET_SHM_IDLE_MS 1
+
+enum {
+    NET_EVENT_STOP = 0,
+    NET_EVENT_TX,
+    NET_EVENT_MAX
+};
+
+/* Frame n of a ring is complete when the sequence of its slot is 2 * (n + 1);
+   the sequence is odd while the slot is being written. */
+typedef struct net_shm_slot_t {
+    atomic_uint seq;
+    uint32_t    len;
+    uint8_t     data[NET_MAX_FRAME];
+} net_shm_slot_t;
+
+typedef struct net_shm_port_t {
+    atomic_int     pid;
+    atomic_uint    head; /* Frames written to this ring so far */
+    net_shm_slot_t slots[NET_SHM_SLOTS];
+} net_shm_port_t;
+
+typedef struct net_shm_seg_t {
+    atomic_uint    magic;
+    uint32_t       version;
+    uint32_t       ports;
+    uint32_t       slots;
+    uint32_t       frame_size;
+    net_shm_port_t port[NET_SHM_PORTS];
+} net_shm_seg_t;
+
+typedef struct net_shm_t {
+    net_shm_seg_t *seg;
+    int            port;
+    uint32_t       next[NET_SHM_PORTS];
+    netcard_t     *card;
+    thread_t      *poll_tid;
+    net_evt_t      tx_event;
+    net_evt_t      stop_event;
+    netpkt_t       pkt;
+    netpkt_t       pktv[NET_SHM_BATCH];
+    uint8_t        mac_addr[6];
+} net_shm_t;
+
+#ifdef ENABLE_NET_SHM_LOG
+int net_shm_do_log = ENABLE_NET_SHM_LOG;
+
+static void
+net_shm_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (net_shm_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define net_shm_log(fmt, ...)
+#endif
+
+static void
+net_shm_error(char *errbuf, const char *message)
+{
+    strncpy(errbuf, message, NET_DRV_ERRBUF_SIZE);
+    errbuf[NET_DRV_ERRBUF_SIZE - 1] = '\0';
+    net_shm_log("Shared memory network: %s\n", message);
+}
+
+/* Put a frame into our own ring. */
+static void
+net_shm_write(net_shm_t *shm, const netpkt_t *pkt)
+{
+    net_shm_port_t *port = &shm->seg->port[shm->port];
+    uint32_t        n    = atomic_load_explicit(&port->head, memory_order_relaxed);
+    net_shm_slot_t *slot = &port->slots[n & (NET_SHM_SLOTS - 1)];
+
+    if ((pkt->len <= 0) || (pkt->len > NET_MAX_FRAME))
+        return;
+
+    atomic_store_explicit(&slot->seq, (n << 1) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->len = pkt->len;
+    memcpy(slot->data, pkt->data, pkt->len);
+
+    atomic_store_explicit(&slot->seq, (n + 1) << 1, memory_order_release);
+    atomic_store_explicit(&port->head, n + 1, memory_order_release);
+}
+
+/* Move the frames the other ports wrote since the last scan into the
+   receive queue, returns how many were seen. */
+static int
+net_shm_read(net_shm_t *shm)
+{
+    net_shm_port_t *port;
+    net_shm_slot_t *slot;
+    uint32_t        head;
+    uint32_t        r;
+    uint32_t        seq;
+    uint32_t        len;
+    int             frames = 0;
+
+    for (int p = 0; p < NET_SHM_PORTS; p++) {
+        if (p == shm->port)
+            continue;
+
+        port = &shm->seg->port[p];
+        head = atomic_load_explicit(&port->head, memory_order_acquire);
+        r    = shm->next[p];
+
+        /* Fell more than a ring behind, the oldest frames are gone. */
+        if ((head - r) > NET_SHM_SLOTS)
+            r = head - NET_SHM_SLOTS;
+
+        for (; r != head; r++) {
+            slot = &port->slots[r & (NET_SHM_SLOTS - 1)];
+            seq  = atomic_load_explicit(&slot->seq, memory_order_acquire);
+            if (seq != ((r + 1) << 1))
+                continue;
+
+            len = slot->len;
+            if (len > NET_MAX_FRAME)
+                continue;
+            memcpy(shm->pkt.data, slot->data, len);
+
+            /* Drop the frame if the slot was rewritten while copying. */
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq)
+                continue;
+
+            shm->pkt.len = len;
+            network_rx_put_pkt(shm->card, &shm->pkt);
+            frames++;
+        }
+
+        shm->next[p] = r;
+    }
+
+    return frames;
+}
+
+static int
+net_shm_tx(net_shm_t *shm)
+{
+    int packets = network_tx_popv(shm->card, shm->pktv, NET_SHM_BATCH);
+
+    for (int i = 0; i < packets; i++)
+        net_shm_write(shm, &shm->pktv[i]);
+
+    return packets;
+}
+
+static void
+net_shm_thread(void *priv)
+{
+    net_shm_t *shm   = (net_shm_t *) priv;
+    int        spins = 0;
+
+    net_shm_log("Shared memory network: polling started.\n");
+
+    struct pollfd pfd[NET_EVENT_MAX];
+    pfd[NET_EVENT_STOP].fd     = net_event_get_fd(&shm->stop_event);
+    pfd[NET_EVENT_STOP].events = POLLIN | POLLPRI;
+
+    pfd[NET_EVENT_TX].fd     = net_event_get_fd(&shm->tx_event);
+    pfd[NET_EVENT_TX].events = POLLIN | POLLPRI;
+
+    while (1) {
+        /* The transmit queue and the rings can both be checked without
+           entering the kernel, so keep scanning while there is traffic. */
+        if (net_shm_tx(shm) + net_shm_read(shm)) {
+            spins = 0;
+            continue;
+        }
+        if (++spins < NET_SHM_SPINS)
+            continue;
+
+        poll(pfd, NET_EVENT_MAX, NET_SHM_IDLE_MS);
+
+        if (pfd[NET_EVENT_STOP].revents & POLLIN) {
+            net_event_clear(&shm->stop_event);
+            break;
+        }
+
+        if (pfd[NET_EVENT_TX].revents & POLLIN) {
+            net_event_clear(&shm->tx_event);
+            spins = 0;
+        }
+    }
+
+    net_shm_log("Shared memory network: polling stopped.\n");
+}
+
+/* Map the segment, creating and formatting it if we are the first. */
+static net_shm_seg_t *
+net_shm_map(const char *name, char *errbuf)
+{
+    net_shm_seg_t *seg;
+    struct stat    st;
+    int            created = 1;
+    int            fd;
+
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if ((fd < 0) && (errno == EEXIST)) {
+        created = 0;
+        fd      = shm_open(name, O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        snprintf(errbuf, NET_DRV_ERRBUF_SIZE, "Unable to open shared memory segment %s (%s)", name, strerror(errno));
+        return NULL;
+    }
+
+    if (created) {
+        if (ftruncate(fd, sizeof(net_shm_seg_t)) < 0) {
+            snprintf(errbuf, NET_DRV_ERRBUF_SIZE, "Unable to size shared memory segment %s (%s)", name, strerror(errno));
+            close(fd);
+            shm_unlink(name);
+            return NULL;
+        }
+    } else {
+        /* Give the instance that created the segment time to size it. */
+        for (int i = 0; i < 100; i++) {
+            if ((fstat(fd, &st) == 0) && (st.st_size >= (off_t) sizeof(net_shm_seg_t)))
+                break;
+            usleep(10000);
+        }
+        if ((fstat(fd, &st) != 0) || (st.st_size != (off_t) sizeof(net_shm_seg_t))) {
+            snprintf(errbuf, NET_DRV_ERRBUF_SIZE, "Shared memory segment %s has the wrong size", name);
+            close(fd);
+            return NULL;
+        }
+    }
+
+    seg = mmap(NULL, sizeof(net_shm_seg_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED) {
+        snprintf(errbuf, NET_DRV_ERRBUF_SIZE, "Unable to map shared memory segment %s (%s)", name, strerror(errno));
+        return NULL;
+    }
+
+    if (created) {
+        /* ftruncate() zeroed it, which is an empty ring with no owner. */
+        seg->version    = NET_SHM_VERSION;
+        seg->ports      = NET_SHM_PORTS;
+        seg->slots      = NET_SHM_SLOTS;
+        seg->frame_size = NET_MAX_FRAME;
+        atomic_store_explicit(&seg->magic, NET_SHM_MAGIC, memory_order_release);
+    } else {
+        for (int i = 0; i < 100; i++) {
+            if (atomic_load_explicit(&seg->magic, memory_order_acquire) == NET_SHM_MAGIC)
+                break;
+            usleep(10000);
+        }
+    }
+
+    if ((atomic_load_explicit(&seg->magic, memory_order_acquire) != NET_SHM_MAGIC) ||
+        (seg->version != NET_SHM_VERSION) || (seg->ports != NET_SHM_PORTS) ||
+        (seg->slots != NET_SHM_SLOTS) || (seg->frame_size != NET_MAX_FRAME)) {
+        snprintf(errbuf, NET_DRV_ERRBUF_SIZE, "Shared memory segment %s has an incompatible layout", name);
+        munmap(seg, sizeof(net_shm_seg_t));
+        return NULL;
+    }
+
+    return seg;
+}
+
+/* Claim a free port, or one left behind by an instance that died. */
+static int
+net_shm_claim(net_shm_seg_t *seg)
+{
+    int self = getpid();
+    int pid;
+
+    for (int p = 0; p < NET_SHM_PORTS; p++) {
+        pid = atomic_load(&seg->port[p].pid);
+        if ((pid != 0) && ((kill(pid, 0) == 0) || (errno != ESRCH)))
+            continue;
+
+        if (atomic_compare_exchange_strong(&seg->port[p].pid, &pid, self))
+            return p;
+    }
+
+    return -1;
+}
+
+/*
+ * Join a shared memory segment.
+ *
+ * priv is the name of the segment; all cards using the same name are on the
+ * same segment.
+ */
+void *
+net_shm_init(const netcard_t *card, const uint8_t *mac_addr, void *priv, char *netdrv_errbuf)
+{
+    char           *seg_name = (char *) priv;
+    char            name[NET_DRV_ERRBUF_SIZE];
+    char            errbuf[NET_DRV_ERRBUF_SIZE];
+    net_shm_seg_t  *seg;
+    net_shm_t      *shm;
+    int             port;
+
+    if ((seg_name == NULL) || (seg_name[0] == '\0') || !strcmp(seg_name, "none")) {
+        net_shm_error(netdrv_errbuf, "No shared memory segment name configured");
+        return NULL;
+    }
+
+    if (strchr(seg_name, '/') != NULL) {
+        snprintf(errbuf, sizeof(errbuf), "Invalid shared memory segment name %s", seg_name);
+        net_shm_error(netdrv_errbuf, errbuf);
+        return NULL;
+    }
+
+    snprintf(name, sizeof(name), "/86box-net-%s", seg_name);
+    seg = net_shm_map(name, errbuf);
+    if (seg == NULL) {
+        net_shm_error(netdrv_errbuf, errbuf);
+        return NULL;
+    }
+
+    port = net_shm_claim(seg);
+    if (port < 0) {
+        snprintf(errbuf, sizeof(errbuf), "All %i ports of shared memory segment %s are in use", NET_SHM_PORTS, seg_name);
+        net_shm_error(netdrv_errbuf, errbuf);
+        munmap(seg, sizeof(net_shm_seg_t));
+        return NULL;
+    }
+
+    net_shm_log("Shared memory network: joined %s as port %i\n", name, port);
+
+    shm       = calloc(1, sizeof(net_shm_t));
+    shm->seg  = seg;
+    shm->port = port;
+    shm->card = (netcard_t *) card;
+    memcpy(shm->mac_addr, mac_addr, sizeof(shm->mac_addr));
+
+    /* Only see what is sent from now on. */
+    for (int p = 0; p < NET_SHM_PORTS; p++)
+        shm->next[p] = atomic_load(&seg->port[p].head);
+
+    for (int i = 0; i < NET_SHM_BATCH; i++)
+        shm->pktv[i].data = calloc(1, NET_MAX_FRAME);
+    shm->pkt.data = calloc(1, NET_MAX_FRAME);
+
+    net_event_init(&shm->tx_event);
+    net_event_init(&shm->stop_event);
+    shm->poll_tid = thread_create(net_shm_thread, shm);
+
+    return shm;
+}
+
+void
+net_shm_in_available(void *priv)
+{
+    net_shm_t *shm = (net_shm_t *) priv;
+
+    net_event_set(&shm->tx_event);
+}
+
+void
+net_shm_close(void *priv)
+{
+    if (!priv)
+        return;
+
+    net_shm_t *shm  = (net_shm_t *) priv;
+    int        self = getpid();
+
+    net_shm_log("Shared memory network: closing.\n");
+
+    /* Tell the thread to terminate. */
+    net_event_set(&shm->stop_event);
+
+    /* Wait for the thread to finish. */
+    net_shm_log("Shared memory network: waiting for thread to end...\n");
+    thread_wait(shm->poll_tid);
+    net_shm_log("Shared memory network: thread ended\n");
+
+    /* Give the port back; the segment stays for the other instances. */
+    atomic_compare_exchange_strong(&shm->seg->port[shm->port].pid, &self, 0);
+    munmap(shm->seg, sizeof(net_shm_seg_t));
+
+    for (int i = 0; i < NET_SHM_BATCH; i++)
+        free(shm->pktv[i].data);
+    free(shm->pkt.data);
+
+    net_event_close(&shm->tx_event);
+    net_event_close(&shm->stop_event);
+
+    free(shm);
+}
+
+const netdrv_t net_shm_drv = {
+    &net_shm_in_available,
+    &net_shm_init,
+    &net_shm_close,
+    NULL
+};
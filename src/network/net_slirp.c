@@ -50,7 +50,9 @@
 #endif
 #include <86box/net_event.h>
 
-#define SLIRP_PKT_BATCH NET_QUEUE_LEN
+#define SLIRP_PKT_BATCH   NET_QUEUE_LEN
+#define SLIRP_RX_RESERVE  8 /* frames kept free in the card queue before reading from sockets */
+#define SLIRP_RX_THROTTLE 1 /* ms to wait for the card to catch up when its queue is full */
 
 enum {
     NET_EVENT_STOP = 0,
@@ -59,6 +61,14 @@ enum {
     NET_EVENT_MAX
 };
 
+/* libslirp timers, run by the polling thread. */
+typedef struct net_slirp_timer_t {
+    struct net_slirp_timer_t *next;
+    SlirpTimerCb              cb;
+    void                     *cb_opaque;
+    int64_t                   expire_ms; /* -1 when not armed */
+} net_slirp_timer_t;
+
 typedef struct net_slirp_t {
     Slirp     *slirp;
     uint8_t    mac_addr[6];
@@ -68,6 +78,10 @@ typedef struct net_slirp_t {
     net_evt_t  stop_event;
     netpkt_t   pkt;
     netpkt_t   pkt_tx_v[SLIRP_PKT_BATCH];
+    int        rx_throttle;
+    uint32_t   clock_ticks;
+    int64_t    clock_ms;
+    net_slirp_timer_t *timers;
 #ifdef _WIN32
     HANDLE     sock_event;
 #else
@@ -124,31 +138,102 @@ net_slirp_guest_error(UNUSED(const char *msg), UNUSED(void *opaque))
     slirp_log("SLiRP: guest_error(): %s\n", msg);
 }
 
+/*
+ * libslirp runs its timers off the host clock, so that TCP and DHCP
+ * timeouts neither depend on the emulation speed nor have to be
+ * serviced from the emulation thread. The millisecond tick counter is
+ * widened to 64 bits here, which is only ever done by the thread that
+ * owns this instance.
+ */
 static int64_t
-net_slirp_clock_get_ns(UNUSED(void *opaque))
+net_slirp_clock_ms(net_slirp_t *slirp)
 {
-    return (int64_t) ((double) tsc / cpuclock * 1000000000.0);
+    uint32_t ticks = plat_get_ticks();
+
+    slirp->clock_ms += (uint32_t) (ticks - slirp->clock_ticks);
+    slirp->clock_ticks = ticks;
+
+    return slirp->clock_ms;
+}
+
+static int64_t
+net_slirp_clock_get_ns(void *opaque)
+{
+    return net_slirp_clock_ms((net_slirp_t *) opaque) * 1000000LL;
 }
 
 static void *
-net_slirp_timer_new(SlirpTimerCb cb, void *cb_opaque, UNUSED(void *opaque))
+net_slirp_timer_new(SlirpTimerCb cb, void *cb_opaque, void *opaque)
 {
-    pc_timer_t *timer = malloc(sizeof(pc_timer_t));
-    timer_add(timer, cb, cb_opaque, 0);
+    net_slirp_t       *slirp = (net_slirp_t *) opaque;
+    net_slirp_timer_t *timer = calloc(1, sizeof(net_slirp_timer_t));
+
+    timer->cb        = cb;
+    timer->cb_opaque = cb_opaque;
+    timer->expire_ms = -1;
+    timer->next      = slirp->timers;
+    slirp->timers    = timer;
+
     return timer;
 }
 
 static void
-net_slirp_timer_free(void *timer, UNUSED(void *opaque))
+net_slirp_timer_free(void *timer, void *opaque)
 {
-    timer_stop(timer);
+    net_slirp_t        *slirp = (net_slirp_t *) opaque;
+    net_slirp_timer_t **prev  = &slirp->timers;
+
+    while (*prev != NULL) {
+        if (*prev == timer) {
+            *prev = (*prev)->next;
+            break;
+        }
+        prev = &(*prev)->next;
+    }
+
     free(timer);
 }
 
+/* expire_time is an absolute time in milliseconds on the clock above. */
+static void
+net_slirp_timer_mod(void *timer, int64_t expire_time, UNUSED(void *opaque))
+{
+    ((net_slirp_timer_t *) timer)->expire_ms = expire_time;
+}
+
+/* Shorten the poll timeout to the nearest timer expiry. */
+static uint32_t
+net_slirp_timers_timeout(net_slirp_t *slirp, uint32_t timeout)
+{
+    int64_t now = net_slirp_clock_ms(slirp);
+
+    for (net_slirp_timer_t *timer = slirp->timers; timer != NULL; timer = timer->next) {
+        if (timer->expire_ms < 0)
+            continue;
+        if (timer->expire_ms <= now)
+            return 0;
+        if ((timer->expire_ms - now) < (int64_t) timeout)
+            timeout = (uint32_t) (timer->expire_ms - now);
+    }
+
+    return timeout;
+}
+
 static void
-net_slirp_timer_mod(void *timer, int64_t expire_timer, UNUSED(void *opaque))
+net_slirp_timers_run(net_slirp_t *slirp)
 {
-    timer_on_auto(timer, expire_timer * 1000);
+    net_slirp_timer_t *timer;
+    int64_t            now = net_slirp_clock_ms(slirp);
+
+    /* A callback may re-arm or free timers, so rescan after each one. */
+restart:
+    for (timer = slirp->timers; timer != NULL; timer = timer->next) {
+        if ((timer->expire_ms >= 0) && (timer->expire_ms <= now)) {
+            timer->expire_ms = -1;
+            timer->cb(timer->cb_opaque);
+            goto restart;
+        }
+    }
 }
 
 static void
@@ -191,6 +276,8 @@ net_slirp_add_poll(int fd, int events, void *opaque)
 {
     net_slirp_t *slirp   = (net_slirp_t *) opaque;
     long         bitmask = 0;
+    if (slirp->rx_throttle)
+        events &= ~SLIRP_POLL_IN;
     if (events & SLIRP_POLL_IN)
         bitmask |= FD_READ | FD_ACCEPT;
     if (events & SLIRP_POLL_OUT)
@@ -221,6 +308,8 @@ net_slirp_add_poll(int fd, int events, void *opaque)
         int idx = slirp->pfd_len++;
         slirp->pfd[idx].fd = fd;
         int pevents = 0;
+        if (slirp->rx_throttle && (idx >= NET_EVENT_RX))
+            events &= ~SLIRP_POLL_IN;
         if (events & SLIRP_POLL_IN)
             pevents |= POLLIN;
         if (events & SLIRP_POLL_OUT)
@@ -313,6 +402,35 @@ net_slirp_in(net_slirp_t *slirp, uint8_t *pkt, int pkt_len)
     slirp_input(slirp->slirp, (const uint8_t *) pkt, pkt_len);
 }
 
+/* Feed everything the card has queued to libslirp. */
+static void
+net_slirp_tx(net_slirp_t *slirp)
+{
+    int packets;
+
+    do {
+        packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
+        for (int i = 0; i < packets; i++)
+            net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
+    } while (packets == SLIRP_PKT_BATCH);
+}
+
+/*
+ * Stop reading from host sockets while the card's receive queue is
+ * nearly full, leaving the data in the socket buffers (and TCP flow
+ * control) instead of dropping frames the guest did not pick up yet.
+ */
+static uint32_t
+net_slirp_throttle(net_slirp_t *slirp, uint32_t timeout)
+{
+    slirp->rx_throttle = network_rx_space(slirp->card) < SLIRP_RX_RESERVE;
+
+    if (slirp->rx_throttle && (timeout > SLIRP_RX_THROTTLE))
+        timeout = SLIRP_RX_THROTTLE;
+
+    return timeout;
+}
+
 void
 net_slirp_in_available(void *priv)
 {
@@ -335,10 +453,9 @@ net_slirp_thread(void *priv)
     events[NET_EVENT_RX]   = slirp->sock_event;
     bool run               = true;
     while (run) {
-        uint32_t timeout = -1;
+        uint32_t timeout = net_slirp_throttle(slirp, INFINITE);
         slirp_pollfds_fill(slirp->slirp, &timeout, net_slirp_add_poll, slirp);
-        if (timeout < 0)
-            timeout = INFINITE;
+        timeout = net_slirp_timers_timeout(slirp, timeout);
 
         int ret = WaitForMultipleObjects(3, events, FALSE, (DWORD) timeout);
         switch (ret - WAIT_OBJECT_0) {
@@ -347,18 +464,15 @@ net_slirp_thread(void *priv)
                 break;
 
             case NET_EVENT_TX:
-                {
-                    int packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
-                    for (int i = 0; i < packets; i++) {
-                        net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
-                    }
-                }
+                net_slirp_tx(slirp);
                 break;
 
             default:
                 slirp_pollfds_poll(slirp->slirp, ret == WAIT_FAILED, net_slirp_get_revents, slirp);
                 break;
         }
+
+        net_slirp_timers_run(slirp);
     }
 
     slirp_log("SLiRP: polling stopped.\n");
@@ -374,15 +488,16 @@ net_slirp_thread(void *priv)
     slirp_log("SLiRP: polling started.\n");
 
     while (1) {
-        uint32_t timeout = -1;
+        uint32_t timeout = net_slirp_throttle(slirp, -1);
 
         slirp->pfd_len = 0;
         net_slirp_add_poll(net_event_get_fd(&slirp->stop_event), SLIRP_POLL_IN, slirp);
         net_slirp_add_poll(net_event_get_fd(&slirp->tx_event), SLIRP_POLL_IN, slirp);
 
         slirp_pollfds_fill(slirp->slirp, &timeout, net_slirp_add_poll, slirp);
+        timeout = net_slirp_timers_timeout(slirp, timeout);
 
-        int ret = poll(slirp->pfd, slirp->pfd_len, timeout);
+        int ret = poll(slirp->pfd, slirp->pfd_len, (timeout == (uint32_t) -1) ? -1 : (int) timeout);
 
         slirp_pollfds_poll(slirp->slirp, (ret < 0), net_slirp_get_revents, slirp);
 
@@ -393,12 +508,10 @@ net_slirp_thread(void *priv)
 
         if (slirp->pfd[NET_EVENT_TX].revents & POLLIN) {
             net_event_clear(&slirp->tx_event);
-
-            int packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
-            for (int i = 0; i < packets; i++) {
-                net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
-            }
+            net_slirp_tx(slirp);
         }
+
+        net_slirp_timers_run(slirp);
     }
 
     slirp_log("SLiRP: polling stopped.\n");
@@ -415,6 +528,7 @@ net_slirp_init(const netcard_t *card, const uint8_t *mac_addr, UNUSED(void *priv
     net_slirp_t *slirp = calloc(1, sizeof(net_slirp_t));
     memcpy(slirp->mac_addr, mac_addr, sizeof(slirp->mac_addr));
     slirp->card = (netcard_t *) card;
+    slirp->clock_ticks = plat_get_ticks();
 
 #ifndef _WIN32
     slirp->pfd_size = 16 * sizeof(struct pollfd);
@@ -531,6 +645,8 @@ net_slirp_close(void *priv)
     net_event_close(&slirp->tx_event);
     net_event_close(&slirp->stop_event);
     slirp_cleanup(slirp->slirp);
+    while (slirp->timers != NULL)
+        net_slirp_timer_free(slirp->timers, slirp);
     for (int i = 0; i < SLIRP_PKT_BATCH; i++) {
         free(slirp->pkt_tx_v[i].data);
     }
@@ -0,0 +1,284 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Linux TAP network driver.
+ *
+ *          The card is attached to an existing TAP interface, which can
+ *          then be bridged or routed on the host. The interface has to be
+ *          created beforehand to be used without root, for example with:
+ *
+ *              ip tuntap add dev tap0 mode tap user <user>
+ *
+ *          Frames are moved in batches: each wakeup of the polling thread
+ *          drains the whole transmit queue and reads every frame pending on
+ *          the TAP file descriptor, straight into the receive queue.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/thread.h>
+#include <86box/timer.h>
+#include <86box/network.h>
+#include <86box/net_event.h>
+
+#define TAP_DEVICE    "/dev/net/tun"
+#define TAP_PKT_BATCH NET_QUEUE_LEN
+
+enum {
+    NET_EVENT_STOP = 0,
+    NET_EVENT_TX,
+    NET_EVENT_RX,
+    NET_EVENT_MAX
+};
+
+typedef struct net_tap_t {
+    int        fd;
+    netcard_t *card;
+    thread_t  *poll_tid;
+    net_evt_t  tx_event;
+    net_evt_t  stop_event;
+    netpkt_t   pkt;
+    netpkt_t   pktv[TAP_PKT_BATCH];
+    uint8_t    mac_addr[6];
+} net_tap_t;
+
+#ifdef ENABLE_TAP_LOG
+int tap_do_log = ENABLE_TAP_LOG;
+
+static void
+tap_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (tap_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define tap_log(fmt, ...)
+#endif
+
+static void
+net_tap_tx(net_tap_t *tap)
+{
+    int packets;
+
+    do {
+        packets = network_tx_popv(tap->card, tap->pktv, TAP_PKT_BATCH);
+        for (int i = 0; i < packets; i++) {
+            if (write(tap->fd, tap->pktv[i].data, tap->pktv[i].len) < 0)
+                tap_log("TAP: unable to send packet (%s)\n", strerror(errno));
+        }
+    } while (packets == TAP_PKT_BATCH);
+}
+
+static void
+net_tap_rx(net_tap_t *tap)
+{
+    ssize_t len;
+
+    /* The descriptor is non-blocking, read until there is nothing left. */
+    for (int i = 0; i < TAP_PKT_BATCH; i++) {
+        len = read(tap->fd, tap->pkt.data, NET_MAX_FRAME);
+        if (len <= 0)
+            break;
+
+        tap->pkt.len = len;
+        network_rx_put_pkt(tap->card, &tap->pkt);
+    }
+}
+
+static void
+net_tap_thread(void *priv)
+{
+    net_tap_t *tap = (net_tap_t *) priv;
+
+    tap_log("TAP: polling started.\n");
+
+    struct pollfd pfd[NET_EVENT_MAX];
+    pfd[NET_EVENT_STOP].fd     = net_event_get_fd(&tap->stop_event);
+    pfd[NET_EVENT_STOP].events = POLLIN | POLLPRI;
+
+    pfd[NET_EVENT_TX].fd     = net_event_get_fd(&tap->tx_event);
+    pfd[NET_EVENT_TX].events = POLLIN | POLLPRI;
+
+    pfd[NET_EVENT_RX].fd     = tap->fd;
+    pfd[NET_EVENT_RX].events = POLLIN;
+
+    while (1) {
+        poll(pfd, NET_EVENT_MAX, -1);
+
+        if (pfd[NET_EVENT_STOP].revents & POLLIN) {
+            net_event_clear(&tap->stop_event);
+            break;
+        }
+
+        if (pfd[NET_EVENT_TX].revents & POLLIN) {
+            net_event_clear(&tap->tx_event);
+            net_tap_tx(tap);
+        }
+
+        if (pfd[NET_EVENT_RX].revents & POLLIN)
+            net_tap_rx(tap);
+
+        /* The interface went away. */
+        if (pfd[NET_EVENT_RX].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            tap_log("TAP: interface closed.\n");
+            break;
+        }
+    }
+
+    tap_log("TAP: polling stopped.\n");
+}
+
+/* Check whether TAP interfaces can be used at all. */
+int
+net_tap_prepare(void)
+{
+    if (access(TAP_DEVICE, R_OK | W_OK) != 0) {
+        tap_log("TAP: %s is not available (%s)\n", TAP_DEVICE, strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
+static void
+net_tap_error(char *errbuf, const char *message)
+{
+    strncpy(errbuf, message, NET_DRV_ERRBUF_SIZE);
+    errbuf[NET_DRV_ERRBUF_SIZE - 1] = '\0';
+    tap_log("TAP: %s\n", message);
+}
+
+/*
+ * Attach to a TAP interface.
+ *
+ * priv is the name of the interface.
+ */
+void *
+net_tap_init(const netcard_t *card, const uint8_t *mac_addr, void *priv, char *netdrv_errbuf)
+{
+    char         *ifname = (char *) priv;
+    char          errbuf[NET_DRV_ERRBUF_SIZE];
+    struct ifreq  ifr;
+    net_tap_t    *tap;
+    int           fd;
+
+    if ((ifname == NULL) || (ifname[0] == '\0') || !strcmp(ifname, "none")) {
+        net_tap_error(netdrv_errbuf, "No TAP interface configured");
+        return NULL;
+    }
+
+    if (strlen(ifname) >= IFNAMSIZ) {
+        snprintf(errbuf, sizeof(errbuf), "Invalid TAP interface name %s", ifname);
+        net_tap_error(netdrv_errbuf, errbuf);
+        return NULL;
+    }
+
+    fd = open(TAP_DEVICE, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        snprintf(errbuf, sizeof(errbuf), "Unable to open %s (%s)", TAP_DEVICE, strerror(errno));
+        net_tap_error(netdrv_errbuf, errbuf);
+        return NULL;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strcpy(ifr.ifr_name, ifname);
+    if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+        snprintf(errbuf, sizeof(errbuf), "Unable to attach to TAP interface %s (%s)", ifname, strerror(errno));
+        net_tap_error(netdrv_errbuf, errbuf);
+        close(fd);
+        return NULL;
+    }
+
+    tap_log("TAP: attached to %s\n", ifr.ifr_name);
+
+    tap       = calloc(1, sizeof(net_tap_t));
+    tap->fd   = fd;
+    tap->card = (netcard_t *) card;
+    memcpy(tap->mac_addr, mac_addr, sizeof(tap->mac_addr));
+
+    for (int i = 0; i < TAP_PKT_BATCH; i++)
+        tap->pktv[i].data = calloc(1, NET_MAX_FRAME);
+    tap->pkt.data = calloc(1, NET_MAX_FRAME);
+
+    net_event_init(&tap->tx_event);
+    net_event_init(&tap->stop_event);
+    tap->poll_tid = thread_create(net_tap_thread, tap);
+
+    return tap;
+}
+
+void
+net_tap_in_available(void *priv)
+{
+    net_tap_t *tap = (net_tap_t *) priv;
+
+    net_event_set(&tap->tx_event);
+}
+
+void
+net_tap_close(void *priv)
+{
+    if (!priv)
+        return;
+
+    net_tap_t *tap = (net_tap_t *) priv;
+
+    tap_log("TAP: closing.\n");
+
+    /* Tell the thread to terminate. */
+    net_event_set(&tap->stop_event);
+
+    /* Wait for the thread to finish. */
+    tap_log("TAP: waiting for thread to end...\n");
+    thread_wait(tap->poll_tid);
+    tap_log("TAP: thread ended\n");
+
+    for (int i = 0; i < TAP_PKT_BATCH; i++)
+        free(tap->pktv[i].data);
+    free(tap->pkt.data);
+
+    close(tap->fd);
+
+    net_event_close(&tap->tx_event);
+    net_event_close(&tap->stop_event);
+
+    free(tap);
+}
+
+const netdrv_t net_tap_drv = {
+    &net_tap_in_available,
+    &net_tap_init,
+    &net_tap_close,
+    NULL
+};
@@ -330,6 +330,8 @@ struct TULIPState {
 
     uint8_t  rx_frame[2048];
     uint8_t  tx_frame[2048];
+    uint8_t *tx_buf; /* tx_frame, or a buffer borrowed from the transmit queue */
+    uint16_t tx_buf_size;
     uint16_t tx_frame_len;
     uint16_t rx_frame_len;
     uint16_t rx_frame_size;
@@ -346,10 +348,8 @@ static void
 tulip_desc_read(TULIPState *s, uint32_t p,
                 struct tulip_descriptor *desc)
 {
-    desc->status    = mem_readl_phys(p);
-    desc->control   = mem_readl_phys(p + 4);
-    desc->buf_addr1 = mem_readl_phys(p + 8);
-    desc->buf_addr2 = mem_readl_phys(p + 12);
+    /* The descriptor is four consecutive dwords, fetch them in one burst. */
+    dma_bm_read(p, (uint8_t *) desc, sizeof(struct tulip_descriptor), 4);
 
     if (s->csr[0] & CSR0_DBO) {
         bswap32s(&desc->status);
@@ -363,17 +363,17 @@ static void
 tulip_desc_write(TULIPState *s, uint32_t p,
                  struct tulip_descriptor *desc)
 {
+    struct tulip_descriptor swapped;
+
     if (s->csr[0] & CSR0_DBO) {
-        mem_writel_phys(p, bswap32(desc->status));
-        mem_writel_phys(p + 4, bswap32(desc->control));
-        mem_writel_phys(p + 8, bswap32(desc->buf_addr1));
-        mem_writel_phys(p + 12, bswap32(desc->buf_addr2));
-    } else {
-        mem_writel_phys(p, desc->status);
-        mem_writel_phys(p + 4, desc->control);
-        mem_writel_phys(p + 8, desc->buf_addr1);
-        mem_writel_phys(p + 12, desc->buf_addr2);
+        swapped.status    = bswap32(desc->status);
+        swapped.control   = bswap32(desc->control);
+        swapped.buf_addr1 = bswap32(desc->buf_addr1);
+        swapped.buf_addr2 = bswap32(desc->buf_addr2);
+        desc              = &swapped;
     }
+
+    dma_bm_write(p, (uint8_t *) desc, sizeof(struct tulip_descriptor), 4);
 }
 
 static void
@@ -727,7 +727,10 @@ tulip_tx(TULIPState *s, struct tulip_descriptor *desc)
     if (s->tx_frame_len) {
         if ((s->csr[6] >> CSR6_OM_SHIFT) & CSR6_OM_MASK) {
             /* Internal or external Loopback */
-            tulip_receive(s, s->tx_frame, s->tx_frame_len);
+            tulip_receive(s, s->tx_buf, s->tx_frame_len);
+        } else if (s->tx_buf != s->tx_frame) {
+            /* The frame was assembled in the transmit queue already. */
+            network_tx_buf_commit(s->nic, s->tx_frame_len);
         } else if (s->tx_frame_len <= sizeof(s->tx_frame)) {
             //pclog("Transmit!.\n");
             network_tx(s->nic, s->tx_frame, s->tx_frame_len);
@@ -746,21 +749,21 @@ tulip_copy_tx_buffers(TULIPState *s, struct tulip_descriptor *desc)
     int len1 = (desc->control >> TDES1_BUF1_SIZE_SHIFT) & TDES1_BUF1_SIZE_MASK;
     int len2 = (desc->control >> TDES1_BUF2_SIZE_SHIFT) & TDES1_BUF2_SIZE_MASK;
 
-    if (s->tx_frame_len + len1 > sizeof(s->tx_frame)) {
+    if (s->tx_frame_len + len1 > s->tx_buf_size) {
         return -1;
     }
     if (len1) {
         dma_bm_read(desc->buf_addr1,
-                    s->tx_frame + s->tx_frame_len, len1, 4);
+                    s->tx_buf + s->tx_frame_len, len1, 4);
         s->tx_frame_len += len1;
     }
 
-    if (s->tx_frame_len + len2 > sizeof(s->tx_frame)) {
+    if (s->tx_frame_len + len2 > s->tx_buf_size) {
         return -1;
     }
     if (len2) {
         dma_bm_read(desc->buf_addr2,
-                    s->tx_frame + s->tx_frame_len, len2, 4);
+                    s->tx_buf + s->tx_frame_len, len2, 4);
         s->tx_frame_len += len2;
     }
     desc->status = (len1 + len2) ? 0 : 0x7fffffff;
@@ -850,6 +853,19 @@ tulip_xmit_list_update(TULIPState *s)
         } else {
             if (desc.control & TDES1_FS) {
                 s->tx_frame_len = 0;
+
+                /* Unless looping back, DMA the frame straight into the
+                   transmit queue. */
+                s->tx_buf      = s->tx_frame;
+                s->tx_buf_size = sizeof(s->tx_frame);
+                if (!((s->csr[6] >> CSR6_OM_SHIFT) & CSR6_OM_MASK)) {
+                    uint8_t *txbuf = network_tx_buf_get(s->nic);
+
+                    if (txbuf != NULL) {
+                        s->tx_buf      = txbuf;
+                        s->tx_buf_size = NET_MAX_FRAME;
+                    }
+                }
             }
 
             if (!tulip_copy_tx_buffers(s, &desc)) {
@@ -1394,6 +1410,9 @@ nic_init(const device_t *info)
     if (!s)
         return NULL;
 
+    s->tx_buf      = s->tx_frame;
+    s->tx_buf_size = sizeof(s->tx_frame);
+
     if (info->local && info->local != 3) {
         s->bios_addr = 0xD0000;
         s->has_bios  = device_get_config_int("bios");
@@ -67,6 +67,8 @@
 #include <86box/ui.h>
 #include <86box/timer.h>
 #include <86box/network.h>
+#include <86box/trace.h>
+#include <86box/metrics.h>
 #include <86box/net_ne2000.h>
 #include <86box/net_pcnet.h>
 #include <86box/net_wd8003.h>
@@ -143,6 +145,8 @@ static const device_t *net_cards[] = {
 netcard_conf_t net_cards_conf[NET_CARD_MAX];
 uint16_t       net_card_current = 0;
 
+static netcard_t *net_cards_attached[NET_CARD_MAX];
+
 /* Global variables. */
 network_devmap_t network_devmap = {0};
 int  network_ndev;
@@ -150,10 +154,8 @@ netdev_t network_devs[NET_HOST_INTF_MAX];
 
 /* Local variables. */
 
-#if defined     ENABLE_NETWORK_LOG && !defined(_WIN32)
-int             network_do_log = ENABLE_NETWORK_LOG;
-static FILE    *network_dump   = NULL;
-static mutex_t *network_dump_mutex;
+#ifdef ENABLE_NETWORK_LOG
+int network_do_log = ENABLE_NETWORK_LOG;
 
 static void
 network_log(const char *fmt, ...)
@@ -166,42 +168,8 @@ network_log(const char *fmt, ...)
         va_end(ap);
     }
 }
-
-static void
-network_dump_packet(netpkt_t *pkt)
-{
-    if (!network_dump)
-        return;
-
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    struct {
-        uint32_t ts_sec, ts_usec, incl_len, orig_len;
-    } pcap_packet_hdr = {
-        tv.tv_sec, tv.tv_usec, pkt->len, pkt->len
-    };
-
-    if (network_dump_mutex)
-        thread_wait_mutex(network_dump_mutex);
-
-    size_t written;
-    if ((written = fwrite(&pcap_packet_hdr, 1, sizeof(pcap_packet_hdr), network_dump)) < sizeof(pcap_packet_hdr)) {
-        network_log("NETWORK: failed to write dump packet header\n");
-        fseek(network_dump, -written, SEEK_CUR);
-    } else {
-        if ((written = fwrite(pkt->data, 1, pkt->len, network_dump)) < pkt->len) {
-            network_log("NETWORK: failed to write dump packet data\n");
-            fseek(network_dump, -written - sizeof(pcap_packet_hdr), SEEK_CUR);
-        }
-        fflush(network_dump);
-    }
-
-    if (network_dump_mutex)
-        thread_release_mutex(network_dump_mutex);
-}
 #else
 #    define network_log(fmt, ...)
-#    define network_dump_packet(pkt)
 #endif
 
 #ifdef _WIN32
@@ -251,46 +219,81 @@ network_init(void)
     }
 #endif
 
-#if defined ENABLE_NETWORK_LOG && !defined(_WIN32)
-    /* Start packet dump. */
-    network_dump = fopen("network.pcap", "wb");
-
-    struct {
-        uint32_t magic_number;
-        uint16_t version_major, version_minor;
-        int32_t  thiszone;
-        uint32_t sigfigs, snaplen, network;
-    } pcap_hdr = {
-        0xa1b2c3d4,
-        2, 4,
-        0,
-        0, 65535, 1
-    };
-    fwrite(&pcap_hdr, sizeof(pcap_hdr), 1, network_dump);
-    fflush(network_dump);
+#ifdef HAS_TAP
+    if (net_tap_prepare() == 0)
+        network_devmap.has_tap = 1;
 #endif
+
+#ifdef HAS_SHM
+    network_devmap.has_shm = 1;
+#endif
+
 }
 
+/*
+ * Each queue is a single-producer, single-consumer ring, so no locks are
+ * needed: the producer only ever writes head and the consumer only ever
+ * writes tail. Publishing an index with release semantics, and reading the
+ * other side's index with acquire semantics, orders the packet buffer
+ * accesses around them.
+ *
+ *   NET_QUEUE_RX:      host backend thread -> emulation thread
+ *   NET_QUEUE_TX_VM:   emulation thread    -> emulation thread
+ *   NET_QUEUE_TX_HOST: emulation thread    -> host backend thread
+ */
 void
 network_queue_init(netqueue_t *queue)
 {
-    queue->head = queue->tail = 0;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
     for (int i = 0; i < NET_QUEUE_LEN; i++) {
         queue->packets[i].data = calloc(1, NET_MAX_FRAME);
         queue->packets[i].len  = 0;
     }
 }
 
+/* Producer side. */
 static bool
 network_queue_full(netqueue_t *queue)
 {
-    return ((queue->head + 1) & NET_QUEUE_LEN_MASK) == queue->tail;
+    int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    return ((head + 1) & NET_QUEUE_LEN_MASK) == atomic_load_explicit(&queue->tail, memory_order_acquire);
+}
+
+static inline netpkt_t *
+network_queue_head(netqueue_t *queue)
+{
+    return &queue->packets[atomic_load_explicit(&queue->head, memory_order_relaxed)];
 }
 
+static inline void
+network_queue_push(netqueue_t *queue)
+{
+    int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    atomic_store_explicit(&queue->head, (head + 1) & NET_QUEUE_LEN_MASK, memory_order_release);
+}
+
+/* Consumer side. */
 static bool
 network_queue_empty(netqueue_t *queue)
 {
-    return (queue->head == queue->tail);
+    return atomic_load_explicit(&queue->tail, memory_order_relaxed) == atomic_load_explicit(&queue->head, memory_order_acquire);
+}
+
+static inline netpkt_t *
+network_queue_tail(netqueue_t *queue)
+{
+    return &queue->packets[atomic_load_explicit(&queue->tail, memory_order_relaxed)];
+}
+
+static inline void
+network_queue_pop(netqueue_t *queue)
+{
+    int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&queue->tail, (tail + 1) & NET_QUEUE_LEN_MASK, memory_order_release);
 }
 
 static inline void
@@ -308,10 +311,10 @@ network_queue_put(netqueue_t *queue, uint8_t *data, int len)
         return 0;
     }
 
-    netpkt_t *pkt = &queue->packets[queue->head];
+    netpkt_t *pkt = network_queue_head(queue);
     memcpy(pkt->data, data, len);
-    pkt->len    = len;
-    queue->head = (queue->head + 1) & NET_QUEUE_LEN_MASK;
+    pkt->len = len;
+    network_queue_push(queue);
     return 1;
 }
 
@@ -324,19 +327,17 @@ network_queue_put_swap(netqueue_t *queue, netpkt_t *src_pkt)
             network_log("Discarded zero length packet.\n");
         } else if (src_pkt->len > NET_MAX_FRAME) {
             network_log("Discarded oversized packet of len=%d.\n", src_pkt->len);
-            network_dump_packet(src_pkt);
         } else {
             network_log("Discarded %d bytes packet because the queue is full.\n", src_pkt->len);
-            network_dump_packet(src_pkt);
         }
 #endif
         return 0;
     }
 
-    netpkt_t *dst_pkt = &queue->packets[queue->head];
+    netpkt_t *dst_pkt = network_queue_head(queue);
     network_swap_packet(src_pkt, dst_pkt);
 
-    queue->head = (queue->head + 1) & NET_QUEUE_LEN_MASK;
+    network_queue_push(queue);
     return 1;
 }
 
@@ -346,9 +347,9 @@ network_queue_get_swap(netqueue_t *queue, netpkt_t *dst_pkt)
     if (network_queue_empty(queue))
         return 0;
 
-    netpkt_t *src_pkt = &queue->packets[queue->tail];
+    netpkt_t *src_pkt = network_queue_tail(queue);
     network_swap_packet(src_pkt, dst_pkt);
-    queue->tail = (queue->tail + 1) & NET_QUEUE_LEN_MASK;
+    network_queue_pop(queue);
     return 1;
 }
 
@@ -362,12 +363,12 @@ network_queue_move(netqueue_t *dst_q, netqueue_t *src_q)
         return 0;
     }
 
-    netpkt_t *src_pkt = &src_q->packets[src_q->tail];
-    netpkt_t *dst_pkt = &dst_q->packets[dst_q->head];
+    netpkt_t *src_pkt = network_queue_tail(src_q);
+    netpkt_t *dst_pkt = network_queue_head(dst_q);
 
     network_swap_packet(src_pkt, dst_pkt);
-    dst_q->head = (dst_q->head + 1) & NET_QUEUE_LEN_MASK;
-    src_q->tail = (src_q->tail + 1) & NET_QUEUE_LEN_MASK;
+    network_queue_push(dst_q);
+    network_queue_pop(src_q);
 
     return dst_pkt->len;
 }
@@ -379,7 +380,25 @@ network_queue_clear(netqueue_t *queue)
         free(queue->packets[i].data);
         queue->packets[i].len = 0;
     }
-    queue->tail = queue->head = 0;
+    atomic_store(&queue->tail, 0);
+    atomic_store(&queue->head, 0);
+}
+
+/*
+ * Re-arm the timer of a card that went idle. The timer is left disarmed
+ * once a card has seen no traffic for NET_IDLE_TIME, and is brought back
+ * when the card queues a frame for transmission, when the host side queues
+ * a received frame or when the link state changes.
+ */
+static void
+network_wake(netcard_t *card)
+{
+    card->idle_time = 0;
+
+    if (card->idle) {
+        card->idle = 0;
+        timer_on_auto(&card->timer, 200);
+    }
 }
 
 static void
@@ -387,6 +406,11 @@ network_rx_queue(void *priv)
 {
     netcard_t *card = (netcard_t *) priv;
 
+    /* Anything the host side queues from now on will wake us up again. */
+    atomic_store(&card->wake, false);
+
+    TRACE_BEGIN_I(network, "network_rx_queue", "card", card->card_num);
+
     uint32_t new_link_state = net_cards_conf[card->card_num].link_state;
     if (new_link_state != card->link_state) {
         if (card->set_link_state)
@@ -396,45 +420,66 @@ network_rx_queue(void *priv)
 
     uint32_t rx_bytes = 0;
     for (int i = 0; i < NET_QUEUE_LEN; i++) {
-        if (card->queued_pkt.len == 0) {
-            thread_wait_mutex(card->rx_mutex);
-            int res = network_queue_get_swap(&card->queues[NET_QUEUE_RX], &card->queued_pkt);
-            thread_release_mutex(card->rx_mutex);
-            if (!res)
-                break;
-        }
+        if ((card->queued_pkt.len == 0) &&
+            !network_queue_get_swap(&card->queues[NET_QUEUE_RX], &card->queued_pkt))
+            break;
 
-        network_dump_packet(&card->queued_pkt);
+        if (net_dump_enabled)
+            net_dump_packet(card->card_num, 0, card->queued_pkt.data, card->queued_pkt.len);
         int res = card->rx(card->card_drv, card->queued_pkt.data, card->queued_pkt.len);
         if (!res)
             break;
         rx_bytes += card->queued_pkt.len;
         card->queued_pkt.len = 0;
+        metrics.net_rx_packets++;
     }
 
     /* Transmission. */
     uint32_t tx_bytes = 0;
-    thread_wait_mutex(card->tx_mutex);
     for (int i = 0; i < NET_QUEUE_LEN; i++) {
+        if (net_dump_enabled && !network_queue_empty(&card->queues[NET_QUEUE_TX_VM]) &&
+            !network_queue_full(&card->queues[NET_QUEUE_TX_HOST])) {
+            const netpkt_t *pkt = network_queue_tail(&card->queues[NET_QUEUE_TX_VM]);
+            net_dump_packet(card->card_num, 1, pkt->data, pkt->len);
+        }
         uint32_t bytes = network_queue_move(&card->queues[NET_QUEUE_TX_HOST], &card->queues[NET_QUEUE_TX_VM]);
         if (!bytes)
             break;
         tx_bytes += bytes;
+        metrics.net_tx_packets++;
     }
-    thread_release_mutex(card->tx_mutex);
     if (tx_bytes) {
         /* Notify host that a packet is available in the TX queue */
         card->host_drv.notify_in(card->host_drv.priv);
     }
 
+    TRACE_END(network, "network_rx_queue");
+
     double timer_period = card->byte_period * (rx_bytes > tx_bytes ? rx_bytes : tx_bytes);
     if (timer_period < 200)
         timer_period = 200;
 
-    timer_on_auto(&card->timer, timer_period);
-
     bool activity = rx_bytes || tx_bytes;
     bool led_on   = card->led_timer & 0x80000000;
+
+    if (activity || (card->queued_pkt.len != 0))
+        card->idle_time = 0;
+    else
+        card->idle_time += timer_period;
+
+    if ((card->idle_time >= NET_IDLE_TIME) &&
+        network_queue_empty(&card->queues[NET_QUEUE_RX]) &&
+        network_queue_empty(&card->queues[NET_QUEUE_TX_VM])) {
+        /* Nothing moved for a while, stop polling until there is traffic. */
+        if (led_on)
+            ui_sb_update_icon(SB_NETWORK | card->card_num, 0);
+        card->led_timer = 0;
+        card->idle      = 1;
+        return;
+    }
+
+    timer_on_auto(&card->timer, timer_period);
+
     if ((activity && !led_on) || (card->led_timer & 0x7fffffff) >= 150000) {
         ui_sb_update_icon(SB_NETWORK | card->card_num, activity);
         card->led_timer = 0 | (activity << 31);
@@ -443,6 +488,22 @@ network_rx_queue(void *priv)
     card->led_timer += timer_period;
 }
 
+/*
+ * Wake up idle cards that the host side has queued frames for, called
+ * from the emulation thread once per frame. Host threads cannot touch the
+ * timers, so they only raise the card's wake flag.
+ */
+void
+network_process(void)
+{
+    for (int i = 0; i < NET_CARD_MAX; i++) {
+        netcard_t *card = net_cards_attached[i];
+
+        if ((card != NULL) && card->idle && atomic_load(&card->wake))
+            network_wake(card);
+    }
+}
+
 /*
  * Attach a network card to the system.
  *
@@ -459,8 +520,6 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
     card->card_drv        = card_drv;
     card->rx              = rx;
     card->set_link_state  = set_link_state;
-    card->tx_mutex        = thread_create_mutex();
-    card->rx_mutex        = thread_create_mutex();
     card->card_num        = net_card_current;
     card->byte_period     = NET_PERIOD_10M;
 
@@ -491,6 +550,18 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
             card->host_drv      = net_vde_drv;
             card->host_drv.priv = card->host_drv.init(card, mac, net_cards_conf[net_card_current].host_dev_name, net_drv_error);
             break;
+#endif
+#ifdef HAS_TAP
+        case NET_TYPE_TAP:
+            card->host_drv      = net_tap_drv;
+            card->host_drv.priv = card->host_drv.init(card, mac, net_cards_conf[net_card_current].host_dev_name, net_drv_error);
+            break;
+#endif
+#ifdef HAS_SHM
+        case NET_TYPE_SHM:
+            card->host_drv      = net_shm_drv;
+            card->host_drv.priv = card->host_drv.init(card, mac, net_cards_conf[net_card_current].host_dev_name, net_drv_error);
+            break;
 #endif
         default:
             card->host_drv.priv = NULL;
@@ -519,8 +590,6 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
         // If null fails, something is very wrong
         // Clean up and fatal
         if(!card->host_drv.priv) {
-            thread_close_mutex(card->tx_mutex);
-            thread_close_mutex(card->rx_mutex);
             for (int i = 0; i < NET_QUEUE_COUNT; i++) {
                 network_queue_clear(&card->queues[i]);
             }
@@ -534,6 +603,9 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
 
     }
 
+    atomic_init(&card->wake, false);
+    net_cards_attached[card->card_num] = card;
+
     timer_add(&card->timer, network_rx_queue, card, 0);
     timer_on_auto(&card->timer, 100);
 
@@ -543,11 +615,12 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
 void
 netcard_close(netcard_t *card)
 {
+    if (net_cards_attached[card->card_num] == card)
+        net_cards_attached[card->card_num] = NULL;
+
     timer_stop(&card->timer);
     card->host_drv.close(card->host_drv.priv);
 
-    thread_close_mutex(card->tx_mutex);
-    thread_close_mutex(card->rx_mutex);
     for (int i = 0; i < NET_QUEUE_COUNT; i++) {
         network_queue_clear(&card->queues[i]);
     }
@@ -560,10 +633,7 @@ netcard_close(netcard_t *card)
 void
 network_close(void)
 {
-#if defined ENABLE_NETWORK_LOG && !defined(_WIN32)
-    thread_close_mutex(network_dump_mutex);
-    network_dump_mutex = NULL;
-#endif
+    net_dump_close();
 
     network_log("NETWORK: closed.\n");
 }
@@ -581,9 +651,7 @@ network_reset(void)
 {
     ui_sb_update_icon(SB_NETWORK, 0);
 
-#if defined ENABLE_NETWORK_LOG && !defined(_WIN32)
-    network_dump_mutex = thread_create_mutex();
-#endif
+    net_dump_init();
 
     for (uint8_t i = 0; i < NET_CARD_MAX; i++) {
         if (!network_dev_available(i)) {
@@ -601,18 +669,48 @@ void
 network_tx(netcard_t *card, uint8_t *bufp, int len)
 {
     network_queue_put(&card->queues[NET_QUEUE_TX_VM], bufp, len);
+    network_wake(card);
+}
+
+/*
+ * Zero-copy transmission.
+ *
+ * Rather than building a frame in its own buffer and having network_tx()
+ * copy it into the transmit queue, a card can borrow the free buffer at the
+ * head of the queue, DMA the frame straight into it and then commit it. The
+ * buffer holds up to NET_MAX_FRAME bytes and stays owned by the card until it
+ * is committed; it is NULL if the queue is full, in which case the frame
+ * would have been dropped by network_tx() anyway.
+ */
+uint8_t *
+network_tx_buf_get(netcard_t *card)
+{
+    netqueue_t *queue = &card->queues[NET_QUEUE_TX_VM];
+
+    if (network_queue_full(queue))
+        return NULL;
+
+    return network_queue_head(queue)->data;
 }
 
 int
-network_tx_pop(netcard_t *card, netpkt_t *out_pkt)
+network_tx_buf_commit(netcard_t *card, int len)
 {
-    int ret = 0;
+    netqueue_t *queue = &card->queues[NET_QUEUE_TX_VM];
 
-    thread_wait_mutex(card->tx_mutex);
-    ret = network_queue_get_swap(&card->queues[NET_QUEUE_TX_HOST], out_pkt);
-    thread_release_mutex(card->tx_mutex);
+    if (len == 0 || len > NET_MAX_FRAME || network_queue_full(queue))
+        return 0;
 
-    return ret;
+    network_queue_head(queue)->len = len;
+    network_queue_push(queue);
+    network_wake(card);
+    return 1;
+}
+
+int
+network_tx_pop(netcard_t *card, netpkt_t *out_pkt)
+{
+    return network_queue_get_swap(&card->queues[NET_QUEUE_TX_HOST], out_pkt);
 }
 
 int
@@ -621,42 +719,46 @@ network_tx_popv(netcard_t *card, netpkt_t *pkt_vec, int vec_size)
     int pkt_count = 0;
 
     netqueue_t *queue = &card->queues[NET_QUEUE_TX_HOST];
-    thread_wait_mutex(card->tx_mutex);
     for (int i = 0; i < vec_size; i++) {
         if (!network_queue_get_swap(queue, pkt_vec))
             break;
         pkt_count++;
         pkt_vec++;
     }
-    thread_release_mutex(card->tx_mutex);
 
     return pkt_count;
 }
 
+/* Only the host backend thread of a card may put received packets. */
 int
 network_rx_put(netcard_t *card, uint8_t *bufp, int len)
 {
-    int ret = 0;
-
-    thread_wait_mutex(card->rx_mutex);
-    ret = network_queue_put(&card->queues[NET_QUEUE_RX], bufp, len);
-    thread_release_mutex(card->rx_mutex);
+    int ret = network_queue_put(&card->queues[NET_QUEUE_RX], bufp, len);
 
+    atomic_store(&card->wake, true);
     return ret;
 }
 
 int
 network_rx_put_pkt(netcard_t *card, netpkt_t *pkt)
 {
-    int ret = 0;
-
-    thread_wait_mutex(card->rx_mutex);
-    ret = network_queue_put_swap(&card->queues[NET_QUEUE_RX], pkt);
-    thread_release_mutex(card->rx_mutex);
+    int ret = network_queue_put_swap(&card->queues[NET_QUEUE_RX], pkt);
 
+    atomic_store(&card->wake, true);
     return ret;
 }
 
+/* Free slots in the receive queue, for backends that can hold frames back. */
+int
+network_rx_space(netcard_t *card)
+{
+    netqueue_t *queue = &card->queues[NET_QUEUE_RX];
+    int         head  = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    int         tail  = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    return (NET_QUEUE_LEN - 1) - ((head - tail) & NET_QUEUE_LEN_MASK);
+}
+
 void
 network_connect(int id, int connect)
 {
@@ -668,6 +770,10 @@ network_connect(int id, int connect)
     } else {
         net_cards_conf[id].link_state |= NET_LINK_DOWN;
     }
+
+    /* Let an idle card pick up the new link state. */
+    if (net_cards_attached[id] != NULL)
+        atomic_store(&net_cards_attached[id]->wake, true);
 }
 
 int
@@ -752,17 +858,19 @@ network_card_get_internal_name(int card)
     return device_get_internal_name(net_cards[card]);
 }
 
+static const char *
+network_card_get_name(int c)
+{
+    return (net_cards[c] != NULL) ? net_cards[c]->internal_name : NULL;
+}
+
+static device_name_index_t network_card_names = { .get_name = network_card_get_name };
+
 /* UI */
 int
 network_card_get_from_internal_name(char *s)
 {
-    int c = 0;
-
-    while (net_cards[c] != NULL) {
-        if (!strcmp(net_cards[c]->internal_name, s))
-            return c;
-        c++;
-    }
+    int c = device_name_index_find(&network_card_names, s);
 
-    return 0;
+    return (c >= 0) ? c : 0;
 }
@@ -83,6 +83,9 @@ static uint8_t     normal_pci_cards = 0;
 static uint8_t     next_normal_pci_card = 0;
 static uint8_t     pci_card_to_slot_mapping[256][PCI_CARDS_NUM];
 static uint8_t     pci_bus_number_to_index_mapping[256];
+/* Bus number and device to card, folded from the two mappings above; rebuilt
+   whenever either changes, so a configuration access is one lookup. */
+static pci_card_t *pci_card_map[256][PCI_CARDS_NUM];
 static uint8_t     pci_irqs[PCI_IRQS_NUM];
 static uint8_t     pci_irq_level[PCI_IRQS_NUM];
 static uint64_t    pci_irq_hold[PCI_IRQS_NUM];
@@ -96,6 +99,7 @@ static int         pci_trc_reg = 0;
 static uint32_t    pci_enable = 0x00000000;
 
 static void        pci_reset_regs(void);
+static void        pci_card_map_rebuild(void);
 
 #ifdef ENABLE_PCI_LOG
 int pci_do_log = ENABLE_PCI_LOG;
@@ -292,6 +296,8 @@ pci_relocate_slot(int type, int new_slot)
 
     if (pci_card_to_slot_mapping[0][new_slot] == PCI_CARD_INVALID)
         pci_card_to_slot_mapping[0][new_slot] = card;
+
+    pci_card_map_rebuild();
 }
 
 /* Write PCI enable/disable key, split for the ALi M1435. */
@@ -339,23 +345,73 @@ pci_set_pmc(uint8_t pmc)
 }
 
 static void
-pci_reg_write(uint16_t port, uint8_t val)
+pci_card_map_rebuild(void)
+{
+    uint8_t index;
+    uint8_t slot;
+    int     i = 0;
+
+    do {
+        index = pci_bus_number_to_index_mapping[i];
+        for (uint8_t j = 0; j < PCI_CARDS_NUM; j++) {
+            slot = (index == PCI_BUS_INVALID) ? PCI_CARD_INVALID : pci_card_to_slot_mapping[index][j];
+            pci_card_map[i][j] = (slot == PCI_CARD_INVALID) ? NULL : &pci_cards[slot];
+        }
+    } while (i++ < 0xff);
+}
+
+/* Whether a data port access goes to the configuration space right now. */
+static int
+pci_config_port_enabled(uint16_t port)
 {
-    uint8_t slot = 0;
+    if ((port >= 0xcfc) && (port <= 0xcff))
+        return (pci_flags & FLAG_MECHANISM_1) && (pci_flags & FLAG_CONFIG_M1_IO_ON);
+    if ((port >= 0xc000) && (port <= 0xc0ff))
+        return (pci_flags & FLAG_MECHANISM_2) && (pci_flags & (FLAG_CONFIG_IO_ON | FLAG_CONFIG_DEV0_IO_ON));
+    if ((port >= 0xc100) && (port <= 0xcfff))
+        return (pci_flags & FLAG_MECHANISM_2) && (pci_flags & FLAG_CONFIG_IO_ON);
+
+    return 0;
+}
 
+static pci_card_t *
+pci_config_card(uint16_t port)
+{
     if (port >= 0xc000) {
         pci_card  = (port >> 8) & 0xf;
         pci_index = port & 0xfc;
     }
 
-    slot = pci_card_to_slot_mapping[pci_bus_number_to_index_mapping[pci_bus]][pci_card];
-    if (slot != PCI_CARD_INVALID) {
-        if (pci_cards[slot].write)
-            pci_cards[slot].write(pci_func, pci_index | (port & 0x03), val, pci_cards[slot].priv);
+    return pci_card_map[pci_bus][pci_card];
+}
+
+static void
+pci_reg_write(uint16_t port, uint8_t val)
+{
+    const pci_card_t *card = pci_config_card(port);
+
+    if ((card != NULL) && card->write)
+        card->write(pci_func, pci_index | (port & 0x03), val, card->priv);
+    pci_log("PCI: [WB] Mechanism #%i, %s card %02X:%02X, function %02X, index %02X = %02X\n",
+            (port >= 0xc000) ? 2 : 1,
+            (card == NULL) ? "non-existent" : (card->write ? "used" : "unused"),
+            pci_card, pci_bus, pci_func, pci_index | (port & 0x03), val);
+}
+
+/* Aligned word and dword accesses: the card is looked up once, then its
+   registers are written in ascending order, as the byte path would. */
+static void
+pci_reg_write_multi(uint16_t port, uint32_t val, int len)
+{
+    const pci_card_t *card = pci_config_card(port);
+
+    if ((card != NULL) && card->write) {
+        for (int i = 0; i < len; i++)
+            card->write(pci_func, pci_index | ((port + i) & 0x03), (val >> (i << 3)) & 0xff, card->priv);
     }
-    pci_log("PCI: [WB] Mechanism #%i, slot %02X, %s card %02X:%02X, function %02X, index %02X = %02X\n",
-            (port >= 0xc000) ? 2 : 1, slot,
-            (slot == PCI_CARD_INVALID) ? "non-existent" : (pci_cards[slot].write ? "used" : "unused"),
+    pci_log("PCI: [W%c] Mechanism #%i, %s card %02X:%02X, function %02X, index %02X = %08X\n",
+            (len == 4) ? 'L' : 'W', (port >= 0xc000) ? 2 : 1,
+            (card == NULL) ? "non-existent" : (card->write ? "used" : "unused"),
             pci_card, pci_bus, pci_func, pci_index | (port & 0x03), val);
 }
 
@@ -498,13 +554,13 @@ pci_writew(uint16_t port, uint16_t val, UNUSED(void *priv))
         pci_write(port, val & 0xff, priv);
         pci_write(port + 1, val >> 8, priv);
     } else {
-        /* Aligned access, still split because we cheat. */
+        /* Aligned access. */
         switch (port) {
             case 0xcfc:
             case 0xcfe:
             case 0xc000 ... 0xcffe:
-                pci_write(port, val & 0xff, priv);
-                pci_write(port + 1, val >> 8, priv);
+                if (pci_config_port_enabled(port))
+                    pci_reg_write_multi(port, val, 2);
                 break;
 
             default:
@@ -543,9 +599,8 @@ pci_writel(uint16_t port, uint32_t val, UNUSED(void *priv))
                 break;
             case 0xcfc:
             case 0xc000 ... 0xcffc:
-                /* Still split because we cheat. */
-                pci_writew(port, val & 0xffff, priv);
-                pci_writew(port + 2, val >> 16, priv);
+                if (pci_config_port_enabled(port))
+                    pci_reg_write_multi(port, val, 4);
                 break;
 
             default:
@@ -557,22 +612,33 @@ pci_writel(uint16_t port, uint32_t val, UNUSED(void *priv))
 static uint8_t
 pci_reg_read(uint16_t port)
 {
-    uint8_t slot = 0;
-    uint8_t ret  = 0xff;
+    const pci_card_t *card = pci_config_card(port);
+    uint8_t           ret  = 0xff;
+
+    if ((card != NULL) && card->read)
+        ret = card->read(pci_func, pci_index | (port & 0x03), card->priv);
+    pci_log("PCI: [RB] Mechanism #%i, %s card %02X:%02X, function %02X, index %02X = %02X\n",
+            (port >= 0xc000) ? 2 : 1,
+            (card == NULL) ? "non-existent" : (card->read ? "used" : "unused"),
+            pci_card, pci_bus, pci_func, pci_index | (port & 0x03), ret);
 
-    if (port >= 0xc000) {
-        pci_card  = (port >> 8) & 0xf;
-        pci_index = port & 0xfc;
-    }
+    return ret;
+}
 
-    slot = pci_card_to_slot_mapping[pci_bus_number_to_index_mapping[pci_bus]][pci_card];
-    if (slot != PCI_CARD_INVALID) {
-        if (pci_cards[slot].read)
-            ret = pci_cards[slot].read(pci_func, pci_index | (port & 0x03), pci_cards[slot].priv);
+static uint32_t
+pci_reg_read_multi(uint16_t port, int len)
+{
+    const pci_card_t *card = pci_config_card(port);
+    uint32_t          ret  = 0xffffffff >> ((4 - len) << 3);
+
+    if ((card != NULL) && card->read) {
+        ret = 0x00000000;
+        for (int i = 0; i < len; i++)
+            ret |= ((uint32_t) card->read(pci_func, pci_index | ((port + i) & 0x03), card->priv)) << (i << 3);
     }
-    pci_log("PCI: [RB] Mechanism #%i, slot %02X, %s card %02X:%02X, function %02X, index %02X = %02X\n",
-            (port >= 0xc000) ? 2 : 1, slot,
-            (slot == PCI_CARD_INVALID) ? "non-existent" : (pci_cards[slot].read ? "used" : "unused"),
+    pci_log("PCI: [R%c] Mechanism #%i, %s card %02X:%02X, function %02X, index %02X = %08X\n",
+            (len == 4) ? 'L' : 'W', (port >= 0xc000) ? 2 : 1,
+            (card == NULL) ? "non-existent" : (card->read ? "used" : "unused"),
             pci_card, pci_bus, pci_func, pci_index | (port & 0x03), ret);
 
     return ret;
@@ -637,13 +703,13 @@ pci_readw(uint16_t port, UNUSED(void *priv))
         ret = pci_read(port, priv);
         ret |= ((uint16_t) pci_read(port + 1, priv)) << 8;
     } else {
-        /* Aligned access, still split because we cheat. */
+        /* Aligned access. */
         switch (port) {
             case 0xcfc:
             case 0xcfe:
             case 0xc000 ... 0xcffe:
-                ret = pci_read(port, priv);
-                ret |= ((uint16_t) pci_read(port + 1, priv)) << 8;
+                if (pci_config_port_enabled(port))
+                    ret = pci_reg_read_multi(port, 2);
                 break;
 
             default:
@@ -680,9 +746,8 @@ pci_readl(uint16_t port, UNUSED(void *priv))
                 break;
             case 0xcfc:
             case 0xc000 ... 0xcffc:
-                /* Still split because we cheat. */
-                ret = pci_readw(port, priv);
-                ret |= ((uint32_t) pci_readw(port + 2, priv)) << 16;
+                if (pci_config_port_enabled(port))
+                    ret = pci_reg_read_multi(port, 4);
                 break;
         }
     }
@@ -707,6 +772,8 @@ pci_remap_bus(uint8_t bus_index, uint8_t bus_number)
 
     if ((bus_number > 0) && (bus_number < 0xff))
         pci_bus_number_to_index_mapping[bus_number] = bus_index;
+
+    pci_card_map_rebuild();
 }
 
 void
@@ -725,6 +792,7 @@ pci_register_bus_slot(int bus, int card, int type, int inta, int intb, int intc,
     dev->write                          = NULL;
     dev->priv                           = NULL;
     pci_card_to_slot_mapping[bus][card] = last_pci_card;
+    pci_card_map_rebuild();
 
     pci_log("pci_register_slot(): pci_cards[%i].bus = %02X; .id = %02X\n", last_pci_card, bus, card);
 
@@ -934,6 +1002,8 @@ pci_slots_clear(void)
     } while (i++ < 0xff);
 
     pci_bus_number_to_index_mapping[0] = 0; /* always map bus 0 to index 0 */
+
+    pci_card_map_rebuild();
 }
 
 void
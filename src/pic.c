@@ -18,6 +18,7 @@
  *          Copyright 2016-2020 Miran Grca.
  */
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,6 +38,8 @@
 #include <86box/apm.h>
 #include <86box/nvr.h>
 #include <86box/acpi.h>
+#include <86box/snapshot.h>
+#include <86box/device_profile.h>
 #include <86box/plat_unused.h>
 
 enum {
@@ -186,24 +189,31 @@ pic_slave_on(pic_t *dev, int channel)
     return pic_cascade_mode(dev) && (dev->is_master || ((dev->icw4 & 0x0c) == 0x0c)) && (dev->icw3 & (1 << channel));
 }
 
+/* Rotates an IRQ bitmap so that bit 0 is the highest priority line. */
+static __inline uint8_t
+pic_rotate(uint8_t val, uint8_t priority)
+{
+    return (uint8_t) ((val >> priority) | (val << ((8 - priority) & 7)));
+}
+
 static __inline int
 find_best_interrupt(pic_t *dev)
 {
-    uint8_t b;
+    uint8_t isr;
+    uint8_t req;
     uint8_t intr;
-    uint8_t j;
+    int     best;
     int8_t  ret = -1;
 
-    for (uint8_t i = 0; i < 8; i++) {
-        j = (i + dev->priority) & 7;
-        b = 1 << j;
+    /* The highest priority request wins, unless an interrupt of the same or
+       higher priority is in service. */
+    req = (dev->state == 0) ? pic_rotate(dev->irr & ~dev->imr, dev->priority) : 0x00;
+    if (req) {
+        isr  = pic_rotate(dev->isr, dev->priority);
+        best = __builtin_ctz(req);
 
-        if (dev->isr & b)
-            break;
-        else if ((dev->state == 0) && ((dev->irr & ~dev->imr) & b)) {
-            ret = j;
-            break;
-        }
+        if (!isr || (__builtin_ctz(isr) > best))
+            ret = (best + dev->priority) & 7;
     }
 
     intr = dev->interrupt = (ret == -1) ? 0x17 : ret;
@@ -861,6 +871,10 @@ picinterrupt(void)
 {
     int ret = -1;
 
+#ifdef USE_DEVICE_PROFILE
+    uint64_t profile_start = device_profile_start();
+#endif
+
     if (pic.int_pending) {
         if (pic_slave_on(&pic, pic.interrupt)) {
             if (!pic.slaves[pic.interrupt]->int_pending) {
@@ -896,5 +910,26 @@ picinterrupt(void)
         }
     }
 
+#ifdef USE_DEVICE_PROFILE
+    device_profile_end(DEVICE_PROFILE_IRQ, &pic, profile_start);
+#endif
+
     return ret;
 }
+
+void
+pic_snapshot(snapshot_t *snap)
+{
+    /* Both controllers up to their slave pointers, which are fixed wiring. */
+    snapshot_data(snap, &pic, offsetof(pic_t, slaves));
+    snapshot_data(snap, &pic2, offsetof(pic_t, slaves));
+    snapshot_var(snap, kbd_latch);
+    snapshot_var(snap, mouse_latch);
+    snapshot_var(snap, smi_irq_mask);
+    snapshot_var(snap, smi_irq_status);
+    snapshot_var(snap, latched_irqs);
+    snapshot_timer(snap, &pic_timer);
+
+    if (snapshot_loading(snap) && (update_pending != NULL))
+        update_pending();
+}
@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -41,6 +42,7 @@
 #include <86box/sound.h>
 #include <86box/snd_speaker.h>
 #include <86box/video.h>
+#include <86box/snapshot.h>
 #include <86box/plat_unused.h>
 
 pit_intf_t pit_devs[2];
@@ -99,6 +101,9 @@ pit_log(const char *fmt, ...)
 #    define pit_log(fmt, ...)
 #endif
 
+static void pit_sync(pit_t *dev);
+static void pit_schedule(pit_t *dev);
+
 static void
 ctr_set_out(ctr_t *ctr, int out, void *priv)
 {
@@ -445,6 +450,8 @@ pit_ctr_set_gate(void *data, int counter_id, int gate)
     int     old  = ctr->gate;
     uint8_t mode = ctr->m & 3;
 
+    pit_sync(pit);
+
     switch (mode) {
         case 1:
         case 2:
@@ -472,6 +479,8 @@ pit_ctr_set_gate(void *data, int counter_id, int gate)
     }
 
     ctr->gate = gate;
+
+    pit_schedule(pit);
 }
 
 static __inline void
@@ -516,7 +525,164 @@ pit_ctr_set_using_timer(void *data, int counter_id, int using_timer)
         timer_process();
     pit_t *pit       = (pit_t *) data;
     ctr_t *ctr       = &pit->counters[counter_id];
+    pit_sync(pit);
     ctr->using_timer = using_timer;
+    pit_schedule(pit);
+}
+
+/*
+   The timer normally fires on every edge of the PIT clock. As long as the
+   next falling edges would only count the counters down, without changing
+   their state or output, it instead goes straight to the first falling
+   edge that does something, and the counters are moved down by the clocks
+   skipped over in one go. Anything that looks at or changes the counters
+   first catches up to the current time through pit_sync().
+ */
+#define PIT_FAST_MAX 0x10000
+
+/* How many falling edges the counter can take without anything but its
+   count changing, and by how much each one decrements it. */
+static uint32_t
+ctr_fast_ticks(const ctr_t *ctr, int *step)
+{
+    *step = 0;
+
+    if (!ctr->using_timer)
+        return PIT_FAST_MAX;
+
+    if (ctr->latch || ctr->bcd || ((ctr->state & 0x03) == 0x01))
+        return 0;
+
+    switch (ctr->m & 0x07) {
+        case 0:
+            if ((ctr->state == 2) && ctr->gate && (ctr->count >= 1)) {
+                *step = 1;
+                return ctr->count - 1;
+            } else if (ctr->state == 3)
+                *step = 1;
+            break;
+        case 1:
+            if ((ctr->state == 2) && (ctr->count >= 1)) {
+                *step = 1;
+                return ctr->count - 1;
+            } else if ((ctr->state == 3) || (ctr->state == 6))
+                *step = 1;
+            break;
+        case 2:
+        case 6:
+            if (ctr->state == 3)
+                return 0;
+            else if ((ctr->state == 2) && ctr->gate && (ctr->count >= 2)) {
+                *step = 1;
+                return ctr->count - 2;
+            }
+            break;
+        case 3:
+        case 7:
+            if (((ctr->state == 2) || (ctr->state == 3)) && ctr->gate && (ctr->count >= 0)) {
+                if (ctr->newcount)
+                    return 0;
+                *step = 2;
+                return ctr->count >> 1;
+            }
+            break;
+        case 4:
+        case 5:
+            if ((ctr->gate == 0) && (ctr->m == 4))
+                break;
+            if (ctr->state == 3)
+                return 0;
+            else if ((ctr->state == 2) && (ctr->count >= 1)) {
+                *step = 1;
+                return ctr->count - 1;
+            } else if ((ctr->state == 0) || (ctr->state == 6))
+                *step = 1;
+            break;
+
+        default:
+            break;
+    }
+
+    return PIT_FAST_MAX;
+}
+
+static void
+pit_fast_advance(pit_t *dev, uint32_t ticks)
+{
+    ctr_t *ctr;
+    int    step;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        ctr = &dev->counters[i];
+        (void) ctr_fast_ticks(ctr, &step);
+
+        if (step == 1)
+            ctr->count = (ctr->count - ticks) & 0xffff;
+        else if (step == 2)
+            ctr->count -= (ticks << 1);
+    }
+}
+
+/* Catches up with the clocks skipped so far and goes back to one timer
+   event per edge. */
+static void
+pit_sync(pit_t *dev)
+{
+    uint64_t half = dev->pit_const >> 1ULL;
+    uint64_t full = half << 1ULL;
+    uint64_t now  = tsc << 32;
+    uint64_t base;
+    uint64_t done = 0;
+
+    if (!dev->fast_ticks || !timer_is_enabled(&dev->callback_timer))
+        return;
+
+    base = dev->callback_timer.ts.ts64 - (full * (dev->fast_ticks + 1));
+    if (now > base) {
+        done = (now - base) / full;
+        if (done > dev->fast_ticks)
+            done = dev->fast_ticks;
+    }
+
+    pit_fast_advance(dev, (uint32_t) done);
+    dev->fast_ticks = 0;
+    base += done * full;
+
+    if ((now > base) && ((now - base) >= half)) {
+        dev->clock = 1;
+        for (uint8_t i = 0; i < 3; i++)
+            pit_ctr_set_clock_common(&dev->counters[i], 1, dev);
+        dev->callback_timer.ts.ts64 = base + full;
+    } else
+        dev->callback_timer.ts.ts64 = base + half;
+
+    timer_enable(&dev->callback_timer);
+}
+
+/* Called with the timer set for the rising edge after a falling one. */
+static void
+pit_schedule(pit_t *dev)
+{
+    uint32_t ticks = PIT_FAST_MAX;
+    uint32_t ctr_ticks;
+    uint64_t half = dev->pit_const >> 1ULL;
+    int      step;
+
+    if (dev->fast_ticks || dev->clock || !timer_is_enabled(&dev->callback_timer))
+        return;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        ctr_ticks = ctr_fast_ticks(&dev->counters[i], &step);
+        if (ctr_ticks < ticks)
+            ticks = ctr_ticks;
+    }
+
+    if (ticks == 0)
+        return;
+
+    dev->fast_ticks = ticks;
+    dev->callback_timer.ts.ts64 += ((uint64_t) ticks * (half << 1ULL)) + half;
+    timer_enable(&dev->callback_timer);
 }
 
 static void
@@ -524,12 +690,24 @@ pit_timer_over(void *priv)
 {
     pit_t *dev = (pit_t *) priv;
 
+    if (dev->fast_ticks) {
+        pit_fast_advance(dev, dev->fast_ticks);
+        dev->fast_ticks = 0;
+
+        /* The rising edge before the falling one due now. */
+        dev->clock = 1;
+        for (uint8_t i = 0; i < 3; i++)
+            pit_ctr_set_clock_common(&dev->counters[i], 1, dev);
+    }
+
     dev->clock ^= 1;
 
     for (uint8_t i = 0; i < 3; i++)
         pit_ctr_set_clock_common(&dev->counters[i], dev->clock, dev);
 
     timer_advance_u64(&dev->callback_timer, dev->pit_const >> 1ULL);
+
+    pit_schedule(dev);
 }
 
 static void
@@ -543,6 +721,8 @@ pit_write(uint16_t addr, uint8_t val, void *priv)
         pit_log("[%04X:%08X] pit_write(%04X, %02X, %08X)\n", CS, cpu_state.pc, addr, val, priv);
     }
 
+    pit_sync(dev);
+
     switch (addr & 3) {
         case 3: /* control */
             t = val >> 6;
@@ -671,6 +851,8 @@ pit_write(uint16_t addr, uint8_t val, void *priv)
         default:
             break;
     }
+
+    pit_schedule(dev);
 }
 
 extern uint8_t *ram;
@@ -720,6 +902,8 @@ pit_read(uint16_t addr, void *priv)
     int     t = (addr & 3);
     ctr_t  *ctr;
 
+    pit_sync(dev);
+
     switch (addr & 3) {
         case 3: /* Control. */
             /* This is 8254-only, 8253 returns 0x00. */
@@ -791,6 +975,8 @@ pit_read(uint16_t addr, void *priv)
         pit_log("[%04X:%08X] pit_read(%04X, %08X) = %02X\n", CS, cpu_state.pc, addr, priv, ret);
     }
 
+    pit_schedule(dev);
+
     return ret;
 }
 
@@ -872,6 +1058,8 @@ ctr_reset(ctr_t *ctr)
 void
 pit_device_reset(pit_t *dev)
 {
+    pit_sync(dev);
+
     dev->clock = 0;
 
     for (uint8_t i = 0; i < 3; i++)
@@ -903,7 +1091,9 @@ pit_set_pit_const(void *data, uint64_t pit_const)
 {
     pit_t *pit = (pit_t *) data;
 
+    pit_sync(pit);
     pit->pit_const = pit_const;
+    pit_schedule(pit);
 }
 
 static void
@@ -952,6 +1142,20 @@ pit_init(const device_t *info)
     return dev;
 }
 
+static void
+pit_snapshot(void *priv, snapshot_t *snap)
+{
+    pit_t *dev = (pit_t *) priv;
+
+    /* The counters up to their callbacks, which belong to the machine. */
+    for (uint8_t i = 0; i < 3; i++)
+        snapshot_data(snap, &dev->counters[i], offsetof(ctr_t, load_func));
+    snapshot_var(snap, dev->ctrl);
+    snapshot_var(snap, dev->pit_const);
+    snapshot_var(snap, dev->fast_ticks);
+    snapshot_timer(snap, &dev->callback_timer);
+}
+
 const device_t i8253_device = {
     .name          = "Intel 8253/8253-5 Programmable Interval Timer",
     .internal_name = "i8253",
@@ -963,7 +1167,8 @@ const device_t i8253_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pit_snapshot
 };
 
 const device_t i8253_ext_io_device = {
@@ -977,7 +1182,8 @@ const device_t i8253_ext_io_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pit_snapshot
 };
 
 const device_t i8254_device = {
@@ -991,7 +1197,8 @@ const device_t i8254_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pit_snapshot
 };
 
 const device_t i8254_sec_device = {
@@ -1005,7 +1212,8 @@ const device_t i8254_sec_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pit_snapshot
 };
 
 const device_t i8254_ext_io_device = {
@@ -1019,7 +1227,8 @@ const device_t i8254_ext_io_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pit_snapshot
 };
 
 const device_t i8254_ps2_device = {
@@ -1033,7 +1242,8 @@ const device_t i8254_ps2_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pit_snapshot
 };
 
 pit_t *
@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -41,6 +42,7 @@
 #include <86box/sound.h>
 #include <86box/snd_speaker.h>
 #include <86box/video.h>
+#include <86box/snapshot.h>
 
 #define PIT_PS2          16  /* The PIT is the PS/2's second PIT. */
 #define PIT_EXT_IO       32  /* The PIT has externally specified port I/O. */
@@ -743,6 +745,19 @@ pitf_init(const device_t *info)
     return dev;
 }
 
+static void
+pitf_snapshot(void *priv, snapshot_t *snap)
+{
+    pitf_t *dev = (pitf_t *) priv;
+
+    /* The counters up to their timers and callbacks. */
+    for (uint8_t i = 0; i < 3; i++) {
+        snapshot_data(snap, &dev->counters[i], offsetof(ctrf_t, timer));
+        snapshot_timer(snap, &dev->counters[i].timer);
+    }
+    snapshot_var(snap, dev->ctrl);
+}
+
 const device_t i8253_fast_device = {
     .name          = "Intel 8253/8253-5 Programmable Interval Timer",
     .internal_name = "i8253_fast",
@@ -754,7 +769,8 @@ const device_t i8253_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pitf_snapshot
 };
 
 const device_t i8254_fast_device = {
@@ -768,7 +784,8 @@ const device_t i8254_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pitf_snapshot
 };
 
 const device_t i8254_sec_fast_device = {
@@ -782,7 +799,8 @@ const device_t i8254_sec_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pitf_snapshot
 };
 
 const device_t i8254_ext_io_fast_device = {
@@ -796,7 +814,8 @@ const device_t i8254_ext_io_fast_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pitf_snapshot
 };
 
 const device_t i8254_ps2_fast_device = {
@@ -810,7 +829,8 @@ const device_t i8254_ps2_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .snapshot      = pitf_snapshot
 };
 
 const pit_intf_t pit_fast_intf = {
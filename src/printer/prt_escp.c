@@ -60,6 +60,7 @@
 #include "cpu.h"
 #include <86box/machine.h>
 #include <86box/timer.h>
+#include <86box/thread.h>
 #include <86box/mem.h>
 #include <86box/rom.h>
 #include <86box/pit.h>
@@ -154,6 +155,50 @@ typedef struct psurface_t {
     uint8_t *pixels; /* grayscale pixel data */
 } psurface_t;
 
+/*
+ * Rendered glyph cache. Each distinct font setup (file, size and
+ * italics transform) keeps its FreeType face open, together with a
+ * direct-mapped table of glyphs already rendered at that setup, so that
+ * switching styles back and forth neither reloads the font file nor
+ * re-renders every character.
+ */
+#define FONT_CACHE_SIZE  8
+#define GLYPH_CACHE_SIZE 256
+
+typedef struct glyph_t {
+    FT_UInt  index; /* glyph index + 1, 0 if the slot is empty */
+    int      left;
+    int      top;
+    FT_Pos   advance_x;
+    uint16_t width;
+    uint16_t rows;
+    uint8_t *buffer; /* width x rows coverage */
+} glyph_t;
+
+typedef struct font_t {
+    const char *fn;
+    FT_F26Dot6  hsize;
+    FT_F26Dot6  vsize;
+    int8_t      italics;
+    FT_Face     face;
+    glyph_t     glyphs[GLYPH_CACHE_SIZE];
+} font_t;
+
+/*
+ * Pages waiting to be written out as PNG by the output thread. They are
+ * held run-length compressed, since a page is mostly blank and a long
+ * job can queue up many of them while the slow PNG encoder catches up.
+ */
+typedef struct page_job_t {
+    struct page_job_t *next;
+    char               path[1024];
+    uint16_t           w;
+    uint16_t           h;
+    uint32_t           size;
+    uint8_t           *data;
+    PALETTE            palcol;
+} page_job_t;
+
 typedef struct escp_t {
     const char *name;
 
@@ -221,6 +266,9 @@ typedef struct escp_t {
     double      curr_y; /* print head position (y, inch) */
     uint16_t    current_font;
     FT_Face     fontface;
+    font_t     *font;
+    font_t      fonts[FONT_CACHE_SIZE];
+    int         font_next;
     int8_t      lq_typeface;
     uint16_t    font_style;
     uint8_t     print_quality;
@@ -251,12 +299,20 @@ typedef struct escp_t {
     uint8_t ctrl;
 
     PALETTE palcol;
+
+    /* page output */
+    thread_t   *page_thread;
+    event_t    *page_event;
+    mutex_t    *page_mutex;
+    page_job_t *page_queue;
+    page_job_t *page_queue_tail;
+    int         page_stop;
 } escp_t;
 
 static void
 update_font(escp_t *dev);
 static void
-blit_glyph(escp_t *dev, unsigned destx, unsigned desty, int8_t add);
+blit_glyph(escp_t *dev, const glyph_t *glyph, unsigned destx, unsigned desty, int8_t add);
 static void
 draw_hline(escp_t *dev, unsigned from_x, unsigned to_x, unsigned y, int8_t broken);
 static void
@@ -346,15 +402,138 @@ escp_log(const char *fmt, ...)
 #    define escp_log(fmt, ...)
 #endif
 
-/* Dump the current page into a formatted file. */
+/*
+ * PackBits style run-length coding: a control byte c below 0x80 is
+ * followed by c + 1 literal bytes, otherwise the next byte is repeated
+ * (c & 0x7f) + 2 times.
+ */
+static uint32_t
+page_compress(uint8_t *dst, const psurface_t *page)
+{
+    uint8_t *out = dst;
+
+    for (uint16_t y = 0; y < page->h; y++) {
+        const uint8_t *row = page->pixels + (size_t) y * page->pitch;
+        unsigned       x   = 0;
+
+        while (x < page->w) {
+            unsigned run = 1;
+
+            while ((x + run < page->w) && (run < 129) && (row[x + run] == row[x]))
+                run++;
+
+            if (run >= 2) {
+                *out++ = 0x80 | (run - 2);
+                *out++ = row[x];
+                x += run;
+            } else {
+                unsigned lit = 1;
+
+                while ((x + lit < page->w) && (lit < 128) &&
+                       ((x + lit + 1 >= page->w) || (row[x + lit] != row[x + lit + 1])))
+                    lit++;
+
+                *out++ = lit - 1;
+                memcpy(out, &row[x], lit);
+                out += lit;
+                x += lit;
+            }
+        }
+    }
+
+    return out - dst;
+}
+
 static void
-dump_page(escp_t *dev)
+page_decompress(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+    const uint8_t *end = src + size;
+
+    while (src < end) {
+        uint8_t c = *src++;
+
+        if (c & 0x80) {
+            memset(dst, *src++, (c & 0x7f) + 2);
+            dst += (c & 0x7f) + 2;
+        } else {
+            memcpy(dst, src, c + 1);
+            dst += c + 1;
+            src += c + 1;
+        }
+    }
+}
+
+static void
+page_thread(void *priv)
 {
-    char path[1024];
+    escp_t     *dev    = (escp_t *) priv;
+    uint8_t    *pixels = NULL;
+    page_job_t *job;
+    int         stop;
+
+    while (1) {
+        thread_wait_event(dev->page_event, -1);
+        thread_reset_event(dev->page_event);
+
+        while (1) {
+            thread_wait_mutex(dev->page_mutex);
+            job = dev->page_queue;
+            if (job != NULL) {
+                dev->page_queue = job->next;
+                if (dev->page_queue == NULL)
+                    dev->page_queue_tail = NULL;
+            }
+            stop = dev->page_stop;
+            thread_release_mutex(dev->page_mutex);
 
-    strcpy(path, dev->pagepath);
-    strcat(path, dev->page_fn);
-    png_write_rgb(path, dev->page->pixels, dev->page->w, dev->page->h, dev->page->pitch, dev->palcol);
+            if (job == NULL)
+                break;
+
+            pixels = (uint8_t *) realloc(pixels, (size_t) job->w * job->h);
+            page_decompress(pixels, job->data, job->size);
+            png_write_rgb(job->path, pixels, job->w, job->h, job->w, job->palcol);
+
+            free(job->data);
+            free(job);
+        }
+
+        if (stop)
+            break;
+    }
+
+    free(pixels);
+}
+
+/* Queue the current page for writing out into a formatted file. */
+static void
+dump_page(escp_t *dev)
+{
+    const psurface_t *page = dev->page;
+    page_job_t       *job  = (page_job_t *) calloc(1, sizeof(page_job_t));
+    uint8_t          *data;
+
+    strcpy(job->path, dev->pagepath);
+    strcat(job->path, dev->page_fn);
+    job->w = page->w;
+    job->h = page->h;
+    memcpy(job->palcol, dev->palcol, sizeof(PALETTE));
+
+    /* Worst case is one control byte per 128 literals, plus one per row. */
+    data      = (uint8_t *) malloc((size_t) page->w * page->h + ((size_t) page->w * page->h) / 128 + page->h + 1);
+    job->size = page_compress(data, page);
+    job->data = (uint8_t *) realloc(data, job->size ? job->size : 1);
+
+    escp_log("ESC/P: queued page %s, %u bytes compressed\n", job->path, job->size);
+
+    thread_wait_mutex(dev->page_mutex);
+    if (dev->page_queue_tail != NULL)
+        dev->page_queue_tail->next = job;
+    else
+        dev->page_queue = job;
+    dev->page_queue_tail = job;
+    thread_release_mutex(dev->page_mutex);
+
+    thread_set_event(dev->page_event);
 }
 
 static void
@@ -492,12 +671,30 @@ init_codepage(escp_t *dev, uint16_t num)
     select_codepage(num, dev->curr_cpmap);
 }
 
+static void
+font_cache_release(font_t *font)
+{
+    for (int i = 0; i < GLYPH_CACHE_SIZE; i++) {
+        free(font->glyphs[i].buffer);
+        font->glyphs[i].buffer = NULL;
+        font->glyphs[i].index  = 0;
+    }
+
+    if (font->face != NULL)
+        FT_Done_Face(font->face);
+    font->face = NULL;
+}
+
 static void
 update_font(escp_t *dev)
 {
     char        path[1024];
     const char *fn;
     FT_Matrix   matrix;
+    font_t     *font;
+    FT_F26Dot6  hsize;
+    FT_F26Dot6  vsize;
+    int8_t      italics;
     double      hpoints = 10.5;
     double      vpoints = 10.5;
 
@@ -505,10 +702,6 @@ update_font(escp_t *dev)
     if (ft_lib == NULL)
         return;
 
-    /* Release current font if we have one. */
-    if (dev->fontface)
-        FT_Done_Face(dev->fontface);
-
     if (dev->print_quality == QUALITY_DRAFT) {
         if (dev->font_style & STYLE_ITALICS)
             fn = FONT_FILE_DOTMATRIX_ITALIC;
@@ -538,19 +731,6 @@ update_font(escp_t *dev)
                 fn = FONT_FILE_ROMAN;
         }
 
-    /* Create a full pathname for the ROM file. */
-    strcpy(path, dev->fontpath);
-    path_slash(path);
-    strcat(path, fn);
-
-    escp_log("Temp file=%s\n", path);
-
-    /* Load the new font. */
-    if (FT_New_Face(ft_lib, path, 0, &dev->fontface)) {
-        escp_log("ESC/P: unable to load font '%s'\n", path);
-        dev->fontface = NULL;
-    }
-
     if (!dev->multipoint_mode) {
         dev->actual_cpi = dev->cpi;
 
@@ -592,18 +772,89 @@ update_font(escp_t *dev)
         dev->actual_cpi /= 2.0 / 3.0;
     }
 
-    FT_Set_Char_Size(dev->fontface,
-                     (uint16_t) (hpoints * 64), (uint16_t) (vpoints * 64),
-                     dev->dpi, dev->dpi);
+    hsize   = (uint16_t) (hpoints * 64);
+    vsize   = (uint16_t) (vpoints * 64);
+    italics = (dev->print_quality != QUALITY_DRAFT) && ((dev->font_style & STYLE_ITALICS) || (dev->char_tables[dev->curr_char_table] == 0));
+
+    /* Reuse the face if this setup was loaded before. */
+    for (int i = 0; i < FONT_CACHE_SIZE; i++) {
+        font = &dev->fonts[i];
+        if ((font->face != NULL) && (font->fn == fn) && (font->hsize == hsize) &&
+            (font->vsize == vsize) && (font->italics == italics)) {
+            dev->font     = font;
+            dev->fontface = font->face;
+            return;
+        }
+    }
+
+    /* Otherwise replace the oldest one. */
+    font = &dev->fonts[dev->font_next];
+    dev->font_next = (dev->font_next + 1) % FONT_CACHE_SIZE;
+    font_cache_release(font);
 
-    if ((dev->print_quality != QUALITY_DRAFT) && ((dev->font_style & STYLE_ITALICS) || (dev->char_tables[dev->curr_char_table] == 0))) {
+    /* Create a full pathname for the ROM file. */
+    strcpy(path, dev->fontpath);
+    path_slash(path);
+    strcat(path, fn);
+
+    escp_log("Temp file=%s\n", path);
+
+    /* Load the new font. */
+    dev->font     = NULL;
+    dev->fontface = NULL;
+    if (FT_New_Face(ft_lib, path, 0, &font->face)) {
+        escp_log("ESC/P: unable to load font '%s'\n", path);
+        font->face = NULL;
+        return;
+    }
+
+    font->fn      = fn;
+    font->hsize   = hsize;
+    font->vsize   = vsize;
+    font->italics = italics;
+
+    FT_Set_Char_Size(font->face, hsize, vsize, dev->dpi, dev->dpi);
+
+    if (italics) {
         /* Italics transformation. */
         matrix.xx = 0x10000L;
         matrix.xy = (FT_Fixed) (0.20 * 0x10000L);
         matrix.yx = 0;
         matrix.yy = 0x10000L;
-        FT_Set_Transform(dev->fontface, &matrix, 0);
+        FT_Set_Transform(font->face, &matrix, 0);
     }
+
+    dev->font     = font;
+    dev->fontface = font->face;
+}
+
+/* Get a glyph of the current font, rendering it on first use. */
+static const glyph_t *
+font_cache_glyph(font_t *font, uint16_t code)
+{
+    FT_UInt          char_index = FT_Get_Char_Index(font->face, code);
+    glyph_t         *glyph      = &font->glyphs[char_index & (GLYPH_CACHE_SIZE - 1)];
+    const FT_Bitmap *bitmap;
+
+    if (glyph->index == (char_index + 1))
+        return glyph;
+
+    FT_Load_Glyph(font->face, char_index, FT_LOAD_DEFAULT);
+    FT_Render_Glyph(font->face->glyph, FT_RENDER_MODE_NORMAL);
+    bitmap = &font->face->glyph->bitmap;
+
+    free(glyph->buffer);
+    glyph->index     = char_index + 1;
+    glyph->left      = font->face->glyph->bitmap_left;
+    glyph->top       = font->face->glyph->bitmap_top;
+    glyph->advance_x = font->face->glyph->advance.x;
+    glyph->width     = bitmap->width;
+    glyph->rows      = bitmap->rows;
+    glyph->buffer    = (uint8_t *) malloc((size_t) glyph->width * glyph->rows + 1);
+    for (unsigned int y = 0; y < bitmap->rows; y++)
+        memcpy(glyph->buffer + y * glyph->width, bitmap->buffer + y * bitmap->pitch, glyph->width);
+
+    return glyph;
 }
 
 /* This is the actual ESC/P interpreter. */
@@ -1535,7 +1786,7 @@ process_char(escp_t *dev, uint8_t ch)
 static void
 handle_char(escp_t *dev, uint8_t ch)
 {
-    FT_UInt  char_index;
+    const glyph_t *glyph;
     uint16_t pen_x;
     uint16_t pen_y;
     uint16_t line_start;
@@ -1569,50 +1820,46 @@ handle_char(escp_t *dev, uint8_t ch)
     }
 
     /* We cannot print if we have no font loaded. */
-    if (dev->fontface == NULL)
+    if ((dev->fontface == NULL) || (ft_lib == NULL))
         return;
 
     if (ch == 0x01)
         ch = 0x20;
 
     /* ok, so we need to print the character now */
-    if (ft_lib) {
-        char_index = FT_Get_Char_Index(dev->fontface, dev->curr_cpmap[ch]);
-        FT_Load_Glyph(dev->fontface, char_index, FT_LOAD_DEFAULT);
-        FT_Render_Glyph(dev->fontface->glyph, FT_RENDER_MODE_NORMAL);
-    }
+    glyph = font_cache_glyph(dev->font, dev->curr_cpmap[ch]);
 
-    pen_x = PIXX + fmax(0.0, dev->fontface->glyph->bitmap_left);
-    pen_y = (uint16_t) (PIXY + fmax(0.0, -dev->fontface->glyph->bitmap_top + dev->fontface->size->metrics.ascender / 64));
+    pen_x = PIXX + fmax(0.0, glyph->left);
+    pen_y = (uint16_t) (PIXY + fmax(0.0, -glyph->top + dev->fontface->size->metrics.ascender / 64));
 
     if (dev->font_style & STYLE_SUBSCRIPT)
-        pen_y += dev->fontface->glyph->bitmap.rows / 2;
+        pen_y += glyph->rows / 2;
 
     /* mark the page as dirty if anything is drawn */
     if ((ch != 0x20) || (dev->font_score != SCORE_NONE))
         dev->page->dirty = 1;
 
     /* draw the glyph */
-    blit_glyph(dev, pen_x, pen_y, 0);
-    blit_glyph(dev, pen_x + 1, pen_y, 1);
+    blit_glyph(dev, glyph, pen_x, pen_y, 0);
+    blit_glyph(dev, glyph, pen_x + 1, pen_y, 1);
 
     /* doublestrike -> draw glyph a second time, 1px below */
     if (dev->font_style & STYLE_DOUBLESTRIKE) {
-        blit_glyph(dev, pen_x, pen_y + 1, 1);
-        blit_glyph(dev, pen_x + 1, pen_y + 1, 1);
+        blit_glyph(dev, glyph, pen_x, pen_y + 1, 1);
+        blit_glyph(dev, glyph, pen_x + 1, pen_y + 1, 1);
     }
 
     /* bold -> draw glyph a second time, 1px to the right */
     if (dev->font_style & STYLE_BOLD) {
-        blit_glyph(dev, pen_x + 1, pen_y, 1);
-        blit_glyph(dev, pen_x + 2, pen_y, 1);
-        blit_glyph(dev, pen_x + 3, pen_y, 1);
+        blit_glyph(dev, glyph, pen_x + 1, pen_y, 1);
+        blit_glyph(dev, glyph, pen_x + 2, pen_y, 1);
+        blit_glyph(dev, glyph, pen_x + 3, pen_y, 1);
     }
 
     line_start = PIXX;
 
     if (dev->font_style & STYLE_PROP)
-        x_advance = dev->fontface->glyph->advance.x / (dev->dpi * 64.0);
+        x_advance = glyph->advance_x / (dev->dpi * 64.0);
     else {
         if (dev->hmi < 0)
             x_advance = 1.0 / dev->actual_cpi;
@@ -1649,24 +1896,30 @@ handle_char(escp_t *dev, uint8_t ch)
     }
 }
 
-/* TODO: This can be optimized quite a bit... I'm just too lazy right now ;-) */
 static void
-blit_glyph(escp_t *dev, unsigned destx, unsigned desty, int8_t add)
+blit_glyph(escp_t *dev, const glyph_t *glyph, unsigned destx, unsigned desty, int8_t add)
 {
-    const FT_Bitmap *bitmap = &dev->fontface->glyph->bitmap;
-    uint8_t          src;
-    uint8_t         *dst;
+    unsigned int width = glyph->width;
+    unsigned int rows  = glyph->rows;
+    uint8_t      src;
+    uint8_t     *dst;
 
-    /* check if freetype is available */
-    if (ft_lib == NULL)
+    /* Clip to the page once rather than per pixel. */
+    if (destx >= (unsigned) dev->page->w || desty >= (unsigned) dev->page->h)
         return;
-
-    for (unsigned int y = 0; y < bitmap->rows; y++) {
-        for (unsigned int x = 0; x < bitmap->width; x++) {
-            src = *(bitmap->buffer + x + y * bitmap->pitch);
-            /* ignore background, and respect page size */
-            if (src > 0 && (destx + x < (unsigned) dev->page->w) && (desty + y < (unsigned) dev->page->h)) {
-                dst = (uint8_t *) dev->page->pixels + (x + destx) + (y + desty) * dev->page->pitch;
+    if (destx + width > (unsigned) dev->page->w)
+        width = dev->page->w - destx;
+    if (desty + rows > (unsigned) dev->page->h)
+        rows = dev->page->h - desty;
+
+    for (unsigned int y = 0; y < rows; y++) {
+        const uint8_t *line = glyph->buffer + y * glyph->width;
+
+        dst = (uint8_t *) dev->page->pixels + destx + (y + desty) * dev->page->pitch;
+        for (unsigned int x = 0; x < width; x++, dst++) {
+            src = line[x];
+            /* ignore background */
+            if (src > 0) {
                 src >>= 3;
 
                 if (add) {
@@ -2033,6 +2286,10 @@ escp_init(void *lpt)
     timer_add(&dev->pulse_timer, pulse_timer, dev, 0);
     timer_add(&dev->timeout_timer, timeout_timer, dev, 0);
 
+    dev->page_mutex  = thread_create_mutex();
+    dev->page_event  = thread_create_event();
+    dev->page_thread = thread_create_named(page_thread, dev, "ESC/P page output");
+
     return dev;
 }
 
@@ -2054,6 +2311,18 @@ escp_close(void *priv)
         free(dev->page);
     }
 
+    /* Let the output thread finish the queued pages. */
+    thread_wait_mutex(dev->page_mutex);
+    dev->page_stop = 1;
+    thread_release_mutex(dev->page_mutex);
+    thread_set_event(dev->page_event);
+    thread_wait(dev->page_thread);
+    thread_destroy_event(dev->page_event);
+    thread_close_mutex(dev->page_mutex);
+
+    for (int i = 0; i < FONT_CACHE_SIZE; i++)
+        font_cache_release(&dev->fonts[i]);
+
     free(dev);
 }
 
@@ -29,6 +29,7 @@
 #include <86box/path.h>
 #include <86box/plat.h>
 #include <86box/plat_dynld.h>
+#include <86box/thread.h>
 #include <86box/ui.h>
 #include <86box/prt_devs.h>
 
@@ -110,6 +111,26 @@ static dllimp_t ghostscript_imports[] = {
 
 static void *ghostscript_handle = NULL;
 
+/*
+ * Finished jobs are converted by a single background thread, shared by
+ * all PostScript printers, so that the guest keeps running while
+ * Ghostscript works. One conversion runs at a time: Ghostscript only
+ * supports one interpreter instance per process in most builds, and
+ * queued jobs simply wait their turn as spooled .ps files.
+ */
+typedef struct ps_job_t {
+    struct ps_job_t *next;
+    char             input_fn[1024];
+} ps_job_t;
+
+static thread_t *ps_thread       = NULL;
+static event_t  *ps_event        = NULL;
+static mutex_t  *ps_mutex        = NULL;
+static ps_job_t *ps_queue        = NULL;
+static ps_job_t *ps_queue_tail   = NULL;
+static bool      ps_thread_stop  = false;
+static int       ps_users        = 0;
+
 static void
 reset_ps(ps_t *dev)
 {
@@ -139,18 +160,13 @@ pulse_timer(void *priv)
 }
 
 static int
-convert_to_pdf(ps_t *dev)
+convert_to_pdf(char *input_fn)
 {
     volatile int code;
     void        *instance = NULL;
-    char         input_fn[1024];
     char         output_fn[1024];
     char        *gsargv[9];
 
-    strcpy(input_fn, dev->printer_path);
-    path_slash(input_fn);
-    strcat(input_fn, dev->filename);
-
     strcpy(output_fn, input_fn);
     strcpy(output_fn + strlen(output_fn) - 3, ".pdf");
 
@@ -164,7 +180,7 @@ convert_to_pdf(ps_t *dev)
     gsargv[7] = output_fn;
     gsargv[8] = input_fn;
 
-    code = gsapi_new_instance(&instance, dev);
+    code = gsapi_new_instance(&instance, NULL);
     if (code < 0)
         return code;
 
@@ -188,6 +204,60 @@ convert_to_pdf(ps_t *dev)
     return code;
 }
 
+static void
+ps_thread_func(UNUSED(void *priv))
+{
+    ps_job_t *job;
+    bool      stop;
+
+    while (1) {
+        thread_wait_event(ps_event, -1);
+        thread_reset_event(ps_event);
+
+        while (1) {
+            thread_wait_mutex(ps_mutex);
+            job = ps_queue;
+            if (job != NULL) {
+                ps_queue = job->next;
+                if (ps_queue == NULL)
+                    ps_queue_tail = NULL;
+            }
+            stop = ps_thread_stop;
+            thread_release_mutex(ps_mutex);
+
+            if (job == NULL)
+                break;
+
+            convert_to_pdf(job->input_fn);
+            free(job);
+        }
+
+        if (stop)
+            break;
+    }
+}
+
+/* Hand a finished job over to the conversion thread. */
+static void
+queue_conversion(ps_t *dev)
+{
+    ps_job_t *job = (ps_job_t *) calloc(1, sizeof(ps_job_t));
+
+    strcpy(job->input_fn, dev->printer_path);
+    path_slash(job->input_fn);
+    strcat(job->input_fn, dev->filename);
+
+    thread_wait_mutex(ps_mutex);
+    if (ps_queue_tail != NULL)
+        ps_queue_tail->next = job;
+    else
+        ps_queue = job;
+    ps_queue_tail = job;
+    thread_release_mutex(ps_mutex);
+
+    thread_set_event(ps_event);
+}
+
 static void
 write_buffer(ps_t *dev, bool finish)
 {
@@ -210,7 +280,7 @@ write_buffer(ps_t *dev, bool finish)
 
     fseek(fp, 0, SEEK_END);
 
-    fprintf(fp, "%.*s", POSTSCRIPT_BUFFER_LENGTH, dev->buffer);
+    fwrite(dev->buffer, 1, dev->buffer_pos, fp);
 
     fclose(fp);
 
@@ -219,7 +289,7 @@ write_buffer(ps_t *dev, bool finish)
 
     if (finish) {
         if (ghostscript_handle != NULL)
-            convert_to_pdf(dev);
+            queue_conversion(dev);
 
         dev->filename[0] = 0;
     }
@@ -339,6 +409,9 @@ ps_init(void *lpt)
     dev->ctrl = 0x04;
     dev->lpt  = lpt;
 
+    if (ps_users++ > 0)
+        goto loaded;
+
     /* Try loading the DLL. */
     ghostscript_handle = dynld_module(PATH_GHOSTSCRIPT_DLL, ghostscript_imports);
 #ifdef PATH_GHOSTSCRIPT_DLL_ALT1
@@ -361,6 +434,12 @@ ps_init(void *lpt)
         }
     }
 
+    ps_thread_stop = false;
+    ps_mutex       = thread_create_mutex();
+    ps_event       = thread_create_event();
+    ps_thread      = thread_create_named(ps_thread_func, NULL, "PostScript conversion");
+
+loaded:
     /* Cache print folder path. */
     memset(dev->printer_path, 0x00, sizeof(dev->printer_path));
     path_append_filename(dev->printer_path, usr_path, "printer");
@@ -387,9 +466,21 @@ ps_close(void *priv)
     if (dev->buffer[0] != 0)
         write_buffer(dev, true);
 
-    if (ghostscript_handle != NULL) {
-        dynld_close(ghostscript_handle);
-        ghostscript_handle = NULL;
+    if (--ps_users == 0) {
+        /* Finish the queued conversions before unloading Ghostscript. */
+        thread_wait_mutex(ps_mutex);
+        ps_thread_stop = true;
+        thread_release_mutex(ps_mutex);
+        thread_set_event(ps_event);
+        thread_wait(ps_thread);
+        thread_destroy_event(ps_event);
+        thread_close_mutex(ps_mutex);
+        ps_thread = NULL;
+
+        if (ghostscript_handle != NULL) {
+            dynld_close(ghostscript_handle);
+            ghostscript_handle = NULL;
+        }
     }
 
     free(dev);
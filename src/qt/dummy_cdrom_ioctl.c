@@ -210,6 +210,14 @@ plat_cdrom_read_sector(uint8_t *buffer, int raw, uint32_t sector)
     return 0;
 }
 
+int
+plat_cdrom_read_sectors(UNUSED(uint8_t *buffer), uint32_t sector, int count)
+{
+    dummy_cdrom_ioctl_log("ReadSectors sector=%d, count=%d.\n", sector, count);
+
+    return 0;
+}
+
 void
 plat_cdrom_eject(void)
 {
@@ -449,7 +449,12 @@ HarddiskDialog::onCreateNewFile()
     // formats 0, 1 and 2
     connect(this, &HarddiskDialog::fileProgress, this, [this](int value) { ui->progressBar->setValue(value); QApplication::processEvents(); });
     ui->progressBar->setVisible(true);
-    [size, &file, this] {
+
+    /* Extending the file leaves the data unwritten, sparse where the file system allows. */
+    file.flush();
+    if (file.resize(file.size() + size))
+        emit fileProgress(100);
+    else [size, &file, this] {
         QDataStream stream(&file);
         stream.setByteOrder(QDataStream::LittleEndian);
 
@@ -258,7 +258,7 @@ MachineStatus::MachineStatus(QObject *parent)
 {
     d = std::make_unique<MachineStatus::States>(this);
     connect(refreshTimer, &QTimer::timeout, this, &MachineStatus::refreshIcons);
-    refreshTimer->start(75);
+    refreshTimer->start(33);
 }
 
 MachineStatus::~MachineStatus() = default;
@@ -380,6 +380,16 @@ hdd_count(int bus)
     return c;
 }
 
+/* Active now, or at some point since the last poll. */
+template <typename T>
+static bool
+pollActive(T &status)
+{
+    const bool seen = status.seen.exchange(false, std::memory_order_relaxed);
+
+    return status.active.load(std::memory_order_relaxed) || seen;
+}
+
 void
 MachineStatus::refreshIcons()
 {
@@ -388,30 +398,30 @@ MachineStatus::refreshIcons()
         return;
 
     for (size_t i = 0; i < FDD_NUM; ++i) {
-        d->fdd[i].setActive(machine_status.fdd[i].active);
+        d->fdd[i].setActive(pollActive(machine_status.fdd[i]));
         d->fdd[i].setEmpty(machine_status.fdd[i].empty);
     }
     for (size_t i = 0; i < CDROM_NUM; ++i) {
-        d->cdrom[i].setActive(machine_status.cdrom[i].active);
+        d->cdrom[i].setActive(pollActive(machine_status.cdrom[i]));
         d->cdrom[i].setEmpty(machine_status.cdrom[i].empty);
     }
     for (size_t i = 0; i < ZIP_NUM; i++) {
-        d->zip[i].setActive(machine_status.zip[i].active);
+        d->zip[i].setActive(pollActive(machine_status.zip[i]));
         d->zip[i].setEmpty(machine_status.zip[i].empty);
     }
     for (size_t i = 0; i < MO_NUM; i++) {
-        d->mo[i].setActive(machine_status.mo[i].active);
+        d->mo[i].setActive(pollActive(machine_status.mo[i]));
         d->mo[i].setEmpty(machine_status.mo[i].empty);
     }
 
     d->cassette.setEmpty(machine_status.cassette.empty);
 
     for (size_t i = 0; i < HDD_BUS_USB; i++) {
-        d->hdds[i].setActive(machine_status.hdd[i].active);
+        d->hdds[i].setActive(pollActive(machine_status.hdd[i]));
     }
 
     for (size_t i = 0; i < NET_CARD_MAX; i++) {
-        d->net[i].setActive(machine_status.net[i].active);
+        d->net[i].setActive(pollActive(machine_status.net[i]));
         d->net[i].setEmpty(machine_status.net[i].empty);
     }
 
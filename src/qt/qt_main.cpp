@@ -83,6 +83,8 @@ extern MainWindow   *main_window;
 extern "C" {
 #include <86box/timer.h>
 #include <86box/nvr.h>
+#include <86box/bench.h>
+#include <86box/thread.h>
 extern int qt_nvr_save(void);
 }
 
@@ -95,6 +97,7 @@ main_thread_fn()
 
     QThread::currentThread()->setPriority(QThread::HighestPriority);
     plat_set_thread_name(nullptr, "main_thread_fn");
+    thread_placement_apply("main_thread_fn");
     framecountx = 0;
     // title_update = 1;
     uint64_t old_time = elapsed_timer.elapsed();
@@ -107,6 +110,10 @@ main_thread_fn()
             drawits = 10;
         else
 #endif
+        /* Turbo POST, max speed and benchmarks run frames back to back, with no host pacing. */
+        if (pc_unthrottled() && (drawits <= 0))
+            drawits = 10;
+        else
             drawits += static_cast<int>(new_time - old_time);
         old_time = new_time;
         if (drawits > 0 && !dopause) {
@@ -120,6 +127,8 @@ main_thread_fn()
 #endif
             /* Run a block of code. */
             pc_run();
+            if (bench_frame())
+                break;
 
 #ifdef USE_INSTRUMENT
             if (instru_enabled) {
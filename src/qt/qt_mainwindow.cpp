@@ -48,6 +48,7 @@ extern "C" {
 #include <86box/machine.h>
 #include <86box/vid_ega.h>
 #include <86box/version.h>
+#include <86box/capture.h>
 #if 0
 #include <86box/acpi.h> /* Requires timer.h include, which conflicts with Qt headers */
 #endif
@@ -66,6 +67,7 @@ extern int qt_nvr_save(void);
 };
 
 #include <QGuiApplication>
+#include <QClipboard>
 #include <QWindow>
 #include <QTimer>
 #include <QThread>
@@ -604,6 +606,9 @@ MainWindow::MainWindow(QWidget *parent)
     if (do_auto_pause > 0) {
         ui->actionAuto_pause->setChecked(true);
     }
+    if (max_speed > 0) {
+        ui->actionMax_speed->setChecked(true);
+    }
 
 #ifdef Q_OS_MACOS
     ui->actionCtrl_Alt_Del->setShortcutVisibleInContextMenu(true);
@@ -917,6 +922,12 @@ MainWindow::on_actionCtrl_Alt_Esc_triggered()
     pc_send_cae();
 }
 
+void
+MainWindow::on_actionPaste_text_triggered()
+{
+    keyboard_paste_text(QGuiApplication::clipboard()->text().toUtf8().constData());
+}
+
 void
 MainWindow::on_actionPause_triggered()
 {
@@ -1766,6 +1777,13 @@ MainWindow::on_actionAuto_pause_triggered()
     ui->actionAuto_pause->setChecked(do_auto_pause > 0 ? true : false);
 }
 
+void
+MainWindow::on_actionMax_speed_triggered()
+{
+    max_speed ^= 1;
+    ui->actionMax_speed->setChecked(max_speed > 0 ? true : false);
+}
+
 void
 MainWindow::on_actionRemember_size_and_position_triggered()
 {
@@ -1869,6 +1887,16 @@ MainWindow::on_actionTake_screenshot_triggered()
     device_force_redraw();
 }
 
+void
+MainWindow::on_actionRecord_video_triggered(bool checked)
+{
+    if (checked) {
+        if (!capture_active && !capture_start(nullptr))
+            ui->actionRecord_video->setChecked(false);
+    } else
+        capture_stop();
+}
+
 void
 MainWindow::on_actionSound_gain_triggered()
 {
@@ -69,8 +69,10 @@ private slots:
     void on_actionExit_triggered();
     void on_actionAuto_pause_triggered();
     void on_actionPause_triggered();
+    void on_actionMax_speed_triggered();
     void on_actionCtrl_Alt_Del_triggered();
     void on_actionCtrl_Alt_Esc_triggered();
+    void on_actionPaste_text_triggered();
     void on_actionHard_Reset_triggered();
     void on_actionRight_CTRL_is_left_ALT_triggered();
     static void on_actionKeyboard_requires_capture_triggered();
@@ -114,6 +116,7 @@ private slots:
     void on_actionHide_tool_bar_triggered();
     void on_actionUpdate_status_bar_icons_triggered();
     void on_actionTake_screenshot_triggered();
+    void on_actionRecord_video_triggered(bool checked);
     void on_actionSound_gain_triggered();
     void on_actionPreferences_triggered();
     void on_actionEnable_Discord_integration_triggered(bool checked);
@@ -523,7 +523,7 @@ MediaMenu::cdromMount(int i, int dir, const QString &arg)
     else {
         filename = QFileDialog::getOpenFileName(parentWidget, QString(),
                                                 QString(),
-            tr("CD-ROM images") % util::DlgFilter({ "iso", "cue" }) % tr("All files") % util::DlgFilter({ "*" }, true));
+            tr("CD-ROM images") % util::DlgFilter({ "iso", "cue", "cso" }) % tr("All files") % util::DlgFilter({ "*" }, true));
     }
 
     if (filename.isEmpty())
@@ -955,6 +955,12 @@ MediaMenu::nicUpdateMenu(int i)
         case NET_TYPE_VDE:
             netType = "VDE";
             break;
+        case NET_TYPE_TAP:
+            netType = "TAP";
+            break;
+        case NET_TYPE_SHM:
+            netType = tr("Shared Memory");
+            break;
     }
 
     QString devName = DeviceConfig::DeviceName(network_card_getdevice(net_cards_conf[i].device_num), network_card_get_internal_name(net_cards_conf[i].device_num), 1);
@@ -173,10 +173,14 @@ OpenGLOptions::addShader(const QString &path)
 
     static const char *extension = "\n#extension GL_ARB_shading_language_420pack : enable\n";
 
-    if (!shader->addShaderFromSourceCode(QOpenGLShader::Vertex, version_line % extension % "\n#define VERTEX\n#line 1\n" % shader_text))
+    /* Cacheable sources are only compiled the first time; after that Qt loads
+       the linked program binary from its disk cache (GL_ARB_get_program_binary),
+       keyed by the sources and the driver, so options and mode changes do not
+       stall on the shader compiler. */
+    if (!shader->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, version_line % extension % "\n#define VERTEX\n#line 1\n" % shader_text))
         throw_shader_error(tr("Error compiling vertex shader in file \"%1\""));
 
-    if (!shader->addShaderFromSourceCode(QOpenGLShader::Fragment, version_line % extension % "\n#define FRAGMENT\n#line 1\n" % shader_text))
+    if (!shader->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, version_line % extension % "\n#define FRAGMENT\n#line 1\n" % shader_text))
         throw_shader_error(tr("Error compiling fragment shader in file \"%1\""));
 
     if (!shader->link())
@@ -189,8 +193,8 @@ void
 OpenGLOptions::addDefaultShader()
 {
     auto shader = new QOpenGLShaderProgram(this);
-    shader->addShaderFromSourceCode(QOpenGLShader::Vertex, m_glslVersion % "\n" % vertex_shader);
-    shader->addShaderFromSourceCode(QOpenGLShader::Fragment, m_glslVersion % "\n" % fragment_shader);
+    shader->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, m_glslVersion % "\n" % vertex_shader);
+    shader->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, m_glslVersion % "\n" % fragment_shader);
     shader->link();
     m_shaders << OpenGLShaderPass(shader, QString());
 }
@@ -22,6 +22,7 @@
 #include <QStringBuilder>
 #include <QSurfaceFormat>
 
+#include <algorithm>
 #include <cmath>
 
 #include "qt_opengloptionsdialog.hpp"
@@ -223,6 +224,9 @@ OpenGLRenderer::finalize()
 
     context->makeCurrent(this);
 
+    for (int i = 0; i < BUFFERCOUNT; i++)
+        releaseBuffer(i);
+
     if (hasBufferStorage)
         glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
 
@@ -239,6 +243,18 @@ OpenGLRenderer::finalize()
     isFinalized = true;
 }
 
+void
+OpenGLRenderer::releaseBuffer(int buf_idx)
+{
+    if (uploadFences[buf_idx]) {
+        glClientWaitSync(uploadFences[buf_idx], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(uploadFences[buf_idx]);
+        uploadFences[buf_idx] = nullptr;
+    }
+
+    buf_usage[buf_idx].clear();
+}
+
 QDialog *
 OpenGLRenderer::getOptions(QWidget *parent)
 {
@@ -369,12 +385,52 @@ OpenGLRenderer::applyShader(const OpenGLShaderPass &shader)
         glUniform2f(shader.input_size(), source.width(), source.height());
 
     if (shader.texture_size() != -1)
-        glUniform2f(shader.texture_size(), source.width(), source.height());
+        glUniform2f(shader.texture_size(), textureWidth, textureHeight);
 
     if (shader.frame_count() != -1)
         glUniform1i(shader.frame_count(), frameCounter);
 }
 
+/* The texture only grows, in power of two steps, so that guest mode changes
+   do not reallocate it every time; the frame sits in its top left corner and
+   the quad's texture coordinates are scaled to match. */
+void
+OpenGLRenderer::resizeTexture(int w, int h)
+{
+    if ((w > textureWidth) || (h > textureHeight)) {
+        int tw = 1;
+        int th = 1;
+
+        while (tw < std::max(w, textureWidth))
+            tw <<= 1;
+        while (th < std::max(h, textureHeight))
+            th <<= 1;
+        textureWidth  = tw;
+        textureHeight = th;
+
+        glTexImage2D(GL_TEXTURE_2D, 0, (GLenum) QOpenGLTexture::RGBA8_UNorm, textureWidth, textureHeight, 0, (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, NULL);
+    }
+
+    /* Black out the column and row past the frame, which the border clamp
+       used to provide, so that filtering does not pick up an older frame. */
+    std::vector<uint32_t> black(std::max(w, h) + 1, 0xff000000);
+
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    if (w < textureWidth)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, w, 0, 1, std::min(h + 1, textureHeight), (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, black.data());
+    if (h < textureHeight)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, h, std::min(w + 1, textureWidth), 1, (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, black.data());
+
+    const GLfloat u = (GLfloat) w / (GLfloat) textureWidth;
+    const GLfloat v = (GLfloat) h / (GLfloat) textureHeight;
+    const GLfloat coords[4][2] = { { 0.f, 0.f }, { u, 0.f }, { 0.f, v }, { u, v } };
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+    for (int i = 0; i < 4; i++)
+        glBufferSubData(GL_ARRAY_BUFFER, (i * 8 + 2) * sizeof(GLfloat), sizeof(coords[i]), coords[i]);
+}
+
 void
 OpenGLRenderer::render()
 {
@@ -427,10 +483,14 @@ OpenGLRenderer::getBuffers()
 }
 
 void
-OpenGLRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
+OpenGLRenderer::onBlit(int buf_idx, int x, int y, int w, int h, int dirty_y1, int dirty_y2)
 {
-    if (notReady())
+    if (notReady()) {
+        textureStale = true;
+        buf_usage[buf_idx].clear();
+        buf_usage[(buf_idx + 1) % BUFFERCOUNT].clear();
         return;
+    }
 
     context->makeCurrent(this);
 
@@ -447,21 +507,37 @@ OpenGLRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
 
         /* Resize the texture */
         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-        glTexImage2D(GL_TEXTURE_2D, 0, (GLenum) QOpenGLTexture::RGBA8_UNorm, source.width(), source.height(), 0, (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, NULL);
+        resizeTexture(source.width(), source.height());
         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBufferID);
+        textureStale = true;
     }
 
-    if (!hasBufferStorage)
-        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, BUFFERBYTES * buf_idx, h * ROW_LENGTH * sizeof(uint32_t) + (y * ROW_LENGTH * sizeof(uint32_t)), (uint8_t *) unpackBuffer + BUFFERBYTES * buf_idx);
+    /* Only upload the rows that changed since the last frame. */
+    if (textureStale) {
+        dirty_y1     = y;
+        dirty_y2     = y + h;
+        textureStale = false;
+    }
 
-    glPixelStorei(GL_UNPACK_SKIP_PIXELS, BUFFERPIXELS * buf_idx + y * ROW_LENGTH + x);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, ROW_LENGTH);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, NULL);
+    if (dirty_y2 > dirty_y1) {
+        if (!hasBufferStorage)
+            glBufferSubData(GL_PIXEL_UNPACK_BUFFER, BUFFERBYTES * buf_idx + (dirty_y1 * ROW_LENGTH * sizeof(uint32_t)), (dirty_y2 - dirty_y1) * ROW_LENGTH * sizeof(uint32_t), (uint8_t *) unpackBuffer + BUFFERBYTES * buf_idx + (dirty_y1 * ROW_LENGTH * sizeof(uint32_t)));
 
-    /* TODO: check if fence sync is implementable here and still has any benefit. */
-    glFinish();
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, BUFFERPIXELS * buf_idx + dirty_y1 * ROW_LENGTH + x);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, ROW_LENGTH);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirty_y1 - y, w, dirty_y2 - dirty_y1, (GLenum) QOpenGLTexture::BGRA, (GLenum) QOpenGLTexture::UInt32_RGBA8_Rev, NULL);
+    }
 
-    buf_usage[buf_idx].clear();
+    /* The upload from the unpack buffer runs asynchronously; the buffer
+       stays busy for the blitter until the GPU has read it. Buffers are
+       filled in turn, so the next one was uploaded BUFFERCOUNT - 1 frames
+       ago and waiting for it rarely blocks. */
+    if (uploadFences[buf_idx])
+        glDeleteSync(uploadFences[buf_idx]);
+    uploadFences[buf_idx] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    releaseBuffer((buf_idx + 1) % BUFFERCOUNT);
 
     if (options->renderBehavior() == OpenGLOptions::SyncWithVideo)
         render();
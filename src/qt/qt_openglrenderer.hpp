@@ -63,7 +63,7 @@ signals:
     void errorInitializing();
 
 public slots:
-    void onBlit(int buf_idx, int x, int y, int w, int h);
+    void onBlit(int buf_idx, int x, int y, int w, int h, int dirty_y1, int dirty_y2);
 
 protected:
     void exposeEvent(QExposeEvent *event) override;
@@ -90,6 +90,8 @@ private:
     GLuint vertexArrayID  = 0;
     GLuint vertexBufferID = 0;
     GLuint textureID      = 0;
+    int    textureWidth   = INIT_WIDTH;
+    int    textureHeight  = INIT_HEIGHT;
     int    frameCounter   = 0;
 
     OpenGLOptions::FilterType currentFilter;
@@ -101,8 +103,17 @@ private:
     void initializeBuffers();
     void applyOptions();
     void applyShader(const OpenGLShaderPass &shader);
+    void resizeTexture(int w, int h);
     bool notReady() const { return !isInitialized || isFinalized; }
 
+    /* Set when the texture does not hold the previous frame. */
+    bool textureStale = true;
+
+    /* Signalled once the GPU is done reading the matching unpack buffer. */
+    GLsync uploadFences[BUFFERCOUNT] = {};
+
+    void releaseBuffer(int buf_idx);
+
     /* GL_ARB_buffer_storage */
     bool hasBufferStorage = false;
 #ifndef NO_BUFFER_STORAGE
@@ -348,6 +348,18 @@ plat_remove(char *path)
     QFile(path).remove();
 }
 
+/* Replaces to if it exists, in one step where the host allows it. */
+int
+plat_rename(const char *from, const char *to)
+{
+#ifdef Q_OS_WINDOWS
+    return MoveFileExW(QString::fromUtf8(from).toStdWString().c_str(), QString::fromUtf8(to).toStdWString().c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+#else
+    return rename(from, to);
+#endif
+}
+
 void *
 plat_mmap(size_t size, uint8_t executable)
 {
@@ -424,6 +436,7 @@ plat_power_off(void)
     confirm_exit_cmdl = 0;
     nvr_save();
     config_save();
+    config_flush();
 
     /* Deduct a sufficiently large number of cycles that no instructions will
        run before the main thread is terminated */
@@ -33,6 +33,7 @@
 
 #include "evdev_mouse.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <stdexcept>
 
@@ -395,6 +396,7 @@ RendererStack::createRenderer(Renderer renderer)
     this->setStyleSheet("background-color: black");
 
     currentBuf = 0;
+    dirtyFull  = true;
 
     if (renderer != Renderer::OpenGL3 && renderer != Renderer::Vulkan) {
         imagebufs = rendererWindow->getBuffers();
@@ -411,24 +413,49 @@ RendererStack::blit(int x, int y, int w, int h)
         (w > 2048) || (h > 2048) ||
         (monitors[m_monitor_index].target_buffer == NULL) || imagebufs.empty() ||
         std::get<std::atomic_flag *>(imagebufs[currentBuf])->test_and_set()) {
+        /* The frame is lost, so nothing can be assumed about the next one. */
+        dirtyFull = true;
         video_blit_complete_monitor(m_monitor_index);
         return;
     }
+
+    int dirty_y1;
+    int dirty_y2;
+    video_blit_get_dirty_monitor(&dirty_y1, &dirty_y2, m_monitor_index);
+    if (dirtyFull || (bufDirty.size() != imagebufs.size()) ||
+        (x != sx) || (y != sy) || (w != sw) || (h != sh)) {
+        dirty_y1 = y;
+        dirty_y2 = y + h;
+        bufDirty.assign(imagebufs.size(), std::make_pair(0, 0));
+        dirtyFull = false;
+    }
+
+    /* The other buffers miss this frame's rows too, until they are next used. */
+    if (dirty_y2 > dirty_y1) {
+        for (auto &dirty : bufDirty) {
+            if (dirty.second > dirty.first)
+                dirty = std::make_pair(std::min(dirty.first, dirty_y1), std::max(dirty.second, dirty_y2));
+            else
+                dirty = std::make_pair(dirty_y1, dirty_y2);
+        }
+    }
+
     sx = x;
     sy = y;
     sw = this->w = w;
     sh = this->h       = h;
     uint8_t *imagebits = std::get<uint8_t *>(imagebufs[currentBuf]);
-    for (int y1 = y; y1 < (y + h); y1++) {
+    for (int y1 = bufDirty[currentBuf].first; y1 < bufDirty[currentBuf].second; y1++) {
         auto scanline = imagebits + (y1 * rendererWindow->getBytesPerRow()) + (x * 4);
         video_copy(scanline, &(monitors[m_monitor_index].target_buffer->line[y1][x]), w * 4);
     }
+    bufDirty[currentBuf] = std::make_pair(0, 0);
 
     if (monitors[m_monitor_index].mon_screenshots) {
         video_screenshot_monitor((uint32_t *) imagebits, x, y, 2048, m_monitor_index);
     }
     video_blit_complete_monitor(m_monitor_index);
-    emit blitToRenderer(currentBuf, sx, sy, sw, sh);
+    emit blitToRenderer(currentBuf, sx, sy, sw, sh, dirty_y1, dirty_y2);
     currentBuf = (currentBuf + 1) % imagebufs.size();
 }
 
@@ -11,6 +11,7 @@
 #include <atomic>
 #include <memory>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "qt_renderercommon.hpp"
@@ -79,7 +80,9 @@ public:
     void (*mouse_exit_func)()                   = nullptr;
 
 signals:
-    void blitToRenderer(int buf_idx, int x, int y, int w, int h);
+    /* dirty_y1 to (dirty_y2 - 1) are the rows that changed since the previous
+       blit, renderers that keep the frame around only need to upload them. */
+    void blitToRenderer(int buf_idx, int x, int y, int w, int h, int dirty_y1, int dirty_y2);
     void rendererChanged();
 
 public slots:
@@ -105,6 +108,10 @@ private:
 
     std::vector<std::tuple<uint8_t *, std::atomic_flag *>> imagebufs;
 
+    /* Rows each image buffer is missing, as [first, last) pairs. */
+    std::vector<std::pair<int, int>> bufDirty;
+    bool                             dirtyFull = true;
+
     RendererCommon          *rendererWindow { nullptr };
     std::unique_ptr<QWidget> current;
 };
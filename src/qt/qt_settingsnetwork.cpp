@@ -43,6 +43,8 @@ SettingsNetwork::enableElements(Ui::SettingsNetwork *ui)
         bool adaptersEnabled =  netType == NET_TYPE_NONE
                             ||  netType == NET_TYPE_SLIRP
                             ||  netType == NET_TYPE_VDE
+                            ||  netType == NET_TYPE_TAP
+                            ||  netType == NET_TYPE_SHM
                             || (netType == NET_TYPE_PCAP && intf_cbox->currentData().toInt() > 0);
 
         intf_cbox->setEnabled(net_type_cbox->currentData().toInt() == NET_TYPE_PCAP);
@@ -53,7 +55,7 @@ SettingsNetwork::enableElements(Ui::SettingsNetwork *ui)
                                  device_has_config(machine_get_net_device(machineId)));
         else
             conf_btn->setEnabled(adaptersEnabled && network_card_has_config(nic_cbox->currentData().toInt()));
-        socket_line->setEnabled(net_type_cbox->currentData().toInt() == NET_TYPE_VDE);
+        socket_line->setEnabled((netType == NET_TYPE_VDE) || (netType == NET_TYPE_TAP) || (netType == NET_TYPE_SHM));
     }
 }
 
@@ -93,7 +95,8 @@ SettingsNetwork::save()
         memset(net_cards_conf[i].host_dev_name, '\0', sizeof(net_cards_conf[i].host_dev_name));
         if (net_cards_conf[i].net_type == NET_TYPE_PCAP) {
             strncpy(net_cards_conf[i].host_dev_name, network_devs[cbox->currentData().toInt()].device, sizeof(net_cards_conf[i].host_dev_name) - 1);
-        } else if (net_cards_conf[i].net_type == NET_TYPE_VDE) {
+        } else if ((net_cards_conf[i].net_type == NET_TYPE_VDE) || (net_cards_conf[i].net_type == NET_TYPE_TAP) ||
+                   (net_cards_conf[i].net_type == NET_TYPE_SHM)) {
             strncpy(net_cards_conf[i].host_dev_name, socket_line->text().toUtf8().constData(), sizeof(net_cards_conf[i].host_dev_name));
         }
     }
@@ -152,9 +155,17 @@ SettingsNetwork::onCurrentMachineChanged(int machineId)
         if (network_devmap.has_vde) {
             Models::AddEntry(model, "VDE", NET_TYPE_VDE);
         }
+        if (network_devmap.has_tap) {
+            Models::AddEntry(model, "TAP", NET_TYPE_TAP);
+        }
+        if (network_devmap.has_shm) {
+            Models::AddEntry(model, tr("Shared Memory"), NET_TYPE_SHM);
+        }
         
         model->removeRows(0, removeRows);
-        cbox->setCurrentIndex(net_cards_conf[i].net_type);
+        /* Look the type up, the rows depend on which drivers are available. */
+        int typeRow = cbox->findData(net_cards_conf[i].net_type);
+        cbox->setCurrentIndex((typeRow >= 0) ? typeRow : 0);
 
         selectedRow = 0;
 
@@ -172,7 +183,8 @@ SettingsNetwork::onCurrentMachineChanged(int machineId)
             model->removeRows(0, removeRows);
             cbox->setCurrentIndex(selectedRow);
         }  
-        if (net_cards_conf[i].net_type == NET_TYPE_VDE) {
+        if ((net_cards_conf[i].net_type == NET_TYPE_VDE) || (net_cards_conf[i].net_type == NET_TYPE_TAP) ||
+            (net_cards_conf[i].net_type == NET_TYPE_SHM)) {
             QString currentVdeSocket = net_cards_conf[i].host_dev_name;
             auto editline = findChild<QLineEdit *>(QString("socketVDENIC%1").arg(i+1));
             editline->setText(currentVdeSocket);
@@ -24,6 +24,7 @@ extern "C" {
 #include <86box/isamem.h>
 #include <86box/isartc.h>
 #include <86box/unittester.h>
+#include <86box/hostshare.h>
 #include <86box/novell_cardkey.h>
 }
 
@@ -47,11 +48,13 @@ SettingsOtherPeripherals::onCurrentMachineChanged(int machineId)
     ui->checkBoxISABugger->setChecked((machineHasIsa && (bugger_enabled > 0)) ? true : false);
     ui->checkBoxPOSTCard->setChecked(postcard_enabled > 0 ? true : false);
     ui->checkBoxUnitTester->setChecked(unittester_enabled > 0 ? true : false);
+    ui->checkBoxHostShare->setChecked(hostshare_enabled > 0 ? true : false);
     ui->checkBoxKeyCard->setChecked((machineHasIsa && (novell_keycard_enabled > 0)) ? true : false);
     ui->checkBoxISABugger->setEnabled(machineHasIsa);
     ui->checkBoxKeyCard->setEnabled(machineHasIsa);
     ui->pushButtonConfigureKeyCard->setEnabled(novell_keycard_enabled > 0);
     ui->pushButtonConfigureUT->setEnabled(unittester_enabled > 0);
+    ui->pushButtonConfigureHostShare->setEnabled(hostshare_enabled > 0);
     ui->comboBoxRTC->setEnabled(machineHasIsa);
     ui->pushButtonConfigureRTC->setEnabled(machineHasIsa);
 
@@ -123,6 +126,7 @@ SettingsOtherPeripherals::save()
     bugger_enabled         = ui->checkBoxISABugger->isChecked() ? 1 : 0;
     postcard_enabled       = ui->checkBoxPOSTCard->isChecked() ? 1 : 0;
     unittester_enabled     = ui->checkBoxUnitTester->isChecked() ? 1 : 0;
+    hostshare_enabled      = ui->checkBoxHostShare->isChecked() ? 1 : 0;
     novell_keycard_enabled = ui->checkBoxKeyCard->isChecked() ? 1 : 0;
     isartc_type            = ui->comboBoxRTC->currentData().toInt();
 
@@ -220,6 +224,18 @@ SettingsOtherPeripherals::on_pushButtonConfigureUT_clicked()
     DeviceConfig::ConfigureDevice(&unittester_device);
 }
 
+void
+SettingsOtherPeripherals::on_checkBoxHostShare_stateChanged(int arg1)
+{
+    ui->pushButtonConfigureHostShare->setEnabled(arg1 != 0);
+}
+
+void
+SettingsOtherPeripherals::on_pushButtonConfigureHostShare_clicked()
+{
+    DeviceConfig::ConfigureDevice(&hostshare_device);
+}
+
 void SettingsOtherPeripherals::on_pushButtonConfigureKeyCard_clicked()
 {
     DeviceConfig::ConfigureDevice(&novell_keycard_device);
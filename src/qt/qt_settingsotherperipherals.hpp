@@ -32,6 +32,8 @@ private slots:
     void on_comboBoxRTC_currentIndexChanged(int index);
     void on_checkBoxUnitTester_stateChanged(int arg1);
     void on_pushButtonConfigureUT_clicked();
+    void on_checkBoxHostShare_stateChanged(int arg1);
+    void on_pushButtonConfigureHostShare_clicked();
 
     void on_pushButtonConfigureKeyCard_clicked();
 
@@ -258,6 +258,18 @@ ui_sb_update_icon_state(int tag, int state)
     }
 }
 
+/* Called for every transfer; only touches the flags when they change. */
+static void
+sb_set_active(atomic_bool_t &status_active, atomic_bool_t &status_seen, int active)
+{
+    const bool b = active > 0;
+
+    if (b && !status_seen.load(std::memory_order_relaxed))
+        status_seen.store(true, std::memory_order_relaxed);
+    if (status_active.load(std::memory_order_relaxed) != b)
+        status_active.store(b, std::memory_order_relaxed);
+}
+
 void
 ui_sb_update_icon(int tag, int active)
 {
@@ -271,22 +283,22 @@ ui_sb_update_icon(int tag, int active)
         case SB_CARTRIDGE:
             break;
         case SB_FLOPPY:
-            machine_status.fdd[item].active = active > 0 ? true : false;
+            sb_set_active(machine_status.fdd[item].active, machine_status.fdd[item].seen, active);
             break;
         case SB_CDROM:
-            machine_status.cdrom[item].active = active > 0 ? true : false;
+            sb_set_active(machine_status.cdrom[item].active, machine_status.cdrom[item].seen, active);
             break;
         case SB_ZIP:
-            machine_status.zip[item].active = active > 0 ? true : false;
+            sb_set_active(machine_status.zip[item].active, machine_status.zip[item].seen, active);
             break;
         case SB_MO:
-            machine_status.mo[item].active = active > 0 ? true : false;
+            sb_set_active(machine_status.mo[item].active, machine_status.mo[item].seen, active);
             break;
         case SB_HDD:
-            machine_status.hdd[item].active = active > 0 ? true : false;
+            sb_set_active(machine_status.hdd[item].active, machine_status.hdd[item].seen, active);
             break;
         case SB_NETWORK:
-            machine_status.net[item].active = active > 0 ? true : false;
+            sb_set_active(machine_status.net[item].active, machine_status.net[item].seen, active);
             break;
         case SB_SOUND:
         case SB_TEXT:
@@ -144,6 +144,7 @@ VulkanRenderer2::createTexture()
             return false;
 
         m_texStagingPending = true;
+        m_texStagingFullCopy = true;
     }
 
     VkImageViewCreateInfo viewInfo;
@@ -363,17 +364,32 @@ VulkanRenderer2::ensureTexture()
             m_texStagingTransferLayout = true;
         }
 
-        VkImageCopy copyInfo;
-        memset(&copyInfo, 0, sizeof(copyInfo));
-        copyInfo.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        copyInfo.srcSubresource.layerCount = 1;
-        copyInfo.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        copyInfo.dstSubresource.layerCount = 1;
-        copyInfo.extent.width              = m_texSize.width();
-        copyInfo.extent.height             = m_texSize.height();
-        copyInfo.extent.depth              = 1;
-        m_devFuncs->vkCmdCopyImage(cb, m_texStaging, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                   m_texImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyInfo);
+        // Frames are redrawn at the presentation rate, only copy what the
+        // last blit wrote, and only once.
+        auto  window = qobject_cast<VulkanWindowRenderer *>(m_window);
+        QRect region = QRect(QPoint(0, 0), m_texSize);
+        if (!m_texStagingFullCopy)
+            region = (window && window->frameUpdated) ? window->source.intersected(region) : QRect();
+        if (window)
+            window->frameUpdated = false;
+        m_texStagingFullCopy = false;
+
+        if (!region.isEmpty()) {
+            VkImageCopy copyInfo;
+            memset(&copyInfo, 0, sizeof(copyInfo));
+            copyInfo.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copyInfo.srcSubresource.layerCount = 1;
+            copyInfo.srcOffset.x               = region.x();
+            copyInfo.srcOffset.y               = region.y();
+            copyInfo.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copyInfo.dstSubresource.layerCount = 1;
+            copyInfo.dstOffset                 = copyInfo.srcOffset;
+            copyInfo.extent.width              = region.width();
+            copyInfo.extent.height             = region.height();
+            copyInfo.extent.depth              = 1;
+            m_devFuncs->vkCmdCopyImage(cb, m_texStaging, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                       m_texImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyInfo);
+        }
 
         barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
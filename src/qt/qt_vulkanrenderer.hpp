@@ -85,6 +85,7 @@ private:
     VkDeviceMemory m_texStagingMem            = VK_NULL_HANDLE;
     bool           m_texStagingPending        = false;
     bool           m_texStagingTransferLayout = false;
+    bool           m_texStagingFullCopy       = true;
     QSize          m_texSize;
     VkFormat       m_texFormat;
 
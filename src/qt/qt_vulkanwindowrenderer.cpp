@@ -833,6 +833,7 @@ VulkanWindowRenderer::onBlit(int buf_idx, int x, int y, int w, int h)
 {
     auto origSource = source;
     source.setRect(x, y, w, h);
+    frameUpdated = true;
     if (isExposed())
         requestUpdate();
     buf_usage[0].clear();
@@ -27,6 +27,7 @@ protected:
 
 private:
     QVulkanInstance instance;
+    bool            frameUpdated = false; /* set by onBlit(), cleared once staged */
 
     QVulkanWindowRenderer *createRenderer() override;
 
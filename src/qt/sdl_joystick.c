@@ -31,6 +31,8 @@
 #include <86box/86box.h>
 #include <86box/device.h>
 #include <86box/gameport.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
 #include <86box/plat_unused.h>
 
 int                  joysticks_present;
@@ -38,10 +40,54 @@ joystick_t           joystick_state[MAX_JOYSTICKS];
 plat_joystick_t      plat_joystick_state[MAX_PLAT_JOYSTICKS];
 static SDL_Joystick *sdl_joy[MAX_PLAT_JOYSTICKS];
 
+/* The host devices are polled on a thread of their own, which publishes
+   their state under poll_mutex; the emulation thread only maps it. */
+static thread_t     *poll_thread;
+static mutex_t      *poll_mutex;
+static volatile int  poll_run;
+
 #ifndef M_PI
 #    define M_PI 3.14159265358979323846
 #endif
 
+static void
+joystick_poll_thread(UNUSED(void *priv))
+{
+    struct {
+        int a[MAX_JOY_AXES];
+        int b[MAX_JOY_BUTTONS];
+        int p[MAX_JOY_POVS];
+    } state[MAX_PLAT_JOYSTICKS];
+    int c;
+    int b;
+
+    while (poll_run) {
+        plat_delay_ms(10);
+        if (!joystick_type)
+            continue;
+
+        SDL_JoystickUpdate();
+        for (c = 0; c < joysticks_present; c++) {
+            for (b = 0; b < plat_joystick_state[c].nr_axes; b++)
+                state[c].a[b] = SDL_JoystickGetAxis(sdl_joy[c], b);
+
+            for (b = 0; b < plat_joystick_state[c].nr_buttons; b++)
+                state[c].b[b] = SDL_JoystickGetButton(sdl_joy[c], b);
+
+            for (b = 0; b < plat_joystick_state[c].nr_povs; b++)
+                state[c].p[b] = SDL_JoystickGetHat(sdl_joy[c], b);
+        }
+
+        thread_wait_mutex(poll_mutex);
+        for (c = 0; c < joysticks_present; c++) {
+            memcpy(plat_joystick_state[c].a, state[c].a, plat_joystick_state[c].nr_axes * sizeof(state[c].a[0]));
+            memcpy(plat_joystick_state[c].b, state[c].b, plat_joystick_state[c].nr_buttons * sizeof(state[c].b[0]));
+            memcpy(plat_joystick_state[c].p, state[c].p, plat_joystick_state[c].nr_povs * sizeof(state[c].p[0]));
+        }
+        thread_release_mutex(poll_mutex);
+    }
+}
+
 void
 joystick_init(void)
 {
@@ -79,6 +125,12 @@ joystick_init(void)
             }
         }
     }
+
+    if (joysticks_present > 0) {
+        poll_mutex  = thread_create_mutex();
+        poll_run    = 1;
+        poll_thread = thread_create(joystick_poll_thread, NULL);
+    }
 }
 
 void
@@ -86,6 +138,12 @@ joystick_close(void)
 {
     int c;
 
+    if (poll_thread) {
+        poll_run = 0;
+        thread_wait(poll_thread);
+        poll_thread = NULL;
+    }
+
     for (c = 0; c < joysticks_present; c++) {
         if (sdl_joy[c])
             SDL_JoystickClose(sdl_joy[c]);
@@ -138,20 +196,8 @@ joystick_process(void)
     if (!joystick_type)
         return;
 
-    SDL_JoystickUpdate();
-    for (c = 0; c < joysticks_present; c++) {
-        int b;
-
-        for (b = 0; b < plat_joystick_state[c].nr_axes; b++)
-            plat_joystick_state[c].a[b] = SDL_JoystickGetAxis(sdl_joy[c], b);
-
-        for (b = 0; b < plat_joystick_state[c].nr_buttons; b++)
-            plat_joystick_state[c].b[b] = SDL_JoystickGetButton(sdl_joy[c], b);
-
-        for (b = 0; b < plat_joystick_state[c].nr_povs; b++)
-            plat_joystick_state[c].p[b] = SDL_JoystickGetHat(sdl_joy[c], b);
-        //                pclog("joystick %i - x=%i y=%i b[0]=%i b[1]=%i  %i\n", c, joystick_state[c].x, joystick_state[c].y, joystick_state[c].b[0], joystick_state[c].b[1], joysticks_present);
-    }
+    if (poll_mutex)
+        thread_wait_mutex(poll_mutex);
 
     for (c = 0; c < joystick_get_max_joysticks(joystick_type); c++) {
         if (joystick_state[c].plat_joystick_nr) {
@@ -185,6 +231,9 @@ joystick_process(void)
                 joystick_state[c].pov[d] = -1;
         }
     }
+
+    if (poll_mutex)
+        thread_release_mutex(poll_mutex);
 }
 
 #ifdef _WIN32
@@ -339,6 +339,17 @@ plat_cdrom_get_sector_size(UNUSED(uint32_t sector))
     return dgCDROM.BytesPerSector;
 }
 
+/* Reads keep the handle open, opening the drive costs more than reading a
+   sector from it; anything else closes it again. */
+static int
+plat_cdrom_read_open(void)
+{
+    if ((handle == NULL) || (handle == INVALID_HANDLE_VALUE))
+        return plat_cdrom_open();
+
+    return 1;
+}
+
 int
 plat_cdrom_read_sector(uint8_t *buffer, int raw, uint32_t sector)
 {
@@ -346,7 +357,7 @@ plat_cdrom_read_sector(uint8_t *buffer, int raw, uint32_t sector)
     long size   = 0;
     int  buflen = raw ? RAW_SECTOR_SIZE : COOKED_SECTOR_SIZE;
 
-    plat_cdrom_open();
+    plat_cdrom_read_open();
 
     if (raw) {
         win_cdrom_ioctl_log("Raw\n");
@@ -367,10 +378,37 @@ plat_cdrom_read_sector(uint8_t *buffer, int raw, uint32_t sector)
             success = ReadFile(handle, buffer, buflen, (LPDWORD)&size, NULL);
         status  = (success != 0);
     }
-    plat_cdrom_close();
     win_cdrom_ioctl_log("ReadSector status=%d, sector=%d, size=%" PRId64 ".\n", status, sector, (long long) size);
 
-    return (size == buflen) && (status > 0);
+    if ((size != buflen) || (status <= 0)) {
+        plat_cdrom_close();
+        return 0;
+    }
+
+    return 1;
+}
+
+int
+plat_cdrom_read_sectors(uint8_t *buffer, uint32_t sector, int count)
+{
+    LARGE_INTEGER pos;
+    long          size    = 0;
+    int           buflen  = count * COOKED_SECTOR_SIZE;
+    int           success = 0;
+
+    plat_cdrom_read_open();
+
+    pos.QuadPart = ((LONGLONG) sector) * COOKED_SECTOR_SIZE;
+    if (SetFilePointerEx(handle, pos, NULL, FILE_BEGIN))
+        success = ReadFile(handle, buffer, buflen, (LPDWORD) &size, NULL);
+    win_cdrom_ioctl_log("ReadSectors status=%d, sector=%d, count=%d, size=%" PRId64 ".\n", success, sector, count, (long long) size);
+
+    if (!success || (size != buflen)) {
+        plat_cdrom_close();
+        return 0;
+    }
+
+    return 1;
 }
 
 void
@@ -142,29 +142,30 @@ plat_serpt_write(void *priv, uint8_t data)
     }
 }
 
-uint8_t
-plat_serpt_read_vcon(serial_passthrough_t *dev, uint8_t *data)
-{
-    DWORD bytesRead = 0;
-    ReadFile((HANDLE) dev->master_fd, data, 1, &bytesRead, NULL);
-    return !!bytesRead;
-}
-
+/* Waits up to timeout_ms for data, then reads whatever is there, up to len
+   bytes. Called from the reader thread only. */
 int
-plat_serpt_read(void *priv, uint8_t *data)
+plat_serpt_read_block(void *priv, uint8_t *buf, int len, int timeout_ms)
 {
-    serial_passthrough_t *dev = (serial_passthrough_t *) priv;
-    int                   res = 0;
+    serial_passthrough_t *dev       = (serial_passthrough_t *) priv;
+    DWORD                 bytesRead = 0;
 
     switch (dev->mode) {
         case SERPT_MODE_VCON:
+            /* The pipe is in non-blocking mode, so there is nothing to wait on. */
+            ReadFile((HANDLE) dev->master_fd, buf, len, &bytesRead, NULL);
+            if (!bytesRead)
+                Sleep(1);
+            break;
         case SERPT_MODE_HOSTSER:
-            res = plat_serpt_read_vcon(dev, data);
+            /* The port timeouts make this return as soon as anything arrives. */
+            ReadFile((HANDLE) dev->master_fd, buf, len, &bytesRead, NULL);
             break;
         default:
+            Sleep(timeout_ms);
             break;
     }
-    return res;
+    return (int) bytesRead;
 }
 
 static int
@@ -191,9 +192,10 @@ static int
 open_host_serial_port(serial_passthrough_t *dev)
 {
     COMMTIMEOUTS timeouts = {
+        /* Reads return as soon as there is data, or after 10 ms without any. */
         .ReadIntervalTimeout         = MAXDWORD,
-        .ReadTotalTimeoutConstant    = 0,
-        .ReadTotalTimeoutMultiplier  = 0,
+        .ReadTotalTimeoutConstant    = 10,
+        .ReadTotalTimeoutMultiplier  = MAXDWORD,
         .WriteTotalTimeoutMultiplier = 0,
         .WriteTotalTimeoutConstant   = 1000
     };
@@ -152,18 +152,20 @@ scsi_card_get_internal_name(int card)
     return device_get_internal_name(scsi_cards[card].device);
 }
 
+static const char *
+scsi_card_get_name(int c)
+{
+    return (scsi_cards[c].device != NULL) ? scsi_cards[c].device->internal_name : NULL;
+}
+
+static device_name_index_t scsi_card_names = { .get_name = scsi_card_get_name };
+
 int
 scsi_card_get_from_internal_name(char *s)
 {
-    int c = 0;
-
-    while (scsi_cards[c].device != NULL) {
-        if (!strcmp(scsi_cards[c].device->internal_name, s))
-            return c;
-        c++;
-    }
+    int c = device_name_index_find(&scsi_card_names, s);
 
-    return 0;
+    return (c >= 0) ? c : 0;
 }
 
 void
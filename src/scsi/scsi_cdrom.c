@@ -1329,6 +1329,7 @@ scsi_cdrom_read_data(scsi_cdrom_t *dev, int msf, int type, int flags, int32_t *l
     int      ret      = 0;
     int      data_pos = 0;
     int      temp_len = 0;
+    int      done     = 0;
     uint32_t cdsize   = 0;
 
     if (dev->drv->cd_status == CD_STATUS_EMPTY) {
@@ -1360,7 +1361,17 @@ scsi_cdrom_read_data(scsi_cdrom_t *dev, int msf, int type, int flags, int32_t *l
     dev->old_len = 0;
     *len         = 0;
 
-    for (int i = 0; i < dev->requested_blocks; i++) {
+    /* Plain 2048-byte reads go through in whole runs, the rest sector by sector. */
+    if (!msf && !vendor_type) {
+        done = cdrom_readsectors_data(dev->drv, dev->buffer, dev->sector_pos, dev->requested_blocks,
+                                      type, flags, &temp_len);
+
+        data_pos += temp_len;
+        dev->old_len += temp_len;
+        *len += temp_len;
+    }
+
+    for (int i = done; i < dev->requested_blocks; i++) {
         ret = cdrom_readsector_raw(dev->drv, dev->buffer + data_pos,
                                    dev->sector_pos + i, msf, type, flags, &temp_len, vendor_type);
 
@@ -624,16 +624,23 @@ static void
 scsi_disk_buf_alloc(scsi_disk_t *dev, uint32_t len)
 {
     scsi_disk_log("SCSI HD %i: Allocated buffer length: %i\n", dev->id, len);
-    if (!dev->temp_buffer)
-        dev->temp_buffer = (uint8_t *) malloc(len);
+    if (!dev->temp_buffer) {
+        if (len > dev->buf_pool_len) {
+            free(dev->buf_pool);
+            dev->buf_pool     = (uint8_t *) malloc(len);
+            dev->buf_pool_len = len;
+        }
+        dev->temp_buffer = dev->buf_pool;
+    }
 }
 
+/* The buffer goes back to the pool, temp_buffer being NULL still means that
+   no command owns one. */
 static void
 scsi_disk_buf_free(scsi_disk_t *dev)
 {
     if (dev->temp_buffer) {
         scsi_disk_log("SCSI HD %i: Freeing buffer...\n", dev->id);
-        free(dev->temp_buffer);
         dev->temp_buffer = NULL;
     }
 }
@@ -727,18 +734,22 @@ scsi_disk_blocks(scsi_disk_t *dev, int32_t *len, UNUSED(int first_batch), int ou
 
     *len = dev->requested_blocks << 9;
 
-    for (int i = 0; i < dev->requested_blocks; i++) {
-        if (out)
-            hdd_image_write(dev->id, dev->sector_pos + i, 1, dev->temp_buffer + (i << 9));
-        else
-            hdd_image_read(dev->id, dev->sector_pos + i, 1, dev->temp_buffer + (i << 9));
-    }
+    /* One image request for the whole batch rather than one per sector. */
+    if (out)
+        hdd_image_write(dev->id, dev->sector_pos, dev->requested_blocks, dev->temp_buffer);
+    else
+        hdd_image_read(dev->id, dev->sector_pos, dev->requested_blocks, dev->temp_buffer);
 
     scsi_disk_log("%s %i bytes of blocks...\n", out ? "Written" : "Read", *len);
 
     dev->sector_pos += dev->requested_blocks;
     dev->sector_len -= dev->requested_blocks;
 
+    /* Guests mostly read sequentially, start reading the next batch in the
+       background. */
+    if (!out)
+        hdd_image_prefetch(dev->id, dev->sector_pos, dev->requested_blocks);
+
     return 1;
 }
 
@@ -1802,6 +1813,7 @@ scsi_disk_close(void)
             if (dev) {
                 if (dev->tf)
                     free(dev->tf);
+                free(dev->buf_pool);
 
                 free(dev);
                 hdd[c].priv = NULL;
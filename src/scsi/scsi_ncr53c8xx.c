@@ -319,6 +319,11 @@ typedef struct ncr53c8xx_t {
 
     pc_timer_t timer;
 
+    /* Host pointer to the RAM granule SCRIPTS were last fetched from. */
+    const uint8_t *fetch_ptr;
+    uint32_t       fetch_gran;
+    uint32_t       fetch_gen;
+
 #ifdef USE_WDTR
     uint8_t tr_set[16];
 #endif
@@ -487,11 +492,27 @@ ncr53c8xx_write(ncr53c8xx_t *dev, uint32_t addr, uint8_t *buf, uint32_t len)
     }
 }
 
+/* SCRIPTS and the tables they walk sit in RAM, so keep a host pointer to the
+   granule last read from and reuse it until the memory map changes instead of
+   going through dma_bm_read() for every dword. */
 static __inline uint32_t
-read_dword(UNUSED(ncr53c8xx_t *dev), uint32_t addr)
+read_dword(ncr53c8xx_t *dev, uint32_t addr)
 {
     uint32_t buf;
     ncr53c8xx_log("Reading the next DWORD from memory (%08X)...\n", addr);
+
+    if ((addr & MEM_GRANULARITY_MASK) <= MEM_GRANULARITY_QBOUND) {
+        if (((addr >> MEM_GRANULARITY_BITS) != dev->fetch_gran) || (dev->fetch_gen != mem_mapping_gen)) {
+            dev->fetch_gran = addr >> MEM_GRANULARITY_BITS;
+            dev->fetch_gen  = mem_mapping_gen;
+            dev->fetch_ptr  = mem_get_phys_ptr(addr & ~MEM_GRANULARITY_MASK, MEM_GRANULARITY_SIZE, 0);
+        }
+        if (dev->fetch_ptr != NULL) {
+            memcpy(&buf, &dev->fetch_ptr[addr & MEM_GRANULARITY_MASK], 4);
+            return buf;
+        }
+    }
+
     dma_bm_read(addr, (uint8_t *) &buf, 4, 4);
     return buf;
 }
@@ -2535,7 +2556,8 @@ ncr53c8xx_init(const device_t *info)
     dev = malloc(sizeof(ncr53c8xx_t));
     memset(dev, 0x00, sizeof(ncr53c8xx_t));
 
-    dev->bus = scsi_get_bus();
+    dev->bus        = scsi_get_bus();
+    dev->fetch_gran = 0xffffffff;
 
     dev->chip_rev = 0;
     dev->chip     = info->local & 0xff;
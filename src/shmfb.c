@@ -0,0 +1,205 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Shared memory frame output, for test harnesses and other
+ *          external tools that want to look at the screen without
+ *          going through a renderer or a screenshot file.
+ *
+ *          Frames are published from the blit thread while the target
+ *          buffer is still held for the blit, so they are never torn.
+ *          Each slot keeps its own list of rows it is missing, so only
+ *          rows that changed since the slot was last written are copied.
+ */
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/video.h>
+#include <86box/shmfb.h>
+
+typedef struct shmfb_t {
+    int             failed;
+    char            name[256];
+    size_t          size;
+    shmfb_header_t *hdr;
+
+    /* Geometry of the last frame, slots are rewritten when it changes. */
+    int             x;
+    int             y;
+    int             w;
+    int             h;
+
+    /* Rows each slot is missing, as [first, last) in buffer coordinates. */
+    int             missing_y1[SHMFB_SLOTS];
+    int             missing_y2[SHMFB_SLOTS];
+} shmfb_t;
+
+static shmfb_t shmfb[MONITORS_NUM];
+
+#ifdef ENABLE_SHMFB_LOG
+int shmfb_do_log = ENABLE_SHMFB_LOG;
+
+static void
+shmfb_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (shmfb_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define shmfb_log(fmt, ...)
+#endif
+
+static int
+shmfb_open(shmfb_t *dev, int monitor_index)
+{
+    void *ptr;
+    int   fd;
+
+    if (monitor_index)
+        snprintf(dev->name, sizeof(dev->name), "%s%s-%i", (video_shm_name[0] == '/') ? "" : "/", video_shm_name, monitor_index);
+    else
+        snprintf(dev->name, sizeof(dev->name), "%s%s", (video_shm_name[0] == '/') ? "" : "/", video_shm_name);
+
+    dev->size = sizeof(shmfb_header_t) + ((size_t) SHMFB_SLOTS * SHMFB_MAX_Y * SHMFB_STRIDE);
+
+    fd = shm_open(dev->name, O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        pclog("SHMFB: unable to create \"%s\"\n", dev->name);
+        return 0;
+    }
+    if (ftruncate(fd, dev->size) < 0) {
+        pclog("SHMFB: unable to size \"%s\" to %i bytes\n", dev->name, (int) dev->size);
+        close(fd);
+        shm_unlink(dev->name);
+        return 0;
+    }
+
+    ptr = mmap(NULL, dev->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        pclog("SHMFB: unable to map \"%s\"\n", dev->name);
+        shm_unlink(dev->name);
+        return 0;
+    }
+
+    dev->hdr = (shmfb_header_t *) ptr;
+    memset(dev->hdr, 0, sizeof(shmfb_header_t));
+    memcpy(dev->hdr->magic, SHMFB_MAGIC, sizeof(dev->hdr->magic));
+    dev->hdr->version = SHMFB_VERSION;
+    dev->hdr->slots   = SHMFB_SLOTS;
+    dev->hdr->max_x   = SHMFB_MAX_X;
+    dev->hdr->max_y   = SHMFB_MAX_Y;
+    dev->hdr->stride  = SHMFB_STRIDE;
+    dev->hdr->monitor = monitor_index;
+    for (int i = 0; i < SHMFB_SLOTS; i++)
+        dev->hdr->slot[i].offset = sizeof(shmfb_header_t) + ((uint64_t) i * SHMFB_MAX_Y * SHMFB_STRIDE);
+
+    dev->w = 0;
+    dev->h = 0;
+
+    pclog("SHMFB: publishing monitor %i frames to \"%s\"\n", monitor_index, dev->name);
+    return 1;
+}
+
+/* Called by the blit thread before the platform blit, with the rectangle and
+   changed rows of the frame; see video_blit_get_dirty_monitor(). */
+void
+shmfb_publish(int x, int y, int w, int h, int dirty_y1, int dirty_y2, int monitor_index)
+{
+    shmfb_t      *dev = &shmfb[monitor_index];
+    shmfb_slot_t *slot;
+    bitmap_t     *buf = monitors[monitor_index].target_buffer;
+    uint8_t      *pixels;
+    uint64_t      frame;
+    int           nr;
+
+    if (!video_shm_name[0] || dev->failed || (buf == NULL) ||
+        (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > SHMFB_MAX_X) || (h > SHMFB_MAX_Y))
+        return;
+
+    if ((dev->hdr == NULL) && !shmfb_open(dev, monitor_index)) {
+        dev->failed = 1;
+        return;
+    }
+
+    if ((x != dev->x) || (y != dev->y) || (w != dev->w) || (h != dev->h)) {
+        dev->x   = x;
+        dev->y   = y;
+        dev->w   = w;
+        dev->h   = h;
+        dirty_y1 = y;
+        dirty_y2 = y + h;
+        for (int i = 0; i < SHMFB_SLOTS; i++) {
+            dev->missing_y1[i] = y;
+            dev->missing_y2[i] = y + h;
+        }
+    } else if (dirty_y2 > dirty_y1) {
+        for (int i = 0; i < SHMFB_SLOTS; i++) {
+            if (dev->missing_y2[i] > dev->missing_y1[i]) {
+                dev->missing_y1[i] = MIN(dev->missing_y1[i], dirty_y1);
+                dev->missing_y2[i] = MAX(dev->missing_y2[i], dirty_y2);
+            } else {
+                dev->missing_y1[i] = dirty_y1;
+                dev->missing_y2[i] = dirty_y2;
+            }
+        }
+    }
+
+    frame  = dev->hdr->seq + 1;
+    nr     = (int) (frame % SHMFB_SLOTS);
+    slot   = &dev->hdr->slot[nr];
+    pixels = (uint8_t *) dev->hdr + slot->offset;
+
+    slot->seq = (frame << 1) - 1;
+    atomic_thread_fence(memory_order_seq_cst);
+
+    for (int row = dev->missing_y1[nr]; row < dev->missing_y2[nr]; row++)
+        memcpy(&pixels[(row - y) * SHMFB_STRIDE], &buf->line[row][x], w * sizeof(uint32_t));
+    dev->missing_y1[nr] = 0;
+    dev->missing_y2[nr] = 0;
+
+    slot->w        = w;
+    slot->h        = h;
+    slot->dirty_y1 = dirty_y1 - y;
+    slot->dirty_y2 = MAX(dirty_y2, dirty_y1) - y;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    slot->seq     = frame << 1;
+    dev->hdr->seq = frame;
+
+    shmfb_log("SHMFB: monitor %i frame %" PRIu64 " in slot %i, rows %i-%i changed\n",
+              monitor_index, frame, nr, dirty_y1 - y, dirty_y2 - y);
+}
+
+void
+shmfb_close(int monitor_index)
+{
+    shmfb_t *dev = &shmfb[monitor_index];
+
+    if (dev->hdr != NULL) {
+        munmap(dev->hdr, dev->size);
+        shm_unlink(dev->name);
+    }
+
+    memset(dev, 0, sizeof(shmfb_t));
+}
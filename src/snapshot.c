@@ -0,0 +1,410 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Machine state snapshots.
+ *
+ *          The file is a short header followed by a stream of
+ *          sections, each one tagged with the name and number of
+ *          the state it holds. Sections are written through a
+ *          memory buffer so their length is known up front, except
+ *          for guest RAM, which is streamed page by page with zero
+ *          pages run-length encoded and repeated pages stored as a
+ *          reference to their first copy.
+ *
+ *          Devices opt in by providing a snapshot handler in their
+ *          device_t; devices without one keep their current state
+ *          on load, and are listed in the log when saving.
+ */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/device.h>
+#include <86box/machine.h>
+#include <86box/mem.h>
+#include <86box/plat.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
+
+#define SNAPSHOT_MAGIC   "86BoxSNP"
+#define SNAPSHOT_VERSION 1
+
+#define SNAPSHOT_CHUNK   65536
+
+struct snapshot_t {
+    FILE    *fp;
+    int      loading;
+    int      error;
+    int      touched; /* machine state has been overwritten by a load */
+
+    /* Current section; NULL buffer means data goes straight to the file. */
+    uint8_t *buf;
+    size_t   len;
+    size_t   size;
+    size_t   pos;
+};
+
+volatile int snapshot_pending = 0;
+
+static char snapshot_fn[1024];
+
+#ifdef ENABLE_SNAPSHOT_LOG
+int snapshot_do_log = ENABLE_SNAPSHOT_LOG;
+
+static void
+snapshot_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (snapshot_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define snapshot_log(fmt, ...)
+#endif
+
+void
+snapshot_error(snapshot_t *snap, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (!snap->error) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+    snap->error = 1;
+}
+
+int
+snapshot_loading(snapshot_t *snap)
+{
+    return snap->loading;
+}
+
+int
+snapshot_failed(snapshot_t *snap)
+{
+    return snap->error;
+}
+
+static void
+snapshot_file_data(snapshot_t *snap, void *data, size_t len)
+{
+    if (snap->error)
+        return;
+
+    if (snap->loading) {
+        if (fread(data, 1, len, snap->fp) != len)
+            snapshot_error(snap, "Snapshot: unexpected end of file\n");
+    } else if (fwrite(data, 1, len, snap->fp) != len)
+        snapshot_error(snap, "Snapshot: write error\n");
+}
+
+void
+snapshot_data(snapshot_t *snap, void *data, size_t len)
+{
+    if (snap->error)
+        return;
+
+    if (snap->buf == NULL) {
+        snapshot_file_data(snap, data, len);
+        return;
+    }
+
+    if (snap->loading) {
+        if (len > (snap->len - snap->pos)) {
+            snapshot_error(snap, "Snapshot: section is shorter than its handler expects\n");
+            return;
+        }
+        memcpy(data, &snap->buf[snap->pos], len);
+        snap->pos += len;
+    } else {
+        if ((snap->len + len) > snap->size) {
+            size_t   size = snap->size;
+            uint8_t *buf;
+
+            while ((snap->len + len) > size)
+                size += SNAPSHOT_CHUNK;
+            if ((buf = realloc(snap->buf, size)) == NULL) {
+                snapshot_error(snap, "Snapshot: out of memory\n");
+                return;
+            }
+            snap->buf  = buf;
+            snap->size = size;
+        }
+        memcpy(&snap->buf[snap->len], data, len);
+        snap->len += len;
+    }
+}
+
+/* Timers are stored with their absolute timestamps, which stay valid since
+   the TSC is restored along with the CPU. */
+void
+snapshot_timer(snapshot_t *snap, pc_timer_t *timer)
+{
+    uint64_t ts;
+    int      flags;
+    double   period;
+
+    ts     = timer->ts.ts64;
+    flags  = timer->flags & (TIMER_ENABLED | TIMER_SPLIT);
+    period = timer->period;
+
+    snapshot_var(snap, ts);
+    snapshot_var(snap, flags);
+    snapshot_var(snap, period);
+
+    if (!snap->loading || snap->error)
+        return;
+
+    timer_disable(timer);
+    timer->ts.ts64 = ts;
+    timer->period = period;
+    timer->flags  = (timer->flags & ~TIMER_SPLIT) | (flags & TIMER_SPLIT);
+    if (flags & TIMER_ENABLED)
+        timer_enable(timer);
+}
+
+static void
+snapshot_string(snapshot_t *snap, char *str, size_t size)
+{
+    uint32_t len = (uint32_t) strlen(str);
+
+    snapshot_var(snap, len);
+    if (snap->error)
+        return;
+    if (len >= size) {
+        snapshot_error(snap, "Snapshot: string too long\n");
+        return;
+    }
+    snapshot_data(snap, str, len);
+    str[len] = '\0';
+}
+
+/* Write or read one section, running its handler against the section's
+   buffer. On load, the section in the file must carry the same name and
+   number, and the handler must consume all of it. */
+void
+snapshot_device(snapshot_t *snap, const char *name, int nr,
+                void (*handler)(void *priv, snapshot_t *snap), void *priv)
+{
+    char     sname[256];
+    uint32_t snr = nr;
+    uint32_t len;
+
+    if (snap->error)
+        return;
+
+    snprintf(sname, sizeof(sname), "%s", name);
+    snapshot_string(snap, sname, sizeof(sname));
+    snapshot_var(snap, snr);
+    if (snap->error)
+        return;
+
+    if (snap->loading) {
+        if (strcmp(sname, name) || (snr != (uint32_t) nr)) {
+            snapshot_error(snap, "Snapshot: expected \"%s\" #%i, found \"%s\" #%u - "
+                               "configuration differs\n", name, nr, sname, snr);
+            return;
+        }
+
+        snapshot_file_data(snap, &len, sizeof(len));
+        if (snap->error)
+            return;
+        if ((snap->buf = malloc(len ? len : 1)) == NULL) {
+            snapshot_error(snap, "Snapshot: out of memory\n");
+            return;
+        }
+        snap->len = len;
+        snap->pos = 0;
+        snapshot_file_data(snap, snap->buf, len);
+
+        if (!snap->error) {
+            snap->touched = 1;
+            handler(priv, snap);
+            if (!snap->error && (snap->pos != snap->len))
+                snapshot_error(snap, "Snapshot: \"%s\" #%i has %i bytes left over\n",
+                               name, nr, (int) (snap->len - snap->pos));
+        }
+    } else {
+        /* Start a buffer so that snapshot_data() collects the section. */
+        snap->len = 0;
+        if ((snap->buf = malloc(SNAPSHOT_CHUNK)) == NULL) {
+            snapshot_error(snap, "Snapshot: out of memory\n");
+            return;
+        }
+        snap->size = SNAPSHOT_CHUNK;
+
+        handler(priv, snap);
+
+        len = (uint32_t) snap->len;
+        snapshot_file_data(snap, &len, sizeof(len));
+        snapshot_file_data(snap, snap->buf, snap->len);
+    }
+
+    snapshot_log("Snapshot: %s \"%s\" #%i, %i bytes\n", snap->loading ? "loaded" : "saved",
+                 name, nr, (int) snap->len);
+
+    free(snap->buf);
+    snap->buf  = NULL;
+    snap->len  = 0;
+    snap->size = 0;
+    snap->pos  = 0;
+}
+
+typedef struct snapshot_core_t {
+    const char *name;
+    void (*handler)(snapshot_t *snap);
+} snapshot_core_t;
+
+/* State that does not belong to a device_t, saved ahead of the devices. */
+static const snapshot_core_t snapshot_cores[] = {
+    { "cpu", cpu_snapshot },
+    { "pic", pic_snapshot },
+    { "dma", dma_snapshot },
+    { NULL,  NULL         }
+};
+
+static void
+snapshot_core(void *priv, snapshot_t *snap)
+{
+    const snapshot_core_t *core = (const snapshot_core_t *) priv;
+
+    core->handler(snap);
+}
+
+/* Header check: build, machine, CPU and memory size must all match. */
+static void
+snapshot_header(snapshot_t *snap)
+{
+    char     magic[8];
+    uint32_t version    = SNAPSHOT_VERSION;
+    uint32_t cpu_size   = sizeof(cpu_state_t);
+    char     mach[256];
+    char     cpu_name[256];
+    int      cpu_nr     = cpu;
+    uint32_t mem_kb     = mem_size;
+
+    memcpy(magic, SNAPSHOT_MAGIC, sizeof(magic));
+    snprintf(mach, sizeof(mach), "%s", machine_get_internal_name());
+    snprintf(cpu_name, sizeof(cpu_name), "%s", cpu_f->internal_name);
+
+    snapshot_file_data(snap, magic, sizeof(magic));
+    snapshot_file_data(snap, &version, sizeof(version));
+    snapshot_file_data(snap, &cpu_size, sizeof(cpu_size));
+    snapshot_string(snap, mach, sizeof(mach));
+    snapshot_string(snap, cpu_name, sizeof(cpu_name));
+    snapshot_file_data(snap, &cpu_nr, sizeof(cpu_nr));
+    snapshot_file_data(snap, &mem_kb, sizeof(mem_kb));
+
+    if (!snap->loading || snap->error)
+        return;
+
+    if (memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)))
+        snapshot_error(snap, "Snapshot: not a snapshot file\n");
+    else if ((version != SNAPSHOT_VERSION) || (cpu_size != sizeof(cpu_state_t)))
+        snapshot_error(snap, "Snapshot: taken with a different build\n");
+    else if (strcmp(mach, machine_get_internal_name()) || strcmp(cpu_name, cpu_f->internal_name) ||
+             (cpu_nr != cpu) || (mem_kb != mem_size))
+        snapshot_error(snap, "Snapshot: taken on a %s/%s/%i with %u KB, this is a %s/%s/%i with %u KB\n",
+                       mach, cpu_name, cpu_nr, mem_kb, machine_get_internal_name(),
+                       cpu_f->internal_name, cpu, mem_size);
+}
+
+static int
+snapshot_run(const char *fn, int load, int *touched)
+{
+    snapshot_t snap;
+
+    memset(&snap, 0, sizeof(snapshot_t));
+    snap.loading = load;
+
+    snap.fp = plat_fopen(fn, load ? "rb" : "wb");
+    if (snap.fp == NULL) {
+        pclog("Snapshot: unable to open \"%s\"\n", fn);
+        return 0;
+    }
+
+    snapshot_header(&snap);
+
+    for (const snapshot_core_t *core = snapshot_cores; core->name != NULL; core++)
+        snapshot_device(&snap, core->name, 0, snapshot_core, (void *) core);
+    device_snapshot_all(&snap);
+
+    /* RAM goes last and is streamed straight to the file. */
+    if (!snap.error) {
+        snap.touched = load;
+        mem_snapshot(&snap);
+    }
+
+    (void) fclose(snap.fp);
+    if (touched != NULL)
+        *touched = snap.touched;
+
+    if (snap.error) {
+        if (!load)
+            (void) remove(fn);
+        pclog("Snapshot: %s \"%s\" failed\n", load ? "loading" : "saving", fn);
+        return 0;
+    }
+
+    pclog("Snapshot: %s \"%s\"\n", load ? "loaded" : "saved", fn);
+    return 1;
+}
+
+int
+snapshot_save(const char *fn)
+{
+    return snapshot_run(fn, 0, NULL);
+}
+
+int
+snapshot_load(const char *fn)
+{
+    int touched = 0;
+    int ret     = snapshot_run(fn, 1, &touched);
+
+    /* A partial load leaves the machine in an inconsistent state. */
+    if (!ret && touched)
+        pc_reset_hard();
+
+    return ret;
+}
+
+void
+snapshot_request(const char *fn, int load)
+{
+    if (snapshot_pending)
+        return;
+
+    snprintf(snapshot_fn, sizeof(snapshot_fn), "%s", fn);
+    snapshot_pending = load ? 2 : 1;
+}
+
+/* Called by the emulation thread between blocks, so nothing is mid-instruction. */
+void
+snapshot_process(void)
+{
+    int load = (snapshot_pending == 2);
+
+    if (load)
+        (void) snapshot_load(snapshot_fn);
+    else
+        (void) snapshot_save(snapshot_fn);
+
+    snapshot_pending = 0;
+}
@@ -29,6 +29,7 @@
 
 extern void givealbuffer_midi(void *buf, uint32_t size);
 extern void al_set_midi(int freq, int buf_size);
+extern void al_set_midi_ahead(int ms);
 
 typedef struct fluidsynth {
     fluid_settings_t *settings;
@@ -36,13 +37,18 @@ typedef struct fluidsynth {
     int               samplerate;
     int               sound_font;
 
-    thread_t *thread_h;
-    event_t  *event, *start_event;
+    int       render_id;
+    int       block_segs;
+    int       buf_pos;
     int       buf_size;
     float    *buffer;
     int16_t  *buffer_int16;
     int       midi_pos;
 
+    /* The sound font is loaded in the background. */
+    device_task_t *load_task;
+    char           sound_font_path[1024];
+
     int on;
 } fluidsynth_t;
 
@@ -54,50 +60,73 @@ fluidsynth_available(void)
     return 1;
 }
 
+/* Returns 1 once the sound font is loaded, waiting for it if asked to. */
+static int
+fluidsynth_loaded(fluidsynth_t *data, int wait)
+{
+    if (data->load_task != NULL) {
+        if (!wait && !device_task_done(data->load_task))
+            return 0;
+        device_task_wait(&data->load_task);
+    }
+
+    return 1;
+}
+
+static void
+fluidsynth_load(void *priv)
+{
+    fluidsynth_t *data = (fluidsynth_t *) priv;
+
+    data->sound_font = fluid_synth_sfload(data->synth, data->sound_font_path, 1);
+}
+
 void
 fluidsynth_poll(void)
 {
     fluidsynth_t *data = &fsdev;
+
+    /* Nothing to render before there are instruments to play. */
+    if (!fluidsynth_loaded(data, 0))
+        return;
+
     data->midi_pos++;
-    if (data->midi_pos == SOUND_FREQ / RENDER_RATE) {
+    if (data->midi_pos == (SOUND_FREQ / RENDER_RATE) * data->block_segs) {
         data->midi_pos = 0;
-        thread_set_event(data->event);
+        sound_render_request(data->render_id);
     }
 }
 
+/* One render pass of block_segs segments, run on the sound render workers.
+   Messages take effect at the start of the block they arrived in. */
 static void
-fluidsynth_thread(void *param)
+fluidsynth_render(void *priv)
 {
-    fluidsynth_t *data     = (fluidsynth_t *) param;
-    int           buf_pos  = 0;
-    int           buf_size = data->buf_size / BUFFER_SEGMENTS;
-
-    thread_set_event(data->start_event);
-
-    while (data->on) {
-        thread_wait_event(data->event, -1);
-        thread_reset_event(data->event);
-
-        if (sound_is_float) {
-            float *buf = (float *) ((uint8_t *) data->buffer + buf_pos);
-            memset(buf, 0, buf_size);
-            if (data->synth)
-                fluid_synth_write_float(data->synth, buf_size / (2 * sizeof(float)), buf, 0, 2, buf, 1, 2);
-            buf_pos += buf_size;
-            if (buf_pos >= data->buf_size) {
-                givealbuffer_midi(data->buffer, data->buf_size / sizeof(float));
-                buf_pos = 0;
-            }
-        } else {
-            int16_t *buf = (int16_t *) ((uint8_t *) data->buffer_int16 + buf_pos);
-            memset(buf, 0, buf_size);
-            if (data->synth)
-                fluid_synth_write_s16(data->synth, buf_size / (2 * sizeof(int16_t)), buf, 0, 2, buf, 1, 2);
-            buf_pos += buf_size;
-            if (buf_pos >= data->buf_size) {
-                givealbuffer_midi(data->buffer_int16, data->buf_size / sizeof(int16_t));
-                buf_pos = 0;
-            }
+    fluidsynth_t *data     = (fluidsynth_t *) priv;
+    int           buf_size = (data->buf_size / BUFFER_SEGMENTS) * data->block_segs;
+
+    if (!data->on)
+        return;
+
+    if (sound_is_float) {
+        float *buf = (float *) ((uint8_t *) data->buffer + data->buf_pos);
+        memset(buf, 0, buf_size);
+        if (data->synth)
+            fluid_synth_write_float(data->synth, buf_size / (2 * sizeof(float)), buf, 0, 2, buf, 1, 2);
+        data->buf_pos += buf_size;
+        if (data->buf_pos >= data->buf_size) {
+            givealbuffer_midi(data->buffer, data->buf_size / sizeof(float));
+            data->buf_pos = 0;
+        }
+    } else {
+        int16_t *buf = (int16_t *) ((uint8_t *) data->buffer_int16 + data->buf_pos);
+        memset(buf, 0, buf_size);
+        if (data->synth)
+            fluid_synth_write_s16(data->synth, buf_size / (2 * sizeof(int16_t)), buf, 0, 2, buf, 1, 2);
+        data->buf_pos += buf_size;
+        if (data->buf_pos >= data->buf_size) {
+            givealbuffer_midi(data->buffer_int16, data->buf_size / sizeof(int16_t));
+            data->buf_pos = 0;
         }
     }
 }
@@ -114,6 +143,8 @@ fluidsynth_msg(uint8_t *msg)
     uint8_t  cmd    = (uint8_t) (val & 0xF0);
     uint8_t  chan   = (uint8_t) (val & 0x0F);
 
+    fluidsynth_loaded(data, 1);
+
     switch (cmd) {
         case 0x80: /* Note Off */
             fluid_synth_noteoff(data->synth, chan, param1);
@@ -147,6 +178,7 @@ fluidsynth_sysex(uint8_t *data, unsigned int len)
 {
     fluidsynth_t *d = &fsdev;
 
+    fluidsynth_loaded(d, 1);
     fluid_synth_sysex(d->synth, (const char *) data, len, 0, 0, 0, 0);
 }
 
@@ -162,6 +194,9 @@ fluidsynth_init(UNUSED(const device_t *info))
 
     fluid_settings_setnum(data->settings, "synth.sample-rate", 44100);
     fluid_settings_setnum(data->settings, "synth.gain", device_get_config_int("output_gain") / 100.0f);
+    fluid_settings_setint(data->settings, "synth.polyphony", device_get_config_int("polyphony"));
+    /* Extra cores render voices in parallel, inside each fluid_synth_write call. */
+    fluid_settings_setint(data->settings, "synth.cpu-cores", device_get_config_int("cpu_cores"));
 
     data->synth = new_fluid_synth(data->settings);
 
@@ -171,7 +206,8 @@ fluidsynth_init(UNUSED(const device_t *info))
         sound_font = (access("/usr/share/sounds/sf2/FluidR3_GM.sf2", F_OK) == 0 ? "/usr/share/sounds/sf2/FluidR3_GM.sf2" :
                       (access("/usr/share/soundfonts/default.sf2", F_OK) == 0 ? "/usr/share/soundfonts/default.sf2" : ""));
 #endif
-    data->sound_font = fluid_synth_sfload(data->synth, sound_font, 1);
+    if (sound_font != NULL)
+        snprintf(data->sound_font_path, sizeof(data->sound_font_path), "%s", sound_font);
 
     if (device_get_config_int("chorus")) {
 #ifndef USE_OLD_FLUIDSYNTH_API
@@ -262,6 +298,11 @@ fluidsynth_init(UNUSED(const device_t *info))
     }
 
     al_set_midi(data->samplerate, data->buf_size);
+    al_set_midi_ahead(device_get_config_int("render_ahead"));
+
+    data->block_segs = device_get_config_int("render_block");
+    if ((data->block_segs < 1) || (BUFFER_SEGMENTS % data->block_segs))
+        data->block_segs = 1;
 
     dev = malloc(sizeof(midi_device_t));
     memset(dev, 0, sizeof(midi_device_t));
@@ -270,17 +311,15 @@ fluidsynth_init(UNUSED(const device_t *info))
     dev->play_sysex = fluidsynth_sysex;
     dev->poll       = fluidsynth_poll;
 
-    midi_out_init(dev);
-
-    data->on = 1;
+    data->on        = 1;
+    data->buf_pos   = 0;
+    data->render_id = sound_render_add(fluidsynth_render, data);
 
-    data->start_event = thread_create_event();
+    /* Sound fonts run to hundreds of megabytes, load it while the rest of
+       the machine comes up; the first message waits for it if need be. */
+    data->load_task = device_task_start(fluidsynth_load, data);
 
-    data->event    = thread_create_event();
-    data->thread_h = thread_create(fluidsynth_thread, data);
-
-    thread_wait_event(data->start_event, -1);
-    thread_reset_event(data->start_event);
+    midi_out_init(dev);
 
     return dev;
 }
@@ -294,8 +333,10 @@ fluidsynth_close(void *priv)
     fluidsynth_t *data = &fsdev;
 
     data->on = 0;
-    thread_set_event(data->event);
-    thread_wait(data->thread_h);
+    sound_render_remove(data->render_id);
+    data->render_id = -1;
+
+    device_task_wait(&data->load_task);
 
     if (data->synth) {
         delete_fluid_synth(data->synth);
@@ -480,6 +521,102 @@ static const device_config_t fluidsynth_config[] = {
         },
         .default_int = 2
     },
+    {
+        .name = "polyphony",
+        .description = "Polyphony",
+        .type = CONFIG_SELECTION,
+        .selection =
+        {
+            {
+                .description = "64 voices",
+                .value = 64
+            },
+            {
+                .description = "128 voices",
+                .value = 128
+            },
+            {
+                .description = "256 voices",
+                .value = 256
+            },
+            {
+                .description = "512 voices",
+                .value = 512
+            }
+        },
+        .default_int = 256
+    },
+    {
+        .name = "cpu_cores",
+        .description = "Render threads",
+        .type = CONFIG_SELECTION,
+        .selection =
+        {
+            {
+                .description = "1",
+                .value = 1
+            },
+            {
+                .description = "2",
+                .value = 2
+            },
+            {
+                .description = "4",
+                .value = 4
+            },
+            {
+                .description = "8",
+                .value = 8
+            }
+        },
+        .default_int = 1
+    },
+    {
+        .name = "render_block",
+        .description = "Render block",
+        .type = CONFIG_SELECTION,
+        .selection =
+        {
+            {
+                .description = "10 ms",
+                .value = 1
+            },
+            {
+                .description = "20 ms",
+                .value = 2
+            },
+            {
+                .description = "50 ms",
+                .value = 5
+            }
+        },
+        .default_int = 1
+    },
+    {
+        .name = "render_ahead",
+        .description = "Render ahead",
+        .type = CONFIG_SELECTION,
+        .selection =
+        {
+            {
+                .description = "None",
+                .value = 0
+            },
+            {
+                .description = "50 ms",
+                .value = 50
+            },
+            {
+                .description = "100 ms",
+                .value = 100
+            },
+            {
+                .description = "200 ms",
+                .value = 200
+            }
+        },
+        .default_int = 0
+    },
     { .name = "", .description = "", .type = CONFIG_END }
   // clang-format on
 };
@@ -150,19 +150,36 @@ cm32ln_available(void)
     return roms_present[1];
 }
 
-static thread_t *thread_h    = NULL;
-static event_t  *event       = NULL;
-static event_t  *start_event = NULL;
-static int       mt32_on     = 0;
+static int mt32_render_id = -1;
+static int mt32_on        = 0;
 
 #define RENDER_RATE     100
 #define BUFFER_SEGMENTS 10
+#define MIDI_QUEUE_SIZE 4096
 
 static uint32_t samplerate   = 44100;
 static int      buf_size     = 0;
 static float   *buffer       = NULL;
 static int16_t *buffer_int16 = NULL;
 static int      midi_pos     = 0;
+static int      buf_pos      = 0;
+static int      block_segs   = BUFFER_SEGMENTS;
+static uint64_t poll_count   = 0;
+static uint32_t ts_base      = 0;
+
+/* The ROMs are loaded and the synth opened in the background. */
+static device_task_t *load_task = NULL;
+static int            load_ok   = 0;
+static char           load_ctrl_fn[512];
+static char           load_pcm_fn[512];
+static struct {
+    int   renderer;
+    float output_gain;
+    int   reverb;
+    float reverb_output_gain;
+    int   reversed_stereo;
+    int   nice_ramp;
+} load_opts;
 
 static mt32emu_report_handler_version
 get_mt32_report_handler_version(UNUSED(mt32emu_report_handler_i i))
@@ -198,48 +215,117 @@ mt32_stream_int16(int16_t *stream, int len)
         mt32emu_render_bit16s(context, stream, len);
 }
 
+static void
+mt32_load(UNUSED(void *priv))
+{
+    load_ok = 0;
+
+    if (!mt32_check("mt32emu_add_rom_file", mt32emu_add_rom_file(context, load_ctrl_fn), MT32EMU_RC_ADDED_CONTROL_ROM))
+        return;
+    if (!mt32_check("mt32emu_add_rom_file", mt32emu_add_rom_file(context, load_pcm_fn), MT32EMU_RC_ADDED_PCM_ROM))
+        return;
+
+    mt32emu_select_renderer_type(context, load_opts.renderer ? MT32EMU_RT_FLOAT : MT32EMU_RT_BIT16S);
+
+    if (!mt32_check("mt32emu_open_synth", mt32emu_open_synth(context), MT32EMU_RC_OK))
+        return;
+
+    /* Up to a whole buffer of messages is queued ahead of the renderer. */
+    mt32emu_set_midi_event_queue_size(context, MIDI_QUEUE_SIZE);
+
+    mt32emu_set_output_gain(context, load_opts.output_gain);
+    mt32emu_set_reverb_enabled(context, load_opts.reverb);
+    mt32emu_set_reverb_output_gain(context, load_opts.reverb_output_gain);
+    mt32emu_set_reversed_stereo_enabled(context, load_opts.reversed_stereo);
+    mt32emu_set_nice_amp_ramp_enabled(context, load_opts.nice_ramp);
+
+    load_ok = 1;
+}
+
+/*
+ * Returns 1 once the synth is open, waiting for it if asked to. Emulated
+ * time starts counting for the synth from then on, so messages are not
+ * held back for as long as the load took.
+ */
+static int
+mt32_loaded(int wait)
+{
+    if (load_task != NULL) {
+        if (!wait && !device_task_done(load_task))
+            return 0;
+        device_task_wait(&load_task);
+
+        if (!load_ok) {
+            mt32emu_free_context(context);
+            context = NULL;
+            return 1;
+        }
+
+        midi_pos   = 0;
+        poll_count = 0;
+        ts_base    = mt32emu_get_internal_rendered_sample_count(context);
+        mt32_on    = 1;
+    }
+
+    return 1;
+}
+
 void
 mt32_poll(void)
 {
+    if (!mt32_loaded(0))
+        return;
+
+    poll_count++;
     midi_pos++;
-    if (midi_pos == SOUND_FREQ / RENDER_RATE) {
+    if (midi_pos == (SOUND_FREQ / RENDER_RATE) * block_segs) {
         midi_pos = 0;
-        thread_set_event(event);
+        sound_render_request(mt32_render_id);
     }
 }
 
+/*
+ * Synth time of the current emulated sound sample. A block is only
+ * requested once the emulation has gone past its end, so every message
+ * falling into it is already queued when it is rendered, and the synth
+ * plays it at the right sample however large the block is.
+ */
+static uint32_t
+mt32_timestamp(void)
+{
+    uint32_t pos = (uint32_t) ((poll_count * samplerate) / SOUND_FREQ);
+
+    return ts_base + mt32emu_convert_output_to_synth_timestamp(context, pos);
+}
+
+/* One render pass of block_segs segments, run on the sound render workers. */
 static void
-mt32_thread(UNUSED(void *param))
+mt32_render(UNUSED(void *priv))
 {
-    int      buf_pos = 0;
-    int      bsize   = buf_size / BUFFER_SEGMENTS;
+    int      bsize = (buf_size / BUFFER_SEGMENTS) * block_segs;
     float   *buf;
     int16_t *buf16;
 
-    thread_set_event(start_event);
-
-    while (mt32_on) {
-        thread_wait_event(event, -1);
-        thread_reset_event(event);
+    if (!mt32_on)
+        return;
 
-        if (sound_is_float) {
-            buf = (float *) ((uint8_t *) buffer + buf_pos);
-            memset(buf, 0, bsize);
-            mt32_stream(buf, bsize / (2 * sizeof(float)));
-            buf_pos += bsize;
-            if (buf_pos >= buf_size) {
-                givealbuffer_midi(buffer, buf_size / sizeof(float));
-                buf_pos = 0;
-            }
-        } else {
-            buf16 = (int16_t *) ((uint8_t *) buffer_int16 + buf_pos);
-            memset(buf16, 0, bsize);
-            mt32_stream_int16(buf16, bsize / (2 * sizeof(int16_t)));
-            buf_pos += bsize;
-            if (buf_pos >= buf_size) {
-                givealbuffer_midi(buffer_int16, buf_size / sizeof(int16_t));
-                buf_pos = 0;
-            }
+    if (sound_is_float) {
+        buf = (float *) ((uint8_t *) buffer + buf_pos);
+        memset(buf, 0, bsize);
+        mt32_stream(buf, bsize / (2 * sizeof(float)));
+        buf_pos += bsize;
+        if (buf_pos >= buf_size) {
+            givealbuffer_midi(buffer, buf_size / sizeof(float));
+            buf_pos = 0;
+        }
+    } else {
+        buf16 = (int16_t *) ((uint8_t *) buffer_int16 + buf_pos);
+        memset(buf16, 0, bsize);
+        mt32_stream_int16(buf16, bsize / (2 * sizeof(int16_t)));
+        buf_pos += bsize;
+        if (buf_pos >= buf_size) {
+            givealbuffer_midi(buffer_int16, buf_size / sizeof(int16_t));
+            buf_pos = 0;
         }
     }
 }
@@ -247,38 +333,41 @@ mt32_thread(UNUSED(void *param))
 void
 mt32_msg(uint8_t *val)
 {
+    mt32_loaded(1);
     if (context)
-        mt32_check("mt32emu_play_msg", mt32emu_play_msg(context, *(uint32_t *) val), MT32EMU_RC_OK);
+        mt32_check("mt32emu_play_msg_at", mt32emu_play_msg_at(context, *(uint32_t *) val, mt32_timestamp()), MT32EMU_RC_OK);
 }
 
 void
 mt32_sysex(uint8_t *data, unsigned int len)
 {
+    mt32_loaded(1);
     if (context)
-        mt32_check("mt32emu_play_sysex", mt32emu_play_sysex(context, data, len), MT32EMU_RC_OK);
+        mt32_check("mt32emu_play_sysex_at", mt32emu_play_sysex_at(context, data, len, mt32_timestamp()), MT32EMU_RC_OK);
 }
 
 void *
 mt32emu_init(char *control_rom, char *pcm_rom)
 {
     midi_device_t *dev;
-    char           fn[512];
 
     context = mt32emu_create_context(strstr(control_rom, "MT32_CONTROL.ROM") ? handler_mt32 : handler_cm32l, NULL);
 
-    if (!rom_getfile(control_rom, fn, 512))
-        return 0;
-    if (!mt32_check("mt32emu_add_rom_file", mt32emu_add_rom_file(context, fn), MT32EMU_RC_ADDED_CONTROL_ROM))
+    if (!rom_getfile(control_rom, load_ctrl_fn, 512))
         return 0;
-    if (!rom_getfile(pcm_rom, fn, 512))
-        return 0;
-    if (!mt32_check("mt32emu_add_rom_file", mt32emu_add_rom_file(context, fn), MT32EMU_RC_ADDED_PCM_ROM))
+    if (!rom_getfile(pcm_rom, load_pcm_fn, 512))
         return 0;
 
-    if (!mt32_check("mt32emu_open_synth", mt32emu_open_synth(context), MT32EMU_RC_OK))
-        return 0;
+    load_opts.renderer           = device_get_config_int("renderer");
+    load_opts.output_gain        = device_get_config_int("output_gain") / 100.0f;
+    load_opts.reverb             = device_get_config_int("reverb");
+    load_opts.reverb_output_gain = device_get_config_int("reverb_output_gain") / 100.0f;
+    load_opts.reversed_stereo    = device_get_config_int("reversed_stereo");
+    load_opts.nice_ramp          = device_get_config_int("nice_ramp");
 
-    samplerate = mt32emu_get_actual_stereo_output_samplerate(context);
+    /* What the synth opens at, in the default analog output mode; known
+       before the synth is open. */
+    samplerate = mt32emu_get_stereo_output_samplerate(MT32EMU_AOM_COARSE);
     /* buf_size = samplerate/RENDER_RATE*2; */
     if (sound_is_float) {
         buf_size     = (samplerate / RENDER_RATE) * 2 * BUFFER_SEGMENTS * sizeof(float);
@@ -290,12 +379,6 @@ mt32emu_init(char *control_rom, char *pcm_rom)
         buffer_int16 = malloc(buf_size);
     }
 
-    mt32emu_set_output_gain(context, device_get_config_int("output_gain") / 100.0f);
-    mt32emu_set_reverb_enabled(context, device_get_config_int("reverb"));
-    mt32emu_set_reverb_output_gain(context, device_get_config_int("reverb_output_gain") / 100.0f);
-    mt32emu_set_reversed_stereo_enabled(context, device_get_config_int("reversed_stereo"));
-    mt32emu_set_nice_amp_ramp_enabled(context, device_get_config_int("nice_ramp"));
-
     al_set_midi(samplerate, buf_size);
 
     dev = malloc(sizeof(midi_device_t));
@@ -305,17 +388,23 @@ mt32emu_init(char *control_rom, char *pcm_rom)
     dev->play_sysex = mt32_sysex;
     dev->poll       = mt32_poll;
 
-    midi_out_init(dev);
-
-    mt32_on = 1;
+    block_segs = device_get_config_int("render_block");
+    if ((block_segs < 1) || (BUFFER_SEGMENTS % block_segs))
+        block_segs = BUFFER_SEGMENTS;
 
-    start_event = thread_create_event();
+    mt32_on        = 0;
+    buf_pos        = 0;
+    midi_pos       = 0;
+    poll_count     = 0;
+    ts_base        = 0;
+    mt32_render_id = sound_render_add(mt32_render, NULL);
 
-    event    = thread_create_event();
-    thread_h = thread_create(mt32_thread, 0);
+    /* Validating the ROMs and opening the synth takes a while; do it while
+       the rest of the machine comes up. The first message waits for it if
+       need be. */
+    load_task = device_task_start(mt32_load, NULL);
 
-    thread_wait_event(start_event, -1);
-    thread_reset_event(start_event);
+    midi_out_init(dev);
 
     return dev;
 }
@@ -351,12 +440,10 @@ mt32_close(void *priv)
         return;
 
     mt32_on = 0;
-    thread_set_event(event);
-    thread_wait(thread_h);
+    sound_render_remove(mt32_render_id);
+    mt32_render_id = -1;
 
-    event       = NULL;
-    start_event = NULL;
-    thread_h    = NULL;
+    device_task_wait(&load_task);
 
     if (context) {
         mt32emu_close_synth(context);
@@ -415,6 +502,48 @@ static const device_config_t mt32_config[] = {
         .type = CONFIG_BINARY,
         .default_int = 1
     },
+    {
+        .name = "renderer",
+        .description = "Renderer",
+        .type = CONFIG_SELECTION,
+        .selection =
+        {
+            {
+                .description = "Integer",
+                .value = 0
+            },
+            {
+                .description = "Floating point",
+                .value = 1
+            }
+        },
+        .default_int = 0
+    },
+    {
+        .name = "render_block",
+        .description = "Render block",
+        .type = CONFIG_SELECTION,
+        .selection =
+        {
+            {
+                .description = "10 ms",
+                .value = 1
+            },
+            {
+                .description = "20 ms",
+                .value = 2
+            },
+            {
+                .description = "50 ms",
+                .value = 5
+            },
+            {
+                .description = "100 ms",
+                .value = 10
+            }
+        },
+        .default_int = 10
+    },
     { .name = "", .description = "", .type = CONFIG_END }
   // clang-format on
 };
@@ -281,8 +281,8 @@ typedef struct opl4_midi {
     uint32_t          midi_pos;
     bool              on;
     atomic_bool       gen_in_progress;
-    thread_t         *thread;
-    event_t          *wait_event;
+    uint32_t          buf_pos;
+    int               render_id;
 } opl4_midi_t;
 
 static opl4_midi_t *opl4_midi_cur;
@@ -556,46 +556,42 @@ program_change(uint8_t midi_channel, uint8_t program, opl4_midi_t *opl4_midi)
     opl4_midi->midi_channel_data[midi_channel].instrument = program;
 }
 
+/* One render pass, run on the sound render workers. */
 static void
-opl4_midi_thread(void *arg)
+opl4_midi_render(void *priv)
 {
-    opl4_midi_t *opl4_midi         = opl4_midi_cur;
+    opl4_midi_t *opl4_midi         = (opl4_midi_t *) priv;
     uint32_t     i                 = 0;
     uint32_t     buf_size          = RENDER_RATE * 2;
     uint32_t     buf_size_segments = buf_size * BUFFER_SEGMENTS;
-    uint32_t     buf_pos           = 0;
 
     int32_t buffer[RENDER_RATE * 2];
 
     extern void givealbuffer_midi(void *buf, uint32_t size);
-    while (opl4_midi->on) {
-        thread_wait_event(opl4_midi->wait_event, -1);
-        thread_reset_event(opl4_midi->wait_event);
-        if (!opl4_midi->on)
-            break;
-        atomic_store(&opl4_midi->gen_in_progress, true);
-        opl4_midi->opl4.generate(opl4_midi->opl4.priv, buffer, RENDER_RATE);
-        atomic_store(&opl4_midi->gen_in_progress, false);
-        if (sound_is_float) {
-            for (i = 0; i < (buf_size / 2); i++) {
-                opl4_midi->buffer_float[(i + buf_pos) * 2]       = buffer[i * 2] / 32768.0;
-                opl4_midi->buffer_float[((i + buf_pos) * 2) + 1] = buffer[(i * 2) + 1] / 32768.0;
-            }
-            buf_pos += buf_size / 2;
-            if (buf_pos >= (buf_size_segments / 2)) {
-                givealbuffer_midi(opl4_midi->buffer_float, buf_size_segments);
-                buf_pos = 0;
-            }
-        } else {
-            for (i = 0; i < (buf_size / 2); i++) {
-                opl4_midi->buffer[(i + buf_pos) * 2]       = buffer[i * 2] & 0xFFFF;       /* Outputs are clamped beforehand. */
-                opl4_midi->buffer[((i + buf_pos) * 2) + 1] = buffer[(i * 2) + 1] & 0xFFFF; /* Outputs are clamped beforehand. */
-            }
-            buf_pos += buf_size / 2;
-            if (buf_pos >= (buf_size_segments / 2)) {
-                givealbuffer_midi(opl4_midi->buffer, buf_size_segments);
-                buf_pos = 0;
-            }
+    if (!opl4_midi->on)
+        return;
+    atomic_store(&opl4_midi->gen_in_progress, true);
+    opl4_midi->opl4.generate(opl4_midi->opl4.priv, buffer, RENDER_RATE);
+    atomic_store(&opl4_midi->gen_in_progress, false);
+    if (sound_is_float) {
+        for (i = 0; i < (buf_size / 2); i++) {
+            opl4_midi->buffer_float[(i + opl4_midi->buf_pos) * 2]       = buffer[i * 2] / 32768.0;
+            opl4_midi->buffer_float[((i + opl4_midi->buf_pos) * 2) + 1] = buffer[(i * 2) + 1] / 32768.0;
+        }
+        opl4_midi->buf_pos += buf_size / 2;
+        if (opl4_midi->buf_pos >= (buf_size_segments / 2)) {
+            givealbuffer_midi(opl4_midi->buffer_float, buf_size_segments);
+            opl4_midi->buf_pos = 0;
+        }
+    } else {
+        for (i = 0; i < (buf_size / 2); i++) {
+            opl4_midi->buffer[(i + opl4_midi->buf_pos) * 2]       = buffer[i * 2] & 0xFFFF;       /* Outputs are clamped beforehand. */
+            opl4_midi->buffer[((i + opl4_midi->buf_pos) * 2) + 1] = buffer[(i * 2) + 1] & 0xFFFF; /* Outputs are clamped beforehand. */
+        }
+        opl4_midi->buf_pos += buf_size / 2;
+        if (opl4_midi->buf_pos >= (buf_size_segments / 2)) {
+            givealbuffer_midi(opl4_midi->buffer, buf_size_segments);
+            opl4_midi->buf_pos = 0;
         }
     }
 }
@@ -607,7 +603,7 @@ opl4_midi_poll(void)
     opl4_midi->midi_pos++;
     if (opl4_midi->midi_pos == RENDER_RATE) {
         opl4_midi->midi_pos = 0;
-        thread_set_event(opl4_midi->wait_event);
+        sound_render_request(opl4_midi->render_id);
     }
 }
 
@@ -667,7 +663,8 @@ opl4_init(const device_t *info)
 
     al_set_midi(48000, 4800);
 
-    opl4_midi_cur = calloc(1, sizeof(opl4_midi_t));
+    opl4_midi_cur            = calloc(1, sizeof(opl4_midi_t));
+    opl4_midi_cur->render_id = -1;
 
     fm_driver_get(FM_YMF278B, &opl4_midi_cur->opl4);
 
@@ -692,8 +689,7 @@ opl4_init(const device_t *info)
         opl4_midi_cur->voice_data[voice].reg_misc        = 0;
         opl4_midi_cur->voice_data[voice].reg_lfo_vibrato = 0;
     }
-    opl4_midi_cur->wait_event = thread_create_event();
-    opl4_midi_cur->thread     = thread_create(opl4_midi_thread, NULL);
+    opl4_midi_cur->render_id = sound_render_add(opl4_midi_render, opl4_midi_cur);
     return dev;
 }
 
@@ -704,8 +700,7 @@ opl4_close(void *p)
         return;
 
     opl4_midi_cur->on = false;
-    thread_set_event(opl4_midi_cur->wait_event);
-    thread_wait(opl4_midi_cur->thread);
+    sound_render_remove(opl4_midi_cur->render_id);
     free(opl4_midi_cur);
     opl4_midi_cur = NULL;
 }
@@ -8,6 +8,13 @@
  *
  *          MIDI backend implemented using the RtMidi library.
  *
+ *          Output goes through a queue, drained by a thread of its own so
+ *          the emulation thread never waits on the host MIDI driver. Each
+ *          message is stamped with the emulated time it was sent at, and
+ *          the thread sends it that long after the first message of the
+ *          run, plus a little latency, so the spacing the guest gave the
+ *          messages survives the emulator running in bursts.
+ *
  * Author:  Cacodemon345,
  *          Miran Grca, <mgrca8@gmail.com>
  *          Copyright 2021 Cacodemon345.
@@ -27,6 +34,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <vector>
 
 extern "C" {
 #include <86box/86box.h>
@@ -35,8 +44,14 @@ extern "C" {
 #include <86box/midi_rtmidi.h>
 #include <86box/ini.h>
 #include <86box/config.h>
+#include <86box/thread.h>
+#include <86box/bench.h>
 #include <86box/plat_unused.h>
 
+/* From cpu.h, which does not build as C++. */
+extern uint64_t tsc;
+extern double   cpuclock;
+
 // Disable c99-designator to avoid the warnings in rtmidi_*_device
 #ifdef __clang__
 #    if __has_warning("-Wc99-designator")
@@ -50,6 +65,140 @@ static RtMidiIn  *midiin      = nullptr;
 static int        midi_out_id = 0, midi_in_id = 0;
 static const int  midi_lengths[8] = { 3, 3, 3, 3, 2, 2, 3, 1 };
 
+#define MIDI_OUT_LATENCY_US 20000  /* added to the first message of a run */
+#define MIDI_OUT_AHEAD_US   250000 /* further ahead than this, start a new run */
+
+typedef struct midi_out_event_t {
+    uint64_t             time_us; /* Emulated. */
+    std::vector<uint8_t> data;
+} midi_out_event_t;
+
+static struct {
+    thread_t *thread;
+    event_t  *wake_event;
+    mutex_t  *mutex;
+    int       run;
+
+    std::deque<midi_out_event_t> events;
+
+    /* Emulated time, kept up to date as messages are queued. */
+    uint64_t emu_us;
+    uint64_t emu_tsc;
+} out_queue;
+
+static void
+rtmidi_out_thread(UNUSED(void *param))
+{
+    std::vector<midi_out_event_t> due;
+    uint64_t                      host_base = 0;
+    uint64_t                      emu_base  = 0;
+    int                           started   = 0;
+    int                           run       = 1;
+    int                           sent;
+    int                           timeout;
+    uint64_t                      now;
+    uint64_t                      when;
+
+    while (run) {
+        thread_wait_mutex(out_queue.mutex);
+        run = out_queue.run;
+        now = bench_host_ns() / 1000;
+
+        /* Take everything that is due in one go, sending it unlocked. */
+        timeout = -1;
+        while (!out_queue.events.empty()) {
+            midi_out_event_t &ev = out_queue.events.front();
+
+            when = host_base + (ev.time_us - emu_base);
+            if (!started || (ev.time_us < emu_base) || ((when + MIDI_OUT_LATENCY_US) < now) ||
+                (when > (now + MIDI_OUT_AHEAD_US))) {
+                /* The emulator fell behind or ran ahead, start a new run. */
+                host_base = when = now + MIDI_OUT_LATENCY_US;
+                emu_base         = ev.time_us;
+                started          = 1;
+            }
+
+            if (run && (when > now)) {
+                timeout = (int) ((when - now + 999) / 1000);
+                break;
+            }
+
+            due.push_back(std::move(ev));
+            out_queue.events.pop_front();
+        }
+        thread_release_mutex(out_queue.mutex);
+
+        /* RtMidi takes one message per call, so writes cannot be merged. */
+        sent = !due.empty();
+        if (midiout) {
+            for (auto &ev : due)
+                midiout->sendMessage(ev.data.data(), ev.data.size());
+        }
+        due.clear();
+
+        if (run && !sent) {
+            thread_wait_event(out_queue.wake_event, timeout);
+            thread_reset_event(out_queue.wake_event);
+        }
+    }
+}
+
+static void
+rtmidi_out_queue(const uint8_t *data, unsigned int len)
+{
+    midi_out_event_t ev;
+
+    if (out_queue.thread == nullptr) {
+        if (midiout)
+            midiout->sendMessage(data, len);
+        return;
+    }
+
+    ev.data.assign(data, data + len);
+
+    thread_wait_mutex(out_queue.mutex);
+    /* The counter starts over on hard reset. */
+    if (tsc >= out_queue.emu_tsc)
+        out_queue.emu_us += (uint64_t) ((double) (tsc - out_queue.emu_tsc) * 1000000.0 / cpuclock);
+    out_queue.emu_tsc = tsc;
+    ev.time_us        = out_queue.emu_us;
+
+    out_queue.events.push_back(std::move(ev));
+    thread_release_mutex(out_queue.mutex);
+
+    thread_set_event(out_queue.wake_event);
+}
+
+static void
+rtmidi_out_queue_start(void)
+{
+    out_queue.mutex      = thread_create_mutex();
+    out_queue.wake_event = thread_create_event();
+    out_queue.emu_us     = 0;
+    out_queue.emu_tsc    = tsc;
+    out_queue.run        = 1;
+    out_queue.thread     = thread_create(rtmidi_out_thread, nullptr);
+}
+
+/* Whatever is still queued is sent right away. */
+static void
+rtmidi_out_queue_stop(void)
+{
+    if (out_queue.thread == nullptr)
+        return;
+
+    thread_wait_mutex(out_queue.mutex);
+    out_queue.run = 0;
+    thread_release_mutex(out_queue.mutex);
+    thread_set_event(out_queue.wake_event);
+    thread_wait(out_queue.thread);
+    out_queue.thread = nullptr;
+
+    thread_destroy_event(out_queue.wake_event);
+    thread_close_mutex(out_queue.mutex);
+    out_queue.events.clear();
+}
+
 int
 rtmidi_write(UNUSED(uint8_t val))
 {
@@ -59,15 +208,13 @@ rtmidi_write(UNUSED(uint8_t val))
 void
 rtmidi_play_msg(uint8_t *msg)
 {
-    if (midiout)
-        midiout->sendMessage(msg, midi_lengths[(msg[0] >> 4) & 7]);
+    rtmidi_out_queue(msg, midi_lengths[(msg[0] >> 4) & 7]);
 }
 
 void
 rtmidi_play_sysex(uint8_t *sysex, unsigned int len)
 {
-    if (midiout)
-        midiout->sendMessage(sysex, len);
+    rtmidi_out_queue(sysex, len);
 }
 
 void *
@@ -105,6 +252,7 @@ rtmidi_output_init(UNUSED(const device_t *info))
         }
     }
 
+    rtmidi_out_queue_start();
     midi_out_init(dev);
 
     return dev;
@@ -116,6 +264,7 @@ rtmidi_output_close(UNUSED(void *priv))
     if (!midiout)
         return;
 
+    rtmidi_out_queue_stop();
     midiout->closePort();
 
     delete midiout;
@@ -25,6 +25,7 @@
 #include <86box/device.h>
 #include <86box/io.h>
 #include <86box/mem.h>
+#include <86box/dma.h>
 #include <86box/pci.h>
 #include <86box/pic.h>
 #include <86box/snd_ac97.h>
@@ -32,6 +33,11 @@
 #include <86box/timer.h>
 #include <86box/plat_unused.h>
 
+/* Playback SGDs fill their whole FIFO per run, so they only need to run often
+   enough to stay ahead of 48 KHz 16-bit stereo, which drains 10 of the 32
+   bytes in this time. */
+#define AC97_VIA_FIFO_REFILL 50.0
+
 typedef struct ac97_via_sgd_t {
     uint8_t            id;
     uint8_t            always_run;
@@ -538,6 +544,7 @@ ac97_via_update_stereo(ac97_via_t *dev, ac97_via_sgd_t *sgd)
     else if (r > 32767)
         r = 32767;
 
+    sound_pos_sync();
     for (; sgd->pos < sound_pos_global; sgd->pos++) {
         sgd->buffer[sgd->pos * 2]     = l;
         sgd->buffer[sgd->pos * 2 + 1] = r;
@@ -555,11 +562,16 @@ ac97_via_sgd_process(void *priv)
     if (!(sgd_status & 0x80))
         return;
 
+    /* Playback with the FIFO enabled moves as much as fits in one go. */
+    int     bulk = !sgd->always_run && !(sgd->id & 0x10);
+    uint8_t data[sizeof(sgd->fifo)];
+    int     n;
+
     /* Schedule next run. */
-    timer_on_auto(&sgd->dma_timer, 10.0);
+    timer_on_auto(&sgd->dma_timer, bulk ? AC97_VIA_FIFO_REFILL : 10.0);
 
-    /* Process SGD if it's active, and the FIFO has room or is disabled. */
-    if (((sgd_status & 0xc7) == 0x80) && (sgd->always_run || ((sgd->fifo_end - sgd->fifo_pos) <= (sizeof(sgd->fifo) - 4)))) {
+    /* Process SGD while it's active, and the FIFO has room or is disabled. */
+    while (((sgd_status & 0xc7) == 0x80) && (sgd->always_run || ((sgd->fifo_end - sgd->fifo_pos) <= (sizeof(sgd->fifo) - 4)))) {
         /* Move on to the next block if no entry is present. */
         if (sgd->restart) {
             /* (Re)load entry pointer if required. */
@@ -589,13 +601,26 @@ ac97_via_sgd_process(void *priv)
         if (sgd->id & 0x10) {
             /* Write channel: read data from FIFO. */
             mem_writel_phys(sgd->sample_ptr, *((uint32_t *) &sgd->fifo[sgd->fifo_end & (sizeof(sgd->fifo) - 1)]));
-        } else {
+            n = 1;
+        } else if (!bulk) {
             /* Read channel: write data to FIFO. */
             *((uint32_t *) &sgd->fifo[sgd->fifo_end & (sizeof(sgd->fifo) - 1)]) = mem_readl_phys(sgd->sample_ptr);
+            n = 1;
+        } else {
+            /* Read channel: fill the FIFO, up to the end of the block. */
+            n = (sizeof(sgd->fifo) - (sgd->fifo_end - sgd->fifo_pos)) >> 2;
+            if (n > ((sgd->sample_count + 3) >> 2))
+                n = (sgd->sample_count + 3) >> 2;
+            if (n < 1)
+                n = 1;
+
+            dma_bm_read(sgd->sample_ptr, data, n << 2, 4);
+            for (int i = 0; i < n; i++)
+                memcpy(&sgd->fifo[(sgd->fifo_end + (i << 2)) & (sizeof(sgd->fifo) - 1)], &data[i << 2], 4);
         }
-        sgd->fifo_end += 4;
-        sgd->sample_ptr += 4;
-        sgd->sample_count -= 4;
+        sgd->fifo_end += n << 2;
+        sgd->sample_ptr += n << 2;
+        sgd->sample_count -= n << 2;
 
         /* Check if we've hit the end of this block. */
         if (sgd->sample_count <= 0) {
@@ -655,6 +680,10 @@ ac97_via_sgd_process(void *priv)
             /* Fire any requested status interrupts. */
             ac97_via_update_irqs(dev);
         }
+
+        if (!bulk)
+            break;
+        sgd_status = dev->sgd_regs[sgd->id] & 0xc4;
     }
 }
 
@@ -647,6 +647,7 @@ adgold_read(uint16_t addr, void *priv)
 void
 adgold_update(adgold_t *adgold)
 {
+    sound_pos_sync();
     for (; adgold->pos < sound_pos_global; adgold->pos++) {
         adgold->mma_buffer[0][adgold->pos] = adgold->mma_buffer[1][adgold->pos] = 0;
 
@@ -25,6 +25,13 @@
 #include <string.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    define AUDIOPCI_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define AUDIOPCI_NEON
+#endif
 #define HAVE_STDARG_H
 
 #include <86box/86box.h>
@@ -43,8 +50,11 @@
 #define N            16
 
 #define ES1371_NCoef 91
+#define ES1371_NTaps ((ES1371_NCoef + N - 1) / N)
 
 static float low_fir_es1371_coef[ES1371_NCoef];
+/* The same coefficients by tap and output phase, zero past the end. */
+static float low_fir_es1371_taps[ES1371_NTaps][N];
 
 typedef struct es1371_t {
     uint8_t pci_command;
@@ -108,6 +118,9 @@ typedef struct es1371_t {
         int filtered_r[32];
         int f_pos;
 
+        float fir_x[2][128 / N];
+        int   fir_pos;
+
         int16_t out_l;
         int16_t out_r;
 
@@ -1882,17 +1895,19 @@ es1371_fetch(es1371_t *dev, int dac_nr)
     if (dev->si_cr & (dac_nr ? SI_P2_PAUSE : SI_P1_PAUSE))
         return;
 
-    int format = dac_nr ? ((dev->si_cr >> 2) & 3) : (dev->si_cr & 3);
-    int pos    = dev->dac[dac_nr].buffer_pos & 63;
-    int c;
+    int      format = dac_nr ? ((dev->si_cr >> 2) & 3) : (dev->si_cr & 3);
+    int      pos    = dev->dac[dac_nr].buffer_pos & 63;
+    int      c;
+    uint32_t frame;
 
     switch (format) {
         case FORMAT_MONO_8:
             for (c = 0; c < 32; c += 4) {
-                dev->dac[dac_nr].buffer_l[(pos + c) & 63] = dev->dac[dac_nr].buffer_r[(pos + c) & 63] = (mem_readb_phys(dev->dac[dac_nr].addr) ^ 0x80) << 8;
-                dev->dac[dac_nr].buffer_l[(pos + c + 1) & 63] = dev->dac[dac_nr].buffer_r[(pos + c + 1) & 63] = (mem_readb_phys(dev->dac[dac_nr].addr + 1) ^ 0x80) << 8;
-                dev->dac[dac_nr].buffer_l[(pos + c + 2) & 63] = dev->dac[dac_nr].buffer_r[(pos + c + 2) & 63] = (mem_readb_phys(dev->dac[dac_nr].addr + 2) ^ 0x80) << 8;
-                dev->dac[dac_nr].buffer_l[(pos + c + 3) & 63] = dev->dac[dac_nr].buffer_r[(pos + c + 3) & 63] = (mem_readb_phys(dev->dac[dac_nr].addr + 3) ^ 0x80) << 8;
+                frame = mem_readl_phys(dev->dac[dac_nr].addr);
+                dev->dac[dac_nr].buffer_l[(pos + c) & 63] = dev->dac[dac_nr].buffer_r[(pos + c) & 63] = ((frame & 0xff) ^ 0x80) << 8;
+                dev->dac[dac_nr].buffer_l[(pos + c + 1) & 63] = dev->dac[dac_nr].buffer_r[(pos + c + 1) & 63] = (((frame >> 8) & 0xff) ^ 0x80) << 8;
+                dev->dac[dac_nr].buffer_l[(pos + c + 2) & 63] = dev->dac[dac_nr].buffer_r[(pos + c + 2) & 63] = (((frame >> 16) & 0xff) ^ 0x80) << 8;
+                dev->dac[dac_nr].buffer_l[(pos + c + 3) & 63] = dev->dac[dac_nr].buffer_r[(pos + c + 3) & 63] = ((frame >> 24) ^ 0x80) << 8;
                 dev->dac[dac_nr].addr += 4;
 
                 dev->dac[dac_nr].buffer_pos_end += 4;
@@ -1908,10 +1923,11 @@ es1371_fetch(es1371_t *dev, int dac_nr)
 
         case FORMAT_STEREO_8:
             for (c = 0; c < 16; c += 2) {
-                dev->dac[dac_nr].buffer_l[(pos + c) & 63]     = (mem_readb_phys(dev->dac[dac_nr].addr) ^ 0x80) << 8;
-                dev->dac[dac_nr].buffer_r[(pos + c) & 63]     = (mem_readb_phys(dev->dac[dac_nr].addr + 1) ^ 0x80) << 8;
-                dev->dac[dac_nr].buffer_l[(pos + c + 1) & 63] = (mem_readb_phys(dev->dac[dac_nr].addr + 2) ^ 0x80) << 8;
-                dev->dac[dac_nr].buffer_r[(pos + c + 1) & 63] = (mem_readb_phys(dev->dac[dac_nr].addr + 3) ^ 0x80) << 8;
+                frame = mem_readl_phys(dev->dac[dac_nr].addr);
+                dev->dac[dac_nr].buffer_l[(pos + c) & 63]     = ((frame & 0xff) ^ 0x80) << 8;
+                dev->dac[dac_nr].buffer_r[(pos + c) & 63]     = (((frame >> 8) & 0xff) ^ 0x80) << 8;
+                dev->dac[dac_nr].buffer_l[(pos + c + 1) & 63] = (((frame >> 16) & 0xff) ^ 0x80) << 8;
+                dev->dac[dac_nr].buffer_r[(pos + c + 1) & 63] = ((frame >> 24) ^ 0x80) << 8;
                 dev->dac[dac_nr].addr += 4;
 
                 dev->dac[dac_nr].buffer_pos_end += 2;
@@ -1927,8 +1943,9 @@ es1371_fetch(es1371_t *dev, int dac_nr)
 
         case FORMAT_MONO_16:
             for (c = 0; c < 16; c += 2) {
-                dev->dac[dac_nr].buffer_l[(pos + c) & 63] = dev->dac[dac_nr].buffer_r[(pos + c) & 63] = mem_readw_phys(dev->dac[dac_nr].addr);
-                dev->dac[dac_nr].buffer_l[(pos + c + 1) & 63] = dev->dac[dac_nr].buffer_r[(pos + c + 1) & 63] = mem_readw_phys(dev->dac[dac_nr].addr + 2);
+                frame = mem_readl_phys(dev->dac[dac_nr].addr);
+                dev->dac[dac_nr].buffer_l[(pos + c) & 63] = dev->dac[dac_nr].buffer_r[(pos + c) & 63] = frame & 0xffff;
+                dev->dac[dac_nr].buffer_l[(pos + c + 1) & 63] = dev->dac[dac_nr].buffer_r[(pos + c + 1) & 63] = frame >> 16;
                 dev->dac[dac_nr].addr += 4;
 
                 dev->dac[dac_nr].buffer_pos_end += 2;
@@ -1944,8 +1961,9 @@ es1371_fetch(es1371_t *dev, int dac_nr)
 
         case FORMAT_STEREO_16:
             for (c = 0; c < 4; c++) {
-                dev->dac[dac_nr].buffer_l[(pos + c) & 63] = mem_readw_phys(dev->dac[dac_nr].addr);
-                dev->dac[dac_nr].buffer_r[(pos + c) & 63] = mem_readw_phys(dev->dac[dac_nr].addr + 2);
+                frame = mem_readl_phys(dev->dac[dac_nr].addr);
+                dev->dac[dac_nr].buffer_l[(pos + c) & 63] = frame & 0xffff;
+                dev->dac[dac_nr].buffer_r[(pos + c) & 63] = frame >> 16;
                 dev->dac[dac_nr].addr += 4;
 
                 dev->dac[dac_nr].buffer_pos_end++;
@@ -1964,36 +1982,77 @@ es1371_fetch(es1371_t *dev, int dac_nr)
     }
 }
 
-static inline float
-low_fir_es1371(int dac_nr, int i, float NewSample)
+/* Only one input sample in 16 is non-zero once upsampled, so every output
+   phase is a short dot product over the last 128 / 16 input samples; the 16
+   phases are computed side by side. Each phase keeps the order of its sums
+   and the multiplies and adds stay separate, so the result does not depend
+   on the path taken. */
+static void
+low_fir_es1371(const float *x, int pos, int *out)
 {
-    static float x[2][2][128]; // input samples
-    static int   x_pos[2] = { 0, 0 };
-    float        out      = 0.0;
-    int          read_pos;
-    int          n_coef;
-    int          pos = x_pos[dac_nr];
-
-    x[dac_nr][i][pos] = NewSample;
-
-    /* Since only 1/16th of input samples are non-zero, only filter those that
-       are valid.*/
-    read_pos = (pos + 15) & (127 & ~15);
-    n_coef   = (16 - pos) & 15;
-
-    while (n_coef < ES1371_NCoef) {
-        out += low_fir_es1371_coef[n_coef] * x[dac_nr][i][read_pos];
-        read_pos = (read_pos + 16) & (127 & ~15);
-        n_coef += 16;
+    float w0[ES1371_NTaps];
+    float w1[ES1371_NTaps];
+
+    /* Phase 0 starts at the new sample, the others one sample further. */
+    for (int k = 0; k < ES1371_NTaps; k++) {
+        w0[k] = x[(pos + k) & ((128 / N) - 1)];
+        w1[k] = x[(pos + 1 + k) & ((128 / N) - 1)];
+    }
+
+#if defined(AUDIOPCI_SSE2)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    __m128 acc2 = _mm_setzero_ps();
+    __m128 acc3 = _mm_setzero_ps();
+
+    for (int k = 0; k < ES1371_NTaps; k++) {
+        const __m128 v  = _mm_set1_ps(w1[k]);
+        const __m128 v0 = _mm_move_ss(v, _mm_set_ss(w0[k]));
+
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(&low_fir_es1371_taps[k][0]), v0));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(&low_fir_es1371_taps[k][4]), v));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(&low_fir_es1371_taps[k][8]), v));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(&low_fir_es1371_taps[k][12]), v));
     }
 
-    if (i == 1) {
-        x_pos[dac_nr] = (x_pos[dac_nr] + 1) & 127;
-        if (x_pos[dac_nr] > 127)
-            x_pos[dac_nr] = 0;
+    _mm_storeu_si128((__m128i *) &out[0], _mm_cvttps_epi32(acc0));
+    _mm_storeu_si128((__m128i *) &out[4], _mm_cvttps_epi32(acc1));
+    _mm_storeu_si128((__m128i *) &out[8], _mm_cvttps_epi32(acc2));
+    _mm_storeu_si128((__m128i *) &out[12], _mm_cvttps_epi32(acc3));
+#elif defined(AUDIOPCI_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    float32x4_t acc2 = vdupq_n_f32(0.0f);
+    float32x4_t acc3 = vdupq_n_f32(0.0f);
+
+    for (int k = 0; k < ES1371_NTaps; k++) {
+        const float32x4_t v  = vdupq_n_f32(w1[k]);
+        const float32x4_t v0 = vsetq_lane_f32(w0[k], v, 0);
+
+        acc0 = vaddq_f32(acc0, vmulq_f32(vld1q_f32(&low_fir_es1371_taps[k][0]), v0));
+        acc1 = vaddq_f32(acc1, vmulq_f32(vld1q_f32(&low_fir_es1371_taps[k][4]), v));
+        acc2 = vaddq_f32(acc2, vmulq_f32(vld1q_f32(&low_fir_es1371_taps[k][8]), v));
+        acc3 = vaddq_f32(acc3, vmulq_f32(vld1q_f32(&low_fir_es1371_taps[k][12]), v));
     }
 
-    return out;
+    vst1q_s32(&out[0], vcvtq_s32_f32(acc0));
+    vst1q_s32(&out[4], vcvtq_s32_f32(acc1));
+    vst1q_s32(&out[8], vcvtq_s32_f32(acc2));
+    vst1q_s32(&out[12], vcvtq_s32_f32(acc3));
+#else
+    for (int p = 0; p < N; p++) {
+        const float *w   = p ? w1 : w0;
+        float        acc = 0.0f;
+
+        for (int k = 0; k < ES1371_NTaps; k++) {
+            const float prod = low_fir_es1371_taps[k][p] * w[k];
+
+            acc += prod;
+        }
+
+        out[p] = (int) acc;
+    }
+#endif
 }
 
 static void
@@ -2001,6 +2060,7 @@ es1371_next_sample_filtered(es1371_t *dev, int dac_nr, int out_idx)
 {
     int out_l;
     int out_r;
+    int pos;
 
     if ((dev->dac[dac_nr].buffer_pos - dev->dac[dac_nr].buffer_pos_end) >= 0)
         es1371_fetch(dev, dac_nr);
@@ -2008,13 +2068,14 @@ es1371_next_sample_filtered(es1371_t *dev, int dac_nr, int out_idx)
     out_l = dev->dac[dac_nr].buffer_l[dev->dac[dac_nr].buffer_pos & 63];
     out_r = dev->dac[dac_nr].buffer_r[dev->dac[dac_nr].buffer_pos & 63];
 
-    dev->dac[dac_nr].filtered_l[out_idx] = (int) low_fir_es1371(dac_nr, 0, (float) out_l);
-    dev->dac[dac_nr].filtered_r[out_idx] = (int) low_fir_es1371(dac_nr, 1, (float) out_r);
+    pos                            = dev->dac[dac_nr].fir_pos;
+    dev->dac[dac_nr].fir_x[0][pos] = (float) out_l;
+    dev->dac[dac_nr].fir_x[1][pos] = (float) out_r;
 
-    for (uint8_t c = 1; c < 16; c++) {
-        dev->dac[dac_nr].filtered_l[out_idx + c] = (int) low_fir_es1371(dac_nr, 0, 0);
-        dev->dac[dac_nr].filtered_r[out_idx + c] = (int) low_fir_es1371(dac_nr, 1, 0);
-    }
+    low_fir_es1371(dev->dac[dac_nr].fir_x[0], pos, &dev->dac[dac_nr].filtered_l[out_idx]);
+    low_fir_es1371(dev->dac[dac_nr].fir_x[1], pos, &dev->dac[dac_nr].filtered_r[out_idx]);
+
+    dev->dac[dac_nr].fir_pos = (pos + 1) & ((128 / N) - 1);
 
     dev->dac[dac_nr].buffer_pos++;
 }
@@ -2045,6 +2106,7 @@ es1371_update(es1371_t *dev)
     else if (r > 32767)
         r = 32767;
 
+    sound_pos_sync();
     for (; dev->pos < sound_pos_global; dev->pos++) {
         dev->buffer[dev->pos * 2]     = l;
         dev->buffer[dev->pos * 2 + 1] = r;
@@ -2205,6 +2267,14 @@ generate_es1371_filter(void)
     /* Normalise filter, to produce unity gain */
     for (n = 0; n < ES1371_NCoef; n++)
         low_fir_es1371_coef[n] /= gain;
+
+    /* Phase 0 takes coefficients 0, 16, 32 and so on, phase p 16 - p onwards. */
+    for (int p = 0; p < N; p++) {
+        for (int k = 0; k < ES1371_NTaps; k++) {
+            n                         = (p ? (N - p) : 0) + (k * N);
+            low_fir_es1371_taps[k][p] = (n < ES1371_NCoef) ? low_fir_es1371_coef[n] : 0.0f;
+        }
+    }
 }
 
 static void
@@ -55,6 +55,10 @@ enum {
     TRAP_MAX
 };
 
+/* Playback DMA fills the whole FIFO per run, so it only runs once per this
+   many dword periods; the 256-byte FIFO covers several times that. */
+#define CMI8X38_DMA_BURST 8
+
 typedef struct cmi8x38_dma_t {
     uint8_t           id;
     uint8_t           reg;
@@ -1031,6 +1035,7 @@ cmi8x38_update(cmi8x38_t *dev, cmi8x38_dma_t *dma)
     int32_t                  l     = (dma->out_fl * mixer->voice_l) * mixer->master_l;
     int32_t                  r     = (dma->out_fr * mixer->voice_r) * mixer->master_r;
 
+    sound_pos_sync();
     for (; dma->pos < sound_pos_global; dma->pos++) {
         dma->buffer[dma->pos * 2]     = l;
         dma->buffer[dma->pos * 2 + 1] = r;
@@ -1050,12 +1055,17 @@ cmi8x38_dma_process(void *priv)
         return;
     }
 
+    /* Playback with the FIFO enabled moves as much as fits in one go. */
+    uint8_t dma_status = dev->io_regs[0x00] >> dma->id;
+    int     bulk       = !dma->always_run && !(dma_status & 0x01);
+    uint8_t data[sizeof(dma->fifo)];
+    int     n;
+
     /* Schedule next run. */
-    timer_on_auto(&dma->dma_timer, dma->dma_latch);
+    timer_on_auto(&dma->dma_timer, bulk ? (dma->dma_latch * CMI8X38_DMA_BURST) : dma->dma_latch);
 
-    /* Process DMA if it's active, and the FIFO has room or is disabled. */
-    uint8_t dma_status = dev->io_regs[0x00] >> dma->id;
-    if (!(dma_status & 0x04) && (dma->always_run || ((dma->fifo_end - dma->fifo_pos) <= (sizeof(dma->fifo) - 4)))) {
+    /* Process DMA while it's active, and the FIFO has room or is disabled. */
+    while (!(dma_status & 0x04) && (dma->always_run || ((dma->fifo_end - dma->fifo_pos) <= (sizeof(dma->fifo) - 4)))) {
         /* Start DMA if requested. */
         if (dma->restart) {
             /* Set up base address and counters.
@@ -1071,12 +1081,31 @@ cmi8x38_dma_process(void *priv)
         if (dma_status & 0x01) {
             /* Write channel: read data from FIFO. */
             mem_writel_phys(dma->sample_ptr, *((uint32_t *) &dma->fifo[dma->fifo_end & (sizeof(dma->fifo) - 1)]));
-        } else {
+            n = 1;
+        } else if (!bulk) {
             /* Read channel: write data to FIFO. */
             *((uint32_t *) &dma->fifo[dma->fifo_end & (sizeof(dma->fifo) - 1)]) = mem_readl_phys(dma->sample_ptr);
+            n = 1;
+        } else {
+            /* Read channel: fill the FIFO, stopping at the fragment or buffer end. */
+            n = (sizeof(dma->fifo) - (dma->fifo_end - dma->fifo_pos)) >> 2;
+            if (n > dma->frame_count_fragment)
+                n = dma->frame_count_fragment;
+            if (n > dma->frame_count_dma)
+                n = dma->frame_count_dma;
+            if (n < 1)
+                n = 1;
+
+            dma_bm_read(dma->sample_ptr, data, n << 2, 4);
+            for (int i = 0; i < n; i++)
+                memcpy(&dma->fifo[(dma->fifo_end + (i << 2)) & (sizeof(dma->fifo) - 1)], &data[i << 2], 4);
         }
-        dma->fifo_end += 4;
-        dma->sample_ptr += 4;
+        dma->fifo_end += n << 2;
+        dma->sample_ptr += n << 2;
+
+        /* The last dword of the run is counted below. */
+        dma->frame_count_fragment -= n - 1;
+        dma->frame_count_dma -= n - 1;
 
         /* Check if the fragment size was reached. */
         if (--dma->frame_count_fragment <= 0) {
@@ -1113,6 +1142,10 @@ cmi8x38_dma_process(void *priv)
             /* Restart DMA on the next run. */
             dma->restart = 1;
         }
+
+        if (!bulk)
+            break;
+        dma_status = dev->io_regs[0x00] >> dma->id;
     }
 }
 
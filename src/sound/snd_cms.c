@@ -15,6 +15,7 @@
 void
 cms_update(cms_t *cms)
 {
+    sound_pos_sync();
     for (; cms->pos < sound_pos_global; cms->pos++) {
         int16_t out_l = 0;
         int16_t out_r = 0;
@@ -7,6 +7,13 @@
 #include <wchar.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    define EMU8K_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define EMU8K_NEON
+#endif
 #define HAVE_STDARG_H
 
 #include <86box/86box.h>
@@ -1750,360 +1757,569 @@ emu8k_vol_slide(emu8k_slide_t *slide, int32_t target)
     return slide->last;
 }
 
-#if 0
-int32_t old_pitch[32] = { 0 };
-int32_t old_cut[32]   = { 0 };
-int32_t old_vol[32]   = { 0 };
-#endif
-void
-emu8k_update(emu8k_t *emu8k)
+/* Oscillator state captured per sample by the control pass of emu8k_update(),
+   for the render pass to work from. */
+static uint32_t voice_addr[WTBUFLEN];
+static uint16_t voice_fract[WTBUFLEN];
+static int32_t  voice_vol[WTBUFLEN];
+static uint16_t voice_cut[WTBUFLEN];
+static int32_t  voice_dat[WTBUFLEN];
+
+/* Lowest attenuation for which the volume target is zero. */
+static int32_t env_vol_silent_att = 0x1FFFFF;
+
+/* Pitch, filter and volume targets from the envelopes and LFOs, with the
+   volume envelope already applied to attenuation. */
+static inline void
+emu8k_voice_targets(emu8k_voice_t *emu_voice, int32_t attenuation)
 {
-    if (emu8k->pos >= wavetable_pos_global)
-        return;
+    int32_t filtercut    = emu_voice->initial_filter;
+    int32_t currentpitch = emu_voice->ip;
 
-    int32_t       *buf;
-    emu8k_voice_t *emu_voice;
-    int            pos;
+    if (emu_voice->fixed_modenv_pitch_height) {
+        /* modenv range 1<<21, pitch height range 1<<14 desired range 0x1000 (+/-one octave) */
+        currentpitch += ((emu_voice->mod_envelope.value_db_oct >> 9) * emu_voice->fixed_modenv_pitch_height) >> 14;
+    }
 
-    /* Clean the buffers since we will accumulate into them. */
-    buf = &emu8k->buffer[emu8k->pos * 2];
-    memset(buf, 0, 2 * (wavetable_pos_global - emu8k->pos) * sizeof(emu8k->buffer[0]));
-    memset(&emu8k->chorus_in_buffer[emu8k->pos], 0, (wavetable_pos_global - emu8k->pos) * sizeof(emu8k->chorus_in_buffer[0]));
-    memset(&emu8k->reverb_in_buffer[emu8k->pos], 0, (wavetable_pos_global - emu8k->pos) * sizeof(emu8k->reverb_in_buffer[0]));
+    if (emu_voice->fixed_lfo1_vibrato) {
+        /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
+        int32_t lfo1_vibrato = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_vibrato) >> 17;
+        currentpitch += lfo1_vibrato;
+    }
+    if (emu_voice->fixed_lfo2_vibrato) {
+        /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
+        int32_t lfo2_vibrato = (lfotable[emu_voice->lfo2_count.int_address] * emu_voice->fixed_lfo2_vibrato) >> 17;
+        currentpitch += lfo2_vibrato;
+    }
 
-    /* Voices section  */
-    for (uint8_t c = 0; c < 32; c++) {
-        emu_voice = &emu8k->voice[c];
-        buf       = &emu8k->buffer[emu8k->pos * 2];
+    if (emu_voice->fixed_modenv_filter_height) {
+        /* modenv range 1<<21, pitch height range 1<<14 desired range 0x200000 (+/-full filter range) */
+        filtercut += ((emu_voice->mod_envelope.value_db_oct >> 9) * emu_voice->fixed_modenv_filter_height) >> 5;
+    }
 
-        for (pos = emu8k->pos; pos < wavetable_pos_global; pos++) {
-            int32_t dat;
+    if (emu_voice->fixed_lfo1_filt_mod) {
+        /* table range 1<<15, pitch mod range 1<<14 desired range 0x100000 (+/-three octaves) */
+        int32_t lfo1_filtmod = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_filt_mod) >> 9;
+        filtercut += lfo1_filtmod;
+    }
 
-            if (emu_voice->cvcf_curr_volume) {
-                /* Waveform oscillator */
-#ifdef RESAMPLER_LINEAR
-                dat = EMU8K_READ_INTERP_LINEAR(emu8k, emu_voice->addr.int_address,
-                                               emu_voice->addr.fract_address);
+    if (emu_voice->fixed_lfo1_tremolo) {
+        /* table range 1<<15, pitch mod range 1<<14 desired range 0x40000 (+/-12dBs). */
+        int32_t lfo1_tremolo = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_tremolo) >> 11;
+        attenuation += lfo1_tremolo;
+    }
 
-#elif defined RESAMPLER_CUBIC
-                dat = EMU8K_READ_INTERP_CUBIC(emu8k, emu_voice->addr.int_address,
-                                              emu_voice->addr.fract_address);
-#endif
+    if (currentpitch > 0xFFFF)
+        currentpitch = 0xFFFF;
+    if (currentpitch < 0)
+        currentpitch = 0;
+    if (attenuation > 0x1FFFFF)
+        attenuation = 0x1FFFFF;
+    if (attenuation < 0)
+        attenuation = 0;
+    if (filtercut > 0x1FFFFF)
+        filtercut = 0x1FFFFF;
+    if (filtercut < 0)
+        filtercut = 0;
+
+    emu_voice->vtft_vol_target    = env_vol_db_to_vol_target[attenuation >> 5];
+    emu_voice->vtft_filter_target = filtercut >> 5;
+    emu_voice->ptrx_pit_target    = freqtable[currentpitch] >> 18;
+}
 
-                /* Filter section */
-                if (emu_voice->filterq_idx || emu_voice->cvcf_curr_filt_ctoff != 0xFFFF) {
-                    int           cutoff = emu_voice->cvcf_curr_filt_ctoff >> 8;
-                    const int64_t coef0  = filt_coeffs[emu_voice->filterq_idx][cutoff][0];
-                    const int64_t coef1  = filt_coeffs[emu_voice->filterq_idx][cutoff][1];
-                    const int64_t coef2  = filt_coeffs[emu_voice->filterq_idx][cutoff][2];
-/* clip at twice the range */
-#define ClipBuffer(buf) (buf < -16777216) ? -16777216 : (buf > 16777216) ? 16777216 \
-                                                                         : buf
+/* Per sample envelope and LFO step, setting the voice targets. */
+static inline void
+emu8k_voice_envelopes(emu8k_voice_t *emu_voice)
+{
+    int32_t attenuation = emu_voice->initial_att;
+
+    /* run envelopes */
+    emu8k_envelope_t *volenv = &emu_voice->vol_envelope;
+    switch (volenv->state) {
+        case ENV_DELAY:
+            volenv->delay_samples--;
+            if (volenv->delay_samples <= 0) {
+                volenv->state         = ENV_ATTACK;
+                volenv->delay_samples = 0;
+            }
+            attenuation = 0x1FFFFF;
+            break;
 
-#ifdef FILTER_INITIAL
-#    define NOOP(x) (void) x;
-                    NOOP(coef1)
-                    /* Apply expected attenuation. (FILTER_MOOG does it implicitly, but this one doesn't).
-                     * Work in 24bits. */
-                    dat = (dat * emu_voice->filt_att) >> 8;
-
-                    int64_t vhp = ((-emu_voice->filt_buffer[0] * coef2) >> 24) - emu_voice->filt_buffer[1] - dat;
-                    emu_voice->filt_buffer[1] += (emu_voice->filt_buffer[0] * coef0) >> 24;
-                    emu_voice->filt_buffer[0] += (vhp * coef0) >> 24;
-                    dat = (int32_t) (emu_voice->filt_buffer[1] >> 8);
-                    if (dat > 32767) {
-                        dat = 32767;
-                    } else if (dat < -32768) {
-                        dat = -32768;
-                    }
+        case ENV_ATTACK:
+            /* Attack amount is in linear amplitude */
+            volenv->value_amp_hz += volenv->attack_amount_amp_hz;
+            if (volenv->value_amp_hz >= (1 << 21)) {
+                volenv->value_amp_hz = 1 << 21;
+                volenv->value_db_oct = 0;
+                if (volenv->hold_samples) {
+                    volenv->state = ENV_HOLD;
+                } else {
+                    /* RAMP_UP since db value is inverted and it is 0 at this point. */
+                    volenv->state = ENV_RAMP_UP;
+                }
+            }
+            attenuation += env_vol_amplitude_to_db[volenv->value_amp_hz >> 5] << 5;
+            break;
 
-#elif defined FILTER_MOOG
+        case ENV_HOLD:
+            volenv->hold_samples--;
+            if (volenv->hold_samples <= 0) {
+                volenv->state = ENV_RAMP_UP;
+            }
+            attenuation += volenv->value_db_oct;
+            break;
 
-                    /*move to 24bits*/
-                    dat <<= 8;
+        case ENV_RAMP_DOWN:
+            /* Decay/release amount is in fraction of dBs and is always positive */
+            volenv->value_db_oct -= volenv->ramp_amount_db_oct;
+            if (volenv->value_db_oct <= volenv->sustain_value_db_oct) {
+                volenv->value_db_oct = volenv->sustain_value_db_oct;
+                volenv->state        = ENV_SUSTAIN;
+            }
+            attenuation += volenv->value_db_oct;
+            break;
 
-                    dat -= (coef2 * emu_voice->filt_buffer[4]) >> 24; /*feedback*/
-                    int64_t t1 = emu_voice->filt_buffer[1];
-                    emu_voice->filt_buffer[1] = ((dat + emu_voice->filt_buffer[0]) * coef0 - emu_voice->filt_buffer[1] * coef1) >> 24;
-                    emu_voice->filt_buffer[1] = ClipBuffer(emu_voice->filt_buffer[1]);
+        case ENV_RAMP_UP:
+            /* Decay/release amount is in fraction of dBs and is always positive */
+            volenv->value_db_oct += volenv->ramp_amount_db_oct;
+            if (volenv->value_db_oct >= volenv->sustain_value_db_oct) {
+                volenv->value_db_oct = volenv->sustain_value_db_oct;
+                volenv->state        = ENV_SUSTAIN;
+            }
+            attenuation += volenv->value_db_oct;
+            break;
 
-                    int64_t t2 = emu_voice->filt_buffer[2];
-                    emu_voice->filt_buffer[2] = ((emu_voice->filt_buffer[1] + t1) * coef0 - emu_voice->filt_buffer[2] * coef1) >> 24;
-                    emu_voice->filt_buffer[2] = ClipBuffer(emu_voice->filt_buffer[2]);
+        case ENV_SUSTAIN:
+            attenuation += volenv->value_db_oct;
+            break;
 
-                    int64_t t3 = emu_voice->filt_buffer[3];
-                    emu_voice->filt_buffer[3] = ((emu_voice->filt_buffer[2] + t2) * coef0 - emu_voice->filt_buffer[3] * coef1) >> 24;
-                    emu_voice->filt_buffer[3] = ClipBuffer(emu_voice->filt_buffer[3]);
+        case ENV_STOPPED:
+            attenuation = 0x1FFFFF;
+            break;
 
-                    emu_voice->filt_buffer[4] = ((emu_voice->filt_buffer[3] + t3) * coef0 - emu_voice->filt_buffer[4] * coef1) >> 24;
-                    emu_voice->filt_buffer[4] = ClipBuffer(emu_voice->filt_buffer[4]);
+        default:
+            break;
+    }
 
-                    emu_voice->filt_buffer[0] = ClipBuffer(dat);
+    emu8k_envelope_t *modenv = &emu_voice->mod_envelope;
+    switch (modenv->state) {
+        case ENV_DELAY:
+            modenv->delay_samples--;
+            if (modenv->delay_samples <= 0) {
+                modenv->state         = ENV_ATTACK;
+                modenv->delay_samples = 0;
+            }
+            break;
 
-                    dat = (int32_t) (emu_voice->filt_buffer[4] >> 8);
-                    if (dat > 32767) {
-                        dat = 32767;
-                    } else if (dat < -32768) {
-                        dat = -32768;
-                    }
+        case ENV_ATTACK:
+            /* Attack amount is in linear amplitude */
+            modenv->value_amp_hz += modenv->attack_amount_amp_hz;
+            modenv->value_db_oct = env_mod_hertz_to_octave[modenv->value_amp_hz >> 5] << 5;
+            if (modenv->value_amp_hz >= (1 << 21)) {
+                modenv->value_amp_hz = 1 << 21;
+                modenv->value_db_oct = 1 << 21;
+                if (modenv->hold_samples) {
+                    modenv->state = ENV_HOLD;
+                } else {
+                    modenv->state = ENV_RAMP_DOWN;
+                }
+            }
+            break;
 
-#elif defined FILTER_CONSTANT
+        case ENV_HOLD:
+            modenv->hold_samples--;
+            if (modenv->hold_samples <= 0) {
+                modenv->state = ENV_RAMP_UP;
+            }
+            break;
 
-                    /* Apply expected attenuation. (FILTER_MOOG does it implicitly, but this one is constant gain).
-                     * Also stay at 24bits.*/
-                    dat = (dat * emu_voice->filt_att) >> 8;
-
-                    emu_voice->filt_buffer[0] = (coef1 * emu_voice->filt_buffer[0]
-                                                 + coef0 * (dat + ((coef2 * (emu_voice->filt_buffer[0] - emu_voice->filt_buffer[1])) >> 24)))
-                        >> 24;
-                    emu_voice->filt_buffer[1] = (coef1 * emu_voice->filt_buffer[1]
-                                                 + coef0 * emu_voice->filt_buffer[0])
-                        >> 24;
-
-                    emu_voice->filt_buffer[0] = ClipBuffer(emu_voice->filt_buffer[0]);
-                    emu_voice->filt_buffer[1] = ClipBuffer(emu_voice->filt_buffer[1]);
-
-                    dat = (int32_t) (emu_voice->filt_buffer[1] >> 8);
-                    if (dat > 32767) {
-                        dat = 32767;
-                    } else if (dat < -32768) {
-                        dat = -32768;
-                    }
+        case ENV_RAMP_DOWN:
+            /* Decay/release amount is in fraction of octave and is always positive */
+            modenv->value_db_oct -= modenv->ramp_amount_db_oct;
+            if (modenv->value_db_oct <= modenv->sustain_value_db_oct) {
+                modenv->value_db_oct = modenv->sustain_value_db_oct;
+                modenv->state        = ENV_SUSTAIN;
+            }
+            break;
+
+        case ENV_RAMP_UP:
+            /* Decay/release amount is in fraction of octave and is always positive */
+            modenv->value_db_oct += modenv->ramp_amount_db_oct;
+            if (modenv->value_db_oct >= modenv->sustain_value_db_oct) {
+                modenv->value_db_oct = modenv->sustain_value_db_oct;
+                modenv->state        = ENV_SUSTAIN;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    /* run lfos */
+    if (emu_voice->lfo1_delay_samples) {
+        emu_voice->lfo1_delay_samples--;
+    } else {
+        emu_voice->lfo1_count.addr += emu_voice->lfo1_speed;
+        emu_voice->lfo1_count.int_address &= 0xFFFF;
+    }
+    if (emu_voice->lfo2_delay_samples) {
+        emu_voice->lfo2_delay_samples--;
+    } else {
+        emu_voice->lfo2_count.addr += emu_voice->lfo2_speed;
+        emu_voice->lfo2_count.int_address &= 0xFFFF;
+    }
+
+    emu8k_voice_targets(emu_voice, attenuation);
+}
+
+static inline void
+emu8k_voice_advance(emu8k_voice_t *emu_voice)
+{
+    /*
+    I've recopilated these sentences to get an idea of how to loop
+
+    - Set its PSST register and its CLS register to zero to cause no loops to occur.
+    -Setting the Loop Start Offset and the Loop End Offset to the same value, will cause the oscillator to loop the entire memory.
+
+    -Setting the PlayPosition greater than the Loop End Offset, will cause the oscillator to play in reverse, back to the Loop End Offset.
+       It's pretty neat, but appears to be uncontrollable (the rate at which the samples are played in reverse).
+
+    -Note that due to interpolator offset, the actual loop point is one greater than the start address
+    -Note that due to interpolator offset, the actual loop point will end at an address one greater than the loop address
+    -Note that the actual audio location is the point 1 word higher than this value due to interpolation offset
+    -In programs that use the awe, they generally set the loop address as "loopaddress -1" to compensate for the above.
+    (Note: I am already using address+1 in the interpolators so these things are already as they should.)
+    */
+    emu_voice->addr.addr += ((uint64_t) emu_voice->cpf_curr_pitch) << 18;
+    if (emu_voice->addr.addr >= emu_voice->loop_end.addr) {
+        emu_voice->addr.int_address -= (emu_voice->loop_end.int_address - emu_voice->loop_start.int_address);
+        emu_voice->addr.int_address &= EMU8K_MEM_ADDRESS_MASK;
+    }
+
+    /* TODO: How and when are the target and current values updated */
+    emu_voice->cpf_curr_pitch       = emu_voice->ptrx_pit_target;
+    emu_voice->cvcf_curr_volume     = emu8k_vol_slide(&emu_voice->volumeslide, emu_voice->vtft_vol_target);
+    emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
+}
+
+/* A voice that is silent now and can not become audible before the end of
+   the block: nothing is rendered, so only its position, LFOs and current
+   values have to move on. */
+static int
+emu8k_voice_silent(const emu8k_voice_t *emu_voice)
+{
+    int32_t attenuation;
+
+    if (emu_voice->cvcf_curr_volume || emu_voice->volumeslide.last)
+        return 0;
+
+    if (!emu_voice->env_engine_on)
+        return !emu_voice->vtft_vol_target;
+
+    /* The pitch has to stay put for the position to be stepped blindly. */
+    if (emu_voice->fixed_lfo1_vibrato || emu_voice->fixed_lfo2_vibrato)
+        return 0;
+    if ((emu_voice->mod_envelope.state != ENV_SUSTAIN) && (emu_voice->mod_envelope.state != ENV_STOPPED))
+        return 0;
+
+    if (emu_voice->vol_envelope.state == ENV_SUSTAIN)
+        attenuation = emu_voice->initial_att + emu_voice->vol_envelope.value_db_oct;
+    else if (emu_voice->vol_envelope.state == ENV_STOPPED)
+        attenuation = 0x1FFFFF;
+    else
+        return 0;
+
+    if (emu_voice->fixed_lfo1_tremolo)
+        attenuation -= ((32768 * abs(emu_voice->fixed_lfo1_tremolo)) >> 11) + 1;
+
+    return attenuation >= env_vol_silent_att;
+}
+
+static inline void
+emu8k_lfo_skip(emu8k_mem_internal_t *count, int32_t *delay_samples, int64_t speed, int samples)
+{
+    int delay = 0;
+
+    if (*delay_samples < 0)
+        delay = samples;
+    else if (*delay_samples > 0)
+        delay = MIN(samples, *delay_samples);
+    *delay_samples -= delay;
+
+    /* The integer part is kept to 16 bits, so the phase is modulo 2^48. */
+    count->addr += (uint64_t) (samples - delay) * (uint64_t) speed;
+    count->int_address &= 0xFFFF;
+}
+
+static void
+emu8k_voice_skip(emu8k_voice_t *emu_voice, int samples)
+{
+    if (emu_voice->env_engine_on) {
+        emu8k_lfo_skip(&emu_voice->lfo1_count, &emu_voice->lfo1_delay_samples, emu_voice->lfo1_speed, samples);
+        emu8k_lfo_skip(&emu_voice->lfo2_count, &emu_voice->lfo2_delay_samples, emu_voice->lfo2_speed, samples);
+
+        if (emu_voice->vol_envelope.state == ENV_SUSTAIN)
+            emu8k_voice_targets(emu_voice, emu_voice->initial_att + emu_voice->vol_envelope.value_db_oct);
+        else
+            emu8k_voice_targets(emu_voice, 0x1FFFFF);
+    }
+
+    for (int i = 0; i < samples; i++) {
+        emu_voice->addr.addr += ((uint64_t) emu_voice->cpf_curr_pitch) << 18;
+        if (emu_voice->addr.addr >= emu_voice->loop_end.addr) {
+            emu_voice->addr.int_address -= (emu_voice->loop_end.int_address - emu_voice->loop_start.int_address);
+            emu_voice->addr.int_address &= EMU8K_MEM_ADDRESS_MASK;
+        }
+        emu_voice->cpf_curr_pitch = emu_voice->ptrx_pit_target;
+    }
+
+    emu_voice->cvcf_curr_volume     = emu8k_vol_slide(&emu_voice->volumeslide, emu_voice->vtft_vol_target);
+    emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
+}
 
+#if defined(EMU8K_SSE2) || defined(EMU8K_NEON)
+/* The four words under the interpolator, read in one go unless they straddle
+   a 64K block. */
+static inline void
+emu8k_read_taps(emu8k_t *emu8k, uint32_t int_addr, int16_t *taps)
+{
+    if ((int_addr & 0xffff) <= 0xfffc)
+        memcpy(taps, &emu8k->ram_pointers[(int_addr >> 16) & 0xff][int_addr & 0xffff], 4 * sizeof(int16_t));
+    else {
+        taps[0] = EMU8K_READ(emu8k, int_addr);
+        taps[1] = EMU8K_READ(emu8k, int_addr + 1);
+        taps[2] = EMU8K_READ(emu8k, int_addr + 2);
+        taps[3] = EMU8K_READ(emu8k, int_addr + 3);
+    }
+}
 #endif
-                }
-                if ((emu8k->hwcf3 & 0x04) && !CCCA_DMA_ACTIVE(emu_voice->ccca)) {
-                    /*volume and pan*/
-                    dat = (dat * emu_voice->cvcf_curr_volume) >> 16;
 
-                    (*buf++) += (dat * emu_voice->vol_l) >> 8;
-                    (*buf++) += (dat * emu_voice->vol_r) >> 8;
+#ifdef EMU8K_SSE2
+static inline __m128
+emu8k_interp_products(emu8k_t *emu8k, int i)
+{
+    int16_t taps[4];
+    __m128i dat;
 
-                    /* Effects section */
-                    if (emu_voice->ptrx_revb_send > 0) {
-                        emu8k->reverb_in_buffer[pos] += (dat * emu_voice->ptrx_revb_send) >> 8;
-                    }
-                    if (emu_voice->csl_chor_send > 0) {
-                        emu8k->chorus_in_buffer[pos] += (dat * emu_voice->csl_chor_send) >> 8;
-                    }
-                }
-            }
+    emu8k_read_taps(emu8k, voice_addr[i], taps);
+    dat = _mm_loadl_epi64((const __m128i *) taps);
+    dat = _mm_srai_epi32(_mm_unpacklo_epi16(dat, dat), 16);
 
-            if (emu_voice->env_engine_on) {
-                int32_t attenuation  = emu_voice->initial_att;
-                int32_t filtercut    = emu_voice->initial_filter;
-                int32_t currentpitch = emu_voice->ip;
-                /* run envelopes */
-                emu8k_envelope_t *volenv = &emu_voice->vol_envelope;
-                switch (volenv->state) {
-                    case ENV_DELAY:
-                        volenv->delay_samples--;
-                        if (volenv->delay_samples <= 0) {
-                            volenv->state         = ENV_ATTACK;
-                            volenv->delay_samples = 0;
-                        }
-                        attenuation = 0x1FFFFF;
-                        break;
+    return _mm_mul_ps(_mm_cvtepi32_ps(dat), _mm_loadu_ps(&cubic_table[(voice_fract[i] >> (16 - CUBIC_RESOLUTION_LOG)) << 2]));
+}
+#elif defined(EMU8K_NEON)
+static inline float32x4_t
+emu8k_interp_products(emu8k_t *emu8k, int i)
+{
+    int16_t taps[4];
 
-                    case ENV_ATTACK:
-                        /* Attack amount is in linear amplitude */
-                        volenv->value_amp_hz += volenv->attack_amount_amp_hz;
-                        if (volenv->value_amp_hz >= (1 << 21)) {
-                            volenv->value_amp_hz = 1 << 21;
-                            volenv->value_db_oct = 0;
-                            if (volenv->hold_samples) {
-                                volenv->state = ENV_HOLD;
-                            } else {
-                                /* RAMP_UP since db value is inverted and it is 0 at this point. */
-                                volenv->state = ENV_RAMP_UP;
-                            }
-                        }
-                        attenuation += env_vol_amplitude_to_db[volenv->value_amp_hz >> 5] << 5;
-                        break;
+    emu8k_read_taps(emu8k, voice_addr[i], taps);
 
-                    case ENV_HOLD:
-                        volenv->hold_samples--;
-                        if (volenv->hold_samples <= 0) {
-                            volenv->state = ENV_RAMP_UP;
-                        }
-                        attenuation += volenv->value_db_oct;
-                        break;
+    return vmulq_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(taps))), vld1q_f32(&cubic_table[(voice_fract[i] >> (16 - CUBIC_RESOLUTION_LOG)) << 2]));
+}
+#endif
 
-                    case ENV_RAMP_DOWN:
-                        /* Decay/release amount is in fraction of dBs and is always positive */
-                        volenv->value_db_oct -= volenv->ramp_amount_db_oct;
-                        if (volenv->value_db_oct <= volenv->sustain_value_db_oct) {
-                            volenv->value_db_oct = volenv->sustain_value_db_oct;
-                            volenv->state        = ENV_SUSTAIN;
-                        }
-                        attenuation += volenv->value_db_oct;
-                        break;
+/* Cubic interpolation of the captured positions, four samples at a time:
+   the tap products of each sample are transposed into lanes and summed in
+   the same order as EMU8K_READ_INTERP_CUBIC(), so the result is identical. */
+static void
+emu8k_voice_interp(emu8k_t *emu8k, int samples)
+{
+    int i = 0;
 
-                    case ENV_RAMP_UP:
-                        /* Decay/release amount is in fraction of dBs and is always positive */
-                        volenv->value_db_oct += volenv->ramp_amount_db_oct;
-                        if (volenv->value_db_oct >= volenv->sustain_value_db_oct) {
-                            volenv->value_db_oct = volenv->sustain_value_db_oct;
-                            volenv->state        = ENV_SUSTAIN;
-                        }
-                        attenuation += volenv->value_db_oct;
-                        break;
+#ifdef EMU8K_SSE2
+    for (; i <= (samples - 4); i += 4) {
+        __m128 p0 = emu8k_interp_products(emu8k, i);
+        __m128 p1 = emu8k_interp_products(emu8k, i + 1);
+        __m128 p2 = emu8k_interp_products(emu8k, i + 2);
+        __m128 p3 = emu8k_interp_products(emu8k, i + 3);
 
-                    case ENV_SUSTAIN:
-                        attenuation += volenv->value_db_oct;
-                        break;
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+        _mm_storeu_si128((__m128i *) &voice_dat[i], _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(_mm_add_ps(p0, p1), p2), p3)));
+    }
+#elif defined(EMU8K_NEON)
+    for (; i <= (samples - 4); i += 4) {
+        const float32x4_t   p0 = emu8k_interp_products(emu8k, i);
+        const float32x4_t   p1 = emu8k_interp_products(emu8k, i + 1);
+        const float32x4_t   p2 = emu8k_interp_products(emu8k, i + 2);
+        const float32x4_t   p3 = emu8k_interp_products(emu8k, i + 3);
+        const float32x4x2_t a  = vzipq_f32(p0, p2);
+        const float32x4x2_t b  = vzipq_f32(p1, p3);
+        const float32x4x2_t lo = vzipq_f32(a.val[0], b.val[0]);
+        const float32x4x2_t hi = vzipq_f32(a.val[1], b.val[1]);
+
+        /* Separate adds, a fused multiply-add would round differently. */
+        vst1q_s32(&voice_dat[i], vcvtq_s32_f32(vaddq_f32(vaddq_f32(vaddq_f32(lo.val[0], lo.val[1]), hi.val[0]), hi.val[1])));
+    }
+#endif
 
-                    case ENV_STOPPED:
-                        attenuation = 0x1FFFFF;
-                        break;
+    for (; i < samples; i++)
+        voice_dat[i] = EMU8K_READ_INTERP_CUBIC(emu8k, voice_addr[i], voice_fract[i]);
+}
 
-                    default:
-                        break;
-                }
+/* Filter, volume, pan and effect sends over the captured samples. */
+static void
+emu8k_voice_render(emu8k_t *emu8k, emu8k_voice_t *emu_voice, int32_t *buf, int start, int samples)
+{
+    int32_t dat;
 
-                emu8k_envelope_t *modenv = &emu_voice->mod_envelope;
-                switch (modenv->state) {
-                    case ENV_DELAY:
-                        modenv->delay_samples--;
-                        if (modenv->delay_samples <= 0) {
-                            modenv->state         = ENV_ATTACK;
-                            modenv->delay_samples = 0;
-                        }
-                        break;
+    emu8k_voice_interp(emu8k, samples);
 
-                    case ENV_ATTACK:
-                        /* Attack amount is in linear amplitude */
-                        modenv->value_amp_hz += modenv->attack_amount_amp_hz;
-                        modenv->value_db_oct = env_mod_hertz_to_octave[modenv->value_amp_hz >> 5] << 5;
-                        if (modenv->value_amp_hz >= (1 << 21)) {
-                            modenv->value_amp_hz = 1 << 21;
-                            modenv->value_db_oct = 1 << 21;
-                            if (modenv->hold_samples) {
-                                modenv->state = ENV_HOLD;
-                            } else {
-                                modenv->state = ENV_RAMP_DOWN;
-                            }
-                        }
-                        break;
+    for (int i = 0; i < samples; i++) {
+        if (!voice_vol[i])
+            continue;
 
-                    case ENV_HOLD:
-                        modenv->hold_samples--;
-                        if (modenv->hold_samples <= 0) {
-                            modenv->state = ENV_RAMP_UP;
-                        }
-                        break;
+        dat = voice_dat[i];
 
-                    case ENV_RAMP_DOWN:
-                        /* Decay/release amount is in fraction of octave and is always positive */
-                        modenv->value_db_oct -= modenv->ramp_amount_db_oct;
-                        if (modenv->value_db_oct <= modenv->sustain_value_db_oct) {
-                            modenv->value_db_oct = modenv->sustain_value_db_oct;
-                            modenv->state        = ENV_SUSTAIN;
-                        }
-                        break;
+        /* Filter section */
+        if (emu_voice->filterq_idx || voice_cut[i] != 0xFFFF) {
+            int           cutoff = voice_cut[i] >> 8;
+            const int64_t coef0  = filt_coeffs[emu_voice->filterq_idx][cutoff][0];
+            const int64_t coef1  = filt_coeffs[emu_voice->filterq_idx][cutoff][1];
+            const int64_t coef2  = filt_coeffs[emu_voice->filterq_idx][cutoff][2];
+/* clip at twice the range */
+#define ClipBuffer(buf) (buf < -16777216) ? -16777216 : (buf > 16777216) ? 16777216 \
+                                                                 : buf
 
-                    case ENV_RAMP_UP:
-                        /* Decay/release amount is in fraction of octave and is always positive */
-                        modenv->value_db_oct += modenv->ramp_amount_db_oct;
-                        if (modenv->value_db_oct >= modenv->sustain_value_db_oct) {
-                            modenv->value_db_oct = modenv->sustain_value_db_oct;
-                            modenv->state        = ENV_SUSTAIN;
-                        }
-                        break;
+#ifdef FILTER_INITIAL
+#    define NOOP(x) (void) x;
+            NOOP(coef1)
+            /* Apply expected attenuation. (FILTER_MOOG does it implicitly, but this one doesn't).
+             * Work in 24bits. */
+            dat = (dat * emu_voice->filt_att) >> 8;
+
+            int64_t vhp = ((-emu_voice->filt_buffer[0] * coef2) >> 24) - emu_voice->filt_buffer[1] - dat;
+            emu_voice->filt_buffer[1] += (emu_voice->filt_buffer[0] * coef0) >> 24;
+            emu_voice->filt_buffer[0] += (vhp * coef0) >> 24;
+            dat = (int32_t) (emu_voice->filt_buffer[1] >> 8);
+            if (dat > 32767) {
+                dat = 32767;
+            } else if (dat < -32768) {
+                dat = -32768;
+            }
 
-                    default:
-                        break;
-                }
+#elif defined FILTER_MOOG
 
-                /* run lfos */
-                if (emu_voice->lfo1_delay_samples) {
-                    emu_voice->lfo1_delay_samples--;
-                } else {
-                    emu_voice->lfo1_count.addr += emu_voice->lfo1_speed;
-                    emu_voice->lfo1_count.int_address &= 0xFFFF;
-                }
-                if (emu_voice->lfo2_delay_samples) {
-                    emu_voice->lfo2_delay_samples--;
-                } else {
-                    emu_voice->lfo2_count.addr += emu_voice->lfo2_speed;
-                    emu_voice->lfo2_count.int_address &= 0xFFFF;
-                }
+            /*move to 24bits*/
+            dat <<= 8;
 
-                if (emu_voice->fixed_modenv_pitch_height) {
-                    /* modenv range 1<<21, pitch height range 1<<14 desired range 0x1000 (+/-one octave) */
-                    currentpitch += ((modenv->value_db_oct >> 9) * emu_voice->fixed_modenv_pitch_height) >> 14;
-                }
+            dat -= (coef2 * emu_voice->filt_buffer[4]) >> 24; /*feedback*/
+            int64_t t1 = emu_voice->filt_buffer[1];
+            emu_voice->filt_buffer[1] = ((dat + emu_voice->filt_buffer[0]) * coef0 - emu_voice->filt_buffer[1] * coef1) >> 24;
+            emu_voice->filt_buffer[1] = ClipBuffer(emu_voice->filt_buffer[1]);
 
-                if (emu_voice->fixed_lfo1_vibrato) {
-                    /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
-                    int32_t lfo1_vibrato = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_vibrato) >> 17;
-                    currentpitch += lfo1_vibrato;
-                }
-                if (emu_voice->fixed_lfo2_vibrato) {
-                    /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
-                    int32_t lfo2_vibrato = (lfotable[emu_voice->lfo2_count.int_address] * emu_voice->fixed_lfo2_vibrato) >> 17;
-                    currentpitch += lfo2_vibrato;
-                }
+            int64_t t2 = emu_voice->filt_buffer[2];
+            emu_voice->filt_buffer[2] = ((emu_voice->filt_buffer[1] + t1) * coef0 - emu_voice->filt_buffer[2] * coef1) >> 24;
+            emu_voice->filt_buffer[2] = ClipBuffer(emu_voice->filt_buffer[2]);
 
-                if (emu_voice->fixed_modenv_filter_height) {
-                    /* modenv range 1<<21, pitch height range 1<<14 desired range 0x200000 (+/-full filter range) */
-                    filtercut += ((modenv->value_db_oct >> 9) * emu_voice->fixed_modenv_filter_height) >> 5;
-                }
+            int64_t t3 = emu_voice->filt_buffer[3];
+            emu_voice->filt_buffer[3] = ((emu_voice->filt_buffer[2] + t2) * coef0 - emu_voice->filt_buffer[3] * coef1) >> 24;
+            emu_voice->filt_buffer[3] = ClipBuffer(emu_voice->filt_buffer[3]);
 
-                if (emu_voice->fixed_lfo1_filt_mod) {
-                    /* table range 1<<15, pitch mod range 1<<14 desired range 0x100000 (+/-three octaves) */
-                    int32_t lfo1_filtmod = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_filt_mod) >> 9;
-                    filtercut += lfo1_filtmod;
-                }
+            emu_voice->filt_buffer[4] = ((emu_voice->filt_buffer[3] + t3) * coef0 - emu_voice->filt_buffer[4] * coef1) >> 24;
+            emu_voice->filt_buffer[4] = ClipBuffer(emu_voice->filt_buffer[4]);
 
-                if (emu_voice->fixed_lfo1_tremolo) {
-                    /* table range 1<<15, pitch mod range 1<<14 desired range 0x40000 (+/-12dBs). */
-                    int32_t lfo1_tremolo = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_tremolo) >> 11;
-                    attenuation += lfo1_tremolo;
-                }
+            emu_voice->filt_buffer[0] = ClipBuffer(dat);
 
-                if (currentpitch > 0xFFFF)
-                    currentpitch = 0xFFFF;
-                if (currentpitch < 0)
-                    currentpitch = 0;
-                if (attenuation > 0x1FFFFF)
-                    attenuation = 0x1FFFFF;
-                if (attenuation < 0)
-                    attenuation = 0;
-                if (filtercut > 0x1FFFFF)
-                    filtercut = 0x1FFFFF;
-                if (filtercut < 0)
-                    filtercut = 0;
-
-                emu_voice->vtft_vol_target    = env_vol_db_to_vol_target[attenuation >> 5];
-                emu_voice->vtft_filter_target = filtercut >> 5;
-                emu_voice->ptrx_pit_target    = freqtable[currentpitch] >> 18;
+            dat = (int32_t) (emu_voice->filt_buffer[4] >> 8);
+            if (dat > 32767) {
+                dat = 32767;
+            } else if (dat < -32768) {
+                dat = -32768;
             }
-            /*
-            I've recopilated these sentences to get an idea of how to loop
-
-            - Set its PSST register and its CLS register to zero to cause no loops to occur.
-            -Setting the Loop Start Offset and the Loop End Offset to the same value, will cause the oscillator to loop the entire memory.
-
-            -Setting the PlayPosition greater than the Loop End Offset, will cause the oscillator to play in reverse, back to the Loop End Offset.
-               It's pretty neat, but appears to be uncontrollable (the rate at which the samples are played in reverse).
-
-            -Note that due to interpolator offset, the actual loop point is one greater than the start address
-            -Note that due to interpolator offset, the actual loop point will end at an address one greater than the loop address
-            -Note that the actual audio location is the point 1 word higher than this value due to interpolation offset
-            -In programs that use the awe, they generally set the loop address as "loopaddress -1" to compensate for the above.
-            (Note: I am already using address+1 in the interpolators so these things are already as they should.)
-            */
-            emu_voice->addr.addr += ((uint64_t) emu_voice->cpf_curr_pitch) << 18;
-            if (emu_voice->addr.addr >= emu_voice->loop_end.addr) {
-                emu_voice->addr.int_address -= (emu_voice->loop_end.int_address - emu_voice->loop_start.int_address);
-                emu_voice->addr.int_address &= EMU8K_MEM_ADDRESS_MASK;
+
+#elif defined FILTER_CONSTANT
+
+            /* Apply expected attenuation. (FILTER_MOOG does it implicitly, but this one is constant gain).
+             * Also stay at 24bits.*/
+            dat = (dat * emu_voice->filt_att) >> 8;
+
+            emu_voice->filt_buffer[0] = (coef1 * emu_voice->filt_buffer[0]
+                                         + coef0 * (dat + ((coef2 * (emu_voice->filt_buffer[0] - emu_voice->filt_buffer[1])) >> 24)))
+                >> 24;
+            emu_voice->filt_buffer[1] = (coef1 * emu_voice->filt_buffer[1]
+                                         + coef0 * emu_voice->filt_buffer[0])
+                >> 24;
+
+            emu_voice->filt_buffer[0] = ClipBuffer(emu_voice->filt_buffer[0]);
+            emu_voice->filt_buffer[1] = ClipBuffer(emu_voice->filt_buffer[1]);
+
+            dat = (int32_t) (emu_voice->filt_buffer[1] >> 8);
+            if (dat > 32767) {
+                dat = 32767;
+            } else if (dat < -32768) {
+                dat = -32768;
+            }
+
+#endif
+        }
+        if ((emu8k->hwcf3 & 0x04) && !CCCA_DMA_ACTIVE(emu_voice->ccca)) {
+            /*volume and pan*/
+            dat = (dat * voice_vol[i]) >> 16;
+
+            buf[i * 2]       += (dat * emu_voice->vol_l) >> 8;
+            buf[(i * 2) + 1] += (dat * emu_voice->vol_r) >> 8;
+
+            /* Effects section */
+            if (emu_voice->ptrx_revb_send > 0) {
+                emu8k->reverb_in_buffer[start + i] += (dat * emu_voice->ptrx_revb_send) >> 8;
+            }
+            if (emu_voice->csl_chor_send > 0) {
+                emu8k->chorus_in_buffer[start + i] += (dat * emu_voice->csl_chor_send) >> 8;
+            }
+        }
+    }
+}
+
+#if 0
+int32_t old_pitch[32] = { 0 };
+int32_t old_cut[32]   = { 0 };
+int32_t old_vol[32]   = { 0 };
+#endif
+void
+emu8k_update(emu8k_t *emu8k)
+{
+    wavetable_pos_sync();
+    if (emu8k->pos >= wavetable_pos_global)
+        return;
+
+    int32_t       *buf;
+    emu8k_voice_t *emu_voice;
+    int            pos;
+    const int      count = wavetable_pos_global - emu8k->pos;
+
+    /* Clean the buffers since we will accumulate into them. */
+    buf = &emu8k->buffer[emu8k->pos * 2];
+    memset(buf, 0, 2 * (wavetable_pos_global - emu8k->pos) * sizeof(emu8k->buffer[0]));
+    memset(&emu8k->chorus_in_buffer[emu8k->pos], 0, (wavetable_pos_global - emu8k->pos) * sizeof(emu8k->chorus_in_buffer[0]));
+    memset(&emu8k->reverb_in_buffer[emu8k->pos], 0, (wavetable_pos_global - emu8k->pos) * sizeof(emu8k->reverb_in_buffer[0]));
+
+    /* Voices section: a control pass runs the envelopes and the oscillator
+       position over the block, then the audible samples are rendered from
+       the state it captured. */
+    for (uint8_t c = 0; c < 32; c++) {
+        emu_voice = &emu8k->voice[c];
+
+        if (emu8k_voice_silent(emu_voice))
+            emu8k_voice_skip(emu_voice, count);
+        else {
+            int audible = 0;
+
+            for (pos = 0; pos < count; pos++) {
+                voice_addr[pos]  = emu_voice->addr.int_address;
+                voice_fract[pos] = emu_voice->addr.fract_address;
+                voice_vol[pos]   = emu_voice->cvcf_curr_volume;
+                voice_cut[pos]   = emu_voice->cvcf_curr_filt_ctoff;
+                audible |= voice_vol[pos];
+
+                if (emu_voice->env_engine_on)
+                    emu8k_voice_envelopes(emu_voice);
+
+                emu8k_voice_advance(emu_voice);
             }
 
-            /* TODO: How and when are the target and current values updated */
-            emu_voice->cpf_curr_pitch       = emu_voice->ptrx_pit_target;
-            emu_voice->cvcf_curr_volume     = emu8k_vol_slide(&emu_voice->volumeslide, emu_voice->vtft_vol_target);
-            emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
+            if (audible)
+                emu8k_voice_render(emu8k, emu_voice, &emu8k->buffer[emu8k->pos * 2], emu8k->pos, count);
         }
 
         /* Update EMU voice registers. */
@@ -2242,6 +2458,9 @@ emu8k_init(emu8k_t *emu8k, uint16_t emu_addr, int onboard_ram)
     env_vol_db_to_vol_target[0x10000 - 1] = 0;
     /* One more position to accept max value being 65536. */
     env_vol_db_to_vol_target[0x10000] = 0;
+    for (c = 0x10000; (c > 0) && !env_vol_db_to_vol_target[c - 1]; c--)
+        ;
+    env_vol_silent_att = c << 5;
 
     for (c = 1; c < 0x10000; c++) {
         out                        = -680.32142884264 * 20.0 * log10(((double) c) / 65535.0);
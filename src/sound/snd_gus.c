@@ -48,6 +48,10 @@ enum {
     GUS_MAX     = 1,
 };
 
+/* Most samples rendered per pass, and how far apart the sample timer fires
+   when no IRQ is due. */
+#define GUS_BLOCK 256
+
 typedef struct gus_t {
     int reset;
 
@@ -94,6 +98,7 @@ typedef struct gus_t {
 
     pc_timer_t samp_timer;
     uint64_t   samp_latch;
+    uint64_t   samp_ahead;
 
     uint8_t *ram;
     uint32_t gus_end_ram;
@@ -248,6 +253,9 @@ gus_midi_update_int_status(gus_t *gus)
     gus_update_int_status(gus);
 }
 
+static void gus_render_now(gus_t *gus);
+static void gus_schedule(gus_t *gus);
+
 void
 writegus(uint16_t addr, uint8_t val, void *priv)
 {
@@ -265,6 +273,10 @@ writegus(uint16_t addr, uint8_t val, void *priv)
     else
         port = addr & 0xf0f;
 
+    /* Voice and DRAM accesses have to find the voices up to date. */
+    if ((port >= 0x304) && (port <= 0x307))
+        gus_render_now(gus);
+
     switch (port) {
         case 0x300: /*MIDI control*/
             old            = gus->midi_ctrl;
@@ -709,6 +721,9 @@ writegus(uint16_t addr, uint8_t val, void *priv)
         default:
             break;
     }
+
+    if ((port == 0x304) || (port == 0x305))
+        gus_schedule(gus);
 }
 
 uint8_t
@@ -723,6 +738,9 @@ readgus(uint16_t addr, void *priv)
     else
         port = addr & 0xf0f;
 
+    if ((port >= 0x304) && (port <= 0x307))
+        gus_render_now(gus);
+
     switch (port) {
         case 0x300: /*MIDI status*/
             val = gus->midi_status;
@@ -788,6 +806,8 @@ readgus(uint16_t addr, void *priv)
                     gus->rampirqs[gus->irqstatus2 & 0x1F] = 0;
                     gus->waveirqs[gus->irqstatus2 & 0x1F] = 0;
                     gus_update_int_status(gus);
+                    /* The voice can raise its IRQs again. */
+                    gus_schedule(gus);
                     return val;
 
                 case 0x00:
@@ -842,6 +862,8 @@ readgus(uint16_t addr, void *priv)
                     gus->rampirqs[gus->irqstatus2 & 0x1F] = 0;
                     gus->waveirqs[gus->irqstatus2 & 0x1F] = 0;
                     gus_update_int_status(gus);
+                    /* The voice can raise its IRQs again. */
+                    gus_schedule(gus);
                     return val;
 
                 case 0x41: /*DMA control*/
@@ -1005,10 +1027,11 @@ gus_poll_timer_2(void *priv)
     gus_update_int_status(gus);
 }
 
+/* Holds the last output sample up to pos in the output buffer. */
 static void
-gus_update(gus_t *gus)
+gus_update(gus_t *gus, int pos)
 {
-    for (; gus->pos < sound_pos_global; gus->pos++) {
+    for (; gus->pos < pos; gus->pos++) {
         if (gus->out_l < -32768)
             gus->buffer[0][gus->pos] = -32768;
         else if (gus->out_l > 32767)
@@ -1024,72 +1047,72 @@ gus_update(gus_t *gus)
     }
 }
 
-void
-gus_poll_wave(void *priv)
+static __inline int16_t
+gus_voice_fetch(gus_t *gus, int d, int bits16, int interp)
 {
-    gus_t   *gus = (gus_t *) priv;
     uint32_t addr;
-    int16_t  v;
     int32_t  vl;
-    int      update_irqs = 0;
 
-    gus_update(gus);
+    if (bits16) {
+        addr = gus->cur[d] >> 9;
+        addr = (addr & 0xC0000) | ((addr << 1) & 0x3FFFE);
+        if (interp) {
+            if (((addr + 1) & 0xfffff) < gus->gus_end_ram)
+                vl = (int16_t) (int8_t) ((gus->ram[(addr + 1) & 0xfffff] ^ 0x80) - 0x80) *
+                     (511 - (gus->cur[d] & 511));
+            else
+                vl = 0;
 
-    timer_advance_u64(&gus->samp_timer, gus->samp_latch);
+            if (((addr + 3) & 0xfffff) < gus->gus_end_ram)
+                vl += (int16_t) (int8_t) ((gus->ram[(addr + 3) & 0xfffff] ^ 0x80) - 0x80) *
+                      (gus->cur[d] & 511);
 
-    gus->out_l = gus->out_r = 0;
+            return vl >> 9;
+        } else if (((addr + 1) & 0xfffff) < gus->gus_end_ram)
+            return (int16_t) (int8_t) ((gus->ram[(addr + 1) & 0xfffff] ^ 0x80) - 0x80);
+    } else {
+        if (interp) {
+            if (((gus->cur[d] >> 9) & 0xfffff) < gus->gus_end_ram)
+                vl = ((int8_t) ((gus->ram[(gus->cur[d] >> 9) & 0xfffff] ^ 0x80) - 0x80)) *
+                               (511 - (gus->cur[d] & 511));
+            else
+                vl = 0;
 
-    if ((gus->reset & 3) != 3)
-        return;
-    for (uint8_t d = 0; d < 32; d++) {
-        if (!(gus->ctrl[d] & 3)) {
-            if (gus->ctrl[d] & 4) {
-                addr = gus->cur[d] >> 9;
-                addr = (addr & 0xC0000) | ((addr << 1) & 0x3FFFE);
-                if (!(gus->freq[d] >> 10)) {
-                    /* Interpolate */
-                    if (((addr + 1) & 0xfffff) < gus->gus_end_ram)
-                        vl = (int16_t) (int8_t) ((gus->ram[(addr + 1) & 0xfffff] ^ 0x80) - 0x80) *
-                             (511 - (gus->cur[d] & 511));
-                    else
-                        vl = 0;
+            if ((((gus->cur[d] >> 9) + 1) & 0xfffff) < gus->gus_end_ram)
+                vl += ((int8_t) ((gus->ram[((gus->cur[d] >> 9) + 1) & 0xfffff] ^ 0x80) - 0x80)) *
+                      (gus->cur[d] & 511);
 
-                    if (((addr + 3) & 0xfffff) < gus->gus_end_ram)
-                        vl += (int16_t) (int8_t) ((gus->ram[(addr + 3) & 0xfffff] ^ 0x80) - 0x80) *
-                              (gus->cur[d] & 511);
+            return vl >> 9;
+        } else if (((gus->cur[d] >> 9) & 0xfffff) < gus->gus_end_ram)
+            return (int16_t) (int8_t) ((gus->ram[(gus->cur[d] >> 9) & 0xfffff] ^ 0x80) - 0x80);
+    }
 
-                    v = vl >> 9;
-                } else if (((addr + 1) & 0xfffff) < gus->gus_end_ram)
-                    v = (int16_t) (int8_t) ((gus->ram[(addr + 1) & 0xfffff] ^ 0x80) - 0x80);
-                else
-                    v = 0x0000;
-            } else {
-                if (!(gus->freq[d] >> 10)) {
-                    /* Interpolate */
-                    if (((gus->cur[d] >> 9) & 0xfffff) < gus->gus_end_ram)
-                        vl = ((int8_t) ((gus->ram[(gus->cur[d] >> 9) & 0xfffff] ^ 0x80) - 0x80)) *
-                                       (511 - (gus->cur[d] & 511));
-                    else
-                        vl = 0;
+    return 0x0000;
+}
 
-                    if ((((gus->cur[d] >> 9) + 1) & 0xfffff) < gus->gus_end_ram)
-                        vl += ((int8_t) ((gus->ram[((gus->cur[d] >> 9) + 1) & 0xfffff] ^ 0x80) - 0x80)) *
-                              (gus->cur[d] & 511);
+/* Runs one voice over n samples, mixing it into out_l and out_r. The sample
+   width and interpolation can only change through a register write, and
+   those bring the voices up to date first, so they are fixed for the block.
+   Returns whether an IRQ was raised. */
+static int
+gus_voice_render(gus_t *gus, int d, int32_t *out_l, int32_t *out_r, int n)
+{
+    const int bits16      = gus->ctrl[d] & 4;
+    const int interp      = !(gus->freq[d] >> 10);
+    int       update_irqs = 0;
+    int16_t   v;
 
-                    v = vl >> 9;
-                } else if (((gus->cur[d] >> 9) & 0xfffff) < gus->gus_end_ram)
-                    v = (int16_t) (int8_t) ((gus->ram[(gus->cur[d] >> 9) & 0xfffff] ^ 0x80) - 0x80);
-                else
-                    v = 0x0000;
-            }
+    for (int c = 0; c < n; c++) {
+        if (!(gus->ctrl[d] & 3)) {
+            v = gus_voice_fetch(gus, d, bits16, interp);
 
             if ((gus->rcur[d] >> 14) > 4095)
                 v = (int16_t) (float) (v) *24.0 * vol16bit[4095];
             else
                 v = (int16_t) (float) (v) *24.0 * vol16bit[(gus->rcur[d] >> 10) & 4095];
 
-            gus->out_l += (v * gus->pan_l[d]) / 7;
-            gus->out_r += (v * gus->pan_r[d]) / 7;
+            out_l[c] += (v * gus->pan_l[d]) / 7;
+            out_r[c] += (v * gus->pan_r[d]) / 7;
 
             if (gus->ctrl[d] & 0x40) {
                 gus->cur[d] -= (gus->freq[d] >> 1);
@@ -1171,12 +1194,131 @@ gus_poll_wave(void *priv)
                 }
             }
         }
+
+        /* Both the wave and the ramp have stopped, the rest is silence. */
+        if ((gus->ctrl[d] & 3) && (gus->rctrl[d] & 3))
+            break;
+    }
+
+    return update_irqs;
+}
+
+/* Produces n samples, voice by voice. Voices with both the wave and the
+   volume ramp stopped neither sound nor change, so they are left out. */
+static void
+gus_render_block(gus_t *gus, int32_t *out_l, int32_t *out_r, int n)
+{
+    uint8_t active[32];
+    int     active_num  = 0;
+    int     update_irqs = 0;
+
+    memset(out_l, 0x00, n * sizeof(int32_t));
+    memset(out_r, 0x00, n * sizeof(int32_t));
+
+    if ((gus->reset & 3) != 3)
+        return;
+
+    for (uint8_t d = 0; d < 32; d++) {
+        if (!(gus->ctrl[d] & 3) || !(gus->rctrl[d] & 3))
+            active[active_num++] = d;
     }
 
+    for (int c = 0; c < active_num; c++)
+        update_irqs |= gus_voice_render(gus, active[c], out_l, out_r, n);
+
     if (update_irqs)
         gus_update_int_status(gus);
 }
 
+/* Brings the voices up to time now. The next sample is due samp_ahead
+   before the sample timer fires; keeping it relative to the timer lets it
+   follow the timer when the timestamps are rebased. */
+static void
+gus_render(gus_t *gus, uint64_t now)
+{
+    uint64_t next = gus->samp_timer.ts.ts64 - gus->samp_ahead;
+    int32_t  out_l[GUS_BLOCK];
+    int32_t  out_r[GUS_BLOCK];
+    int      n;
+
+    while ((int64_t) (now - next) >= 0) {
+        n = 1 + (int) MIN((now - next) / gus->samp_latch, GUS_BLOCK - 1);
+
+        gus_render_block(gus, out_l, out_r, n);
+
+        /* Output positions are taken at whole timer ticks, as when the
+           sample timer fired for every sample. */
+        for (int c = 0; c < n; c++) {
+            gus_update(gus, sound_pos_at(next & ~0xffffffffULL));
+
+            gus->out_l = out_l[c];
+            gus->out_r = out_r[c];
+            next += gus->samp_latch;
+        }
+    }
+
+    gus->samp_ahead = gus->samp_timer.ts.ts64 - next;
+}
+
+/* Like the timers, a sample is due once the integer part of its time has
+   been reached. */
+static void
+gus_render_now(gus_t *gus)
+{
+    gus_render(gus, (uint64_t) (tsc << 32) | 0xffffffffULL);
+}
+
+/* Lower bound on the samples until a position stepping by step from cur
+   crosses the boundary, counting the step that crosses it. */
+static uint32_t
+gus_steps_to(int64_t cur, int64_t bound, int64_t step, int down)
+{
+    int64_t dist;
+
+    if (down ? (cur <= bound) : (cur >= bound))
+        return 1;
+    if (!step)
+        return GUS_BLOCK;
+
+    dist = down ? (cur - bound) : (bound - cur);
+
+    return (uint32_t) MIN((dist + step - 1) / step, GUS_BLOCK);
+}
+
+/* Sets the sample timer to the earliest sample that can raise a wave or
+   ramp IRQ, or a block ahead when none can. Everything else the guest sees
+   is caught up on register access, so the timer does not tick per sample. */
+static void
+gus_schedule(gus_t *gus)
+{
+    uint64_t next  = gus->samp_timer.ts.ts64 - gus->samp_ahead;
+    uint32_t steps = GUS_BLOCK;
+
+    if ((gus->reset & 3) == 3) {
+        for (uint8_t d = 0; d < 32; d++) {
+            if (!(gus->ctrl[d] & 3) && (gus->ctrl[d] & 0x20) && !gus->waveirqs[d])
+                steps = MIN(steps, gus_steps_to(gus->cur[d], (gus->ctrl[d] & 0x40) ? gus->start[d] : gus->end[d],
+                                                gus->freq[d] >> 1, gus->ctrl[d] & 0x40));
+            if (!(gus->rctrl[d] & 3) && (gus->rctrl[d] & 0x20) && !gus->rampirqs[d])
+                steps = MIN(steps, gus_steps_to(gus->rcur[d], (gus->rctrl[d] & 0x40) ? gus->rstart[d] : gus->rend[d],
+                                                gus->rfreq[d], gus->rctrl[d] & 0x40));
+        }
+    }
+
+    gus->samp_ahead         = (steps - 1) * gus->samp_latch;
+    gus->samp_timer.ts.ts64 = next + gus->samp_ahead;
+    timer_enable(&gus->samp_timer);
+}
+
+void
+gus_poll_wave(void *priv)
+{
+    gus_t *gus = (gus_t *) priv;
+
+    gus_render(gus, gus->samp_timer.ts.ts64);
+    gus_schedule(gus);
+}
+
 static void
 gus_get_buffer(int32_t *buffer, int len, void *priv)
 {
@@ -1186,7 +1328,9 @@ gus_get_buffer(int32_t *buffer, int len, void *priv)
     if ((gus->type == GUS_MAX) && (gus->max_ctrl))
         ad1848_update(&gus->ad1848);
 #endif
-    gus_update(gus);
+    gus_render(gus, sound_buf_end_ts());
+    sound_pos_sync();
+    gus_update(gus, sound_pos_global);
 
     for (int c = 0; c < len * 2; c++) {
 #if defined(DEV_BRANCH) && defined(USE_GUSMAX)
@@ -1419,11 +1563,15 @@ gus_speed_changed(void *priv)
 {
     gus_t *gus = (gus_t *) priv;
 
+    gus_render_now(gus);
+
     if (gus->voices < 14)
         gus->samp_latch = (uint64_t) (TIMER_USEC * (1000000.0 / 44100.0));
     else
         gus->samp_latch = (uint64_t) (TIMER_USEC * (1000000.0 / gusfreqs[gus->voices - 14]));
 
+    gus_schedule(gus);
+
 #if defined(DEV_BRANCH) && defined(USE_GUSMAX)
     if ((gus->type == GUS_MAX) && (gus->max_ctrl))
         ad1848_speed_changed(&gus->ad1848);
@@ -32,6 +32,7 @@ typedef struct dss_t {
 static void
 dss_update(dss_t *dss)
 {
+    sound_pos_sync();
     for (; dss->pos < sound_pos_global; dss->pos++)
         dss->buffer[dss->pos] = (int8_t) (dss->dac_val ^ 0x80) * 0x40;
 }
@@ -201,6 +201,7 @@ esfm_drv_update(void *priv)
 {
     esfm_drv_t *dev = (esfm_drv_t *) priv;
 
+    music_pos_sync();
     if (dev->pos >= music_pos_global)
         return dev->buffer;
 
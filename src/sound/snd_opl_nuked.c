@@ -49,6 +49,7 @@
 #include <86box/sound.h>
 #include <86box/timer.h>
 #include <86box/device.h>
+#include <86box/thread.h>
 #include <86box/snd_opl.h>
 
 #define WRBUF_SIZE  1024
@@ -176,6 +177,20 @@ typedef struct chip {
     wrbuf_t  wrbuf[WRBUF_SIZE];
 } nuked_t;
 
+#define NUKED_WRITES 2048
+
+/* A register write, stamped with its position in the music buffer. */
+typedef struct nuked_write_t {
+    int      pos;
+    uint16_t reg;
+    uint8_t  val;
+} nuked_write_t;
+
+/* With a render worker the chip runs one buffer behind, the same way as the
+   SSI-2001: register writes are queued against the buffer being filled, the
+   worker renders it from the queue once the card has taken the previous one.
+   The status register and the timers live here on the emulation side, so
+   reads never have to wait for the worker. */
 typedef struct {
     nuked_t opl;
     int8_t  flags;
@@ -186,11 +201,18 @@ typedef struct {
     uint8_t  timer_ctrl;
     uint16_t timer_count[2];
     uint16_t timer_cur_count[2];
+    uint8_t  newm;
 
     pc_timer_t timers[2];
 
-    int     pos;
-    int32_t buffer[MUSICBUFLEN * 2];
+    int     pos[2];
+    int     cur;
+    int     job;
+    int     render_id;
+    int32_t buffer[2][MUSICBUFLEN * 2];
+
+    int           writes_num[2];
+    nuked_write_t writes[2][NUKED_WRITES];
 } nuked_drv_t;
 
 enum {
@@ -339,9 +361,16 @@ static const uint8_t ch_slot[18] = {
 };
 
 // Envelope generator
-typedef int16_t (*env_sinfunc)(uint16_t phase, uint16_t envelope);
 typedef void (*env_genfunc)(slot_t *slot);
 
+/* Log-sin attenuation of each waveform per 10-bit phase, with bit 15 set
+   where the output is negated; built once so that slot_generate() is a pair
+   of lookups instead of a call through a per-waveform function. */
+#define WF_NEG 0x8000
+
+static uint16_t env_wf[8][1024];
+static int      env_wf_ready = 0;
+
 static int16_t
 env_calc_exp(uint32_t level)
 {
@@ -351,152 +380,99 @@ env_calc_exp(uint32_t level)
     return ((exprom[level & 0xff] << 1) >> (level >> 8));
 }
 
-static int16_t
-env_calc_sin0(uint16_t phase, uint16_t env)
+static uint16_t
+env_calc_wf(uint8_t wf, uint16_t phase)
 {
     uint16_t out = 0;
     uint16_t neg = 0;
 
-    phase &= 0x3ff;
-
-    if (phase & 0x0200)
-        neg = 0xffff;
-
-    if (phase & 0x0100)
-        out = logsinrom[(phase & 0xff) ^ 0xff];
-    else
-        out = logsinrom[phase & 0xff];
-
-    return (env_calc_exp(out + (env << 3)) ^ neg);
-}
-
-static int16_t
-env_calc_sin1(uint16_t phase, uint16_t env)
-{
-    uint16_t out = 0;
-
-    phase &= 0x3ff;
-
-    if (phase & 0x0200)
-        out = 0x1000;
-    else if (phase & 0x0100)
-        out = logsinrom[(phase & 0xff) ^ 0xff];
-    else
-        out = logsinrom[phase & 0xff];
-
-    return (env_calc_exp(out + (env << 3)));
-}
-
-static int16_t
-env_calc_sin2(uint16_t phase, uint16_t env)
-{
-    uint16_t out = 0;
-
-    phase &= 0x03ff;
-
-    if (phase & 0x0100)
-        out = logsinrom[(phase & 0xff) ^ 0xff];
-    else
-        out = logsinrom[phase & 0xff];
-
-    return (env_calc_exp(out + (env << 3)));
-}
-
-static int16_t
-env_calc_sin3(uint16_t phase, uint16_t env)
-{
-    uint16_t out = 0;
-
-    phase &= 0x03ff;
-
-    if (phase & 0x0100)
-        out = 0x1000;
-    else
-        out = logsinrom[phase & 0xff];
-
-    return (env_calc_exp(out + (env << 3)));
-}
-
-static int16_t
-env_calc_sin4(uint16_t phase, uint16_t env)
-{
-    uint16_t out = 0;
-    uint16_t neg = 0;
-
-    phase &= 0x03ff;
-
-    if ((phase & 0x0300) == 0x0100)
-        neg = 0xffff;
-
-    if (phase & 0x0200)
-        out = 0x1000;
-    else if (phase & 0x80)
-        out = logsinrom[((phase ^ 0xff) << 1) & 0xff];
-    else
-        out = logsinrom[(phase << 1) & 0xff];
+    switch (wf) {
+        case 0:
+            if (phase & 0x0200)
+                neg = WF_NEG;
+            if (phase & 0x0100)
+                out = logsinrom[(phase & 0xff) ^ 0xff];
+            else
+                out = logsinrom[phase & 0xff];
+            break;
 
-    return (env_calc_exp(out + (env << 3)) ^ neg);
-}
+        case 1:
+            if (phase & 0x0200)
+                out = 0x1000;
+            else if (phase & 0x0100)
+                out = logsinrom[(phase & 0xff) ^ 0xff];
+            else
+                out = logsinrom[phase & 0xff];
+            break;
 
-static int16_t
-env_calc_sin5(uint16_t phase, uint16_t env)
-{
-    uint16_t out = 0;
+        case 2:
+            if (phase & 0x0100)
+                out = logsinrom[(phase & 0xff) ^ 0xff];
+            else
+                out = logsinrom[phase & 0xff];
+            break;
 
-    phase &= 0x03ff;
+        case 3:
+            if (phase & 0x0100)
+                out = 0x1000;
+            else
+                out = logsinrom[phase & 0xff];
+            break;
 
-    if (phase & 0x0200)
-        out = 0x1000;
-    else if (phase & 0x80)
-        out = logsinrom[((phase ^ 0xff) << 1) & 0xff];
-    else
-        out = logsinrom[(phase << 1) & 0xff];
+        case 4:
+            if ((phase & 0x0300) == 0x0100)
+                neg = WF_NEG;
+            if (phase & 0x0200)
+                out = 0x1000;
+            else if (phase & 0x80)
+                out = logsinrom[((phase ^ 0xff) << 1) & 0xff];
+            else
+                out = logsinrom[(phase << 1) & 0xff];
+            break;
 
-    return (env_calc_exp(out + (env << 3)));
-}
+        case 5:
+            if (phase & 0x0200)
+                out = 0x1000;
+            else if (phase & 0x80)
+                out = logsinrom[((phase ^ 0xff) << 1) & 0xff];
+            else
+                out = logsinrom[(phase << 1) & 0xff];
+            break;
 
-static int16_t
-env_calc_sin6(uint16_t phase, uint16_t env)
-{
-    uint16_t neg = 0;
+        case 6:
+            if (phase & 0x0200)
+                neg = WF_NEG;
+            break;
 
-    phase &= 0x03ff;
+        case 7:
+            if (phase & 0x0200) {
+                neg   = WF_NEG;
+                phase = (phase & 0x01ff) ^ 0x01ff;
+            }
+            out = phase << 3;
+            break;
 
-    if (phase & 0x0200)
-        neg = 0xffff;
+        default:
+            break;
+    }
 
-    return (env_calc_exp(env << 3) ^ neg);
+    return out | neg;
 }
 
-static int16_t
-env_calc_sin7(uint16_t phase, uint16_t env)
+static void
+env_wf_init(void)
 {
-    uint16_t out = 0;
-    uint16_t neg = 0;
-
-    phase &= 0x03ff;
+    if (env_wf_ready)
+        return;
 
-    if (phase & 0x0200) {
-        neg   = 0xffff;
-        phase = (phase & 0x01ff) ^ 0x01ff;
+    for (uint8_t wf = 0; wf < 8; wf++) {
+        for (uint16_t phase = 0; phase < 1024; phase++)
+            env_wf[wf][phase] = env_calc_wf(wf, phase);
     }
 
-    out = phase << 3;
-
-    return (env_calc_exp(out + (env << 3)) ^ neg);
+    env_wf_ready = 1;
 }
 
-static const env_sinfunc env_sin[8] = {
-    env_calc_sin0,
-    env_calc_sin1,
-    env_calc_sin2,
-    env_calc_sin3,
-    env_calc_sin4,
-    env_calc_sin5,
-    env_calc_sin6,
-    env_calc_sin7
-};
-
 static void
 env_update_ksl(slot_t *slot)
 {
@@ -784,8 +760,10 @@ slot_write_e0(slot_t *slot, uint8_t data)
 static void
 slot_generate(slot_t *slot)
 {
-    slot->out = env_sin[slot->reg_wf](slot->pg_phase_out + *slot->mod,
-                                      slot->eg_out);
+    const uint16_t wf  = env_wf[slot->reg_wf][(slot->pg_phase_out + *slot->mod) & 0x3ff];
+    const int16_t  neg = -(int16_t) (wf >> 15);
+
+    slot->out = env_calc_exp((wf & ~WF_NEG) + ((uint16_t) slot->eg_out << 3)) ^ neg;
 }
 
 static void
@@ -1391,13 +1369,19 @@ nuked_generate_raw(nuked_t *dev, int32_t *bufp)
     bufp[1] = (int32_t) dev->samples[1];
 }
 
+/* Renders a whole span straight into the caller's buffer. */
 void
 nuked_generate_stream(nuked_t *dev, int32_t *sndptr, uint32_t num)
 {
     for (uint32_t i = 0; i < num; i++) {
-        nuked_generate_raw(dev, sndptr);
+        nuked_generate(dev, sndptr);
         sndptr += 2;
     }
+
+    if (num > 0) {
+        dev->samples[0] = sndptr[-2];
+        dev->samples[1] = sndptr[-1];
+    }
 }
 
 void
@@ -1405,6 +1389,8 @@ nuked_init(nuked_t *dev, uint32_t samplerate)
 {
     uint8_t i;
 
+    env_wf_init();
+
     memset(dev, 0x00, sizeof(nuked_t));
 
     for (i = 0; i < 36; i++) {
@@ -1512,6 +1498,57 @@ nuked_drv_set_do_cycles(void *priv, int8_t do_cycles)
         dev->flags &= ~FLAG_CYCLES;
 }
 
+static void
+nuked_drv_fill(nuked_drv_t *dev, int b, int end)
+{
+    if (dev->pos[b] >= end)
+        return;
+
+    nuked_generate_stream(&dev->opl,
+                          &dev->buffer[b][dev->pos[b] * 2],
+                          end - dev->pos[b]);
+
+    for (; dev->pos[b] < end; dev->pos[b]++) {
+        dev->buffer[b][dev->pos[b] * 2] /= 2;
+        dev->buffer[b][(dev->pos[b] * 2) + 1] /= 2;
+    }
+}
+
+/* Renders buffer b up to end, applying its queued writes on the way. */
+static void
+nuked_drv_render_to(nuked_drv_t *dev, int b, int end)
+{
+    const nuked_write_t *w = dev->writes[b];
+
+    for (int i = 0; i < dev->writes_num[b]; i++) {
+        nuked_drv_fill(dev, b, w[i].pos);
+        nuked_write_reg_buffered(&dev->opl, w[i].reg, w[i].val);
+    }
+    dev->writes_num[b] = 0;
+
+    nuked_drv_fill(dev, b, end);
+}
+
+static void
+nuked_drv_render(void *priv)
+{
+    nuked_drv_t *dev = (nuked_drv_t *) priv;
+
+    nuked_drv_render_to(dev, dev->job, MUSICBUFLEN);
+}
+
+/* Brings the buffer being filled up to the current position. */
+static void
+nuked_drv_catch_up(nuked_drv_t *dev)
+{
+    music_pos_sync();
+
+    if (dev->render_id != -1)
+        sound_render_wait(dev->render_id);
+
+    nuked_drv_render_to(dev, dev->cur, music_pos_global);
+}
+
 static void *
 nuked_drv_init(const device_t *info)
 {
@@ -1528,6 +1565,10 @@ nuked_drv_init(const device_t *info)
     timer_add(&dev->timers[0], nuked_timer_1, dev, 0);
     timer_add(&dev->timers[1], nuked_timer_2, dev, 0);
 
+    dev->render_id = -1;
+    if (thread_get_cpu_count() >= 2)
+        dev->render_id = sound_render_add(nuked_drv_render, dev);
+
     return dev;
 }
 
@@ -1535,6 +1576,9 @@ static void
 nuked_drv_close(void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
+
+    sound_render_remove(dev->render_id);
+
     free(dev);
 }
 
@@ -1543,19 +1587,17 @@ nuked_drv_update(void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
 
-    if (dev->pos >= music_pos_global)
-        return dev->buffer;
+    if (dev->render_id == -1) {
+        nuked_drv_catch_up(dev);
+        return dev->buffer[dev->cur];
+    }
 
-    nuked_generate_stream(&dev->opl,
-                          &dev->buffer[dev->pos * 2],
-                          music_pos_global - dev->pos);
+    sound_render_wait(dev->render_id);
 
-    for (; dev->pos < music_pos_global; dev->pos++) {
-        dev->buffer[dev->pos * 2] /= 2;
-        dev->buffer[(dev->pos * 2) + 1] /= 2;
-    }
+    dev->job = dev->cur;
+    sound_render_request(dev->render_id);
 
-    return dev->buffer;
+    return dev->buffer[dev->cur ^ 1];
 }
 
 static uint8_t
@@ -1566,7 +1608,8 @@ nuked_drv_read(uint16_t port, void *priv)
     if (dev->flags & FLAG_CYCLES)
         cycles -= ((int) (isa_timing * 8));
 
-    nuked_drv_update(dev);
+    if (dev->render_id == -1)
+        nuked_drv_catch_up(dev);
 
     uint8_t ret = 0xff;
 
@@ -1584,11 +1627,25 @@ nuked_drv_read(uint16_t port, void *priv)
 static void
 nuked_drv_write(uint16_t port, uint8_t val, void *priv)
 {
-    nuked_drv_t *dev = (nuked_drv_t *) priv;
-    nuked_drv_update(dev);
+    nuked_drv_t   *dev = (nuked_drv_t *) priv;
+    nuked_write_t *w;
+
+    if (dev->render_id == -1)
+        nuked_drv_catch_up(dev);
 
     if ((port & 0x0001) == 0x0001) {
-        nuked_write_reg_buffered(&dev->opl, dev->port, val);
+        if (dev->render_id == -1)
+            nuked_write_reg_buffered(&dev->opl, dev->port, val);
+        else {
+            music_pos_sync();
+            if (dev->writes_num[dev->cur] == NUKED_WRITES)
+                nuked_drv_catch_up(dev);
+
+            w      = &dev->writes[dev->cur][dev->writes_num[dev->cur]++];
+            w->pos = music_pos_global;
+            w->reg = dev->port;
+            w->val = val;
+        }
 
         switch (dev->port) {
             case 0x002: /* Timer 1 */
@@ -1614,14 +1671,20 @@ nuked_drv_write(uint16_t port, uint8_t val, void *priv)
                 break;
 
             case 0x105:
-                dev->opl.newm = val & 0x01;
+                dev->newm = val & 0x01;
+                if (dev->render_id == -1)
+                    dev->opl.newm = dev->newm;
                 break;
 
             default:
                 break;
         }
     } else {
-        dev->port = nuked_write_addr(&dev->opl, port, val) & 0x01ff;
+        /* Decoded against the mode as last written, the chip itself may
+           still be a buffer behind. */
+        dev->port = val;
+        if ((port & 0x0002) && ((val == 0x05) || dev->newm))
+            dev->port |= 0x0100;
 
         if (!(dev->flags & FLAG_OPL3))
             dev->port &= 0x00ff;
@@ -1633,7 +1696,11 @@ nuked_drv_reset_buffer(void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
 
-    dev->pos = 0;
+    if (dev->render_id != -1)
+        dev->cur ^= 1;
+
+    dev->pos[dev->cur]        = 0;
+    dev->writes_num[dev->cur] = 0;
 }
 
 const device_t ym3812_nuked_device = {
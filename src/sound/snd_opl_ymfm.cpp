@@ -43,6 +43,8 @@ extern "C" {
 
 #define RSM_FRAC 10
 
+#define YMFM_BATCH 256
+
 #define OPL_FREQ FREQ_48000
 
 enum {
@@ -82,6 +84,7 @@ protected:
     int32_t  m_buffer[MUSICBUFLEN * 2];
     int      m_buf_pos;
     int      *m_buf_pos_global;
+    void    (*m_buf_pos_sync)(void);
     int8_t   m_flags;
     fm_type  m_type;
     uint32_t m_samplerate;
@@ -105,6 +108,7 @@ public:
         m_subtract[1]    = 320.0;
         m_type           = type;
         m_buf_pos_global = (samplerate == FREQ_49716) ? &music_pos_global : &wavetable_pos_global;
+        m_buf_pos_sync   = (samplerate == FREQ_49716) ? music_pos_sync : wavetable_pos_sync;
 
         if (m_type == FM_YMF278B) {
             if (rom_load_linear("roms/sound/yamaha/yrw801.rom", 0, 0x200000, 0, m_yrw801) == 0) {
@@ -149,25 +153,32 @@ public:
         ymfm_set_timer(1, m_duration_in_clocks[1]);
     }
 
+    /* The chip is run a batch at a time into m_output, which also lets it
+       skip whole batches while nothing is sounding. */
     virtual void generate(int32_t *data, uint32_t num_samples) override
     {
-        for (uint32_t i = 0; i < num_samples; i++) {
-            m_chip.generate(&m_output);
-            if ((m_type == FM_YMF278B) && (sizeof(m_output.data) > (4 * sizeof(int32_t)))) {
-                if (ChipType::OUTPUTS == 1) {
-                    *data++ = m_output.data[4];
-                    *data++ = m_output.data[4];
+        while (num_samples > 0) {
+            uint32_t count = (num_samples > YMFM_BATCH) ? YMFM_BATCH : num_samples;
+
+            m_chip.generate(m_output, count);
+            for (uint32_t i = 0; i < count; i++) {
+                if ((m_type == FM_YMF278B) && (sizeof(m_output[i].data) > (4 * sizeof(int32_t)))) {
+                    if (ChipType::OUTPUTS == 1) {
+                        *data++ = m_output[i].data[4];
+                        *data++ = m_output[i].data[4];
+                    } else {
+                        *data++ = m_output[i].data[4];
+                        *data++ = m_output[i].data[5];
+                    }
+                } else if (ChipType::OUTPUTS == 1) {
+                    *data++ = m_output[i].data[0];
+                    *data++ = m_output[i].data[0];
                 } else {
-                    *data++ = m_output.data[4];
-                    *data++ = m_output.data[5];
+                    *data++ = m_output[i].data[0];
+                    *data++ = m_output[i].data[1 % ChipType::OUTPUTS];
                 }
-            } else if (ChipType::OUTPUTS == 1) {
-                *data++ = m_output.data[0];
-                *data++ = m_output.data[0];
-            } else {
-                *data++ = m_output.data[0];
-                *data++ = m_output.data[1 % ChipType::OUTPUTS];
             }
+            num_samples -= count;
         }
     }
 
@@ -183,21 +194,21 @@ public:
             while (m_samplecnt >= m_rateratio) {
                 m_oldsamples[0] = m_samples[0];
                 m_oldsamples[1] = m_samples[1];
-                m_chip.generate(&m_output);
-                if ((m_type == FM_YMF278B) && (sizeof(m_output.data) > (4 * sizeof(int32_t)))) {
+                m_chip.generate(m_output);
+                if ((m_type == FM_YMF278B) && (sizeof(m_output[0].data) > (4 * sizeof(int32_t)))) {
                     if (ChipType::OUTPUTS == 1) {
-                        m_samples[0] = m_output.data[4];
-                        m_samples[1] = m_output.data[4];
+                        m_samples[0] = m_output[0].data[4];
+                        m_samples[1] = m_output[0].data[4];
                     } else {
-                        m_samples[0] = m_output.data[4];
-                        m_samples[1] = m_output.data[5];
+                        m_samples[0] = m_output[0].data[4];
+                        m_samples[1] = m_output[0].data[5];
                     }
                 } else if (ChipType::OUTPUTS == 1) {
-                    m_samples[0] = m_output.data[0];
-                    m_samples[1] = m_output.data[0];
+                    m_samples[0] = m_output[0].data[0];
+                    m_samples[1] = m_output[0].data[0];
                 } else {
-                    m_samples[0] = m_output.data[0];
-                    m_samples[1] = m_output.data[1 % ChipType::OUTPUTS];
+                    m_samples[0] = m_output[0].data[0];
+                    m_samples[1] = m_output[0].data[1 % ChipType::OUTPUTS];
                 }
                 m_samplecnt -= m_rateratio;
             }
@@ -216,6 +227,7 @@ public:
 
     virtual int32_t *update() override
     {
+        m_buf_pos_sync();
         if (m_buf_pos >= *m_buf_pos_global)
             return m_buffer;
 
@@ -269,7 +281,7 @@ private:
     uint32_t                       m_clock;
     double                         m_clock_us;
     double                         m_subtract[2];
-    typename ChipType::output_data m_output;
+    typename ChipType::output_data m_output[YMFM_BATCH];
     pc_timer_t                     m_timers[2];
     int32_t                        m_duration_in_clocks[2]; // Needed for clock switches.
     uint32_t                       m_samplerate;
@@ -1922,6 +1922,7 @@ pas16_input_sysex(void *priv, uint8_t *buffer, uint32_t len, int abort)
 static void
 pas16_update(pas16_t *pas16)
 {
+    sound_pos_sync();
     if (!(pas16->audiofilt & PAS16_FILT_MUTE)) {
         for (; pas16->pos < sound_pos_global; pas16->pos++) {
             pas16->pcm_buffer[0][pas16->pos] = 0;
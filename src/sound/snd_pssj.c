@@ -122,6 +122,7 @@ pssj_read(uint16_t port, void *priv)
 static void
 pssj_update(pssj_t *pssj)
 {
+    sound_pos_sync();
     for (; pssj->pos < sound_pos_global; pssj->pos++)
         pssj->buffer[pssj->pos] = (((int8_t) (pssj->dac_val ^ 0x80) * 0x20) * pssj->amplitude) / 15;
 }
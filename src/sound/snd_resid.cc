@@ -17,13 +17,14 @@ typedef struct psid_t {
 
 psid_t *psid;
 
+/* Interpolation is much cheaper, resampling keeps the aliasing out. */
 void *
-sid_init(void)
+sid_init(int resample)
 {
 #if 0
     psid_t *psid;
 #endif
-    sampling_method method         = SAMPLE_INTERPOLATE;
+    sampling_method method         = resample ? SAMPLE_RESAMPLE_INTERPOLATE : SAMPLE_INTERPOLATE;
     float           cycles_per_sec = 14318180.0 / 16.0;
 
     psid = new psid_t;
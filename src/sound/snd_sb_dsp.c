@@ -771,23 +771,53 @@ sb_16_read_dma(void *priv)
         } else
             /* High DMA channel disabled, always use the first 8-bit channel. */
             dma_ch = dsp->sb_8_dmanum;
-        int temp = dma_channel_read(dma_ch);
-        ret  = temp;
-        if ((temp != DMA_NODATA) && !(temp & DMA_OVER)) {
-            temp = dma_channel_read(dma_ch);
-            if (temp == DMA_NODATA)
+        /* Both bytes in one go; the block ends early on terminal count,
+           where the high byte is not fetched. */
+        int temp[2];
+        switch (dma_channel_read_block(dma_ch, temp, 2)) {
+            case 0:
                 ret = DMA_NODATA;
-            else {
-                const int dma_flags = temp & DMA_OVER;
-                temp &= ~DMA_OVER;
-                ret |= (temp << 8) | dma_flags;
-            }
+                break;
+            case 1:
+                ret = temp[0];
+                break;
+            default:
+                ret = temp[0] | ((temp[1] & ~DMA_OVER) << 8) | (temp[1] & DMA_OVER);
+                break;
         }
     }
 
     return ret;
 }
 
+/* Fetches a stereo pair. On the DSP's own channels both transfers are made
+   in a single block read; a pair split by terminal count takes its second
+   half through the normal path, where auto-init may have restarted it. */
+static void
+sb_dsp_read_pair8(sb_dsp_t *dsp, int *data)
+{
+    int n = 0;
+
+    if ((dsp->dma_readb == sb_8_read_dma) && (dsp->sb_8_dmanum < 4))
+        n = dma_channel_read_block(dsp->sb_8_dmanum, data, 2);
+
+    for (; n < 2; n++)
+        data[n] = dsp->dma_readb(dsp->dma_priv);
+}
+
+static void
+sb_dsp_read_pair16(sb_dsp_t *dsp, int *data)
+{
+    int n = 0;
+
+    if ((dsp->dma_readw == sb_16_read_dma) && dsp->sb_16_dma_enabled && dsp->sb_16_dma_supported &&
+        !dsp->sb_16_dma_translate)
+        n = dma_channel_read_block(dsp->sb_16_dmanum, data, 2);
+
+    for (; n < 2; n++)
+        data[n] = dsp->dma_readw(dsp->dma_priv);
+}
+
 int
 sb_16_write_dma(void *priv, uint16_t val)
 {
@@ -2244,8 +2274,7 @@ pollsb(void *priv)
                 break;
             case 0x20: /* Stereo unsigned */
                 if (!dsp->sb_8_pause) {
-                    data[0] = dsp->dma_readb(dsp->dma_priv);
-                    data[1] = dsp->dma_readb(dsp->dma_priv);
+                    sb_dsp_read_pair8(dsp, data);
                     if ((data[0] == DMA_NODATA) || (data[1] == DMA_NODATA))
                         break;
                     dsp->sbdatl = (int16_t) ((data[0] ^ 0x80) << 8);
@@ -2256,8 +2285,7 @@ pollsb(void *priv)
                 break;
             case 0x30: /* Stereo signed */
                 if (!dsp->sb_8_pause) {
-                    data[0] = dsp->dma_readb(dsp->dma_priv);
-                    data[1] = dsp->dma_readb(dsp->dma_priv);
+                    sb_dsp_read_pair8(dsp, data);
                     if ((data[0] == DMA_NODATA) || (data[1] == DMA_NODATA))
                         break;
                     dsp->sbdatl = (int16_t) (data[0] << 8);
@@ -2631,8 +2659,7 @@ pollsb(void *priv)
                 dsp->ess_dma_counter += 2;
                 break;
             case 0x20: /* Stereo unsigned */
-                data[0] = dsp->dma_readw(dsp->dma_priv);
-                data[1] = dsp->dma_readw(dsp->dma_priv);
+                sb_dsp_read_pair16(dsp, data);
                 if ((data[0] == DMA_NODATA) || (data[1] == DMA_NODATA))
                     break;
                 dsp->sbdatl = (int16_t) ((data[0] & 0xffff) ^ 0x8000);
@@ -2641,8 +2668,7 @@ pollsb(void *priv)
                 dsp->ess_dma_counter += 4;
                 break;
             case 0x30: /* Stereo signed */
-                data[0] = dsp->dma_readw(dsp->dma_priv);
-                data[1] = dsp->dma_readw(dsp->dma_priv);
+                sb_dsp_read_pair16(dsp, data);
                 if ((data[0] == DMA_NODATA) || (data[1] == DMA_NODATA))
                     break;
                 dsp->sbdatl = (int16_t) (data[0] & 0xffff);
@@ -2921,6 +2947,7 @@ sb_poll_i(void *priv)
 void
 sb_dsp_update(sb_dsp_t *dsp)
 {
+    sound_pos_sync();
     if (dsp->muted) {
         dsp->sbdatl = 0;
         dsp->sbdatr = 0;
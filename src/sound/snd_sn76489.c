@@ -24,6 +24,7 @@ static float volslog[16] = {
 void
 sn76489_update(sn76489_t *sn76489)
 {
+    sound_pos_sync();
     for (; sn76489->pos < sound_pos_global; sn76489->pos++) {
         int16_t result = 0;
 
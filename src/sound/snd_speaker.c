@@ -61,6 +61,7 @@ speaker_update(void)
     if (amplitude > 5120.0)
         amplitude = 5120.0;
 
+    sound_pos_sync();
     if (speaker_pos < sound_pos_global) {
         for (; speaker_pos < sound_pos_global; speaker_pos++) {
             if (speaker_gated && was_speaker_enable) {
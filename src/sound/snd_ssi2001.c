@@ -12,36 +12,99 @@
 #include <86box/io.h>
 #include <86box/snd_resid.h>
 #include <86box/sound.h>
+#include <86box/thread.h>
 #include <86box/plat_unused.h>
 
-typedef struct ssi2001_t {
-    void   *psid;
-    int16_t buffer[SOUNDBUFLEN * 2];
+#define SSI2001_WRITES 1024
+
+/* A register write, stamped with its position in the output buffer. */
+typedef struct ssi2001_write_t {
     int     pos;
-    int     gameport_enabled;
+    uint8_t addr;
+    uint8_t val;
+} ssi2001_write_t;
+
+/* With a render worker the SID runs one buffer behind: writes are queued
+   against the buffer being filled, and at the end of each period the worker
+   renders that buffer from the queue while the emulation goes on; the mixer
+   takes the previous one. Reads have to see the chip as it is now, so they
+   wait for the worker and catch up here. */
+typedef struct ssi2001_t {
+    void           *psid;
+    int16_t         buffer[2][SOUNDBUFLEN];
+    int             pos[2];
+    int             cur;
+    int             job;
+    int             render_id;
+    int             writes_num[2];
+    ssi2001_write_t writes[2][SSI2001_WRITES];
+    int             gameport_enabled;
 } ssi2001_t;
 
+/* Renders buffer b up to end, applying its queued writes on the way. */
+static void
+ssi2001_render_to(ssi2001_t *ssi2001, int b, int end)
+{
+    const ssi2001_write_t *w = ssi2001->writes[b];
+
+    for (int i = 0; i < ssi2001->writes_num[b]; i++) {
+        if (w[i].pos > ssi2001->pos[b]) {
+            sid_fillbuf(&ssi2001->buffer[b][ssi2001->pos[b]], w[i].pos - ssi2001->pos[b], ssi2001->psid);
+            ssi2001->pos[b] = w[i].pos;
+        }
+        sid_write(w[i].addr, w[i].val, ssi2001->psid);
+    }
+    ssi2001->writes_num[b] = 0;
+
+    if (end > ssi2001->pos[b]) {
+        sid_fillbuf(&ssi2001->buffer[b][ssi2001->pos[b]], end - ssi2001->pos[b], ssi2001->psid);
+        ssi2001->pos[b] = end;
+    }
+}
+
+static void
+ssi2001_render(void *priv)
+{
+    ssi2001_t *ssi2001 = (ssi2001_t *) priv;
+
+    ssi2001_render_to(ssi2001, ssi2001->job, SOUNDBUFLEN);
+}
+
 static void
 ssi2001_update(ssi2001_t *ssi2001)
 {
-    if (ssi2001->pos >= sound_pos_global)
-        return;
+    sound_pos_sync();
+
+    if (ssi2001->render_id != -1)
+        sound_render_wait(ssi2001->render_id);
 
-    sid_fillbuf(&ssi2001->buffer[ssi2001->pos], sound_pos_global - ssi2001->pos, ssi2001->psid);
-    ssi2001->pos = sound_pos_global;
+    ssi2001_render_to(ssi2001, ssi2001->cur, sound_pos_global);
 }
 
 static void
 ssi2001_get_buffer(int32_t *buffer, int len, void *priv)
 {
     ssi2001_t *ssi2001 = (ssi2001_t *) priv;
+    int        b       = ssi2001->cur;
 
-    ssi2001_update(ssi2001);
+    if (ssi2001->render_id != -1) {
+        sound_render_wait(ssi2001->render_id);
+
+        ssi2001->job = ssi2001->cur;
+        sound_render_request(ssi2001->render_id);
+
+        b = ssi2001->cur ^ 1;
+    } else
+        ssi2001_update(ssi2001);
 
     for (int c = 0; c < len * 2; c++)
-        buffer[c] += ssi2001->buffer[c >> 1] / 2;
+        buffer[c] += ssi2001->buffer[b][c >> 1] / 2;
+
+    if (ssi2001->render_id != -1)
+        ssi2001->cur ^= 1;
 
-    ssi2001->pos = 0;
+    ssi2001->pos[ssi2001->cur]        = 0;
+    ssi2001->writes_num[ssi2001->cur] = 0;
 }
 
 static uint8_t
@@ -57,10 +120,23 @@ ssi2001_read(uint16_t addr, void *priv)
 static void
 ssi2001_write(uint16_t addr, uint8_t val, void *priv)
 {
-    ssi2001_t *ssi2001 = (ssi2001_t *) priv;
+    ssi2001_t       *ssi2001 = (ssi2001_t *) priv;
+    ssi2001_write_t *w;
 
-    ssi2001_update(ssi2001);
-    sid_write(addr, val, priv);
+    if (ssi2001->render_id == -1) {
+        ssi2001_update(ssi2001);
+        sid_write(addr, val, priv);
+        return;
+    }
+
+    sound_pos_sync();
+    if (ssi2001->writes_num[ssi2001->cur] == SSI2001_WRITES)
+        ssi2001_update(ssi2001);
+
+    w       = &ssi2001->writes[ssi2001->cur][ssi2001->writes_num[ssi2001->cur]++];
+    w->pos  = sound_pos_global;
+    w->addr = addr;
+    w->val  = val;
 }
 
 void *
@@ -69,8 +145,12 @@ ssi2001_init(UNUSED(const device_t *info))
     ssi2001_t *ssi2001 = malloc(sizeof(ssi2001_t));
     memset(ssi2001, 0, sizeof(ssi2001_t));
 
-    ssi2001->psid = sid_init();
+    ssi2001->psid = sid_init(device_get_config_int("resample"));
     sid_reset(ssi2001->psid);
+
+    ssi2001->render_id = -1;
+    if (thread_get_cpu_count() >= 2)
+        ssi2001->render_id = sound_render_add(ssi2001_render, ssi2001);
     uint16_t addr             = device_get_config_hex16("base");
     ssi2001->gameport_enabled = device_get_config_int("gameport");
     io_sethandler(addr, 0x0020, ssi2001_read, NULL, NULL, ssi2001_write, NULL, NULL, ssi2001);
@@ -85,6 +165,8 @@ ssi2001_close(void *priv)
 {
     ssi2001_t *ssi2001 = (ssi2001_t *) priv;
 
+    sound_render_remove(ssi2001->render_id);
+
     sid_close(ssi2001->psid);
 
     free(ssi2001);
@@ -121,6 +203,23 @@ static const device_config_t ssi2001_config[] = {
         }
     },
     { "gameport", "Enable Game port", CONFIG_BINARY, "",  1 },
+    {
+        .name = "resample",
+        .description = "Sampling method",
+        .type = CONFIG_SELECTION,
+        .default_int = 0,
+        .selection = {
+            {
+                .description = "Interpolation (fast)",
+                .value = 0
+            },
+            {
+                .description = "Resampling (accurate)",
+                .value = 1
+            },
+            { .description = "" }
+        }
+    },
     { "",         "",                                    -1 }
 // clang-format off
 };
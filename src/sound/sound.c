@@ -22,6 +22,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    define SOUND_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define SOUND_NEON
+#endif
 #define HAVE_STDARG_H
 
 #include <86box/86box.h>
@@ -36,6 +43,10 @@
 #include <86box/timer.h>
 #include <86box/snd_mpu401.h>
 #include <86box/sound.h>
+#include <86box/capture.h>
+#include <86box/device_profile.h>
+#include <86box/trace.h>
+#include <86box/bench.h>
 
 typedef struct {
     const device_t *device;
@@ -51,6 +62,9 @@ int sound_pos_global                   = 0;
 int music_pos_global                   = 0;
 int wavetable_pos_global               = 0;
 int sound_gain                         = 0;
+int sound_low_latency                  = 0;
+
+uint32_t sound_underruns = 0;
 
 static sound_handler_t sound_handlers[8];
 
@@ -66,14 +80,11 @@ static int32_t   *outbuffer;
 static float     *outbuffer_ex;
 static int16_t   *outbuffer_ex_int16;
 static int32_t   *outbuffer_m;
-static float     *outbuffer_m_ex;
-static int16_t   *outbuffer_m_ex_int16;
 static int32_t   *outbuffer_w;
-static float     *outbuffer_w_ex;
-static int16_t   *outbuffer_w_ex_int16;
 static int        sound_handlers_num;
 static int        music_handlers_num;
 static int        wavetable_handlers_num;
+static int        sound_queue_cur = SOUND_QUEUE_DEFAULT;
 static pc_timer_t sound_poll_timer;
 static uint64_t   sound_poll_latch;
 static pc_timer_t music_poll_timer;
@@ -84,6 +95,7 @@ static uint64_t   wavetable_poll_latch;
 static int16_t      cd_buffer[CDROM_NUM][CD_BUFLEN * 2];
 static float        cd_out_buffer[CD_BUFLEN * 2];
 static int16_t      cd_out_buffer_int16[CD_BUFLEN * 2];
+static double       cd_mix_buffer[CD_BUFLEN * 2];
 static unsigned int cd_vol_l;
 static unsigned int cd_vol_r;
 static int          cd_buf_update    = CD_BUFLEN / SOUNDBUFLEN;
@@ -96,6 +108,48 @@ static void *filter_cd_audio_p                                          = NULL;
 void (*filter_pc_speaker)(int channel, double *buffer, void *priv) = NULL;
 void *filter_pc_speaker_p                                          = NULL;
 
+/* Everything that is not produced at SOUND_FREQ by the sound handlers is
+   resampled and queued here, then mixed into the main output buffer, which
+   is the only one handed to the audio backend. */
+#define SOUND_MIX_TAPS    16    /* Per output sample. */
+#define SOUND_MIX_PHASES  256
+#define SOUND_MIX_RING    32768 /* Output frames, a power of two. */
+#define SOUND_MIX_IN      4096  /* Input frames resampled at a time. */
+#define SOUND_MIX_LATENCY SOUNDBUFLEN /* Queued on top of a stream's largest chunk before it starts playing. */
+
+enum {
+    SOUND_STREAM_MUSIC = 0,
+    SOUND_STREAM_WT,
+    SOUND_STREAM_CD,
+    SOUND_STREAM_MIDI,
+
+    SOUND_STREAM_MAX
+};
+
+enum {
+    SOUND_SAMPLES_INT32 = 0,
+    SOUND_SAMPLES_INT16,
+    SOUND_SAMPLES_FLOAT
+};
+
+typedef struct sound_stream_t {
+    int      freq;
+    uint64_t step; /* Input frames per output frame, 32.32. */
+    uint64_t pos;  /* Position of the next output frame in in_buf, 32.32. */
+    int      in_len;
+    int      prefill;
+    int      min_prefill; /* Render-ahead asked for by the producer. */
+    int      started;
+    uint32_t rd; /* Free running ring indices, in frames. */
+    uint32_t wr;
+    float    taps[SOUND_MIX_PHASES * SOUND_MIX_TAPS];
+    float    in_buf[(SOUND_MIX_TAPS + SOUND_MIX_IN) * 2];
+    float    ring[SOUND_MIX_RING * 2];
+} sound_stream_t;
+
+static sound_stream_t *sound_streams[SOUND_STREAM_MAX];
+static mutex_t        *sound_mix_mutex;
+
 static const device_t sound_none_device = {
     .name          = "None",
     .internal_name = "none",
@@ -232,18 +286,20 @@ sound_card_get_internal_name(int card)
     return device_get_internal_name(sound_cards[card].device);
 }
 
+static const char *
+sound_card_get_name(int c)
+{
+    return (sound_cards[c].device != NULL) ? sound_cards[c].device->internal_name : NULL;
+}
+
+static device_name_index_t sound_card_names = { .get_name = sound_card_get_name };
+
 int
 sound_card_get_from_internal_name(const char *s)
 {
-    int c = 0;
-
-    while (sound_cards[c].device != NULL) {
-        if (!strcmp(sound_cards[c].device->internal_name, s))
-            return c;
-        c++;
-    }
+    int c = device_name_index_find(&sound_card_names, s);
 
-    return 0;
+    return (c >= 0) ? c : 0;
 }
 
 void
@@ -266,6 +322,392 @@ sound_set_cd_volume(unsigned int vol_l, unsigned int vol_r)
     cd_vol_r = vol_r;
 }
 
+/* Build the polyphase windowed sinc filter for a stream coming in at freq,
+   with the cutoff below the lower of the two Nyquist frequencies. */
+static void
+sound_stream_set_freq(sound_stream_t *st, int freq)
+{
+    const double fc   = ((freq > SOUND_FREQ) ? ((double) SOUND_FREQ / (double) freq) : 1.0) * 0.95;
+    const double half = (double) (SOUND_MIX_TAPS / 2);
+
+    st->freq = freq;
+    st->step = ((uint64_t) freq << 32) / SOUND_FREQ;
+
+    for (int p = 0; p < SOUND_MIX_PHASES; p++) {
+        float *h   = &st->taps[p * SOUND_MIX_TAPS];
+        double sum = 0.0;
+
+        for (int k = 0; k < SOUND_MIX_TAPS; k++) {
+            const double x = (double) (k - ((SOUND_MIX_TAPS / 2) - 1)) - ((double) p / (double) SOUND_MIX_PHASES);
+            const double u = x / half;
+            const double w = 0.42 + (0.5 * cos(M_PI * u)) + (0.08 * cos(2.0 * M_PI * u));
+            const double t = M_PI * fc * x;
+            const double v = fc * ((x == 0.0) ? 1.0 : (sin(t) / t)) * w;
+
+            h[k] = (float) v;
+            sum += v;
+        }
+        for (int k = 0; k < SOUND_MIX_TAPS; k++)
+            h[k] = (float) (h[k] / sum);
+    }
+}
+
+static void
+sound_streams_reset(void)
+{
+    thread_wait_mutex(sound_mix_mutex);
+    for (int i = 0; i < SOUND_STREAM_MAX; i++) {
+        sound_stream_t *st = sound_streams[i];
+
+        st->pos = 0;
+        st->in_len = 0;
+        st->prefill = MAX(SOUND_MIX_LATENCY, st->min_prefill);
+        st->started = 0;
+        st->rd = st->wr = 0;
+        memset(st->in_buf, 0x00, sizeof(st->in_buf));
+    }
+    thread_release_mutex(sound_mix_mutex);
+}
+
+/* Queue frames stereo frames of a stream, resampled to SOUND_FREQ. Called from
+   whichever thread produces the stream. */
+static void
+sound_stream_push(int stream, const void *buf, int frames, int format)
+{
+    sound_stream_t *st = sound_streams[stream];
+    uint32_t        wr;
+
+    if ((st == NULL) || !st->freq)
+        return;
+
+    thread_wait_mutex(sound_mix_mutex);
+
+    wr = st->wr;
+    while (frames > 0) {
+        const int n   = MIN(frames, (SOUND_MIX_TAPS + SOUND_MIX_IN) - st->in_len);
+        float    *dst = &st->in_buf[st->in_len * 2];
+        int       drop;
+
+        switch (format) {
+            case SOUND_SAMPLES_INT32:
+                for (int c = 0; c < (n * 2); c++)
+                    dst[c] = ((float) ((const int32_t *) buf)[c]) / 32768.0f;
+                buf = (const int32_t *) buf + (n * 2);
+                break;
+            case SOUND_SAMPLES_INT16:
+                for (int c = 0; c < (n * 2); c++)
+                    dst[c] = ((float) ((const int16_t *) buf)[c]) / 32768.0f;
+                buf = (const int16_t *) buf + (n * 2);
+                break;
+            default:
+                memcpy(dst, buf, n * 2 * sizeof(float));
+                buf = (const float *) buf + (n * 2);
+                break;
+        }
+        frames -= n;
+        st->in_len += n;
+
+        while (((int) (st->pos >> 32) + SOUND_MIX_TAPS) <= st->in_len) {
+            const float *x = &st->in_buf[(st->pos >> 32) * 2];
+            const float *h = &st->taps[((st->pos >> 24) & (SOUND_MIX_PHASES - 1)) * SOUND_MIX_TAPS];
+            float       *o = &st->ring[(wr & (SOUND_MIX_RING - 1)) * 2];
+            float        l = 0.0f;
+            float        r = 0.0f;
+
+            for (int k = 0; k < SOUND_MIX_TAPS; k++) {
+                l += x[k * 2] * h[k];
+                r += x[(k * 2) + 1] * h[k];
+            }
+            o[0] = l;
+            o[1] = r;
+            wr++;
+            st->pos += st->step;
+        }
+
+        drop = (int) (st->pos >> 32);
+        memmove(st->in_buf, &st->in_buf[drop * 2], (st->in_len - drop) * 2 * sizeof(float));
+        st->in_len -= drop;
+        st->pos -= (uint64_t) drop << 32;
+    }
+
+    /* Keep enough queued to bridge the gap between two chunks of this size,
+       and drop the oldest frames if the ring overflows. */
+    st->prefill = MAX(st->prefill, MIN((int) (wr - st->wr) + SOUND_MIX_LATENCY, SOUND_MIX_RING / 2));
+    st->wr      = wr;
+    if ((st->wr - st->rd) > SOUND_MIX_RING)
+        st->rd = st->wr - SOUND_MIX_RING;
+
+    thread_release_mutex(sound_mix_mutex);
+}
+
+/* Add whatever the other streams have queued into the main output buffer. A
+   stream that runs dry stops until it has enough queued again. */
+static void
+sound_streams_mix(int32_t *buf, int frames)
+{
+    thread_wait_mutex(sound_mix_mutex);
+    for (int i = 0; i < SOUND_STREAM_MAX; i++) {
+        sound_stream_t *st   = sound_streams[i];
+        const int       fill = (int) (st->wr - st->rd);
+        int             n;
+
+        if (!st->started) {
+            if (!fill || (fill < st->prefill))
+                continue;
+            st->started = 1;
+        }
+
+        n = MIN(fill, frames);
+        for (int c = 0; c < n; c++) {
+            const float *o = &st->ring[(st->rd & (SOUND_MIX_RING - 1)) * 2];
+
+            buf[c * 2] += (int32_t) lrintf(o[0] * 32768.0f);
+            buf[(c * 2) + 1] += (int32_t) lrintf(o[1] * 32768.0f);
+            st->rd++;
+        }
+        if (n < frames)
+            st->started = 0;
+    }
+    thread_release_mutex(sound_mix_mutex);
+}
+
+/* How many SOUNDBUFLEN periods the backend may keep queued. */
+int
+sound_queue_depth(void)
+{
+    return sound_queue_cur;
+}
+
+void
+sound_queue_reset(void)
+{
+    sound_queue_cur = sound_low_latency ? SOUND_QUEUE_MIN : SOUND_QUEUE_DEFAULT;
+    sound_underruns = 0;
+}
+
+/* Called by the backend when its queue ran dry; in the low latency mode each
+   underrun buys one more period of buffering, up to SOUND_QUEUE_MAX. */
+void
+sound_queue_underrun(void)
+{
+    sound_underruns++;
+
+    if (sound_low_latency && (sound_queue_cur < SOUND_QUEUE_MAX))
+        sound_queue_cur++;
+
+    sound_log("Sound: underrun %u, queue depth %i\n", sound_underruns, sound_queue_cur);
+}
+
+/* Render workers.
+
+   The synthesizers that are expensive to run but not tied to the emulated
+   timeline hand their render passes to one small shared pool of threads,
+   instead of each spinning its own or rendering on the emulation thread.
+   Passes for one client never overlap and run in the order requested. */
+#define SOUND_RENDER_CLIENTS 8
+#define SOUND_RENDER_THREADS 4
+
+typedef struct sound_render_client_t {
+    void (*render)(void *priv);
+    void    *priv;
+    int      pending;
+    int      busy;
+    event_t *done_event;
+} sound_render_client_t;
+
+static sound_render_client_t sound_render_clients[SOUND_RENDER_CLIENTS];
+static thread_t             *sound_render_threads[SOUND_RENDER_THREADS];
+static int                   sound_render_threads_num = 0;
+static int                   sound_render_clients_num = 0;
+static int                   sound_render_next        = 0;
+static volatile int          sound_render_run         = 0;
+static mutex_t              *sound_render_mutex       = NULL;
+static event_t              *sound_render_wake_event  = NULL;
+
+static void
+sound_render_thread(UNUSED(void *param))
+{
+    sound_render_client_t *client;
+
+    thread_wait_mutex(sound_render_mutex);
+
+    while (sound_render_run) {
+        client = NULL;
+        for (int i = 0; i < SOUND_RENDER_CLIENTS; i++) {
+            sound_render_client_t *c = &sound_render_clients[(sound_render_next + i) % SOUND_RENDER_CLIENTS];
+
+            if ((c->render != NULL) && c->pending && !c->busy) {
+                client = c;
+                break;
+            }
+        }
+
+        if (client == NULL) {
+            /* Reset under the mutex so a request can not slip in between. */
+            thread_reset_event(sound_render_wake_event);
+            thread_release_mutex(sound_render_mutex);
+            thread_wait_event(sound_render_wake_event, -1);
+            thread_wait_mutex(sound_render_mutex);
+            continue;
+        }
+
+        client->pending--;
+        client->busy      = 1;
+        sound_render_next = (int) ((client - sound_render_clients) + 1) % SOUND_RENDER_CLIENTS;
+        thread_release_mutex(sound_render_mutex);
+
+        client->render(client->priv);
+
+        thread_wait_mutex(sound_render_mutex);
+        client->busy = 0;
+        if (!client->pending)
+            thread_set_event(client->done_event);
+    }
+
+    thread_release_mutex(sound_render_mutex);
+}
+
+/* Returns the client handle, or -1 if the pool is full. */
+int
+sound_render_add(void (*render)(void *priv), void *priv)
+{
+    int id = -1;
+
+    if (sound_render_mutex == NULL) {
+        sound_render_mutex      = thread_create_mutex();
+        sound_render_wake_event = thread_create_event();
+    }
+
+    thread_wait_mutex(sound_render_mutex);
+    for (int i = 0; i < SOUND_RENDER_CLIENTS; i++) {
+        if (sound_render_clients[i].render == NULL) {
+            id = i;
+            break;
+        }
+    }
+
+    if (id != -1) {
+        sound_render_clients[id].render     = render;
+        sound_render_clients[id].priv       = priv;
+        sound_render_clients[id].pending    = 0;
+        sound_render_clients[id].busy       = 0;
+        sound_render_clients[id].done_event = thread_create_event();
+        sound_render_clients_num++;
+    }
+    thread_release_mutex(sound_render_mutex);
+
+    if ((id != -1) && !sound_render_threads_num) {
+        sound_render_threads_num = MIN(SOUND_RENDER_THREADS, MAX(1, thread_get_cpu_count() - 1));
+        sound_render_run         = 1;
+        for (int i = 0; i < sound_render_threads_num; i++)
+            sound_render_threads[i] = thread_create(sound_render_thread, NULL);
+    }
+
+    return id;
+}
+
+void
+sound_render_request(int id)
+{
+    if (id < 0)
+        return;
+
+    thread_wait_mutex(sound_render_mutex);
+    sound_render_clients[id].pending++;
+    thread_reset_event(sound_render_clients[id].done_event);
+    thread_set_event(sound_render_wake_event);
+    thread_release_mutex(sound_render_mutex);
+}
+
+/* Blocks until every pass requested for the client so far has finished. */
+void
+sound_render_wait(int id)
+{
+    sound_render_client_t *client;
+
+    if (id < 0)
+        return;
+
+    client = &sound_render_clients[id];
+
+    thread_wait_mutex(sound_render_mutex);
+    while (client->pending || client->busy) {
+        thread_release_mutex(sound_render_mutex);
+        thread_wait_event(client->done_event, -1);
+        thread_wait_mutex(sound_render_mutex);
+    }
+    thread_release_mutex(sound_render_mutex);
+}
+
+/* Drops any passes still queued, waits out the running one and frees the
+   slot; the last client to go takes the threads down with it. */
+void
+sound_render_remove(int id)
+{
+    if (id < 0)
+        return;
+
+    thread_wait_mutex(sound_render_mutex);
+    sound_render_clients[id].pending = 0;
+    thread_release_mutex(sound_render_mutex);
+
+    sound_render_wait(id);
+
+    thread_wait_mutex(sound_render_mutex);
+    thread_destroy_event(sound_render_clients[id].done_event);
+    memset(&sound_render_clients[id], 0x00, sizeof(sound_render_client_t));
+    sound_render_clients_num--;
+    thread_release_mutex(sound_render_mutex);
+
+    if (!sound_render_clients_num && sound_render_threads_num) {
+        thread_wait_mutex(sound_render_mutex);
+        sound_render_run = 0;
+        thread_set_event(sound_render_wake_event);
+        thread_release_mutex(sound_render_mutex);
+
+        for (int i = 0; i < sound_render_threads_num; i++)
+            thread_wait(sound_render_threads[i]);
+        sound_render_threads_num = 0;
+    }
+}
+
+/* The MIDI renderers hand over their output here, in the output format. */
+void
+al_set_midi(const int freq, UNUSED(const int buf_size))
+{
+    if (sound_streams[SOUND_STREAM_MIDI] == NULL)
+        return;
+
+    thread_wait_mutex(sound_mix_mutex);
+    if (sound_streams[SOUND_STREAM_MIDI]->freq != freq)
+        sound_stream_set_freq(sound_streams[SOUND_STREAM_MIDI], freq);
+    sound_streams[SOUND_STREAM_MIDI]->min_prefill = 0;
+    thread_release_mutex(sound_mix_mutex);
+}
+
+/* Keeps at least ms worth of MIDI output queued before it (re)starts playing,
+   so a renderer that runs late now and then does not drop out; called after
+   al_set_midi(), which clears it. */
+void
+al_set_midi_ahead(const int ms)
+{
+    sound_stream_t *st = sound_streams[SOUND_STREAM_MIDI];
+
+    if (st == NULL)
+        return;
+
+    thread_wait_mutex(sound_mix_mutex);
+    st->min_prefill = MIN((ms * SOUND_FREQ) / 1000, SOUND_MIX_RING / 2);
+    st->prefill     = MAX(st->prefill, st->min_prefill);
+    thread_release_mutex(sound_mix_mutex);
+}
+
+void
+givealbuffer_midi(const void *buf, const uint32_t size)
+{
+    sound_stream_push(SOUND_STREAM_MIDI, buf, (int) (size >> 1), sound_is_float ? SOUND_SAMPLES_FLOAT : SOUND_SAMPLES_INT16);
+}
+
 static void
 sound_cd_clean_buffers(void)
 {
@@ -280,6 +722,7 @@ sound_cd_thread(UNUSED(void *param))
 {
     int      temp_buffer[2];
     int      channel_select[2];
+    int      port_on[2];
     double   audio_vol_l;
     double   audio_vol_r;
     double   cd_buffer_temp[2] = { 0.0, 0.0 };
@@ -323,11 +766,14 @@ sound_cd_thread(UNUSED(void *param))
                 channel_select[1] = 2;
             }
 
+            port_on[0] = (audio_vol_l != 0.0) && (channel_select[0] != 0);
+            port_on[1] = (audio_vol_r != 0.0) && (channel_select[1] != 0);
+
             for (int c = 0; c < CD_BUFLEN * 2; c += 2) {
                 /*Apply ATAPI channel select*/
                 cd_buffer_temp[0] = cd_buffer_temp[1] = 0.0;
 
-                if ((audio_vol_l != 0.0) && (channel_select[0] != 0)) {
+                if (port_on[0]) {
                     if (channel_select[0] & 1)
                         cd_buffer_temp[0] += ((double) cd_buffer[i][c]); /* Channel 0 => Port 0 */
                     if (channel_select[0] & 2)
@@ -339,7 +785,7 @@ sound_cd_thread(UNUSED(void *param))
                         cd_buffer_temp[0] = deemph_iir(0, cd_buffer_temp[0]); /* De-emphasize if necessary */
                 }
 
-                if ((audio_vol_r != 0.0) && (channel_select[1] != 0)) {
+                if (port_on[1]) {
                     if (channel_select[1] & 1)
                         cd_buffer_temp[1] += ((double) cd_buffer[i][c]); /* Channel 0 => Port 1 */
                     if (channel_select[1] & 2)
@@ -357,12 +803,17 @@ sound_cd_thread(UNUSED(void *param))
                     filter_cd_audio(1, &(cd_buffer_temp[1]), filter_cd_audio_p);
                 }
 
-                if (sound_is_float) {
-                    cd_out_buffer[c] += (float) (cd_buffer_temp[0] / 32768.0);
-                    cd_out_buffer[c + 1] += (float) (cd_buffer_temp[1] / 32768.0);
-                } else {
-                    temp_buffer[0] += (int) trunc(cd_buffer_temp[0]);
-                    temp_buffer[1] += (int) trunc(cd_buffer_temp[1]);
+                cd_mix_buffer[c]     = cd_buffer_temp[0];
+                cd_mix_buffer[c + 1] = cd_buffer_temp[1];
+            }
+
+            if (sound_is_float) {
+                for (int c = 0; c < CD_BUFLEN * 2; c++)
+                    cd_out_buffer[c] += (float) (cd_mix_buffer[c] / 32768.0);
+            } else {
+                for (int c = 0; c < CD_BUFLEN * 2; c += 2) {
+                    temp_buffer[0] += (int) trunc(cd_mix_buffer[c]);
+                    temp_buffer[1] += (int) trunc(cd_mix_buffer[c + 1]);
 
                     if (temp_buffer[0] > 32767)
                         temp_buffer[0] = 32767;
@@ -379,10 +830,14 @@ sound_cd_thread(UNUSED(void *param))
             }
         }
 
+        if (capture_active)
+            capture_audio(CAPTURE_AUDIO_CD, sound_is_float ? (void *) cd_out_buffer : (void *) cd_out_buffer_int16,
+                          CD_BUFLEN, sound_is_float ? CAPTURE_SAMPLES_FLOAT : CAPTURE_SAMPLES_INT16);
+
         if (sound_is_float)
-            givealbuffer_cd(cd_out_buffer);
+            sound_stream_push(SOUND_STREAM_CD, cd_out_buffer, CD_BUFLEN, SOUND_SAMPLES_FLOAT);
         else
-            givealbuffer_cd(cd_out_buffer_int16);
+            sound_stream_push(SOUND_STREAM_CD, cd_out_buffer_int16, CD_BUFLEN, SOUND_SAMPLES_INT16);
     }
 }
 
@@ -408,50 +863,6 @@ sound_realloc_buffers(void)
     }
 }
 
-static void
-music_realloc_buffers(void)
-{
-    if (outbuffer_m_ex != NULL) {
-        free(outbuffer_m_ex);
-        outbuffer_m_ex = NULL;
-    }
-
-    if (outbuffer_m_ex_int16 != NULL) {
-        free(outbuffer_m_ex_int16);
-        outbuffer_m_ex_int16 = NULL;
-    }
-
-    if (sound_is_float) {
-        outbuffer_m_ex = calloc(MUSICBUFLEN * 2, sizeof(float));
-        memset(outbuffer_m_ex, 0x00, MUSICBUFLEN * 2 * sizeof(float));
-    } else {
-        outbuffer_m_ex_int16 = calloc(MUSICBUFLEN * 2, sizeof(int16_t));
-        memset(outbuffer_m_ex_int16, 0x00, MUSICBUFLEN * 2 * sizeof(int16_t));
-    }
-}
-
-static void
-wavetable_realloc_buffers(void)
-{
-    if (outbuffer_w_ex != NULL) {
-        free(outbuffer_w_ex);
-        outbuffer_w_ex = NULL;
-    }
-
-    if (outbuffer_w_ex_int16 != NULL) {
-        free(outbuffer_w_ex_int16);
-        outbuffer_w_ex_int16 = NULL;
-    }
-
-    if (sound_is_float) {
-        outbuffer_w_ex = calloc(WTBUFLEN * 2, sizeof(float));
-        memset(outbuffer_w_ex, 0x00, WTBUFLEN * 2 * sizeof(float));
-    } else {
-        outbuffer_w_ex_int16 = calloc(WTBUFLEN * 2, sizeof(int16_t));
-        memset(outbuffer_w_ex_int16, 0x00, WTBUFLEN * 2 * sizeof(int16_t));
-    }
-}
-
 void
 sound_init(void)
 {
@@ -460,12 +871,6 @@ sound_init(void)
     outbuffer_ex       = NULL;
     outbuffer_ex_int16 = NULL;
 
-    outbuffer_m_ex       = NULL;
-    outbuffer_m_ex_int16 = NULL;
-
-    outbuffer_w_ex       = NULL;
-    outbuffer_w_ex_int16 = NULL;
-
     outbuffer = NULL;
     outbuffer = calloc(SOUNDBUFLEN * 2, sizeof(int32_t));
     memset(outbuffer, 0x00, SOUNDBUFLEN * 2 * sizeof(int32_t));
@@ -478,6 +883,14 @@ sound_init(void)
     outbuffer_w = calloc(WTBUFLEN * 2, sizeof(int32_t));
     memset(outbuffer_w, 0x00, WTBUFLEN * 2 * sizeof(int32_t));
 
+    sound_mix_mutex = thread_create_mutex();
+    for (uint8_t i = 0; i < SOUND_STREAM_MAX; i++)
+        sound_streams[i] = calloc(1, sizeof(sound_stream_t));
+    sound_stream_set_freq(sound_streams[SOUND_STREAM_MUSIC], MUSIC_FREQ);
+    sound_stream_set_freq(sound_streams[SOUND_STREAM_WT], WT_FREQ);
+    sound_stream_set_freq(sound_streams[SOUND_STREAM_CD], CD_FREQ);
+    sound_stream_set_freq(sound_streams[SOUND_STREAM_MIDI], FREQ_44100);
+
     for (uint16_t i = 0; i < 256; i++) {
         double di = (double) i;
 
@@ -556,122 +969,215 @@ sound_set_pc_speaker_filter(void (*filter)(int channel, double *buffer, void *pr
     }
 }
 
+/* Convert a mixed buffer of len stereo samples for the output, either to
+   float or clamped to 16 bits. */
+static void
+sound_convert_buffer(const int32_t *buf, float *out_f, int16_t *out_i, int len)
+{
+    int c = 0;
+
+    len *= 2;
+    if (sound_is_float) {
+#if defined(SOUND_SSE2)
+        const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+        for (; c <= (len - 4); c += 4)
+            _mm_storeu_ps(&out_f[c], _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) &buf[c])), scale));
+#elif defined(SOUND_NEON)
+        for (; c <= (len - 4); c += 4)
+            vst1q_f32(&out_f[c], vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(&buf[c])), 1.0f / 32768.0f));
+#endif
+        for (; c < len; c++)
+            out_f[c] = ((float) buf[c]) / (float) 32768.0;
+    } else {
+#if defined(SOUND_SSE2)
+        for (; c <= (len - 8); c += 8) {
+            const __m128i lo = _mm_loadu_si128((const __m128i *) &buf[c]);
+            const __m128i hi = _mm_loadu_si128((const __m128i *) &buf[c + 4]);
+
+            _mm_storeu_si128((__m128i *) &out_i[c], _mm_packs_epi32(lo, hi));
+        }
+#elif defined(SOUND_NEON)
+        for (; c <= (len - 8); c += 8)
+            vst1q_s16(&out_i[c], vcombine_s16(vqmovn_s32(vld1q_s32(&buf[c])), vqmovn_s32(vld1q_s32(&buf[c + 4]))));
+#endif
+        for (; c < len; c++) {
+            if (buf[c] > 32767)
+                out_i[c] = 32767;
+            else if (buf[c] < -32768)
+                out_i[c] = -32768;
+            else
+                out_i[c] = (int16_t) buf[c];
+        }
+    }
+}
+
+/* The poll timers fire once per buffer; in between, the position within the
+   buffer is worked out from the time left until the timer fires, whenever a
+   source wants to catch up to it. */
+static int
+sound_pos_from_timer(pc_timer_t *timer, uint64_t latch, int len, int pos)
+{
+    uint64_t remaining;
+    uint64_t left;
+
+    if (!timer_is_enabled(timer) || !latch)
+        return pos;
+
+    remaining = timer_get_remaining_u64(timer);
+    left      = (remaining + latch - 1) / latch;
+    if (left >= (uint64_t) len)
+        return pos;
+
+    return MAX(pos, MIN(len - (int) left, len - 1));
+}
+
+/* Time at which the current output buffer ends. While the handlers run the
+   poll timer has already moved on to the next buffer, so this is the end of
+   the one being collected. */
+uint64_t
+sound_buf_end_ts(void)
+{
+    if (sound_pos_global == SOUNDBUFLEN)
+        return sound_poll_timer.ts.ts64 - (sound_poll_latch * SOUNDBUFLEN);
+
+    return sound_poll_timer.ts.ts64;
+}
+
+/* Position in the output buffer that a point in time falls on, for sources
+   that catch up on their own clock rather than at the current time. */
+int
+sound_pos_at(uint64_t ts)
+{
+    int64_t  remaining;
+    uint64_t left;
+
+    if (!sound_poll_latch)
+        return 0;
+
+    remaining = (int64_t) (sound_buf_end_ts() - ts);
+    if (remaining < 0)
+        remaining = 0;
+    left = ((uint64_t) remaining + sound_poll_latch - 1) / sound_poll_latch;
+    if (left >= SOUNDBUFLEN)
+        return 0;
+
+    return MIN(SOUNDBUFLEN - (int) left, SOUNDBUFLEN - 1);
+}
+
+void
+sound_pos_sync(void)
+{
+    sound_pos_global = sound_pos_from_timer(&sound_poll_timer, sound_poll_latch, SOUNDBUFLEN, sound_pos_global);
+}
+
+void
+music_pos_sync(void)
+{
+    music_pos_global = sound_pos_from_timer(&music_poll_timer, music_poll_latch, MUSICBUFLEN, music_pos_global);
+}
+
+void
+wavetable_pos_sync(void)
+{
+    wavetable_pos_global = sound_pos_from_timer(&wavetable_poll_timer, wavetable_poll_latch, WTBUFLEN, wavetable_pos_global);
+}
+
 void
 sound_poll(UNUSED(void *priv))
 {
-    timer_advance_u64(&sound_poll_timer, sound_poll_latch);
+    int c;
 
-    midi_poll();
+    timer_advance_u64(&sound_poll_timer, sound_poll_latch * SOUNDBUFLEN);
 
-    sound_pos_global++;
-    if (sound_pos_global == SOUNDBUFLEN) {
-        int c;
+    /* The MIDI renderers count output samples. */
+    for (c = 0; c < SOUNDBUFLEN; c++)
+        midi_poll();
 
-        memset(outbuffer, 0x00, SOUNDBUFLEN * 2 * sizeof(int32_t));
+    sound_pos_global = SOUNDBUFLEN;
 
-        for (c = 0; c < sound_handlers_num; c++)
-            sound_handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, sound_handlers[c].priv);
+    memset(outbuffer, 0x00, SOUNDBUFLEN * 2 * sizeof(int32_t));
 
-        for (c = 0; c < SOUNDBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_ex[c] = ((float) outbuffer[c]) / (float) 32768.0;
-            else {
-                if (outbuffer[c] > 32767)
-                    outbuffer[c] = 32767;
-                if (outbuffer[c] < -32768)
-                    outbuffer[c] = -32768;
+    TRACE_BEGIN(sound, "sound_poll");
+    for (c = 0; c < sound_handlers_num; c++)
+        device_profile_call(DEVICE_PROFILE_SOUND, sound_handlers[c].priv ? sound_handlers[c].priv : (void *) sound_handlers[c].get_buffer,
+                            sound_handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, sound_handlers[c].priv));
+    TRACE_END(sound, "sound_poll");
 
-                outbuffer_ex_int16[c] = (int16_t) outbuffer[c];
-            }
-        }
+    if (capture_active)
+        capture_audio(CAPTURE_AUDIO_SOUND, outbuffer, SOUNDBUFLEN, CAPTURE_SAMPLES_INT32);
+
+    sound_streams_mix(outbuffer, SOUNDBUFLEN);
 
+    sound_convert_buffer(outbuffer, outbuffer_ex, outbuffer_ex_int16, SOUNDBUFLEN);
+
+    /* Unthrottled, the output would only pile up; drop it. */
+    if (!bench_enabled && !max_speed) {
         if (sound_is_float)
             givealbuffer(outbuffer_ex);
         else
             givealbuffer(outbuffer_ex_int16);
+    }
 
-        if (cd_thread_enable) {
-            cd_buf_update--;
-            if (!cd_buf_update) {
-                cd_buf_update = (SOUND_FREQ / SOUNDBUFLEN) / (CD_FREQ / CD_BUFLEN);
-                thread_set_event(sound_cd_event);
-            }
+    if (cd_thread_enable) {
+        cd_buf_update--;
+        if (!cd_buf_update) {
+            cd_buf_update = (SOUND_FREQ / SOUNDBUFLEN) / (CD_FREQ / CD_BUFLEN);
+            thread_set_event(sound_cd_event);
         }
-
-        sound_pos_global = 0;
     }
+
+    sound_pos_global = 0;
 }
 
 void
 music_poll(UNUSED(void *priv))
 {
-    timer_advance_u64(&music_poll_timer, music_poll_latch);
+    int c;
 
-    music_pos_global++;
-    if (music_pos_global == MUSICBUFLEN) {
-        int c;
+    timer_advance_u64(&music_poll_timer, music_poll_latch * MUSICBUFLEN);
 
-        memset(outbuffer_m, 0x00, MUSICBUFLEN * 2 * sizeof(int32_t));
+    music_pos_global = MUSICBUFLEN;
 
-        for (c = 0; c < music_handlers_num; c++)
-            music_handlers[c].get_buffer(outbuffer_m, MUSICBUFLEN, music_handlers[c].priv);
+    memset(outbuffer_m, 0x00, MUSICBUFLEN * 2 * sizeof(int32_t));
 
-        for (c = 0; c < MUSICBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_m_ex[c] = ((float) outbuffer_m[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_m[c] > 32767)
-                    outbuffer_m[c] = 32767;
-                if (outbuffer_m[c] < -32768)
-                    outbuffer_m[c] = -32768;
+    TRACE_BEGIN(sound, "music_poll");
+    for (c = 0; c < music_handlers_num; c++)
+        device_profile_call(DEVICE_PROFILE_SOUND, music_handlers[c].priv ? music_handlers[c].priv : (void *) music_handlers[c].get_buffer,
+                            music_handlers[c].get_buffer(outbuffer_m, MUSICBUFLEN, music_handlers[c].priv));
+    TRACE_END(sound, "music_poll");
 
-                outbuffer_m_ex_int16[c] = (int16_t) outbuffer_m[c];
-            }
-        }
+    if (capture_active)
+        capture_audio(CAPTURE_AUDIO_MUSIC, outbuffer_m, MUSICBUFLEN, CAPTURE_SAMPLES_INT32);
 
-        if (sound_is_float)
-            givealbuffer_music(outbuffer_m_ex);
-        else
-            givealbuffer_music(outbuffer_m_ex_int16);
+    sound_stream_push(SOUND_STREAM_MUSIC, outbuffer_m, MUSICBUFLEN, SOUND_SAMPLES_INT32);
 
-        music_pos_global = 0;
-    }
+    music_pos_global = 0;
 }
 
 void
 wavetable_poll(UNUSED(void *priv))
 {
-    timer_advance_u64(&wavetable_poll_timer, wavetable_poll_latch);
+    int c;
 
-    wavetable_pos_global++;
-    if (wavetable_pos_global == WTBUFLEN) {
-        int c;
+    timer_advance_u64(&wavetable_poll_timer, wavetable_poll_latch * WTBUFLEN);
 
-        memset(outbuffer_w, 0x00, WTBUFLEN * 2 * sizeof(int32_t));
+    wavetable_pos_global = WTBUFLEN;
 
-        for (c = 0; c < wavetable_handlers_num; c++)
-            wavetable_handlers[c].get_buffer(outbuffer_w, WTBUFLEN, wavetable_handlers[c].priv);
+    memset(outbuffer_w, 0x00, WTBUFLEN * 2 * sizeof(int32_t));
 
-        for (c = 0; c < WTBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_w_ex[c] = ((float) outbuffer_w[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_w[c] > 32767)
-                    outbuffer_w[c] = 32767;
-                if (outbuffer_w[c] < -32768)
-                    outbuffer_w[c] = -32768;
+    TRACE_BEGIN(sound, "wavetable_poll");
+    for (c = 0; c < wavetable_handlers_num; c++)
+        device_profile_call(DEVICE_PROFILE_SOUND, wavetable_handlers[c].priv ? wavetable_handlers[c].priv : (void *) wavetable_handlers[c].get_buffer,
+                            wavetable_handlers[c].get_buffer(outbuffer_w, WTBUFLEN, wavetable_handlers[c].priv));
+    TRACE_END(sound, "wavetable_poll");
 
-                outbuffer_w_ex_int16[c] = (int16_t) outbuffer_w[c];
-            }
-        }
+    if (capture_active)
+        capture_audio(CAPTURE_AUDIO_WT, outbuffer_w, WTBUFLEN, CAPTURE_SAMPLES_INT32);
 
-        if (sound_is_float)
-            givealbuffer_wt(outbuffer_w_ex);
-        else
-            givealbuffer_wt(outbuffer_w_ex_int16);
+    sound_stream_push(SOUND_STREAM_WT, outbuffer_w, WTBUFLEN, SOUND_SAMPLES_INT32);
 
-        wavetable_pos_global = 0;
-    }
+    wavetable_pos_global = 0;
 }
 
 void
@@ -689,9 +1195,7 @@ sound_reset(void)
 {
     sound_realloc_buffers();
 
-    music_realloc_buffers();
-
-    wavetable_realloc_buffers();
+    sound_streams_reset();
 
     midi_out_device_init();
     midi_in_device_init();
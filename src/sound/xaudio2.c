@@ -30,7 +30,6 @@
 #endif
 
 #include <86box/86box.h>
-#include <86box/midi.h>
 #include <86box/plat_dynld.h>
 #include <86box/sound.h>
 #include <86box/plat_unused.h>
@@ -45,16 +44,11 @@ static dllimp_t xaudio2_imports[] = {
 #    define XAudio2Create pXAudio2Create
 #endif
 
-static int                     midi_freq     = FREQ_44100;
-static int                     midi_buf_size = 4410;
-static int                     initialized   = 0;
-static IXAudio2               *xaudio2       = NULL;
-static IXAudio2MasteringVoice *mastervoice   = NULL;
-static IXAudio2SourceVoice    *srcvoice      = NULL;
-static IXAudio2SourceVoice    *srcvoicemusic = NULL;
-static IXAudio2SourceVoice    *srcvoicewt    = NULL;
-static IXAudio2SourceVoice    *srcvoicemidi  = NULL;
-static IXAudio2SourceVoice    *srcvoicecd    = NULL;
+static int                     initialized = 0;
+static IXAudio2               *xaudio2     = NULL;
+static IXAudio2MasteringVoice *mastervoice = NULL;
+static IXAudio2SourceVoice    *srcvoice    = NULL;
+static int                     submitted   = 0;
 
 #define FREQ   SOUND_FREQ
 #define BUFLEN SOUNDBUFLEN
@@ -166,39 +160,11 @@ inital(void)
         return;
     }
 
-    fmt.nSamplesPerSec  = MUSIC_FREQ;
-    fmt.nBlockAlign     = fmt.nChannels * fmt.wBitsPerSample / 8;
-    fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
-
-    (void) IXAudio2_CreateSourceVoice(xaudio2, &srcvoicemusic, &fmt, 0, 2.0f, &callbacks, NULL, NULL);
-
-    fmt.nSamplesPerSec  = WT_FREQ;
-    fmt.nBlockAlign     = fmt.nChannels * fmt.wBitsPerSample / 8;
-    fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
-
-    (void) IXAudio2_CreateSourceVoice(xaudio2, &srcvoicewt, &fmt, 0, 2.0f, &callbacks, NULL, NULL);
-
-    fmt.nSamplesPerSec  = CD_FREQ;
-    fmt.nBlockAlign     = fmt.nChannels * fmt.wBitsPerSample / 8;
-    fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
-
-    (void) IXAudio2_CreateSourceVoice(xaudio2, &srcvoicecd, &fmt, 0, 2.0f, &callbacks, NULL, NULL);
-
     (void) IXAudio2SourceVoice_SetVolume(srcvoice, 1, XAUDIO2_COMMIT_NOW);
     (void) IXAudio2SourceVoice_Start(srcvoice, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_Start(srcvoicecd, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_Start(srcvoicemusic, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_Start(srcvoicewt, 0, XAUDIO2_COMMIT_NOW);
-
-    const char *mdn = midi_out_device_get_internal_name(midi_output_device_current);
 
-    if ((strcmp(mdn, "none") != 0) && (strcmp(mdn, SYSTEM_MIDI_INTERNAL_NAME) != 0)) {
-        fmt.nSamplesPerSec  = midi_freq;
-        fmt.nBlockAlign     = fmt.nChannels * fmt.wBitsPerSample / 8;
-        fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
-        (void) IXAudio2_CreateSourceVoice(xaudio2, &srcvoicemidi, &fmt, 0, 2.0f, &callbacks, NULL, NULL);
-        (void) IXAudio2SourceVoice_Start(srcvoicemidi, 0, XAUDIO2_COMMIT_NOW);
-    }
+    sound_queue_reset();
+    submitted = 0;
 
     initialized = 1;
     atexit(closeal);
@@ -212,26 +178,12 @@ closeal(void)
     initialized = 0;
     (void) IXAudio2SourceVoice_Stop(srcvoice, 0, XAUDIO2_COMMIT_NOW);
     (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoice);
-    (void) IXAudio2SourceVoice_Stop(srcvoicemusic, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoicemusic);
-    (void) IXAudio2SourceVoice_Stop(srcvoicewt, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoicewt);
-    (void) IXAudio2SourceVoice_Stop(srcvoicecd, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoicecd);
-    if (srcvoicemidi) {
-        (void) IXAudio2SourceVoice_Stop(srcvoicemidi, 0, XAUDIO2_COMMIT_NOW);
-        (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoicemidi);
-        IXAudio2SourceVoice_DestroyVoice(srcvoicemidi);
-    }
-    IXAudio2SourceVoice_DestroyVoice(srcvoicewt);
-    IXAudio2SourceVoice_DestroyVoice(srcvoicecd);
-    IXAudio2SourceVoice_DestroyVoice(srcvoicemusic);
     IXAudio2SourceVoice_DestroyVoice(srcvoice);
     IXAudio2MasteringVoice_DestroyVoice(mastervoice);
     IXAudio2_Release(xaudio2);
-    srcvoice = srcvoicecd = srcvoicemidi = NULL;
-    mastervoice                          = NULL;
-    xaudio2                              = NULL;
+    srcvoice    = NULL;
+    mastervoice = NULL;
+    xaudio2     = NULL;
 
 #if defined(_WIN32) && !defined(USE_FAUDIO)
     dynld_close(xaudio2_handle);
@@ -242,9 +194,21 @@ closeal(void)
 void
 givealbuffer_common(const void *buf, IXAudio2SourceVoice *sourcevoice, const size_t buflen)
 {
+    XAUDIO2_VOICE_STATE state;
+
     if (!initialized)
         return;
 
+    /* Same queue controller as the OpenAL backend: drop the period when the
+       voice already holds enough, count an underrun when it holds none. */
+    IXAudio2SourceVoice_GetState(sourcevoice, &state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+    if (state.BuffersQueued == 0) {
+        if (submitted)
+            sound_queue_underrun();
+    }
+    else if (state.BuffersQueued >= (uint32_t) sound_queue_depth())
+        return;
+
     (void) IXAudio2MasteringVoice_SetVolume(mastervoice, pow(10.0, (double) sound_gain / 20.0),
                                             XAUDIO2_COMMIT_NOW);
     XAUDIO2_BUFFER buffer = { 0 };
@@ -264,6 +228,7 @@ givealbuffer_common(const void *buf, IXAudio2SourceVoice *sourcevoice, const siz
     buffer.PlayLength                    = buflen >> 1;
     buffer.pContext                      = (void *) buffer.pAudioData;
     (void) IXAudio2SourceVoice_SubmitSourceBuffer(sourcevoice, &buffer, NULL);
+    submitted = 1;
 }
 
 void
@@ -271,57 +236,3 @@ givealbuffer(const void *buf)
 {
     givealbuffer_common(buf, srcvoice, BUFLEN << 1);
 }
-
-void
-givealbuffer_music(const void *buf)
-{
-    givealbuffer_common(buf, srcvoicemusic, MUSICBUFLEN << 1);
-}
-
-void
-givealbuffer_wt(const void *buf)
-{
-    givealbuffer_common(buf, srcvoicewt, WTBUFLEN << 1);
-}
-
-void
-givealbuffer_cd(const void *buf)
-{
-    if (srcvoicecd)
-        givealbuffer_common(buf, srcvoicecd, CD_BUFLEN << 1);
-}
-
-void
-al_set_midi(const int freq, const int buf_size)
-{
-    midi_freq     = freq;
-    midi_buf_size = buf_size;
-
-    if (initialized && srcvoicemidi) {
-        (void) IXAudio2SourceVoice_Stop(srcvoicemidi, 0, XAUDIO2_COMMIT_NOW);
-        (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoicemidi);
-        IXAudio2SourceVoice_DestroyVoice(srcvoicemidi);
-        srcvoicemidi = NULL;
-        WAVEFORMATEX fmt;
-        fmt.nChannels = 2;
-        if (sound_is_float) {
-            fmt.wFormatTag     = WAVE_FORMAT_IEEE_FLOAT;
-            fmt.wBitsPerSample = 32;
-        } else {
-            fmt.wFormatTag     = WAVE_FORMAT_PCM;
-            fmt.wBitsPerSample = 16;
-        }
-        fmt.nSamplesPerSec  = midi_freq;
-        fmt.nBlockAlign     = fmt.nChannels * fmt.wBitsPerSample / 8;
-        fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
-        fmt.cbSize          = 0;
-        (void) IXAudio2_CreateSourceVoice(xaudio2, &srcvoicemidi, &fmt, 0, 2.0f, &callbacks, NULL, NULL);
-        (void) IXAudio2SourceVoice_Start(srcvoicemidi, 0, XAUDIO2_COMMIT_NOW);
-    }
-}
-
-void
-givealbuffer_midi(const void *buf, const uint32_t size)
-{
-    givealbuffer_common(buf, srcvoicemidi, size);
-}
@@ -190,6 +190,16 @@ public:
 	// master clocking function
 	void clock(uint32_t env_counter, int32_t lfo_raw_pm);
 
+	// true if released to full attenuation, where only the phase still moves
+	bool idle() const
+	{
+		return (m_env_state == (RegisterType::EG_HAS_REVERB ? EG_REVERB : EG_RELEASE) &&
+				m_env_attenuation == 0x3ff && !m_regs.op_ssg_eg_enable(m_opoffs));
+	}
+
+	// clocking function for an idle operator, over several samples
+	void clock_idle(int32_t const *lfo_raw_pm, uint32_t numsamples);
+
 	// return the current phase value
 	uint32_t phase() const { return m_phase >> 10; }
 
@@ -282,6 +292,9 @@ public:
 	// master clocking function
 	void clock(uint32_t env_counter, int32_t lfo_raw_pm);
 
+	// clocking function for an idle channel, over several samples
+	void clock_idle(int32_t const *lfo_raw_pm, uint32_t numsamples);
+
 	// specific 2-operator and 4-operator output handlers
 	void output_2op(output_data &output, uint32_t rshift, int32_t clipmax) const;
 	void output_4op(output_data &output, uint32_t rshift, int32_t clipmax) const;
@@ -372,6 +385,12 @@ public:
 	// master clocking function
 	uint32_t clock(uint32_t chanmask);
 
+	// true if nothing is sounding and nothing will until the next write
+	bool idle() const;
+
+	// clock an idle engine over several samples, the output being silence
+	void clock_idle(uint32_t numsamples);
+
 	// compute sum of channel outputs
 	void output(output_data &output, uint32_t rshift, int32_t clipmax, uint32_t chanmask) const;
 
@@ -759,6 +759,25 @@ void fm_operator<RegisterType>::clock_phase(int32_t lfo_raw_pm)
 }
 
 
+//-------------------------------------------------
+//  clock_idle - clock an idle operator; the
+//  envelope has nowhere to go, so this is only
+//  the phase, in one step unless PM is active
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_operator<RegisterType>::clock_idle(int32_t const *lfo_raw_pm, uint32_t numsamples)
+{
+	m_ssg_inverted = false;
+
+	if (m_cache.phase_step != opdata_cache::PHASE_STEP_DYNAMIC)
+		m_phase += m_cache.phase_step * numsamples;
+	else
+		for (uint32_t samp = 0; samp < numsamples; samp++)
+			clock_phase(lfo_raw_pm[samp]);
+}
+
+
 //-------------------------------------------------
 //  envelope_attenuation - return the effective
 //  attenuation of the envelope
@@ -903,6 +922,27 @@ printf(" -- ");
 }
 
 
+//-------------------------------------------------
+//  clock_idle - clock all operators of an idle
+//  channel over several samples
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_channel<RegisterType>::clock_idle(int32_t const *lfo_raw_pm, uint32_t numsamples)
+{
+	// the feedback input is not updated while idle, so it just shifts through
+	for (uint32_t samp = 0; samp < numsamples && samp < 2; samp++)
+	{
+		m_feedback[0] = m_feedback[1];
+		m_feedback[1] = m_feedback_in;
+	}
+
+	for (uint32_t opnum = 0; opnum < array_size(m_op); opnum++)
+		if (m_op[opnum] != nullptr)
+			m_op[opnum]->clock_idle(lfo_raw_pm, numsamples);
+}
+
+
 //-------------------------------------------------
 //  output_2op - combine 4 operators according to
 //  the specified algorithm, returning a sum
@@ -1321,6 +1361,67 @@ uint32_t fm_engine_base<RegisterType>::clock(uint32_t chanmask)
 }
 
 
+//-------------------------------------------------
+//  idle - return true if no operator can produce
+//  any output until registers are written again
+//-------------------------------------------------
+
+template<class RegisterType>
+bool fm_engine_base<RegisterType>::idle() const
+{
+	// a pending write still needs a prepare, and the outputs of channels
+	// still marked active feed back into them
+	if (m_modified_channels != 0 || m_active_channels != 0)
+		return false;
+
+	for (uint32_t opnum = 0; opnum < OPERATORS; opnum++)
+		if (!m_operator[opnum]->idle())
+			return false;
+
+	return true;
+}
+
+
+//-------------------------------------------------
+//  clock_idle - clock an idle engine over several
+//  samples; leaves the same state as calling
+//  clock() that many times, without the envelope
+//  and output work
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_engine_base<RegisterType>::clock_idle(uint32_t numsamples)
+{
+	int32_t lfo_raw_pm[256];
+
+	while (numsamples != 0)
+	{
+		uint32_t count = std::min<uint32_t>(numsamples, array_size(lfo_raw_pm));
+
+		for (uint32_t samp = 0; samp < count; samp++)
+		{
+			m_total_clocks++;
+
+			// the periodic prepare finds nothing to do while idle
+			if (m_prepare_count++ >= 4096)
+				m_prepare_count = 0;
+
+			if (RegisterType::EG_CLOCK_DIVIDER == 1)
+				m_env_counter += 4;
+			else if (bitfield(++m_env_counter, 0, 2) == RegisterType::EG_CLOCK_DIVIDER)
+				m_env_counter += 4 - RegisterType::EG_CLOCK_DIVIDER;
+
+			lfo_raw_pm[samp] = m_regs.clock_noise_and_lfo();
+		}
+
+		for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
+			m_channel[chnum]->clock_idle(lfo_raw_pm, count);
+
+		numsamples -= count;
+	}
+}
+
+
 //-------------------------------------------------
 //  output - compute a sum over the relevant
 //  channels
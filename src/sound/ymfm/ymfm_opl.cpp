@@ -1228,6 +1228,15 @@ void ym3812::write(uint32_t offset, uint8_t data)
 
 void ym3812::generate(output_data *output, uint32_t numsamples)
 {
+	// nothing sounding, the output of every sample is zero
+	if (m_fm.idle())
+	{
+		m_fm.clock_idle(numsamples);
+		for (uint32_t samp = 0; samp < numsamples; samp++, output++)
+			output->clear();
+		return;
+	}
+
 	for (uint32_t samp = 0; samp < numsamples; samp++, output++)
 	{
 		// clock the system
@@ -1401,6 +1410,15 @@ void ymf262::write(uint32_t offset, uint8_t data)
 
 void ymf262::generate(output_data *output, uint32_t numsamples)
 {
+	// nothing sounding, the output of every sample is zero
+	if (m_fm.idle())
+	{
+		m_fm.clock_idle(numsamples);
+		for (uint32_t samp = 0; samp < numsamples; samp++, output++)
+			output->clear();
+		return;
+	}
+
 	for (uint32_t samp = 0; samp < numsamples; samp++, output++)
 	{
 		// clock the system
@@ -1604,6 +1622,15 @@ void ymf289b::write(uint32_t offset, uint8_t data)
 
 void ymf289b::generate(output_data *output, uint32_t numsamples)
 {
+	// nothing sounding, the output of every sample is zero
+	if (m_fm.idle())
+	{
+		m_fm.clock_idle(numsamples);
+		for (uint32_t samp = 0; samp < numsamples; samp++, output++)
+			output->clear();
+		return;
+	}
+
 	for (uint32_t samp = 0; samp < numsamples; samp++, output++)
 	{
 		// clock the system
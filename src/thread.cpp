@@ -1,16 +1,39 @@
+#include <atomic>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#    include <immintrin.h>
+#endif
 
 #include <86box/plat.h>
 #include <86box/thread.h>
 
+/*
+ * The state is only ever changed from clear to set with the mutex held,
+ * so that a waiter cannot miss the notification, but it is read without
+ * it: setting an event that is already set and waiting on one that is
+ * set cost no lock at all, which is what the producer/consumer pairs do
+ * most of the time. The condition variable is only signalled when some
+ * thread is actually blocked on it.
+ */
 struct event_cpp11_t {
     std::condition_variable cond;
     std::mutex              mutex;
-    bool                    state = false;
+    std::atomic<bool>       state { false };
+    int                     waiters = 0;
 };
 
+static inline void
+thread_cpu_relax()
+{
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
 extern "C" {
 
 thread_t *
@@ -18,6 +41,7 @@ thread_create_named(void (*thread_rout)(void *param), void *param, const char *n
 {
     auto thread = new std::thread([thread_rout, param, name] {
         plat_set_thread_name(NULL, name);
+        thread_placement_apply(name);
         thread_rout(param);
     });
     return thread;
@@ -79,6 +103,14 @@ thread_close_mutex(mutex_t *_mutex)
     delete mutex;
 }
 
+int
+thread_get_cpu_count(void)
+{
+    unsigned int count = std::thread::hardware_concurrency();
+
+    return (count > 0) ? (int) count : 1;
+}
+
 event_t *
 thread_create_event()
 {
@@ -90,42 +122,62 @@ int
 thread_wait_event(event_t *handle, int timeout)
 {
     auto event = reinterpret_cast<event_cpp11_t *>(handle);
-    auto lock  = std::unique_lock<std::mutex>(event->mutex);
 
-    if (timeout < 0) {
-        event->cond.wait(lock, [event] { return event->state; });
-    } else {
-        auto           to = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout);
-        std::cv_status status;
+    if (event->state.load(std::memory_order_acquire))
+        return 0;
+
+    auto lock = std::unique_lock<std::mutex>(event->mutex);
+    int  ret  = 0;
+
+    event->waiters++;
+    if (timeout < 0)
+        event->cond.wait(lock, [event] { return event->state.load(std::memory_order_acquire); });
+    else if (!event->cond.wait_for(lock, std::chrono::milliseconds(timeout),
+                                   [event] { return event->state.load(std::memory_order_acquire); }))
+        ret = 1;
+    event->waiters--;
 
-        do {
-            status = event->cond.wait_until(lock, to);
-        } while ((status != std::cv_status::timeout) && !event->state);
+    return ret;
+}
+
+int
+thread_wait_event_spin(event_t *handle, int timeout, int spins)
+{
+    auto event = reinterpret_cast<event_cpp11_t *>(handle);
 
-        if (status == std::cv_status::timeout) {
-            return 1;
-        }
+    for (int c = 0; c < spins; c++) {
+        if (event->state.load(std::memory_order_acquire))
+            return 0;
+        thread_cpu_relax();
     }
-    return 0;
+
+    return thread_wait_event(handle, timeout);
 }
 
 void
 thread_set_event(event_t *handle)
 {
     auto event = reinterpret_cast<event_cpp11_t *>(handle);
+    int  waiters;
+
+    if (event->state.load(std::memory_order_acquire))
+        return;
+
     {
         auto lock    = std::unique_lock<std::mutex>(event->mutex);
-        event->state = true;
+        event->state.store(true, std::memory_order_release);
+        waiters = event->waiters;
     }
-    event->cond.notify_all();
+    if (waiters)
+        event->cond.notify_all();
 }
 
 void
 thread_reset_event(event_t *handle)
 {
-    auto event   = reinterpret_cast<event_cpp11_t *>(handle);
-    auto lock    = std::unique_lock<std::mutex>(event->mutex);
-    event->state = false;
+    auto event = reinterpret_cast<event_cpp11_t *>(handle);
+
+    event->state.store(false, std::memory_order_release);
 }
 
 void
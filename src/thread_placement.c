@@ -0,0 +1,254 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Host CPU placement and priority of the emulator threads.
+ *
+ *          Threads are sorted into classes by the name they were created
+ *          with; each class can be given a list of host CPUs to run on
+ *          ("0-3,8") and a priority ("low", "normal" or "high"), from the
+ *          configuration file. A thread applies its own settings when it
+ *          starts.
+ *
+ *          By default, on Linux, the CPU thread and the FIFO threads fed
+ *          by it are kept on the cores sharing the last level cache with
+ *          the core the first of them started on, so that on multi-socket
+ *          and multi-complex hosts they do not migrate away from each
+ *          other; every other thread floats freely.
+ *
+ *
+ *
+ * Authors: The 86Box development team
+ *
+ *          Copyright 2024 The 86Box development team
+ */
+#ifdef __linux__
+#    ifndef _GNU_SOURCE
+#        define _GNU_SOURCE
+#    endif
+#    include <sched.h>
+#    include <unistd.h>
+#    include <sys/resource.h>
+#    include <sys/syscall.h>
+#endif
+#if defined WIN32 || defined _WIN32
+#    include <windows.h>
+#endif
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+
+#define THREAD_CPUS_MAX 256
+
+char thread_class_cpus[THREAD_CLASS_MAX][THREAD_CPUS_LEN];
+int  thread_class_priority[THREAD_CLASS_MAX];
+
+const char *thread_class_names[THREAD_CLASS_MAX] = {
+    "other", "cpu", "blit", "voodoo_render", "voodoo_fifo", "sound", "net"
+};
+
+static const struct {
+    const char *name;
+    int         prefix;
+    int         class;
+} thread_class_map[] = {
+    { "main_thread",         0, THREAD_CLASS_CPU           },
+    { "main_thread_fn",      0, THREAD_CLASS_CPU           },
+    { "blit_thread",         0, THREAD_CLASS_BLIT          },
+    { "render_thread",       0, THREAD_CLASS_VOODOO_RENDER },
+    { "voodoo_fifo_thread",  0, THREAD_CLASS_VOODOO_FIFO   },
+    { "sound_",              1, THREAD_CLASS_SOUND         },
+    { "net_",                1, THREAD_CLASS_NET           },
+    { NULL,                  0, THREAD_CLASS_OTHER         }
+};
+
+/* The shared cache complex picked for the CPU and FIFO threads. */
+static uint64_t complex_set[THREAD_CPUS_MAX / 64];
+static int      complex_known = 0;
+
+#ifdef ENABLE_THREAD_PLACEMENT_LOG
+int thread_placement_do_log = ENABLE_THREAD_PLACEMENT_LOG;
+
+static void
+thread_placement_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (thread_placement_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define thread_placement_log(fmt, ...)
+#endif
+
+static int
+thread_classify(const char *name)
+{
+    int i;
+
+    if (name == NULL)
+        return THREAD_CLASS_OTHER;
+
+    for (i = 0; thread_class_map[i].name != NULL; i++) {
+        if (thread_class_map[i].prefix) {
+            if (!strncmp(name, thread_class_map[i].name, strlen(thread_class_map[i].name)))
+                break;
+        } else if (!strcmp(name, thread_class_map[i].name))
+            break;
+    }
+
+    return thread_class_map[i].class;
+}
+
+/* Parses a list like "0-3,8" into a bit set, returns the number of CPUs in it. */
+static int
+thread_parse_cpus(const char *str, uint64_t *set)
+{
+    const char *p = str;
+    char       *end;
+    long        first;
+    long        last;
+    int         count = 0;
+
+    memset(set, 0x00, (THREAD_CPUS_MAX / 64) * sizeof(uint64_t));
+
+    while (*p != '\0') {
+        while (isspace((unsigned char) *p) || (*p == ','))
+            p++;
+        if (*p == '\0')
+            break;
+
+        first = strtol(p, &end, 10);
+        if (end == p)
+            return 0;
+        p    = end;
+        last = first;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p)
+                return 0;
+            p = end;
+        }
+
+        for (long c = first; (c <= last) && (c < THREAD_CPUS_MAX); c++) {
+            if ((c >= 0) && !(set[c >> 6] & (1ULL << (c & 63)))) {
+                set[c >> 6] |= (1ULL << (c & 63));
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+static void
+thread_find_complex(void)
+{
+#ifdef __linux__
+    char  path[128];
+    char  list[256];
+    FILE *fp;
+    int   cpu = sched_getcpu();
+
+    complex_known = -1;
+    if (cpu < 0)
+        return;
+
+    /* index3 is the L3 on every x86 and most ARM hosts, fall back to the L2. */
+    for (int index = 3; index >= 2; index--) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%i/cache/index%i/shared_cpu_list", cpu, index);
+        fp = fopen(path, "r");
+        if (fp == NULL)
+            continue;
+
+        if ((fgets(list, sizeof(list), fp) != NULL) && thread_parse_cpus(list, complex_set)) {
+            fclose(fp);
+            thread_placement_log("THREAD: CPU and FIFO threads kept on CPUs %s", list);
+            complex_known = 1;
+            return;
+        }
+        fclose(fp);
+    }
+#else
+    complex_known = -1;
+#endif
+}
+
+static void
+thread_set_affinity(const uint64_t *set)
+{
+#ifdef __linux__
+    cpu_set_t cpus;
+
+    CPU_ZERO(&cpus);
+    for (int c = 0; (c < THREAD_CPUS_MAX) && (c < CPU_SETSIZE); c++) {
+        if (set[c >> 6] & (1ULL << (c & 63)))
+            CPU_SET(c, &cpus);
+    }
+
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+        pclog("THREAD: unable to set the CPU affinity\n");
+#elif defined WIN32 || defined _WIN32
+    DWORD_PTR mask = (DWORD_PTR) set[0];
+
+    if ((mask == 0) || !SetThreadAffinityMask(GetCurrentThread(), mask))
+        pclog("THREAD: unable to set the CPU affinity\n");
+#else
+    (void) set;
+#endif
+}
+
+static void
+thread_set_priority(int priority)
+{
+#ifdef __linux__
+    /* Per thread nice value; raising it above normal needs CAP_SYS_NICE. */
+    if (setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), (priority > 0) ? -5 : 10) != 0)
+        pclog("THREAD: unable to set the priority\n");
+#elif defined WIN32 || defined _WIN32
+    if (!SetThreadPriority(GetCurrentThread(), (priority > 0) ? THREAD_PRIORITY_ABOVE_NORMAL : THREAD_PRIORITY_BELOW_NORMAL))
+        pclog("THREAD: unable to set the priority\n");
+#else
+    (void) priority;
+#endif
+}
+
+/* Called by every new thread, with the name it was created with. */
+void
+thread_placement_apply(const char *name)
+{
+    uint64_t set[THREAD_CPUS_MAX / 64];
+    int      class = thread_classify(name);
+
+    if (thread_class_cpus[class][0] != '\0') {
+        if (thread_parse_cpus(thread_class_cpus[class], set))
+            thread_set_affinity(set);
+        else
+            pclog("THREAD: invalid CPU list \"%s\" for %s threads\n",
+                  thread_class_cpus[class], thread_class_names[class]);
+    } else if ((class == THREAD_CLASS_CPU) || (class == THREAD_CLASS_VOODOO_FIFO)) {
+        if (!complex_known)
+            thread_find_complex();
+        if (complex_known > 0)
+            thread_set_affinity(complex_set);
+    }
+
+    if (thread_class_priority[class])
+        thread_set_priority(thread_class_priority[class]);
+}
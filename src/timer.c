@@ -1,87 +1,155 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 #include <86box/86box.h>
 #include <86box/timer.h>
+#include <86box/device_profile.h>
+#include <86box/trace.h>
 
 uint64_t TIMER_USEC;
 uint32_t timer_target;
 
-/*Enabled timers are stored in a linked list, with the first timer to expire at
-  the head.*/
-pc_timer_t *timer_head = NULL;
+uint64_t timer_total_inserts;
+uint64_t timer_total_fires;
+
+/*Enabled timers are stored in a binary min-heap, with the first timer to expire
+  at index 0. Insertion, removal and re-arming are all O(log n), which matters
+  on machines with dozens of armed periodic timers.*/
+static pc_timer_t **timer_heap       = NULL;
+static uint32_t     timer_heap_count = 0;
+static uint32_t     timer_heap_size  = 0;
+static uint32_t     timer_seq        = 0;
 
 /* Are we initialized? */
 int timer_inited = 0;
 
 static void timer_advance_ex(pc_timer_t *timer, int start);
 
+/*True if timer a has to be processed before timer b. Timers with identical
+  timestamps are processed most recently armed first, which is the order the
+  old sorted list used.*/
+static __inline int
+timer_heap_less(pc_timer_t *a, pc_timer_t *b)
+{
+    int64_t diff = (int64_t) (a->ts.ts64 - b->ts.ts64);
+
+    if (diff != 0)
+        return diff < 0;
+
+    return ((int32_t) (a->seq - b->seq)) > 0;
+}
+
+static __inline void
+timer_heap_set(uint32_t idx, pc_timer_t *timer)
+{
+    timer_heap[idx] = timer;
+    timer->heap_idx = idx;
+}
+
+static void
+timer_heap_sift_up(uint32_t idx)
+{
+    pc_timer_t *timer = timer_heap[idx];
+
+    while (idx > 0) {
+        uint32_t parent = (idx - 1) >> 1;
+
+        if (!timer_heap_less(timer, timer_heap[parent]))
+            break;
+
+        timer_heap_set(idx, timer_heap[parent]);
+        idx = parent;
+    }
+
+    timer_heap_set(idx, timer);
+}
+
+static void
+timer_heap_sift_down(uint32_t idx)
+{
+    pc_timer_t *timer = timer_heap[idx];
+
+    while (1) {
+        uint32_t child = (idx << 1) + 1;
+
+        if (child >= timer_heap_count)
+            break;
+
+        if (((child + 1) < timer_heap_count) && timer_heap_less(timer_heap[child + 1], timer_heap[child]))
+            child++;
+
+        if (!timer_heap_less(timer_heap[child], timer))
+            break;
+
+        timer_heap_set(idx, timer_heap[child]);
+        idx = child;
+    }
+
+    timer_heap_set(idx, timer);
+}
+
+static void
+timer_heap_remove(pc_timer_t *timer)
+{
+    uint32_t    idx = timer->heap_idx;
+    pc_timer_t *last;
+
+    if ((idx >= timer_heap_count) || (timer_heap[idx] != timer))
+        fatal("timer_disable - timer not in heap\n");
+
+    last = timer_heap[--timer_heap_count];
+
+    if (last != timer) {
+        timer_heap_set(idx, last);
+        if ((idx > 0) && timer_heap_less(last, timer_heap[(idx - 1) >> 1]))
+            timer_heap_sift_up(idx);
+        else
+            timer_heap_sift_down(idx);
+    }
+
+    timer->heap_idx = 0;
+}
+
+static __inline void
+timer_update_target(void)
+{
+    if (timer_heap_count)
+        timer_target = timer_heap[0]->ts.ts32.integer;
+}
+
 void
 timer_enable(pc_timer_t *timer)
 {
-    pc_timer_t *timer_node = timer_head;
-    int ret = 0;
-
     if (!timer_inited || (timer == NULL))
         return;
 
-    if (timer->flags & TIMER_ENABLED)
-        timer_disable(timer);
-
-    if (timer->next || timer->prev)
-        fatal("timer_enable - timer->next\n");
-
-    /*List currently empty - add to head*/
-    if (!timer_head) {
-        timer_head  = timer;
-        timer->next = timer->prev = NULL;
-        timer_target              = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (TIMER_LESS_THAN(timer, timer_head)) {
-        timer->next      = timer_head;
-        timer->prev      = NULL;
-        timer_head->prev = timer;
-        timer_head       = timer;
-        timer_target     = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (!timer_head->next) {
-        timer_head->next = timer;
-        timer->prev      = timer_head;
-        ret = 1;
-    }
+    timer->seq = timer_seq++;
+    timer->inserts++;
+    timer_total_inserts++;
 
-    if (ret == 0) {
-        pc_timer_t *prev = timer_head;
-        timer_node       = timer_head->next;
-
-        while (1) {
-            /*Timer expires before timer_node. Add to list in front of timer_node*/
-            if (TIMER_LESS_THAN(timer, timer_node)) {
-                timer->next      = timer_node;
-                timer->prev      = prev;
-                timer_node->prev = timer;
-                prev->next       = timer;
-                ret = 1;
-                break;
-            }
-
-            /*timer_node is last in the list. Add timer to end of list*/
-            if (!timer_node->next) {
-                timer_node->next = timer;
-                timer->prev      = timer_node;
-                ret = 1;
-                break;
-            }
-
-            prev       = timer_node;
-            timer_node = timer_node->next;
+    if (timer->flags & TIMER_ENABLED) {
+        /*Already queued - the timestamp changed, so just restore heap order
+          in place instead of removing and re-inserting the timer.*/
+        timer->in_callback = 0;
+        timer_heap_sift_up(timer->heap_idx);
+        timer_heap_sift_down(timer->heap_idx);
+    } else {
+        if (timer_heap_count == timer_heap_size) {
+            timer_heap_size = timer_heap_size ? (timer_heap_size << 1) : 64;
+            timer_heap      = (pc_timer_t **) realloc(timer_heap, timer_heap_size * sizeof(pc_timer_t *));
+            if (timer_heap == NULL)
+                fatal("timer_enable - out of memory\n");
         }
-    }
 
-    /* Do not mark it as enabled if it has failed every single condition. */
-    if (ret == 1)
+        timer_heap_set(timer_heap_count++, timer);
+        timer_heap_sift_up(timer->heap_idx);
+
         timer->flags |= TIMER_ENABLED;
+    }
+
+    timer_update_target();
 }
 
 void
@@ -90,19 +158,11 @@ timer_disable(pc_timer_t *timer)
     if (!timer_inited || (timer == NULL) || !(timer->flags & TIMER_ENABLED))
         return;
 
-    if (!timer->next && !timer->prev && timer != timer_head)
-        fatal("timer_disable - !timer->next\n");
-
     timer->flags &= ~TIMER_ENABLED;
     timer->in_callback = 0;
 
-    if (timer->prev)
-        timer->prev->next = timer->next;
-    else
-        timer_head = timer->next;
-    if (timer->next)
-        timer->next->prev = timer->prev;
-    timer->prev = timer->next = NULL;
+    timer_heap_remove(timer);
+    timer_update_target();
 }
 
 void
@@ -110,20 +170,15 @@ timer_process(void)
 {
     pc_timer_t *timer;
 
-    if (!timer_head)
-        return;
+    TRACE_BEGIN(timer, "timer_process");
 
-    while (1) {
-        timer = timer_head;
+    while (timer_heap_count) {
+        timer = timer_heap[0];
 
         if (!TIMER_LESS_THAN_VAL(timer, (uint32_t) tsc))
             break;
 
-        timer_head = timer->next;
-        if (timer_head)
-            timer_head->prev = NULL;
-
-        timer->next = timer->prev = NULL;
+        timer_heap_remove(timer);
         timer->flags &= ~TIMER_ENABLED;
 
         if (timer->flags & TIMER_SPLIT)
@@ -133,31 +188,43 @@ timer_process(void)
             /* Make sure it's not NULL, so that we can
                have a NULL callback when no operation
                is needed. */
+            timer->fires++;
+            timer_total_fires++;
+
             timer->in_callback = 1;
-            timer->callback(timer->priv);
+            device_profile_call(DEVICE_PROFILE_TIMER, timer->priv ? timer->priv : (void *) timer->callback,
+                                timer->callback(timer->priv));
             timer->in_callback = 0;
         }
     }
 
-    timer_target = timer_head->ts.ts32.integer;
+    timer_update_target();
+
+    TRACE_END(timer, "timer_process");
 }
 
 void
-timer_close(void)
+timer_rebase(int64_t delta)
 {
-    pc_timer_t *t = timer_head;
-    pc_timer_t *r;
+    /*A uniform shift keeps every timer's position relative to the others, so
+      the heap order stays valid*/
+    for (uint32_t i = 0; i < timer_heap_count; i++)
+        timer_heap[i]->ts.ts64 += (uint64_t) delta << 32;
 
-    /* Set all timers' prev and next to NULL so it is assured that
-       timers that are not in malloc'd structs don't keep pointing
-       to timers that may be in malloc'd structs. */
-    while (t != NULL) {
-        r       = t;
-        r->prev = r->next = NULL;
-        t                 = r->next;
+    timer_update_target();
+}
+
+void
+timer_close(void)
+{
+    /* Clear all timers' heap state so it is assured that timers that
+       are not in malloc'd structs are not considered enabled anymore. */
+    for (uint32_t i = 0; i < timer_heap_count; i++) {
+        timer_heap[i]->flags &= ~TIMER_ENABLED;
+        timer_heap[i]->heap_idx = 0;
     }
 
-    timer_head = NULL;
+    timer_heap_count = 0;
 
     timer_inited = 0;
 }
@@ -168,19 +235,28 @@ timer_init(void)
     timer_target = 0ULL;
     tsc          = 0;
 
+    timer_heap_count    = 0;
+    timer_seq           = 0;
+    timer_total_inserts = 0;
+    timer_total_fires   = 0;
+
     timer_inited = 1;
 }
 
 void
 timer_add(pc_timer_t *timer, void (*callback)(void *priv), void *priv, int start_timer)
 {
+    /* Re-adding a timer that is still queued would leave a stale heap entry. */
+    if (timer_inited && (timer->flags & TIMER_ENABLED) && (timer->heap_idx < timer_heap_count) &&
+        (timer_heap[timer->heap_idx] == timer))
+        timer_disable(timer);
+
     memset(timer, 0, sizeof(pc_timer_t));
 
     timer->callback    = callback;
     timer->in_callback = 0;
     timer->priv        = priv;
     timer->flags       = 0;
-    timer->prev        = timer->next = NULL;
     if (start_timer)
         timer_set_delay_u64(timer, 0);
 }
@@ -44,6 +44,9 @@
 #include <86box/video.h>
 #include <86box/ui.h>
 #include <86box/gdbstub.h>
+#include <86box/snapshot.h>
+#include <86box/capture.h>
+#include <86box/bench.h>
 
 #define __USE_GNU 1 /* shouldn't be done, yet it is */
 #include <pthread.h>
@@ -184,9 +187,11 @@ typedef struct sdl_blit_params {
     int y;
     int w;
     int h;
+    int dirty_y1;
+    int dirty_y2;
 } sdl_blit_params;
 
-sdl_blit_params params  = { 0, 0, 0, 0 };
+sdl_blit_params params  = { 0, 0, 0, 0, 0, 0 };
 int             blitreq = 0;
 
 void *
@@ -408,7 +413,7 @@ plat_mmap(size_t size, uint8_t executable)
 #else
     void *ret = mmap(0, size, PROT_READ | PROT_WRITE | (executable ? PROT_EXEC : 0), MAP_ANON | MAP_PRIVATE, -1, 0);
 #endif
-    return (ret < 0) ? NULL : ret;
+    return (ret == MAP_FAILED) ? NULL : ret;
 }
 
 void
@@ -452,6 +457,12 @@ plat_remove(char *path)
     remove(path);
 }
 
+int
+plat_rename(const char *from, const char *to)
+{
+    return rename(from, to);
+}
+
 void
 ui_sb_update_icon_state(int tag, int state)
 {
@@ -547,6 +558,10 @@ main_thread(void *param)
             drawits = 10;
         else
 #endif
+        /* Turbo POST, max speed and benchmarks run frames back to back, with no host pacing. */
+        if (pc_unthrottled() && (drawits <= 0))
+            drawits = 10;
+        else
             drawits += (new_time - old_time);
         old_time = new_time;
         if (drawits > 0 && !dopause) {
@@ -557,6 +572,8 @@ main_thread(void *param)
 
             /* Run a block of code. */
             pc_run();
+            if (bench_frame())
+                break;
 
             /* Every 200 frames we save the machine status. */
             if (++frames >= 200 && nvr_dosave) {
@@ -688,6 +705,7 @@ plat_power_off(void)
     confirm_exit_cmdl = 0;
     nvr_save();
     config_save();
+    config_flush();
 
     /* Deduct a sufficiently large number of cycles that no instructions will
        run before the main thread is terminated */
@@ -963,6 +981,9 @@ monitor_thread(void *param)
                         "carteject <id> - eject cartridge from drive <id>.\n"
                         "moeject <id> - eject image from MO drive <id>.\n\n"
                         "hardreset - hard reset the emulated system.\n"
+                        "savestate <filename> - save a snapshot of the running machine.\n"
+                        "loadstate <filename> - resume a snapshot taken with this configuration.\n"
+                        "capture [filename] - start recording video, or stop if already recording.\n"
                         "pause - pause the the emulated system.\n"
                         "fullscreen - toggle fullscreen.\n"
                         "version - print version and license information.\n"
@@ -1013,6 +1034,17 @@ monitor_thread(void *param)
                     printf("%s", dopause ? "Paused.\n" : "Unpaused.\n");
                 } else if (strncasecmp(xargv[0], "hardreset", 9) == 0) {
                     pc_reset_hard();
+                } else if ((strncasecmp(xargv[0], "savestate", 9) == 0 ||
+                            strncasecmp(xargv[0], "loadstate", 9) == 0) && cmdargc >= 2) {
+                    if (snapshot_pending)
+                        printf("A snapshot is already being processed.\n");
+                    else
+                        snapshot_request(xargv[1], strncasecmp(xargv[0], "loadstate", 9) == 0);
+                } else if (strncasecmp(xargv[0], "capture", 7) == 0) {
+                    if (capture_active)
+                        capture_stop();
+                    else
+                        capture_start((cmdargc >= 2) ? xargv[1] : NULL);
                 } else if (strncasecmp(xargv[0], "cdload", 6) == 0 && cmdargc >= 3) {
                     uint8_t id;
                     bool    err = false;
@@ -1321,6 +1353,12 @@ main(int argc, char **argv)
                             case SDL_WINDOWEVENT_LEAVE:
                                 mouse_inside = 0;
                                 break;
+                            case SDL_WINDOWEVENT_EXPOSED:
+                                {
+                                    extern void sdl_redraw(void);
+                                    sdl_redraw();
+                                }
+                                break;
                         }
                     }
             }
@@ -27,6 +27,8 @@ typedef struct sdl_blit_params {
     int y;
     int w;
     int h;
+    int dirty_y1; /* Rows changed since the frame last shown. */
+    int dirty_y2;
 } sdl_blit_params;
 extern sdl_blit_params params;
 extern int             blitreq;
@@ -52,6 +54,14 @@ int                 resize_pending    = 0;
 int                 resize_w          = 0;
 int                 resize_h          = 0;
 static void        *pixeldata;
+static int          pixel_w           = 0; /* pixeldata pitch and height, those of the target buffer */
+static int          pixel_h           = 0;
+static int          pixel_valid       = 0; /* pixeldata holds the rows outside the dirty range too */
+static volatile int blit_direct       = 0; /* sdl_blit() uploads from the target buffer */
+static volatile int tex_w             = 0;
+static volatile int tex_h             = 0;
+static int          tex_valid         = 0; /* sdl_tex holds the frame last shown, at tex_rect */
+static SDL_Rect     tex_rect;
 
 extern void RenderImGui(void);
 static void
@@ -143,20 +153,69 @@ sdl_stretch(int *w, int *h, int *x, int *y)
     }
 }
 
+/* Whether a blit of this rectangle can go to the texture. */
+static int
+sdl_blit_fits(int x, int y, int w, int h)
+{
+    return sdl_enabled && (x >= 0) && (y >= 0) && (w > 0) && (h > 0) && (buffer32 != NULL) &&
+           ((x + w) <= buffer32->w) && ((y + h) <= buffer32->h) && ((x + w) <= tex_w) && ((y + h) <= tex_h) &&
+           (sdl_render != NULL) && (sdl_tex != NULL);
+}
+
 void
 sdl_blit_shim(int x, int y, int w, int h, int monitor_index)
 {
-    params.x = x;
-    params.y = y;
-    params.w = w;
-    params.h = h;
+    int same = (params.x == x) && (params.y == y) && (params.w == w) && (params.h == h);
+    int dirty_y1;
+    int dirty_y2;
+    int copy_y1;
+    int copy_y2;
+
+    video_blit_get_dirty_monitor(&dirty_y1, &dirty_y2, monitor_index);
+
+    /* A frame the main thread has not shown yet keeps its rows pending. */
+    if (blitreq && same && (params.dirty_y2 > params.dirty_y1)) {
+        if (dirty_y2 > dirty_y1) {
+            dirty_y1 = MIN(dirty_y1, params.dirty_y1);
+            dirty_y2 = MAX(dirty_y2, params.dirty_y2);
+        } else {
+            dirty_y1 = params.dirty_y1;
+            dirty_y2 = params.dirty_y2;
+        }
+    }
 
-    if (!(!sdl_enabled || (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > 2048) || (h > 2048) || (buffer32 == NULL) || (sdl_render == NULL) || (sdl_tex == NULL)) || (monitor_index >= 1))
-        for (int row = 0; row < h; ++row)
-            video_copy(&(((uint8_t *) pixeldata)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+    params.x        = x;
+    params.y        = y;
+    params.w        = w;
+    params.h        = h;
+    params.dirty_y1 = dirty_y1;
+    params.dirty_y2 = dirty_y2;
+
+    /* Without a colour transform to apply or a screenshot to take, sdl_blit()
+       uploads straight from the target buffer, which stays in use until then. */
+    if (!monitor_index && (video_copy == memcpy) && !monitors[monitor_index].mon_screenshots && sdl_blit_fits(x, y, w, h)) {
+        pixel_valid = 0;
+        blit_direct = 1;
+        blitreq     = 1;
+        return;
+    }
+
+    if ((sdl_blit_fits(x, y, w, h) || (monitor_index >= 1)) && ((x + w) <= pixel_w) && (h <= pixel_h)) {
+        /* Rows outside the dirty range are already there from the last copy. */
+        if (pixel_valid && same && !monitors[monitor_index].mon_screenshots) {
+            copy_y1 = dirty_y1;
+            copy_y2 = dirty_y2;
+        } else {
+            copy_y1 = y;
+            copy_y2 = y + h;
+        }
+        for (int row = copy_y1; row < copy_y2; ++row)
+            video_copy(&(((uint32_t *) pixeldata)[(row - y) * pixel_w]), &(buffer32->line[row][x]), w * sizeof(uint32_t));
+        pixel_valid = 1;
+    }
 
     if (monitors[monitor_index].mon_screenshots)
-        video_screenshot((uint32_t *) pixeldata, 0, 0, 2048);
+        video_screenshot((uint32_t *) pixeldata, 0, 0, pixel_w);
     blitreq = 1;
 
     video_blit_complete_monitor(monitor_index);
@@ -192,18 +251,45 @@ sdl_real_blit(SDL_Rect *r_src)
     SDL_RenderPresent(sdl_render);
 }
 
+/* Copies rows y1 to (y2 - 1) of the blit at r_src into the texture, through
+   a lock on just those rows. */
+static void
+sdl_upload(const SDL_Rect *r_src, int y1, int y2)
+{
+    SDL_Rect r_up = { r_src->x, y1, r_src->w, y2 - y1 };
+    void    *pixels;
+    int      pitch;
+
+    if (blit_direct) {
+        if (SDL_LockTexture(sdl_tex, &r_up, &pixels, &pitch)) {
+            SDL_UpdateTexture(sdl_tex, &r_up, &buffer32->line[y1][r_src->x], buffer32->w * 4);
+            return;
+        }
+        for (int row = y1; row < y2; row++)
+            memcpy(&((uint8_t *) pixels)[(row - y1) * pitch], &buffer32->line[row][r_src->x], r_src->w * 4);
+        SDL_UnlockTexture(sdl_tex);
+    } else
+        SDL_UpdateTexture(sdl_tex, &r_up, &((uint32_t *) pixeldata)[(y1 - r_src->y) * pixel_w], pixel_w * 4);
+}
+
 void
 sdl_blit(int x, int y, int w, int h)
 {
     SDL_Rect r_src;
+    int      y1;
+    int      y2;
 
-    if (!sdl_enabled || (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > 2048) || (h > 2048) || (buffer32 == NULL) || (sdl_render == NULL) || (sdl_tex == NULL)) {
+    if (!sdl_blit_fits(x, y, w, h)) {
         r_src.x = x;
         r_src.y = y;
         r_src.w = w;
         r_src.h = h;
         sdl_real_blit(&r_src);
         blitreq = 0;
+        if (blit_direct) {
+            blit_direct = 0;
+            video_blit_complete_monitor(0);
+        }
         return;
     }
 
@@ -218,10 +304,42 @@ sdl_blit(int x, int y, int w, int h)
     r_src.y = y;
     r_src.w = w;
     r_src.h = h;
-    SDL_UpdateTexture(sdl_tex, &r_src, pixeldata, 2048 * 4);
+
+    /* Only the changed rows go to the texture, unless it was just created or
+       the frame moved; nothing changed means nothing to present either. */
+    if (tex_valid && !memcmp(&r_src, &tex_rect, sizeof(SDL_Rect))) {
+        y1 = params.dirty_y1;
+        y2 = params.dirty_y2;
+    } else {
+        y1 = y;
+        y2 = y + h;
+    }
+    if (y2 > y1)
+        sdl_upload(&r_src, y1, y2);
+    if (blit_direct) {
+        blit_direct = 0;
+        video_blit_complete_monitor(0);
+    }
     blitreq = 0;
 
-    sdl_real_blit(&r_src);
+    if (y2 > y1) {
+        tex_valid = 1;
+        tex_rect  = r_src;
+        sdl_real_blit(&r_src);
+    }
+    SDL_UnlockMutex(sdl_mutex);
+}
+
+/* The window needs repainting, from what the texture already holds. */
+void
+sdl_redraw(void)
+{
+    if (sdl_mutex == NULL)
+        return;
+
+    SDL_LockMutex(sdl_mutex);
+    if (sdl_enabled && tex_valid && (sdl_render != NULL))
+        sdl_real_blit(&tex_rect);
     SDL_UnlockMutex(sdl_mutex);
 }
 
@@ -259,6 +377,11 @@ sdl_close(void)
     /* Unregister our renderer! */
     video_setblit(NULL);
 
+    if (blit_direct) {
+        blit_direct = 0;
+        video_blit_complete_monitor(0);
+    }
+
     if (sdl_enabled)
         sdl_enabled = 0;
 
@@ -314,6 +437,10 @@ sdl_select_best_hw_driver(void)
 void
 sdl_reinit_texture(void)
 {
+    SDL_RendererInfo info;
+    int              w = (buffer32 != NULL) ? buffer32->w : 2048;
+    int              h = (buffer32 != NULL) ? buffer32->h : 2048;
+
     sdl_destroy_texture();
 
     if (sdl_flags & RENDERER_HARDWARE) {
@@ -322,8 +449,19 @@ sdl_reinit_texture(void)
     } else
         sdl_render = SDL_CreateRenderer(sdl_win, -1, SDL_RENDERER_SOFTWARE);
 
-    sdl_tex = SDL_CreateTexture(sdl_render, SDL_PIXELFORMAT_ARGB8888,
-                                SDL_TEXTUREACCESS_STREAMING, 2048, 2048);
+    /* As large as the target buffer, within what the renderer can do. */
+    if ((sdl_render != NULL) && !SDL_GetRendererInfo(sdl_render, &info)) {
+        if (info.max_texture_width && (w > info.max_texture_width))
+            w = info.max_texture_width;
+        if (info.max_texture_height && (h > info.max_texture_height))
+            h = info.max_texture_height;
+    }
+
+    sdl_tex   = SDL_CreateTexture(sdl_render, SDL_PIXELFORMAT_ARGB8888,
+                                  SDL_TEXTUREACCESS_STREAMING, w, h);
+    tex_w     = (sdl_tex != NULL) ? w : 0;
+    tex_h     = (sdl_tex != NULL) ? h : 0;
+    tex_valid = 0;
 }
 
 void
@@ -435,7 +573,10 @@ sdl_init_common(int flags)
     /* Make sure we get a clean exit. */
     atexit(sdl_close);
 
-    pixeldata = malloc(2048 * 2048 * 4);
+    pixel_w     = (buffer32 != NULL) ? buffer32->w : 2048;
+    pixel_h     = (buffer32 != NULL) ? buffer32->h : 2048;
+    pixel_valid = 0;
+    pixeldata   = malloc((size_t) pixel_w * pixel_h * 4);
 
     /* Register our renderer! */
     video_setblit(sdl_blit_shim);
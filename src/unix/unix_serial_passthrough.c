@@ -31,7 +31,7 @@
 #include <string.h>
 #include <sys/select.h>
 #include <stdint.h>
-#include <sys/select.h>
+#include <poll.h>
 
 #include <86box/86box.h>
 #include <86box/log.h>
@@ -44,32 +44,39 @@
 
 #define LOG_PREFIX "serial_passthrough: "
 
+/* Waits up to timeout_ms for data, then reads whatever is there, up to len
+   bytes. Called from the reader thread only. */
 int
-plat_serpt_read(void *priv, uint8_t *data)
+plat_serpt_read_block(void *priv, uint8_t *buf, int len, int timeout_ms)
 {
     serial_passthrough_t *dev = (serial_passthrough_t *) priv;
-    int                   res;
-    struct timeval        tv;
-    fd_set                rdfds;
+    struct pollfd         pfd;
+    ssize_t               res;
 
     switch (dev->mode) {
         case SERPT_MODE_VCON:
         case SERPT_MODE_HOSTSER:
-            FD_ZERO(&rdfds);
-            FD_SET(dev->master_fd, &rdfds);
-            tv.tv_sec  = 0;
-            tv.tv_usec = 0;
-
-            res = select(dev->master_fd + 1, &rdfds, NULL, NULL, &tv);
-            if (res <= 0 || !FD_ISSET(dev->master_fd, &rdfds)) {
+            pfd.fd      = dev->master_fd;
+            pfd.events  = POLLIN;
+            pfd.revents = 0;
+
+            if ((poll(&pfd, 1, timeout_ms) <= 0) || !(pfd.revents & POLLIN)) {
+                /* A pseudo terminal with nothing on the other side reports a
+                   hangup right away, do not spin on it. */
+                if (pfd.revents & (POLLHUP | POLLERR))
+                    plat_delay_ms(timeout_ms);
                 return 0;
             }
 
-            if (read(dev->master_fd, data, 1) > 0) {
-                return 1;
-            }
+            res = read(dev->master_fd, buf, len);
+            if (res > 0)
+                return (int) res;
+
+            if ((res < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+                plat_delay_ms(timeout_ms);
             break;
         default:
+            plat_delay_ms(timeout_ms);
             break;
     }
     return 0;
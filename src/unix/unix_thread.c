@@ -2,20 +2,28 @@
 #include <stdio.h>
 #include <time.h>
 #include <pthread.h>
+#include <unistd.h>
 #include <inttypes.h>
+#include <stdatomic.h>
+#if defined(__i386__) || defined(__x86_64__)
+#    include <immintrin.h>
+#endif
 #include <86box/86box.h>
 #include <86box/plat.h>
 #include <86box/thread.h>
 
+/* The state is set under the mutex but read without it, see thread.cpp. */
 typedef struct event_pthread_t {
     pthread_cond_t  cond;
     pthread_mutex_t mutex;
-    int             state;
+    atomic_int      state;
+    int             waiters;
 } event_pthread_t;
 
 typedef struct thread_param {
     void (*thread_rout)(void *);
-    void *param;
+    void       *param;
+    const char *name;
 } thread_param;
 
 typedef struct pt_mutex_t {
@@ -27,6 +35,7 @@ thread_run_wrapper(thread_param *arg)
 {
     thread_param localparam = *arg;
     free(arg);
+    thread_placement_apply(localparam.name);
     localparam.thread_rout(localparam.param);
     return NULL;
 }
@@ -38,6 +47,7 @@ thread_create_named(void (*thread_rout)(void *param), void *param, const char *n
     thread_param *thrparam = malloc(sizeof(thread_param));
     thrparam->thread_rout  = thread_rout;
     thrparam->param        = param;
+    thrparam->name         = name;
 
     pthread_create(thread, NULL, (void *(*) (void *) ) thread_run_wrapper, thrparam);
     plat_set_thread_name(thread, name);
@@ -58,7 +68,8 @@ thread_create_event(void)
 
     pthread_cond_init(&event->cond, NULL);
     pthread_mutex_init(&event->mutex, NULL);
-    event->state = 0;
+    atomic_init(&event->state, 0);
+    event->waiters = 0;
 
     return (event_t *) event;
 }
@@ -68,9 +79,13 @@ thread_set_event(event_t *handle)
 {
     event_pthread_t *event = (event_pthread_t *) handle;
 
+    if (atomic_load_explicit(&event->state, memory_order_acquire))
+        return;
+
     pthread_mutex_lock(&event->mutex);
-    event->state = 1;
-    pthread_cond_broadcast(&event->cond);
+    atomic_store_explicit(&event->state, 1, memory_order_release);
+    if (event->waiters)
+        pthread_cond_broadcast(&event->cond);
     pthread_mutex_unlock(&event->mutex);
 }
 
@@ -79,9 +94,7 @@ thread_reset_event(event_t *handle)
 {
     event_pthread_t *event = (event_pthread_t *) handle;
 
-    pthread_mutex_lock(&event->mutex);
-    event->state = 0;
-    pthread_mutex_unlock(&event->mutex);
+    atomic_store_explicit(&event->state, 0, memory_order_release);
 }
 
 int
@@ -90,6 +103,9 @@ thread_wait_event(event_t *handle, int timeout)
     event_pthread_t *event = (event_pthread_t *) handle;
     struct timespec  abstime;
 
+    if (atomic_load_explicit(&event->state, memory_order_acquire))
+        return 0;
+
     clock_gettime(CLOCK_REALTIME, &abstime);
     abstime.tv_nsec += (timeout % 1000) * 1000000;
     abstime.tv_sec += (timeout / 1000);
@@ -99,16 +115,36 @@ thread_wait_event(event_t *handle, int timeout)
     }
 
     pthread_mutex_lock(&event->mutex);
+    event->waiters++;
     if (timeout == -1) {
-        while (!event->state)
+        while (!atomic_load_explicit(&event->state, memory_order_acquire))
             pthread_cond_wait(&event->cond, &event->mutex);
-    } else if (!event->state)
+    } else if (!atomic_load_explicit(&event->state, memory_order_acquire))
         pthread_cond_timedwait(&event->cond, &event->mutex, &abstime);
+    event->waiters--;
     pthread_mutex_unlock(&event->mutex);
 
     return 0;
 }
 
+int
+thread_wait_event_spin(event_t *handle, int timeout, int spins)
+{
+    event_pthread_t *event = (event_pthread_t *) handle;
+
+    for (int c = 0; c < spins; c++) {
+        if (atomic_load_explicit(&event->state, memory_order_acquire))
+            return 0;
+#if defined(__i386__) || defined(__x86_64__)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+#endif
+    }
+
+    return thread_wait_event(handle, timeout);
+}
+
 void
 thread_destroy_event(event_t *handle)
 {
@@ -169,3 +205,11 @@ thread_close_mutex(mutex_t *_mutex)
 
     free(mutex);
 }
+
+int
+thread_get_cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (count > 0) ? (int) count : 1;
+}
@@ -6,8 +6,13 @@
  *
  *          This file is part of the 86Box distribution.
  *
- *          Universal Serial Bus emulation (currently dummy UHCI and
- *          OHCI).
+ *          Universal Serial Bus emulation (UHCI and OHCI).
+ *
+ *          While running, each controller walks its schedule once per
+ *          1 ms frame. Descriptors are fetched whole in one bus master
+ *          read, and the lists are only walked at all while a device is
+ *          plugged into a port; otherwise a frame only moves the frame
+ *          number and the start of frame status on.
  *
  *
  *
@@ -25,7 +30,10 @@
 #include <86box/86box.h>
 #include <86box/device.h>
 #include <86box/io.h>
+#include <86box/timer.h>
 #include <86box/mem.h>
+#include <86box/dma.h>
+#include <86box/pci.h>
 #include <86box/usb.h>
 #include "cpu.h"
 #include <86box/plat_unused.h>
@@ -48,6 +56,224 @@ usb_log(const char *fmt, ...)
 #    define usb_log(fmt, ...)
 #endif
 
+#define USB_FRAME_US      1000.0
+#define USB_MAX_ELEMENTS  256 /* Descriptors looked at per list per frame. */
+#define USB_MAX_QHS       32  /* UHCI QHs remembered to catch looped lists. */
+#define USB_MAX_TRANSFER  8192
+
+/* UHCI TD control and status. */
+#define UHCI_TD_ACTIVE    (1 << 23)
+#define UHCI_TD_STALLED   (1 << 22)
+#define UHCI_TD_NAK       (1 << 19)
+#define UHCI_TD_TIMEOUT   (1 << 18)
+#define UHCI_TD_IOC       (1 << 24)
+#define UHCI_TD_SPD       (1 << 29)
+
+/* OHCI TD condition codes. */
+#define OHCI_CC_NO_ERROR  0x0
+#define OHCI_CC_STALL     0x4
+#define OHCI_CC_NO_RESP   0x5
+#define OHCI_CC_OVERRUN   0x8
+#define OHCI_CC_UNDERRUN  0x9
+
+static usb_device_c *
+usb_find_device(const usb_t *dev, uint8_t address)
+{
+    for (int i = 0; i < USB_NUM_PORTS; i++) {
+        if ((dev->ports[i] != NULL) && (dev->ports[i]->address == address))
+            return dev->ports[i];
+    }
+
+    return NULL;
+}
+
+static void
+usb_set_irq_level(usb_t *dev, int level)
+{
+    if (level == dev->irq_level)
+        return;
+
+    dev->irq_level = level;
+    if (!dev->slot)
+        return;
+
+    if (level)
+        pci_set_irq(dev->slot, dev->irq_pin, &dev->irq_state);
+    else
+        pci_clear_irq(dev->slot, dev->irq_pin, &dev->irq_state);
+}
+
+/* Reads or writes len bytes of a transfer buffer that may cross one page
+   boundary, at page2 (OHCI) or straight on (UHCI, page2 = 0). */
+static void
+usb_buffer_rw(uint32_t addr, uint32_t page2, uint8_t *buf, uint32_t len, int write)
+{
+    uint32_t first = len;
+
+    if (page2 && ((addr & 0xfff) + len > 0x1000))
+        first = 0x1000 - (addr & 0xfff);
+
+    if (write)
+        dma_bm_write(addr, buf, first, 1);
+    else
+        dma_bm_read(addr, buf, first, 1);
+
+    if (first < len) {
+        if (write)
+            dma_bm_write(page2, buf + first, len - first, 1);
+        else
+            dma_bm_read(page2, buf + first, len - first, 1);
+    }
+}
+
+static void
+uhci_update_irq(usb_t *dev)
+{
+    const uint8_t *regs  = dev->uhci_io;
+    int            level = 0;
+
+    if ((regs[0x02] & 0x01) && (regs[0x04] & 0x0c))
+        level = 1;
+    if ((regs[0x02] & 0x02) && (regs[0x04] & 0x01))
+        level = 1;
+    if (regs[0x02] & 0x18)
+        level = 1;
+
+    usb_set_irq_level(dev, level);
+}
+
+/* Runs one TD, already fetched into td[]; writes its status back. Returns 1
+   if it completed, 0 if it is still active (NAK) or was retired in error. */
+static int
+uhci_process_td(usb_t *dev, uint32_t addr, uint32_t *td)
+{
+    uint8_t       buf[0x800];
+    uint8_t       pid     = td[2] & 0xff;
+    uint32_t      max_len = ((td[2] >> 21) + 1) & 0x7ff;
+    uint32_t      len     = max_len;
+    usb_device_c *device  = usb_find_device(dev, (td[2] >> 8) & 0x7f);
+    int           ret     = USB_ERROR_STALL;
+    int           cerr;
+
+    td[1] &= ~(UHCI_TD_NAK | UHCI_TD_TIMEOUT);
+
+    if (device == NULL) {
+        /* Nothing answers: a timeout, retired once the error count runs out. */
+        cerr = (td[1] >> 27) & 0x03;
+        td[1] |= UHCI_TD_TIMEOUT;
+        if (cerr && !--cerr) {
+            td[1] &= ~UHCI_TD_ACTIVE;
+            td[1] |= UHCI_TD_STALLED;
+            dev->uhci_io[0x02] |= 0x02;
+        }
+        td[1] = (td[1] & ~(0x03 << 27)) | (cerr << 27);
+        mem_writel_phys(addr + 4, td[1]);
+        return 0;
+    }
+
+    if ((pid != USB_PID_IN) && len)
+        usb_buffer_rw(td[3], 0, buf, len, 0);
+
+    ret = device->handle_packet(device->priv, pid, (td[2] >> 15) & 0x0f, buf, &len);
+    switch (ret) {
+        case USB_ERROR_NAK:
+            td[1] |= UHCI_TD_NAK;
+            mem_writel_phys(addr + 4, td[1]);
+            return 0;
+
+        case USB_ERROR_NO_ERROR:
+            if ((pid == USB_PID_IN) && len)
+                usb_buffer_rw(td[3], 0, buf, len, 1);
+            td[1] = (td[1] & ~(UHCI_TD_ACTIVE | 0x7ff)) | ((len - 1) & 0x7ff);
+            if (td[1] & UHCI_TD_IOC)
+                dev->uhci_io[0x02] |= 0x01;
+            if ((pid == USB_PID_IN) && (td[1] & UHCI_TD_SPD) && (len < max_len))
+                dev->uhci_io[0x02] |= 0x01;
+            mem_writel_phys(addr + 4, td[1]);
+            return 1;
+
+        default:
+            td[1] = (td[1] & ~UHCI_TD_ACTIVE) | UHCI_TD_STALLED;
+            dev->uhci_io[0x02] |= 0x02;
+            mem_writel_phys(addr + 4, td[1]);
+            return 0;
+    }
+}
+
+static void
+uhci_process_schedule(usb_t *dev, uint32_t link)
+{
+    uint32_t qhs[USB_MAX_QHS];
+    uint32_t desc[4];
+    uint32_t elem;
+    int      nqh   = 0;
+    int      count = 0;
+
+    while (!(link & 0x01) && (count++ < USB_MAX_ELEMENTS)) {
+        const uint32_t addr = link & 0xfffffff0;
+
+        if (!(link & 0x02)) {
+            /* A TD straight off the frame list (isochronous, in practice). */
+            dma_bm_read(addr, (uint8_t *) desc, 16, 4);
+            if (desc[1] & UHCI_TD_ACTIVE)
+                uhci_process_td(dev, addr, desc);
+            link = desc[0];
+            continue;
+        }
+
+        /* Lists looped back for bandwidth reclamation end here. */
+        for (int i = 0; i < nqh; i++) {
+            if (qhs[i] == addr)
+                return;
+        }
+        if (nqh == USB_MAX_QHS)
+            return;
+        qhs[nqh++] = addr;
+
+        dma_bm_read(addr, (uint8_t *) desc, 8, 4);
+        link = desc[0];
+        elem = desc[1];
+
+        /* Run the queue until a TD does not complete, one TD per visit
+           unless it asks for depth first. */
+        while (!(elem & 0x03) && (count++ < USB_MAX_ELEMENTS)) {
+            const uint32_t td_addr = elem & 0xfffffff0;
+
+            dma_bm_read(td_addr, (uint8_t *) desc, 16, 4);
+            if (!(desc[1] & UHCI_TD_ACTIVE) || !uhci_process_td(dev, td_addr, desc))
+                break;
+
+            elem = desc[0];
+            mem_writel_phys(addr + 4, elem);
+            if (!(elem & 0x04))
+                break;
+        }
+    }
+}
+
+static void
+uhci_frame_timer(void *priv)
+{
+    usb_t    *dev  = (usb_t *) priv;
+    uint16_t *regs = (uint16_t *) dev->uhci_io;
+    uint32_t  fl_base;
+    uint32_t  entry;
+
+    if (!(regs[0x00] & 0x0001))
+        return;
+
+    timer_advance_u64(&dev->uhci_frame_timer, (uint64_t) (USB_FRAME_US * TIMER_USEC));
+
+    if (dev->ports_used) {
+        fl_base = *(uint32_t *) &dev->uhci_io[0x08] & 0xfffff000;
+        entry   = mem_readl_phys(fl_base + ((regs[0x03] & 0x03ff) << 2));
+        uhci_process_schedule(dev, entry);
+    }
+
+    regs[0x03] = (regs[0x03] + 1) & 0x07ff;
+    uhci_update_irq(dev);
+}
+
 static uint8_t
 uhci_reg_read(uint16_t addr, void *priv)
 {
@@ -73,9 +299,11 @@ uhci_reg_write(uint16_t addr, uint8_t val, void *priv)
     switch (addr) {
         case 0x02:
             regs[0x02] &= ~(val & 0x3f);
+            uhci_update_irq(dev);
             break;
         case 0x04:
             regs[0x04] = (val & 0x0f);
+            uhci_update_irq(dev);
             break;
         case 0x09:
             regs[0x09] = (val & 0xf0);
@@ -103,10 +331,13 @@ uhci_reg_writew(uint16_t addr, uint16_t val, void *priv)
 
     switch (addr) {
         case 0x00:
-            if ((val & 0x0001) && !(regs[0x00] & 0x0001))
+            if ((val & 0x0001) && !(regs[0x00] & 0x0001)) {
                 regs[0x01] &= ~0x20;
-            else if (!(val & 0x0001))
+                timer_on_auto(&dev->uhci_frame_timer, USB_FRAME_US);
+            } else if (!(val & 0x0001)) {
                 regs[0x01] |= 0x20;
+                timer_disable(&dev->uhci_frame_timer);
+            }
             regs[0x00] = (val & 0x00ff);
             break;
         case 0x06:
@@ -136,6 +367,191 @@ uhci_update_io_mapping(usb_t *dev, uint8_t base_l, uint8_t base_h, int enable)
         io_sethandler(dev->uhci_io_base, 0x20, uhci_reg_read, NULL, NULL, uhci_reg_write, uhci_reg_writew, NULL, dev);
 }
 
+static void
+ohci_update_irq(usb_t *dev)
+{
+    const uint32_t status = *(uint32_t *) &dev->ohci_mmio[0x0c];
+    const uint32_t enable = *(uint32_t *) &dev->ohci_mmio[0x10];
+    const int      level  = (enable & 0x80000000) && (status & enable & 0x4000007f);
+
+    /* InterruptRouting sends it to SMM instead. */
+    if (dev->ohci_mmio[0x05] & 0x01) {
+        if (level && !dev->irq_level)
+            smi_raise();
+        dev->irq_level = level;
+    } else
+        usb_set_irq_level(dev, level);
+}
+
+/* Moves a TD, done with condition code cc, from its ED onto the done queue. */
+static void
+ohci_retire_td(usb_t *dev, uint32_t ed_addr, uint32_t *ed, uint32_t td_addr, uint32_t *td, int cc, int halt)
+{
+    td[0] = (td[0] & 0x0fffffff) | (cc << 28);
+    ed[2] = (td[2] & 0xfffffff0) | (ed[2] & 0x02) | (halt ? 0x01 : 0x00);
+    td[2] = dev->ohci_done_head;
+    dev->ohci_done_head = td_addr;
+
+    dma_bm_write(td_addr, (uint8_t *) td, 12, 4);
+    mem_writel_phys(ed_addr + 8, ed[2]);
+}
+
+/* Runs the TD at the head of an ED, already fetched into ed[]. Returns 1 if
+   a TD was acted upon. */
+static int
+ohci_process_td(usb_t *dev, uint32_t ed_addr, uint32_t *ed)
+{
+    uint8_t       buf[USB_MAX_TRANSFER];
+    uint32_t      td[4];
+    const uint32_t td_addr = ed[2] & 0xfffffff0;
+    usb_device_c *device   = usb_find_device(dev, ed[0] & 0x7f);
+    uint32_t      len      = 0;
+    uint32_t      max_len;
+    uint32_t      toggle;
+    uint8_t       pid;
+    int           ret;
+
+    dma_bm_read(td_addr, (uint8_t *) td, 16, 4);
+
+    switch ((ed[0] >> 11) & 0x03) {
+        case 0x01:
+            pid = USB_PID_OUT;
+            break;
+        case 0x02:
+            pid = USB_PID_IN;
+            break;
+        default:
+            pid = (((td[0] >> 19) & 0x03) == 0x00) ? USB_PID_SETUP : ((((td[0] >> 19) & 0x03) == 0x01) ? USB_PID_OUT : USB_PID_IN);
+            break;
+    }
+
+    if (td[1]) {
+        if ((td[1] ^ td[3]) & 0xfffff000)
+            len = (0x1000 - (td[1] & 0xfff)) + (td[3] & 0xfff) + 1;
+        else
+            len = td[3] - td[1] + 1;
+        len = MIN(len, USB_MAX_TRANSFER);
+    }
+    max_len = len;
+
+    if (device == NULL) {
+        ohci_retire_td(dev, ed_addr, ed, td_addr, td, OHCI_CC_NO_RESP, 1);
+        return 1;
+    }
+
+    if ((pid != USB_PID_IN) && len)
+        usb_buffer_rw(td[1], td[3] & 0xfffff000, buf, len, 0);
+
+    ret = device->handle_packet(device->priv, pid, (ed[0] >> 7) & 0x0f, buf, &len);
+    if (ret == USB_ERROR_NAK)
+        return 1;
+
+    if (ret != USB_ERROR_NO_ERROR) {
+        ohci_retire_td(dev, ed_addr, ed, td_addr, td, (ret == USB_ERROR_OVERRUN) ? OHCI_CC_OVERRUN : OHCI_CC_STALL, 1);
+        return 1;
+    }
+
+    if ((pid == USB_PID_IN) && len)
+        usb_buffer_rw(td[1], td[3] & 0xfffff000, buf, len, 1);
+
+    /* Flip the data toggle, in the TD if it carries its own, else in the ED. */
+    toggle = (td[0] & 0x02000000) ? ((td[0] >> 24) & 0x01) : ((ed[2] >> 1) & 0x01);
+    toggle ^= 0x01;
+    td[0] = (td[0] & ~0x03000000) | 0x02000000 | (toggle << 24);
+    ed[2] = (ed[2] & ~0x02) | (toggle << 1);
+
+    if (len < max_len) {
+        /* Short packet: fine with bufferRounding, else a data underrun. */
+        td[1] = ((td[1] & 0xfff) + len >= 0x1000) ? ((td[3] & 0xfffff000) + (((td[1] & 0xfff) + len) & 0xfff)) : (td[1] + len);
+        ohci_retire_td(dev, ed_addr, ed, td_addr, td, (td[0] & 0x00040000) ? OHCI_CC_NO_ERROR : OHCI_CC_UNDERRUN, !(td[0] & 0x00040000));
+    } else {
+        td[1] = 0x00000000;
+        ohci_retire_td(dev, ed_addr, ed, td_addr, td, OHCI_CC_NO_ERROR, 0);
+    }
+
+    return 1;
+}
+
+/* Walks an ED list; returns 1 if any TD on it was acted upon. */
+static int
+ohci_process_list(usb_t *dev, uint32_t ed_addr)
+{
+    uint32_t ed[4];
+    int      count = 0;
+    int      ret   = 0;
+
+    ed_addr &= 0xfffffff0;
+    while (ed_addr && (count++ < USB_MAX_ELEMENTS)) {
+        dma_bm_read(ed_addr, (uint8_t *) ed, 16, 4);
+
+        /* Skipped, halted, empty or isochronous EDs have nothing to run. */
+        if (!(ed[0] & 0x0000c000) && !(ed[2] & 0x01) && ((ed[2] & 0xfffffff0) != (ed[1] & 0xfffffff0)))
+            ret |= ohci_process_td(dev, ed_addr, ed);
+
+        ed_addr = ed[3] & 0xfffffff0;
+    }
+
+    return ret;
+}
+
+static void
+ohci_frame_timer(void *priv)
+{
+    usb_t    *dev     = (usb_t *) priv;
+    uint8_t  *mmio    = dev->ohci_mmio;
+    uint32_t  hcca    = *(uint32_t *) &mmio[0x18] & 0xffffff00;
+    uint16_t  fm      = *(uint16_t *) &mmio[0x3c];
+    uint32_t  head;
+    uint32_t  done;
+
+    if ((mmio[0x04] & 0xc0) != 0x80)
+        return;
+
+    timer_advance_u64(&dev->ohci_frame_timer, (uint64_t) (USB_FRAME_US * TIMER_USEC));
+
+    if ((++fm ^ *(uint16_t *) &mmio[0x3c]) & 0x8000)
+        mmio[0x0c] |= 0x20; /* FrameNumberOverflow */
+    *(uint16_t *) &mmio[0x3c] = fm;
+    mmio[0x0c] |= 0x04; /* StartofFrame */
+    if (hcca)
+        mem_writel_phys(hcca + 0x80, fm);
+
+    if (dev->ports_used) {
+        if ((mmio[0x04] & 0x04) && hcca) {
+            head = mem_readl_phys(hcca + ((fm & 0x1f) << 2));
+            ohci_process_list(dev, head);
+        }
+
+        /* The control and bulk lists are only gone through while filled. */
+        if ((mmio[0x04] & 0x10) && (mmio[0x08] & 0x02) && !ohci_process_list(dev, *(uint32_t *) &mmio[0x20]))
+            mmio[0x08] &= ~0x02;
+        if ((mmio[0x04] & 0x20) && (mmio[0x08] & 0x04) && !ohci_process_list(dev, *(uint32_t *) &mmio[0x28]))
+            mmio[0x08] &= ~0x04;
+    }
+
+    /* Hand the done queue over once the driver has taken the last one. */
+    if (dev->ohci_done_head && !(mmio[0x0c] & 0x02) && hcca) {
+        done = dev->ohci_done_head;
+        if (*(uint32_t *) &mmio[0x0c] & *(uint32_t *) &mmio[0x10] & ~0x02)
+            done |= 0x01;
+        mem_writel_phys(hcca + 0x84, done);
+        dev->ohci_done_head = 0x00000000;
+        mmio[0x0c] |= 0x02; /* WritebackDoneHead */
+    }
+
+    ohci_update_irq(dev);
+}
+
+static void
+ohci_update_frame_timer(usb_t *dev)
+{
+    if ((dev->ohci_mmio[0x04] & 0xc0) == 0x80) {
+        if (!timer_is_enabled(&dev->ohci_frame_timer))
+            timer_on_auto(&dev->ohci_frame_timer, USB_FRAME_US);
+    } else
+        timer_disable(&dev->ohci_frame_timer);
+}
+
 static uint8_t
 ohci_mmio_read(uint32_t addr, void *priv)
 {
@@ -144,7 +560,11 @@ ohci_mmio_read(uint32_t addr, void *priv)
 
     addr &= 0x00000fff;
 
-    ret = dev->ohci_mmio[addr];
+    /* HcInterruptDisable reads back as HcInterruptEnable. */
+    if ((addr >= 0x14) && (addr <= 0x17))
+        ret = dev->ohci_mmio[addr - 4];
+    else
+        ret = dev->ohci_mmio[addr];
 
     if (addr == 0x101)
         ret = (ret & 0xfe) | (!!mem_a20_key);
@@ -166,7 +586,13 @@ ohci_mmio_write(uint32_t addr, uint8_t val, void *priv)
                 /* UsbReset */
                 dev->ohci_mmio[0x56] = dev->ohci_mmio[0x5a] = 0x16;
             }
-            break;
+            dev->ohci_mmio[addr] = val;
+            ohci_update_frame_timer(dev);
+            return;
+        case 0x05:
+            dev->ohci_mmio[addr] = val;
+            ohci_update_irq(dev);
+            return;
         case 0x08: /* HCCOMMANDSTATUS */
             /* bit OwnershipChangeRequest triggers an ownership change (SMM <-> OS) */
             if (val & 0x08) {
@@ -181,17 +607,36 @@ ohci_mmio_write(uint32_t addr, uint8_t val, void *priv)
                 dev->ohci_mmio[0x00] = 0x10;
                 dev->ohci_mmio[0x01] = 0x01;
                 dev->ohci_mmio[0x48] = 0x02;
+                dev->ohci_done_head  = 0x00000000;
                 val &= ~0x01;
+                ohci_update_frame_timer(dev);
+                ohci_update_irq(dev);
             }
             break;
         case 0x0c:
             dev->ohci_mmio[addr] &= ~(val & 0x7f);
+            ohci_update_irq(dev);
             return;
         case 0x0d:
         case 0x0e:
             return;
         case 0x0f:
             dev->ohci_mmio[addr] &= ~(val & 0x40);
+            ohci_update_irq(dev);
+            return;
+        case 0x10:
+        case 0x11:
+        case 0x12:
+        case 0x13:
+            dev->ohci_mmio[addr] |= val;
+            ohci_update_irq(dev);
+            return;
+        case 0x14:
+        case 0x15:
+        case 0x16:
+        case 0x17:
+            dev->ohci_mmio[addr - 4] &= ~val;
+            ohci_update_irq(dev);
             return;
         case 0x3b:
             dev->ohci_mmio[addr] = (val & 0x80);
@@ -368,11 +813,69 @@ ohci_update_mem_mapping(usb_t *dev, uint8_t base1, uint8_t base2, uint8_t base3,
         mem_mapping_set_addr(&dev->ohci_mmio_mapping, dev->ohci_mem_base, 0x1000);
 }
 
+/* Where the controller's interrupt goes; without it there is none. */
+void
+usb_set_slot(usb_t *dev, int slot, int irq_pin)
+{
+    dev->slot    = slot;
+    dev->irq_pin = irq_pin;
+}
+
+/* Plugs a device into the first free root hub port, returns the port. */
+int
+usb_attach_device(usb_t *dev, usb_device_c *device)
+{
+    for (int i = 0; i < USB_NUM_PORTS; i++) {
+        if (dev->ports[i] == NULL) {
+            dev->ports[i] = device;
+            dev->ports_used++;
+
+            /* Connect status and its change, on both port register sets. */
+            dev->uhci_io[0x10 + (i << 1)] |= 0x03;
+            if (device->low_speed)
+                dev->uhci_io[0x11 + (i << 1)] |= 0x01;
+            dev->ohci_mmio[0x54 + (i << 2)] |= 0x01;
+            if (device->low_speed)
+                dev->ohci_mmio[0x55 + (i << 2)] |= 0x02;
+            dev->ohci_mmio[0x56 + (i << 2)] |= 0x01;
+            dev->ohci_mmio[0x0c] |= 0x40;
+            ohci_update_irq(dev);
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void
+usb_detach_device(usb_t *dev, usb_device_c *device)
+{
+    for (int i = 0; i < USB_NUM_PORTS; i++) {
+        if (dev->ports[i] == device) {
+            dev->ports[i] = NULL;
+            dev->ports_used--;
+
+            dev->uhci_io[0x10 + (i << 1)] = (dev->uhci_io[0x10 + (i << 1)] & ~0x05) | 0x02;
+            dev->uhci_io[0x11 + (i << 1)] &= ~0x01;
+            dev->ohci_mmio[0x54 + (i << 2)] &= ~0x03;
+            dev->ohci_mmio[0x55 + (i << 2)] &= ~0x02;
+            dev->ohci_mmio[0x56 + (i << 2)] |= 0x01;
+            dev->ohci_mmio[0x0c] |= 0x40;
+            ohci_update_irq(dev);
+        }
+    }
+}
+
 static void
 usb_reset(void *priv)
 {
     usb_t *dev = (usb_t *) priv;
 
+    timer_disable(&dev->uhci_frame_timer);
+    timer_disable(&dev->ohci_frame_timer);
+    dev->ohci_done_head = 0x00000000;
+    usb_set_irq_level(dev, 0);
+
     memset(dev->uhci_io, 0x00, 128);
     dev->uhci_io[0x0c] = 0x40;
     dev->uhci_io[0x10] = dev->uhci_io[0x12] = 0x80;
@@ -394,6 +897,8 @@ usb_close(void *priv)
 {
     usb_t *dev = (usb_t *) priv;
 
+    timer_disable(&dev->uhci_frame_timer);
+    timer_disable(&dev->ohci_frame_timer);
     free(dev);
 }
 
@@ -420,6 +925,10 @@ usb_init(UNUSED(const device_t *info))
                     ohci_mmio_read, NULL, NULL,
                     ohci_mmio_write, NULL, NULL,
                     NULL, MEM_MAPPING_EXTERNAL, dev);
+
+    timer_add(&dev->uhci_frame_timer, uhci_frame_timer, dev, 0);
+    timer_add(&dev->ohci_frame_timer, ohci_frame_timer, dev, 0);
+
     usb_reset(dev);
 
     return dev;
@@ -44,6 +44,13 @@ agpgart_log(const char *fmt, ...)
 #    define agpgart_log(fmt, ...)
 #endif
 
+static void
+agpgart_flush_tlb(agpgart_t *dev)
+{
+    for (int i = 0; i < AGPGART_TLB_SIZE; i++)
+        dev->tlb[i].page = 0xffffffff;
+}
+
 void
 agpgart_set_aperture(agpgart_t *dev, uint32_t base, uint32_t size, int enable)
 {
@@ -51,6 +58,7 @@ agpgart_set_aperture(agpgart_t *dev, uint32_t base, uint32_t size, int enable)
 
     /* Disable old aperture mapping. */
     mem_mapping_disable(&dev->aperture_mapping);
+    agpgart_flush_tlb(dev);
 
     /* Set new aperture base address, size, mask and enable. */
     dev->aperture_base   = base;
@@ -72,6 +80,7 @@ agpgart_set_gart(agpgart_t *dev, uint32_t base)
 
     /* Set GART base address. */
     dev->gart_base = base;
+    agpgart_flush_tlb(dev);
 }
 
 static uint32_t
@@ -87,46 +96,118 @@ agpgart_translate(uint32_t addr, agpgart_t *dev)
     return gart_ptr | (addr & 0x00000fff);
 }
 
+/* Translations are cached along with host pointers to the GART entry they
+   came from and, where the target page is RAM, to the page itself. An entry
+   is only used while the memory map is unchanged and the GART entry still
+   holds the value it was filled from, so the guest rewriting the table needs
+   no flush; checking it is a host load instead of a mem_readl_phys(). A GART
+   table outside RAM is never cached. */
+static agpgart_tlb_t *
+agpgart_tlb_lookup(uint32_t addr, agpgart_t *dev)
+{
+    uint32_t       page = (addr & dev->aperture_mask) >> 12;
+    agpgart_tlb_t *tlb  = &dev->tlb[page & (AGPGART_TLB_SIZE - 1)];
+    uint32_t       entry;
+
+    if ((tlb->page == page) && (tlb->gen == mem_mapping_gen)) {
+        memcpy(&entry, tlb->entry_ptr, 4);
+        if (entry == tlb->entry)
+            return tlb;
+    }
+
+    tlb->entry_ptr = mem_get_phys_ptr(dev->gart_base + (page << 2), 4, 0);
+    if (tlb->entry_ptr == NULL) {
+        tlb->page = 0xffffffff;
+        return NULL;
+    }
+
+    memcpy(&tlb->entry, tlb->entry_ptr, 4);
+    tlb->page     = page;
+    tlb->gen      = mem_mapping_gen;
+    tlb->phys     = tlb->entry & 0xfffff000;
+    tlb->read_ptr = mem_get_phys_ptr(tlb->phys, 4096, 0);
+
+    return tlb;
+}
+
 static uint8_t
 agpgart_aperture_readb(uint32_t addr, void *priv)
 {
-    agpgart_t *dev = (agpgart_t *) priv;
-    return mem_readb_phys(agpgart_translate(addr, dev));
+    agpgart_t           *dev = (agpgart_t *) priv;
+    const agpgart_tlb_t *tlb = agpgart_tlb_lookup(addr, dev);
+
+    if (tlb == NULL)
+        return mem_readb_phys(agpgart_translate(addr, dev));
+
+    if (tlb->read_ptr != NULL)
+        return tlb->read_ptr[addr & 0x00000fff];
+
+    return mem_readb_phys(tlb->phys | (addr & 0x00000fff));
 }
 
 static uint16_t
 agpgart_aperture_readw(uint32_t addr, void *priv)
 {
-    agpgart_t *dev = (agpgart_t *) priv;
-    return mem_readw_phys(agpgart_translate(addr, dev));
+    agpgart_t           *dev = (agpgart_t *) priv;
+    const agpgart_tlb_t *tlb = agpgart_tlb_lookup(addr, dev);
+    uint16_t             ret;
+
+    if (tlb == NULL)
+        return mem_readw_phys(agpgart_translate(addr, dev));
+
+    if ((tlb->read_ptr != NULL) && ((addr & 0x00000fff) <= 0x00000ffe)) {
+        memcpy(&ret, &tlb->read_ptr[addr & 0x00000fff], 2);
+        return ret;
+    }
+
+    return mem_readw_phys(tlb->phys | (addr & 0x00000fff));
 }
 
 static uint32_t
 agpgart_aperture_readl(uint32_t addr, void *priv)
 {
-    agpgart_t *dev = (agpgart_t *) priv;
-    return mem_readl_phys(agpgart_translate(addr, dev));
+    agpgart_t           *dev = (agpgart_t *) priv;
+    const agpgart_tlb_t *tlb = agpgart_tlb_lookup(addr, dev);
+    uint32_t             ret;
+
+    if (tlb == NULL)
+        return mem_readl_phys(agpgart_translate(addr, dev));
+
+    if ((tlb->read_ptr != NULL) && ((addr & 0x00000fff) <= 0x00000ffc)) {
+        memcpy(&ret, &tlb->read_ptr[addr & 0x00000fff], 4);
+        return ret;
+    }
+
+    return mem_readl_phys(tlb->phys | (addr & 0x00000fff));
 }
 
+/* Writes keep going through the physical accessors so that RAM holding
+   recompiled code still gets invalidated. */
 static void
 agpgart_aperture_writeb(uint32_t addr, uint8_t val, void *priv)
 {
-    agpgart_t *dev = (agpgart_t *) priv;
-    mem_writeb_phys(agpgart_translate(addr, dev), val);
+    agpgart_t           *dev = (agpgart_t *) priv;
+    const agpgart_tlb_t *tlb = agpgart_tlb_lookup(addr, dev);
+
+    mem_writeb_phys(tlb ? (tlb->phys | (addr & 0x00000fff)) : agpgart_translate(addr, dev), val);
 }
 
 static void
 agpgart_aperture_writew(uint32_t addr, uint16_t val, void *priv)
 {
-    agpgart_t *dev = (agpgart_t *) priv;
-    mem_writew_phys(agpgart_translate(addr, dev), val);
+    agpgart_t           *dev = (agpgart_t *) priv;
+    const agpgart_tlb_t *tlb = agpgart_tlb_lookup(addr, dev);
+
+    mem_writew_phys(tlb ? (tlb->phys | (addr & 0x00000fff)) : agpgart_translate(addr, dev), val);
 }
 
 static void
 agpgart_aperture_writel(uint32_t addr, uint32_t val, void *priv)
 {
-    agpgart_t *dev = (agpgart_t *) priv;
-    mem_writel_phys(agpgart_translate(addr, dev), val);
+    agpgart_t           *dev = (agpgart_t *) priv;
+    const agpgart_tlb_t *tlb = agpgart_tlb_lookup(addr, dev);
+
+    mem_writel_phys(tlb ? (tlb->phys | (addr & 0x00000fff)) : agpgart_translate(addr, dev), val);
 }
 
 static void *
@@ -134,6 +215,7 @@ agpgart_init(UNUSED(const device_t *info))
 {
     agpgart_t *dev = malloc(sizeof(agpgart_t));
     memset(dev, 0, sizeof(agpgart_t));
+    agpgart_flush_tlb(dev);
 
     agpgart_log("AGP GART: init()\n");
 
@@ -1224,6 +1224,115 @@ ibm8514_short_stroke_start(int count, int cpu_input, uint32_t mix_dat, uint32_t
     ibm8514_accel_start(count, cpu_input, mix_dat, cpu_dat, svga, len);
 }
 
+/* Row kernel for the rectangle fill and BitBLT loops of the 8514/A and Mach8
+   engines, for the foreground mixes that need nothing but the source and
+   destination pixel: zero, one, XOR and replace. Draws n pixels of row y
+   from x, stepping by xdir, taking the source from src + sx stepping by
+   sxdir when blit is set and from color otherwise. The pixels are processed
+   in the same order as the per-pixel loops, so overlapping blits come out
+   the same, and the ones outside the clip rectangle are left alone.
+
+   Returns 0 without touching anything when the mix is not one of these or
+   the span wraps around the end of memory, so the caller can fall back. */
+int
+ibm8514_accel_row(ibm8514_t *dev, int mix, int blit, uint16_t color, uint16_t wrt_mask,
+                  uint32_t dest, int x, int xdir, int y, uint32_t src, int sx, int sxdir, int n,
+                  int clip_l, int clip_r, int clip_t, int clip_b)
+{
+    uint16_t *vram_w   = (uint16_t *) dev->vram;
+    uint32_t  mask     = dev->bpp ? (dev->vram_mask >> 1) : dev->vram_mask;
+    uint16_t  pix_mask = dev->bpp ? 0xffff : 0xff;
+    int       shift    = dev->bpp ? 11 : 12;
+    uint32_t  d;
+    uint32_t  s = 0;
+    uint32_t  lo;
+    uint32_t  hi;
+    int       i1;
+    int       i2;
+
+    mix &= 0x1f;
+    if ((mix != 0x01) && (mix != 0x02) && (mix != 0x05) && (mix != 0x07))
+        return 0;
+
+    if ((y < clip_t) || (y > clip_b))
+        return 1;
+
+    if (xdir > 0) {
+        i1 = clip_l - x;
+        i2 = clip_r - x;
+    } else {
+        i1 = x - clip_r;
+        i2 = x - clip_l;
+    }
+    i1 = MAX(i1, 0);
+    i2 = MIN(i2, n - 1);
+    if (i1 > i2)
+        return 1;
+    n = i2 - i1 + 1;
+
+    d = (dest + x + (i1 * xdir)) & mask;
+    if ((xdir > 0) ? ((d + n - 1) > mask) : (d < (uint32_t) (n - 1)))
+        return 0;
+    if (blit) {
+        s = (src + sx + (i1 * sxdir)) & mask;
+        if ((sxdir > 0) ? ((s + n - 1) > mask) : (s < (uint32_t) (n - 1)))
+            return 0;
+    }
+
+    lo = (xdir > 0) ? d : (d - (n - 1));
+    hi = (xdir > 0) ? (d + (n - 1)) : d;
+
+    if (!blit && (mix != 0x05) && ((wrt_mask & pix_mask) == pix_mask)) {
+        uint16_t val = (mix == 0x01) ? 0 : ((mix == 0x02) ? 0xffff : color);
+
+        if (dev->bpp) {
+            for (uint32_t i = lo; i <= hi; i++)
+                vram_w[i] = val;
+        } else
+            memset(&dev->vram[lo], val & 0xff, n);
+    } else {
+        for (int i = 0; i < n; i++) {
+            uint16_t src_dat = color;
+            uint16_t dest_dat;
+            uint16_t old_dest_dat;
+
+            if (blit)
+                src_dat = dev->bpp ? vram_w[s] : dev->vram[s];
+            dest_dat     = dev->bpp ? vram_w[d] : dev->vram[d];
+            old_dest_dat = dest_dat;
+
+            switch (mix) {
+                case 0x01:
+                    dest_dat = 0;
+                    break;
+                case 0x02:
+                    dest_dat = ~0;
+                    break;
+                case 0x05:
+                    dest_dat ^= src_dat;
+                    break;
+                default:
+                    dest_dat = src_dat;
+                    break;
+            }
+            dest_dat = (dest_dat & wrt_mask) | (old_dest_dat & ~wrt_mask);
+
+            if (dev->bpp)
+                vram_w[d] = dest_dat;
+            else
+                dev->vram[d] = dest_dat;
+
+            d += xdir;
+            s += sxdir;
+        }
+    }
+
+    for (uint32_t page = lo >> shift; page <= (hi >> shift); page++)
+        dev->changedvram[page] = changeframecount;
+
+    return 1;
+}
+
 void
 ibm8514_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, svga_t *svga, UNUSED(int len))
 {
@@ -2910,8 +3019,34 @@ rect_fill:
                                 }
                             }
                         } else {
+                            /*With the mix data all ones every pixel gets the foreground source,
+                              so all but the last pixel of each row can go through the row kernel.*/
+                            int      fast_fill  = (mix_dat == 0xffffffff) && (compare_mode == 0) && (dev->accel.cmd & 0x10);
+                            uint16_t fill_color = 0;
+
+                            if (frgd_mix == 1)
+                                fill_color = frgd_color;
+                            else if (frgd_mix == 0) {
+                                fill_color = bkgd_color;
+                                if (!bkgd_mix && (dev->accel.cmd & 0x40) && ((dev->accel.frgd_mix & 0x1f) == 7) && ((dev->accel.bkgd_mix & 0x1f) == 3) && !dev->bpp && (bkgd_color == 0x00))
+                                    fill_color = frgd_color;
+                            }
+
                             ibm8514_log("Rectangle Fill Normal CMD=%04x, CURRENT(%d,%d), sx=%d, FR(%02x), linedraw=%d.\n", dev->accel.cmd, dev->accel.cx, dev->accel.cy, dev->accel.sx, frgd_color, dev->accel.linedraw);
                             while (count-- && dev->accel.sy >= 0) {
+                                if (fast_fill && (dev->accel.sx > 0) && ((count < 0) || (count >= dev->accel.sx)) &&
+                                    ibm8514_accel_row(dev, dev->accel.frgd_mix, 0, fill_color, wrt_mask,
+                                                      dev->accel.dest, dev->accel.cx, (dev->accel.cmd & 0x20) ? 1 : -1, dev->accel.cy,
+                                                      0, 0, 0, dev->accel.sx,
+                                                      dev->accel.clip_left, clip_r, dev->accel.clip_top, clip_b)) {
+                                    if (dev->accel.cmd & 0x20)
+                                        dev->accel.cx += dev->accel.sx;
+                                    else
+                                        dev->accel.cx -= dev->accel.sx;
+                                    count -= dev->accel.sx;
+                                    dev->accel.sx = 0;
+                                }
+
                                 if (dev->accel.cx >= dev->accel.clip_left && dev->accel.cx <= clip_r && dev->accel.cy >= dev->accel.clip_top && dev->accel.cy <= clip_b) {
                                     switch ((mix_dat & mix_mask) ? frgd_mix : bkgd_mix) {
                                         case 0:
@@ -3749,6 +3884,24 @@ bitblt:
 
                         ibm8514_log("BitBLT 8514/A=%04x, selfrmix=%d, selbkmix=%d, d(%d,%d), c(%d,%d), pixcntl=%d, sy=%d, frgdmix=%02x, bkgdmix=%02x, rdmask=%02x, wrtmask=%02x, linedraw=%d.\n", dev->accel.cmd, frgd_mix, bkgd_mix, dev->accel.dx, dev->accel.dy, dev->accel.cx, dev->accel.cy, pixcntl, dev->accel.sy, dev->accel.frgd_mix & 0x1f, dev->accel.bkgd_mix & 0x1f, dev->accel.rd_mask, wrt_mask, dev->accel.linedraw);
                         while (count-- && dev->accel.sy >= 0) {
+                            /*Same as the rectangle fill: with no pixel-driven mix select every pixel
+                              gets the foreground source, either a colour or the source pixel.*/
+                            if ((mix_dat == 0xffffffff) && (pixcntl != 3) && (compare_mode == 0) &&
+                                (dev->accel.sx > 0) && ((count < 0) || (count >= dev->accel.sx))) {
+                                uint16_t blt_color = (frgd_mix == 1) ? frgd_color : ((frgd_mix == 0) ? bkgd_color : 0);
+                                int      dir       = (dev->accel.cmd & 0x20) ? 1 : -1;
+
+                                if (ibm8514_accel_row(dev, dev->accel.frgd_mix, frgd_mix == 3, blt_color, wrt_mask,
+                                                      dev->accel.dest, dev->accel.dx, dir, dev->accel.dy,
+                                                      dev->accel.src, dev->accel.cx, dir, dev->accel.sx,
+                                                      dev->accel.clip_left, clip_r, dev->accel.clip_top, clip_b)) {
+                                    dev->accel.dx += dir * dev->accel.sx;
+                                    dev->accel.cx += dir * dev->accel.sx;
+                                    count -= dev->accel.sx;
+                                    dev->accel.sx = 0;
+                                }
+                            }
+
                             if ((dev->accel.dx >= dev->accel.clip_left) && (dev->accel.dx <= clip_r) &&
                                 (dev->accel.dy >= dev->accel.clip_top) && (dev->accel.dy <= clip_b)) {
                                 if (pixcntl == 3) {
@@ -457,7 +457,7 @@ mach64_out(uint16_t addr, uint8_t val, void *priv)
                         svga->ma_latch   = ((svga->crtc[0xc] << 8) | svga->crtc[0xd]) + ((svga->crtc[8] & 0x60) >> 5);
                     } else {
                         svga->fullchange = svga->monitor->mon_changeframecount;
-                        svga_recalctimings(svga);
+                        svga_recalctimings_crtc(svga);
                     }
                 }
             }
@@ -1561,6 +1561,187 @@ mach64_start_line(mach64_t *mach64)
         svga->changedvram[(((addr) >> 3) & mach64->vram_mask) >> 12] = svga->monitor->mon_changeframecount;    \
     }
 
+/* Row kernel for rectangles where every pixel takes the same path through
+   mach64_blit(): foreground always selected, a solid colour or a blit source
+   of the destination depth, and a zero, one, XOR or replace mix, with no
+   colour compare, polygon outline or 24bpp rotation. Draws all but the last
+   pixel of the row from its start, clipping the span against the scissor
+   once, and leaves the last one to mach64_blit() so that the end of row
+   handling stays in one place. Returns the number of pixels drawn. */
+static int
+mach64_rect_row(mach64_t *mach64)
+{
+    svga_t  *svga   = &mach64->svga;
+    int      n      = mach64->accel.dst_width - 1;
+    int      xinc   = mach64->accel.xinc;
+    int      size   = mach64->accel.dst_size;
+    int      bpp    = 1 << size;
+    int      mix_fg = mach64->accel.mix_fg;
+    int      blit   = mach64->accel.source_fg == SRC_BLITSRC;
+    uint32_t pix_mask;
+    uint32_t color = 0;
+    uint32_t wm;
+    uint32_t d;
+    uint32_t s = 0;
+    uint32_t lo;
+    uint32_t hi;
+    int      dst_x;
+    int      dst_y;
+    int      src_x = 0;
+    int      src_y;
+    int      i1;
+    int      i2;
+    int      src_wraps;
+
+    if (mach64->accel.dst_x || (mach64->accel.x_count != mach64->accel.dst_width) || (n < 1))
+        return 0;
+    if (mach64->accel.source_host || (mach64->accel.source_mix != MONO_SRC_1) || (size > 2) ||
+        (mach64->dst_cntl & (DST_POLYGON_EN | DST_24_ROT_EN)) ||
+        (mach64->accel.clr_cmp_fn == 1) || (mach64->accel.clr_cmp_fn == 4) || (mach64->accel.clr_cmp_fn == 5))
+        return 0;
+    if ((mix_fg != 0x1) && (mix_fg != 0x2) && (mix_fg != 0x5) && (mix_fg != 0x7))
+        return 0;
+
+    switch (mach64->accel.source_fg) {
+        case SRC_FG:
+            color = mach64->accel.dp_frgd_clr;
+            break;
+        case SRC_BG:
+            color = mach64->accel.dp_bkgd_clr;
+            break;
+        case SRC_BLITSRC:
+            if (mach64->accel.src_size != size)
+                return 0;
+            break;
+        default:
+            if ((mix_fg == 0x5) || (mix_fg == 0x7))
+                return 0;
+            break;
+    }
+
+    /* A tiled source that restarts within the row only matters if it is read;
+       otherwise the end of the row resets the source position anyway. */
+    src_wraps = !(mach64->src_cntl & SRC_LINEAR_EN) && (mach64->accel.src_x_count <= n);
+    if (blit && src_wraps)
+        return 0;
+
+    dst_x = mach64->accel.dst_x_start;
+    dst_y = (mach64->accel.dst_y + mach64->accel.dst_y_start) & 0x3fff;
+    if ((dst_x < 0) || (dst_x > 0xfff) || ((dst_x + ((n - 1) * xinc)) < 0) || ((dst_x + ((n - 1) * xinc)) > 0xfff))
+        return 0;
+
+    if (mach64->src_cntl & SRC_LINEAR_EN)
+        src_x = mach64->accel.src_x;
+    else {
+        src_x = (mach64->accel.src_x + mach64->accel.src_x_start) & 0xfff;
+        if (blit && (((src_x + ((n - 1) * xinc)) < 0) || ((src_x + ((n - 1) * xinc)) > 0xfff)))
+            return 0;
+    }
+    src_y = (mach64->accel.src_y + mach64->accel.src_y_start) & 0x3fff;
+
+    if (xinc > 0) {
+        i1 = mach64->accel.sc_left - dst_x;
+        i2 = mach64->accel.sc_right - dst_x;
+    } else {
+        i1 = dst_x - mach64->accel.sc_right;
+        i2 = dst_x - mach64->accel.sc_left;
+    }
+    i1 = MAX(i1, 0);
+    i2 = MIN(i2, n - 1);
+
+    if ((dst_y >= mach64->accel.sc_top) && (dst_y <= mach64->accel.sc_bottom) && (i1 <= i2)) {
+        int cnt = i2 - i1 + 1;
+        int step = xinc * bpp;
+
+        d = ((mach64->accel.dst_offset + (dst_y * mach64->accel.dst_pitch) + dst_x + (i1 * xinc)) << size) & mach64->vram_mask;
+        if ((xinc > 0) ? ((d + (cnt * bpp) - 1) > mach64->vram_mask) : (d < (uint32_t) ((cnt - 1) * bpp)))
+            return 0;
+        if (blit) {
+            s = ((mach64->accel.src_offset + (src_y * mach64->accel.src_pitch) + src_x + (i1 * xinc)) << size) & mach64->vram_mask;
+            if ((xinc > 0) ? ((s + (cnt * bpp) - 1) > mach64->vram_mask) : (s < (uint32_t) ((cnt - 1) * bpp)))
+                return 0;
+        }
+
+        pix_mask = (size == 2) ? 0xffffffff : ((1 << (8 << size)) - 1);
+        wm       = mach64->accel.write_mask;
+        lo       = (xinc > 0) ? d : (d - ((cnt - 1) * bpp));
+        hi       = (xinc > 0) ? (d + (cnt * bpp) - 1) : (d + bpp - 1);
+
+        if (!blit && (mix_fg != 0x5) && ((wm & pix_mask) == pix_mask)) {
+            uint32_t val = (mix_fg == 0x1) ? 0 : ((mix_fg == 0x2) ? 0xffffffff : color);
+
+            if (size == 0)
+                memset(&svga->vram[lo], val & 0xff, cnt);
+            else if (size == 1) {
+                for (uint32_t addr = lo; addr < hi; addr += 2)
+                    *(uint16_t *) &svga->vram[addr] = val;
+            } else {
+                for (uint32_t addr = lo; addr < hi; addr += 4)
+                    *(uint32_t *) &svga->vram[addr] = val;
+            }
+        } else {
+            for (int i = 0; i < cnt; i++) {
+                uint32_t src_dat = color;
+                uint32_t dest_dat;
+                uint32_t old_dest_dat;
+
+                if (size == 0) {
+                    if (blit)
+                        src_dat = svga->vram[s];
+                    dest_dat = svga->vram[d];
+                } else if (size == 1) {
+                    if (blit)
+                        src_dat = *(uint16_t *) &svga->vram[s];
+                    dest_dat = *(uint16_t *) &svga->vram[d];
+                } else {
+                    if (blit)
+                        src_dat = *(uint32_t *) &svga->vram[s];
+                    dest_dat = *(uint32_t *) &svga->vram[d];
+                }
+                old_dest_dat = dest_dat;
+
+                switch (mix_fg) {
+                    case 0x1:
+                        dest_dat = 0;
+                        break;
+                    case 0x2:
+                        dest_dat = 0xffffffff;
+                        break;
+                    case 0x5:
+                        dest_dat ^= src_dat;
+                        break;
+                    default:
+                        dest_dat = src_dat;
+                        break;
+                }
+                dest_dat = (dest_dat & wm) | (old_dest_dat & ~wm);
+
+                if (size == 0)
+                    svga->vram[d] = dest_dat;
+                else if (size == 1)
+                    *(uint16_t *) &svga->vram[d] = dest_dat;
+                else
+                    *(uint32_t *) &svga->vram[d] = dest_dat;
+
+                d += step;
+                s += step;
+            }
+        }
+
+        for (uint32_t page = lo >> 12; page <= (hi >> 12); page++)
+            svga->changedvram[page] = svga->monitor->mon_changeframecount;
+    }
+
+    mach64->accel.src_x += n * xinc;
+    mach64->accel.dst_x += n * xinc;
+    if (!(mach64->src_cntl & SRC_LINEAR_EN) && !src_wraps)
+        mach64->accel.src_x_count -= n;
+    mach64->accel.x_count -= n;
+    mach64->accel.xx_count = n % 3;
+
+    return n;
+}
+
 void
 mach64_blit(uint32_t cpu_dat, int count, mach64_t *mach64)
 {
@@ -1586,6 +1767,9 @@ mach64_blit(uint32_t cpu_dat, int count, mach64_t *mach64)
                 int      src_x;
                 int      src_y;
 
+                if (!mach64->accel.dst_x && ((count < 0) || (count > mach64->accel.dst_width)))
+                    count -= mach64_rect_row(mach64);
+
                 dst_x = (mach64->accel.dst_x + mach64->accel.dst_x_start) & 0xfff;
                 dst_y = (mach64->accel.dst_y + mach64->accel.dst_y_start) & 0x3fff;
 
@@ -1013,6 +1013,36 @@ skip_dx:
             }
 
             while (count--) {
+                /*With the foreground always selected, no colour compare and no polygon
+                  fill, a run of pixels that ends before the row or the source does can
+                  go through the row kernel; the pattern index these pixels would step
+                  is recomputed at the end of the row anyway.*/
+                if (!cpu_input && (mono_src == 0) && (compare_mode == 0) && ((frgd_sel <= 1) || (frgd_sel == 3)) &&
+                    ((mach->accel.dp_config & 0x13) == 0x11) && !(mach->accel.linedraw_opt & 0x02) && (dev->accel.dx < 0x600)) {
+                    int src_moves = (frgd_sel == 3) || (bkgd_sel == 3);
+                    int n         = mach->accel.width - 1 - dev->accel.sx;
+
+                    if (mach->accel.stepx > 0)
+                        n = MIN(n, 0x5ff - dev->accel.dx);
+                    if (src_moves)
+                        n = MIN(n, mach->accel.src_width - 1 - mach->accel.sx);
+
+                    if ((n > 0) && ((count < 0) || (count >= n)) &&
+                        ibm8514_accel_row(dev, dev->accel.frgd_mix, frgd_sel == 3,
+                                          (frgd_sel == 1) ? dev->accel.frgd_color : dev->accel.bkgd_color, wrt_mask,
+                                          dev->accel.dest, dev->accel.dx, mach->accel.stepx, dev->accel.dy,
+                                          dev->accel.src, dev->accel.cx, mach->accel.src_stepx, n,
+                                          clip_l, clip_r, clip_t, clip_b)) {
+                        if (src_moves) {
+                            dev->accel.cx += n * mach->accel.src_stepx;
+                            mach->accel.sx += n;
+                        }
+                        dev->accel.dx += n * mach->accel.stepx;
+                        dev->accel.sx += n;
+                        count -= n;
+                    }
+                }
+
                 switch (mono_src) {
                     case 0:
                         mix = 1;
@@ -2330,7 +2360,7 @@ mach_out(uint16_t addr, uint8_t val, void *priv)
                         svga->ma_latch   = ((svga->crtc[0xc] << 8) | svga->crtc[0xd]) + ((svga->crtc[8] & 0x60) >> 5);
                     } else {
                         svga->fullchange = changeframecount;
-                        svga_recalctimings(svga);
+                        svga_recalctimings_crtc(svga);
                     }
                 }
             }
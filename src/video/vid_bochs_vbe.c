@@ -593,7 +593,7 @@ bochs_vbe_out(uint16_t addr, uint8_t val, void *priv)
                         svga->ma_latch   = ((svga->crtc[0xc] << 8) | svga->crtc[0xd]) + ((svga->crtc[8] & 0x60) >> 5);
                     } else {
                         svga->fullchange = changeframecount;
-                        svga_recalctimings(svga);
+                        svga_recalctimings_crtc(svga);
                     }
                 }
             }
@@ -265,16 +265,10 @@ cga_render(cga_t *cga, int line)
             } else
                 cols[0] = (attr >> 4) + 16;
             if (drawcursor) {
-                for (c = 0; c < 8; c++) {
-                    buffer32->line[line][(x << 3) + c + 8]
-                        = cols[(fontdat[chr + cga->fontbase][cga->sc & 7] & (1 << (c ^ 7))) ? 1 : 0] ^ 15;
-                }
-            } else {
-                for (c = 0; c < 8; c++) {
-                    buffer32->line[line][(x << 3) + c + 8]
-                        = cols[(fontdat[chr + cga->fontbase][cga->sc & 7] & (1 << (c ^ 7))) ? 1 : 0];
-                }
+                cols[0] ^= 15;
+                cols[1] ^= 15;
             }
+            video_glyph_row(&buffer32->line[line][(x << 3) + 8], fontdat[chr + cga->fontbase][cga->sc & 7], cols[1], cols[0]);
             cga->ma++;
         }
     } else if (!(cga->cgamode & 2)) {
@@ -294,18 +288,10 @@ cga_render(cga_t *cga, int line)
                 cols[0] = (attr >> 4) + 16;
             cga->ma++;
             if (drawcursor) {
-                for (c = 0; c < 8; c++) {
-                    buffer32->line[line][(x << 4) + (c << 1) + 8]
-                        = buffer32->line[line][(x << 4) + (c << 1) + 9]
-                        = cols[(fontdat[chr + cga->fontbase][cga->sc & 7] & (1 << (c ^ 7))) ? 1 : 0] ^ 15;
-                }
-            } else {
-                for (c = 0; c < 8; c++) {
-                    buffer32->line[line][(x << 4) + (c << 1) + 8]
-                        = buffer32->line[line][(x << 4) + (c << 1) + 9] 
-                        = cols[(fontdat[chr + cga->fontbase][cga->sc & 7] & (1 << (c ^ 7))) ? 1 : 0];
-                }
+                cols[0] ^= 15;
+                cols[1] ^= 15;
             }
+            video_glyph_row_wide(&buffer32->line[line][(x << 4) + 8], fontdat[chr + cga->fontbase][cga->sc & 7], cols[1], cols[0]);
         }
     } else if (!(cga->cgamode & 16)) {
         cols[0] = (cga->cgacol & 15) | 16;
@@ -29,6 +29,17 @@
 #include <86box/vid_cga.h>
 #include <86box/vid_cga_comp.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    ifdef __SSE4_1__
+#        include <smmintrin.h>
+#    endif
+#    define CGA_COMP_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define CGA_COMP_NEON
+#endif
+
 int CGA_Composite_Table[1024];
 
 static double brightness = 0;
@@ -86,6 +97,8 @@ int    tandy_mode_control = 0;
 
 static bool new_cga = 0;
 
+static uint32_t composite_gen = 1;
+
 void
 update_cga16_color(uint8_t cgamode)
 {
@@ -170,6 +183,10 @@ update_cga16_color(uint8_t cgamode)
     video_bi        = (int) (bi * iq_adjust_i + bq * iq_adjust_q);
     video_bq        = (int) (-bi * iq_adjust_q + bq * iq_adjust_i);
     video_sharpness = (int) (sharpness * 256 / 100);
+
+    /* Lines cached with the old settings are out of date. */
+    if (++composite_gen == 0)
+        composite_gen = 1;
 }
 
 static uint8_t
@@ -182,68 +199,238 @@ byte_clamp(int v)
 /* 2048x1536 is the maximum we can possibly support. */
 #define SCALER_MAXWIDTH 2048
 
-static int temp[SCALER_MAXWIDTH + 10] = { 0 };
-static int atemp[SCALER_MAXWIDTH + 2] = { 0 };
-static int btemp[SCALER_MAXWIDTH + 2] = { 0 };
+/* Padded so that the vector loops can run past the end of the line. */
+static int temp[SCALER_MAXWIDTH + 16] = { 0 };
+static int atemp[SCALER_MAXWIDTH + 8] = { 0 };
+static int btemp[SCALER_MAXWIDTH + 8] = { 0 };
+
+#if defined(CGA_COMP_SSE2) || defined(CGA_COMP_NEON)
+/* The signal with the chroma taken out, (temp << 3) - atemp. */
+static int mtemp[SCALER_MAXWIDTH + 8] = { 0 };
+#endif
+
+/* Decoded lines, looked up by their input so that lines which did not change
+   since the last frame are copied instead of decoded again. The colour
+   settings are part of the key through composite_gen. */
+#define COMP_CACHE_LINES 512
+
+typedef struct comp_cache_t {
+    uint32_t  hash;
+    uint32_t  gen;
+    int       w;
+    uint8_t   mono;
+    uint8_t   border;
+    int       size;
+    uint32_t *in; /* Input nibbles, eight to a word. */
+    uint32_t *out;
+} comp_cache_t;
+
+static comp_cache_t comp_cache[COMP_CACHE_LINES];
+static uint32_t     comp_cache_key[(SCALER_MAXWIDTH + 7) / 8];
+
+#if defined(CGA_COMP_SSE2)
+static inline __m128i
+composite_mullo(__m128i a, __m128i b)
+{
+#    ifdef __SSE4_1__
+    return _mm_mullo_epi32(a, b);
+#    else
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd  = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#    endif
+}
 
-uint32_t *
-Composite_Process(uint8_t cgamode, uint8_t border, uint32_t blocks /*, bool doublewidth*/, uint32_t *TempLine)
+/* byte_clamp() on four lanes, left in the low byte of each. */
+static inline __m128i
+composite_clamp(__m128i v)
 {
-    uint32_t x2;
+    v = _mm_srai_epi32(v, 13);
+    v = _mm_packs_epi32(v, v);
+    v = _mm_packus_epi16(v, v);
+    v = _mm_unpacklo_epi8(v, _mm_setzero_si128());
+    return _mm_unpacklo_epi16(v, _mm_setzero_si128());
+}
 
-    int w = blocks * 4;
+static inline __m128i
+composite_luma(const int *i, __m128i sharp)
+{
+    __m128i c = _mm_slli_epi32(_mm_loadu_si128((const __m128i *) i), 1);
+    __m128i d = _mm_add_epi32(_mm_loadu_si128((const __m128i *) &i[-1]), _mm_loadu_si128((const __m128i *) &i[1]));
 
-    int            *o;
-    const uint32_t *rgbi;
-    const int      *b;
-    int            *i;
-    uint32_t       *srgb;
-    int            *ap;
-    int            *bp;
-
-#define COMPOSITE_CONVERT(I, Q)                                                  \
-    do {                                                                         \
-        i[1] = (i[1] << 3) - ap[1];                                              \
-        a    = ap[0];                                                            \
-        b    = bp[0];                                                            \
-        c    = i[0] + i[0];                                                      \
-        d    = i[-1] + i[1];                                                     \
-        y    = ((c + d) << 8) + video_sharpness * (c - d);                       \
-        rr   = y + video_ri * (I) + video_rq * (Q);                              \
-        gg   = y + video_gi * (I) + video_gq * (Q);                              \
-        bb   = y + video_bi * (I) + video_bq * (Q);                              \
-        ++i;                                                                     \
-        ++ap;                                                                    \
-        ++bp;                                                                    \
-        *srgb = (byte_clamp(rr) << 16) | (byte_clamp(gg) << 8) | byte_clamp(bb); \
-        ++srgb;                                                                  \
-    } while (0)
+    return _mm_add_epi32(_mm_slli_epi32(_mm_add_epi32(c, d), 8), composite_mullo(sharp, _mm_sub_epi32(c, d)));
+}
+#elif defined(CGA_COMP_NEON)
+static inline uint32x4_t
+composite_clamp(int32x4_t v)
+{
+    int16x4_t h = vqmovn_s32(vshrq_n_s32(v, 13));
+    uint8x8_t b = vqmovun_s16(vcombine_s16(h, h));
 
-#define OUT(v)    \
-    do {          \
-        *o = (v); \
-        ++o;      \
-    } while (0)
+    return vmovl_u16(vget_low_u16(vmovl_u8(b)));
+}
 
-    /* Simulate CGA composite output */
-    o    = temp;
-    rgbi = TempLine;
-    b    = &CGA_Composite_Table[border * 68];
-    for (uint8_t x = 0; x < 4; ++x)
-        OUT(b[(x + 3) & 3]);
-    OUT(CGA_Composite_Table[(border << 6) | ((*rgbi & 0x0f) << 2) | 3]);
-    for (int x = 0; x < w - 1; ++x) {
-        OUT(CGA_Composite_Table[((rgbi[0] & 0x0f) << 6) | ((rgbi[1] & 0x0f) << 2) | (x & 3)]);
-        ++rgbi;
+static inline int32x4_t
+composite_luma(const int *i, int32x4_t sharp)
+{
+    int32x4_t c = vshlq_n_s32(vld1q_s32(i), 1);
+    int32x4_t d = vaddq_s32(vld1q_s32(&i[-1]), vld1q_s32(&i[1]));
+
+    return vaddq_s32(vshlq_n_s32(vaddq_s32(c, d), 8), vmulq_s32(sharp, vsubq_s32(c, d)));
+}
+#endif
+
+#if defined(CGA_COMP_SSE2) || defined(CGA_COMP_NEON)
+/* Four pixels at a time: one colour clock, phases 0 to 3 in the lanes. With
+   the (I, Q) pairs being (a, b), (-b, a), (-a, -b) and (b, -a) for the four
+   phases, each channel is y + ka * a + kb * b with per-lane coefficients. */
+static void
+composite_decode(uint8_t mono, uint32_t blocks, uint32_t *srgb)
+{
+    const int *i    = temp + 5;
+    const int  ri   = (int) video_ri;
+    const int  rq   = (int) video_rq;
+    const int  gi   = (int) video_gi;
+    const int  gq   = (int) video_gq;
+    const int  bi   = (int) video_bi;
+    const int  bq   = (int) video_bq;
+    const int  w    = blocks * 4;
+    const int  ka[3][4] = { { ri, rq, -ri, -rq }, { gi, gq, -gi, -gq }, { bi, bq, -bi, -bq } };
+    const int  kb[3][4] = { { rq, -ri, -rq, ri }, { gq, -gi, -gq, gi }, { bq, -bi, -bq, bi } };
+    int        x;
+
+#    if defined(CGA_COMP_SSE2)
+    const __m128i sharp = _mm_set1_epi32(video_sharpness);
+
+    if (mono) {
+        for (x = 0; x < w; x += 4) {
+            __m128i y = composite_clamp(_mm_slli_epi32(composite_luma(&i[x], sharp), 3));
+
+            _mm_storeu_si128((__m128i *) &srgb[x], _mm_or_si128(_mm_or_si128(y, _mm_slli_epi32(y, 8)), _mm_slli_epi32(y, 16)));
+        }
+        return;
+    }
+
+    /* Store chroma, and the signal without it. */
+    for (x = -1; x < (w + 1); x += 4) {
+        const int *p  = &temp[x + 5];
+        __m128i    ap = _mm_add_epi32(_mm_sub_epi32(_mm_loadu_si128((const __m128i *) &p[-4]),
+                                                    _mm_slli_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_loadu_si128((const __m128i *) &p[-2]),
+                                                                                               _mm_loadu_si128((const __m128i *) p)),
+                                                                                 _mm_loadu_si128((const __m128i *) &p[2])),
+                                                                   1)),
+                                      _mm_loadu_si128((const __m128i *) &p[4]));
+        __m128i    bp = _mm_slli_epi32(_mm_sub_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_loadu_si128((const __m128i *) &p[-3]),
+                                                                                 _mm_loadu_si128((const __m128i *) &p[-1])),
+                                                                   _mm_loadu_si128((const __m128i *) &p[1])),
+                                                     _mm_loadu_si128((const __m128i *) &p[3])),
+                                       1);
+
+        _mm_storeu_si128((__m128i *) &atemp[x + 1], ap);
+        _mm_storeu_si128((__m128i *) &btemp[x + 1], bp);
+        _mm_storeu_si128((__m128i *) &mtemp[x + 1], _mm_sub_epi32(_mm_slli_epi32(_mm_loadu_si128((const __m128i *) p), 3), ap));
+    }
+
+    {
+        const __m128i kra = _mm_loadu_si128((const __m128i *) ka[0]);
+        const __m128i krb = _mm_loadu_si128((const __m128i *) kb[0]);
+        const __m128i kga = _mm_loadu_si128((const __m128i *) ka[1]);
+        const __m128i kgb = _mm_loadu_si128((const __m128i *) kb[1]);
+        const __m128i kba = _mm_loadu_si128((const __m128i *) ka[2]);
+        const __m128i kbb = _mm_loadu_si128((const __m128i *) kb[2]);
+
+        for (x = 0; x < w; x += 4) {
+            __m128i a  = _mm_loadu_si128((const __m128i *) &atemp[x + 1]);
+            __m128i b  = _mm_loadu_si128((const __m128i *) &btemp[x + 1]);
+            __m128i y  = composite_luma(&mtemp[x + 1], sharp);
+            __m128i rr = composite_clamp(_mm_add_epi32(y, _mm_add_epi32(composite_mullo(kra, a), composite_mullo(krb, b))));
+            __m128i gg = composite_clamp(_mm_add_epi32(y, _mm_add_epi32(composite_mullo(kga, a), composite_mullo(kgb, b))));
+            __m128i bb = composite_clamp(_mm_add_epi32(y, _mm_add_epi32(composite_mullo(kba, a), composite_mullo(kbb, b))));
+
+            _mm_storeu_si128((__m128i *) &srgb[x], _mm_or_si128(_mm_or_si128(_mm_slli_epi32(rr, 16), _mm_slli_epi32(gg, 8)), bb));
+        }
+    }
+#    else
+    const int32x4_t sharp = vdupq_n_s32(video_sharpness);
+
+    if (mono) {
+        for (x = 0; x < w; x += 4) {
+            uint32x4_t y = composite_clamp(vshlq_n_s32(composite_luma(&i[x], sharp), 3));
+
+            vst1q_u32(&srgb[x], vorrq_u32(vorrq_u32(y, vshlq_n_u32(y, 8)), vshlq_n_u32(y, 16)));
+        }
+        return;
     }
-    OUT(CGA_Composite_Table[((*rgbi & 0x0f) << 6) | (border << 2) | 3]);
-    for (uint8_t x = 0; x < 5; ++x)
-        OUT(b[x & 3]);
 
-    if ((cgamode & 4) != 0) {
+    /* Store chroma, and the signal without it. */
+    for (x = -1; x < (w + 1); x += 4) {
+        const int *p  = &temp[x + 5];
+        int32x4_t  ap = vaddq_s32(vsubq_s32(vld1q_s32(&p[-4]),
+                                            vshlq_n_s32(vaddq_s32(vsubq_s32(vld1q_s32(&p[-2]), vld1q_s32(p)), vld1q_s32(&p[2])), 1)),
+                                  vld1q_s32(&p[4]));
+        int32x4_t  bp = vshlq_n_s32(vsubq_s32(vaddq_s32(vsubq_s32(vld1q_s32(&p[-3]), vld1q_s32(&p[-1])), vld1q_s32(&p[1])),
+                                              vld1q_s32(&p[3])),
+                                    1);
+
+        vst1q_s32(&atemp[x + 1], ap);
+        vst1q_s32(&btemp[x + 1], bp);
+        vst1q_s32(&mtemp[x + 1], vsubq_s32(vshlq_n_s32(vld1q_s32(p), 3), ap));
+    }
+
+    {
+        const int32x4_t kra = vld1q_s32(ka[0]);
+        const int32x4_t krb = vld1q_s32(kb[0]);
+        const int32x4_t kga = vld1q_s32(ka[1]);
+        const int32x4_t kgb = vld1q_s32(kb[1]);
+        const int32x4_t kba = vld1q_s32(ka[2]);
+        const int32x4_t kbb = vld1q_s32(kb[2]);
+
+        for (x = 0; x < w; x += 4) {
+            int32x4_t  a  = vld1q_s32(&atemp[x + 1]);
+            int32x4_t  b  = vld1q_s32(&btemp[x + 1]);
+            int32x4_t  y  = composite_luma(&mtemp[x + 1], sharp);
+            uint32x4_t rr = composite_clamp(vmlaq_s32(vmlaq_s32(y, kra, a), krb, b));
+            uint32x4_t gg = composite_clamp(vmlaq_s32(vmlaq_s32(y, kga, a), kgb, b));
+            uint32x4_t bb = composite_clamp(vmlaq_s32(vmlaq_s32(y, kba, a), kbb, b));
+
+            vst1q_u32(&srgb[x], vorrq_u32(vorrq_u32(vshlq_n_u32(rr, 16), vshlq_n_u32(gg, 8)), bb));
+        }
+    }
+#    endif
+}
+#else
+static void
+composite_decode(uint8_t mono, uint32_t blocks, uint32_t *srgb)
+{
+    uint32_t x2;
+    int      w = blocks * 4;
+    int     *i;
+    int     *ap;
+    int     *bp;
+
+#    define COMPOSITE_CONVERT(I, Q)                                                  \
+        do {                                                                         \
+            i[1] = (i[1] << 3) - ap[1];                                              \
+            a    = ap[0];                                                            \
+            b    = bp[0];                                                            \
+            c    = i[0] + i[0];                                                      \
+            d    = i[-1] + i[1];                                                     \
+            y    = ((c + d) << 8) + video_sharpness * (c - d);                       \
+            rr   = y + video_ri * (I) + video_rq * (Q);                              \
+            gg   = y + video_gi * (I) + video_gq * (Q);                              \
+            bb   = y + video_bi * (I) + video_bq * (Q);                              \
+            ++i;                                                                     \
+            ++ap;                                                                    \
+            ++bp;                                                                    \
+            *srgb = (byte_clamp(rr) << 16) | (byte_clamp(gg) << 8) | byte_clamp(bb); \
+            ++srgb;                                                                  \
+        } while (0)
+
+    if (mono) {
         /* Decode */
-        i    = temp + 5;
-        srgb = TempLine;
+        i = temp + 5;
         for (x2 = 0; x2 < blocks * 4; ++x2) {
             int c = (i[0] + i[0]) << 3;
             int d = (i[-1] + i[1]) << 3;
@@ -267,7 +454,6 @@ Composite_Process(uint8_t cgamode, uint8_t border, uint32_t blocks /*, bool doub
         i     = temp + 5;
         i[-1] = (i[-1] << 3) - ap[-1];
         i[0]  = (i[0] << 3) - ap[0];
-        srgb  = TempLine;
         for (x2 = 0; x2 < blocks; ++x2) {
             int y;
             int a;
@@ -283,9 +469,109 @@ Composite_Process(uint8_t cgamode, uint8_t border, uint32_t blocks /*, bool doub
             COMPOSITE_CONVERT(b, -a);
         }
     }
-#undef COMPOSITE_CONVERT
+#    undef COMPOSITE_CONVERT
+}
+#endif
+
+/* Returns the cache entry for the line, and whether it holds it already. */
+static comp_cache_t *
+composite_cache_lookup(uint8_t mono, uint8_t border, int w, const uint32_t *rgbi, int *hit)
+{
+    comp_cache_t *entry;
+    uint32_t      hash  = 2166136261u ^ (mono << 4) ^ border;
+    int           words = (w + 7) >> 3;
+
+    memset(comp_cache_key, 0x00, words * sizeof(uint32_t));
+    for (int x = 0; x < w; x++)
+        comp_cache_key[x >> 3] |= (rgbi[x] & 0x0f) << ((x & 7) << 2);
+    for (int x = 0; x < words; x++)
+        hash = (hash ^ comp_cache_key[x]) * 16777619u;
+    hash ^= (uint32_t) w * 0x9e3779b9u;
+
+    entry = &comp_cache[hash & (COMP_CACHE_LINES - 1)];
+    *hit  = (entry->gen == composite_gen) && (entry->hash == hash) && (entry->w == w) &&
+           (entry->mono == mono) && (entry->border == border) &&
+           !memcmp(entry->in, comp_cache_key, words * sizeof(uint32_t));
+
+    if (!*hit) {
+        if (entry->size < w) {
+            free(entry->in);
+            free(entry->out);
+            entry->in   = (uint32_t *) malloc(((w + 7) >> 3) * sizeof(uint32_t));
+            entry->out  = (uint32_t *) malloc(w * sizeof(uint32_t));
+            entry->size = w;
+            if ((entry->in == NULL) || (entry->out == NULL)) {
+                free(entry->in);
+                free(entry->out);
+                entry->in   = NULL;
+                entry->out  = NULL;
+                entry->size = 0;
+                entry->gen  = 0;
+                return NULL;
+            }
+        }
+        entry->hash   = hash;
+        entry->w      = w;
+        entry->mono   = mono;
+        entry->border = border;
+        entry->gen    = 0;
+        memcpy(entry->in, comp_cache_key, words * sizeof(uint32_t));
+    }
+
+    return entry;
+}
+
+uint32_t *
+Composite_Process(uint8_t cgamode, uint8_t border, uint32_t blocks /*, bool doublewidth*/, uint32_t *TempLine)
+{
+    int             w     = blocks * 4;
+    uint8_t         mono  = ((cgamode & 4) != 0);
+    comp_cache_t   *entry = NULL;
+    int             hit   = 0;
+    int            *o;
+    const uint32_t *rgbi;
+    const int      *b;
+
+#define OUT(v)    \
+    do {          \
+        *o = (v); \
+        ++o;      \
+    } while (0)
+
+    if (w > SCALER_MAXWIDTH)
+        return TempLine;
+
+    if (vid_cga_comp_cache) {
+        entry = composite_cache_lookup(mono, border, w, TempLine, &hit);
+        if (hit) {
+            memcpy(TempLine, entry->out, w * sizeof(uint32_t));
+            return TempLine;
+        }
+    }
+
+    /* Simulate CGA composite output */
+    o    = temp;
+    rgbi = TempLine;
+    b    = &CGA_Composite_Table[border * 68];
+    for (uint8_t x = 0; x < 4; ++x)
+        OUT(b[(x + 3) & 3]);
+    OUT(CGA_Composite_Table[(border << 6) | ((*rgbi & 0x0f) << 2) | 3]);
+    for (int x = 0; x < w - 1; ++x) {
+        OUT(CGA_Composite_Table[((rgbi[0] & 0x0f) << 6) | ((rgbi[1] & 0x0f) << 2) | (x & 3)]);
+        ++rgbi;
+    }
+    OUT(CGA_Composite_Table[((*rgbi & 0x0f) << 6) | (border << 2) | 3]);
+    for (uint8_t x = 0; x < 5; ++x)
+        OUT(b[x & 3]);
 #undef OUT
 
+    composite_decode(mono, blocks, TempLine);
+
+    if (entry != NULL) {
+        memcpy(entry->out, TempLine, w * sizeof(uint32_t));
+        entry->gen = composite_gen;
+    }
+
     return TempLine;
 }
 
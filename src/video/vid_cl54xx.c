@@ -1219,7 +1219,7 @@ gd54xx_out(uint16_t addr, uint8_t val, void *priv)
                         svga->ma_latch   = ((svga->crtc[0xc] << 8) | svga->crtc[0xd]) + ((svga->crtc[8] & 0x60) >> 5);
                     } else {
                         svga->fullchange = changeframecount;
-                        svga_recalctimings(svga);
+                        svga_recalctimings_crtc(svga);
                     }
                 }
             }
@@ -2184,6 +2184,39 @@ gd54xx_mem_sys_src_write(gd54xx_t *gd54xx, uint8_t val, uint8_t ap)
     }
 }
 
+/* A whole dword of host data; goes straight to the blitter when it starts a
+   new dword, instead of being assembled one byte at a time. */
+static void
+gd54xx_mem_sys_src_writel(gd54xx_t *gd54xx, uint32_t val, uint8_t ap)
+{
+    if (gd54xx->blt.sys_cnt != 0) {
+        for (uint8_t i = 0; i < 4; i++)
+            gd54xx_mem_sys_src_write(gd54xx, (val >> (i << 3)) & 0xff, ap);
+        return;
+    }
+
+    if ((gd54xx->blt.mode & CIRRUS_BLTMODE_COLOREXPAND) &&
+        !(gd54xx->blt.modeext & CIRRUS_BLTMODEEXT_DWORDGRANULARITY)) {
+        switch (ap) {
+            case 1:
+                val = ((val & 0x00ff00ff) << 8) | ((val >> 8) & 0x00ff00ff);
+                break;
+            case 2:
+                val = (val << 24) | ((val & 0x0000ff00) << 8) | ((val >> 8) & 0x0000ff00) | (val >> 24);
+                break;
+
+            default:
+                break;
+        }
+        gd54xx->blt.sys_src32 = val;
+        for (uint8_t i = 0; i < 32; i += 8)
+            gd54xx_start_blit((val >> i) & 0xff, 8, gd54xx, &gd54xx->svga);
+    } else {
+        gd54xx->blt.sys_src32 = val;
+        gd54xx_start_blit(val, 32, gd54xx, &gd54xx->svga);
+    }
+}
+
 static void
 gd54xx_write(uint32_t addr, uint8_t val, void *priv)
 {
@@ -2230,10 +2263,7 @@ gd54xx_writel(uint32_t addr, uint32_t val, void *priv)
     svga_t   *svga   = &gd54xx->svga;
 
     if (gd54xx->countminusone && !gd54xx->blt.ms_is_dest && !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
-        gd54xx_write(addr, val, gd54xx);
-        gd54xx_write(addr + 1, val >> 8, gd54xx);
-        gd54xx_write(addr + 2, val >> 16, gd54xx);
-        gd54xx_write(addr + 3, val >> 24, gd54xx);
+        gd54xx_mem_sys_src_writel(gd54xx, val, 0);
         return;
     }
 
@@ -2553,10 +2583,14 @@ gd5436_aperture2_writel(uint32_t addr, uint32_t val, void *priv)
 
     if (gd54xx->countminusone && !gd54xx->blt.ms_is_dest &&
         gd54xx_aperture2_enabled(gd54xx) && !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
-        gd5436_aperture2_writeb(addr, val, gd54xx);
-        gd5436_aperture2_writeb(addr + 1, val >> 8, gd54xx);
-        gd5436_aperture2_writeb(addr + 2, val >> 16, gd54xx);
-        gd5436_aperture2_writeb(addr + 3, val >> 24, gd54xx);
+        if (!(addr & 3))
+            gd54xx_mem_sys_src_writel(gd54xx, val, gd54xx_get_aperture(addr));
+        else {
+            gd5436_aperture2_writeb(addr, val, gd54xx);
+            gd5436_aperture2_writeb(addr + 1, val >> 8, gd54xx);
+            gd5436_aperture2_writeb(addr + 2, val >> 16, gd54xx);
+            gd5436_aperture2_writeb(addr + 3, val >> 24, gd54xx);
+        }
     }
 }
 
@@ -2698,10 +2732,15 @@ gd54xx_writel_linear(uint32_t addr, uint32_t val, void *priv)
 
     /* Do mem sys src writes here if the blitter is neither paused, nor is there a second aperture. */
     if (gd54xx->countminusone && !gd54xx->blt.ms_is_dest && !gd54xx_aperture2_enabled(gd54xx) && !(gd54xx->blt.status & CIRRUS_BLT_PAUSED)) {
-        gd54xx_writeb_linear(old_addr, val, gd54xx);
-        gd54xx_writeb_linear(old_addr + 1, val >> 8, gd54xx);
-        gd54xx_writeb_linear(old_addr + 2, val >> 16, gd54xx);
-        gd54xx_writeb_linear(old_addr + 3, val >> 24, gd54xx);
+        /* An aligned dword cannot reach into the MMIO range at the top of the aperture. */
+        if (!(addr & 3))
+            gd54xx_mem_sys_src_writel(gd54xx, val, ap);
+        else {
+            gd54xx_writeb_linear(old_addr, val, gd54xx);
+            gd54xx_writeb_linear(old_addr + 1, val >> 8, gd54xx);
+            gd54xx_writeb_linear(old_addr + 2, val >> 16, gd54xx);
+            gd54xx_writeb_linear(old_addr + 3, val >> 24, gd54xx);
+        }
         return;
     }
 
@@ -3405,6 +3444,63 @@ gd54xx_transparent_comp(gd54xx_t *gd54xx, uint32_t xx, uint8_t src)
     return ret;
 }
 
+/* One row of a colour expanded SRCCOPY pattern fill, the pattern line being
+   at srca2 unless it is a solid fill. Returns 0 without drawing anything if
+   the row wraps around video memory or overwrites its own pattern line. */
+static int
+gd54xx_pattern_row(gd54xx_t *gd54xx, uint32_t dsta, uint32_t srca2)
+{
+    svga_t  *svga      = &gd54xx->svga;
+    int      pw        = gd54xx->blt.pixel_width;
+    int      is_transp = gd54xx->blt.mode & CIRRUS_BLTMODE_TRANSPARENTCOMP;
+    int      is_bgonly = gd54xx->blt.modeext & CIRRUS_BLTMODEEXT_BACKGROUNDONLY;
+    int      inv       = is_transp && (gd54xx->blt.modeext & CIRRUS_BLTMODEEXT_COLOREXPINV);
+    uint32_t last_x    = gd54xx->blt.width - (gd54xx->blt.width % pw);
+    uint8_t  fg[4];
+    uint8_t  bg[4];
+    uint8_t  bits  = 0xff;
+    uint8_t *dst;
+    int      pixel = 0;
+
+    dsta &= gd54xx->vram_mask;
+    srca2 &= gd54xx->vram_mask;
+    if ((dsta + last_x + pw - 1) > gd54xx->vram_mask)
+        return 0;
+    if (!(gd54xx->blt.modeext & CIRRUS_BLTMODEEXT_SOLIDFILL)) {
+        if ((srca2 >= dsta) && (srca2 <= (dsta + last_x + pw - 1)))
+            return 0;
+        bits = svga->vram[srca2];
+    }
+
+    for (int xx = 0; xx < 4; xx++) {
+        fg[xx] = gd54xx->blt.fg_col >> (xx << 3);
+        bg[xx] = gd54xx->blt.bg_col >> (xx << 3);
+    }
+
+    dst = &svga->vram[dsta];
+    for (uint32_t x = 0; x <= last_x; x += pw) {
+        int mask = !!(bits & (0x80 >> pixel));
+        int skip = (x < gd54xx->blt.pattern_x);
+        int wr;
+
+        if (is_transp)
+            wr = (mask ^ inv) && !skip;
+        else if (is_bgonly)
+            wr = mask || !skip;
+        else
+            wr = !skip;
+
+        if (wr)
+            memcpy(&dst[x], (is_transp || mask) ? fg : bg, pw);
+        pixel = (pixel + 1) & 7;
+    }
+
+    for (uint32_t page = dsta >> 12; page <= ((dsta + last_x) >> 12); page++)
+        svga->changedvram[page] = changeframecount;
+
+    return 1;
+}
+
 static void
 gd54xx_pattern_copy(gd54xx_t *gd54xx)
 {
@@ -3419,6 +3515,10 @@ gd54xx_pattern_copy(gd54xx_t *gd54xx)
     uint32_t srca2;
     uint32_t dsta;
     svga_t  *svga = &gd54xx->svga;
+    /* Solid and transparent colour expanded fills with SRCCOPY go through
+       gd54xx_pattern_row() a row at a time. */
+    int      fast = (gd54xx->blt.mode & CIRRUS_BLTMODE_COLOREXPAND) && (gd54xx->blt.rop == 0x0d) &&
+               (gd54xx->blt.pixel_width != 3);
 
     pattern_pitch = gd54xx->blt.pixel_width << 3;
 
@@ -3448,6 +3548,11 @@ gd54xx_pattern_copy(gd54xx_t *gd54xx)
         /* Go to the correct pattern line. */
         srca2 = srca + (pattern_y * pattern_pitch);
         pixel = 0;
+        if (fast && gd54xx_pattern_row(gd54xx, dsta, srca2)) {
+            pattern_y = (pattern_y + 1) & 7;
+            dsta += gd54xx->blt.dst_pitch;
+            continue;
+        }
         for (uint16_t x = 0; x <= gd54xx->blt.width; x += gd54xx->blt.pixel_width) {
             if (gd54xx->blt.mode & CIRRUS_BLTMODE_COLOREXPAND) {
                 if (gd54xx->blt.modeext & CIRRUS_BLTMODEEXT_SOLIDFILL)
@@ -3577,6 +3682,68 @@ gd54xx_mem_sys_src(gd54xx_t *gd54xx, uint32_t cpu_dat, uint32_t count)
     }
 }
 
+/* n bytes of a row of a plain screen to screen blit (no colour expansion,
+   no transparency) for the common ROPs, stepping by blt.dir from src_addr
+   and dst_addr. Returns 0 without drawing anything for other ROPs or if
+   either span wraps around video memory. */
+static int
+gd54xx_normal_blit_row(gd54xx_t *gd54xx, svga_t *svga, uint32_t src_addr, uint32_t dst_addr, int n)
+{
+    int      dir = gd54xx->blt.dir;
+    uint32_t src;
+    uint32_t dst;
+    uint8_t *s;
+    uint8_t *d;
+
+    src_addr &= gd54xx->vram_mask;
+    dst_addr &= gd54xx->vram_mask;
+    if (dir > 0) {
+        if (((src_addr + n - 1) > gd54xx->vram_mask) || ((dst_addr + n - 1) > gd54xx->vram_mask))
+            return 0;
+        src = src_addr;
+        dst = dst_addr;
+    } else {
+        if ((src_addr < (uint32_t) (n - 1)) || (dst_addr < (uint32_t) (n - 1)))
+            return 0;
+        src = src_addr - (n - 1);
+        dst = dst_addr - (n - 1);
+    }
+    s = &svga->vram[src_addr];
+    d = &svga->vram[dst_addr];
+
+    switch (gd54xx->blt.rop) {
+        case 0x00:
+            memset(&svga->vram[dst], 0x00, n);
+            break;
+        case 0x06:
+            break;
+        case 0x0d:
+            /* A copy running into its own source replicates bytes. */
+            if ((dir > 0) ? ((dst <= src) || (dst >= (src + n))) : ((dst >= src) || ((dst + n) <= src)))
+                memmove(&svga->vram[dst], &svga->vram[src], n);
+            else {
+                for (int i = 0; i < n; i++)
+                    d[i * dir] = s[i * dir];
+            }
+            break;
+        case 0x0e:
+            memset(&svga->vram[dst], 0xff, n);
+            break;
+        case 0x59:
+            for (int i = 0; i < n; i++)
+                d[i * dir] ^= s[i * dir];
+            break;
+
+        default:
+            return 0;
+    }
+
+    for (uint32_t page = dst >> 12; page <= ((dst + n - 1) >> 12); page++)
+        svga->changedvram[page] = changeframecount;
+
+    return 1;
+}
+
 static void
 gd54xx_normal_blit(uint32_t count, gd54xx_t *gd54xx, svga_t *svga)
 {
@@ -3588,6 +3755,7 @@ gd54xx_normal_blit(uint32_t count, gd54xx_t *gd54xx, svga_t *svga)
     int      mask = 0;
     uint32_t src_addr = gd54xx->blt.src_addr;
     uint32_t dst_addr = gd54xx->blt.dst_addr;
+    int      fast     = !(gd54xx->blt.mode & (CIRRUS_BLTMODE_COLOREXPAND | CIRRUS_BLTMODE_TRANSPARENTCOMP));
 
     x_max = gd54xx->blt.pixel_width << 3;
 
@@ -3598,6 +3766,17 @@ gd54xx_normal_blit(uint32_t count, gd54xx_t *gd54xx, svga_t *svga)
     gd54xx->blt.y_count         = 0;
 
     while (count) {
+        /* All but the last byte of the row at once, the last one goes through
+           the loop below so that the end of the row is handled there. */
+        if (fast && width && (width == gd54xx->blt.width) && (count > width) &&
+            gd54xx_normal_blit_row(gd54xx, svga, src_addr, dst_addr, width)) {
+            src_addr += gd54xx->blt.dir * width;
+            dst_addr += gd54xx->blt.dir * width;
+            gd54xx->blt.x_count = (gd54xx->blt.x_count + width) % x_max;
+            count -= width;
+            width = 0;
+        }
+
         src  = 0;
         mask = 0;
 
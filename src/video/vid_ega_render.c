@@ -248,18 +248,16 @@ ega_render_graphics(ega_t *ega)
         }
 
         if (!crtcreset) {
-            for (int i = 0; i < 8; i += 2) {
+            /* All 8 pixels as 4bpp chunky, the leftmost in the top nibble. */
+            // FIXME: Confirm blink behaviour is actually XOR on real hardware
+            const uint32_t dat = ((edatlookup8[edat[0]] | (edatlookup8[edat[1]] << 1) | (edatlookup8[edat[2]] << 2) | (edatlookup8[edat[3]] << 3))
+                                  & (0x11111111 * ega->plane_mask))
+                ^ (0x11111111 * blinkmask);
+            for (int i = 0; i < 8; i++) {
                 const int outoffs = i << dwshift;
-                const int inshift = 6 - i;
-                uint8_t   dat     = (edatlookup[(edat[0] >> inshift) & 3][(edat[1] >> inshift) & 3])
-                    | (edatlookup[(edat[2] >> inshift) & 3][(edat[3] >> inshift) & 3] << 2);
-                // FIXME: Confirm blink behaviour is actually XOR on real hardware
-                uint32_t p0 = ega->pallook[ega->egapal[((dat >> 4) & ega->plane_mask) ^ blinkmask]];
-                uint32_t p1 = ega->pallook[ega->egapal[(dat & ega->plane_mask) ^ blinkmask]];
+                uint32_t  p0      = ega->pallook[ega->egapal[(dat >> (28 - (i << 2))) & 0xf]];
                 for (int subx = 0; subx < dotwidth; subx++)
                     p[outoffs + subx] = p0;
-                for (int subx = 0; subx < dotwidth; subx++)
-                    p[outoffs + subx + dotwidth] = p1;
             }
         } else
             memset(p, 0x00, charwidth * sizeof(uint32_t));
@@ -35,6 +35,17 @@
 
 static int mdacols[256][2][2];
 
+/* What drawing one line takes, so it can be done on the monitor's line
+   worker. */
+typedef struct mda_line_t {
+    int     count;
+    int     sc;
+    int     fontbase;
+    int     cursor; /* Character with the cursor, -1 for none. */
+    int     blink;
+    uint8_t cells[256 * 2];
+} mda_line_t;
+
 static video_timings_t timing_mda = { .type = VIDEO_ISA, .write_b = 8, .write_w = 16, .write_l = 32, .read_b = 8, .read_w = 16, .read_l = 32 };
 
 void mda_recalctimings(mda_t *mda);
@@ -127,19 +138,49 @@ mda_recalctimings(mda_t *mda)
     mda->dispofftime = (uint64_t) (_dispofftime);
 }
 
+static void
+mda_draw_line(int monitor_index, int y, const void *data)
+{
+    const mda_line_t *line = (const mda_line_t *) data;
+    uint32_t         *p    = monitors[monitor_index].target_buffer->line[y];
+    uint8_t           chr;
+    uint8_t           attr;
+    uint8_t           dat;
+    int               blink;
+
+    for (int x = 0; x < line->count; x++) {
+        chr   = line->cells[x << 1];
+        attr  = line->cells[(x << 1) + 1];
+        blink = (line->blink && (attr & 0x80) && (x != line->cursor));
+        if (line->sc == 12 && ((attr & 7) == 1)) {
+            for (int c = 0; c < 9; c++)
+                p[(x * 9) + c] = mdacols[attr][blink][1];
+        } else {
+            dat = fontdatm[chr + line->fontbase][line->sc];
+            video_glyph_row(&p[x * 9], dat, mdacols[attr][blink][1], mdacols[attr][blink][0]);
+            if ((chr & ~0x1f) == 0xc0)
+                p[(x * 9) + 8] = mdacols[attr][blink][dat & 1];
+            else
+                p[(x * 9) + 8] = mdacols[attr][blink][0];
+        }
+        if (x == line->cursor) {
+            for (int c = 0; c < 9; c++)
+                p[(x * 9) + c] ^= mdacols[attr][0][1];
+        }
+    }
+
+    video_process_8_monitor(line->count * 9, y, monitor_index);
+}
+
 void
 mda_poll(void *priv)
 {
-    mda_t   *mda = (mda_t *) priv;
-    uint16_t ca  = (mda->crtc[15] | (mda->crtc[14] << 8)) & 0x3fff;
-    int      drawcursor;
-    int      x;
-    int      c;
-    int      oldvc;
-    uint8_t  chr;
-    uint8_t  attr;
-    int      oldsc;
-    int      blink;
+    mda_t     *mda = (mda_t *) priv;
+    uint16_t   ca  = (mda->crtc[15] | (mda->crtc[14] << 8)) & 0x3fff;
+    int        x;
+    int        oldvc;
+    int        oldsc;
+    mda_line_t line;
 
     VIDEO_MONITOR_PROLOGUE()
     if (!mda->linepos) {
@@ -155,30 +196,23 @@ mda_poll(void *priv)
                 video_wait_for_buffer();
             }
             mda->lastline = mda->displine;
-            for (x = 0; x < mda->crtc[1]; x++) {
-                chr        = mda->vram[(mda->ma << 1) & 0xfff];
-                attr       = mda->vram[((mda->ma << 1) + 1) & 0xfff];
-                drawcursor = ((mda->ma == ca) && mda->con && mda->cursoron);
-                blink      = ((mda->blink & 16) && (mda->ctrl & 0x20) && (attr & 0x80) && !drawcursor);
-                if (mda->sc == 12 && ((attr & 7) == 1)) {
-                    for (c = 0; c < 9; c++)
-                        buffer32->line[mda->displine][(x * 9) + c] = mdacols[attr][blink][1];
-                } else {
-                    for (c = 0; c < 8; c++)
-                        buffer32->line[mda->displine][(x * 9) + c] = mdacols[attr][blink][(fontdatm[chr + mda->fontbase][mda->sc] & (1 << (c ^ 7))) ? 1 : 0];
-                    if ((chr & ~0x1f) == 0xc0)
-                        buffer32->line[mda->displine][(x * 9) + 8] = mdacols[attr][blink][fontdatm[chr + mda->fontbase][mda->sc] & 1];
-                    else
-                        buffer32->line[mda->displine][(x * 9) + 8] = mdacols[attr][blink][0];
-                }
+
+            line.count    = mda->crtc[1];
+            line.sc       = mda->sc;
+            line.fontbase = mda->fontbase;
+            line.blink    = (mda->blink & 16) && (mda->ctrl & 0x20);
+            line.cursor   = -1;
+            for (x = 0; x < line.count; x++) {
+                line.cells[x << 1]       = mda->vram[(mda->ma << 1) & 0xfff];
+                line.cells[(x << 1) + 1] = mda->vram[((mda->ma << 1) + 1) & 0xfff];
+                if ((mda->ma == ca) && mda->con && mda->cursoron)
+                    line.cursor = x;
                 mda->ma++;
-                if (drawcursor) {
-                    for (c = 0; c < 9; c++)
-                        buffer32->line[mda->displine][(x * 9) + c] ^= mdacols[attr][0][1];
-                }
             }
 
-            video_process_8(mda->crtc[1] * 9, mda->displine);
+            if (!video_line_queue_monitor(mda->monitor_index, mda->displine, mda_draw_line,
+                                          &line, sizeof(mda_line_t)))
+                mda_draw_line(mda->monitor_index, mda->displine, &line);
         }
         mda->sc = oldsc;
         if (mda->vc == mda->crtc[7] && !mda->sc) {
@@ -4665,6 +4665,185 @@ blit_line_start(mystique_t *mystique, int closed, int autoline)
     }
 }
 
+/*Span kernels for the common drawing cases. They are only used on spans that
+  sit entirely inside the clip window, are fully enabled by the transparency
+  mask and do not wrap around VRAM, and store exactly what the per-pixel
+  loops would.*/
+static void
+span_changed(mystique_t *mystique, uint32_t start, uint32_t len)
+{
+    svga_t *svga = &mystique->svga;
+
+    for (uint32_t page = start >> 12; page <= ((start + len - 1) >> 12); page++)
+        svga->changedvram[page] = changeframecount;
+}
+
+/*Solid and pattern fills; col[] holds the colour of each x & 7.*/
+static void
+span_fill_8(mystique_t *mystique, uint32_t dst, int x, int len, const uint32_t *col, int solid)
+{
+    uint8_t *p = &mystique->svga.vram[dst];
+
+    if (solid)
+        memset(p, col[0] & 0xff, len);
+    else for (int c = 0; c < len; c++)
+        p[c] = col[(x + c) & 7];
+
+    span_changed(mystique, dst, len);
+}
+
+static void
+span_fill_16(mystique_t *mystique, uint32_t dst, int x, int len, const uint32_t *col, int solid)
+{
+    uint16_t *p = &((uint16_t *) mystique->svga.vram)[dst];
+
+    if (solid) {
+        for (int c = 0; c < len; c++)
+            p[c] = col[0];
+    } else for (int c = 0; c < len; c++)
+        p[c] = col[(x + c) & 7];
+
+    span_changed(mystique, dst << 1, len << 1);
+}
+
+static void
+span_fill_24(mystique_t *mystique, uint32_t dst, int x, int len, const uint32_t *col, UNUSED(int solid))
+{
+    uint8_t *p = &mystique->svga.vram[dst * 3];
+
+    for (int c = 0; c < len; c++, p += 3) {
+        uint32_t val = col[(x + c) & 7];
+
+        p[0] = val & 0xff;
+        p[1] = (val >> 8) & 0xff;
+        p[2] = (val >> 16) & 0xff;
+    }
+
+    span_changed(mystique, dst * 3, len * 3);
+}
+
+static void
+span_fill_32(mystique_t *mystique, uint32_t dst, int x, int len, const uint32_t *col, int solid)
+{
+    uint32_t *p = &((uint32_t *) mystique->svga.vram)[dst];
+
+    if (solid) {
+        for (int c = 0; c < len; c++)
+            p[c] = col[0];
+    } else for (int c = 0; c < len; c++)
+        p[c] = col[(x + c) & 7];
+
+    span_changed(mystique, dst << 2, len << 2);
+}
+
+/*Indexed by MACCESS_PWIDTH.*/
+static void (*const span_fill[4])(mystique_t *mystique, uint32_t dst, int x, int len, const uint32_t *col, int solid) = {
+    span_fill_8,
+    span_fill_16,
+    span_fill_32,
+    span_fill_24
+};
+
+/*Source copies, opaque or with the BLTCKEY/BLTCMSK colour key. src and dst
+  are the first pixel in drawing order and len pixels are drawn in x_dir
+  order, so overlapping copies come out as the per-pixel loop leaves them.*/
+#define SPAN_COPY(type)                                                               \
+    {                                                                                 \
+        type *p = (type *) mystique->svga.vram;                                       \
+                                                                                      \
+        if (!transc && ((x_dir > 0) ? ((dst <= src) || (dst >= (src + len)))          \
+                                    : ((dst >= src) || ((dst + len) <= src)))) {      \
+            uint32_t lo_src = (x_dir > 0) ? src : (src - len + 1);                    \
+            uint32_t lo_dst = (x_dir > 0) ? dst : (dst - len + 1);                    \
+                                                                                      \
+            memmove(&p[lo_dst], &p[lo_src], len * sizeof(type));                      \
+        } else for (int c = 0; c < len; c++) {                                        \
+            type val = p[src + (c * x_dir)];                                          \
+                                                                                      \
+            if (!transc || ((val & bltcmsk) != bltckey))                              \
+                p[dst + (c * x_dir)] = val;                                           \
+        }                                                                             \
+    }
+
+static void
+span_copy_8(mystique_t *mystique, uint32_t src, uint32_t dst, int len, int x_dir, int transc, uint32_t bltckey, uint32_t bltcmsk)
+{
+    SPAN_COPY(uint8_t)
+    span_changed(mystique, (x_dir > 0) ? dst : (dst - len + 1), len);
+}
+
+static void
+span_copy_16(mystique_t *mystique, uint32_t src, uint32_t dst, int len, int x_dir, int transc, uint32_t bltckey, uint32_t bltcmsk)
+{
+    SPAN_COPY(uint16_t)
+    span_changed(mystique, ((x_dir > 0) ? dst : (dst - len + 1)) << 1, len << 1);
+}
+
+/*The key is compared against all 32 bits read at the source, as in the
+  per-pixel loop; only the colour bytes are stored.*/
+static void
+span_copy_24(mystique_t *mystique, uint32_t src, uint32_t dst, int len, int x_dir, int transc, uint32_t bltckey, uint32_t bltcmsk)
+{
+    uint8_t *vram = mystique->svga.vram;
+
+    for (int c = 0; c < len; c++) {
+        uint32_t val = *(uint32_t *) &vram[(src + (c * x_dir)) * 3];
+        uint8_t *p   = &vram[(dst + (c * x_dir)) * 3];
+
+        if (!transc || ((val & bltcmsk) != bltckey)) {
+            p[0] = val & 0xff;
+            p[1] = (val >> 8) & 0xff;
+            p[2] = (val >> 16) & 0xff;
+        }
+    }
+
+    span_changed(mystique, ((x_dir > 0) ? dst : (dst - len + 1)) * 3, len * 3);
+}
+
+static void
+span_copy_32(mystique_t *mystique, uint32_t src, uint32_t dst, int len, int x_dir, int transc, uint32_t bltckey, uint32_t bltcmsk)
+{
+    SPAN_COPY(uint32_t)
+    span_changed(mystique, ((x_dir > 0) ? dst : (dst - len + 1)) << 2, len << 2);
+}
+
+static void (*const span_copy[4])(mystique_t *mystique, uint32_t src, uint32_t dst, int len, int x_dir, int transc, uint32_t bltckey, uint32_t bltcmsk) = {
+    span_copy_8,
+    span_copy_16,
+    span_copy_32,
+    span_copy_24
+};
+
+/*Whether pixels lo to hi of the current line can go through a span kernel:
+  inside the clip window, and the pixel addresses not wrapping around VRAM.*/
+static int
+span_visible(mystique_t *mystique, int lo, int hi)
+{
+    int64_t end;
+
+    if ((lo < mystique->dwgreg.cxleft) || (hi > mystique->dwgreg.cxright) || (hi > INT16_MAX))
+        return 0;
+    if ((mystique->dwgreg.ydst_lin < mystique->dwgreg.ytop) || (mystique->dwgreg.ydst_lin > mystique->dwgreg.ybot))
+        return 0;
+
+    end = (int64_t) mystique->dwgreg.ydst_lin + hi + 1;
+    switch (mystique->maccess_running & MACCESS_PWIDTH_MASK) {
+        case MACCESS_PWIDTH_8:
+            return end <= ((int64_t) mystique->vram_mask + 1);
+        case MACCESS_PWIDTH_16:
+            return end <= ((int64_t) mystique->vram_mask_w + 1);
+        case MACCESS_PWIDTH_24:
+            return ((end * 3) + 1) <= ((int64_t) mystique->vram_mask + 1);
+        case MACCESS_PWIDTH_32:
+            return end <= ((int64_t) mystique->vram_mask_l + 1);
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
 static void
 blit_trap(mystique_t *mystique)
 {
@@ -4695,6 +4874,20 @@ blit_trap(mystique_t *mystique)
                 else
                     len = x_r - x_l;
 
+                if ((len > 0) && !trans_sel && span_visible(mystique, x_l, x_l + len - 1)) {
+                    uint32_t col[8];
+                    int      solid = 1;
+
+                    for (int c = 0; c < 8; c++) {
+                        col[c] = mystique->dwgreg.pattern[yoff][(mystique->dwgreg.xoff + c) & 15] ? mystique->dwgreg.fcol : mystique->dwgreg.bcol;
+                        if (col[c] != col[0])
+                            solid = 0;
+                    }
+
+                    span_fill[mystique->maccess_running & MACCESS_PWIDTH_MASK](mystique, mystique->dwgreg.ydst_lin + x_l, x_l, len, col, solid);
+                    len = 0;
+                }
+
                 while (len > 0) {
                     if (x_l >= mystique->dwgreg.cxleft && x_l <= mystique->dwgreg.cxright && mystique->dwgreg.ydst_lin >= mystique->dwgreg.ytop && mystique->dwgreg.ydst_lin <= mystique->dwgreg.ybot && trans[x_l & 3]) {
                         int      xoff    = (mystique->dwgreg.xoff + (x_l & 7)) & 15;
@@ -5457,6 +5650,66 @@ skip_pixel:
     mystique->blitter_complete_refcount++;
 }
 
+/*Whole line source copy for BFCOL/BU32RGB BitBlts with SRCCOPY, opaque or
+  colour keyed. The per-pixel loop moves to the next source line when it
+  reaches AR0, so lines that would get there before their last pixel are
+  left to it.*/
+static int
+blit_bitblt_span(mystique_t *mystique, uint32_t *src_addr, int16_t x_start, int16_t x_end, int x_dir, int trans_sel, uint32_t bltckey, uint32_t bltcmsk)
+{
+    uint32_t dwgctrl = mystique->dwgreg.dwgctrl_running;
+    int      len     = ABS(x_end - x_start) + 1;
+    uint32_t src     = *src_addr;
+    uint32_t last    = src + (x_dir * (len - 1));
+    uint32_t lo      = (x_dir > 0) ? src : last;
+    uint32_t ar0     = (x_dir > 0) ? (mystique->dwgreg.ar[0] - src) : (src - mystique->dwgreg.ar[0]);
+    int64_t  end     = (int64_t) lo + len;
+
+    if (((dwgctrl & DWGCTRL_BOP_MASK) != BOP(0xc)) || (dwgctrl & DWGCTRL_PATTERN) || trans_sel)
+        return 0;
+    /*x always walks towards x_end, while the source follows the scan direction.*/
+    if ((x_start != x_end) && ((x_end > x_start) != (x_dir > 0)))
+        return 0;
+    if (ar0 < (uint32_t) (len - 1))
+        return 0;
+    if (!span_visible(mystique, MIN(x_start, x_end), MAX(x_start, x_end)))
+        return 0;
+
+    switch (mystique->maccess_running & MACCESS_PWIDTH_MASK) {
+        case MACCESS_PWIDTH_8:
+            if (end > ((int64_t) mystique->vram_mask + 1))
+                return 0;
+            break;
+        case MACCESS_PWIDTH_16:
+            if (end > ((int64_t) mystique->vram_mask_w + 1))
+                return 0;
+            break;
+        case MACCESS_PWIDTH_24:
+            if (((end * 3) + 1) > ((int64_t) mystique->vram_mask + 1))
+                return 0;
+            break;
+        case MACCESS_PWIDTH_32:
+            if (end > ((int64_t) mystique->vram_mask_l + 1))
+                return 0;
+            break;
+
+        default:
+            return 0;
+    }
+
+    span_copy[mystique->maccess_running & MACCESS_PWIDTH_MASK](mystique, src, mystique->dwgreg.ydst_lin + x_start, len, x_dir,
+                                                               !!(dwgctrl & DWGCTRL_TRANSC), bltckey, bltcmsk);
+
+    if (ar0 == (uint32_t) (len - 1)) {
+        mystique->dwgreg.ar[0] += mystique->dwgreg.ar[5];
+        mystique->dwgreg.ar[3] += mystique->dwgreg.ar[5];
+        *src_addr = mystique->dwgreg.ar[3];
+    } else
+        *src_addr = last + x_dir;
+
+    return 1;
+}
+
 static void
 blit_bitblt(mystique_t *mystique)
 {
@@ -5772,84 +6025,86 @@ blit_bitblt(mystique_t *mystique)
                         uint32_t             old_src_addr = src_addr;
                         int16_t              x            = x_start;
 
-                        while (1) {
-                            if (x >= mystique->dwgreg.cxleft && x <= mystique->dwgreg.cxright && mystique->dwgreg.ydst_lin >= mystique->dwgreg.ytop && mystique->dwgreg.ydst_lin <= mystique->dwgreg.ybot && trans[x & 3]) {
-                                uint32_t src;
-                                uint32_t dst;
-                                uint32_t old_dst;
+                        if (!blit_bitblt_span(mystique, &src_addr, x_start, x_end, x_dir, trans_sel, bltckey, bltcmsk)) {
+                            while (1) {
+                                if (x >= mystique->dwgreg.cxleft && x <= mystique->dwgreg.cxright && mystique->dwgreg.ydst_lin >= mystique->dwgreg.ytop && mystique->dwgreg.ydst_lin <= mystique->dwgreg.ybot && trans[x & 3]) {
+                                    uint32_t src;
+                                    uint32_t dst;
+                                    uint32_t old_dst;
 
-                                switch (mystique->maccess_running & MACCESS_PWIDTH_MASK) {
-                                    case MACCESS_PWIDTH_8:
-                                        src = svga->vram[src_addr & mystique->vram_mask];
-                                        dst = svga->vram[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask];
-                                        if (!((!(mystique->dwgreg.dwgctrl_running & DWGCTRL_TRANSC) || (src & bltcmsk) != bltckey)))
-                                            break;
+                                    switch (mystique->maccess_running & MACCESS_PWIDTH_MASK) {
+                                        case MACCESS_PWIDTH_8:
+                                            src = svga->vram[src_addr & mystique->vram_mask];
+                                            dst = svga->vram[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask];
+                                            if (!((!(mystique->dwgreg.dwgctrl_running & DWGCTRL_TRANSC) || (src & bltcmsk) != bltckey)))
+                                                break;
 
-                                        dst = bitop(src, dst, mystique->dwgreg.dwgctrl_running);
-
-                                        svga->vram[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask]                = dst;
-                                        svga->changedvram[((mystique->dwgreg.ydst_lin + x) & mystique->vram_mask) >> 12] = changeframecount;
-                                        break;
+                                            dst = bitop(src, dst, mystique->dwgreg.dwgctrl_running);
 
-                                    case MACCESS_PWIDTH_16:
-                                        src = ((uint16_t *) svga->vram)[src_addr & mystique->vram_mask_w];
-                                        dst = ((uint16_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_w];
-                                        if (!((!(mystique->dwgreg.dwgctrl_running & DWGCTRL_TRANSC) || (src & bltcmsk) != bltckey)))
+                                            svga->vram[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask]                = dst;
+                                            svga->changedvram[((mystique->dwgreg.ydst_lin + x) & mystique->vram_mask) >> 12] = changeframecount;
                                             break;
 
-                                        dst = bitop(src, dst, mystique->dwgreg.dwgctrl_running);
+                                        case MACCESS_PWIDTH_16:
+                                            src = ((uint16_t *) svga->vram)[src_addr & mystique->vram_mask_w];
+                                            dst = ((uint16_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_w];
+                                            if (!((!(mystique->dwgreg.dwgctrl_running & DWGCTRL_TRANSC) || (src & bltcmsk) != bltckey)))
+                                                break;
 
-                                        ((uint16_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_w] = dst;
-                                        svga->changedvram[((mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_w) >> 11] = changeframecount;
-                                        break;
+                                            dst = bitop(src, dst, mystique->dwgreg.dwgctrl_running);
 
-                                    case MACCESS_PWIDTH_24:
-                                        src     = *(uint32_t *) &svga->vram[(src_addr * 3) & mystique->vram_mask];
-                                        old_dst = *(uint32_t *) &svga->vram[((mystique->dwgreg.ydst_lin + x) * 3) & mystique->vram_mask];
-                                        if (!((!(mystique->dwgreg.dwgctrl_running & DWGCTRL_TRANSC) || (src & bltcmsk) != bltckey)))
+                                            ((uint16_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_w] = dst;
+                                            svga->changedvram[((mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_w) >> 11] = changeframecount;
                                             break;
 
-                                        dst = bitop(src, old_dst, mystique->dwgreg.dwgctrl_running);
+                                        case MACCESS_PWIDTH_24:
+                                            src     = *(uint32_t *) &svga->vram[(src_addr * 3) & mystique->vram_mask];
+                                            old_dst = *(uint32_t *) &svga->vram[((mystique->dwgreg.ydst_lin + x) * 3) & mystique->vram_mask];
+                                            if (!((!(mystique->dwgreg.dwgctrl_running & DWGCTRL_TRANSC) || (src & bltcmsk) != bltckey)))
+                                                break;
 
-                                        *(uint32_t *) &svga->vram[((mystique->dwgreg.ydst_lin + x) * 3) & mystique->vram_mask] = (dst & 0xffffff) | (old_dst & 0xff000000);
-                                        svga->changedvram[(((mystique->dwgreg.ydst_lin + x) * 3) & mystique->vram_mask) >> 12] = changeframecount;
-                                        break;
+                                            dst = bitop(src, old_dst, mystique->dwgreg.dwgctrl_running);
 
-                                    case MACCESS_PWIDTH_32:
-                                        src = ((uint32_t *) svga->vram)[src_addr & mystique->vram_mask_l];
-                                        dst = ((uint32_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_l];
-                                        if (!((!(mystique->dwgreg.dwgctrl_running & DWGCTRL_TRANSC) || (src & bltcmsk) != bltckey)))
+                                            *(uint32_t *) &svga->vram[((mystique->dwgreg.ydst_lin + x) * 3) & mystique->vram_mask] = (dst & 0xffffff) | (old_dst & 0xff000000);
+                                            svga->changedvram[(((mystique->dwgreg.ydst_lin + x) * 3) & mystique->vram_mask) >> 12] = changeframecount;
                                             break;
 
-                                        dst = bitop(src, dst, mystique->dwgreg.dwgctrl_running);
+                                        case MACCESS_PWIDTH_32:
+                                            src = ((uint32_t *) svga->vram)[src_addr & mystique->vram_mask_l];
+                                            dst = ((uint32_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_l];
+                                            if (!((!(mystique->dwgreg.dwgctrl_running & DWGCTRL_TRANSC) || (src & bltcmsk) != bltckey)))
+                                                break;
 
-                                        ((uint32_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_l] = dst;
-                                        svga->changedvram[((mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_l) >> 10] = changeframecount;
-                                        break;
+                                            dst = bitop(src, dst, mystique->dwgreg.dwgctrl_running);
 
-                                    default:
-                                        fatal("BITBLT RPL BFCOL PWIDTH %x %08x\n", mystique->maccess_running & MACCESS_PWIDTH_MASK, mystique->dwgreg.dwgctrl_running);
-                                }
-                            }
+                                            ((uint32_t *) svga->vram)[(mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_l] = dst;
+                                            svga->changedvram[((mystique->dwgreg.ydst_lin + x) & mystique->vram_mask_l) >> 10] = changeframecount;
+                                            break;
 
-                            if (mystique->dwgreg.dwgctrl_running & DWGCTRL_PATTERN)
-                                src_addr = ((src_addr + x_dir) & 7) | (src_addr & ~7);
-                            else if (src_addr == mystique->dwgreg.ar[0]) {
-                                mystique->dwgreg.ar[0] += mystique->dwgreg.ar[5];
-                                mystique->dwgreg.ar[3] += mystique->dwgreg.ar[5];
-                                src_addr = mystique->dwgreg.ar[3];
-                            } else
-                                src_addr += x_dir;
+                                        default:
+                                            fatal("BITBLT RPL BFCOL PWIDTH %x %08x\n", mystique->maccess_running & MACCESS_PWIDTH_MASK, mystique->dwgreg.dwgctrl_running);
+                                    }
+                                }
 
-                            if (x != x_end)  {
-                                if ((x > x_end) && (x_dir == 1))
-                                    x--;
-                                else if ((x < x_end) && (x_dir == -1))
-                                    x++;
-                                else
-                                    x += x_dir;
-                            } else
-                                break;
+                                if (mystique->dwgreg.dwgctrl_running & DWGCTRL_PATTERN)
+                                    src_addr = ((src_addr + x_dir) & 7) | (src_addr & ~7);
+                                else if (src_addr == mystique->dwgreg.ar[0]) {
+                                    mystique->dwgreg.ar[0] += mystique->dwgreg.ar[5];
+                                    mystique->dwgreg.ar[3] += mystique->dwgreg.ar[5];
+                                    src_addr = mystique->dwgreg.ar[3];
+                                } else
+                                    src_addr += x_dir;
+
+                                if (x != x_end)  {
+                                    if ((x > x_end) && (x_dir == 1))
+                                        x--;
+                                    else if ((x < x_end) && (x_dir == -1))
+                                        x++;
+                                    else
+                                        x += x_dir;
+                                } else
+                                    break;
+                            }
                         }
 
                         if (mystique->dwgreg.dwgctrl_running & DWGCTRL_PATTERN) {
@@ -292,6 +292,10 @@ typedef struct s3_t {
         int draw_fifo_slot;
         int setup_fifo, setup_fifo2;
         int draw_fifo, draw_fifo2;
+
+        /*How often rectangle fills and BitBlts took the row fast paths*/
+        uint32_t fast_fills, slow_fills;
+        uint32_t fast_blits, slow_blits;
     } accel;
 
     struct {
@@ -3046,7 +3050,7 @@ s3_out(uint16_t addr, uint8_t val, void *priv)
                             svga->ma_latch |= (s3->ma_ext << 16);
                     } else {
                         svga->fullchange = svga->monitor->mon_changeframecount;
-                        svga_recalctimings(svga);
+                        svga_recalctimings_crtc(svga);
                     }
                 }
             }
@@ -7926,6 +7930,223 @@ s3_short_stroke_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_d
     s3->accel_start(count, cpu_input, mix_dat, cpu_dat, s3);
 }
 
+/*Log2 of the size of one accelerator pixel in VRAM, matching READ and WRITE.*/
+static __inline int
+s3_accel_pixel_shift(s3_t *s3)
+{
+    svga_t *svga = &s3->svga;
+
+    if ((s3->bpp == 0) && !s3->color_16bit)
+        return 0;
+    else if ((s3->bpp == 1) || (s3->color_16bit && (svga->bpp < 24)))
+        return 1;
+    else if (s3->bpp == 2)
+        return 0;
+    else if (s3->color_16bit && (svga->bpp == 24))
+        return 1;
+
+    return 2;
+}
+
+/*Common checks for the row fast paths: linear VRAM, a write mask covering the
+  whole pixel, and a destination rectangle that sits entirely inside the clip
+  without the 12-bit coordinates wrapping. Returns the first column and row.*/
+static int
+s3_accel_fast_rect(s3_t *s3, int shift, uint32_t wrt_mask, int x, int y, int w, int h, int *x_lo, int *y_lo)
+{
+    svga_t  *svga     = &s3->svga;
+    uint32_t pix_mask = (shift == 2) ? 0xffffffff : ((1 << (8 << shift)) - 1);
+    int      clip_t   = s3->accel.multifunc[1] & 0xfff;
+    int      clip_l   = s3->accel.multifunc[2] & 0xfff;
+    int      clip_b   = s3->accel.multifunc[3] & 0xfff;
+    int      clip_r   = s3->accel.multifunc[4] & 0xfff;
+
+    if (!svga->packed_chain4 && !svga->force_old_addr)
+        return 0;
+    if ((wrt_mask & pix_mask) != pix_mask)
+        return 0;
+
+    *x_lo = (s3->accel.cmd & 0x20) ? x : (x - w + 1);
+    *y_lo = (s3->accel.cmd & 0x80) ? y : (y - h + 1);
+
+    /*The generic path wraps the column before stepping back, so a row ending
+      on coordinate 0 or 0xfff leaves different registers behind.*/
+    if ((s3->accel.cmd & 0x20) ? ((*x_lo + w - 1) >= 0xfff) : (*x_lo <= 0))
+        return 0;
+
+    return (*x_lo >= clip_l) && ((*x_lo + w - 1) <= clip_r) && (*y_lo >= clip_t) && ((*y_lo + h - 1) <= clip_b);
+}
+
+static __inline void
+s3_accel_fast_changed(s3_t *s3, uint32_t addr, int w, int shift)
+{
+    svga_t  *svga  = &s3->svga;
+    uint32_t start = addr << shift;
+    uint32_t end   = ((addr + w) << shift) - 1;
+
+    for (uint32_t page = start >> 12; page <= (end >> 12); page++)
+        svga->changedvram[page] = svga->monitor->mon_changeframecount;
+}
+
+/*Rectangle fill with a constant result, one row at a time. Only used at the
+  start of an operation that takes no data from the CPU, where mix_dat is all
+  ones and the foreground mix is always selected.*/
+static int
+s3_accel_fast_fill(s3_t *s3, uint32_t dstbase, uint32_t wrt_mask, int compare_mode)
+{
+    svga_t  *svga  = &s3->svga;
+    int      shift = s3_accel_pixel_shift(s3);
+    uint32_t elems = (s3->vram_mask >> shift) + 1;
+    int      w     = (s3->accel.maj_axis_pcnt & 0xfff) + 1;
+    int      h     = s3->accel.sy + 1;
+    uint32_t color;
+    int      x_lo;
+    int      y_lo;
+
+    if (!(s3->accel.cmd & 0x10) || (compare_mode >= 2))
+        return 0;
+
+    switch ((s3->accel.frgd_mix >> 5) & 3) {
+        case 0:
+            color = s3->accel.bkgd_color;
+            break;
+        case 1:
+            color = s3->accel.frgd_color;
+            break;
+        default:
+            color = 0;
+            break;
+    }
+
+    switch (s3->accel.frgd_mix & 0xf) {
+        case 0x1:
+            color = 0;
+            break;
+        case 0x2:
+            color = ~0;
+            break;
+        case 0x4:
+            color = ~color;
+            break;
+        case 0x7:
+            break;
+
+        default:
+            return 0;
+    }
+
+    if (!s3_accel_fast_rect(s3, shift, wrt_mask, s3->accel.cx, s3->accel.cy, w, h, &x_lo, &y_lo))
+        return 0;
+    if (((uint64_t) dstbase + ((y_lo + h - 1) * s3->width) + x_lo + w) > elems)
+        return 0;
+
+    for (int y = y_lo; y < (y_lo + h); y++) {
+        uint32_t addr = dstbase + (y * s3->width) + x_lo;
+
+        if (shift == 0)
+            memset(&svga->vram[addr], color & 0xff, w);
+        else if (shift == 1) {
+            uint16_t *p = &((uint16_t *) svga->vram)[addr];
+
+            if ((color & 0xff) == ((color >> 8) & 0xff))
+                memset(p, color & 0xff, w << 1);
+            else for (int x = 0; x < w; x++)
+                p[x] = color;
+        } else {
+            uint32_t *p = &((uint32_t *) svga->vram)[addr];
+
+            for (int x = 0; x < w; x++)
+                p[x] = color;
+        }
+
+        s3_accel_fast_changed(s3, addr, w, shift);
+    }
+
+    /*Leave the registers as the pixel loop would have.*/
+    if (s3->accel.cmd & 0x80)
+        s3->accel.cy += h;
+    else
+        s3->accel.cy -= h;
+    s3->accel.cy &= 0xfff;
+    s3->accel.dest  = dstbase + s3->accel.cy * s3->width;
+    s3->accel.sx    = s3->accel.maj_axis_pcnt & 0xfff;
+    s3->accel.sy    = -1;
+    s3->accel.cur_x = s3->accel.cx;
+    s3->accel.cur_y = s3->accel.cy;
+
+    s3->accel.fast_fills++;
+    return 1;
+}
+
+/*Straight source copy BitBlt, one memmove() per row. Rows are copied in the
+  order the pixel loop would visit them; within a row that is only the same
+  as memmove() when the copy direction does not read pixels it has already
+  overwritten, otherwise the generic path reproduces the smearing.*/
+static int
+s3_accel_fast_blit(s3_t *s3, uint32_t srcbase, uint32_t dstbase, uint32_t wrt_mask, int compare_mode, int vram_mask)
+{
+    svga_t  *svga  = &s3->svga;
+    int      shift = s3_accel_pixel_shift(s3);
+    uint32_t elems = (s3->vram_mask >> shift) + 1;
+    int      w     = (s3->accel.maj_axis_pcnt & 0xfff) + 1;
+    int      h     = s3->accel.sy + 1;
+    int      step  = (s3->accel.cmd & 0x80) ? 1 : -1;
+    int      x_lo;
+    int      y_lo;
+    int      sx_lo;
+    int64_t  src;
+    int64_t  dest;
+    int64_t  src_lo;
+    int64_t  src_hi;
+
+    if (!(s3->accel.cmd & 0x10) || (compare_mode >= 2) || vram_mask)
+        return 0;
+    if ((((s3->accel.frgd_mix >> 5) & 3) != 3) || ((s3->accel.frgd_mix & 0xf) != 7))
+        return 0;
+
+    if (!s3_accel_fast_rect(s3, shift, wrt_mask, s3->accel.dx, s3->accel.dy, w, h, &x_lo, &y_lo))
+        return 0;
+    if (((uint64_t) dstbase + ((y_lo + h - 1) * s3->width) + x_lo + w) > elems)
+        return 0;
+
+    /*The source is not clipped, but must not wrap around VRAM either.*/
+    sx_lo  = (s3->accel.cmd & 0x20) ? s3->accel.cx : (s3->accel.cx - w + 1);
+    src_lo = (int64_t) srcbase + ((int64_t) MIN(s3->accel.cy, s3->accel.cy + step * (h - 1)) * s3->width) + sx_lo;
+    src_hi = (int64_t) srcbase + ((int64_t) MAX(s3->accel.cy, s3->accel.cy + step * (h - 1)) * s3->width) + sx_lo + w;
+    if ((src_lo < 0) || (src_hi > elems))
+        return 0;
+
+    src  = (int64_t) srcbase + ((int64_t) s3->accel.cy * s3->width) + sx_lo;
+    dest = (int64_t) dstbase + ((int64_t) s3->accel.dy * s3->width) + x_lo;
+
+    if (s3->accel.cmd & 0x20) {
+        if ((dest > src) && (dest < (src + w)))
+            return 0;
+    } else if ((dest < src) && ((dest + w) > src))
+        return 0;
+
+    for (int y = 0; y < h; y++) {
+        memmove(&svga->vram[dest << shift], &svga->vram[src << shift], w << shift);
+        s3_accel_fast_changed(s3, dest, w, shift);
+
+        src += step * s3->width;
+        dest += step * s3->width;
+    }
+
+    /*Leave the registers as the pixel loop would have.*/
+    s3->accel.cy += step * h;
+    s3->accel.dy = (s3->accel.dy + step * h) & 0xfff;
+    s3->accel.src         = srcbase + s3->accel.cy * s3->width;
+    s3->accel.dest        = dstbase + s3->accel.dy * s3->width;
+    s3->accel.sx          = s3->accel.maj_axis_pcnt & 0xfff;
+    s3->accel.sy          = -1;
+    s3->accel.destx_distp = s3->accel.dx;
+    s3->accel.desty_axstp = s3->accel.dy;
+
+    s3->accel.fast_blits++;
+    return 1;
+}
+
 void
 s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, void *priv)
 {
@@ -8337,6 +8558,10 @@ s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, voi
                     s3->data_available = 1;
                     return;
                 }
+
+                if (s3_accel_fast_fill(s3, dstbase, wrt_mask, compare_mode))
+                    return;
+                s3->accel.slow_fills++;
             }
 
             frgd_mix = (s3->accel.frgd_mix >> 5) & 3;
@@ -8555,6 +8780,12 @@ s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, voi
                 return; /*Wait for data from CPU*/
             }
 
+            if (!cpu_input) {
+                if (s3_accel_fast_blit(s3, srcbase, dstbase, wrt_mask, compare_mode, vram_mask))
+                    return;
+                s3->accel.slow_blits++;
+            }
+
             frgd_mix = (s3->accel.frgd_mix >> 5) & 3;
             bkgd_mix = (s3->accel.bkgd_mix >> 5) & 3;
 
@@ -10525,6 +10756,10 @@ s3_close(void *priv)
     thread_destroy_event(s3->fifo_not_full_event);
     thread_destroy_event(s3->wake_fifo_thread);
 
+    s3_log("S3 accel: %u of %u rectangle fills and %u of %u BitBlts took the fast path.\n",
+           s3->accel.fast_fills, s3->accel.fast_fills + s3->accel.slow_fills,
+           s3->accel.fast_blits, s3->accel.fast_blits + s3->accel.slow_blits);
+
     svga_close(&s3->svga);
 
     ddc_close(s3->ddc);
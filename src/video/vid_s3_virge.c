@@ -50,9 +50,14 @@ static int dither[4][4] = {
 #define RB_SIZE                       256
 #define RB_MASK                       (RB_SIZE - 1)
 
-#define RB_ENTRIES                    (virge->s3d_write_idx - virge->s3d_read_idx)
-#define RB_FULL                       (RB_ENTRIES == RB_SIZE)
-#define RB_EMPTY                      (!RB_ENTRIES)
+#define RB_ENTRIES(c)                 (virge->s3d_write_idx - virge->s3d_read_idx[c])
+#define RB_FULL(c)                    (RB_ENTRIES(c) == RB_SIZE)
+#define RB_EMPTY(c)                   (!RB_ENTRIES(c))
+
+/*Triangles are rasterised by up to this many threads, each one taking every
+  render_threads'th band of 1 << S3D_BAND_SHIFT scanlines.*/
+#define S3D_MAX_RENDER_THREADS        4
+#define S3D_BAND_SHIFT                3
 
 #define FIFO_SIZE                     65536
 #define FIFO_MASK                     (FIFO_SIZE - 1)
@@ -155,6 +160,11 @@ typedef struct s3d_t {
     uint8_t fog_r, fog_g, fog_b;
 } s3d_t;
 
+typedef struct s3d_render_thread_t {
+    struct virge_t *virge;
+    int             thread; /* Index of the thread, selects the scanline bands it renders. */
+} s3d_render_thread_t;
+
 typedef struct virge_t {
     mem_mapping_t linear_mapping;
     mem_mapping_t mmio_mapping;
@@ -188,10 +198,11 @@ typedef struct virge_t {
     uint32_t memory_size;
     uint32_t vram_mask;
 
-    thread_t *render_thread;
-    event_t  *wake_render_thread;
-    event_t  *wake_main_thread;
-    event_t  *not_full_event;
+    int                 render_threads;
+    thread_t           *render_thread[S3D_MAX_RENDER_THREADS];
+    event_t            *wake_render_thread[S3D_MAX_RENDER_THREADS];
+    event_t            *not_full_event;
+    s3d_render_thread_t render_thread_data[S3D_MAX_RENDER_THREADS];
 
     uint32_t hwc_fg_col, hwc_bg_col;
     int      hwc_col_stack_pos;
@@ -244,8 +255,9 @@ typedef struct virge_t {
     s3d_t s3d_tri;
 
     s3d_t      s3d_buffer[RB_SIZE];
-    atomic_int s3d_read_idx, s3d_write_idx;
-    atomic_int s3d_busy;
+    atomic_int s3d_read_idx[S3D_MAX_RENDER_THREADS];
+    atomic_int s3d_write_idx;
+    atomic_int s3d_busy[S3D_MAX_RENDER_THREADS];
 
     struct
     {
@@ -282,7 +294,7 @@ typedef struct virge_t {
     uint8_t      cmd_dma;
     uint32_t     cmd_dma_base;
     uint32_t     dma_ptr;
-    uint64_t     blitter_time;
+    uint64_t     blitter_time[S3D_MAX_RENDER_THREADS];
     int          fifo_slots_num;
 
     pc_timer_t tri_timer;
@@ -309,7 +321,7 @@ static video_timings_t timing_diamond_stealth3d_3000_pci = { .type = VIDEO_PCI,
 static video_timings_t timing_virge_dx_pci               = { .type = VIDEO_PCI, .write_b = 2, .write_w = 2, .write_l = 3, .read_b = 28, .read_w = 28, .read_l = 45 };
 static video_timings_t timing_virge_agp                  = { .type = VIDEO_AGP, .write_b = 2, .write_w = 2, .write_l = 3, .read_b = 28, .read_w = 28, .read_l = 45 };
 
-static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri);
+static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri, int thread);
 
 static void s3_virge_recalctimings(svga_t *svga);
 static void s3_virge_updatemapping(virge_t *virge);
@@ -395,29 +407,62 @@ s3_virge_log(const char *fmt, ...)
 #    define s3_virge_log(fmt, ...)
 #endif
 
+static int
+s3_virge_3d_busy(virge_t *virge)
+{
+    for (int c = 0; c < virge->render_threads; c++) {
+        if (virge->s3d_busy[c])
+            return 1;
+    }
+
+    return 0;
+}
+
+static int
+s3_virge_render_queue_full(virge_t *virge)
+{
+    for (int c = 0; c < virge->render_threads; c++) {
+        if (RB_FULL(c))
+            return 1;
+    }
+
+    return 0;
+}
+
+static int
+s3_virge_render_queue_empty(virge_t *virge)
+{
+    for (int c = 0; c < virge->render_threads; c++) {
+        if (!RB_EMPTY(c))
+            return 0;
+    }
+
+    return 1;
+}
+
 static void
 s3_virge_tri_timer(void *priv)
 {
     virge_t *virge = (virge_t *) priv;
 
-    thread_set_event(virge->wake_render_thread); /*Wake up FIFO thread if moving from idle*/
+    for (int c = 0; c < virge->render_threads; c++)
+        thread_set_event(virge->wake_render_thread[c]); /*Wake up render threads if moving from idle*/
 }
 
 static void
 queue_triangle(virge_t *virge)
 {
-    if (RB_FULL) {
+    /*Every render thread reads every triangle, so the slowest one decides
+      whether there is room.*/
+    while (s3_virge_render_queue_full(virge)) {
         thread_reset_event(virge->not_full_event);
-        thread_reset_event(virge->wake_main_thread);
-        if (RB_FULL) {
+        if (s3_virge_render_queue_full(virge))
             thread_wait_event(virge->not_full_event, -1); /*Wait for room in ringbuffer*/
-            thread_wait_event(virge->wake_main_thread, -1);
-        }
     }
     virge->s3d_buffer[virge->s3d_write_idx & RB_MASK] = virge->s3d_tri;
     virge->s3d_write_idx++;
 
-    if (!virge->s3d_busy) {
+    if (!s3_virge_3d_busy(virge)) {
         if (!(timer_is_enabled(&virge->tri_timer)))
             timer_set_delay_u64(&virge->tri_timer, 100 * TIMER_USEC);
     }
@@ -435,26 +480,48 @@ s3_virge_update_irqs(virge_t *virge)
 static void
 render_thread(void *param)
 {
-    virge_t *virge = (virge_t *) param;
+    s3d_render_thread_t *data   = (s3d_render_thread_t *) param;
+    virge_t             *virge  = data->virge;
+    int                  thread = data->thread;
 
     while (virge->render_thread_run) {
-        thread_wait_event(virge->wake_render_thread, -1);
-        thread_reset_event(virge->wake_render_thread);
-        virge->s3d_busy = 1;
-        while (!RB_EMPTY) {
-            s3_virge_triangle(virge, &virge->s3d_buffer[virge->s3d_read_idx & RB_MASK]);
-            virge->s3d_read_idx++;
-            if (RB_ENTRIES == RB_MASK) {
+        thread_wait_event(virge->wake_render_thread[thread], -1);
+        thread_reset_event(virge->wake_render_thread[thread]);
+        virge->s3d_busy[thread] = 1;
+        while (!RB_EMPTY(thread)) {
+            s3_virge_triangle(virge, &virge->s3d_buffer[virge->s3d_read_idx[thread] & RB_MASK], thread);
+            virge->s3d_read_idx[thread]++;
+            if (RB_ENTRIES(thread) == RB_MASK)
                 thread_set_event(virge->not_full_event);
-                thread_set_event(virge->wake_main_thread);
-            }
         }
-        virge->s3d_busy = 0;
-        virge->subsys_stat |= INT_S3D_DONE;
-        s3_virge_update_irqs(virge);
+        virge->s3d_busy[thread] = 0;
+
+        /*The FIFO thread only sees the engine as done once every band is.*/
+        if (!s3_virge_3d_busy(virge) && s3_virge_render_queue_empty(virge)) {
+            virge->subsys_stat |= INT_S3D_DONE;
+            s3_virge_update_irqs(virge);
+        }
     }
 }
 
+/*A render_threads setting of 0 selects one render thread per host CPU core,
+  leaving one core for the emulation thread.*/
+static int
+s3_virge_render_threads_from_config(int config)
+{
+    int threads = config;
+
+    if (threads <= 0)
+        threads = thread_get_cpu_count() - 1;
+
+    if (threads < 1)
+        threads = 1;
+    else if (threads > S3D_MAX_RENDER_THREADS)
+        threads = S3D_MAX_RENDER_THREADS;
+
+    return threads;
+}
+
 static void
 s3_virge_out(uint16_t addr, uint8_t val, void *priv)
 {
@@ -661,7 +728,7 @@ s3_virge_out(uint16_t addr, uint8_t val, void *priv)
                             svga->ma_latch |= (virge->ma_ext << 16);
                     } else {
                         svga->fullchange = changeframecount;
-                        svga_recalctimings(svga);
+                        svga_recalctimings_crtc(svga);
                     }
                 }
             }
@@ -1618,7 +1685,7 @@ s3_virge_mmio_read(uint32_t addr, void *priv)
             return ret;
         case 0x8505:
             ret = 0xd0;
-            if (!virge->s3d_busy)
+            if (!s3_virge_3d_busy(virge))
                 ret |= 0x20;
             return ret;
 
@@ -1709,7 +1776,7 @@ s3_virge_mmio_read_w(uint32_t addr, void *priv)
     switch (addr & 0xfffe) {
         case 0x8504:
             ret = 0xd000;
-            if (!virge->s3d_busy)
+            if (!s3_virge_3d_busy(virge))
                 ret |= 0x2000;
             virge->subsys_stat |= (INT_3DF_EMP | INT_FIFO_EMP);
             ret |= virge->subsys_stat;
@@ -1809,7 +1876,7 @@ s3_virge_mmio_read_l(uint32_t addr, void *priv)
 
         case 0x8504:
             ret = 0x0000d000;
-            if (!virge->s3d_busy)
+            if (!s3_virge_3d_busy(virge))
                 ret |= 0x00002000;
             virge->subsys_stat |= (INT_3DF_EMP | INT_FIFO_EMP);
             ret |= virge->subsys_stat;
@@ -2569,7 +2636,7 @@ skip_line:
 
 #define RGB15(r, g, b, dest)                                                                   \
     if (virge->dithering_enabled) {                                                            \
-        int add = dither[_y & 3][_x & 3];                                                      \
+        int add = dither[state->y & 3][x & 3];                                                 \
         int _r  = (r > 248) ? 248 : r + add;                                                   \
         int _g  = (g > 248) ? 248 : g + add;                                                   \
         int _b  = (b > 248) ? 248 : b + add;                                                   \
@@ -2583,6 +2650,13 @@ typedef struct rgba_t {
     int r, g, b, a;
 } rgba_t;
 
+typedef struct s3d_texture_state_t {
+    int level;
+    int texture_shift;
+
+    int32_t u, v;
+} s3d_texture_state_t;
+
 typedef struct s3d_state_t {
     int32_t r, g, b, a, u, v, d, w;
 
@@ -2602,26 +2676,19 @@ typedef struct s3d_state_t {
     int32_t x1, x2;
     int     y;
 
-    rgba_t dest_rgba;
-} s3d_state_t;
-
-typedef struct s3d_texture_state_t {
-    int level;
-    int texture_shift;
+    int thread; /* Render thread this triangle is being drawn by. */
 
-    int32_t u, v;
-} s3d_texture_state_t;
+    rgba_t dest_rgba;
 
-static void (*tex_read)(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out);
-static void (*tex_sample)(s3d_state_t *state);
-static void (*dest_pixel)(s3d_state_t *state);
+    /*Per triangle rather than static, as render threads run concurrently.*/
+    void (*tex_read)(struct s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out);
+    void (*tex_sample)(struct s3d_state_t *state);
+    void (*dest_pixel)(struct s3d_state_t *state);
+} s3d_state_t;
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
-static int _x;
-static int _y;
-
 static void
 tex_ARGB1555(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
 {
@@ -2712,7 +2779,7 @@ tex_sample_normal(s3d_state_t *state)
     texture_state.u             = state->u + state->tbu;
     texture_state.v             = state->v + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -2731,21 +2798,21 @@ tex_sample_normal_filter(s3d_state_t *state)
 
     texture_state.u = state->u + state->tbu;
     texture_state.v = state->v + state->tbv;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (texture_state.u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (texture_state.v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = state->u + state->tbu + tex_offset;
     texture_state.v = state->v + state->tbv;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = state->u + state->tbu;
     texture_state.v = state->v + state->tbv + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = state->u + state->tbu + tex_offset;
     texture_state.v = state->v + state->tbv + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -2770,7 +2837,7 @@ tex_sample_mipmap(s3d_state_t *state)
     texture_state.u             = state->u + state->tbu;
     texture_state.v             = state->v + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -2791,21 +2858,21 @@ tex_sample_mipmap_filter(s3d_state_t *state)
 
     texture_state.u = state->u + state->tbu;
     texture_state.v = state->v + state->tbv;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (texture_state.u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (texture_state.v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = state->u + state->tbu + tex_offset;
     texture_state.v = state->v + state->tbv;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = state->u + state->tbu;
     texture_state.v = state->v + state->tbv + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = state->u + state->tbu + tex_offset;
     texture_state.v = state->v + state->tbv + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -2832,7 +2899,7 @@ tex_sample_persp_normal(s3d_state_t *state)
     texture_state.u             = (int32_t) (((int64_t) state->u * (int64_t) w) >> (12 + state->max_d)) + state->tbu;
     texture_state.v             = (int32_t) (((int64_t) state->v * (int64_t) w) >> (12 + state->max_d)) + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -2860,21 +2927,21 @@ tex_sample_persp_normal_filter(s3d_state_t *state)
 
     texture_state.u = u;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = u + tex_offset;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = u;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = u + tex_offset;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -2901,7 +2968,7 @@ tex_sample_persp_normal_375(s3d_state_t *state)
     texture_state.u             = (int32_t) (((int64_t) state->u * (int64_t) w) >> (8 + state->max_d)) + state->tbu;
     texture_state.v             = (int32_t) (((int64_t) state->v * (int64_t) w) >> (8 + state->max_d)) + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -2929,21 +2996,21 @@ tex_sample_persp_normal_filter_375(s3d_state_t *state)
 
     texture_state.u = u;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = u + tex_offset;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = u;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = u + tex_offset;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -2972,7 +3039,7 @@ tex_sample_persp_mipmap(s3d_state_t *state)
     texture_state.u             = (int32_t) (((int64_t) state->u * (int64_t) w) >> (12 + state->max_d)) + state->tbu;
     texture_state.v             = (int32_t) (((int64_t) state->v * (int64_t) w) >> (12 + state->max_d)) + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -3002,21 +3069,21 @@ tex_sample_persp_mipmap_filter(s3d_state_t *state)
 
     texture_state.u = u;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = u + tex_offset;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = u;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = u + tex_offset;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -3045,7 +3112,7 @@ tex_sample_persp_mipmap_375(s3d_state_t *state)
     texture_state.u             = (int32_t) (((int64_t) state->u * (int64_t) w) >> (8 + state->max_d)) + state->tbu;
     texture_state.v             = (int32_t) (((int64_t) state->v * (int64_t) w) >> (8 + state->max_d)) + state->tbv;
 
-    tex_read(state, &texture_state, &state->dest_rgba);
+    state->tex_read(state, &texture_state, &state->dest_rgba);
 }
 
 static void
@@ -3075,21 +3142,21 @@ tex_sample_persp_mipmap_filter_375(s3d_state_t *state)
 
     texture_state.u = u;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[0]);
+    state->tex_read(state, &texture_state, &tex_samples[0]);
     du = (u >> (texture_state.texture_shift - 8)) & 0xff;
     dv = (v >> (texture_state.texture_shift - 8)) & 0xff;
 
     texture_state.u = u + tex_offset;
     texture_state.v = v;
-    tex_read(state, &texture_state, &tex_samples[1]);
+    state->tex_read(state, &texture_state, &tex_samples[1]);
 
     texture_state.u = u;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[2]);
+    state->tex_read(state, &texture_state, &tex_samples[2]);
 
     texture_state.u = u + tex_offset;
     texture_state.v = v + tex_offset;
-    tex_read(state, &texture_state, &tex_samples[3]);
+    state->tex_read(state, &texture_state, &tex_samples[3]);
 
     d[0] = (256 - du) * (256 - dv);
     d[1] = du * (256 - dv);
@@ -3153,7 +3220,7 @@ dest_pixel_gouraud_shaded_triangle(s3d_state_t *state)
 static void
 dest_pixel_unlit_texture_triangle(s3d_state_t *state)
 {
-    tex_sample(state);
+    state->tex_sample(state);
 
     if (state->cmd_set & CMD_SET_ABC_SRC)
         state->dest_rgba.a = state->a >> 7;
@@ -3162,7 +3229,7 @@ dest_pixel_unlit_texture_triangle(s3d_state_t *state)
 static void
 dest_pixel_lit_texture_decal(s3d_state_t *state)
 {
-    tex_sample(state);
+    state->tex_sample(state);
 
     if (state->cmd_set & CMD_SET_ABC_SRC)
         state->dest_rgba.a = state->a >> 7;
@@ -3171,7 +3238,7 @@ dest_pixel_lit_texture_decal(s3d_state_t *state)
 static void
 dest_pixel_lit_texture_reflection(s3d_state_t *state)
 {
-    tex_sample(state);
+    state->tex_sample(state);
 
     state->dest_rgba.r += (state->r >> 7);
     state->dest_rgba.g += (state->g >> 7);
@@ -3190,7 +3257,7 @@ dest_pixel_lit_texture_modulate(s3d_state_t *state)
     int b = state->b >> 7;
     int a = state->a >> 7;
 
-    tex_sample(state);
+    state->tex_sample(state);
 
     CLAMP_RGBA(r, g, b, a);
 
@@ -3342,6 +3409,11 @@ tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int
                 }
             }
 
+            /*Lines in other bands are left to their threads, the
+              clipping above still has to run so y_count stays in step.*/
+            if ((((uint32_t) state->y >> S3D_BAND_SHIFT) % virge->render_threads) != state->thread)
+                goto tri_next_line;
+
             svga->changedvram[(dest_offset & virge->vram_mask) >> 12] = changeframecount;
 
             dest_addr = dest_offset + (x * (bpp + 1));
@@ -3352,8 +3424,6 @@ tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int
 
             while (x != xe) {
                 update = 1;
-                _x     = x;
-                _y     = state->y;
 
                 if (use_z) {
                     src_z = *(uint16_t *) &vram[z_addr & virge->vram_mask];
@@ -3409,7 +3479,7 @@ tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int
                 if (update) {
                     uint32_t dest_col;
 
-                    dest_pixel(state);
+                    state->dest_pixel(state);
 
                     if (s3d_tri->cmd_set & CMD_SET_FE) {
                         int a              = state->a >> 7;
@@ -3484,6 +3554,7 @@ tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int
             }
         }
 
+tri_next_line:
         y_count--;
 
 tri_skip_line:
@@ -3516,7 +3587,7 @@ static int tex_size[8] = {
 };
 
 static void
-s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
+s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri, int thread)
 {
     s3d_state_t state;
 
@@ -3534,6 +3605,8 @@ s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 
     state.cmd_set = s3d_tri->cmd_set;
 
+    state.thread = thread;
+
     state.base_u = s3d_tri->tus;
     state.base_v = s3d_tri->tvs;
     state.base_z = s3d_tri->tzs;
@@ -3553,19 +3626,19 @@ s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 
     switch ((s3d_tri->cmd_set >> 27) & 0xf) {
         case 0:
-            dest_pixel = dest_pixel_gouraud_shaded_triangle;
+            state.dest_pixel = dest_pixel_gouraud_shaded_triangle;
             break;
         case 1:
         case 5:
             switch ((s3d_tri->cmd_set >> 15) & 0x3) {
                 case 0:
-                    dest_pixel = dest_pixel_lit_texture_reflection;
+                    state.dest_pixel = dest_pixel_lit_texture_reflection;
                     break;
                 case 1:
-                    dest_pixel = dest_pixel_lit_texture_modulate;
+                    state.dest_pixel = dest_pixel_lit_texture_modulate;
                     break;
                 case 2:
-                    dest_pixel = dest_pixel_lit_texture_decal;
+                    state.dest_pixel = dest_pixel_lit_texture_decal;
                     break;
                 default:
                     s3_virge_log("bad triangle type %x\n", (s3d_tri->cmd_set >> 27) & 0xf);
@@ -3574,7 +3647,7 @@ s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
             break;
         case 2:
         case 6:
-            dest_pixel = dest_pixel_unlit_texture_triangle;
+            state.dest_pixel = dest_pixel_unlit_texture_triangle;
             break;
         default:
             s3_virge_log("bad triangle type %x\n", (s3d_tri->cmd_set >> 27) & 0xf);
@@ -3584,47 +3657,47 @@ s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
     switch (((s3d_tri->cmd_set >> 12) & 7) | ((s3d_tri->cmd_set & (1 << 29)) ? 8 : 0)) {
         case 0:
         case 1:
-            tex_sample = tex_sample_mipmap;
+            state.tex_sample = tex_sample_mipmap;
             break;
         case 2:
         case 3:
-            tex_sample = virge->bilinear_enabled ? tex_sample_mipmap_filter : tex_sample_mipmap;
+            state.tex_sample = virge->bilinear_enabled ? tex_sample_mipmap_filter : tex_sample_mipmap;
             break;
         case 4:
         case 5:
-            tex_sample = tex_sample_normal;
+            state.tex_sample = tex_sample_normal;
             break;
         case 6:
         case 7:
-            tex_sample = virge->bilinear_enabled ? tex_sample_normal_filter : tex_sample_normal;
+            state.tex_sample = virge->bilinear_enabled ? tex_sample_normal_filter : tex_sample_normal;
             break;
         case (0 | 8):
         case (1 | 8):
             if (virge->chip == S3_VIRGEDX || virge->chip >= S3_VIRGEGX2)
-                tex_sample = tex_sample_persp_mipmap_375;
+                state.tex_sample = tex_sample_persp_mipmap_375;
             else
-                tex_sample = tex_sample_persp_mipmap;
+                state.tex_sample = tex_sample_persp_mipmap;
             break;
         case (2 | 8):
         case (3 | 8):
             if (virge->chip == S3_VIRGEDX || virge->chip >= S3_VIRGEGX2)
-                tex_sample = virge->bilinear_enabled ? tex_sample_persp_mipmap_filter_375 : tex_sample_persp_mipmap_375;
+                state.tex_sample = virge->bilinear_enabled ? tex_sample_persp_mipmap_filter_375 : tex_sample_persp_mipmap_375;
             else
-                tex_sample = virge->bilinear_enabled ? tex_sample_persp_mipmap_filter : tex_sample_persp_mipmap;
+                state.tex_sample = virge->bilinear_enabled ? tex_sample_persp_mipmap_filter : tex_sample_persp_mipmap;
             break;
         case (4 | 8):
         case (5 | 8):
             if (virge->chip == S3_VIRGEDX || virge->chip >= S3_VIRGEGX2)
-                tex_sample = tex_sample_persp_normal_375;
+                state.tex_sample = tex_sample_persp_normal_375;
             else
-                tex_sample = tex_sample_persp_normal;
+                state.tex_sample = tex_sample_persp_normal;
             break;
         case (6 | 8):
         case (7 | 8):
             if (virge->chip == S3_VIRGEDX || virge->chip >= S3_VIRGEGX2)
-                tex_sample = virge->bilinear_enabled ? tex_sample_persp_normal_filter_375 : tex_sample_persp_normal_375;
+                state.tex_sample = virge->bilinear_enabled ? tex_sample_persp_normal_filter_375 : tex_sample_persp_normal_375;
             else
-                tex_sample = virge->bilinear_enabled ? tex_sample_persp_normal_filter : tex_sample_persp_normal;
+                state.tex_sample = virge->bilinear_enabled ? tex_sample_persp_normal_filter : tex_sample_persp_normal;
             break;
 
         default:
@@ -3633,17 +3706,17 @@ s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 
     switch ((s3d_tri->cmd_set >> 5) & 7) {
         case 0:
-            tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB8888 : tex_ARGB8888_nowrap;
+            state.tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB8888 : tex_ARGB8888_nowrap;
             break;
         case 1:
-            tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB4444 : tex_ARGB4444_nowrap;
+            state.tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB4444 : tex_ARGB4444_nowrap;
             break;
         case 2:
-            tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB1555 : tex_ARGB1555_nowrap;
+            state.tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB1555 : tex_ARGB1555_nowrap;
             break;
         default:
             s3_virge_log("bad texture type %i\n", (s3d_tri->cmd_set >> 5) & 7);
-            tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB1555 : tex_ARGB1555_nowrap;
+            state.tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB1555 : tex_ARGB1555_nowrap;
             break;
     }
 
@@ -3656,7 +3729,7 @@ s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 
     end_time = plat_timer_read();
 
-    virge->blitter_time += end_time - start_time;
+    virge->blitter_time[thread] += end_time - start_time;
 }
 
 static void
@@ -4302,6 +4375,7 @@ s3_virge_init(const device_t *info)
 
     virge->bilinear_enabled  = device_get_config_int("bilinear");
     virge->dithering_enabled = device_get_config_int("dithering");
+    virge->render_threads    = s3_virge_render_threads_from_config(device_get_config_int("render_threads"));
     if (info->local >= S3_VIRGE_GX2)
         virge->memory_size = 4;
     else
@@ -4544,11 +4618,14 @@ s3_virge_init(const device_t *info)
 
     virge->svga.force_old_addr = 1;
 
-    virge->wake_render_thread = thread_create_event();
-    virge->wake_main_thread   = thread_create_event();
-    virge->not_full_event     = thread_create_event();
-    virge->render_thread_run  = 1;
-    virge->render_thread      = thread_create(render_thread, virge);
+    virge->not_full_event    = thread_create_event();
+    virge->render_thread_run = 1;
+    for (int c = 0; c < virge->render_threads; c++) {
+        virge->wake_render_thread[c]         = thread_create_event();
+        virge->render_thread_data[c].virge  = virge;
+        virge->render_thread_data[c].thread = c;
+        virge->render_thread[c]              = thread_create(render_thread, &virge->render_thread_data[c]);
+    }
 
     timer_add(&virge->tri_timer, s3_virge_tri_timer, virge, 0);
 
@@ -4565,11 +4642,12 @@ s3_virge_close(void *priv)
     virge_t *virge = (virge_t *) priv;
 
     virge->render_thread_run = 0;
-    thread_set_event(virge->wake_render_thread);
-    thread_wait(virge->render_thread);
+    for (int c = 0; c < virge->render_threads; c++) {
+        thread_set_event(virge->wake_render_thread[c]);
+        thread_wait(virge->render_thread[c]);
+        thread_destroy_event(virge->wake_render_thread[c]);
+    }
     thread_destroy_event(virge->not_full_event);
-    thread_destroy_event(virge->wake_main_thread);
-    thread_destroy_event(virge->wake_render_thread);
 
     svga_close(&virge->svga);
 
@@ -4697,6 +4775,33 @@ static const device_config_t s3_virge_config[] = {
         .type = CONFIG_BINARY,
         .default_int = 1
     },
+    {
+        .name = "render_threads",
+        .description = "Render threads",
+        .type = CONFIG_SELECTION,
+        .selection = {
+            {
+                .description = "Auto",
+                .value = 0
+            },
+            {
+                .description = "1",
+                .value = 1
+            },
+            {
+                .description = "2",
+                .value = 2
+            },
+            {
+                .description = "4",
+                .value = 4
+            },
+            {
+                .description = ""
+            }
+        },
+        .default_int = 0
+    },
     {
         .type = CONFIG_END
     }
@@ -4740,6 +4845,33 @@ static const device_config_t s3_virge_stb_config[] = {
         .type = CONFIG_BINARY,
         .default_int = 1
     },
+    {
+        .name = "render_threads",
+        .description = "Render threads",
+        .type = CONFIG_SELECTION,
+        .selection = {
+            {
+                .description = "Auto",
+                .value = 0
+            },
+            {
+                .description = "1",
+                .value = 1
+            },
+            {
+                .description = "2",
+                .value = 2
+            },
+            {
+                .description = "4",
+                .value = 4
+            },
+            {
+                .description = ""
+            }
+        },
+        .default_int = 0
+    },
     {
         .type = CONFIG_END
     }
@@ -4760,6 +4892,33 @@ static const device_config_t s3_virge_357_config[] = {
         .type = CONFIG_BINARY,
         .default_int = 1
     },
+    {
+        .name = "render_threads",
+        .description = "Render threads",
+        .type = CONFIG_SELECTION,
+        .selection = {
+            {
+                .description = "Auto",
+                .value = 0
+            },
+            {
+                .description = "1",
+                .value = 1
+            },
+            {
+                .description = "2",
+                .value = 2
+            },
+            {
+                .description = "4",
+                .value = 4
+            },
+            {
+                .description = ""
+            }
+        },
+        .default_int = 0
+    },
     {
         .type = CONFIG_END
     }
@@ -4799,6 +4958,33 @@ static const device_config_t s3_trio3d_config[] = {
         .type = CONFIG_BINARY,
         .default_int = 1
     },
+    {
+        .name = "render_threads",
+        .description = "Render threads",
+        .type = CONFIG_SELECTION,
+        .selection = {
+            {
+                .description = "Auto",
+                .value = 0
+            },
+            {
+                .description = "1",
+                .value = 1
+            },
+            {
+                .description = "2",
+                .value = 2
+            },
+            {
+                .description = "4",
+                .value = 4
+            },
+            {
+                .description = ""
+            }
+        },
+        .default_int = 0
+    },
     {
         .type = CONFIG_END
     }
@@ -4839,6 +5025,33 @@ static const device_config_t s3_trio3d2x_config[] = {
         .type = CONFIG_BINARY,
         .default_int = 1
     },
+    {
+        .name = "render_threads",
+        .description = "Render threads",
+        .type = CONFIG_SELECTION,
+        .selection = {
+            {
+                .description = "Auto",
+                .value = 0
+            },
+            {
+                .description = "1",
+                .value = 1
+            },
+            {
+                .description = "2",
+                .value = 2
+            },
+            {
+                .description = "4",
+                .value = 4
+            },
+            {
+                .description = ""
+            }
+        },
+        .default_int = 0
+    },
     {
         .type = CONFIG_END
     }
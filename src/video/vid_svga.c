@@ -44,14 +44,15 @@
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
 #include <86box/vid_xga_device.h>
+#include <86box/metrics.h>
 
 void svga_doblit(int wx, int wy, svga_t *svga);
 void svga_poll(void *priv);
 
 svga_t *svga_8514;
 
-extern int     cyc_total;
-extern uint8_t edatlookup[4][4];
+extern int      cyc_total;
+extern uint32_t edatlookup8[256];
 
 uint8_t svga_rotate[8][256];
 
@@ -262,6 +263,8 @@ svga_out(uint16_t addr, uint8_t val, void *priv)
                     svga->chain2_write = !(val & 4);
                     svga->chain4       = (svga->chain4 & ~8) | (val & 8);
                     svga->fast         = (svga->gdcreg[8] == 0xff && !(svga->gdcreg[3] & 0x18) && !svga->gdcreg[1]) && ((svga->chain4 && (svga->packed_chain4 || svga->force_old_addr)) || svga->fb_only) && !(svga->adv_flags & FLAG_ADDR_BY8);
+                    if (!svga->fast)
+                        svga_lfb_direct_flush(svga);
                     break;
 
                 default:
@@ -359,6 +362,8 @@ svga_out(uint16_t addr, uint8_t val, void *priv)
             }
             svga->gdcreg[svga->gdcaddr & 15] = val;
             svga->fast                       = (svga->gdcreg[8] == 0xff && !(svga->gdcreg[3] & 0x18) && !svga->gdcreg[1]) && ((svga->chain4 && (svga->packed_chain4 || svga->force_old_addr)) || svga->fb_only);
+            if (!svga->fast)
+                svga_lfb_direct_flush(svga);
             if (((svga->gdcaddr & 15) == 5 && (val ^ o) & 0x70) || ((svga->gdcaddr & 15) == 6 && (val ^ o) & 1))
                 svga_recalctimings(svga);
             break;
@@ -595,6 +600,9 @@ svga_recalctimings(svga_t *svga)
     int              hsyncend;
 #endif
 
+    svga->recalc_pending = 0;
+    metrics.svga_recalcs++;
+
     svga->vtotal      = svga->crtc[6];
     svga->dispend     = svga->crtc[0x12];
     svga->vsyncstart  = svga->crtc[0x10];
@@ -953,6 +961,9 @@ svga_recalctimings(svga_t *svga)
     if (!svga->force_old_addr)
         svga_recalc_remap_func(svga);
 
+    /* The frame buffer layout may have changed under the direct lookups. */
+    svga_lfb_direct_flush(svga);
+
     /* Inform the user interface of any DPMS mode changes. */
     if (svga->dpms) {
         if (!svga->dpms_ui) {
@@ -961,6 +972,7 @@ svga_recalctimings(svga_t *svga)
             int x_add   = enable_overscan ? svga->monitor->mon_overscan_x : 0;
             int y_start = enable_overscan ? 0 : (svga->monitor->mon_overscan_y >> 1);
             int x_start = enable_overscan ? 0 : (svga->monitor->mon_overscan_x >> 1);
+            svga_render_thread_wait(svga);
             video_wait_for_buffer_monitor(svga->monitor_index);
             memset(svga->monitor->target_buffer->dat, 0, svga->monitor->target_buffer->w * svga->monitor->target_buffer->h * 4);
             video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
@@ -974,6 +986,33 @@ svga_recalctimings(svga_t *svga)
     }
 }
 
+/* Recalculate the timings after a CRTC register write. The standard
+   registers only feed the display, which is drawn a line at a time, so
+   guests that reprogram them a register at a time get one recalculation
+   at the start of the next line instead of one per write. Extension
+   registers can change how the CPU sees video memory, those, and any
+   write while something other than svga_poll() drives the display, take
+   effect at once. */
+void
+svga_recalctimings_crtc(svga_t *svga)
+{
+    if ((svga->crtcreg <= 0x18) && timer_is_enabled(&svga->timer) && (svga->timer.callback == svga_poll))
+        svga->recalc_pending = 1;
+    else
+        svga_recalctimings(svga);
+}
+
+/* Lines drawn over by a cursor or overlay have changed even when their VRAM
+   has not. */
+static void
+svga_mark_line(svga_t *svga, int line)
+{
+    if (line < svga->firstline_draw)
+        svga->firstline_draw = line;
+    if (line > svga->lastline_draw)
+        svga->lastline_draw = line;
+}
+
 static void
 svga_do_render(svga_t *svga)
 {
@@ -984,33 +1023,44 @@ svga_do_render(svga_t *svga)
     }
 
     if (!svga->override) {
-        svga->render(svga);
-
-        svga->x_add = (svga->monitor->mon_overscan_x >> 1);
-        svga_render_overscan_left(svga);
-        svga_render_overscan_right(svga);
+        /* Lines with a cursor or overlay drawn over them stay on this
+           thread, the worker draws the overscan of the lines it takes. */
+        if (svga->hwcursor_on || svga->dac_hwcursor_on || svga->overlay_on ||
+            !svga_render_thread_queue(svga)) {
+            svga->render(svga);
+
+            svga->x_add = (svga->monitor->mon_overscan_x >> 1);
+            svga_render_overscan_left(svga);
+            svga_render_overscan_right(svga);
+        }
         svga->x_add = (svga->monitor->mon_overscan_x >> 1) - svga->scrollcache;
     }
 
     if (svga->overlay_on) {
-        if (!svga->override && svga->overlay_draw)
+        if (!svga->override && svga->overlay_draw) {
             svga->overlay_draw(svga, svga->displine + svga->y_add);
+            svga_mark_line(svga, svga->displine);
+        }
         svga->overlay_on--;
         if (svga->overlay_on && svga->interlace)
             svga->overlay_on--;
     }
 
     if (svga->dac_hwcursor_on) {
-        if (!svga->override && svga->dac_hwcursor_draw)
+        if (!svga->override && svga->dac_hwcursor_draw) {
             svga->dac_hwcursor_draw(svga, (svga->displine + svga->y_add + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y)) & 2047);
+            svga_mark_line(svga, svga->displine + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y));
+        }
         svga->dac_hwcursor_on--;
         if (svga->dac_hwcursor_on && svga->interlace)
             svga->dac_hwcursor_on--;
     }
 
     if (svga->hwcursor_on) {
-        if (!svga->override && svga->hwcursor_draw)
+        if (!svga->override && svga->hwcursor_draw) {
             svga->hwcursor_draw(svga, (svga->displine + svga->y_add + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y)) & 2047);
+            svga_mark_line(svga, svga->displine + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y));
+        }
         svga->hwcursor_on--;
         if (svga->hwcursor_on && svga->interlace)
             svga->hwcursor_on--;
@@ -1029,6 +1079,9 @@ svga_poll(void *priv)
     int        ret;
     int        old_ma;
 
+    if (svga->recalc_pending)
+        svga_recalctimings(svga);
+
     if (!svga->override) {
         if (xga_active && xga && xga->on) {
             if ((xga->disp_cntl_2 & 7) >= 2) {
@@ -1202,6 +1255,10 @@ svga_poll(void *priv)
                 if (svga->changedvram[x])
                     svga->changedvram[x]--;
             }
+            /* Pages written through lookups get marked again on their next write,
+               and charged again on the first access of the next frame. */
+            svga_lfb_direct_flush(svga);
+            memset(svga->lfb_charged, 0, svga->lfb_pages);
             if (svga->fullchange)
                 svga->fullchange--;
         }
@@ -1218,6 +1275,7 @@ svga_poll(void *priv)
             wx = x;
 
             if (!svga->override) {
+                svga->dirty_blit = 1;
                 if (svga->vertical_linedbl) {
                     wy = (svga->lastline - svga->firstline) << 1;
                     svga_doblit(wx, wy, svga);
@@ -1344,6 +1402,8 @@ svga_init(const device_t *info, svga_t *svga, void *priv, int memsize,
     svga->vram_display_mask = svga->vram_mask = memsize - 1;
     svga->decode_mask                         = 0x7fffff;
     svga->changedvram                         = calloc(memsize >> 12, 1);
+    svga->lfb_pages                           = memsize >> 12;
+    svga->lfb_charged                         = calloc(svga->lfb_pages, 1);
     svga->recalctimings_ex                    = recalctimings_ex;
     svga->video_in                            = video_in;
     svga->video_out                           = video_out;
@@ -1386,12 +1446,18 @@ svga_init(const device_t *info, svga_t *svga, void *priv, int memsize,
 
     svga->map8            = svga->pallook;
 
+    svga_render_thread_init(svga);
+
     return 0;
 }
 
 void
 svga_close(svga_t *svga)
 {
+    svga_render_thread_close(svga);
+
+    svga_lfb_direct_flush(svga);
+    free(svga->lfb_charged);
     free(svga->changedvram);
     free(svga->vram);
 
@@ -1438,6 +1504,67 @@ svga_decode_addr(svga_t *svga, uint32_t addr, int write)
     return addr;
 }
 
+/* Expands a 4-bit plane mask into a byte mask over the 4 planes of a dword. */
+static __inline uint32_t
+svga_expand_planes(uint8_t mask)
+{
+    return ((((mask & 0x0f) * 0x00204081) & 0x01010101) * 0xff);
+}
+
+/* Write modes 0-3 on 4 planes at a dword aligned address, a whole dword at a time. */
+static void
+svga_write_planar(svga_t *svga, uint32_t addr, uint8_t val, int writemask2)
+{
+    uint32_t *vram     = (uint32_t *) &svga->vram[addr];
+    uint32_t  latch    = svga->latch.d[0];
+    uint32_t  wmask    = svga_expand_planes(writemask2);
+    uint32_t  bitmask  = svga->gdcreg[8] * 0x01010101;
+    uint32_t  setreset = svga_expand_planes(svga->gdcreg[0]);
+    uint32_t  enable   = svga_expand_planes(svga->gdcreg[1]);
+    uint32_t  vall;
+    uint32_t  out;
+
+    switch (svga->writemode) {
+        case 0:
+            val  = ((val >> (svga->gdcreg[3] & 7)) | (val << (8 - (svga->gdcreg[3] & 7))));
+            vall = val * 0x01010101;
+            if ((svga->gdcreg[8] != 0xff) || (svga->gdcreg[3] & 0x18) || (svga->gdcreg[1] && !svga->set_reset_disabled))
+                vall = (vall & ~enable) | (setreset & enable);
+            break;
+        case 1:
+            *vram = (*vram & ~wmask) | (latch & wmask);
+            return;
+        case 2:
+            vall = svga_expand_planes(val);
+            break;
+        case 3:
+            val  = ((val >> (svga->gdcreg[3] & 7)) | (val << (8 - (svga->gdcreg[3] & 7))));
+            bitmask &= val * 0x01010101;
+            vall = setreset;
+            break;
+        default:
+            return;
+    }
+
+    switch (svga->gdcreg[3] & 0x18) {
+        default:
+        case 0x00: /* Set */
+            out = (vall & bitmask) | (latch & ~bitmask);
+            break;
+        case 0x08: /* AND */
+            out = (vall | ~bitmask) & latch;
+            break;
+        case 0x10: /* OR */
+            out = (vall & bitmask) | latch;
+            break;
+        case 0x18: /* XOR */
+            out = (vall & bitmask) ^ latch;
+            break;
+    }
+
+    *vram = (*vram & ~wmask) | (out & wmask);
+}
+
 static __inline void
 svga_write_common(uint32_t addr, uint8_t val, uint8_t linear, void *priv)
 {
@@ -1536,6 +1663,12 @@ svga_write_common(uint32_t addr, uint8_t val, uint8_t linear, void *priv)
     if (svga->adv_flags & FLAG_LATCH8)
         count = 8;
 
+    if ((count == 4) && (svga->writemode < 4) && !(addr & 3) &&
+        !((svga->adv_flags & FLAG_EXT_WRITE) && (svga->adv_flags & FLAG_ADDR_BY8))) {
+        svga_write_planar(svga, addr, val, writemask2);
+        return;
+    }
+
     /* Undocumented Cirrus Logic behavior: The datasheet says that, with EXT_WRITE and FLAG_ADDR_BY8, the write mask only
        changes meaning in write modes 4 and 5, as well as write mode 1. In reality, however, all other write modes are also
        affected, as proven by the Windows 3.1 CL-GD 5422/4 drivers in 8bpp modes. */
@@ -1761,8 +1894,12 @@ svga_read_common(uint32_t addr, uint8_t linear, void *priv)
     } else {
         latch_addr &= svga->vram_mask;
 
-        for (uint8_t i = 0; i < count; i++)
-            svga->latch.b[i] = svga->vram[latch_addr | i];
+        if ((count == 4) && !(latch_addr & 3))
+            svga->latch.d[0] = *(uint32_t *) &svga->vram[latch_addr];
+        else {
+            for (uint8_t i = 0; i < count; i++)
+                svga->latch.b[i] = svga->vram[latch_addr | i];
+        }
     }
 
     if (addr >= svga->vram_max)
@@ -1773,14 +1910,10 @@ svga_read_common(uint32_t addr, uint8_t linear, void *priv)
     if (svga->readmode) {
         temp = 0xff;
 
-        for (uint8_t pixel = 0; pixel < 8; pixel++) {
-            for (uint8_t plane = 0; plane < count; plane++) {
-                if (svga->colournocare & (1 << plane)) {
-                    /* If we care about a plane, and the pixel has a mismatch on it, clear its bit. */
-                    if (((svga->latch.b[plane] >> pixel) & 1) != ((svga->colourcompare >> plane) & 1))
-                        temp &= ~(1 << pixel);
-                }
-            }
+        for (uint8_t plane = 0; plane < count; plane++) {
+            /* If we care about a plane, clear the bits of the pixels that mismatch on it. */
+            if (svga->colournocare & (1 << plane))
+                temp &= ~(svga->latch.b[plane] ^ (((svga->colourcompare >> plane) & 1) * 0xff));
         }
 
         ret = temp;
@@ -1827,6 +1960,21 @@ svga_doblit(int wx, int wy, svga_t *svga)
     int       j;
     int       xs_temp;
     int       ys_temp;
+    int       dirty = svga->dirty_blit;
+    int       dirty_y1;
+    int       dirty_y2;
+
+    svga_render_thread_wait(svga);
+
+    /* Rows of the target buffer written this frame, see svga_do_render(). */
+    svga->dirty_blit = 0;
+    if (svga->firstline_draw == 2000) {
+        dirty_y1 = 0;
+        dirty_y2 = 0;
+    } else {
+        dirty_y1 = svga->firstline_draw + svga->y_add;
+        dirty_y2 = svga->lastline_draw + svga->y_add + 1;
+    }
 
     y_add   = enable_overscan ? svga->monitor->mon_overscan_y : 0;
     x_add   = enable_overscan ? svga->monitor->mon_overscan_x : 0;
@@ -1859,6 +2007,7 @@ svga_doblit(int wx, int wy, svga_t *svga)
         /* Screen res has changed.. fix up, and let them know. */
         svga->monitor->mon_xsize = xs_temp;
         svga->monitor->mon_ysize = ys_temp;
+        dirty                    = 0;
 
         if ((svga->monitor->mon_xsize > 1984) || (svga->monitor->mon_ysize > 2016)) {
             /* 2048x2048 is the biggest safe render texture, to account for overscan,
@@ -1895,12 +2044,79 @@ svga_doblit(int wx, int wy, svga_t *svga)
         }
     }
 
+    /* The overscan is redrawn on every line, a new colour changes all of them. */
+    if (svga->dirty_overscan_color != svga->overscan_color) {
+        svga->dirty_overscan_color = svga->overscan_color;
+        dirty                      = 0;
+    }
+    if (dirty)
+        video_blit_dirty_monitor(dirty_y1, dirty_y2, svga->monitor_index);
+
     video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
 
     if (svga->vertical_linedbl)
         svga->vertical_linedbl >>= 1;
 }
 
+/*
+ * With the fast path in effect, frame buffer pages can be handed to the
+ * CPU as plain memory, so that it stops calling the handlers for them. A
+ * page gets its lookup when the CPU goes through the handlers of the card
+ * itself, not those of a wrapper around them; it is then only marked as
+ * changed on the first write of a frame, as the write lookups are all
+ * taken back at every vertical sync, and whenever the fast path stops
+ * applying.
+ *
+ * Accesses through the lookups never come back to be charged their bus
+ * time, so the first one of each page in a frame is charged for a whole
+ * page of dword accesses instead. That keeps the average speed of frame
+ * buffer updates, which mostly cover whole pages, close to what charging
+ * every access gives. With video_bus_timing set to exact, no lookups are
+ * made and every access is charged as it happens.
+ */
+static void
+svga_lfb_direct_add(svga_t *svga, uint32_t phys, int write)
+{
+    const mem_mapping_t *map;
+    uint32_t             addr = phys & svga->decode_mask;
+    uint32_t             page;
+
+    if ((video_bus_timing == VIDEO_BUS_TIMING_EXACT) || (mem_logical_addr == 0xffffffff) || ((mem_logical_addr ^ phys) & 0xfff) ||
+        svga->translate_address || (svga->vram_mask < 0xfff) || ((addr | 0xfff) >= svga->vram_max))
+        return;
+
+    map = mem_get_phys_mapping(phys, write);
+    if ((map == NULL) || (map->priv != svga))
+        return;
+
+    if (write) {
+        if (((map->write_b != svga_writeb_linear) && (map->write_b != svga_write_linear)) ||
+            (map->write_w != svga_writew_linear) || (map->write_l != svga_writel_linear))
+            return;
+    } else if (((map->read_b != svga_readb_linear) && (map->read_b != svga_read_linear)) ||
+               (map->read_w != svga_readw_linear) || (map->read_l != svga_readl_linear))
+        return;
+
+    mem_add_direct_lookup(mem_logical_addr, &svga->vram[addr & svga->vram_mask & ~0xfff], write);
+    svga->lfb_direct = 1;
+
+    /* This access is charged by the caller, the rest of the page here. */
+    page = (addr & svga->vram_mask) >> 12;
+    if ((page < svga->lfb_pages) && !(svga->lfb_charged[page] & (write ? 2 : 1))) {
+        svga->lfb_charged[page] |= (write ? 2 : 1);
+        cycles -= ((4096 >> 2) - 1) * (write ? svga->monitor->mon_video_timing_write_l : svga->monitor->mon_video_timing_read_l);
+    }
+}
+
+void
+svga_lfb_direct_flush(svga_t *svga)
+{
+    if (svga->lfb_direct) {
+        mem_flush_direct_lookups(svga->vram, svga->vram_mask + 1);
+        svga->lfb_direct = 0;
+    }
+}
+
 void
 svga_writeb_linear(uint32_t addr, uint8_t val, void *priv)
 {
@@ -1911,6 +2127,8 @@ svga_writeb_linear(uint32_t addr, uint8_t val, void *priv)
         return;
     }
 
+    svga_lfb_direct_add(svga, addr, 1);
+
     addr &= svga->decode_mask;
     if (addr >= svga->vram_max)
         return;
@@ -1937,7 +2155,8 @@ svga_writew_common(uint32_t addr, uint16_t val, uint8_t linear, void *priv)
 
         if (addr == 0xffffffff)
             return;
-    }
+    } else
+        svga_lfb_direct_add(svga, addr, 1);
 
     addr &= svga->decode_mask;
     if (svga->translate_address) {
@@ -1993,7 +2212,8 @@ svga_writel_common(uint32_t addr, uint32_t val, uint8_t linear, void *priv)
 
         if (addr == 0xffffffff)
             return;
-    }
+    } else
+        svga_lfb_direct_add(svga, addr, 1);
 
     addr &= svga->decode_mask;
     if (svga->translate_address) {
@@ -2042,11 +2262,13 @@ svga_writel_linear(uint32_t addr, uint32_t val, void *priv)
 uint8_t
 svga_readb_linear(uint32_t addr, void *priv)
 {
-    const svga_t *svga = (svga_t *) priv;
+    svga_t *svga = (svga_t *) priv;
 
     if (!svga->fast)
         return svga_read_linear(addr, priv);
 
+    svga_lfb_direct_add(svga, addr, 0);
+
     addr &= svga->decode_mask;
     if (addr >= svga->vram_max)
         return 0xff;
@@ -2069,7 +2291,8 @@ svga_readw_common(uint32_t addr, uint8_t linear, void *priv)
 
         if (addr == 0xffffffff)
             return 0xffff;
-    }
+    } else
+        svga_lfb_direct_add(svga, addr, 0);
 
     addr &= svga->decode_mask;
     if (svga->translate_address) {
@@ -2116,7 +2339,8 @@ svga_readl_common(uint32_t addr, uint8_t linear, void *priv)
 
         if (addr == 0xffffffff)
             return 0xffffffff;
-    }
+    } else
+        svga_lfb_direct_add(svga, addr, 0);
 
     addr &= svga->decode_mask;
     if (svga->translate_address) {
@@ -17,13 +17,23 @@
  *          Copyright 2016-2019 Miran Grca.
  */
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    define SVGA_RENDER_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define SVGA_RENDER_NEON
+#endif
 #include <86box/86box.h>
 #include <86box/device.h>
 #include <86box/mem.h>
+#include <86box/thread.h>
 #include <86box/timer.h>
 #include <86box/video.h>
 #include <86box/vid_svga.h>
@@ -44,6 +54,136 @@ svga_lookup_lut_ram(svga_t* svga, uint32_t val)
 
 #define lookup_lut(val) svga_lookup_lut_ram(svga, val)
 
+/*
+ * Line converters for the linear high resolution modes.
+ *
+ * When the line does not wrap around the display mask, the palette is not
+ * used as a LUT and the card uses the stock 15/16 bpp conversion, the line
+ * is converted 4 or 8 pixels at a time. The vector code gives the same
+ * results as video_15to32[] and video_16to32[]: a 5 bit component
+ * scales to (c * 1053) >> 7 and a 6 bit one to (c << 2) + ((c * 49) >> 10).
+ * Anything else goes through the per pixel path.
+ */
+static int
+svga_render_line_linear(uint32_t ma, uint32_t mask, int bytes)
+{
+    return !(mask & (mask + 1)) && (((ma & mask) + bytes) <= (mask + 1));
+}
+
+static void
+svga_render_line_32bpp(svga_t *svga, uint32_t *p, uint32_t ma, uint32_t mask, int pixels)
+{
+    const uint32_t *src;
+    int             x = 0;
+
+    if (!svga->lut_map && svga_render_line_linear(ma, mask, pixels << 2)) {
+        src = (const uint32_t *) &svga->vram[ma & mask];
+#if defined(SVGA_RENDER_SSE2)
+        const __m128i rgb = _mm_set1_epi32(0x00ffffff);
+
+        for (; x <= (pixels - 4); x += 4)
+            _mm_storeu_si128((__m128i *) &p[x], _mm_and_si128(_mm_loadu_si128((const __m128i *) &src[x]), rgb));
+#elif defined(SVGA_RENDER_NEON)
+        const uint32x4_t rgb = vdupq_n_u32(0x00ffffff);
+
+        for (; x <= (pixels - 4); x += 4)
+            vst1q_u32(&p[x], vandq_u32(vld1q_u32(&src[x]), rgb));
+#endif
+        for (; x < pixels; x++)
+            p[x] = src[x] & 0xffffff;
+        return;
+    }
+
+    for (; x < pixels; x++)
+        p[x] = lookup_lut(*(uint32_t *) (&svga->vram[(ma + (x << 2)) & mask]) & 0xffffff);
+}
+
+static void
+svga_render_line_16bpp(svga_t *svga, uint32_t *p, uint32_t ma, uint32_t mask, int pixels, int bpp)
+{
+    const uint16_t *src;
+    const uint32_t *table = (bpp == 15) ? video_15to32 : video_16to32;
+    uint32_t        dat;
+    int             x = 0;
+
+    if ((svga->conv_16to32 == svga_conv_16to32) && svga_render_line_linear(ma, mask, pixels << 1)) {
+        src = (const uint16_t *) &svga->vram[ma & mask];
+#if defined(SVGA_RENDER_SSE2)
+        const __m128i m5   = _mm_set1_epi16(0x1f);
+        const __m128i m6   = _mm_set1_epi16(0x3f);
+        const __m128i k5   = _mm_set1_epi16(1053);
+        const __m128i k6   = _mm_set1_epi16(49);
+        __m128i       src16;
+        __m128i       r;
+        __m128i       g;
+        __m128i       b;
+
+        for (; x <= (pixels - 8); x += 8) {
+            src16 = _mm_loadu_si128((const __m128i *) &src[x]);
+            b     = _mm_and_si128(src16, m5);
+            if (bpp == 15) {
+                g = _mm_and_si128(_mm_srli_epi16(src16, 5), m5);
+                r = _mm_and_si128(_mm_srli_epi16(src16, 10), m5);
+                g = _mm_srli_epi16(_mm_mullo_epi16(g, k5), 7);
+            } else {
+                g = _mm_and_si128(_mm_srli_epi16(src16, 5), m6);
+                r = _mm_srli_epi16(src16, 11);
+                g = _mm_add_epi16(_mm_slli_epi16(g, 2), _mm_srli_epi16(_mm_mullo_epi16(g, k6), 10));
+            }
+            b = _mm_or_si128(_mm_srli_epi16(_mm_mullo_epi16(b, k5), 7), _mm_slli_epi16(g, 8));
+            r = _mm_srli_epi16(_mm_mullo_epi16(r, k5), 7);
+
+            _mm_storeu_si128((__m128i *) &p[x], _mm_unpacklo_epi16(b, r));
+            _mm_storeu_si128((__m128i *) &p[x + 4], _mm_unpackhi_epi16(b, r));
+        }
+#elif defined(SVGA_RENDER_NEON)
+        const uint16x8_t m5 = vdupq_n_u16(0x1f);
+        const uint16x8_t m6 = vdupq_n_u16(0x3f);
+        uint16x8_t       src16;
+        uint16x8_t       r;
+        uint16x8_t       g;
+        uint16x8_t       b;
+        uint16x8x2_t     out;
+
+        for (; x <= (pixels - 8); x += 8) {
+            src16 = vld1q_u16(&src[x]);
+            b     = vandq_u16(src16, m5);
+            if (bpp == 15) {
+                g = vandq_u16(vshrq_n_u16(src16, 5), m5);
+                r = vandq_u16(vshrq_n_u16(src16, 10), m5);
+                g = vshrq_n_u16(vmulq_n_u16(g, 1053), 7);
+            } else {
+                g = vandq_u16(vshrq_n_u16(src16, 5), m6);
+                r = vshrq_n_u16(src16, 11);
+                g = vaddq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(vmulq_n_u16(g, 49), 10));
+            }
+            b = vorrq_u16(vshrq_n_u16(vmulq_n_u16(b, 1053), 7), vshlq_n_u16(g, 8));
+            r = vshrq_n_u16(vmulq_n_u16(r, 1053), 7);
+
+            out = vzipq_u16(b, r);
+            vst1q_u32(&p[x], vreinterpretq_u32_u16(out.val[0]));
+            vst1q_u32(&p[x + 4], vreinterpretq_u32_u16(out.val[1]));
+        }
+#endif
+        for (; x < pixels; x++)
+            p[x] = table[src[x]];
+        return;
+    }
+
+    for (; x < pixels; x += 2) {
+        dat      = *(uint32_t *) (&svga->vram[(ma + (x << 1)) & mask]);
+        p[x]     = svga->conv_16to32(svga, dat & 0xffff, bpp);
+        p[x + 1] = svga->conv_16to32(svga, dat >> 16, bpp);
+    }
+}
+
+/* The 15/16 bpp renderers work in groups of 8 pixels. */
+static int
+svga_render_line_pixels(int count, int step)
+{
+    return (count < 0) ? 0 : (((count / step) + 1) * step);
+}
+
 void
 svga_render_null(svga_t *svga)
 {
@@ -136,7 +276,6 @@ void
 svga_render_text_40(svga_t *svga)
 {
     uint32_t *p;
-    int       xx;
     int       drawcursor;
     int       xinc;
     uint8_t   chr;
@@ -192,12 +331,8 @@ svga_render_text_40(svga_t *svga)
             }
 
             dat = svga->vram[charaddr + (svga->sc << 2)];
-            if (svga->seqregs[1] & 1) {
-                for (xx = 0; xx < 16; xx += 2)
-                    p[xx] = p[xx + 1] = (dat & (0x80 >> (xx >> 1))) ? fg : bg;
-            } else {
-                for (xx = 0; xx < 16; xx += 2)
-                    p[xx] = p[xx + 1] = (dat & (0x80 >> (xx >> 1))) ? fg : bg;
+            video_glyph_row_wide(p, dat, fg, bg);
+            if (!(svga->seqregs[1] & 1)) {
                 if ((chr & ~0x1f) != 0xc0 || !(svga->attrregs[0x10] & 4))
                     p[16] = p[17] = bg;
                 else
@@ -214,7 +349,6 @@ void
 svga_render_text_80(svga_t *svga)
 {
     uint32_t *p;
-    int       xx;
     int       drawcursor;
     int       xinc;
     uint8_t   chr;
@@ -269,12 +403,8 @@ svga_render_text_80(svga_t *svga)
             }
 
             dat = svga->vram[charaddr + (svga->sc << 2)];
-            if (svga->seqregs[1] & 1) {
-                for (xx = 0; xx < 8; xx++)
-                    p[xx] = (dat & (0x80 >> xx)) ? fg : bg;
-            } else {
-                for (xx = 0; xx < 8; xx++)
-                    p[xx] = (dat & (0x80 >> xx)) ? fg : bg;
+            video_glyph_row(p, dat, fg, bg);
+            if (!(svga->seqregs[1] & 1)) {
                 if ((chr & ~0x1F) != 0xC0 || !(svga->attrregs[0x10] & 4))
                     p[8] = bg;
                 else
@@ -425,7 +555,7 @@ svga_render_2bpp_headland_highres(svga_t *svga)
     uint32_t  addr;
     uint32_t *p;
     uint8_t   edat[4];
-    uint8_t   dat;
+    uint32_t  dat;
     uint32_t  changed_addr;
 
     if ((svga->displine + svga->y_add) < 0)
@@ -455,18 +585,9 @@ svga_render_2bpp_headland_highres(svga_t *svga)
             svga->ma += 4;
             svga->ma &= svga->vram_mask;
 
-            dat  = edatlookup[edat[0] >> 6][edat[1] >> 6] | (edatlookup[edat[2] >> 6][edat[3] >> 6] << 2);
-            p[0] = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-            p[1] = svga->pallook[svga->egapal[dat & svga->plane_mask]];
-            dat  = edatlookup[(edat[0] >> 4) & 3][(edat[1] >> 4) & 3] | (edatlookup[(edat[2] >> 4) & 3][(edat[3] >> 4) & 3] << 2);
-            p[2] = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-            p[3] = svga->pallook[svga->egapal[dat & svga->plane_mask]];
-            dat  = edatlookup[(edat[0] >> 2) & 3][(edat[1] >> 2) & 3] | (edatlookup[(edat[2] >> 2) & 3][(edat[3] >> 2) & 3] << 2);
-            p[4] = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-            p[5] = svga->pallook[svga->egapal[dat & svga->plane_mask]];
-            dat  = edatlookup[edat[0] & 3][edat[1] & 3] | (edatlookup[edat[2] & 3][edat[3] & 3] << 2);
-            p[6] = svga->pallook[svga->egapal[(dat >> 4) & svga->plane_mask]];
-            p[7] = svga->pallook[svga->egapal[dat & svga->plane_mask]];
+            dat = edatlookup8[edat[0]] | (edatlookup8[edat[1]] << 1) | (edatlookup8[edat[2]] << 2) | (edatlookup8[edat[3]] << 3);
+            for (int i = 0; i < 8; i++)
+                p[i] = svga->pallook[svga->egapal[(dat >> (28 - (i << 2))) & svga->plane_mask]];
 
             p += 8;
         }
@@ -1179,23 +1300,8 @@ svga_render_15bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-                }
+                x = svga_render_line_pixels(svga->hdisp + svga->scrollcache, 8);
+                svga_render_line_16bpp(svga, p, svga->ma, svga->vram_display_mask, x, 15);
                 svga->ma += x << 1;
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 2) {
@@ -1411,23 +1517,8 @@ svga_render_16bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-                }
+                x = svga_render_line_pixels(svga->hdisp + svga->scrollcache, 8);
+                svga_render_line_16bpp(svga, p, svga->ma, svga->vram_display_mask, x, 16);
                 svga->ma += x << 1;
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 2) {
@@ -1700,10 +1791,8 @@ svga_render_32bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 2)) & svga->vram_display_mask]);
-                    *p++ = lookup_lut(dat & 0xffffff);
-                }
+                x = svga_render_line_pixels(svga->hdisp + svga->scrollcache, 1);
+                svga_render_line_32bpp(svga, p, svga->ma, svga->vram_display_mask, x);
                 svga->ma += (x * 4);
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
@@ -1798,3 +1887,200 @@ svga_render_RGBA8888_highres(svga_t *svga)
         svga->ma &= svga->vram_display_mask;
     }
 }
+
+/*
+ * Render worker.
+ *
+ * The linear 15/16/32 bpp high resolution modes only depend on VRAM, the
+ * palette (LUT mapping) and the line start, so their scanlines can be
+ * converted on a separate thread while the CPU keeps running. The line is
+ * captured when the renderer would have run; the worker is drained before
+ * every blit, which keeps the same frame contents modulo VRAM written by
+ * the guest during the same frame.
+ */
+#define RENDER_JOBS      1024
+#define RENDER_JOBS_MASK (RENDER_JOBS - 1)
+
+typedef struct svga_render_job_t {
+    uint32_t *p;
+    uint32_t  ma;
+    uint32_t  mask;
+    int       count;
+    int       bpp;
+
+    /* Overscan is drawn after the line, as it is on the emulation thread,
+       so it overwrites the renderer's overshoot. */
+    uint32_t *left;
+    uint32_t *right;
+    int       left_count;
+    int       right_count;
+    uint32_t  overscan_color;
+} svga_render_job_t;
+
+typedef struct svga_render_queue_t {
+    svga_t   *svga;
+    thread_t *thread;
+    event_t  *wake_event;
+    event_t  *done_event;
+
+    atomic_int read_idx;
+    atomic_int write_idx;
+    atomic_int busy;
+    atomic_int run;
+
+    svga_render_job_t jobs[RENDER_JOBS];
+} svga_render_queue_t;
+
+static void
+svga_render_job(svga_t *svga, const svga_render_job_t *job)
+{
+    if (job->bpp == 32)
+        svga_render_line_32bpp(svga, job->p, job->ma, job->mask, svga_render_line_pixels(job->count, 1));
+    else
+        svga_render_line_16bpp(svga, job->p, job->ma, job->mask, svga_render_line_pixels(job->count, 8), job->bpp);
+
+    for (int i = 0; i < job->left_count; i++)
+        job->left[i] = job->overscan_color;
+    for (int i = 0; i < job->right_count; i++)
+        job->right[i] = job->overscan_color;
+}
+
+static void
+svga_render_thread_loop(void *param)
+{
+    svga_render_queue_t *queue = (svga_render_queue_t *) param;
+
+    while (queue->run) {
+        thread_wait_event(queue->wake_event, -1);
+        thread_reset_event(queue->wake_event);
+        queue->busy = 1;
+
+        while (queue->read_idx != queue->write_idx) {
+            svga_render_job(queue->svga, &queue->jobs[queue->read_idx & RENDER_JOBS_MASK]);
+            queue->read_idx++;
+            if (!(queue->read_idx & 63))
+                thread_set_event(queue->done_event);
+        }
+
+        queue->busy = 0;
+        thread_set_event(queue->done_event);
+    }
+}
+
+/* Block until the worker has caught up to within max_pending lines. */
+static void
+svga_render_thread_sync(svga_render_queue_t *queue, int max_pending)
+{
+    while ((queue->write_idx - queue->read_idx) > max_pending) {
+        thread_reset_event(queue->done_event);
+        thread_set_event(queue->wake_event);
+        if ((queue->write_idx - queue->read_idx) > max_pending)
+            thread_wait_event(queue->done_event, -1);
+    }
+}
+
+void
+svga_render_thread_wait(svga_t *svga)
+{
+    if (svga->render_thread != NULL)
+        svga_render_thread_sync((svga_render_queue_t *) svga->render_thread, 0);
+}
+
+/* Queue the current line instead of rendering it. Returns 0 if the line has
+   to be rendered on this thread. */
+int
+svga_render_thread_queue(svga_t *svga)
+{
+    svga_render_queue_t *queue = (svga_render_queue_t *) svga->render_thread;
+    svga_render_job_t   *job;
+    uint32_t            *line;
+    uint32_t             changed_addr;
+    int                  bpp;
+    int                  border;
+
+    if ((queue == NULL) || svga->force_old_addr || svga->remap_required ||
+        ((svga->displine + svga->y_add) < 0))
+        return 0;
+
+    if (svga->render == svga_render_32bpp_highres)
+        bpp = 32;
+    else if (svga->render == svga_render_16bpp_highres)
+        bpp = 16;
+    else if (svga->render == svga_render_15bpp_highres)
+        bpp = 15;
+    else
+        return 0;
+
+    /* Unchanged lines cost next to nothing, leave them to the renderer. */
+    changed_addr = svga->remap_func(svga, svga->ma);
+    if (!svga->changedvram[changed_addr >> 12] && !svga->changedvram[(changed_addr >> 12) + 1] && !svga->fullchange)
+        return 0;
+
+    if (svga->firstline_draw == 2000)
+        svga->firstline_draw = svga->displine;
+    svga->lastline_draw = svga->displine;
+
+    svga_render_thread_sync(queue, RENDER_JOBS - 1);
+
+    line   = svga->monitor->target_buffer->line[svga->displine + svga->y_add];
+    border = !svga->scrblank && (svga->hdisp > 0);
+
+    job                 = &queue->jobs[queue->write_idx & RENDER_JOBS_MASK];
+    job->p              = &line[svga->x_add];
+    job->ma             = svga->ma;
+    job->mask           = svga->vram_display_mask;
+    job->count          = svga->hdisp + svga->scrollcache;
+    job->bpp            = bpp;
+    job->left           = line;
+    job->left_count     = border ? (svga->monitor->mon_overscan_x >> 1) : 0;
+    job->right          = &line[(svga->monitor->mon_overscan_x >> 1) + svga->hdisp];
+    job->right_count    = border ? (overscan_x >> 1) : 0;
+    job->overscan_color = svga->overscan_color;
+    queue->write_idx++;
+
+    if (!queue->busy)
+        thread_set_event(queue->wake_event);
+
+    return 1;
+}
+
+void
+svga_render_thread_init(svga_t *svga)
+{
+    svga_render_queue_t *queue;
+
+    if (!video_render_thread || (thread_get_cpu_count() < 2))
+        return;
+
+    queue = (svga_render_queue_t *) calloc(1, sizeof(svga_render_queue_t));
+    if (queue == NULL)
+        return;
+
+    queue->svga       = svga;
+    queue->wake_event = thread_create_event();
+    queue->done_event = thread_create_event();
+    queue->run        = 1;
+    queue->thread     = thread_create(svga_render_thread_loop, queue);
+
+    svga->render_thread = queue;
+}
+
+void
+svga_render_thread_close(svga_t *svga)
+{
+    svga_render_queue_t *queue = (svga_render_queue_t *) svga->render_thread;
+
+    if (queue == NULL)
+        return;
+
+    svga_render_thread_sync(queue, 0);
+
+    queue->run = 0;
+    thread_set_event(queue->wake_event);
+    thread_wait(queue->thread);
+    thread_destroy_event(queue->wake_event);
+    thread_destroy_event(queue->done_event);
+
+    free(queue);
+    svga->render_thread = NULL;
+}
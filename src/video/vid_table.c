@@ -440,18 +440,20 @@ video_get_internal_name(int card)
     return device_get_internal_name(video_cards[card].device);
 }
 
+static const char *
+video_get_name(int c)
+{
+    return (video_cards[c].device != NULL) ? video_cards[c].device->internal_name : NULL;
+}
+
+static device_name_index_t video_names = { .get_name = video_get_name };
+
 int
 video_get_video_from_internal_name(char *s)
 {
-    int c = 0;
-
-    while (video_cards[c].device != NULL) {
-        if (!strcmp(video_cards[c].device->internal_name, s))
-            return c;
-        c++;
-    }
+    int c = device_name_index_find(&video_names, s);
 
-    return 0;
+    return (c >= 0) ? c : 0;
 }
 
 int
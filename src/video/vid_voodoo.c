@@ -907,10 +907,69 @@ voodoo_force_blit(void *priv)
     }
 }
 
+/* The texture format tables are the same for every card, and are only
+   worked out the first time one is set up. */
+static void
+voodoo_generate_texture_tables(void)
+{
+    static int generated = 0;
+    int        c;
+
+    if (generated)
+        return;
+    generated = 1;
+
+    for (c = 0; c < 0x100; c++) {
+        rgb332[c].r = c & 0xe0;
+        rgb332[c].g = (c << 3) & 0xe0;
+        rgb332[c].b = (c << 6) & 0xc0;
+        rgb332[c].r = rgb332[c].r | (rgb332[c].r >> 3) | (rgb332[c].r >> 6);
+        rgb332[c].g = rgb332[c].g | (rgb332[c].g >> 3) | (rgb332[c].g >> 6);
+        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 2);
+        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 4);
+        rgb332[c].a = 0xff;
+
+        ai44[c].a = (c & 0xf0) | ((c & 0xf0) >> 4);
+        ai44[c].r = (c & 0x0f) | ((c & 0x0f) << 4);
+        ai44[c].g = ai44[c].b = ai44[c].r;
+    }
+
+    for (c = 0; c < 0x10000; c++) {
+        rgb565[c].r = (c >> 8) & 0xf8;
+        rgb565[c].g = (c >> 3) & 0xfc;
+        rgb565[c].b = (c << 3) & 0xf8;
+        rgb565[c].r |= (rgb565[c].r >> 5);
+        rgb565[c].g |= (rgb565[c].g >> 6);
+        rgb565[c].b |= (rgb565[c].b >> 5);
+        rgb565[c].a = 0xff;
+
+        argb1555[c].r = (c >> 7) & 0xf8;
+        argb1555[c].g = (c >> 2) & 0xf8;
+        argb1555[c].b = (c << 3) & 0xf8;
+        argb1555[c].r |= (argb1555[c].r >> 5);
+        argb1555[c].g |= (argb1555[c].g >> 5);
+        argb1555[c].b |= (argb1555[c].b >> 5);
+        argb1555[c].a = (c & 0x8000) ? 0xff : 0;
+
+        argb4444[c].a = (c >> 8) & 0xf0;
+        argb4444[c].r = (c >> 4) & 0xf0;
+        argb4444[c].g = c & 0xf0;
+        argb4444[c].b = (c << 4) & 0xf0;
+        argb4444[c].a |= (argb4444[c].a >> 4);
+        argb4444[c].r |= (argb4444[c].r >> 4);
+        argb4444[c].g |= (argb4444[c].g >> 4);
+        argb4444[c].b |= (argb4444[c].b >> 4);
+
+        ai88[c].a = (c >> 8);
+        ai88[c].r = c & 0xff;
+        ai88[c].g = c & 0xff;
+        ai88[c].b = c & 0xff;
+    }
+}
+
 void *
 voodoo_card_init(void)
 {
-    int       c;
     voodoo_t *voodoo = malloc(sizeof(voodoo_t));
     memset(voodoo, 0, sizeof(voodoo_t));
 
@@ -921,8 +980,7 @@ voodoo_card_init(void)
     voodoo->texture_mask      = (voodoo->texture_size << 20) - 1;
     voodoo->fb_size           = device_get_config_int("framebuffer_memory");
     voodoo->fb_mask           = (voodoo->fb_size << 20) - 1;
-    voodoo->render_threads    = device_get_config_int("render_threads");
-    voodoo->odd_even_mask     = voodoo->render_threads - 1;
+    voodoo->render_threads    = voodoo_render_threads_from_config(device_get_config_int("render_threads"));
 #ifndef NO_CODEGEN
     voodoo->use_recompiler = device_get_config_int("recompiler");
 #endif
@@ -958,96 +1016,23 @@ voodoo_card_init(void)
     voodoo->tex_mem_w[0] = (uint16_t *) voodoo->tex_mem[0];
     voodoo->tex_mem_w[1] = (uint16_t *) voodoo->tex_mem[1];
 
-    for (c = 0; c < TEX_CACHE_MAX; c++) {
-        voodoo->texture_cache[0][c].data     = malloc((256 * 256 + 256 * 256 + 128 * 128 + 64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2) * 4);
-        voodoo->texture_cache[0][c].base     = -1; /*invalid*/
-        voodoo->texture_cache[0][c].refcount = 0;
-        if (voodoo->dual_tmus) {
-            voodoo->texture_cache[1][c].data     = malloc((256 * 256 + 256 * 256 + 128 * 128 + 64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2) * 4);
-            voodoo->texture_cache[1][c].base     = -1; /*invalid*/
-            voodoo->texture_cache[1][c].refcount = 0;
-        }
-    }
+    voodoo_texture_cache_init(voodoo);
 
     timer_add(&voodoo->timer, voodoo_callback, voodoo, 1);
 
     voodoo->svga     = svga_get_pri();
     voodoo->fbiInit0 = 0;
 
-    voodoo->wake_fifo_thread         = thread_create_event();
-    voodoo->wake_render_thread[0]    = thread_create_event();
-    voodoo->wake_render_thread[1]    = thread_create_event();
-    voodoo->wake_render_thread[2]    = thread_create_event();
-    voodoo->wake_render_thread[3]    = thread_create_event();
-    voodoo->wake_main_thread         = thread_create_event();
-    voodoo->fifo_not_full_event      = thread_create_event();
-    voodoo->render_not_full_event[0] = thread_create_event();
-    voodoo->render_not_full_event[1] = thread_create_event();
-    voodoo->render_not_full_event[2] = thread_create_event();
-    voodoo->render_not_full_event[3] = thread_create_event();
-    voodoo->fifo_thread_run          = 1;
-    voodoo->fifo_thread              = thread_create(voodoo_fifo_thread, voodoo);
-    voodoo->render_thread_run[0]     = 1;
-    voodoo->render_thread[0]         = thread_create(voodoo_render_thread_1, voodoo);
-    if (voodoo->render_threads >= 2) {
-        voodoo->render_thread_run[1] = 1;
-        voodoo->render_thread[1]     = thread_create(voodoo_render_thread_2, voodoo);
-    }
-    if (voodoo->render_threads == 4) {
-        voodoo->render_thread_run[2] = 1;
-        voodoo->render_thread[2]     = thread_create(voodoo_render_thread_3, voodoo);
-        voodoo->render_thread_run[3] = 1;
-        voodoo->render_thread[3]     = thread_create(voodoo_render_thread_4, voodoo);
-    }
+    voodoo->wake_fifo_thread    = thread_create_event();
+    voodoo->wake_main_thread    = thread_create_event();
+    voodoo->fifo_not_full_event = thread_create_event();
+    voodoo_render_threads_start(voodoo);
+    voodoo->fifo_thread_run = 1;
+    voodoo->fifo_thread     = thread_create(voodoo_fifo_thread, voodoo);
     voodoo->swap_mutex = thread_create_mutex();
     timer_add(&voodoo->wake_timer, voodoo_wake_timer, (void *) voodoo, 0);
 
-    for (c = 0; c < 0x100; c++) {
-        rgb332[c].r = c & 0xe0;
-        rgb332[c].g = (c << 3) & 0xe0;
-        rgb332[c].b = (c << 6) & 0xc0;
-        rgb332[c].r = rgb332[c].r | (rgb332[c].r >> 3) | (rgb332[c].r >> 6);
-        rgb332[c].g = rgb332[c].g | (rgb332[c].g >> 3) | (rgb332[c].g >> 6);
-        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 2);
-        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 4);
-        rgb332[c].a = 0xff;
-
-        ai44[c].a = (c & 0xf0) | ((c & 0xf0) >> 4);
-        ai44[c].r = (c & 0x0f) | ((c & 0x0f) << 4);
-        ai44[c].g = ai44[c].b = ai44[c].r;
-    }
-
-    for (c = 0; c < 0x10000; c++) {
-        rgb565[c].r = (c >> 8) & 0xf8;
-        rgb565[c].g = (c >> 3) & 0xfc;
-        rgb565[c].b = (c << 3) & 0xf8;
-        rgb565[c].r |= (rgb565[c].r >> 5);
-        rgb565[c].g |= (rgb565[c].g >> 6);
-        rgb565[c].b |= (rgb565[c].b >> 5);
-        rgb565[c].a = 0xff;
-
-        argb1555[c].r = (c >> 7) & 0xf8;
-        argb1555[c].g = (c >> 2) & 0xf8;
-        argb1555[c].b = (c << 3) & 0xf8;
-        argb1555[c].r |= (argb1555[c].r >> 5);
-        argb1555[c].g |= (argb1555[c].g >> 5);
-        argb1555[c].b |= (argb1555[c].b >> 5);
-        argb1555[c].a = (c & 0x8000) ? 0xff : 0;
-
-        argb4444[c].a = (c >> 8) & 0xf0;
-        argb4444[c].r = (c >> 4) & 0xf0;
-        argb4444[c].g = c & 0xf0;
-        argb4444[c].b = (c << 4) & 0xf0;
-        argb4444[c].a |= (argb4444[c].a >> 4);
-        argb4444[c].r |= (argb4444[c].r >> 4);
-        argb4444[c].g |= (argb4444[c].g >> 4);
-        argb4444[c].b |= (argb4444[c].b >> 4);
-
-        ai88[c].a = (c >> 8);
-        ai88[c].r = c & 0xff;
-        ai88[c].g = c & 0xff;
-        ai88[c].b = c & 0xff;
-    }
+    voodoo_generate_texture_tables();
 #ifndef NO_CODEGEN
     voodoo_codegen_init(voodoo);
 #endif
@@ -1065,15 +1050,13 @@ voodoo_card_init(void)
 void *
 voodoo_2d3d_card_init(int type)
 {
-    int       c;
     voodoo_t *voodoo = malloc(sizeof(voodoo_t));
     memset(voodoo, 0, sizeof(voodoo_t));
 
     voodoo->bilinear_enabled  = device_get_config_int("bilinear");
     voodoo->dithersub_enabled = device_get_config_int("dithersub");
     voodoo->scrfilter         = device_get_config_int("dacfilter");
-    voodoo->render_threads    = device_get_config_int("render_threads");
-    voodoo->odd_even_mask     = voodoo->render_threads - 1;
+    voodoo->render_threads    = voodoo_render_threads_from_config(device_get_config_int("render_threads"));
 #ifndef NO_CODEGEN
     voodoo->use_recompiler = device_get_config_int("recompiler");
 #endif
@@ -1083,95 +1066,22 @@ voodoo_2d3d_card_init(int type)
     /*generate filter lookup tables*/
     voodoo_generate_filter_v2(voodoo);
 
-    for (c = 0; c < TEX_CACHE_MAX; c++) {
-        voodoo->texture_cache[0][c].data     = malloc((256 * 256 + 256 * 256 + 128 * 128 + 64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2) * 4);
-        voodoo->texture_cache[0][c].base     = -1; /*invalid*/
-        voodoo->texture_cache[0][c].refcount = 0;
-        if (voodoo->dual_tmus) {
-            voodoo->texture_cache[1][c].data     = malloc((256 * 256 + 256 * 256 + 128 * 128 + 64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2) * 4);
-            voodoo->texture_cache[1][c].base     = -1; /*invalid*/
-            voodoo->texture_cache[1][c].refcount = 0;
-        }
-    }
+    voodoo_texture_cache_init(voodoo);
 
     timer_add(&voodoo->timer, voodoo_callback, voodoo, 1);
 
     voodoo->fbiInit0 = 0;
 
-    voodoo->wake_fifo_thread         = thread_create_event();
-    voodoo->wake_render_thread[0]    = thread_create_event();
-    voodoo->wake_render_thread[1]    = thread_create_event();
-    voodoo->wake_render_thread[2]    = thread_create_event();
-    voodoo->wake_render_thread[3]    = thread_create_event();
-    voodoo->wake_main_thread         = thread_create_event();
-    voodoo->fifo_not_full_event      = thread_create_event();
-    voodoo->render_not_full_event[0] = thread_create_event();
-    voodoo->render_not_full_event[1] = thread_create_event();
-    voodoo->render_not_full_event[2] = thread_create_event();
-    voodoo->render_not_full_event[3] = thread_create_event();
-    voodoo->fifo_thread_run          = 1;
-    voodoo->fifo_thread              = thread_create(voodoo_fifo_thread, voodoo);
-    voodoo->render_thread_run[0]     = 1;
-    voodoo->render_thread[0]         = thread_create(voodoo_render_thread_1, voodoo);
-    if (voodoo->render_threads >= 2) {
-        voodoo->render_thread_run[1] = 1;
-        voodoo->render_thread[1]     = thread_create(voodoo_render_thread_2, voodoo);
-    }
-    if (voodoo->render_threads == 4) {
-        voodoo->render_thread_run[2] = 1;
-        voodoo->render_thread[2]     = thread_create(voodoo_render_thread_3, voodoo);
-        voodoo->render_thread_run[3] = 1;
-        voodoo->render_thread[3]     = thread_create(voodoo_render_thread_4, voodoo);
-    }
+    voodoo->wake_fifo_thread    = thread_create_event();
+    voodoo->wake_main_thread    = thread_create_event();
+    voodoo->fifo_not_full_event = thread_create_event();
+    voodoo_render_threads_start(voodoo);
+    voodoo->fifo_thread_run = 1;
+    voodoo->fifo_thread     = thread_create(voodoo_fifo_thread, voodoo);
     voodoo->swap_mutex = thread_create_mutex();
     timer_add(&voodoo->wake_timer, voodoo_wake_timer, (void *) voodoo, 0);
 
-    for (c = 0; c < 0x100; c++) {
-        rgb332[c].r = c & 0xe0;
-        rgb332[c].g = (c << 3) & 0xe0;
-        rgb332[c].b = (c << 6) & 0xc0;
-        rgb332[c].r = rgb332[c].r | (rgb332[c].r >> 3) | (rgb332[c].r >> 6);
-        rgb332[c].g = rgb332[c].g | (rgb332[c].g >> 3) | (rgb332[c].g >> 6);
-        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 2);
-        rgb332[c].b = rgb332[c].b | (rgb332[c].b >> 4);
-        rgb332[c].a = 0xff;
-
-        ai44[c].a = (c & 0xf0) | ((c & 0xf0) >> 4);
-        ai44[c].r = (c & 0x0f) | ((c & 0x0f) << 4);
-        ai44[c].g = ai44[c].b = ai44[c].r;
-    }
-
-    for (c = 0; c < 0x10000; c++) {
-        rgb565[c].r = (c >> 8) & 0xf8;
-        rgb565[c].g = (c >> 3) & 0xfc;
-        rgb565[c].b = (c << 3) & 0xf8;
-        rgb565[c].r |= (rgb565[c].r >> 5);
-        rgb565[c].g |= (rgb565[c].g >> 6);
-        rgb565[c].b |= (rgb565[c].b >> 5);
-        rgb565[c].a = 0xff;
-
-        argb1555[c].r = (c >> 7) & 0xf8;
-        argb1555[c].g = (c >> 2) & 0xf8;
-        argb1555[c].b = (c << 3) & 0xf8;
-        argb1555[c].r |= (argb1555[c].r >> 5);
-        argb1555[c].g |= (argb1555[c].g >> 5);
-        argb1555[c].b |= (argb1555[c].b >> 5);
-        argb1555[c].a = (c & 0x8000) ? 0xff : 0;
-
-        argb4444[c].a = (c >> 8) & 0xf0;
-        argb4444[c].r = (c >> 4) & 0xf0;
-        argb4444[c].g = c & 0xf0;
-        argb4444[c].b = (c << 4) & 0xf0;
-        argb4444[c].a |= (argb4444[c].a >> 4);
-        argb4444[c].r |= (argb4444[c].r >> 4);
-        argb4444[c].g |= (argb4444[c].g >> 4);
-        argb4444[c].b |= (argb4444[c].b >> 4);
-
-        ai88[c].a = (c >> 8);
-        ai88[c].r = c & 0xff;
-        ai88[c].g = c & 0xff;
-        ai88[c].b = c & 0xff;
-    }
+    voodoo_generate_texture_tables();
 #ifndef NO_CODEGEN
     voodoo_codegen_init(voodoo);
 #endif
@@ -1249,35 +1159,13 @@ voodoo_card_close(voodoo_t *voodoo)
     voodoo->fifo_thread_run = 0;
     thread_set_event(voodoo->wake_fifo_thread);
     thread_wait(voodoo->fifo_thread);
-    voodoo->render_thread_run[0] = 0;
-    thread_set_event(voodoo->wake_render_thread[0]);
-    thread_wait(voodoo->render_thread[0]);
-    if (voodoo->render_threads >= 2) {
-        voodoo->render_thread_run[1] = 0;
-        thread_set_event(voodoo->wake_render_thread[1]);
-        thread_wait(voodoo->render_thread[1]);
-    }
-    if (voodoo->render_threads == 4) {
-        voodoo->render_thread_run[2] = 0;
-        thread_set_event(voodoo->wake_render_thread[2]);
-        thread_wait(voodoo->render_thread[2]);
-        voodoo->render_thread_run[3] = 0;
-        thread_set_event(voodoo->wake_render_thread[3]);
-        thread_wait(voodoo->render_thread[3]);
-    }
+    voodoo_render_threads_stop(voodoo);
     thread_destroy_event(voodoo->fifo_not_full_event);
     thread_destroy_event(voodoo->wake_main_thread);
     thread_destroy_event(voodoo->wake_fifo_thread);
-    thread_destroy_event(voodoo->wake_render_thread[0]);
-    thread_destroy_event(voodoo->wake_render_thread[1]);
-    thread_destroy_event(voodoo->render_not_full_event[0]);
-    thread_destroy_event(voodoo->render_not_full_event[1]);
 
-    for (uint8_t c = 0; c < TEX_CACHE_MAX; c++) {
-        if (voodoo->dual_tmus)
-            free(voodoo->texture_cache[1][c].data);
-        free(voodoo->texture_cache[0][c].data);
-    }
+    voodoo_fifo_log_stats(voodoo);
+    voodoo_texture_cache_close(voodoo);
 #ifndef NO_CODEGEN
     voodoo_codegen_close(voodoo);
 #endif
@@ -1391,6 +1279,10 @@ static const device_config_t voodoo_config[] = {
         .description = "Render threads",
         .type = CONFIG_SELECTION,
         .selection = {
+            {
+                .description = "Auto",
+                .value = 0
+            },
             {
                 .description = "1",
                 .value = 1
@@ -1399,15 +1291,35 @@ static const device_config_t voodoo_config[] = {
                 .description = "2",
                 .value = 2
             },
+            {
+                .description = "3",
+                .value = 3
+            },
             {
                 .description = "4",
                 .value = 4
             },
+            {
+                .description = "6",
+                .value = 6
+            },
+            {
+                .description = "8",
+                .value = 8
+            },
+            {
+                .description = "12",
+                .value = 12
+            },
+            {
+                .description = "16",
+                .value = 16
+            },
             {
                 .description = ""
             }
         },
-        .default_int = 2
+        .default_int = 0
     },
     {
         .name = "sli",
@@ -371,7 +371,7 @@ banshee_out(uint16_t addr, uint8_t val, void *priv)
                         svga->ma_latch   = ((svga->crtc[0xc] << 8) | svga->crtc[0xd]) + ((svga->crtc[8] & 0x60) >> 5);
                     } else {
                         svga->fullchange = changeframecount;
-                        svga_recalctimings(svga);
+                        svga_recalctimings_crtc(svga);
                     }
                 }
             }
@@ -1084,9 +1084,12 @@ banshee_status(banshee_t *banshee)
     int           fifo_entries = FIFO_ENTRIES;
     int           swap_count   = voodoo->swap_count;
     int           written      = voodoo->cmd_written + voodoo->cmd_written_fifo;
-    int           busy         = (written - voodoo->cmd_read) || (voodoo->cmdfifo_depth_rd != voodoo->cmdfifo_depth_wr) || voodoo->render_voodoo_busy[0] || voodoo->render_voodoo_busy[1] || voodoo->render_voodoo_busy[2] || voodoo->render_voodoo_busy[3] || voodoo->voodoo_busy;
+    int           busy         = (written - voodoo->cmd_read) || (voodoo->cmdfifo_depth_rd != voodoo->cmdfifo_depth_wr) || voodoo->voodoo_busy;
     uint32_t      ret          = 0;
 
+    for (int c = 0; c < voodoo->render_threads; c++)
+        busy |= voodoo->render_voodoo_busy[c];
+
     if (fifo_entries < 0x20)
         ret |= 0x1f - fifo_entries;
     else
@@ -3072,6 +3075,10 @@ static const device_config_t banshee_sgram_config[] = {
         .description = "Render threads",
         .type = CONFIG_SELECTION,
         .selection = {
+            {
+                .description = "Auto",
+                .value = 0
+            },
             {
                 .description = "1",
                 .value = 1
@@ -3080,15 +3087,35 @@ static const device_config_t banshee_sgram_config[] = {
                 .description = "2",
                 .value = 2
             },
+            {
+                .description = "3",
+                .value = 3
+            },
             {
                 .description = "4",
                 .value = 4
             },
+            {
+                .description = "6",
+                .value = 6
+            },
+            {
+                .description = "8",
+                .value = 8
+            },
+            {
+                .description = "12",
+                .value = 12
+            },
+            {
+                .description = "16",
+                .value = 16
+            },
             {
                 .description = ""
             }
         },
-        .default_int = 2
+        .default_int = 0
     },
 #ifndef NO_CODEGEN
     {
@@ -3127,6 +3154,10 @@ static const device_config_t banshee_sgram_16mbonly_config[] = {
         .description = "Render threads",
         .type = CONFIG_SELECTION,
         .selection = {
+            {
+                .description = "Auto",
+                .value = 0
+            },
             {
                 .description = "1",
                 .value = 1
@@ -3135,15 +3166,35 @@ static const device_config_t banshee_sgram_16mbonly_config[] = {
                 .description = "2",
                 .value = 2
             },
+            {
+                .description = "3",
+                .value = 3
+            },
             {
                 .description = "4",
                 .value = 4
             },
+            {
+                .description = "6",
+                .value = 6
+            },
+            {
+                .description = "8",
+                .value = 8
+            },
+            {
+                .description = "12",
+                .value = 12
+            },
+            {
+                .description = "16",
+                .value = 16
+            },
             {
                 .description = ""
             }
         },
-        .default_int = 2
+        .default_int = 0
     },
 #ifndef NO_CODEGEN
     {
@@ -3182,6 +3233,10 @@ static const device_config_t banshee_sdram_config[] = {
         .description = "Render threads",
         .type = CONFIG_SELECTION,
         .selection = {
+            {
+                .description = "Auto",
+                .value = 0
+            },
             {
                 .description = "1",
                 .value = 1
@@ -3190,15 +3245,35 @@ static const device_config_t banshee_sdram_config[] = {
                 .description = "2",
                 .value = 2
             },
+            {
+                .description = "3",
+                .value = 3
+            },
             {
                 .description = "4",
                 .value = 4
             },
+            {
+                .description = "6",
+                .value = 6
+            },
+            {
+                .description = "8",
+                .value = 8
+            },
+            {
+                .description = "12",
+                .value = 12
+            },
+            {
+                .description = "16",
+                .value = 16
+            },
             {
                 .description = ""
             }
         },
-        .default_int = 2
+        .default_int = 0
     },
 #ifndef NO_CODEGEN
     {
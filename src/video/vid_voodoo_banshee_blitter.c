@@ -326,6 +326,308 @@ PLOT_LINE(voodoo_t *voodoo, int x, int y, UNUSED(uint8_t rop), uint32_t pattern,
     }
 }
 
+/*The fast paths below cover spans where every pixel gets the same treatment:
+  ROPs 0x00, 0xcc, 0xf0 and 0xff to a linear destination, with no colour
+  keying and no mono pattern transparency. They write exactly what the
+  generic per-pixel path would. The span functions return 0 if the generic
+  path has to be used instead*/
+static int
+banshee_fast_rop(voodoo_t *voodoo)
+{
+    if (voodoo->banshee_blt.commandExtra & (CMDEXTRA_SRC_COLORKEY | CMDEXTRA_DST_COLORKEY))
+        return -1;
+    if ((voodoo->banshee_blt.command & (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO)) == (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO))
+        return -1;
+    if (voodoo->banshee_blt.dstBaseAddr_tiled)
+        return -1;
+
+    switch (voodoo->banshee_blt.rops[0]) {
+        case 0x00:
+        case 0xcc:
+        case 0xf0:
+        case 0xff:
+            return voodoo->banshee_blt.rops[0];
+
+        default:
+            return -1;
+    }
+}
+
+static int
+banshee_dst_bytes(voodoo_t *voodoo)
+{
+    switch (voodoo->banshee_blt.dstFormat & DST_FORMAT_COL_MASK) {
+        case DST_FORMAT_COL_8_BPP:
+            return 1;
+        case DST_FORMAT_COL_16_BPP:
+            return 2;
+        case DST_FORMAT_COL_24_BPP:
+            return 3;
+        case DST_FORMAT_COL_32_BPP:
+            return 4;
+
+        default:
+            return 0;
+    }
+}
+
+/*Pattern colour of row pat_y, if it is the same for every pixel*/
+static int
+banshee_solid_pattern(voodoo_t *voodoo, int pat_y, uint32_t *col)
+{
+    const uint32_t *pattern;
+
+    if (voodoo->banshee_blt.command & COMMAND_PATTERN_MONO) {
+        uint8_t pattern_mask = ((uint8_t *) voodoo->banshee_blt.colorPattern)[pat_y & 7];
+
+        if (pattern_mask == 0xff)
+            *col = voodoo->banshee_blt.colorFore;
+        else if (pattern_mask == 0x00)
+            *col = voodoo->banshee_blt.colorBack;
+        else
+            return 0;
+        return 1;
+    }
+
+    switch (voodoo->banshee_blt.dstFormat & DST_FORMAT_COL_MASK) {
+        case DST_FORMAT_COL_8_BPP:
+            pattern = &voodoo->banshee_blt.colorPattern8[(pat_y & 7) * 8];
+            break;
+        case DST_FORMAT_COL_16_BPP:
+            pattern = &voodoo->banshee_blt.colorPattern16[(pat_y & 7) * 8];
+            break;
+        case DST_FORMAT_COL_24_BPP:
+            pattern = &voodoo->banshee_blt.colorPattern24[(pat_y & 7) * 8];
+            break;
+        default:
+            pattern = &voodoo->banshee_blt.colorPattern[(pat_y & 7) * 8];
+            break;
+    }
+    for (uint8_t c = 1; c < 8; c++) {
+        if (pattern[c] != pattern[0])
+            return 0;
+    }
+
+    *col = pattern[0];
+    return 1;
+}
+
+/*Indices [*start, *end) of the pixels of a span drawn from x in steps of dir
+  that fall inside the clip rectangle*/
+static void
+banshee_clip_span(voodoo_t *voodoo, const clip_t *clip, int x, int dir, int *start, int *end)
+{
+    if (dir > 0) {
+        *start = MAX(0, clip->x_min - x);
+        *end   = MIN(voodoo->banshee_blt.dstSizeX, clip->x_max - x);
+    } else {
+        *start = MAX(0, x - clip->x_max + 1);
+        *end   = MIN(voodoo->banshee_blt.dstSizeX, x - clip->x_min + 1);
+    }
+}
+
+/*Address of the leftmost visible pixel, or -1 if the span wraps around the
+  end of the framebuffer*/
+static int64_t
+banshee_fast_addr(voodoo_t *voodoo, int left, int count, int bytes, int dst_y)
+{
+    uint32_t addr;
+
+    if (left < 0)
+        return -1;
+
+    addr = get_addr(voodoo, left * bytes, dst_y, 0, 0);
+    if (((uint64_t) addr + (count * bytes)) > ((uint64_t) voodoo->fb_mask + 1))
+        return -1;
+
+    return addr;
+}
+
+static void
+banshee_fast_changed(voodoo_t *voodoo, uint32_t addr, int len)
+{
+    for (uint32_t page = addr >> 12; page <= ((addr + len - 1) >> 12); page++)
+        voodoo->changedvram[page] = changeframecount;
+}
+
+/*ROPs 0x00, 0xf0 and 0xff, and 0xcc with a constant source*/
+static int
+banshee_fast_fill_span(voodoo_t *voodoo, const clip_t *clip, int rop, uint32_t src, int dst_x, int dir, int dst_y, int pat_y)
+{
+    int      bytes = banshee_dst_bytes(voodoo);
+    int      start;
+    int      end;
+    int64_t  addr;
+    uint8_t *p;
+    uint32_t col;
+
+    switch (rop) {
+        case 0x00:
+            col = 0;
+            break;
+        case 0xcc:
+            col = src;
+            break;
+        case 0xf0:
+            if (!banshee_solid_pattern(voodoo, pat_y, &col))
+                return 0;
+            break;
+        default:
+            col = 0xffffffff;
+            break;
+    }
+
+    banshee_clip_span(voodoo, clip, dst_x, dir, &start, &end);
+    if (start >= end)
+        return 1;
+
+    addr = banshee_fast_addr(voodoo, (dir > 0) ? (dst_x + start) : (dst_x - end + 1), end - start, bytes, dst_y);
+    if (!bytes || (addr < 0))
+        return 0;
+
+    p = &voodoo->vram[addr];
+    switch (bytes) {
+        case 1:
+            memset(p, col, end - start);
+            break;
+        case 2:
+            for (int c = start; c < end; c++, p += 2)
+                *(uint16_t *) p = col;
+            break;
+        case 3:
+            for (int c = start; c < end; c++, p += 3) {
+                p[0] = col;
+                p[1] = col >> 8;
+                p[2] = col >> 16;
+            }
+            break;
+        default:
+            for (int c = start; c < end; c++, p += 4)
+                *(uint32_t *) p = col;
+            break;
+    }
+
+    banshee_fast_changed(voodoo, addr, (end - start) * bytes);
+    return 1;
+}
+
+/*ROP 0xcc between identical formats. The generic path copies pixel by
+  pixel in the blit direction, so memmove() is only equivalent when that
+  order never reads a pixel it has already written*/
+static int
+banshee_fast_copy_span(voodoo_t *voodoo, const clip_t *clip, const uint8_t *src_p, int src_x, int dst_x, int dir, int dst_y)
+{
+    int            bytes = banshee_dst_bytes(voodoo);
+    int            start;
+    int            end;
+    int            src_left;
+    int            len;
+    int64_t        addr;
+    const uint8_t *src;
+    uint8_t       *dst;
+
+    banshee_clip_span(voodoo, clip, dst_x, dir, &start, &end);
+    if (start >= end)
+        return 1;
+
+    src_left = (dir > 0) ? (src_x + start) : (src_x - end + 1);
+    addr     = banshee_fast_addr(voodoo, (dir > 0) ? (dst_x + start) : (dst_x - end + 1), end - start, bytes, dst_y);
+    if (!bytes || (src_left < 0) || (addr < 0))
+        return 0;
+
+    len = (end - start) * bytes;
+    src = &src_p[src_left * bytes];
+    dst = &voodoo->vram[addr];
+    if ((dir > 0) ? ((dst > src) && (dst < (src + len))) : ((dst < src) && ((dst + len) > src)))
+        return 0;
+
+    memmove(dst, src, len);
+    banshee_fast_changed(voodoo, addr, len);
+    return 1;
+}
+
+/*ROP 0xcc from 16, 24 or 32 bpp to 16 or 32 bpp, with the same conversion
+  as the generic path, pixel by pixel in the same order*/
+static int
+banshee_fast_convert_span(voodoo_t *voodoo, const clip_t *clip, const uint8_t *src_p, int src_x, int dst_x, int dir, int dst_y)
+{
+    int      src_format = voodoo->banshee_blt.srcFormat & SRC_FORMAT_COL_MASK;
+    int      bytes      = banshee_dst_bytes(voodoo);
+    int      start;
+    int      end;
+    int      left;
+    int64_t  addr;
+
+    if (((src_format != SRC_FORMAT_COL_16_BPP) && (src_format != SRC_FORMAT_COL_24_BPP) && (src_format != SRC_FORMAT_COL_32_BPP)) ||
+        ((bytes != 2) && (bytes != 4)))
+        return 0;
+
+    banshee_clip_span(voodoo, clip, dst_x, dir, &start, &end);
+    if (start >= end)
+        return 1;
+
+    left = (dir > 0) ? (dst_x + start) : (dst_x - end + 1);
+    addr = banshee_fast_addr(voodoo, left, end - start, bytes, dst_y);
+    if ((((dir > 0) ? (src_x + start) : (src_x - end + 1)) < 0) || (addr < 0))
+        return 0;
+
+    src_x += dir * start;
+    dst_x += dir * start;
+    for (int c = start; c < end; c++) {
+        const uint8_t *src = &src_p[(src_x * voodoo->banshee_blt.src_bpp) >> 3];
+        uint8_t       *dst = &voodoo->vram[addr + ((dst_x - left) * bytes)];
+        uint32_t       src_data;
+
+        if (src_format == SRC_FORMAT_COL_16_BPP) {
+            uint16_t src_16 = *(const uint16_t *) src;
+            int      r      = (src_16 >> 11);
+            int      g      = (src_16 >> 5) & 0x3f;
+            int      b      = src_16 & 0x1f;
+
+            r        = (r << 3) | (r >> 2);
+            g        = (g << 2) | (g >> 4);
+            b        = (b << 3) | (b >> 2);
+            src_data = (r << 16) | (g << 8) | b;
+        } else
+            src_data = *(const uint32_t *) src;
+
+        if (bytes == 2) {
+            int r = src_data >> 16;
+            int g = (src_data >> 8) & 0xff;
+            int b = src_data & 0xff;
+
+            *(uint16_t *) dst = (b >> 3) | ((g >> 2) << 5) | ((r >> 3) << 11);
+        } else
+            *(uint32_t *) dst = src_data;
+
+        src_x += dir;
+        dst_x += dir;
+    }
+
+    banshee_fast_changed(voodoo, addr, (end - start) * bytes);
+    return 1;
+}
+
+/*One line of a screen to screen or host to screen blit*/
+static int
+banshee_fast_line(voodoo_t *voodoo, const clip_t *clip, const uint8_t *src_p, int use_x_dir, int src_x, int src_tiled, int pat_y)
+{
+    int rop        = banshee_fast_rop(voodoo);
+    int src_format = voodoo->banshee_blt.srcFormat & SRC_FORMAT_COL_MASK;
+    int dir        = (use_x_dir && (voodoo->banshee_blt.command & COMMAND_DX)) ? -1 : 1;
+
+    /*Mono sources can be transparent and YUYV writes pixel pairs*/
+    if ((rop < 0) || src_tiled || (src_format == SRC_FORMAT_COL_1_BPP) || (src_format == SRC_FORMAT_COL_YUYV))
+        return 0;
+
+    if (rop != 0xcc)
+        return banshee_fast_fill_span(voodoo, clip, rop, 0, voodoo->banshee_blt.dstX, dir, voodoo->banshee_blt.dstY, pat_y);
+    if (src_format == (voodoo->banshee_blt.dstFormat & DST_FORMAT_COL_MASK))
+        return banshee_fast_copy_span(voodoo, clip, src_p, src_x, voodoo->banshee_blt.dstX, dir, voodoo->banshee_blt.dstY);
+
+    return banshee_fast_convert_span(voodoo, clip, src_p, src_x, voodoo->banshee_blt.dstX, dir, voodoo->banshee_blt.dstY);
+}
+
 static void
 update_src_stride(voodoo_t *voodoo)
 {
@@ -424,6 +726,7 @@ banshee_do_rectfill(voodoo_t *voodoo)
     int            pat_y             = (voodoo->banshee_blt.commandExtra & CMDEXTRA_FORCE_PAT_ROW0) ? 0 : (voodoo->banshee_blt.patoff_y + voodoo->banshee_blt.dstY);
     int            use_pattern_trans = (voodoo->banshee_blt.command & (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO)) == (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO);
     uint8_t        rop               = voodoo->banshee_blt.command >> 24;
+    int            fast_rop          = banshee_fast_rop(voodoo);
 
 #if 0
     bansheeblt_log("banshee_do_rectfill: size=%i,%i  dst=%i,%i\n", voodoo->banshee_blt.dstSizeX, voodoo->banshee_blt.dstSizeY, voodoo->banshee_blt.dstX, voodoo->banshee_blt.dstY);
@@ -437,14 +740,18 @@ banshee_do_rectfill(voodoo_t *voodoo)
             int     pat_x        = voodoo->banshee_blt.patoff_x + voodoo->banshee_blt.dstX;
             uint8_t pattern_mask = pattern_mono[pat_y & 7];
 
-            for (voodoo->banshee_blt.cur_x = 0; voodoo->banshee_blt.cur_x < voodoo->banshee_blt.dstSizeX; voodoo->banshee_blt.cur_x++) {
-                int pattern_trans = use_pattern_trans ? (pattern_mask & (1 << (7 - (pat_x & 7)))) : 1;
+            if ((fast_rop >= 0) && banshee_fast_fill_span(voodoo, clip, fast_rop, voodoo->banshee_blt.colorFore, dst_x, (voodoo->banshee_blt.command & COMMAND_DX) ? -1 : 1, dst_y, pat_y))
+                voodoo->banshee_blt.cur_x = voodoo->banshee_blt.dstSizeX;
+            else {
+                for (voodoo->banshee_blt.cur_x = 0; voodoo->banshee_blt.cur_x < voodoo->banshee_blt.dstSizeX; voodoo->banshee_blt.cur_x++) {
+                    int pattern_trans = use_pattern_trans ? (pattern_mask & (1 << (7 - (pat_x & 7)))) : 1;
 
-                if (dst_x >= clip->x_min && dst_x < clip->x_max && pattern_trans)
-                    PLOT(voodoo, dst_x, dst_y, pat_x, pat_y, pattern_mask, rop, voodoo->banshee_blt.colorFore, COLORKEY_32);
+                    if (dst_x >= clip->x_min && dst_x < clip->x_max && pattern_trans)
+                        PLOT(voodoo, dst_x, dst_y, pat_x, pat_y, pattern_mask, rop, voodoo->banshee_blt.colorFore, COLORKEY_32);
 
-                dst_x += (voodoo->banshee_blt.command & COMMAND_DX) ? -1 : 1;
-                pat_x += (voodoo->banshee_blt.command & COMMAND_DX) ? -1 : 1;
+                    dst_x += (voodoo->banshee_blt.command & COMMAND_DX) ? -1 : 1;
+                    pat_x += (voodoo->banshee_blt.command & COMMAND_DX) ? -1 : 1;
+                }
             }
         }
         dst_y += (voodoo->banshee_blt.command & COMMAND_DY) ? -1 : 1;
@@ -574,6 +881,12 @@ do_screen_to_screen_line(voodoo_t *voodoo, uint8_t *src_p, int use_x_dir, int sr
 #if 0
     bansheeblt_log("do_screen_to_screen_line: srcFormat=%08x dst=%08x\n", voodoo->banshee_blt.srcFormat, voodoo->banshee_blt.dstFormat);
 #endif
+    if (dst_y >= clip->y_min && dst_y < clip->y_max && banshee_fast_line(voodoo, clip, src_p, use_x_dir, src_x, src_tiled, pat_y)) {
+        voodoo->banshee_blt.cur_x = voodoo->banshee_blt.dstSizeX;
+        voodoo->banshee_blt.srcY += (voodoo->banshee_blt.command & COMMAND_DY) ? -1 : 1;
+        voodoo->banshee_blt.dstY += (voodoo->banshee_blt.command & COMMAND_DY) ? -1 : 1;
+        return;
+    }
     if ((voodoo->banshee_blt.srcFormat & SRC_FORMAT_COL_MASK) == (voodoo->banshee_blt.dstFormat & DST_FORMAT_COL_MASK)) {
         /*No conversion required*/
         if (dst_y >= clip->y_min && dst_y < clip->y_max) {
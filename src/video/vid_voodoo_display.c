@@ -40,6 +40,15 @@
 #include <86box/vid_voodoo_regs.h>
 #include <86box/vid_voodoo_render.h>
 
+/*Vector versions of the scan-out filter*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    define VOODOO_DISP_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define VOODOO_DISP_NEON
+#endif
+
 #ifdef ENABLE_VOODOODISP_LOG
 int voodoodisp_do_log = ENABLE_VOODOODISP_LOG;
 
@@ -174,6 +183,11 @@ voodoo_generate_filter_v1(voodoo_t *voodoo)
     fcg = FILTCAPG * 6;
     fcb = FILTCAPB * 5;
 
+    voodoo->filter_v2     = 0;
+    voodoo->filter_cap[0] = FILTCAPB;
+    voodoo->filter_cap[1] = FILTCAPG;
+    voodoo->filter_cap[2] = FILTCAP;
+
     for (uint16_t g = 0; g < FILTDIV; g++) // pixel 1
     {
         for (uint16_t h = 0; h < FILTDIV; h++) // pixel 2
@@ -271,6 +285,11 @@ voodoo_generate_filter_v2(voodoo_t *voodoo)
     if (fcb > 32)
         fcb = 32;
 
+    voodoo->filter_v2     = 1;
+    voodoo->filter_cap[0] = FILTCAPB;
+    voodoo->filter_cap[1] = FILTCAPG;
+    voodoo->filter_cap[2] = FILTCAP;
+
     for (uint16_t g = 0; g < 256; g++) // pixel 1 - our target pixel we want to bleed into
     {
         for (uint16_t h = 0; h < 256; h++) // pixel 2 - our main pixel
@@ -386,124 +405,199 @@ voodoo_threshold_check(voodoo_t *voodoo)
     }
 }
 
+/* Planar, one row per channel in blue, green, red order, with room for the
+   pixel past the end of the line the Voodoo 2 filter reads. */
+#define FILTER_LINE (4096 + 8)
+
+static const uint8_t (*voodoo_filter_table(const voodoo_t *voodoo, int chan))[256]
+{
+    if (chan == 0)
+        return voodoo->thefilterb;
+    if (chan == 1)
+        return voodoo->thefilterg;
+    return voodoo->thefilter;
+}
+
 static void
-voodoo_filterline_v1(voodoo_t *voodoo, uint8_t *fil, int column, uint16_t *src, int line)
+voodoo_filter_expand(uint8_t fil[3][FILTER_LINE], const uint16_t *src, int n)
 {
-    // Scratchpad for avoiding feedback streaks
-    uint8_t fil3[4096 * 3];
+    int x = 0;
+
+#if defined(VOODOO_DISP_SSE2)
+    for (; x <= (n - 8); x += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *) &src[x]);
+        __m128i b = _mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(31)), 3);
+        __m128i g = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(v, 5), _mm_set1_epi16(63)), 2);
+        __m128i r = _mm_slli_epi16(_mm_srli_epi16(v, 11), 3);
+
+        _mm_storel_epi64((__m128i *) &fil[0][x], _mm_packus_epi16(b, b));
+        _mm_storel_epi64((__m128i *) &fil[1][x], _mm_packus_epi16(g, g));
+        _mm_storel_epi64((__m128i *) &fil[2][x], _mm_packus_epi16(r, r));
+    }
+#elif defined(VOODOO_DISP_NEON)
+    for (; x <= (n - 8); x += 8) {
+        uint16x8_t v = vld1q_u16(&src[x]);
 
-    assert(voodoo->h_disp <= 4096);
-    /* 16 to 32-bit */
-    for (int x = 0; x < column; x++) {
-        fil[x * 3]     = ((src[x] & 31) << 3);
-        fil[x * 3 + 1] = (((src[x] >> 5) & 63) << 2);
-        fil[x * 3 + 2] = (((src[x] >> 11) & 31) << 3);
-
-        // Copy to our scratchpads
-        fil3[x * 3 + 0] = fil[x * 3 + 0];
-        fil3[x * 3 + 1] = fil[x * 3 + 1];
-        fil3[x * 3 + 2] = fil[x * 3 + 2];
+        vst1_u8(&fil[0][x], vmovn_u16(vshlq_n_u16(vandq_u16(v, vdupq_n_u16(31)), 3)));
+        vst1_u8(&fil[1][x], vmovn_u16(vshlq_n_u16(vandq_u16(vshrq_n_u16(v, 5), vdupq_n_u16(63)), 2)));
+        vst1_u8(&fil[2][x], vmovn_u16(vshlq_n_u16(vshrq_n_u16(v, 11), 3)));
     }
+#endif
+    for (; x < n; x++) {
+        fil[0][x] = ((src[x] & 31) << 3);
+        fil[1][x] = (((src[x] >> 5) & 63) << 2);
+        fil[2][x] = (((src[x] >> 11) & 31) << 3);
+    }
+}
 
-    /* lines */
+#if defined(VOODOO_DISP_NEON)
+static inline uint16x8_t
+voodoo_filter_div5_neon(uint16x8_t v)
+{
+    const uint16x4_t fifth = vdup_n_u16(13108);
 
-    if (line & 1) {
-        for (int x = 0; x < column; x++) {
-            fil[x * 3]     = voodoo->purpleline[fil[x * 3]][0];
-            fil[x * 3 + 1] = voodoo->purpleline[fil[x * 3 + 1]][1];
-            fil[x * 3 + 2] = voodoo->purpleline[fil[x * 3 + 2]][2];
+    return vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(v), fifth), 16),
+                        vshrn_n_u32(vmull_u16(vget_high_u16(v), fifth), 16));
+}
+#endif
+
+/*One filter step over n pixels of one channel, out[x] = table[in[x]][nbr[x]].
+  The vector paths work the table entries out from the thresholds they were
+  generated with, and give the same values; the tail is looked up*/
+static void
+voodoo_filter_pass(const voodoo_t *voodoo, int chan, uint8_t *out, const uint8_t *in, const uint8_t *nbr, int n)
+{
+    const uint8_t (*tab)[256] = voodoo_filter_table(voodoo, chan);
+    int x                     = 0;
+
+#if defined(VOODOO_DISP_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i cap  = _mm_set1_epi16(voodoo->filter_cap[chan]);
+
+    if (voodoo->filter_v2) {
+        /*Lighten by the difference of the 4:1 and 1:4 averages, up to the
+          threshold and at most 32, where the right pixel is brighter but not
+          by more than the threshold. x * 13108 >> 16 is x / 5 over 0-1275*/
+        const __m128i lim   = _mm_set1_epi16((voodoo->filter_cap[chan] > 32) ? 32 : voodoo->filter_cap[chan]);
+        const __m128i fifth = _mm_set1_epi16(13108);
+
+        for (; x <= (n - 8); x += 8) {
+            __m128i g       = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) &in[x]), zero);
+            __m128i h       = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) &nbr[x]), zero);
+            __m128i avg_g   = _mm_mulhi_epu16(_mm_add_epi16(_mm_slli_epi16(g, 2), h), fifth);
+            __m128i avg_h   = _mm_mulhi_epu16(_mm_add_epi16(_mm_slli_epi16(h, 2), g), fifth);
+            __m128i avgdiff = _mm_min_epi16(_mm_sub_epi16(avg_h, avg_g), lim);
+            __m128i mask    = _mm_andnot_si128(_mm_cmpgt_epi16(_mm_sub_epi16(h, g), cap), _mm_cmpgt_epi16(h, g));
+
+            g = _mm_add_epi16(g, _mm_and_si128(avgdiff, mask));
+            _mm_storel_epi64((__m128i *) &out[x], _mm_packus_epi16(g, zero));
         }
-    }
+    } else {
+        /*Move halfway towards the neighbour, by at most half the threshold*/
+        const __m128i ncap = _mm_set1_epi16(-voodoo->filter_cap[chan]);
 
-    /* filtering time */
+        for (; x <= (n - 8); x += 8) {
+            __m128i g = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) &in[x]), zero);
+            __m128i h = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) &nbr[x]), zero);
+            __m128i d = _mm_max_epi16(_mm_min_epi16(_mm_sub_epi16(h, g), cap), ncap);
 
-    for (int x = 1; x < column; x++) {
-        fil3[x * 3]     = voodoo->thefilterb[fil[x * 3]][fil[(x - 1) * 3]];
-        fil3[x * 3 + 1] = voodoo->thefilterg[fil[x * 3 + 1]][fil[(x - 1) * 3 + 1]];
-        fil3[x * 3 + 2] = voodoo->thefilter[fil[x * 3 + 2]][fil[(x - 1) * 3 + 2]];
-    }
-
-    for (int x = 1; x < column; x++) {
-        fil[x * 3]     = voodoo->thefilterb[fil3[x * 3]][fil3[(x - 1) * 3]];
-        fil[x * 3 + 1] = voodoo->thefilterg[fil3[x * 3 + 1]][fil3[(x - 1) * 3 + 1]];
-        fil[x * 3 + 2] = voodoo->thefilter[fil3[x * 3 + 2]][fil3[(x - 1) * 3 + 2]];
+            g = _mm_add_epi16(g, _mm_srai_epi16(d, 1));
+            _mm_storel_epi64((__m128i *) &out[x], _mm_packus_epi16(g, zero));
+        }
     }
+#elif defined(VOODOO_DISP_NEON)
+    const int16x8_t cap = vdupq_n_s16(voodoo->filter_cap[chan]);
+
+    if (voodoo->filter_v2) {
+        const int16x8_t lim = vdupq_n_s16((voodoo->filter_cap[chan] > 32) ? 32 : voodoo->filter_cap[chan]);
+
+        for (; x <= (n - 8); x += 8) {
+            uint16x8_t g       = vmovl_u8(vld1_u8(&in[x]));
+            uint16x8_t h       = vmovl_u8(vld1_u8(&nbr[x]));
+            uint16x8_t avg_g   = voodoo_filter_div5_neon(vaddq_u16(vshlq_n_u16(g, 2), h));
+            uint16x8_t avg_h   = voodoo_filter_div5_neon(vaddq_u16(vshlq_n_u16(h, 2), g));
+            int16x8_t  avgdiff = vminq_s16(vreinterpretq_s16_u16(vsubq_u16(avg_h, avg_g)), lim);
+            uint16x8_t mask    = vbicq_u16(vcgtq_u16(h, g),
+                                           vcgtq_s16(vreinterpretq_s16_u16(vsubq_u16(h, g)), cap));
+
+            g = vaddq_u16(g, vandq_u16(vreinterpretq_u16_s16(avgdiff), mask));
+            vst1_u8(&out[x], vqmovn_u16(g));
+        }
+    } else {
+        const int16x8_t ncap = vnegq_s16(cap);
 
-    for (int x = 1; x < column; x++) {
-        fil3[x * 3]     = voodoo->thefilterb[fil[x * 3]][fil[(x - 1) * 3]];
-        fil3[x * 3 + 1] = voodoo->thefilterg[fil[x * 3 + 1]][fil[(x - 1) * 3 + 1]];
-        fil3[x * 3 + 2] = voodoo->thefilter[fil[x * 3 + 2]][fil[(x - 1) * 3 + 2]];
-    }
+        for (; x <= (n - 8); x += 8) {
+            int16x8_t g = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(&in[x])));
+            int16x8_t h = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(&nbr[x])));
+            int16x8_t d = vmaxq_s16(vminq_s16(vsubq_s16(h, g), cap), ncap);
 
-    for (int x = 0; x < column - 1; x++) {
-        fil[x * 3]     = voodoo->thefilterb[fil3[x * 3]][fil3[(x + 1) * 3]];
-        fil[x * 3 + 1] = voodoo->thefilterg[fil3[x * 3 + 1]][fil3[(x + 1) * 3 + 1]];
-        fil[x * 3 + 2] = voodoo->thefilter[fil3[x * 3 + 2]][fil3[(x + 1) * 3 + 2]];
+            vst1_u8(&out[x], vqmovun_s16(vaddq_s16(g, vshrq_n_s16(d, 1))));
+        }
     }
+#endif
+    for (; x < n; x++)
+        out[x] = tab[in[x]][nbr[x]];
 }
 
 static void
-voodoo_filterline_v2(voodoo_t *voodoo, uint8_t *fil, int column, uint16_t *src, UNUSED(int line))
+voodoo_filterline_v1(voodoo_t *voodoo, uint8_t fil[3][FILTER_LINE], int column, uint16_t *src, int line)
 {
-    int x;
-
-    // Scratchpad for blending filter
-    uint8_t fil3[4096 * 3];
+    // Scratchpad for avoiding feedback streaks
+    uint8_t fil3[3][FILTER_LINE];
 
     assert(voodoo->h_disp <= 4096);
     /* 16 to 32-bit */
-    for (x = 0; x < column; x++) {
-        // Blank scratchpads
-        fil3[x * 3 + 0] = fil[x * 3 + 0] = ((src[x] & 31) << 3);
-        fil3[x * 3 + 1] = fil[x * 3 + 1] = (((src[x] >> 5) & 63) << 2);
-        fil3[x * 3 + 2] = fil[x * 3 + 2] = (((src[x] >> 11) & 31) << 3);
+    voodoo_filter_expand(fil3, src, column);
+
+    for (int c = 0; c < 3; c++) {
+        /* lines */
+        if (line & 1) {
+            for (int x = 0; x < column; x++)
+                fil[c][x] = voodoo->purpleline[fil3[c][x]][c];
+        } else
+            memcpy(fil[c], fil3[c], column);
+
+        /* filtering time */
+        voodoo_filter_pass(voodoo, c, &fil3[c][1], &fil[c][1], &fil[c][0], column - 1);
+        voodoo_filter_pass(voodoo, c, &fil[c][1], &fil3[c][1], &fil3[c][0], column - 1);
+        voodoo_filter_pass(voodoo, c, &fil3[c][1], &fil[c][1], &fil[c][0], column - 1);
+        voodoo_filter_pass(voodoo, c, &fil[c][0], &fil3[c][0], &fil3[c][1], column - 1);
     }
+}
 
-    /* filtering time */
-
-    for (x = 1; x < column - 3; x++) {
-        fil3[(x + 3) * 3]     = voodoo->thefilterb[(src[x + 3] & 31) << 3][(src[x] & 31) << 3];
-        fil3[(x + 3) * 3 + 1] = voodoo->thefilterg[((src[x + 3] >> 5) & 63) << 2][((src[x] >> 5) & 63) << 2];
-        fil3[(x + 3) * 3 + 2] = voodoo->thefilter[((src[x + 3] >> 11) & 31) << 3][((src[x] >> 11) & 31) << 3];
-
-        fil[(x + 2) * 3]     = voodoo->thefilterb[fil3[(x + 2) * 3]][(src[x] & 31) << 3];
-        fil[(x + 2) * 3 + 1] = voodoo->thefilterg[fil3[(x + 2) * 3 + 1]][((src[x] >> 5) & 63) << 2];
-        fil[(x + 2) * 3 + 2] = voodoo->thefilter[fil3[(x + 2) * 3 + 2]][((src[x] >> 11) & 31) << 3];
-
-        fil3[(x + 1) * 3]     = voodoo->thefilterb[fil[(x + 1) * 3]][(src[x] & 31) << 3];
-        fil3[(x + 1) * 3 + 1] = voodoo->thefilterg[fil[(x + 1) * 3 + 1]][((src[x] >> 5) & 63) << 2];
-        fil3[(x + 1) * 3 + 2] = voodoo->thefilter[fil[(x + 1) * 3 + 2]][((src[x] >> 11) & 31) << 3];
+static void
+voodoo_filterline_v2(voodoo_t *voodoo, uint8_t fil[3][FILTER_LINE], int column, uint16_t *src, UNUSED(int line))
+{
+    // Unfiltered pixels and scratchpad for blending filter
+    uint8_t pix[3][FILTER_LINE];
+    uint8_t fil3[3][FILTER_LINE];
 
-        fil[(x - 1) * 3]     = voodoo->thefilterb[fil3[(x - 1) * 3]][(src[x] & 31) << 3];
-        fil[(x - 1) * 3 + 1] = voodoo->thefilterg[fil3[(x - 1) * 3 + 1]][((src[x] >> 5) & 63) << 2];
-        fil[(x - 1) * 3 + 2] = voodoo->thefilter[fil3[(x - 1) * 3 + 2]][((src[x] >> 11) & 31) << 3];
+    assert(voodoo->h_disp <= 4096);
+    /* 16 to 32-bit, and the pixel past the end */
+    voodoo_filter_expand(pix, src, column + 1);
+
+    /*The blend was one loop where pixel x feeds pixels x + 3, x + 2, x + 1
+      and x - 1 in turn; no step reads what a later one writes, so it runs as
+      four passes over the line*/
+    for (int c = 0; c < 3; c++) {
+        const uint8_t (*tab)[256] = voodoo_filter_table(voodoo, c);
+        const uint8_t edge        = pix[c][column];
+
+        memcpy(fil[c], pix[c], column);
+        memcpy(fil3[c], pix[c], column);
+
+        /* filtering time */
+        voodoo_filter_pass(voodoo, c, &fil3[c][4], &pix[c][4], &pix[c][1], column - 4);
+        voodoo_filter_pass(voodoo, c, &fil[c][3], &fil3[c][3], &pix[c][1], column - 4);
+        voodoo_filter_pass(voodoo, c, &fil3[c][2], &fil[c][2], &pix[c][1], column - 4);
+        voodoo_filter_pass(voodoo, c, &fil[c][0], &fil3[c][0], &pix[c][1], column - 4);
+
+        // unroll for edge cases
+        for (int x = column - 3; x < column; x++)
+            fil3[c][x] = tab[pix[c][x]][edge];
+        fil[c][column - 2] = tab[fil3[c][column - 2]][edge];
+        fil[c][column - 1] = tab[fil3[c][column - 1]][edge];
     }
-
-    // unroll for edge cases
-
-    fil3[(column - 3) * 3]     = voodoo->thefilterb[(src[column - 3] & 31) << 3][(src[column] & 31) << 3];
-    fil3[(column - 3) * 3 + 1] = voodoo->thefilterg[((src[column - 3] >> 5) & 63) << 2][((src[column] >> 5) & 63) << 2];
-    fil3[(column - 3) * 3 + 2] = voodoo->thefilter[((src[column - 3] >> 11) & 31) << 3][((src[column] >> 11) & 31) << 3];
-
-    fil3[(column - 2) * 3]     = voodoo->thefilterb[(src[column - 2] & 31) << 3][(src[column] & 31) << 3];
-    fil3[(column - 2) * 3 + 1] = voodoo->thefilterg[((src[column - 2] >> 5) & 63) << 2][((src[column] >> 5) & 63) << 2];
-    fil3[(column - 2) * 3 + 2] = voodoo->thefilter[((src[column - 2] >> 11) & 31) << 3][((src[column] >> 11) & 31) << 3];
-
-    fil3[(column - 1) * 3]     = voodoo->thefilterb[(src[column - 1] & 31) << 3][(src[column] & 31) << 3];
-    fil3[(column - 1) * 3 + 1] = voodoo->thefilterg[((src[column - 1] >> 5) & 63) << 2][((src[column] >> 5) & 63) << 2];
-    fil3[(column - 1) * 3 + 2] = voodoo->thefilter[((src[column - 1] >> 11) & 31) << 3][((src[column] >> 11) & 31) << 3];
-
-    fil[(column - 2) * 3]     = voodoo->thefilterb[fil3[(column - 2) * 3]][(src[column] & 31) << 3];
-    fil[(column - 2) * 3 + 1] = voodoo->thefilterg[fil3[(column - 2) * 3 + 1]][((src[column] >> 5) & 63) << 2];
-    fil[(column - 2) * 3 + 2] = voodoo->thefilter[fil3[(column - 2) * 3 + 2]][((src[column] >> 11) & 31) << 3];
-
-    fil[(column - 1) * 3]     = voodoo->thefilterb[fil3[(column - 1) * 3]][(src[column] & 31) << 3];
-    fil[(column - 1) * 3 + 1] = voodoo->thefilterg[fil3[(column - 1) * 3 + 1]][((src[column] >> 5) & 63) << 2];
-    fil[(column - 1) * 3 + 2] = voodoo->thefilter[fil3[(column - 1) * 3 + 2]][((src[column] >> 11) & 31) << 3];
-
-    fil3[(column - 1) * 3]     = voodoo->thefilterb[fil[(column - 1) * 3]][(src[column] & 31) << 3];
-    fil3[(column - 1) * 3 + 1] = voodoo->thefilterg[fil[(column - 1) * 3 + 1]][((src[column] >> 5) & 63) << 2];
-    fil3[(column - 1) * 3 + 2] = voodoo->thefilter[fil[(column - 1) * 3 + 2]][((src[column] >> 11) & 31) << 3];
 }
 
 void
@@ -554,7 +648,7 @@ voodoo_callback(void *priv)
                     monitor->target_buffer->line[voodoo->line + v_y_add][x] = 0x00000000;
 
                 if (voodoo->scrfilter && voodoo->scrfilterEnabled) {
-                    uint8_t fil[4096 * 3]; /* interleaved 24-bit RGB */
+                    uint8_t fil[3][FILTER_LINE]; /* planar 24-bit RGB */
 
                     assert(voodoo->h_disp <= 4096);
                     if (voodoo->type == VOODOO_2)
@@ -563,7 +657,7 @@ voodoo_callback(void *priv)
                         voodoo_filterline_v1(voodoo, fil, voodoo->h_disp, src, voodoo->line);
 
                     for (x = 0; x < voodoo->h_disp; x++) {
-                        p[x] = (voodoo->clutData256[fil[x * 3]].b << 0 | voodoo->clutData256[fil[x * 3 + 1]].g << 8 | voodoo->clutData256[fil[x * 3 + 2]].r << 16);
+                        p[x] = (voodoo->clutData256[fil[0][x]].b << 0 | voodoo->clutData256[fil[1][x]].g << 8 | voodoo->clutData256[fil[2][x]].r << 16);
                     }
                 } else {
                     for (x = 0; x < voodoo->h_disp; x++) {
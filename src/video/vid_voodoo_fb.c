@@ -469,3 +469,54 @@ skip_pixel:
         }
     }
 }
+
+/*count consecutive dwords from addr on. Raw RGB565 pixel pairs need no
+  conversion, so these are stored as they are, a row at a time; anything
+  else goes through voodoo_fb_writel() one dword at a time*/
+void
+voodoo_fb_writel_run(voodoo_t *voodoo, uint32_t addr, const uint32_t *val, int count)
+{
+    const voodoo_params_t *params    = &voodoo->params;
+    int                    row_shift = (voodoo->type >= VOODOO_BANSHEE) ? 12 : 11;
+    int                    x_mask    = (voodoo->type >= VOODOO_BANSHEE) ? 0xffe : 0x7fe;
+    int                    c         = 0;
+
+    if (((voodoo->lfbMode & (0x100 | LFB_FORMAT_MASK)) != LFB_FORMAT_RGB565) || dither) {
+        for (c = 0; c < count; c++)
+            voodoo_fb_writel(addr + (c << 2), val[c], voodoo);
+        return;
+    }
+
+    while (c < count) {
+        int x = addr & x_mask;
+        int y = (addr >> row_shift) & 0x3ff;
+        int n = ((x_mask + 2) - x) >> 2;
+
+        if (n > (count - c))
+            n = count - c;
+
+        if (SLI_ENABLED) {
+            if ((!(voodoo->initEnable & INITENABLE_SLI_MASTER_SLAVE) && (y & 1)) || ((voodoo->initEnable & INITENABLE_SLI_MASTER_SLAVE) && !(y & 1))) {
+                addr += (n << 2);
+                c += n;
+                continue;
+            }
+            y >>= 1;
+        }
+
+        if (voodoo->fb_write_offset == voodoo->params.front_offset && y < 2048)
+            voodoo->dirty_line[y] = 1;
+
+        for (; n > 0; n--, c++, x += 4, addr += 4) {
+            uint32_t write_addr;
+
+            if (voodoo->col_tiled)
+                write_addr = voodoo->fb_write_offset + (x & 127) + (x >> 7) * 128 * 32 + (y & 31) * 128 + (y >> 5) * voodoo->row_width;
+            else
+                write_addr = voodoo->fb_write_offset + x + (y * voodoo->row_width);
+
+            *(uint16_t *) (&voodoo->fb_mem[write_addr & voodoo->fb_mask])       = val[c] & 0xffff;
+            *(uint16_t *) (&voodoo->fb_mem[(write_addr + 2) & voodoo->fb_mask]) = val[c] >> 16;
+        }
+    }
+}
@@ -17,6 +17,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stddef.h>
@@ -42,6 +43,7 @@
 #include <86box/vid_voodoo_regs.h>
 #include <86box/vid_voodoo_render.h>
 #include <86box/vid_voodoo_texture.h>
+#include <86box/trace.h>
 
 #ifdef ENABLE_VOODOO_FIFO_LOG
 int voodoo_fifo_do_log = ENABLE_VOODOO_FIFO_LOG;
@@ -62,6 +64,16 @@ voodoo_fifo_log(const char *fmt, ...)
 #endif
 
 #define WAKE_DELAY (TIMER_USEC * 100)
+
+#define FB_RUN_MAX 64 /*LFB writes handed over at once*/
+
+/*Only called from the FIFO thread, which owns fifo_read_idx*/
+static inline void
+voodoo_fifo_advance(voodoo_t *voodoo)
+{
+    atomic_store_explicit(&voodoo->fifo_read_idx, atomic_load_explicit(&voodoo->fifo_read_idx, memory_order_relaxed) + 1, memory_order_release);
+}
+
 void
 voodoo_wake_fifo_thread(voodoo_t *voodoo)
 {
@@ -88,28 +100,49 @@ voodoo_wake_timer(void *priv)
     thread_set_event(voodoo->wake_fifo_thread); /*Wake up FIFO thread if moving from idle*/
 }
 
+/*Only called from the CPU thread. The FIFO thread's read index is only
+  looked at when the last copy of it says the ring is filling up, so queueing
+  a command normally touches nothing the FIFO thread writes to*/
 void
 voodoo_queue_command(voodoo_t *voodoo, uint32_t addr_type, uint32_t val)
 {
-    fifo_entry_t *fifo = &voodoo->fifo[voodoo->fifo_write_idx & FIFO_MASK];
+    int           write_idx = atomic_load_explicit(&voodoo->fifo_write_idx, memory_order_relaxed);
+    fifo_entry_t *fifo      = &voodoo->fifo[write_idx & FIFO_MASK];
+
+    if ((write_idx - voodoo->fifo_read_idx_cached) >= (FIFO_SIZE - 4)) {
+        voodoo->fifo_read_idx_cached = atomic_load_explicit(&voodoo->fifo_read_idx, memory_order_acquire);
 
-    while (FIFO_FULL) {
-        thread_reset_event(voodoo->fifo_not_full_event);
         if (FIFO_FULL) {
-            thread_wait_event(voodoo->fifo_not_full_event, 1); /*Wait for room in ringbuffer*/
-            if (FIFO_FULL)
-                voodoo_wake_fifo_thread_now(voodoo);
+            uint64_t start_time = plat_timer_read();
+
+            voodoo->fifo_stalls++;
+            voodoo->fifo_waiting = 1;
+            while (FIFO_FULL) {
+                thread_reset_event(voodoo->fifo_not_full_event);
+                if (FIFO_FULL) {
+                    thread_wait_event(voodoo->fifo_not_full_event, 1); /*Wait for room in ringbuffer*/
+                    if (FIFO_FULL)
+                        voodoo_wake_fifo_thread_now(voodoo);
+                }
+            }
+            voodoo->fifo_waiting = 0;
+            voodoo->fifo_stall_time += plat_timer_read() - start_time;
+
+            voodoo->fifo_read_idx_cached = atomic_load_explicit(&voodoo->fifo_read_idx, memory_order_acquire);
         }
     }
 
     fifo->val       = val;
     fifo->addr_type = addr_type;
 
-    voodoo->fifo_write_idx++;
+    atomic_store_explicit(&voodoo->fifo_write_idx, write_idx + 1, memory_order_release);
     voodoo->cmd_status &= ~(1 << 24);
 
-    if (FIFO_ENTRIES > 0xe000)
-        voodoo_wake_fifo_thread(voodoo);
+    if ((write_idx + 1 - voodoo->fifo_read_idx_cached) > 0xe000) {
+        voodoo->fifo_read_idx_cached = atomic_load_explicit(&voodoo->fifo_read_idx, memory_order_acquire);
+        if ((write_idx + 1 - voodoo->fifo_read_idx_cached) > 0xe000)
+            voodoo_wake_fifo_thread(voodoo);
+    }
 }
 
 void
@@ -124,6 +157,14 @@ voodoo_flush(voodoo_t *voodoo)
     voodoo->flush = 0;
 }
 
+/*Stall time is in plat_timer_read() ticks*/
+void
+voodoo_fifo_log_stats(voodoo_t *voodoo)
+{
+    voodoo_fifo_log("FIFO: %" PRIu64 " wakes, peak depth %i, %" PRIu64 " stalls for %" PRIu64 " ticks\n",
+                    voodoo->fifo_wakes, voodoo->fifo_max_depth, voodoo->fifo_stalls, voodoo->fifo_stall_time);
+}
+
 void
 voodoo_wake_fifo_threads(voodoo_set_t *set, voodoo_t *voodoo)
 {
@@ -176,18 +217,83 @@ cmdfifo_get(voodoo_t *voodoo)
     return val;
 }
 
+/*Waits for the next dword, then returns how many of the following max
+  dwords can be taken in one go: already written by the host and contiguous
+  in frame buffer memory. Subroutines are not counted in the FIFO depth*/
+static int
+cmdfifo_get_run(voodoo_t *voodoo, int max)
+{
+    int contig = ((voodoo->fb_mask + 1) - (voodoo->cmdfifo_rp & voodoo->fb_mask)) >> 2;
+    int avail;
+
+    if (!voodoo->cmdfifo_in_sub) {
+        while (voodoo->fifo_thread_run && (voodoo->cmdfifo_depth_rd == voodoo->cmdfifo_depth_wr)) {
+            thread_wait_event(voodoo->wake_fifo_thread, -1);
+            thread_reset_event(voodoo->wake_fifo_thread);
+        }
+
+        avail = voodoo->cmdfifo_depth_wr - voodoo->cmdfifo_depth_rd;
+        if (avail <= 0)
+            avail = 1; /*shutting down, or the depth was rewritten; same as cmdfifo_get()*/
+        if (avail < max)
+            max = avail;
+    }
+
+    return (contig < max) ? contig : max;
+}
+
+static inline const uint32_t *
+cmdfifo_run_ptr(voodoo_t *voodoo)
+{
+    return (const uint32_t *) &voodoo->fb_mem[voodoo->cmdfifo_rp & voodoo->fb_mask];
+}
+
+static inline void
+cmdfifo_consume(voodoo_t *voodoo, int num)
+{
+    if (!voodoo->cmdfifo_in_sub)
+        voodoo->cmdfifo_depth_rd += num;
+    voodoo->cmdfifo_rp += num << 2;
+}
+
+/*Copies up to max dwords out of the FIFO before releasing their space to the
+  host, returns how many*/
+static int
+cmdfifo_get_block(voodoo_t *voodoo, uint32_t *dst, int max)
+{
+    int num = cmdfifo_get_run(voodoo, max);
+
+    memcpy(dst, cmdfifo_run_ptr(voodoo), num << 2);
+    cmdfifo_consume(voodoo, num);
+
+    return num;
+}
+
+static void
+cmdfifo_get_all(voodoo_t *voodoo, uint32_t *dst, int num)
+{
+    while (num > 0) {
+        int got = cmdfifo_get_block(voodoo, dst, num);
+
+        dst += got;
+        num -= got;
+    }
+}
+
 static inline float
-cmdfifo_get_f(voodoo_t *voodoo)
+cmdfifo_word_f(uint32_t val)
 {
     union {
         uint32_t i;
         float    f;
     } tempif;
 
-    tempif.i = cmdfifo_get(voodoo);
+    tempif.i = val;
     return tempif.f;
 }
 
+#define CMDFIFO_BLOCK 256
+
 enum {
     CMDFIFO3_PC_MASK_RGB   = (1 << 10),
     CMDFIFO3_PC_MASK_ALPHA = (1 << 11),
@@ -211,6 +317,10 @@ voodoo_fifo_thread(void *param)
         thread_wait_event(voodoo->wake_fifo_thread, -1);
         thread_reset_event(voodoo->wake_fifo_thread);
         voodoo->voodoo_busy = 1;
+        voodoo->fifo_wakes++;
+        TRACE_BEGIN(voodoo, "fifo");
+        if (FIFO_ENTRIES > voodoo->fifo_max_depth)
+            voodoo->fifo_max_depth = FIFO_ENTRIES;
         while (!FIFO_EMPTY) {
             uint64_t      start_time = plat_timer_read();
             uint64_t      end_time;
@@ -221,7 +331,7 @@ voodoo_fifo_thread(void *param)
                     while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEL_REG) {
                         voodoo_reg_writel(fifo->addr_type & FIFO_ADDR, fifo->val, voodoo);
                         fifo->addr_type = FIFO_INVALID;
-                        voodoo->fifo_read_idx++;
+                        voodoo_fifo_advance(voodoo);
                         if (FIFO_EMPTY)
                             break;
                         fifo = &voodoo->fifo[voodoo->fifo_read_idx & FIFO_MASK];
@@ -232,7 +342,7 @@ voodoo_fifo_thread(void *param)
                     while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEW_FB) {
                         voodoo_fb_writew(fifo->addr_type & FIFO_ADDR, fifo->val, voodoo);
                         fifo->addr_type = FIFO_INVALID;
-                        voodoo->fifo_read_idx++;
+                        voodoo_fifo_advance(voodoo);
                         if (FIFO_EMPTY)
                             break;
                         fifo = &voodoo->fifo[voodoo->fifo_read_idx & FIFO_MASK];
@@ -241,9 +351,26 @@ voodoo_fifo_thread(void *param)
                 case FIFO_WRITEL_FB:
                     voodoo_wait_for_render_thread_idle(voodoo);
                     while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEL_FB) {
-                        voodoo_fb_writel(fifo->addr_type & FIFO_ADDR, fifo->val, voodoo);
-                        fifo->addr_type = FIFO_INVALID;
-                        voodoo->fifo_read_idx++;
+                        /*Software rendered frames arrive as long runs of consecutive
+                          writes, hand those over a run at a time. Entries are only
+                          released once written, so a flush still waits for them*/
+                        uint32_t run[FB_RUN_MAX];
+                        uint32_t addr    = fifo->addr_type & FIFO_ADDR;
+                        int      entries = FIFO_ENTRIES;
+                        int      n       = 0;
+
+                        do {
+                            run[n++] = fifo->val;
+                            if ((n == FB_RUN_MAX) || (n == entries))
+                                break;
+                            fifo = &voodoo->fifo[(voodoo->fifo_read_idx + n) & FIFO_MASK];
+                        } while (fifo->addr_type == (FIFO_WRITEL_FB | ((addr + (n << 2)) & FIFO_ADDR)));
+
+                        voodoo_fb_writel_run(voodoo, addr, run, n);
+                        while (n--) {
+                            voodoo->fifo[voodoo->fifo_read_idx & FIFO_MASK].addr_type = FIFO_INVALID;
+                            voodoo_fifo_advance(voodoo);
+                        }
                         if (FIFO_EMPTY)
                             break;
                         fifo = &voodoo->fifo[voodoo->fifo_read_idx & FIFO_MASK];
@@ -254,7 +381,7 @@ voodoo_fifo_thread(void *param)
                         if (!(fifo->addr_type & 0x400000))
                             voodoo_tex_writel(fifo->addr_type & FIFO_ADDR, fifo->val, voodoo);
                         fifo->addr_type = FIFO_INVALID;
-                        voodoo->fifo_read_idx++;
+                        voodoo_fifo_advance(voodoo);
                         if (FIFO_EMPTY)
                             break;
                         fifo = &voodoo->fifo[voodoo->fifo_read_idx & FIFO_MASK];
@@ -264,7 +391,7 @@ voodoo_fifo_thread(void *param)
                     while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEL_2DREG) {
                         voodoo_2d_reg_writel(voodoo, fifo->addr_type & FIFO_ADDR, fifo->val);
                         fifo->addr_type = FIFO_INVALID;
-                        voodoo->fifo_read_idx++;
+                        voodoo_fifo_advance(voodoo);
                         if (FIFO_EMPTY)
                             break;
                         fifo = &voodoo->fifo[voodoo->fifo_read_idx & FIFO_MASK];
@@ -275,7 +402,8 @@ voodoo_fifo_thread(void *param)
                     fatal("Unknown fifo entry %08x\n", fifo->addr_type);
             }
 
-            if (FIFO_ENTRIES > 0xe000)
+            /*Only signal a CPU thread that is actually blocked on a full FIFO*/
+            if (voodoo->fifo_waiting && (FIFO_ENTRIES < 0xe000))
                 thread_set_event(voodoo->fifo_not_full_event);
 
             end_time = plat_timer_read();
@@ -294,6 +422,8 @@ voodoo_fifo_thread(void *param)
             int      num;
             int      num_verticies;
             int      v_num;
+            int      vert_words;
+            uint32_t block[CMDFIFO_BLOCK];
 
 #if 0
             voodoo_fifo_log(" CMDFIFO header %08x at %08x\n", header, voodoo->cmdfifo_rp);
@@ -345,29 +475,34 @@ voodoo_fifo_thread(void *param)
 #if 0
                     voodoo_fifo_log("CMDFIFO1 addr=%08x\n",addr);
 #endif
-                    while (num--) {
-                        uint32_t val = cmdfifo_get(voodoo);
-                        if ((addr & (1 << 13)) && voodoo->type >= VOODOO_BANSHEE) {
+                    while (num) {
+                        int got = cmdfifo_get_block(voodoo, block, (num > CMDFIFO_BLOCK) ? CMDFIFO_BLOCK : num);
+
+                        num -= got;
+                        for (int c = 0; c < got; c++) {
+                            uint32_t val = block[c];
+                            if ((addr & (1 << 13)) && voodoo->type >= VOODOO_BANSHEE) {
 #if 0
-                            if (voodoo->type != VOODOO_BANSHEE)
-                                fatal("CMDFIFO1: Not Banshee\n");
+                                if (voodoo->type != VOODOO_BANSHEE)
+                                    fatal("CMDFIFO1: Not Banshee\n");
 #endif
 
 #if 0
-                            voodoo_fifo_log("CMDFIFO1: write %08x %08x\n", addr, val);
+                                voodoo_fifo_log("CMDFIFO1: write %08x %08x\n", addr, val);
 #endif
-                            voodoo_2d_reg_writel(voodoo, addr, val);
-                        } else {
-                            if ((addr & 0x3ff) == SST_triangleCMD || (addr & 0x3ff) == SST_ftriangleCMD || (addr & 0x3ff) == SST_fastfillCMD || (addr & 0x3ff) == SST_nopCMD)
-                                voodoo->cmd_written_fifo++;
+                                voodoo_2d_reg_writel(voodoo, addr, val);
+                            } else {
+                                if ((addr & 0x3ff) == SST_triangleCMD || (addr & 0x3ff) == SST_ftriangleCMD || (addr & 0x3ff) == SST_fastfillCMD || (addr & 0x3ff) == SST_nopCMD)
+                                    voodoo->cmd_written_fifo++;
 
-                            if (voodoo->type >= VOODOO_BANSHEE && (addr & 0x3ff) == SST_swapbufferCMD)
-                                voodoo->cmd_written_fifo++;
-                            voodoo_reg_writel(addr, val, voodoo);
-                        }
+                                if (voodoo->type >= VOODOO_BANSHEE && (addr & 0x3ff) == SST_swapbufferCMD)
+                                    voodoo->cmd_written_fifo++;
+                                voodoo_reg_writel(addr, val, voodoo);
+                            }
 
-                        if (header & (1 << 15))
-                            addr += 4;
+                            if (header & (1 << 15))
+                                addr += 4;
+                        }
                     }
                     break;
 
@@ -402,39 +537,62 @@ voodoo_fifo_thread(void *param)
                     voodoo_fifo_log("CMDFIFO3 %02x %i\n", (header >> 10), (header >> 3) & 7);
 #endif
 
+                    /*Every vertex has the same layout, work it out once*/
+                    vert_words = 2;
+                    if (mask & CMDFIFO3_PC_MASK_RGB)
+                        vert_words += (header & CMDFIFO3_PC) ? 1 : 3;
+                    if ((mask & CMDFIFO3_PC_MASK_ALPHA) && !(header & CMDFIFO3_PC))
+                        vert_words++;
+                    if (mask & CMDFIFO3_PC_MASK_Z)
+                        vert_words++;
+                    if (mask & CMDFIFO3_PC_MASK_Wb)
+                        vert_words++;
+                    if (mask & CMDFIFO3_PC_MASK_W0)
+                        vert_words++;
+                    if (mask & CMDFIFO3_PC_MASK_S0_T0)
+                        vert_words += 2;
+                    if (mask & CMDFIFO3_PC_MASK_W1)
+                        vert_words++;
+                    if (mask & CMDFIFO3_PC_MASK_S1_T1)
+                        vert_words += 2;
+
                     while (num_verticies--) {
-                        voodoo->verts[3].sVx = cmdfifo_get_f(voodoo);
-                        voodoo->verts[3].sVy = cmdfifo_get_f(voodoo);
+                        const uint32_t *vert = block;
+
+                        cmdfifo_get_all(voodoo, block, vert_words);
+
+                        voodoo->verts[3].sVx = cmdfifo_word_f(*vert++);
+                        voodoo->verts[3].sVy = cmdfifo_word_f(*vert++);
                         if (mask & CMDFIFO3_PC_MASK_RGB) {
                             if (header & CMDFIFO3_PC) {
-                                uint32_t val            = cmdfifo_get(voodoo);
+                                uint32_t val            = *vert++;
                                 voodoo->verts[3].sBlue  = (float) (val & 0xff);
                                 voodoo->verts[3].sGreen = (float) ((val >> 8) & 0xff);
                                 voodoo->verts[3].sRed   = (float) ((val >> 16) & 0xff);
                                 voodoo->verts[3].sAlpha = (float) ((val >> 24) & 0xff);
                             } else {
-                                voodoo->verts[3].sRed   = cmdfifo_get_f(voodoo);
-                                voodoo->verts[3].sGreen = cmdfifo_get_f(voodoo);
-                                voodoo->verts[3].sBlue  = cmdfifo_get_f(voodoo);
+                                voodoo->verts[3].sRed   = cmdfifo_word_f(*vert++);
+                                voodoo->verts[3].sGreen = cmdfifo_word_f(*vert++);
+                                voodoo->verts[3].sBlue  = cmdfifo_word_f(*vert++);
                             }
                         }
                         if ((mask & CMDFIFO3_PC_MASK_ALPHA) && !(header & CMDFIFO3_PC))
-                            voodoo->verts[3].sAlpha = cmdfifo_get_f(voodoo);
+                            voodoo->verts[3].sAlpha = cmdfifo_word_f(*vert++);
                         if (mask & CMDFIFO3_PC_MASK_Z)
-                            voodoo->verts[3].sVz = cmdfifo_get_f(voodoo);
+                            voodoo->verts[3].sVz = cmdfifo_word_f(*vert++);
                         if (mask & CMDFIFO3_PC_MASK_Wb)
-                            voodoo->verts[3].sWb = cmdfifo_get_f(voodoo);
+                            voodoo->verts[3].sWb = cmdfifo_word_f(*vert++);
                         if (mask & CMDFIFO3_PC_MASK_W0)
-                            voodoo->verts[3].sW0 = cmdfifo_get_f(voodoo);
+                            voodoo->verts[3].sW0 = cmdfifo_word_f(*vert++);
                         if (mask & CMDFIFO3_PC_MASK_S0_T0) {
-                            voodoo->verts[3].sS0 = cmdfifo_get_f(voodoo);
-                            voodoo->verts[3].sT0 = cmdfifo_get_f(voodoo);
+                            voodoo->verts[3].sS0 = cmdfifo_word_f(*vert++);
+                            voodoo->verts[3].sT0 = cmdfifo_word_f(*vert++);
                         }
                         if (mask & CMDFIFO3_PC_MASK_W1)
-                            voodoo->verts[3].sW1 = cmdfifo_get_f(voodoo);
+                            voodoo->verts[3].sW1 = cmdfifo_word_f(*vert++);
                         if (mask & CMDFIFO3_PC_MASK_S1_T1) {
-                            voodoo->verts[3].sS1 = cmdfifo_get_f(voodoo);
-                            voodoo->verts[3].sT1 = cmdfifo_get_f(voodoo);
+                            voodoo->verts[3].sS1 = cmdfifo_word_f(*vert++);
+                            voodoo->verts[3].sT1 = cmdfifo_word_f(*vert++);
                         }
                         if (v_num)
                             voodoo_reg_writel(SST_sDrawTriCMD, 0, voodoo);
@@ -444,8 +602,7 @@ voodoo_fifo_thread(void *param)
                         if (v_num == 3 && ((header >> 3) & 7) == 0)
                             v_num = 0;
                     }
-                    while (num--)
-                        cmdfifo_get(voodoo);
+                    cmdfifo_get_all(voodoo, block, num);
                     break;
 
                 case 4:
@@ -511,25 +668,42 @@ voodoo_fifo_thread(void *param)
 #endif
                                 flush_texture_cache(voodoo, addr & voodoo->texture_mask, 1);
                             }
-                            while (num--) {
-                                uint32_t val = cmdfifo_get(voodoo);
-                                if (addr <= voodoo->fb_mask)
-                                    *(uint32_t *) &voodoo->fb_mem[addr] = val;
-                                addr += 4;
+                            /*Straight copy, from the FIFO to the frame buffer*/
+                            while (num) {
+                                int got = cmdfifo_get_run(voodoo, num);
+                                int in  = 0;
+
+                                if (addr <= voodoo->fb_mask) {
+                                    in = ((voodoo->fb_mask - addr) >> 2) + 1;
+                                    if (in > got)
+                                        in = got;
+                                    memcpy(&voodoo->fb_mem[addr], cmdfifo_run_ptr(voodoo), in << 2);
+                                }
+                                cmdfifo_consume(voodoo, got);
+                                addr += got << 2;
+                                num -= got;
                             }
                             break;
                         case 2: /*Framebuffer*/
-                            while (num--) {
-                                uint32_t val = cmdfifo_get(voodoo);
-                                voodoo_fb_writel(addr, val, voodoo);
-                                addr += 4;
+                            while (num) {
+                                int got = cmdfifo_get_block(voodoo, block, (num > CMDFIFO_BLOCK) ? CMDFIFO_BLOCK : num);
+
+                                num -= got;
+                                for (int c = 0; c < got; c++) {
+                                    voodoo_fb_writel(addr, block[c], voodoo);
+                                    addr += 4;
+                                }
                             }
                             break;
                         case 3: /*Texture*/
-                            while (num--) {
-                                uint32_t val = cmdfifo_get(voodoo);
-                                voodoo_tex_writel(addr, val, voodoo);
-                                addr += 4;
+                            while (num) {
+                                int got = cmdfifo_get_block(voodoo, block, (num > CMDFIFO_BLOCK) ? CMDFIFO_BLOCK : num);
+
+                                num -= got;
+                                for (int c = 0; c < got; c++) {
+                                    voodoo_tex_writel(addr, block[c], voodoo);
+                                    addr += 4;
+                                }
                             }
                             break;
 
@@ -545,6 +719,7 @@ voodoo_fifo_thread(void *param)
             end_time = plat_timer_read();
             voodoo->time += end_time - start_time;
         }
+        TRACE_END(voodoo, "fifo");
         voodoo->voodoo_busy = 0;
     }
 }
@@ -39,6 +39,17 @@
 #include <86box/vid_voodoo_regs.h>
 #include <86box/vid_voodoo_render.h>
 #include <86box/vid_voodoo_texture.h>
+#include <86box/trace.h>
+
+/*Vector versions of the bilinear filter and alpha blend, used when the
+  pipeline is interpreted rather than recompiled*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    define VOODOO_RENDER_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define VOODOO_RENDER_NEON
+#endif
 
 typedef struct voodoo_state_t {
     int      xstart, xend, xdir;
@@ -281,11 +292,135 @@ tex_read_4(voodoo_state_t *state, voodoo_texture_state_t *texture_state, int s,
         dat[3].u = state->tex[tmu][state->lod][s + 1 + ((t + 1) << texture_state->tex_shift)];
     }
 
+#if defined(VOODOO_RENDER_SSE2) || defined(VOODOO_RENDER_NEON)
+    /*The weights add up to 256, so every partial sum of texel * weight fits
+      in an unsigned 16-bit lane and the result matches the scalar code*/
+    {
+        rgba_u filtered;
+#    if defined(VOODOO_RENDER_SSE2)
+        __m128i texels = _mm_loadu_si128((const __m128i *) dat);
+        __m128i zero   = _mm_setzero_si128();
+        __m128i lo     = _mm_mullo_epi16(_mm_unpacklo_epi8(texels, zero), _mm_set_epi16(d[1], d[1], d[1], d[1], d[0], d[0], d[0], d[0]));
+        __m128i hi     = _mm_mullo_epi16(_mm_unpackhi_epi8(texels, zero), _mm_set_epi16(d[3], d[3], d[3], d[3], d[2], d[2], d[2], d[2]));
+        __m128i sum    = _mm_add_epi16(lo, hi);
+
+        sum        = _mm_srli_epi16(_mm_add_epi16(sum, _mm_srli_si128(sum, 8)), 8);
+        filtered.u = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+#    else
+        uint8x16_t texels = vld1q_u8((const uint8_t *) dat);
+        uint16x8_t lo     = vmulq_u16(vmovl_u8(vget_low_u8(texels)), vcombine_u16(vdup_n_u16(d[0]), vdup_n_u16(d[1])));
+        uint16x8_t hi     = vmulq_u16(vmovl_u8(vget_high_u8(texels)), vcombine_u16(vdup_n_u16(d[2]), vdup_n_u16(d[3])));
+        uint16x8_t sum    = vaddq_u16(lo, hi);
+        uint16x4_t res    = vshr_n_u16(vadd_u16(vget_low_u16(sum), vget_high_u16(sum)), 8);
+
+        filtered.u = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(res, res))), 0);
+#    endif
+
+        state->tex_r[tmu] = filtered.rgba.r;
+        state->tex_g[tmu] = filtered.rgba.g;
+        state->tex_b[tmu] = filtered.rgba.b;
+        state->tex_a[tmu] = filtered.rgba.a;
+    }
+#else
     state->tex_r[tmu] = (dat[0].rgba.r * d[0] + dat[1].rgba.r * d[1] + dat[2].rgba.r * d[2] + dat[3].rgba.r * d[3]) >> 8;
     state->tex_g[tmu] = (dat[0].rgba.g * d[0] + dat[1].rgba.g * d[1] + dat[2].rgba.g * d[2] + dat[3].rgba.g * d[3]) >> 8;
     state->tex_b[tmu] = (dat[0].rgba.b * d[0] + dat[1].rgba.b * d[1] + dat[2].rgba.b * d[2] + dat[3].rgba.b * d[3]) >> 8;
     state->tex_a[tmu] = (dat[0].rgba.a * d[0] + dat[1].rgba.a * d[1] + dat[2].rgba.a * d[2] + dat[3].rgba.a * d[3]) >> 8;
+#endif
+}
+
+#if defined(VOODOO_RENDER_SSE2) || defined(VOODOO_RENDER_NEON)
+/*Per channel blend factor, other being the colour on the opposite side of
+  the blend. Returns 0 for the functions left to ALPHA_BLEND*/
+static inline int
+voodoo_blend_factor(uint16_t *f, int afunc, const uint16_t *other, int src_a, int dest_a)
+{
+    int v;
+
+    switch (afunc) {
+        case AFUNC_AZERO:
+            v = 0;
+            break;
+        case AFUNC_ASRC_ALPHA:
+            v = src_a;
+            break;
+        case AFUNC_A_COLOR:
+            f[0] = other[0];
+            f[1] = other[1];
+            f[2] = other[2];
+            f[3] = 0;
+            return 1;
+        case AFUNC_ADST_ALPHA:
+            v = dest_a;
+            break;
+        case AFUNC_AONE:
+            v = 255;
+            break;
+        case AFUNC_AOMSRC_ALPHA:
+            v = 255 - src_a;
+            break;
+        case AFUNC_AOM_COLOR:
+            f[0] = 255 - other[0];
+            f[1] = 255 - other[1];
+            f[2] = 255 - other[2];
+            f[3] = 0;
+            return 1;
+        case AFUNC_AOMDST_ALPHA:
+            v = 255 - dest_a;
+            break;
+
+        default:
+            return 0;
+    }
+
+    f[0] = f[1] = f[2] = v;
+    f[3]               = 0;
+    return 1;
+}
+
+/*ALPHA_BLEND for 8-bit source and destination colours, all three channels
+  at once. x / 255 is exact as (x + 1 + (x >> 8)) >> 8 over the 0-65025
+  range of a product. Returns 0 if the caller has to use ALPHA_BLEND*/
+static inline int
+voodoo_alpha_blend(int *src_r, int *src_g, int *src_b, int src_a, int dest_r, int dest_g, int dest_b, int dest_a, int src_func, int dest_func)
+{
+    uint16_t src[4] = { *src_r, *src_g, *src_b, 0 };
+    uint16_t dst[4] = { dest_r, dest_g, dest_b, 0 };
+    uint16_t src_f[4];
+    uint16_t dst_f[4];
+    uint16_t out[4];
+
+    if (!voodoo_blend_factor(dst_f, dest_func, src, src_a, dest_a) || !voodoo_blend_factor(src_f, src_func, dst, src_a, dest_a))
+        return 0;
+
+#    if defined(VOODOO_RENDER_SSE2)
+    {
+        __m128i one = _mm_set1_epi16(1);
+        __m128i s   = _mm_mullo_epi16(_mm_loadl_epi64((const __m128i *) src), _mm_loadl_epi64((const __m128i *) src_f));
+        __m128i d   = _mm_mullo_epi16(_mm_loadl_epi64((const __m128i *) dst), _mm_loadl_epi64((const __m128i *) dst_f));
+
+        s = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s, one), _mm_srli_epi16(s, 8)), 8);
+        d = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(d, one), _mm_srli_epi16(d, 8)), 8);
+        _mm_storel_epi64((__m128i *) out, _mm_min_epi16(_mm_add_epi16(s, d), _mm_set1_epi16(255)));
+    }
+#    else
+    {
+        uint16x4_t one = vdup_n_u16(1);
+        uint16x4_t s   = vmul_u16(vld1_u16(src), vld1_u16(src_f));
+        uint16x4_t d   = vmul_u16(vld1_u16(dst), vld1_u16(dst_f));
+
+        s = vshr_n_u16(vadd_u16(vadd_u16(s, one), vshr_n_u16(s, 8)), 8);
+        d = vshr_n_u16(vadd_u16(vadd_u16(d, one), vshr_n_u16(d, 8)), 8);
+        vst1_u16(out, vmin_u16(vadd_u16(s, d), vdup_n_u16(255)));
+    }
+#    endif
+
+    *src_r = out[0];
+    *src_g = out[1];
+    *src_b = out[2];
+    return 1;
 }
+#endif
 
 static inline void
 voodoo_get_texture(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int tmu, int x)
@@ -805,6 +940,12 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
         uint16_t *fb_mem;
         uint16_t *aux_mem;
 
+        /*Lines of the other render threads only need stepping over*/
+        real_y = (params->fbzMode & (1 << 17)) ? (y_origin - state->y) : state->y;
+        if (((SLI_ENABLED ? (real_y >> 1) : real_y) % voodoo->render_threads) != odd_even)
+            goto next_line;
+        real_y = (state->y << 4) + 8;
+
         state->ir     = state->base_r;
         state->ig     = state->base_g;
         state->ib     = state->base_b;
@@ -830,14 +971,6 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
         else
             real_y >>= 4;
 
-        if (SLI_ENABLED) {
-            if (((real_y >> 1) & voodoo->odd_even_mask) != odd_even)
-                goto next_line;
-        } else {
-            if ((real_y & voodoo->odd_even_mask) != odd_even)
-                goto next_line;
-        }
-
         start_x = x;
 
         if (state->xdir > 0)
@@ -945,9 +1078,9 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
                 int x_tiled = (x & 63) | ((x >> 6) * 128 * 32 / 2);
                 start_x     = x;
                 state->x    = x;
-                voodoo->pixel_count[odd_even]++;
-                voodoo->texel_count[odd_even] += texels;
-                voodoo->fbiPixelsIn++;
+                /* Accumulated into the voodoo counters once per span below. */
+                state->pixel_count++;
+                state->texel_count += texels;
 
                 voodoo_render_log("  X=%03i T=%08x\n", x, state->tmu0_t);
 #if 0
@@ -1280,7 +1413,10 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
                             dest_g = dithersub_g2x2[dest_g][real_y & 1][x & 1];
                             dest_b = dithersub_rb2x2[dest_b][real_y & 1][x & 1];
                         }
-                        ALPHA_BLEND(src_r, src_g, src_b, src_a);
+#if defined(VOODOO_RENDER_SSE2) || defined(VOODOO_RENDER_NEON)
+                        if (!voodoo_alpha_blend(&src_r, &src_g, &src_b, src_a, dest_r, dest_g, dest_b, dest_a, src_afunc, dest_afunc))
+#endif
+                            ALPHA_BLEND(src_r, src_g, src_b, src_a);
                     }
 
                     if (update) {
@@ -1355,36 +1491,21 @@ skip_pixel:
             voodoo->dirty_line[real_y >> 1] = 1;
 
 next_line:
-        if (SLI_ENABLED) {
-            state->base_r += params->dRdY;
-            state->base_g += params->dGdY;
-            state->base_b += params->dBdY;
-            state->base_a += params->dAdY;
-            state->base_z += params->dZdY;
-            state->tmu[0].base_s += params->tmu[0].dSdY;
-            state->tmu[0].base_t += params->tmu[0].dTdY;
-            state->tmu[0].base_w += params->tmu[0].dWdY;
-            state->tmu[1].base_s += params->tmu[1].dSdY;
-            state->tmu[1].base_t += params->tmu[1].dTdY;
-            state->tmu[1].base_w += params->tmu[1].dWdY;
-            state->base_w += params->dWdY;
-            state->xstart += state->dx1;
-            state->xend += state->dx2;
-        }
-        state->base_r += params->dRdY;
-        state->base_g += params->dGdY;
-        state->base_b += params->dBdY;
-        state->base_a += params->dAdY;
-        state->base_z += params->dZdY;
-        state->tmu[0].base_s += params->tmu[0].dSdY;
-        state->tmu[0].base_t += params->tmu[0].dTdY;
-        state->tmu[0].base_w += params->tmu[0].dWdY;
-        state->tmu[1].base_s += params->tmu[1].dSdY;
-        state->tmu[1].base_t += params->tmu[1].dTdY;
-        state->tmu[1].base_w += params->tmu[1].dWdY;
-        state->base_w += params->dWdY;
-        state->xstart += state->dx1;
-        state->xend += state->dx2;
+        /*With SLI, this board only has every other line*/
+        state->base_r += params->dRdY * y_diff;
+        state->base_g += params->dGdY * y_diff;
+        state->base_b += params->dBdY * y_diff;
+        state->base_a += params->dAdY * y_diff;
+        state->base_z += params->dZdY * y_diff;
+        state->tmu[0].base_s += params->tmu[0].dSdY * y_diff;
+        state->tmu[0].base_t += params->tmu[0].dTdY * y_diff;
+        state->tmu[0].base_w += params->tmu[0].dWdY * y_diff;
+        state->tmu[1].base_s += params->tmu[1].dSdY * y_diff;
+        state->tmu[1].base_t += params->tmu[1].dTdY * y_diff;
+        state->tmu[1].base_w += params->tmu[1].dWdY * y_diff;
+        state->base_w += params->dWdY * y_diff;
+        state->xstart += state->dx1 * y_diff;
+        state->xend += state->dx2 * y_diff;
     }
 
     voodoo->texture_cache[0][params->tex_entry[0]].refcount_r[odd_even]++;
@@ -1540,15 +1661,19 @@ voodoo_triangle(voodoo_t *voodoo, voodoo_params_t *params, int odd_even)
 }
 
 static void
-render_thread(void *param, int odd_even)
+render_thread(void *param)
 {
-    voodoo_t *voodoo = (voodoo_t *) param;
+    voodoo_render_thread_t *data     = (voodoo_render_thread_t *) param;
+    voodoo_t               *voodoo   = data->voodoo;
+    int                     odd_even = data->odd_even;
 
     while (voodoo->render_thread_run[odd_even]) {
         thread_set_event(voodoo->render_not_full_event[odd_even]);
-        thread_wait_event(voodoo->wake_render_thread[odd_even], -1);
+        /*Triangles usually arrive in bursts, so poll a little before sleeping*/
+        thread_wait_event_spin(voodoo->wake_render_thread[odd_even], -1, 1000);
         thread_reset_event(voodoo->wake_render_thread[odd_even]);
         voodoo->render_voodoo_busy[odd_even] = 1;
+        TRACE_BEGIN_I(voodoo, "render", "thread", odd_even);
 
         while (!PARAM_EMPTY(odd_even)) {
             uint64_t         start_time = plat_timer_read();
@@ -1566,52 +1691,78 @@ render_thread(void *param, int odd_even)
             voodoo->render_time[odd_even] += end_time - start_time;
         }
 
+        TRACE_END(voodoo, "render");
         voodoo->render_voodoo_busy[odd_even] = 0;
     }
 }
 
-void
-voodoo_render_thread_1(void *param)
+/*A render_threads setting of 0 selects one render thread per host CPU core,
+  leaving one core for the emulation thread.*/
+int
+voodoo_render_threads_from_config(int config)
 {
-    render_thread(param, 0);
+    int threads = config;
+
+    if (threads <= 0)
+        threads = thread_get_cpu_count() - 1;
+
+    if (threads < 1)
+        threads = 1;
+    else if (threads > VOODOO_MAX_RENDER_THREADS)
+        threads = VOODOO_MAX_RENDER_THREADS;
+
+    return threads;
 }
+
 void
-voodoo_render_thread_2(void *param)
+voodoo_render_threads_start(voodoo_t *voodoo)
 {
-    render_thread(param, 1);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        voodoo->wake_render_thread[c]          = thread_create_event();
+        voodoo->render_not_full_event[c]       = thread_create_event();
+        voodoo->render_thread_data[c].voodoo   = voodoo;
+        voodoo->render_thread_data[c].odd_even = c;
+        voodoo->render_thread_run[c]           = 1;
+        voodoo->render_thread[c]               = thread_create(render_thread, &voodoo->render_thread_data[c]);
+    }
 }
+
 void
-voodoo_render_thread_3(void *param)
+voodoo_render_threads_stop(voodoo_t *voodoo)
 {
-    render_thread(param, 2);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        voodoo->render_thread_run[c] = 0;
+        thread_set_event(voodoo->wake_render_thread[c]);
+        thread_wait(voodoo->render_thread[c]);
+        thread_destroy_event(voodoo->wake_render_thread[c]);
+        thread_destroy_event(voodoo->render_not_full_event[c]);
+    }
 }
-void
-voodoo_render_thread_4(void *param)
+
+static int
+voodoo_render_queue_full(voodoo_t *voodoo)
 {
-    render_thread(param, 3);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (PARAM_FULL(c))
+            return 1;
+    }
+
+    return 0;
 }
 
 void
 voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 {
     voodoo_params_t *params_new = &voodoo->params_buffer[voodoo->params_write_idx & PARAM_MASK];
-
-    while (PARAM_FULL(0) || (voodoo->render_threads >= 2 && PARAM_FULL(1)) || (voodoo->render_threads == 4 && (PARAM_FULL(2) || PARAM_FULL(3)))) {
-        thread_reset_event(voodoo->render_not_full_event[0]);
-        if (voodoo->render_threads >= 2)
-            thread_reset_event(voodoo->render_not_full_event[1]);
-        if (voodoo->render_threads == 4) {
-            thread_reset_event(voodoo->render_not_full_event[2]);
-            thread_reset_event(voodoo->render_not_full_event[3]);
+    int              wake       = 0;
+
+    while (voodoo_render_queue_full(voodoo)) {
+        for (int c = 0; c < voodoo->render_threads; c++)
+            thread_reset_event(voodoo->render_not_full_event[c]);
+        for (int c = 0; c < voodoo->render_threads; c++) {
+            if (PARAM_FULL(c))
+                thread_wait_event(voodoo->render_not_full_event[c], -1); /*Wait for room in ringbuffer*/
         }
-        if (PARAM_FULL(0))
-            thread_wait_event(voodoo->render_not_full_event[0], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads >= 2 && PARAM_FULL(1))
-            thread_wait_event(voodoo->render_not_full_event[1], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads == 4 && PARAM_FULL(2))
-            thread_wait_event(voodoo->render_not_full_event[2], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads == 4 && PARAM_FULL(3))
-            thread_wait_event(voodoo->render_not_full_event[3], -1); /*Wait for room in ringbuffer*/
     }
 
     voodoo_use_texture(voodoo, params, 0);
@@ -1622,6 +1773,10 @@ voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 
     voodoo->params_write_idx++;
 
-    if (PARAM_ENTRIES(0) < 4 || (voodoo->render_threads >= 2 && PARAM_ENTRIES(1) < 4) || (voodoo->render_threads == 4 && (PARAM_ENTRIES(2) < 4 || PARAM_ENTRIES(3) < 4)))
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (PARAM_ENTRIES(c) < 4)
+            wake = 1;
+    }
+    if (wake)
         voodoo_wake_render_thread(voodoo);
 }
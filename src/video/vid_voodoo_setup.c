@@ -57,9 +57,48 @@ voodoo_setup_log(const char *fmt, ...)
 #    define voodoo_setup_log(fmt, ...)
 #endif
 
+/* Interpolated vertex parameters, in the order voodoo_setup_params() packs them. */
+enum {
+    SETUP_RED = 0,
+    SETUP_GREEN,
+    SETUP_BLUE,
+    SETUP_ALPHA,
+    SETUP_Z,
+    SETUP_WB,
+    SETUP_W0,
+    SETUP_S0,
+    SETUP_T0,
+    SETUP_W1,
+    SETUP_S1,
+    SETUP_T1,
+    SETUP_NR_PARAMS
+};
+
+static __inline void
+voodoo_setup_params(const vert_t *vert, float *params)
+{
+    params[SETUP_RED]   = vert->sRed;
+    params[SETUP_GREEN] = vert->sGreen;
+    params[SETUP_BLUE]  = vert->sBlue;
+    params[SETUP_ALPHA] = vert->sAlpha;
+    params[SETUP_Z]     = vert->sVz;
+    params[SETUP_WB]    = vert->sWb;
+    params[SETUP_W0]    = vert->sW0;
+    params[SETUP_S0]    = vert->sS0;
+    params[SETUP_T0]    = vert->sT0;
+    params[SETUP_W1]    = vert->sW1;
+    params[SETUP_S1]    = vert->sS1;
+    params[SETUP_T1]    = vert->sT1;
+}
+
 void
 voodoo_triangle_setup(voodoo_t *voodoo)
 {
+    float  pa[SETUP_NR_PARAMS];
+    float  pb[SETUP_NR_PARAMS];
+    float  pc[SETUP_NR_PARAMS];
+    float  dpdx[SETUP_NR_PARAMS];
+    float  dpdy[SETUP_NR_PARAMS];
     float  dxAB;
     float  dxBC;
     float  dyAB;
@@ -165,50 +204,62 @@ voodoo_triangle_setup(voodoo_t *voodoo)
         return;
     }
 
+    /* Gradients of every parameter at once, straight loops over arrays the compiler can vectorize. */
+    voodoo_setup_params(&verts[va], pa);
+    voodoo_setup_params(&verts[vb], pb);
+    voodoo_setup_params(&verts[vc], pc);
+    for (int i = 0; i < SETUP_NR_PARAMS; i++) {
+        float dAB = pa[i] - pb[i];
+        float dBC = pb[i] - pc[i];
+
+        dpdx[i] = dAB * dyBC - dBC * dyAB;
+        dpdy[i] = dBC * dxAB - dAB * dxBC;
+    }
+
     if (voodoo->sSetupMode & SETUPMODE_RGB) {
-        voodoo->params.startR = (int32_t) (verts[va].sRed * 4096.0f);
-        voodoo->params.dRdX   = (int32_t) (((verts[va].sRed - verts[vb].sRed) * dyBC - (verts[vb].sRed - verts[vc].sRed) * dyAB) * 4096.0f);
-        voodoo->params.dRdY   = (int32_t) (((verts[vb].sRed - verts[vc].sRed) * dxAB - (verts[va].sRed - verts[vb].sRed) * dxBC) * 4096.0f);
-        voodoo->params.startG = (int32_t) (verts[va].sGreen * 4096.0f);
-        voodoo->params.dGdX   = (int32_t) (((verts[va].sGreen - verts[vb].sGreen) * dyBC - (verts[vb].sGreen - verts[vc].sGreen) * dyAB) * 4096.0f);
-        voodoo->params.dGdY   = (int32_t) (((verts[vb].sGreen - verts[vc].sGreen) * dxAB - (verts[va].sGreen - verts[vb].sGreen) * dxBC) * 4096.0f);
-        voodoo->params.startB = (int32_t) (verts[va].sBlue * 4096.0f);
-        voodoo->params.dBdX   = (int32_t) (((verts[va].sBlue - verts[vb].sBlue) * dyBC - (verts[vb].sBlue - verts[vc].sBlue) * dyAB) * 4096.0f);
-        voodoo->params.dBdY   = (int32_t) (((verts[vb].sBlue - verts[vc].sBlue) * dxAB - (verts[va].sBlue - verts[vb].sBlue) * dxBC) * 4096.0f);
+        voodoo->params.startR = (int32_t) (pa[SETUP_RED] * 4096.0f);
+        voodoo->params.dRdX   = (int32_t) (dpdx[SETUP_RED] * 4096.0f);
+        voodoo->params.dRdY   = (int32_t) (dpdy[SETUP_RED] * 4096.0f);
+        voodoo->params.startG = (int32_t) (pa[SETUP_GREEN] * 4096.0f);
+        voodoo->params.dGdX   = (int32_t) (dpdx[SETUP_GREEN] * 4096.0f);
+        voodoo->params.dGdY   = (int32_t) (dpdy[SETUP_GREEN] * 4096.0f);
+        voodoo->params.startB = (int32_t) (pa[SETUP_BLUE] * 4096.0f);
+        voodoo->params.dBdX   = (int32_t) (dpdx[SETUP_BLUE] * 4096.0f);
+        voodoo->params.dBdY   = (int32_t) (dpdy[SETUP_BLUE] * 4096.0f);
     }
     if (voodoo->sSetupMode & SETUPMODE_ALPHA) {
-        voodoo->params.startA = (int32_t) (verts[va].sAlpha * 4096.0f);
-        voodoo->params.dAdX   = (int32_t) (((verts[va].sAlpha - verts[vb].sAlpha) * dyBC - (verts[vb].sAlpha - verts[vc].sAlpha) * dyAB) * 4096.0f);
-        voodoo->params.dAdY   = (int32_t) (((verts[vb].sAlpha - verts[vc].sAlpha) * dxAB - (verts[va].sAlpha - verts[vb].sAlpha) * dxBC) * 4096.0f);
+        voodoo->params.startA = (int32_t) (pa[SETUP_ALPHA] * 4096.0f);
+        voodoo->params.dAdX   = (int32_t) (dpdx[SETUP_ALPHA] * 4096.0f);
+        voodoo->params.dAdY   = (int32_t) (dpdy[SETUP_ALPHA] * 4096.0f);
     }
     if (voodoo->sSetupMode & SETUPMODE_Z) {
-        voodoo->params.startZ = (int32_t) (verts[va].sVz * 4096.0f);
-        voodoo->params.dZdX   = (int32_t) (((verts[va].sVz - verts[vb].sVz) * dyBC - (verts[vb].sVz - verts[vc].sVz) * dyAB) * 4096.0f);
-        voodoo->params.dZdY   = (int32_t) (((verts[vb].sVz - verts[vc].sVz) * dxAB - (verts[va].sVz - verts[vb].sVz) * dxBC) * 4096.0f);
+        voodoo->params.startZ = (int32_t) (pa[SETUP_Z] * 4096.0f);
+        voodoo->params.dZdX   = (int32_t) (dpdx[SETUP_Z] * 4096.0f);
+        voodoo->params.dZdY   = (int32_t) (dpdy[SETUP_Z] * 4096.0f);
     }
     if (voodoo->sSetupMode & SETUPMODE_Wb) {
-        voodoo->params.startW        = (int64_t) (verts[va].sWb * 4294967296.0f);
-        voodoo->params.dWdX          = (int64_t) (((verts[va].sWb - verts[vb].sWb) * dyBC - (verts[vb].sWb - verts[vc].sWb) * dyAB) * 4294967296.0f);
-        voodoo->params.dWdY          = (int64_t) (((verts[vb].sWb - verts[vc].sWb) * dxAB - (verts[va].sWb - verts[vb].sWb) * dxBC) * 4294967296.0f);
+        voodoo->params.startW        = (int64_t) (pa[SETUP_WB] * 4294967296.0f);
+        voodoo->params.dWdX          = (int64_t) (dpdx[SETUP_WB] * 4294967296.0f);
+        voodoo->params.dWdY          = (int64_t) (dpdy[SETUP_WB] * 4294967296.0f);
         voodoo->params.tmu[0].startW = voodoo->params.tmu[1].startW = voodoo->params.startW;
         voodoo->params.tmu[0].dWdX = voodoo->params.tmu[1].dWdX = voodoo->params.dWdX;
         voodoo->params.tmu[0].dWdY = voodoo->params.tmu[1].dWdY = voodoo->params.dWdY;
     }
     if (voodoo->sSetupMode & SETUPMODE_W0) {
-        voodoo->params.tmu[0].startW = (int64_t) (verts[va].sW0 * 4294967296.0f);
-        voodoo->params.tmu[0].dWdX   = (int64_t) (((verts[va].sW0 - verts[vb].sW0) * dyBC - (verts[vb].sW0 - verts[vc].sW0) * dyAB) * 4294967296.0f);
-        voodoo->params.tmu[0].dWdY   = (int64_t) (((verts[vb].sW0 - verts[vc].sW0) * dxAB - (verts[va].sW0 - verts[vb].sW0) * dxBC) * 4294967296.0f);
+        voodoo->params.tmu[0].startW = (int64_t) (pa[SETUP_W0] * 4294967296.0f);
+        voodoo->params.tmu[0].dWdX   = (int64_t) (dpdx[SETUP_W0] * 4294967296.0f);
+        voodoo->params.tmu[0].dWdY   = (int64_t) (dpdy[SETUP_W0] * 4294967296.0f);
         voodoo->params.tmu[1].startW = voodoo->params.tmu[0].startW;
         voodoo->params.tmu[1].dWdX   = voodoo->params.tmu[0].dWdX;
         voodoo->params.tmu[1].dWdY   = voodoo->params.tmu[0].dWdY;
     }
     if (voodoo->sSetupMode & SETUPMODE_S0_T0) {
-        voodoo->params.tmu[0].startS = (int64_t) (verts[va].sS0 * 4294967296.0f);
-        voodoo->params.tmu[0].dSdX   = (int64_t) (((verts[va].sS0 - verts[vb].sS0) * dyBC - (verts[vb].sS0 - verts[vc].sS0) * dyAB) * 4294967296.0f);
-        voodoo->params.tmu[0].dSdY   = (int64_t) (((verts[vb].sS0 - verts[vc].sS0) * dxAB - (verts[va].sS0 - verts[vb].sS0) * dxBC) * 4294967296.0f);
-        voodoo->params.tmu[0].startT = (int64_t) (verts[va].sT0 * 4294967296.0f);
-        voodoo->params.tmu[0].dTdX   = (int64_t) (((verts[va].sT0 - verts[vb].sT0) * dyBC - (verts[vb].sT0 - verts[vc].sT0) * dyAB) * 4294967296.0f);
-        voodoo->params.tmu[0].dTdY   = (int64_t) (((verts[vb].sT0 - verts[vc].sT0) * dxAB - (verts[va].sT0 - verts[vb].sT0) * dxBC) * 4294967296.0f);
+        voodoo->params.tmu[0].startS = (int64_t) (pa[SETUP_S0] * 4294967296.0f);
+        voodoo->params.tmu[0].dSdX   = (int64_t) (dpdx[SETUP_S0] * 4294967296.0f);
+        voodoo->params.tmu[0].dSdY   = (int64_t) (dpdy[SETUP_S0] * 4294967296.0f);
+        voodoo->params.tmu[0].startT = (int64_t) (pa[SETUP_T0] * 4294967296.0f);
+        voodoo->params.tmu[0].dTdX   = (int64_t) (dpdx[SETUP_T0] * 4294967296.0f);
+        voodoo->params.tmu[0].dTdY   = (int64_t) (dpdy[SETUP_T0] * 4294967296.0f);
         voodoo->params.tmu[1].startS = voodoo->params.tmu[0].startS;
         voodoo->params.tmu[1].dSdX   = voodoo->params.tmu[0].dSdX;
         voodoo->params.tmu[1].dSdY   = voodoo->params.tmu[0].dSdY;
@@ -217,17 +268,17 @@ voodoo_triangle_setup(voodoo_t *voodoo)
         voodoo->params.tmu[1].dTdY   = voodoo->params.tmu[0].dTdY;
     }
     if (voodoo->sSetupMode & SETUPMODE_W1) {
-        voodoo->params.tmu[1].startW = (int64_t) (verts[va].sW1 * 4294967296.0f);
-        voodoo->params.tmu[1].dWdX   = (int64_t) (((verts[va].sW1 - verts[vb].sW1) * dyBC - (verts[vb].sW1 - verts[vc].sW1) * dyAB) * 4294967296.0f);
-        voodoo->params.tmu[1].dWdY   = (int64_t) (((verts[vb].sW1 - verts[vc].sW1) * dxAB - (verts[va].sW1 - verts[vb].sW1) * dxBC) * 4294967296.0f);
+        voodoo->params.tmu[1].startW = (int64_t) (pa[SETUP_W1] * 4294967296.0f);
+        voodoo->params.tmu[1].dWdX   = (int64_t) (dpdx[SETUP_W1] * 4294967296.0f);
+        voodoo->params.tmu[1].dWdY   = (int64_t) (dpdy[SETUP_W1] * 4294967296.0f);
     }
     if (voodoo->sSetupMode & SETUPMODE_S1_T1) {
-        voodoo->params.tmu[1].startS = (int64_t) (verts[va].sS1 * 4294967296.0f);
-        voodoo->params.tmu[1].dSdX   = (int64_t) (((verts[va].sS1 - verts[vb].sS1) * dyBC - (verts[vb].sS1 - verts[vc].sS1) * dyAB) * 4294967296.0f);
-        voodoo->params.tmu[1].dSdY   = (int64_t) (((verts[vb].sS1 - verts[vc].sS1) * dxAB - (verts[va].sS1 - verts[vb].sS1) * dxBC) * 4294967296.0f);
-        voodoo->params.tmu[1].startT = (int64_t) (verts[va].sT1 * 4294967296.0f);
-        voodoo->params.tmu[1].dTdX   = (int64_t) (((verts[va].sT1 - verts[vb].sT1) * dyBC - (verts[vb].sT1 - verts[vc].sT1) * dyAB) * 4294967296.0f);
-        voodoo->params.tmu[1].dTdY   = (int64_t) (((verts[vb].sT1 - verts[vc].sT1) * dxAB - (verts[va].sT1 - verts[vb].sT1) * dxBC) * 4294967296.0f);
+        voodoo->params.tmu[1].startS = (int64_t) (pa[SETUP_S1] * 4294967296.0f);
+        voodoo->params.tmu[1].dSdX   = (int64_t) (dpdx[SETUP_S1] * 4294967296.0f);
+        voodoo->params.tmu[1].dSdY   = (int64_t) (dpdy[SETUP_S1] * 4294967296.0f);
+        voodoo->params.tmu[1].startT = (int64_t) (pa[SETUP_T1] * 4294967296.0f);
+        voodoo->params.tmu[1].dTdX   = (int64_t) (dpdx[SETUP_T1] * 4294967296.0f);
+        voodoo->params.tmu[1].dTdY   = (int64_t) (dpdy[SETUP_T1] * 4294967296.0f);
     }
 
     voodoo->params.sign = (area < 0.0);
@@ -17,6 +17,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stddef.h>
@@ -58,6 +59,180 @@ voodoo_texture_log(const char *fmt, ...)
 #    define voodoo_texture_log(fmt, ...)
 #endif
 
+/*True if any render thread has not yet finished every queued triangle that
+  references this texture*/
+static int
+voodoo_texture_in_use(voodoo_t *voodoo, texture_t *texture)
+{
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (texture->refcount != texture->refcount_r[c])
+            return 1;
+    }
+
+    return 0;
+}
+
+/*Decoded texture, all LODs of both halves of a split texture*/
+#define TEX_DATA_SIZE ((256 * 256 + 256 * 256 + 128 * 128 + 64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2) * 4)
+
+static int
+voodoo_texture_hash(uint32_t base, uint32_t tLOD, uint32_t palette_checksum)
+{
+    uint32_t hash = (base >> 3) ^ (tLOD * 0x85ebca6b) ^ palette_checksum;
+
+    return (hash * 0x9e3779b1) >> (32 - TEX_HASH_SHIFT);
+}
+
+static void
+voodoo_texture_hash_add(voodoo_t *voodoo, int tmu, int c)
+{
+    texture_t *texture = &voodoo->texture_cache[tmu][c];
+    int        hash    = voodoo_texture_hash(texture->base, texture->tLOD, texture->palette_checksum);
+
+    texture->hash_next              = voodoo->texture_hash[tmu][hash];
+    voodoo->texture_hash[tmu][hash] = c;
+}
+
+static void
+voodoo_texture_hash_remove(voodoo_t *voodoo, int tmu, int c)
+{
+    texture_t *texture = &voodoo->texture_cache[tmu][c];
+    int       *entry   = &voodoo->texture_hash[tmu][voodoo_texture_hash(texture->base, texture->tLOD, texture->palette_checksum)];
+
+    while (*entry != -1) {
+        if (*entry == c) {
+            *entry = texture->hash_next;
+            break;
+        }
+        entry = &voodoo->texture_cache[tmu][*entry].hash_next;
+    }
+    texture->hash_next = -1;
+}
+
+static void
+voodoo_texture_lru_unlink(voodoo_t *voodoo, int tmu, int c)
+{
+    texture_t *texture = &voodoo->texture_cache[tmu][c];
+
+    if (texture->lru_prev != -1)
+        voodoo->texture_cache[tmu][texture->lru_prev].lru_next = texture->lru_next;
+    else
+        voodoo->texture_lru_head[tmu] = texture->lru_next;
+    if (texture->lru_next != -1)
+        voodoo->texture_cache[tmu][texture->lru_next].lru_prev = texture->lru_prev;
+    else
+        voodoo->texture_lru_tail[tmu] = texture->lru_prev;
+}
+
+/*Move an entry to the most recently used end of the list, or to the least
+  recently used end if it has just been invalidated*/
+static void
+voodoo_texture_lru_move(voodoo_t *voodoo, int tmu, int c, int to_head)
+{
+    texture_t *texture = &voodoo->texture_cache[tmu][c];
+
+    voodoo_texture_lru_unlink(voodoo, tmu, c);
+    if (to_head) {
+        texture->lru_prev = -1;
+        texture->lru_next = voodoo->texture_lru_head[tmu];
+        if (texture->lru_next != -1)
+            voodoo->texture_cache[tmu][texture->lru_next].lru_prev = c;
+        else
+            voodoo->texture_lru_tail[tmu] = c;
+        voodoo->texture_lru_head[tmu] = c;
+    } else {
+        texture->lru_next = -1;
+        texture->lru_prev = voodoo->texture_lru_tail[tmu];
+        if (texture->lru_prev != -1)
+            voodoo->texture_cache[tmu][texture->lru_prev].lru_next = c;
+        else
+            voodoo->texture_lru_head[tmu] = c;
+        voodoo->texture_lru_tail[tmu] = c;
+    }
+}
+
+/*Add or remove an entry from the page map of every page its LODs live on*/
+static void
+voodoo_texture_mark_pages(voodoo_t *voodoo, int tmu, int c, int present)
+{
+    texture_t *texture   = &voodoo->texture_cache[tmu][c];
+    uint32_t   page_mask = voodoo->texture_mask >> TEX_DIRTY_SHIFT;
+    uint32_t   bit       = 1u << (c & 31);
+
+    for (uint8_t d = 0; d < 4; d++) {
+        uint32_t page;
+        uint32_t page_end;
+
+        if (texture->addr_end[d] == 0)
+            continue;
+
+        page     = texture->addr_start[d] >> TEX_DIRTY_SHIFT;
+        page_end = texture->addr_end[d] >> TEX_DIRTY_SHIFT;
+        if ((page_end - page) > page_mask)
+            page_end = page + page_mask;
+
+        for (; page <= page_end; page++) {
+            uint32_t *pages = &voodoo->texture_pages[tmu][page & page_mask][c >> 5];
+
+            if (present && !(*pages & bit)) {
+                *pages |= bit;
+                voodoo->texture_present[tmu][page & page_mask]++;
+            } else if (!present && (*pages & bit)) {
+                *pages &= ~bit;
+                voodoo->texture_present[tmu][page & page_mask]--;
+            }
+        }
+    }
+}
+
+static void
+voodoo_texture_evict(voodoo_t *voodoo, int tmu, int c)
+{
+    texture_t *texture = &voodoo->texture_cache[tmu][c];
+
+    if (texture->base == -1)
+        return;
+
+    voodoo_texture_hash_remove(voodoo, tmu, c);
+    voodoo_texture_mark_pages(voodoo, tmu, c, 0);
+    texture->base = -1;
+    voodoo->texture_evictions[tmu]++;
+}
+
+void
+voodoo_texture_cache_init(voodoo_t *voodoo)
+{
+    for (uint8_t tmu = 0; tmu < 2; tmu++) {
+        for (int c = 0; c < TEX_CACHE_MAX; c++) {
+            texture_t *texture = &voodoo->texture_cache[tmu][c];
+
+            texture->data      = NULL;
+            texture->base      = -1; /*invalid*/
+            texture->refcount  = 0;
+            texture->hash_next = -1;
+            texture->lru_prev  = c - 1;
+            texture->lru_next  = (c == (TEX_CACHE_MAX - 1)) ? -1 : (c + 1);
+        }
+        for (int c = 0; c < TEX_HASH_SIZE; c++)
+            voodoo->texture_hash[tmu][c] = -1;
+        voodoo->texture_lru_head[tmu] = 0;
+        voodoo->texture_lru_tail[tmu] = TEX_CACHE_MAX - 1;
+    }
+}
+
+void
+voodoo_texture_cache_close(voodoo_t *voodoo)
+{
+    for (uint8_t tmu = 0; tmu < 2; tmu++) {
+        voodoo_texture_log("Texture cache TMU%i: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " evictions\n",
+                           tmu, voodoo->texture_hits[tmu], voodoo->texture_misses[tmu], voodoo->texture_evictions[tmu]);
+        for (int c = 0; c < TEX_CACHE_MAX; c++) {
+            free(voodoo->texture_cache[tmu][c].data);
+            voodoo->texture_cache[tmu][c].data = NULL;
+        }
+    }
+}
+
 void
 voodoo_recalc_tex12(voodoo_t *voodoo, int tmu)
 {
@@ -246,7 +421,6 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     int      lod_min;
     int      lod_max;
     uint32_t addr = 0;
-    uint32_t addr_end;
     uint32_t palette_checksum;
 
     lod_min = (params->tLOD[tmu] >> 2) & 15;
@@ -272,34 +446,37 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
         addr = params->texBaseAddr[tmu];
 
     /*Try to find texture in cache*/
-    for (c = 0; c < TEX_CACHE_MAX; c++) {
+    c = voodoo->texture_hash[tmu][voodoo_texture_hash(addr, params->tLOD[tmu] & 0xf00fff, palette_checksum)];
+    while (c != -1) {
         if (voodoo->texture_cache[tmu][c].base == addr && voodoo->texture_cache[tmu][c].tLOD == (params->tLOD[tmu] & 0xf00fff) && voodoo->texture_cache[tmu][c].palette_checksum == palette_checksum) {
             params->tex_entry[tmu] = c;
             voodoo->texture_cache[tmu][c].refcount++;
+            voodoo_texture_lru_move(voodoo, tmu, c, 1);
+            voodoo->texture_hits[tmu]++;
             return;
         }
+        c = voodoo->texture_cache[tmu][c].hash_next;
     }
+    voodoo->texture_misses[tmu]++;
 
-    /*Texture not found, search for unused texture*/
+    /*Texture not found, replace the least recently used texture not in use*/
     do {
-        for (c = 0; c < TEX_CACHE_MAX; c++) {
-            voodoo->texture_last_removed++;
-            voodoo->texture_last_removed &= (TEX_CACHE_MAX - 1);
-            if (voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[0] && (voodoo->render_threads == 1 || voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[1]))
+        for (c = voodoo->texture_lru_tail[tmu]; c != -1; c = voodoo->texture_cache[tmu][c].lru_prev) {
+            if (!voodoo_texture_in_use(voodoo, &voodoo->texture_cache[tmu][c]))
                 break;
         }
-        if (c == TEX_CACHE_MAX)
+        if (c == -1)
             voodoo_wait_for_render_thread_idle(voodoo);
-    } while (c == TEX_CACHE_MAX);
-    if (c == TEX_CACHE_MAX)
-        fatal("Texture cache full!\n");
+    } while (c == -1);
 
-    c = voodoo->texture_last_removed;
+    voodoo_texture_evict(voodoo, tmu, c);
+    if (!voodoo->texture_cache[tmu][c].data) {
+        voodoo->texture_cache[tmu][c].data = malloc(TEX_DATA_SIZE);
+        if (!voodoo->texture_cache[tmu][c].data)
+            fatal("Texture cache: out of memory\n");
+    }
 
-    if ((voodoo->params.tLOD[tmu] & LOD_SPLIT) && (voodoo->params.tLOD[tmu] & LOD_ODD) && (voodoo->params.tLOD[tmu] & LOD_TMULTIBASEADDR))
-        voodoo->texture_cache[tmu][c].base = params->texBaseAddr1[tmu];
-    else
-        voodoo->texture_cache[tmu][c].base = params->texBaseAddr[tmu];
+    voodoo->texture_cache[tmu][c].base = addr;
     voodoo->texture_cache[tmu][c].tLOD = params->tLOD[tmu] & 0xf00fff;
 
     lod_min = (params->tLOD[tmu] >> 2) & 15;
@@ -536,56 +713,40 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     } else
         voodoo->texture_cache[tmu][c].addr_start[3] = voodoo->texture_cache[tmu][c].addr_end[3] = 0;
 
-    for (uint8_t d = 0; d < 4; d++) {
-        addr     = voodoo->texture_cache[tmu][c].addr_start[d];
-        addr_end = voodoo->texture_cache[tmu][c].addr_end[d];
-
-        if (addr_end != 0) {
-            for (; addr <= addr_end; addr += (1 << TEX_DIRTY_SHIFT))
-                voodoo->texture_present[tmu][(addr & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-        }
-    }
+    voodoo_texture_hash_add(voodoo, tmu, c);
+    voodoo_texture_mark_pages(voodoo, tmu, c, 1);
+    voodoo_texture_lru_move(voodoo, tmu, c, 1);
 
     params->tex_entry[tmu] = c;
     voodoo->texture_cache[tmu][c].refcount++;
 }
 
+/*Invalidate every cached texture with a LOD on the page containing dirty_addr*/
 void
 flush_texture_cache(voodoo_t *voodoo, uint32_t dirty_addr, int tmu)
 {
-    int wait_for_idle = 0;
+    uint32_t *pages         = voodoo->texture_pages[tmu][(dirty_addr & voodoo->texture_mask) >> TEX_DIRTY_SHIFT];
+    int       wait_for_idle = 0;
 
-    memset(voodoo->texture_present[tmu], 0, sizeof(voodoo->texture_present[0]));
 #if 0
-    voodoo_texture_log("Evict %08x %i\n", dirty_addr, sizeof(voodoo->texture_present));
+    voodoo_texture_log("Evict %08x\n", dirty_addr);
 #endif
-    for (uint8_t c = 0; c < TEX_CACHE_MAX; c++) {
-        if (voodoo->texture_cache[tmu][c].base != -1) {
-            for (uint8_t d = 0; d < 4; d++) {
-                int addr_start = voodoo->texture_cache[tmu][c].addr_start[d];
-                int addr_end   = voodoo->texture_cache[tmu][c].addr_end[d];
-
-                if (addr_end != 0) {
-                    int addr_start_masked = addr_start & voodoo->texture_mask & ~0x3ff;
-                    int addr_end_masked   = ((addr_end & voodoo->texture_mask) + 0x3ff) & ~0x3ff;
-
-                    if (addr_end_masked < addr_start_masked)
-                        addr_end_masked = voodoo->texture_mask + 1;
-                    if (dirty_addr >= addr_start_masked && dirty_addr < addr_end_masked) {
+    for (int w = 0; w < (TEX_CACHE_MAX / 32); w++) {
+        while (pages[w]) {
+            int c = w << 5;
+
+            while (!(pages[w] & (1u << (c & 31))))
+                c++;
+
 #if 0
-                        voodoo_texture_log("  Evict texture %i %08x\n", c, voodoo->texture_cache[tmu][c].base);
+            voodoo_texture_log("  Evict texture %i %08x\n", c, voodoo->texture_cache[tmu][c].base);
 #endif
+            if (voodoo_texture_in_use(voodoo, &voodoo->texture_cache[tmu][c]))
+                wait_for_idle = 1;
 
-                        if (voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[0] || (voodoo->render_threads == 2 && voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[1]))
-                            wait_for_idle = 1;
-
-                        voodoo->texture_cache[tmu][c].base = -1;
-                    } else {
-                        for (; addr_start <= addr_end; addr_start += (1 << TEX_DIRTY_SHIFT))
-                            voodoo->texture_present[tmu][(addr_start & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-                    }
-                }
-            }
+            /*Clears this entry's bit on every page, including this one*/
+            voodoo_texture_evict(voodoo, tmu, c);
+            voodoo_texture_lru_move(voodoo, tmu, c, 0);
         }
     }
     if (wait_for_idle)
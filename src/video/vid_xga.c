@@ -103,7 +103,7 @@ svga_xga_out(uint16_t addr, uint8_t val, void *priv)
                         svga->ma_latch   = ((svga->crtc[0xc] << 8) | svga->crtc[0xd]) + ((svga->crtc[8] & 0x60) >> 5);
                     } else {
                         svga->fullchange = changeframecount;
-                        svga_recalctimings(svga);
+                        svga_recalctimings_crtc(svga);
                     }
                 }
             }
@@ -1438,6 +1438,137 @@ xga_line_draw_write(svga_t *svga)
     }
 }
 
+static int
+xga_map_in_aperture(const xga_t *xga, uint32_t base)
+{
+    if (xga->base_addr_1mb)
+        return (base >= xga->base_addr_1mb) && (base <= (xga->base_addr_1mb + 0xfffff));
+
+    return (base >= xga->linear_base) && (base <= (xga->linear_base + 0xfffff));
+}
+
+/* Span kernel for the fixed pattern loop of xga_bitblt(), covering fills and
+   PxBlts between 8 or 16 bpp maps of the same depth with the zero, copy, XOR
+   and one mixes, no mask map, no colour compare and no byte swapping. Draws
+   n pixels of row dy from dx stepping by xdir, taking the source from (sx, sy)
+   in the source map when use_src is set and the foreground colour otherwise,
+   and clips the span against the destination map once.
+
+   xga_accel_write_map_pixel() follows its video memory write with a bus
+   write to the same address, which lands on the same bytes again through
+   the linear aperture; the kernel only does the first and charges the
+   cycles of the second. Returns 0 without drawing anything if the span is
+   not backed that way, or wraps around video memory. */
+static int
+xga_bitblt_span(svga_t *svga, int dx, int dy, int sx, int sy, int xdir, int n, int use_src)
+{
+    xga_t   *xga        = (xga_t *) svga->xga;
+    int      dst_map    = xga->accel.dst_map;
+    int      src_map    = xga->accel.src_map;
+    int      bpp        = ((xga->accel.px_map_format[dst_map] & 7) == 4) ? 2 : 1;
+    uint32_t dstwidth   = xga->accel.px_map_width[dst_map] + 1;
+    uint32_t srcwidth   = xga->accel.px_map_width[src_map] + 1;
+    uint32_t plane_mask = xga->accel.plane_mask;
+    uint32_t frgdcol    = xga->accel.frgd_color;
+    int      mix        = xga->accel.frgd_mix & 0x1f;
+    int      step       = xdir * bpp;
+    uint32_t d;
+    uint32_t s = 0;
+    uint32_t lo;
+    uint32_t hi;
+    int      i1;
+    int      i2;
+
+    if (!xga->on)
+        return 0;
+
+    if ((dy < 0) || (dy > (int) xga->accel.px_map_height[dst_map]))
+        return 1;
+
+    if (xdir > 0) {
+        i1 = -dx;
+        i2 = (int) (dstwidth - 1) - dx;
+    } else {
+        i1 = dx - (int) (dstwidth - 1);
+        i2 = dx;
+    }
+    i1 = MAX(i1, 0);
+    i2 = MIN(i2, n - 1);
+    if (i1 > i2)
+        return 1;
+    n = i2 - i1 + 1;
+
+    d  = xga->accel.px_map_base[dst_map] + (((dy * dstwidth) + dx + (i1 * xdir)) * bpp);
+    lo = (xdir > 0) ? d : (d - ((n - 1) * bpp));
+    hi = lo + (n * bpp) - 1;
+    if ((hi < lo) || (((lo & xga->vram_mask) + (hi - lo)) > xga->vram_mask) ||
+        ((svga->decode_mask & xga->vram_mask) != xga->vram_mask) ||
+        (((lo & svga->decode_mask) + (hi - lo)) >= xga->vram_size))
+        return 0;
+    for (uint32_t addr = lo & ~MEM_GRANULARITY_MASK; addr <= hi; addr += MEM_GRANULARITY_SIZE) {
+        if (mem_get_phys_mapping(addr, 1) != &xga->linear_mapping)
+            return 0;
+    }
+
+    if (use_src) {
+        s = xga->accel.px_map_base[src_map] + (((sy * srcwidth) + sx + (i1 * xdir)) * bpp);
+        if ((xdir > 0) ? (((s & xga->vram_mask) + ((n * bpp) - 1)) > xga->vram_mask) :
+                         ((s & xga->vram_mask) < (uint32_t) ((n - 1) * bpp)))
+            return 0;
+        s &= xga->vram_mask;
+    }
+    d &= xga->vram_mask;
+
+    for (int i = 0; i < n; i++) {
+        uint32_t src_dat = frgdcol;
+        uint32_t dest_dat;
+        uint32_t old_dest_dat;
+
+        if (bpp == 2) {
+            if (use_src)
+                src_dat = *(uint16_t *) &xga->vram[s];
+            dest_dat = *(uint16_t *) &xga->vram[d];
+        } else {
+            if (use_src)
+                src_dat = xga->vram[s];
+            dest_dat = xga->vram[d];
+        }
+        old_dest_dat = dest_dat;
+
+        switch (mix) {
+            case 0x00:
+                dest_dat = 0;
+                break;
+            case 0x03:
+                dest_dat = src_dat;
+                break;
+            case 0x06:
+                dest_dat ^= src_dat;
+                break;
+            default:
+                dest_dat = ~0;
+                break;
+        }
+        dest_dat = (dest_dat & plane_mask) | (old_dest_dat & ~plane_mask);
+
+        if (bpp == 2)
+            *(uint16_t *) &xga->vram[d] = dest_dat;
+        else
+            xga->vram[d] = dest_dat & 0xff;
+
+        d += step;
+        s += step;
+    }
+
+    for (uint32_t page = (lo & xga->vram_mask) >> 12; page <= ((hi & xga->vram_mask) >> 12); page++)
+        xga->changedvram[page] = svga->monitor->mon_changeframecount;
+
+    cycles -= n * bpp * svga->monitor->mon_video_timing_write_b;
+    mem_logical_addr = 0xffffffff;
+
+    return 1;
+}
+
 static void
 xga_bitblt(svga_t *svga)
 {
@@ -1463,6 +1594,8 @@ xga_bitblt(svga_t *svga)
     int      mix  = 0;
     int      xdir = (xga->accel.octant & 0x04) ? -1 : 1;
     int      ydir = (xga->accel.octant & 0x02) ? -1 : 1;
+    int      use_src;
+    int      fast;
 
     xga->accel.x = xga->accel.blt_width & 0xfff;
     xga->accel.y = xga->accel.blt_height & 0xfff;
@@ -1516,7 +1649,30 @@ xga_bitblt(svga_t *svga)
                 xga->accel.px_map_width[2], xga->accel.px_map_width[3]);
         xga_log("PAT8: Pattern Enabled?=%d, xdir=%d, ydir=%d.\n", xga->accel.pattern, xdir, ydir);
 
+        use_src = (((xga->accel.command >> 28) & 3) == 2);
+        fast    = !(xga->accel.command & 0xc0) && (xga->accel.cc_cond == 4) && !xga->linear_endian_reverse &&
+               (((xga->accel.frgd_mix & 0x1f) == 0x00) || ((xga->accel.frgd_mix & 0x1f) == 0x03) ||
+                ((xga->accel.frgd_mix & 0x1f) == 0x06) || ((xga->accel.frgd_mix & 0x1f) == 0x0f)) &&
+               (((xga->accel.px_map_format[xga->accel.dst_map] & 7) == 3) || ((xga->accel.px_map_format[xga->accel.dst_map] & 7) == 4)) &&
+               xga_map_in_aperture(xga, dstbase);
+        if (use_src)
+            fast = fast && !xga->accel.pattern && xga_map_in_aperture(xga, srcbase) &&
+                   ((xga->accel.px_map_format[xga->accel.src_map] & 7) == (xga->accel.px_map_format[xga->accel.dst_map] & 7));
+
         while (xga->accel.y >= 0) {
+            /*All but the last pixel of the row through the span kernel, the last one
+              goes through the loop below so that the end of the row is handled there.*/
+            if (fast && (xga->accel.x > 0) &&
+                xga_bitblt_span(svga, dx, dy, xga->accel.sx, xga->accel.sy, xdir, xga->accel.x, use_src)) {
+                if (xga->accel.pattern) {
+                    for (int i = 0; i < xga->accel.x; i++)
+                        xga->accel.sx = ((xga->accel.sx + xdir) & srcwidth) | (xga->accel.sx & ~srcwidth);
+                } else
+                    xga->accel.sx += xdir * xga->accel.x;
+                dx += xdir * xga->accel.x;
+                xga->accel.x = 0;
+            }
+
             if (xga->accel.command & 0xc0) {
                 if ((dx >= xga->accel.mask_map_origin_x_off) && (dx <= ((xga->accel.px_map_width[0] & 0xfff) + xga->accel.mask_map_origin_x_off)) && (dy >= xga->accel.mask_map_origin_y_off) && (dy <= ((xga->accel.px_map_height[0] & 0xfff) + xga->accel.mask_map_origin_y_off))) {
                     src_dat  = (((xga->accel.command >> 28) & 3) == 2) ? xga_accel_read_map_pixel(svga, xga->accel.sx, xga->accel.sy, xga->accel.src_map, srcbase, srcwidth + 1, 1) : frgdcol;
@@ -49,6 +49,11 @@
  *          Copyright 2016-2019 Miran Grca.
  */
 #include <stdatomic.h>
+#if defined _WIN32
+#    include <windows.h>
+#else
+#    include <time.h>
+#endif
 #define PNG_DEBUG 0
 #include <png.h>
 #include <stdarg.h>
@@ -73,11 +78,16 @@
 #include <86box/thread.h>
 #include <86box/video.h>
 #include <86box/vid_svga.h>
+#include <86box/shmfb.h>
+#include <86box/capture.h>
 
-#include <minitrace/minitrace.h>
+#include <86box/trace.h>
+#include <86box/metrics.h>
+#include <86box/bench.h>
 
 volatile int screenshots = 0;
-uint8_t      edatlookup[4][4];
+uint32_t     edatlookup8[256];
+uint32_t     video_glyphmask[256][8];
 uint8_t      egaremap2bpp[256];
 uint8_t      fontdat[2048][8];            /* IBM CGA font */
 uint8_t      fontdatm[2048][16];          /* IBM MDA font */
@@ -236,6 +246,10 @@ const uint32_t shade[5][256] = {
 
 typedef struct blit_data_struct {
     int x, y, w, h;
+    int dirty_y1, dirty_y2; /* Rows of the blit that changed since the last one. */
+    int next_y1, next_y2;   /* Set by video_blit_dirty_monitor() for the next blit. */
+    int next_dirty;
+    int dropped_full; /* A frame was dropped since the last blit. */
     int busy;
     int buffer_in_use;
     int thread_run;
@@ -245,8 +259,26 @@ typedef struct blit_data_struct {
     event_t  *wake_blit_thread;
     event_t  *blit_complete;
     event_t  *buffer_not_in_use;
+
+    /* Frame time statistics, logged once a second with video_frame_stats. */
+    uint64_t last_frame_us;
+    uint64_t stats_start_us;
+    uint64_t frame_us;
+    uint64_t frame_max_us;
+    uint64_t wait_us;
+    uint64_t blit_us; /* Written by the blit thread. */
+    uint64_t blit_max_us;
+    uint32_t frames;
+    uint32_t dropped;
+    uint32_t blits;
+
+    uint64_t last_blit_us; /* Only kept at max speed. */
+
+    struct video_line_queue_t *line_queue; /* Created on first use. */
 } blit_data_t;
 
+#define MAX_SPEED_FPS 30 /* frames shown per host second at max speed */
+
 static uint32_t cga_2_table[16];
 
 static void (*blit_func)(int x, int y, int w, int h, int monitor_index);
@@ -284,6 +316,89 @@ video_blit_complete_monitor(int monitor_index)
     thread_set_event(blit_data_ptr->buffer_not_in_use);
 }
 
+/* Tell the blitter that only rows y1 to (y2 - 1) changed since the previous
+   frame. Applies to the next blit only; blits without it are full frames. */
+void
+video_blit_dirty_monitor(int y1, int y2, int monitor_index)
+{
+    blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+
+    blit_data_ptr->next_y1    = y1;
+    blit_data_ptr->next_y2    = y2;
+    blit_data_ptr->next_dirty = 1;
+}
+
+/* For the blit callbacks: the changed rows of the blit in progress, clipped
+   to its rectangle. *y1 == *y2 means that nothing changed. */
+void
+video_blit_get_dirty_monitor(int *y1, int *y2, int monitor_index)
+{
+    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+
+    *y1 = blit_data_ptr->dirty_y1;
+    *y2 = blit_data_ptr->dirty_y2;
+}
+
+static uint64_t
+video_time_us(void)
+{
+#if defined _WIN32
+    static LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER        now;
+
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t) ((now.QuadPart * 1000000.0) / freq.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+#endif
+}
+
+/* Frame interval: time between two frames from the emulated card.
+   Wait: time the emulation spent waiting for the previous blit.
+   Blit: time the platform blit callback took. */
+static void
+video_frame_stats_update(blit_data_t *data, uint64_t now)
+{
+    uint64_t elapsed;
+    uint32_t blits;
+
+    if (data->last_frame_us) {
+        elapsed = now - data->last_frame_us;
+        data->frame_us += elapsed;
+        if (elapsed > data->frame_max_us)
+            data->frame_max_us = elapsed;
+        data->frames++;
+    }
+    data->last_frame_us = now;
+
+    if (!data->stats_start_us)
+        data->stats_start_us = now;
+    if ((now - data->stats_start_us) < 1000000)
+        return;
+
+    blits = data->blits ? data->blits : 1;
+    pclog("Video %i: %u frames (%u dropped), interval %.2f/%.2f ms, wait %.2f ms, blit %.2f/%.2f ms (avg/max)\n",
+          data->monitor_index, data->frames, data->dropped,
+          data->frames ? (data->frame_us / (double) data->frames) / 1000.0 : 0.0, data->frame_max_us / 1000.0,
+          data->frames ? (data->wait_us / (double) data->frames) / 1000.0 : 0.0,
+          (data->blit_us / (double) blits) / 1000.0, data->blit_max_us / 1000.0);
+
+    data->stats_start_us = now;
+    data->frame_us       = 0;
+    data->frame_max_us   = 0;
+    data->wait_us        = 0;
+    data->blit_us        = 0;
+    data->blit_max_us    = 0;
+    data->frames         = 0;
+    data->dropped        = 0;
+    data->blits          = 0;
+}
+
 void
 video_wait_for_blit_monitor(int monitor_index)
 {
@@ -304,90 +419,444 @@ video_wait_for_buffer_monitor(int monitor_index)
     thread_reset_event(blit_data_ptr->buffer_not_in_use);
 }
 
-static png_structp png_ptr[MONITORS_NUM];
-static png_infop   info_ptr[MONITORS_NUM];
+/*
+ * Line worker.
+ *
+ * Boards that have no render thread of their own, like the text-only cards
+ * usually found on a secondary monitor, can pass the drawing of their lines
+ * to a worker of the monitor they are on, so each monitor of a multi-head
+ * setup draws on a host thread of its own. The job carries a copy of what
+ * the line needs; the worker is drained before the monitor's frame is
+ * blitted.
+ */
+#define LINE_JOBS      256
+#define LINE_JOBS_MASK (LINE_JOBS - 1)
+#define LINE_JOB_SIZE  1024
+
+typedef struct video_line_job_t {
+    video_line_func_t func;
+    int               y;
+    uint8_t           data[LINE_JOB_SIZE];
+} video_line_job_t;
+
+typedef struct video_line_queue_t {
+    int       monitor_index;
+    thread_t *thread;
+    event_t  *wake_event;
+    event_t  *done_event;
+
+    atomic_int read_idx;
+    atomic_int write_idx;
+    atomic_int busy;
+    atomic_int run;
+
+    video_line_job_t jobs[LINE_JOBS];
+} video_line_queue_t;
 
 static void
-video_take_screenshot_monitor(const char *fn, uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index)
+video_line_thread(void *param)
 {
-    png_bytep         *b_rgb         = NULL;
-    FILE              *fp            = NULL;
-    uint32_t           temp          = 0x00000000;
-    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    video_line_queue_t *queue = (video_line_queue_t *) param;
+    video_line_job_t   *job;
+
+    while (queue->run) {
+        thread_wait_event(queue->wake_event, -1);
+        thread_reset_event(queue->wake_event);
+        queue->busy = 1;
+
+        while (queue->read_idx != queue->write_idx) {
+            job = &queue->jobs[queue->read_idx & LINE_JOBS_MASK];
+            job->func(queue->monitor_index, job->y, job->data);
+            queue->read_idx++;
+            if (!(queue->read_idx & 31))
+                thread_set_event(queue->done_event);
+        }
 
-    /* create file */
-    fp = plat_fopen(fn, (const char *) "wb");
-    if (!fp) {
-        video_log("[video_take_screenshot] File %s could not be opened for writing", fn);
-        return;
+        queue->busy = 0;
+        thread_set_event(queue->done_event);
+    }
+}
+
+/* Block until the worker has caught up to within max_pending lines. */
+static void
+video_line_sync(video_line_queue_t *queue, int max_pending)
+{
+    while ((queue->write_idx - queue->read_idx) > max_pending) {
+        thread_reset_event(queue->done_event);
+        thread_set_event(queue->wake_event);
+        if ((queue->write_idx - queue->read_idx) > max_pending)
+            thread_wait_event(queue->done_event, -1);
     }
+}
+
+/* Queue line y of the monitor, to be drawn by func from a copy of data.
+   Returns 0 if the caller has to draw the line itself. */
+int
+video_line_queue_monitor(int monitor_index, int y, video_line_func_t func, const void *data, int size)
+{
+    blit_data_t        *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    video_line_queue_t *queue;
+    video_line_job_t   *job;
 
-    /* initialize stuff */
-    png_ptr[monitor_index] = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!video_render_thread || (size > LINE_JOB_SIZE) || (blit_data_ptr == NULL))
+        return 0;
 
-    if (!png_ptr[monitor_index]) {
-        video_log("[video_take_screenshot] png_create_write_struct failed");
-        fclose(fp);
+    queue = blit_data_ptr->line_queue;
+    if (queue == NULL) {
+        if (thread_get_cpu_count() < 2)
+            return 0;
+
+        queue = (video_line_queue_t *) calloc(1, sizeof(video_line_queue_t));
+        if (queue == NULL)
+            return 0;
+
+        queue->monitor_index = monitor_index;
+        queue->wake_event    = thread_create_event();
+        queue->done_event    = thread_create_event();
+        queue->run           = 1;
+        queue->thread        = thread_create(video_line_thread, queue);
+
+        blit_data_ptr->line_queue = queue;
+    }
+
+    video_line_sync(queue, LINE_JOBS - 1);
+
+    job       = &queue->jobs[queue->write_idx & LINE_JOBS_MASK];
+    job->func = func;
+    job->y    = y;
+    memcpy(job->data, data, size);
+    queue->write_idx++;
+
+    if (!queue->busy)
+        thread_set_event(queue->wake_event);
+
+    return 1;
+}
+
+static void
+video_line_close(blit_data_t *blit_data_ptr)
+{
+    video_line_queue_t *queue = blit_data_ptr->line_queue;
+
+    if (queue == NULL)
         return;
+
+    video_line_sync(queue, 0);
+
+    queue->run = 0;
+    thread_set_event(queue->wake_event);
+    thread_wait(queue->thread);
+    thread_destroy_event(queue->wake_event);
+    thread_destroy_event(queue->done_event);
+
+    free(queue);
+    blit_data_ptr->line_queue = NULL;
+}
+
+/* Screenshots are copied out of the frame by the caller and encoded by a
+   worker thread, so taking one does not stall the blit. The queue slots
+   keep their buffers when they are done with, to be reused by the next
+   screenshot of the same size. */
+#define SCREENSHOT_JOBS 8
+
+typedef struct screenshot_job_t {
+    char      path[1024];
+    uint32_t *buf;
+    size_t    size; /* Allocated pixels in buf. */
+    int       w;
+    int       h;
+    int       format;
+    int       level;
+} screenshot_job_t;
+
+typedef struct screenshot_queue_t {
+    thread_t        *thread;
+    event_t         *wake_event;
+    mutex_t         *mutex;
+    volatile int     run;
+
+    /* Jobs head to (head + count - 1), the head job stays queued while it
+       is being encoded. */
+    int              head;
+    int              count;
+    screenshot_job_t jobs[SCREENSHOT_JOBS];
+} screenshot_queue_t;
+
+static screenshot_queue_t screenshot_queue;
+
+static int
+video_screenshot_png(FILE *fp, const uint32_t *buf, int pitch, int w, int h, int level)
+{
+    png_structp png_ptr;
+    png_infop   info_ptr;
+    png_bytep   row;
+    uint32_t    temp;
+
+    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png_ptr) {
+        video_log("[video_take_screenshot] png_create_write_struct failed");
+        return 0;
     }
 
-    info_ptr[monitor_index] = png_create_info_struct(png_ptr[monitor_index]);
-    if (!info_ptr[monitor_index]) {
+    info_ptr = png_create_info_struct(png_ptr);
+    if (!info_ptr) {
         video_log("[video_take_screenshot] png_create_info_struct failed");
-        fclose(fp);
-        return;
+        png_destroy_write_struct(&png_ptr, NULL);
+        return 0;
     }
 
-    png_init_io(png_ptr[monitor_index], fp);
+    row = (png_bytep) malloc(w * 3);
+    if (row == NULL) {
+        video_log("[video_take_screenshot] Unable to Allocate RGB Bitmap Memory");
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        return 0;
+    }
+
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        free(row);
+        return 0;
+    }
+
+    png_init_io(png_ptr, fp);
+
+    /* Level 0 is stored uncompressed, filtering would only cost time then. */
+    if (level >= 0) {
+        png_set_compression_level(png_ptr, MIN(level, 9));
+        if (level == 0)
+            png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+    }
 
-    png_set_IHDR(png_ptr[monitor_index], info_ptr[monitor_index], blit_data_ptr->w, blit_data_ptr->h,
+    png_set_IHDR(png_ptr, info_ptr, w, h,
                  8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
                  PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
 
-    b_rgb = (png_bytep *) malloc(sizeof(png_bytep) * blit_data_ptr->h);
-    if (b_rgb == NULL) {
-        video_log("[video_take_screenshot] Unable to Allocate RGB Bitmap Memory");
-        fclose(fp);
-        return;
+    png_write_info(png_ptr, info_ptr);
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            temp             = (buf == NULL) ? 0x00000000 : buf[(y * pitch) + x];
+            row[x * 3]       = (temp >> 16) & 0xff;
+            row[(x * 3) + 1] = (temp >> 8) & 0xff;
+            row[(x * 3) + 2] = temp & 0xff;
+        }
+        png_write_row(png_ptr, row);
     }
 
-    for (int y = 0; y < blit_data_ptr->h; ++y) {
-        b_rgb[y] = (png_byte *) malloc(png_get_rowbytes(png_ptr[monitor_index], info_ptr[monitor_index]));
-        for (int x = 0; x < blit_data_ptr->w; ++x) {
-            if (buf == NULL)
-                memset(&(b_rgb[y][x * 3]), 0x00, 3);
+    png_write_end(png_ptr, NULL);
+
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    free(row);
+
+    return 1;
+}
+
+/* The Quite OK Image format: much faster to write than PNG at a similar
+   size for typical screen contents. */
+static int
+video_screenshot_qoi(FILE *fp, const uint32_t *buf, int pitch, int w, int h)
+{
+    static const uint8_t end[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    uint32_t             index[64];
+    uint8_t              hdr[14];
+    uint8_t             *out;
+    uint8_t             *p;
+    uint32_t             prev = 0xff000000;
+    uint32_t             px;
+    int                  run  = 0;
+    int                  ret  = 1;
+    int                  hash;
+    int8_t               dr;
+    int8_t               dg;
+    int8_t               db;
+
+    /* Worst case is 4 bytes per pixel, plus a pending run. */
+    out = (uint8_t *) malloc((w * 4) + 1);
+    if (out == NULL)
+        return 0;
+
+    memset(index, 0, sizeof(index));
+    memcpy(hdr, "qoif", 4);
+    hdr[4]  = (w >> 24) & 0xff;
+    hdr[5]  = (w >> 16) & 0xff;
+    hdr[6]  = (w >> 8) & 0xff;
+    hdr[7]  = w & 0xff;
+    hdr[8]  = (h >> 24) & 0xff;
+    hdr[9]  = (h >> 16) & 0xff;
+    hdr[10] = (h >> 8) & 0xff;
+    hdr[11] = h & 0xff;
+    hdr[12] = 3; /* RGB */
+    hdr[13] = 0; /* sRGB */
+    if (fwrite(hdr, 1, sizeof(hdr), fp) != sizeof(hdr))
+        ret = 0;
+
+    for (int y = 0; ret && (y < h); ++y) {
+        p = out;
+        for (int x = 0; x < w; ++x) {
+            px = ((buf == NULL) ? 0x00000000 : (buf[(y * pitch) + x] & 0x00ffffff)) | 0xff000000;
+
+            if (px == prev) {
+                if (++run == 62) {
+                    *p++ = 0xc0 | (run - 1);
+                    run  = 0;
+                }
+                continue;
+            }
+
+            if (run) {
+                *p++ = 0xc0 | (run - 1);
+                run  = 0;
+            }
+
+            hash = ((((px >> 16) & 0xff) * 3) + (((px >> 8) & 0xff) * 5) + ((px & 0xff) * 7) + (0xff * 11)) & 63;
+            if (index[hash] == px)
+                *p++ = hash;
             else {
-                temp                  = buf[((start_y + y) * row_len) + start_x + x];
-                b_rgb[y][x * 3]       = (temp >> 16) & 0xff;
-                b_rgb[y][(x * 3) + 1] = (temp >> 8) & 0xff;
-                b_rgb[y][(x * 3) + 2] = temp & 0xff;
+                index[hash] = px;
+
+                dr = (int8_t) (((px >> 16) & 0xff) - ((prev >> 16) & 0xff));
+                dg = (int8_t) (((px >> 8) & 0xff) - ((prev >> 8) & 0xff));
+                db = (int8_t) ((px & 0xff) - (prev & 0xff));
+
+                if ((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) && (db <= 1))
+                    *p++ = 0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+                else if ((dg >= -32) && (dg <= 31) && ((dr - dg) >= -8) && ((dr - dg) <= 7) &&
+                         ((db - dg) >= -8) && ((db - dg) <= 7)) {
+                    *p++ = 0x80 | (dg + 32);
+                    *p++ = ((dr - dg + 8) << 4) | (db - dg + 8);
+                } else {
+                    *p++ = 0xfe;
+                    *p++ = (px >> 16) & 0xff;
+                    *p++ = (px >> 8) & 0xff;
+                    *p++ = px & 0xff;
+                }
             }
+
+            prev = px;
         }
+
+        if (y == (h - 1) && run)
+            *p++ = 0xc0 | (run - 1);
+
+        if (fwrite(out, 1, p - out, fp) != (size_t) (p - out))
+            ret = 0;
     }
 
-    png_write_info(png_ptr[monitor_index], info_ptr[monitor_index]);
+    if (ret && (fwrite(end, 1, sizeof(end), fp) != sizeof(end)))
+        ret = 0;
 
-    png_write_image(png_ptr[monitor_index], b_rgb);
+    free(out);
 
-    png_write_end(png_ptr[monitor_index], NULL);
+    return ret;
+}
 
-    /* cleanup heap allocation */
-    for (int i = 0; i < blit_data_ptr->h; i++)
-        if (b_rgb[i])
-            free(b_rgb[i]);
+static void
+video_take_screenshot_monitor(const char *fn, const uint32_t *buf, int pitch, int w, int h, int format, int level)
+{
+    FILE *fp;
+    int   ret;
 
-    if (b_rgb)
-        free(b_rgb);
+    /* create file */
+    fp = plat_fopen(fn, (const char *) "wb");
+    if (!fp) {
+        video_log("[video_take_screenshot] File %s could not be opened for writing", fn);
+        return;
+    }
 
-    if (fp)
-        fclose(fp);
+    if (format == SCREENSHOT_FORMAT_QOI)
+        ret = video_screenshot_qoi(fp, buf, pitch, w, h);
+    else
+        ret = video_screenshot_png(fp, buf, pitch, w, h, level);
+
+    fclose(fp);
+
+    if (!ret) {
+        video_log("[video_take_screenshot] Unable to write %s", fn);
+        (void) remove(fn);
+    }
+}
+
+static void
+video_screenshot_thread(UNUSED(void *param))
+{
+    screenshot_job_t *job;
+
+    while (1) {
+        thread_wait_event(screenshot_queue.wake_event, -1);
+        thread_reset_event(screenshot_queue.wake_event);
+
+        while (1) {
+            thread_wait_mutex(screenshot_queue.mutex);
+            job = screenshot_queue.count ? &screenshot_queue.jobs[screenshot_queue.head] : NULL;
+            thread_release_mutex(screenshot_queue.mutex);
+
+            if (job == NULL)
+                break;
+
+            TRACE_BEGIN(video, "screenshot");
+            video_take_screenshot_monitor(job->path, job->buf, job->w, job->w, job->h, job->format, job->level);
+            TRACE_END(video, "screenshot");
+
+            thread_wait_mutex(screenshot_queue.mutex);
+            screenshot_queue.head = (screenshot_queue.head + 1) % SCREENSHOT_JOBS;
+            screenshot_queue.count--;
+            thread_release_mutex(screenshot_queue.mutex);
+        }
+
+        /* Anything queued before the close has been written out by now. */
+        if (!screenshot_queue.run)
+            break;
+    }
+}
+
+static void
+video_screenshot_init(void)
+{
+    memset(&screenshot_queue, 0, sizeof(screenshot_queue_t));
+
+    screenshot_queue.mutex      = thread_create_mutex();
+    screenshot_queue.wake_event = thread_create_event();
+    screenshot_queue.run        = 1;
+    screenshot_queue.thread     = thread_create(video_screenshot_thread, NULL);
+}
+
+static void
+video_screenshot_close(void)
+{
+    if (screenshot_queue.thread == NULL)
+        return;
+
+    screenshot_queue.run = 0;
+    thread_set_event(screenshot_queue.wake_event);
+    thread_wait(screenshot_queue.thread);
+
+    thread_destroy_event(screenshot_queue.wake_event);
+    thread_close_mutex(screenshot_queue.mutex);
+
+    for (int i = 0; i < SCREENSHOT_JOBS; i++)
+        free(screenshot_queue.jobs[i].buf);
+
+    memset(&screenshot_queue, 0, sizeof(screenshot_queue_t));
 }
 
 void
 video_screenshot_monitor(uint32_t *buf, int start_x, int start_y, int row_len, int monitor_index)
 {
-    char path[1024];
-    char fn[256];
+    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    screenshot_job_t  *job           = NULL;
+    const uint32_t    *src           = (buf == NULL) ? NULL : &buf[(start_y * row_len) + start_x];
+    int                w             = blit_data_ptr->w;
+    int                h             = blit_data_ptr->h;
+    int                format        = video_screenshot_format;
+    int                level         = video_screenshot_level;
+    uint32_t          *new_buf;
+    char               path[1024];
+    char               fn[256];
+
+    if ((w <= 0) || (h <= 0)) {
+        atomic_fetch_sub(&monitors[monitor_index].mon_screenshots, 1);
+        return;
+    }
 
     memset(fn, 0, sizeof(fn));
     memset(path, 0, sizeof(path));
@@ -401,13 +870,48 @@ video_screenshot_monitor(uint32_t *buf, int start_x, int start_y, int row_len, i
     strcat(path, "Monitor_");
     snprintf(&path[strlen(path)], 42, "%d_", monitor_index + 1);
 
-    plat_tempfile(fn, NULL, ".png");
+    plat_tempfile(fn, NULL, (format == SCREENSHOT_FORMAT_QOI) ? ".qoi" : ".png");
     strcat(path, fn);
 
     video_log("taking screenshot to: %s\n", path);
 
-    video_take_screenshot_monitor((const char *) path, buf, start_x, start_y, row_len, monitor_index);
-    png_destroy_write_struct(&png_ptr[monitor_index], &info_ptr[monitor_index]);
+    if (screenshot_queue.thread != NULL) {
+        thread_wait_mutex(screenshot_queue.mutex);
+        if (screenshot_queue.count < SCREENSHOT_JOBS) {
+            job = &screenshot_queue.jobs[(screenshot_queue.head + screenshot_queue.count) % SCREENSHOT_JOBS];
+            if (job->size < ((size_t) w * h)) {
+                new_buf = (uint32_t *) realloc(job->buf, (size_t) w * h * sizeof(uint32_t));
+                if (new_buf == NULL)
+                    job = NULL;
+                else {
+                    job->buf  = new_buf;
+                    job->size = (size_t) w * h;
+                }
+            }
+        }
+
+        if (job != NULL) {
+            snprintf(job->path, sizeof(job->path), "%s", path);
+            job->w      = w;
+            job->h      = h;
+            job->format = format;
+            job->level  = level;
+            for (int y = 0; y < h; y++) {
+                if (src == NULL)
+                    memset(&job->buf[y * w], 0x00, w * sizeof(uint32_t));
+                else
+                    memcpy(&job->buf[y * w], &src[y * row_len], w * sizeof(uint32_t));
+            }
+            screenshot_queue.count++;
+        }
+        thread_release_mutex(screenshot_queue.mutex);
+    }
+
+    /* Encode it here if the queue is full. */
+    if (job != NULL)
+        thread_set_event(screenshot_queue.wake_event);
+    else
+        video_take_screenshot_monitor(path, src, row_len, w, h, format, level);
 
     atomic_fetch_sub(&monitors[monitor_index].mon_screenshots, 1);
 }
@@ -445,17 +949,37 @@ static void
 blit_thread(void *param)
 {
     blit_data_t *data = param;
+    uint64_t     start;
+    uint64_t     elapsed;
+
     while (data->thread_run) {
         thread_wait_event(data->wake_blit_thread, -1);
         thread_reset_event(data->wake_blit_thread);
-        MTR_BEGIN("video", "blit_thread");
+        TRACE_BEGIN(video, "blit_thread");
+
+        start = (video_frame_stats || metrics_enabled) ? video_time_us() : 0;
+
+        shmfb_publish(data->x, data->y, data->w, data->h, data->dirty_y1, data->dirty_y2, data->monitor_index);
+        if (capture_active && (data->monitor_index == 0))
+            capture_video(data->x, data->y, data->w, data->h, data->dirty_y1, data->dirty_y2);
 
         if (blit_func)
             blit_func(data->x, data->y, data->w, data->h, data->monitor_index);
 
+        if (video_frame_stats || metrics_enabled) {
+            elapsed = video_time_us() - start;
+            data->blit_us += elapsed;
+            if (elapsed > data->blit_max_us)
+                data->blit_max_us = elapsed;
+            data->blits++;
+
+            metrics.blit_us += elapsed;
+            metrics.blits++;
+        }
+
         data->busy = 0;
 
-        MTR_END("video", "blit_thread");
+        TRACE_END(video, "blit_thread");
         thread_set_event(data->blit_complete);
     }
 }
@@ -463,12 +987,57 @@ blit_thread(void *param)
 void
 video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
 {
-    MTR_BEGIN("video", "video_blit_memtoscreen");
+    blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    int          dirty         = blit_data_ptr->next_dirty;
+    uint64_t     now           = 0;
+
+    TRACE_BEGIN(video, "video_blit_memtoscreen");
+
+    /* The frame is only complete once the queued lines are drawn. */
+    if (blit_data_ptr->line_queue != NULL)
+        video_line_sync(blit_data_ptr->line_queue, 0);
+
+    blit_data_ptr->next_dirty = 0;
+
+    /* Benchmarks do not show anything. */
+    if ((w <= 0) || (h <= 0) || bench_enabled) {
+        TRACE_END(video, "video_blit_memtoscreen");
+        return;
+    }
+
+    /* Frames come much faster than real time, only show a few of them. */
+    if (max_speed) {
+        now = video_time_us();
+        if ((now - blit_data_ptr->last_blit_us) < (1000000 / MAX_SPEED_FPS)) {
+            blit_data_ptr->dropped_full = 1;
+            TRACE_END(video, "video_blit_memtoscreen");
+            return;
+        }
+        blit_data_ptr->last_blit_us = now;
+    }
+
+    if (video_frame_stats) {
+        now = video_time_us();
+        video_frame_stats_update(blit_data_ptr, now);
+    }
 
-    if ((w <= 0) || (h <= 0))
+    if ((video_blit_mode == BLIT_MODE_MAILBOX) && blit_data_ptr->busy) {
+        /* The host has not taken the previous frame yet, skip this one.
+           Its changed rows are lost, so the next blit is a full one. */
+        blit_data_ptr->dropped_full = 1;
+        blit_data_ptr->dropped++;
+        TRACE_END(video, "video_blit_memtoscreen");
         return;
+    }
 
     video_wait_for_blit_monitor(monitor_index);
+    if (video_frame_stats)
+        blit_data_ptr->wait_us += video_time_us() - now;
+
+    if (blit_data_ptr->dropped_full) {
+        blit_data_ptr->dropped_full = 0;
+        dirty                       = 0;
+    }
 
     monitors[monitor_index].mon_blit_data_ptr->busy          = 1;
     monitors[monitor_index].mon_blit_data_ptr->buffer_in_use = 1;
@@ -477,8 +1046,16 @@ video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
     monitors[monitor_index].mon_blit_data_ptr->w             = w;
     monitors[monitor_index].mon_blit_data_ptr->h             = h;
 
+    if (dirty) {
+        blit_data_ptr->dirty_y1 = MIN(MAX(blit_data_ptr->next_y1, y), y + h);
+        blit_data_ptr->dirty_y2 = MIN(MAX(blit_data_ptr->next_y2, blit_data_ptr->dirty_y1), y + h);
+    } else {
+        blit_data_ptr->dirty_y1 = y;
+        blit_data_ptr->dirty_y2 = y + h;
+    }
+
     thread_set_event(monitors[monitor_index].mon_blit_data_ptr->wake_blit_thread);
-    MTR_END("video", "video_blit_memtoscreen");
+    TRACE_END(video, "video_blit_memtoscreen");
 }
 
 uint8_t
@@ -881,9 +1458,11 @@ video_monitor_close(int monitor_index)
     if (monitors[monitor_index].target_buffer == NULL) {
         return;
     }
+    video_line_close(monitors[monitor_index].mon_blit_data_ptr);
     monitors[monitor_index].mon_blit_data_ptr->thread_run = 0;
     thread_set_event(monitors[monitor_index].mon_blit_data_ptr->wake_blit_thread);
     thread_wait(monitors[monitor_index].mon_blit_data_ptr->blit_thread);
+    shmfb_close(monitor_index);
     if (monitor_index >= 1)
         ui_deinit_monitor(monitor_index);
     thread_destroy_event(monitors[monitor_index].mon_blit_data_ptr->buffer_not_in_use);
@@ -921,20 +1500,20 @@ video_init(void)
         cgapal[c + 128].b = (((c & 1) ? 2 : 0) | ((c & 0x08) ? 1 : 0)) * 21;
     }
 
-    for (uint8_t c = 0; c < 4; c++) {
-        for (uint8_t d = 0; d < 4; d++) {
-            edatlookup[c][d] = 0;
-            if (c & 1)
-                edatlookup[c][d] |= 1;
-            if (d & 1)
-                edatlookup[c][d] |= 2;
-            if (c & 2)
-                edatlookup[c][d] |= 0x10;
-            if (d & 2)
-                edatlookup[c][d] |= 0x20;
+    /* Spreads the 8 pixels of a plane byte over the nibbles of a dword, leftmost pixel on top. */
+    for (uint16_t c = 0; c < 256; c++) {
+        edatlookup8[c] = 0;
+        for (uint8_t d = 0; d < 8; d++) {
+            if (c & (1 << d))
+                edatlookup8[c] |= 1 << (d << 2);
         }
     }
 
+    for (uint16_t c = 0; c < 256; c++) {
+        for (uint8_t d = 0; d < 8; d++)
+            video_glyphmask[c][d] = (c & (0x80 >> d)) ? 0xffffffff : 0x00000000;
+    }
+
     for (uint16_t c = 0; c < 256; c++) {
         egaremap2bpp[c] = 0;
         if (c & 0x01)
@@ -969,11 +1548,14 @@ video_init(void)
 
     memset(monitors, 0, sizeof(monitors));
     video_monitor_init(0);
+
+    video_screenshot_init();
 }
 
 void
 video_close(void)
 {
+    video_screenshot_close();
     video_monitor_close(0);
 
     free(video_16to32);
@@ -37,11 +37,20 @@
 #define VNC_MIN_Y 200
 #define VNC_MAX_Y 2048
 
+/* Granularity of the change detection in vnc_blit(). */
+#define VNC_TILE_W 64
+#define VNC_TILE_H 16
+
 static rfbScreenInfoPtr rfb = NULL;
 static int              clients;
 static int              updatingSize;
 static int              allowedX;
 static int              allowedY;
+static int              blit_full = 1; /* a blit was dropped, or not marked as modified */
+static int              blit_x;
+static int              blit_y;
+static int              blit_w;
+static int              blit_h;
 static int              ptr_x;
 static int              ptr_y;
 static int              ptr_but;
@@ -73,6 +82,27 @@ vnc_kbdevent(rfbBool down, rfbKeySym k, rfbClientPtr cl)
     vnc_kbinput(down ? 1 : 0, (int) k);
 }
 
+/* Text cut on the client is typed into the guest. */
+static void
+vnc_cuttext(char *str, int len, rfbClientPtr cl)
+{
+    char *text;
+
+    (void) cl;
+
+    if ((str == NULL) || (len <= 0))
+        return;
+
+    text = (char *) malloc(len + 1);
+    if (text == NULL)
+        return;
+    memcpy(text, str, len);
+    text[len] = '\0';
+
+    keyboard_paste_text(text);
+    free(text);
+}
+
 static void
 vnc_ptrevent(int but, int x, int y, rfbClientPtr cl)
 {
@@ -178,21 +208,92 @@ vnc_display(rfbClientPtr cl)
 static void
 vnc_blit(int x, int y, int w, int h, int monitor_index)
 {
+    int       dirty_y1;
+    int       dirty_y2;
+    int       mark_all;
+    int       bands = 0;
+    int       band_x1[(VNC_MAX_Y + VNC_TILE_H - 1) / VNC_TILE_H];
+    int       band_x2[(VNC_MAX_Y + VNC_TILE_H - 1) / VNC_TILE_H];
+    int       band_y1[(VNC_MAX_Y + VNC_TILE_H - 1) / VNC_TILE_H];
+    int       band_y2[(VNC_MAX_Y + VNC_TILE_H - 1) / VNC_TILE_H];
+    uint32_t *dst;
+    uint32_t *src;
+
     if (monitor_index || (x < 0) || (y < 0) || (w < VNC_MIN_X) || (h < VNC_MIN_Y) || (w > VNC_MAX_X) || (h > VNC_MAX_Y) || (buffer32 == NULL)) {
+        blit_full = 1;
         video_blit_complete_monitor(monitor_index);
         return;
     }
 
-    for (int row = 0; row < h; ++row)
-        video_copy(&(((uint8_t *) rfb->frameBuffer)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+    /* Only look at the rows that changed since the last blit. */
+    video_blit_get_dirty_monitor(&dirty_y1, &dirty_y2, monitor_index);
+    mark_all = blit_full || (x != blit_x) || (y != blit_y) || (w != blit_w) || (h != blit_h);
+    if (mark_all) {
+        dirty_y1 = y;
+        dirty_y2 = y + h;
+        blit_x   = x;
+        blit_y   = y;
+        blit_w   = w;
+        blit_h   = h;
+    }
+
+    /* Within those, compare tile by tile against what the clients were sent,
+       so the encoders only see the parts that really changed. The frame
+       buffer holds transformed pixels when a colour transform is enabled,
+       in which case every row is taken as changed. */
+    for (int ty = (dirty_y1 - y); ty < (dirty_y2 - y); ty += VNC_TILE_H) {
+        int th = MIN(VNC_TILE_H, (dirty_y2 - y) - ty);
+        int x1 = w;
+        int x2 = 0;
+
+        for (int row = ty; row < (ty + th); row++) {
+            dst = &((uint32_t *) rfb->frameBuffer)[row * VNC_MAX_X];
+            src = &(buffer32->line[y + row][x]);
+
+            if (video_copy != memcpy) {
+                video_copy(dst, src, w * sizeof(uint32_t));
+                x1 = 0;
+                x2 = w;
+                continue;
+            }
+
+            for (int tx = 0; tx < w; tx += VNC_TILE_W) {
+                int tw = MIN(VNC_TILE_W, w - tx);
+
+                if (memcmp(&dst[tx], &src[tx], tw * sizeof(uint32_t))) {
+                    memcpy(&dst[tx], &src[tx], tw * sizeof(uint32_t));
+                    x1 = MIN(x1, tx);
+                    x2 = MAX(x2, tx + tw);
+                }
+            }
+        }
+
+        if (x2 > x1) {
+            band_x1[bands]   = x1;
+            band_x2[bands]   = x2;
+            band_y1[bands]   = ty;
+            band_y2[bands++] = ty + th;
+        }
+    }
 
     if (screenshots)
         video_screenshot((uint32_t *) rfb->frameBuffer, 0, 0, VNC_MAX_X);
 
     video_blit_complete_monitor(monitor_index);
 
-    if (!updatingSize)
-        rfbMarkRectAsModified(rfb, 0, 0, allowedX, allowedY);
+    if (updatingSize)
+        blit_full = 1;
+    else {
+        blit_full = 0;
+        if (mark_all)
+            rfbMarkRectAsModified(rfb, 0, 0, allowedX, allowedY);
+        else {
+            for (int i = 0; i < bands; i++) {
+                if ((band_y1[i] < allowedY) && (band_x1[i] < allowedX))
+                    rfbMarkRectAsModified(rfb, band_x1[i], band_y1[i], MIN(band_x2[i], allowedX), MIN(band_y2[i], allowedY));
+            }
+        }
+    }
 }
 
 /* Initialize VNC for operation. */
@@ -231,12 +332,18 @@ vnc_init(UNUSED(void *arg))
         rfb->displayHook   = vnc_display;
         rfb->ptrAddEvent   = vnc_ptrevent;
         rfb->kbdAddEvent   = vnc_kbdevent;
+        rfb->setXCutText   = vnc_cuttext;
         rfb->newClientHook = vnc_newclient;
 
         /* Set up our current resolution. */
         rfb->width  = allowedX;
         rfb->height = allowedY;
 
+        /* Each client is served by its own libvncserver thread, which waits
+           this long after a change before encoding, capping its frame rate. */
+        if (vnc_max_fps > 0)
+            rfb->deferUpdateTime = 1000 / vnc_max_fps;
+
         rfbInitServer(rfb);
 
         rfbRunEventLoop(rfb, -1, TRUE);